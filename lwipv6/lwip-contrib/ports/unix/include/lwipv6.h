@@ -115,6 +115,63 @@ struct ip_addr {
 #define lwip_ifup(N) lwip_ifup_flags((N),0)
 #define lwip_ifup_dhcp(N) lwip_ifup_flags((N),NETIF_FLAG_DHCP)
 
+/* asynchronous socket rings (same layout as lwip/sockring.h).
+	 Fill the sqes returned by lwip_ring_get_sqe, publish them with a
+	 single lwip_ring_submit, reap the results as cqes (res is the
+	 return value of the blocking call or -errno).
+	 lwip_ring_fd is readable when completions are available.
+	 Do not mix blocking calls and ring operations on the same socket. */
+#define LWIP_RING_OP_NOP     0
+#define LWIP_RING_OP_RECV    1
+#define LWIP_RING_OP_SEND    2
+#define LWIP_RING_OP_ACCEPT  3
+#define LWIP_RING_OP_CONNECT 4
+#define LWIP_RING_OP_CLOSE   5
+
+struct lwip_sqe {
+	uint8_t opcode;
+	int fd;
+	void *buf;
+	uint32_t len;
+	uint32_t flags;
+	struct sockaddr *addr;
+	socklen_t addrlen;
+	socklen_t *paddrlen;
+	void *user_data;
+};
+
+struct lwip_cqe {
+	void *user_data;
+	int32_t res;
+	uint32_t flags;
+};
+
+struct lwip_ring;
+
+#define lwip_ring_prep(sqe, op, s, b, l, data) do { \
+	(sqe)->opcode = (op); \
+	(sqe)->fd = (s); \
+	(sqe)->buf = (b); \
+	(sqe)->len = (l); \
+	(sqe)->user_data = (data); \
+} while (0)
+#define lwip_ring_prep_recv(sqe, s, b, l, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_RECV, (s), (b), (l), (data))
+#define lwip_ring_prep_send(sqe, s, b, l, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_SEND, (s), (b), (l), (data))
+#define lwip_ring_prep_accept(sqe, s, a, pl, data) do { \
+	lwip_ring_prep((sqe), LWIP_RING_OP_ACCEPT, (s), NULL, 0, (data)); \
+	(sqe)->addr = (a); \
+	(sqe)->paddrlen = (pl); \
+} while (0)
+#define lwip_ring_prep_connect(sqe, s, a, l, data) do { \
+	lwip_ring_prep((sqe), LWIP_RING_OP_CONNECT, (s), NULL, 0, (data)); \
+	(sqe)->addr = (a); \
+	(sqe)->addrlen = (l); \
+} while (0)
+#define lwip_ring_prep_close(sqe, s, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_CLOSE, (s), NULL, 0, (data))
+
 #ifndef LWIPV6DL
 typedef void (*lwipvoidfun)();
 extern const struct ip_addr ip_addr_any;
@@ -207,6 +264,15 @@ int lwip_radv_load_configfile(struct stack *stack,void *arg);
 
 int lwip_event_subscribe(lwipvoidfun cb, void *arg, int fd, int how);
 
+struct lwip_ring *lwip_ring_new(struct stack *stack, unsigned int entries);
+int lwip_ring_free(struct lwip_ring *ring);
+int lwip_ring_fd(struct lwip_ring *ring);
+struct lwip_sqe *lwip_ring_get_sqe(struct lwip_ring *ring);
+int lwip_ring_submit(struct lwip_ring *ring);
+int lwip_ring_peek_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe);
+int lwip_ring_wait_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe);
+void lwip_ring_cqe_seen(struct lwip_ring *ring, struct lwip_cqe *cqe);
+
 /* Allows binding to TCP/UDP sockets below 1024 */
 #define LWIP_CAP_NET_BIND_SERVICE 1<<10
 /* Allow broadcasting, listen to multicast */
@@ -248,6 +314,10 @@ typedef pstack (*pstackfun)();
 typedef int (*lwiplongfun)();
 typedef ssize_t (*lwipssizetfun)();
 typedef void (*lwipvoidfun)();
+typedef struct lwip_ring *pring;
+typedef pring (*pringfun)();
+typedef struct lwip_sqe *psqe;
+typedef psqe (*psqefun)();
 
 pstackfun lwip_stack_new,lwip_stack_new_cap;
 lwipvoidfun lwip_stack_free;
@@ -297,6 +367,15 @@ lwipssizetfun lwip_recv,
 /* Added by Diego Billi */
 lwiplongfun lwip_radv_load_configfile;
 
+pringfun lwip_ring_new;
+psqefun lwip_ring_get_sqe;
+lwiplongfun lwip_ring_free,
+			lwip_ring_fd,
+			lwip_ring_submit,
+			lwip_ring_peek_cqe,
+			lwip_ring_wait_cqe;
+lwipvoidfun lwip_ring_cqe_seen;
+
 static inline void *loadlwipv6dl()
 {
 	struct lwipname2fun {
@@ -347,7 +426,15 @@ static inline void *loadlwipv6dl()
 		{"lwip_add_slirpif", (lwiplongfun *)(&lwip_add_slirpif)}, 
 		{"lwip_radv_load_configfile", (lwiplongfun *)(&lwip_radv_load_configfile)},
 		{"lwip_thread_new", (lwipvoidfun*) (&lwip_thread_new)},
-		{"lwip_event_subscribe", (lwipvoidfun*) (&lwip_event_subscribe)}
+		{"lwip_event_subscribe", (lwipvoidfun*) (&lwip_event_subscribe)},
+		{"lwip_ring_new", (lwiplongfun *)(&lwip_ring_new)},
+		{"lwip_ring_free", &lwip_ring_free},
+		{"lwip_ring_fd", &lwip_ring_fd},
+		{"lwip_ring_get_sqe", (lwiplongfun *)(&lwip_ring_get_sqe)},
+		{"lwip_ring_submit", &lwip_ring_submit},
+		{"lwip_ring_peek_cqe", &lwip_ring_peek_cqe},
+		{"lwip_ring_wait_cqe", &lwip_ring_wait_cqe},
+		{"lwip_ring_cqe_seen", (lwiplongfun *)(&lwip_ring_cqe_seen)}
 	};
 	int i;
 	void *lwiphandle = dlopen("liblwipv6.so",RTLD_NOW); 
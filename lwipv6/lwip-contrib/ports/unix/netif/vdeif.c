@@ -211,6 +211,7 @@ static err_t vdeif_ctl(struct netif *netif, int request, void *arg)
 
 				/* Unset ARP timeout on this interface */
 				sys_untimeout((sys_timeout_handler)arp_timer, netif);
+				etharp_cleanup(netif);
 
 				mem_free(vdeif);
 		}
@@ -532,7 +533,7 @@ err_t vdeif_init(struct netif * netif)
 		return ERR_IF;
 	}
 
-	etharp_init();
+	etharp_init(netif);
 
 	sys_timeout(ARP_TMR_INTERVAL, (sys_timeout_handler)arp_timer, netif);
 
@@ -0,0 +1,157 @@
+/*   This is part of LWIPv6
+ *
+ *   grobench: recv events per MB of a TCP bulk transfer on the loopback
+ *   interface, to measure the receive coalescing (TCP_GRO in lwip/opt.h).
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * A sender thread writes 64MB (or the given amount) to a socket of the
+ * same stack in chunks of 1488 (one segment), 8192 and 65536 bytes (or
+ * of the given size). The receiver reads with a 64KB buffer: each
+ * lwip_read consumes one netbuf, i.e. one recv event of the stack.
+ *
+ * To compare, build the library once as usual and once with
+ * CPPFLAGS=-DTCP_GRO=0, then run "grobench" with each of them.
+ *
+ * usage: grobench [write_size [megabytes]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <lwipv6.h>
+
+#define BENCH_PORT 7100
+#define READ_SIZE 65536
+
+struct bench {
+	struct stack *stack;
+	unsigned short port;
+	int wsize;
+	long total;
+};
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void loopback(struct sockaddr_in *sin, unsigned short port)
+{
+	memset(sin, 0, sizeof(struct sockaddr_in));
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(port);
+	sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static void *sender(void *arg)
+{
+	struct bench *b = arg;
+	struct sockaddr_in sin;
+	char *buf;
+	long sent = 0;
+	int fd;
+
+	buf = calloc(1, b->wsize);
+	fd = lwip_msocket(b->stack, PF_INET, SOCK_STREAM, 0);
+	loopback(&sin, b->port);
+	if (buf == NULL || fd < 0 ||
+			lwip_connect(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+		perror("grobench: connect");
+		exit(1);
+	}
+	while (sent < b->total) {
+		int n = b->wsize;
+		if (n > b->total - sent)
+			n = b->total - sent;
+		if ((n = lwip_write(fd, buf, n)) <= 0) {
+			perror("grobench: write");
+			exit(1);
+		}
+		sent += n;
+	}
+	lwip_close(fd);
+	free(buf);
+	return NULL;
+}
+
+/* returns 0 if all the data has been received */
+static int run(struct bench *b)
+{
+	static char buf[READ_SIZE];
+	struct sockaddr_in sin;
+	pthread_t th;
+	long got = 0, events = 0;
+	int lfd, fd, n;
+	double t0, t;
+
+	lfd = lwip_msocket(b->stack, PF_INET, SOCK_STREAM, 0);
+	loopback(&sin, b->port);
+	if (lfd < 0 || lwip_bind(lfd, (struct sockaddr *) &sin, sizeof(sin)) < 0 ||
+			lwip_listen(lfd, 1) < 0) {
+		perror("grobench: listen");
+		return -1;
+	}
+	pthread_create(&th, NULL, sender, b);
+	if ((fd = lwip_accept(lfd, NULL, NULL)) < 0) {
+		perror("grobench: accept");
+		return -1;
+	}
+	t0 = now();
+	while ((n = lwip_read(fd, buf, sizeof(buf))) > 0) {
+		got += n;
+		events++;
+	}
+	t = now() - t0;
+	pthread_join(th, NULL);
+	lwip_close(fd);
+	lwip_close(lfd);
+	printf("write size %6d: %5.0f recv events/MB, %6.1f MB/s\n", b->wsize,
+			events / (got / 1048576.0), got / t / 1e6);
+	return got != b->total;
+}
+
+int main(int argc, char *argv[])
+{
+	static int wsizes[] = {1488, 8192, 65536};
+	struct bench b;
+	int i, rv = 0;
+
+	if (argc > 3 || (argc > 1 && atoi(argv[1]) <= 0) || (argc > 2 && atoi(argv[2]) <= 0)) {
+		fprintf(stderr, "usage: %s [write_size [megabytes]]\n", argv[0]);
+		return 2;
+	}
+	if ((b.stack = lwip_add_stack(0)) == NULL) {
+		perror("grobench: lwip_add_stack");
+		return 1;
+	}
+	b.total = (argc > 2) ? atol(argv[2]) << 20 : 64L << 20;
+	for (i = 0; i < 3; i++) {
+		b.port = BENCH_PORT + i;
+		b.wsize = (argc > 1) ? atoi(argv[1]) : wsizes[i];
+		rv |= run(&b);
+		if (argc > 1)
+			break;
+	}
+	lwip_del_stack(b.stack);
+	return rv;
+}
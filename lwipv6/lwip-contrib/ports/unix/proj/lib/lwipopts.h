@@ -194,8 +194,8 @@ a lot of data that needs to be copied, this should be set high. */
    defined to 0, all packets with IP options are dropped. */
 #define IP_OPTIONS              1
 
-/* # of suspended fragments */
-#define IP_REASS_POOL_SIZE      5
+/* # of datagrams being reassembled (entries are allocated on demand) */
+#define IP_REASS_POOL_SIZE      64
 
 /* ---------- ICMP options ---------- */
 
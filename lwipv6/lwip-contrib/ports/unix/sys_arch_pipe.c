@@ -63,6 +63,7 @@
 
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/types.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -159,12 +160,26 @@ sys_mbox_post(struct sys_mbox *mbox, void *msg)
 	write(mbox->pipe[1],&msg,sizeof(void *));
 }
 /*-----------------------------------------------------------------------------------*/
+/* reads one message from the pipe; returns 0 if there is no whole message */
+static int
+sys_mbox_read(struct sys_mbox *mbox, void **msg)
+{
+	void *discard;
+	int n;
+
+	if (msg == NULL)
+		msg=&discard;
+	do {
+		n=read(mbox->pipe[0],msg,sizeof(void *));
+	} while (n < 0 && errno==EINTR);
+	return (n == sizeof(void *));
+}
+/*-----------------------------------------------------------------------------------*/
 u32_t
 sys_arch_mbox_fetch(struct sys_mbox *mbox, void **msg, u32_t timeout)
 {
 	int fdn;
 	int time;
-	int n;
 
 	fd_set rds;
 	struct timeval tv;
@@ -184,11 +199,7 @@ sys_arch_mbox_fetch(struct sys_mbox *mbox, void **msg, u32_t timeout)
 	} while (fdn < 0 && errno==EINTR);
 	//fprintf(stderr,"FDN %p %d %s %d\n",(void *)mbox,fdn,strerror(errno),FD_ISSET(mbox->pipe[0],&rds));
 
-	if (fdn > 0) {
-		if (msg != NULL)
-			n=read(mbox->pipe[0],msg,sizeof(void *));
-		else
-			n=read(mbox->pipe[0],&fdn,sizeof(void *));
+	if (fdn > 0 && sys_mbox_read(mbox,msg)) {
 	//fprintf(stderr,"sys_mbox_read %p %p %x\n",mbox,(msg==NULL)?NULL:(void *)*msg, (msg==NULL || *msg==NULL)?0:**(int **)msg);
 	if (timeout != 0)
 		time=timeout - (tv.tv_sec * 1000+tv.tv_usec / 1000);
@@ -205,6 +216,29 @@ sys_arch_mbox_fetch(struct sys_mbox *mbox, void **msg, u32_t timeout)
   return time;
 }
 /*-----------------------------------------------------------------------------------*/
+u32_t
+sys_arch_mbox_tryfetch(struct sys_mbox *mbox, void **msg)
+{
+	int fdn;
+	fd_set rds;
+	struct timeval tv;
+	FD_ZERO(&rds);
+	FD_SET(mbox->pipe[0],&rds);
+	tv.tv_sec=tv.tv_usec=0;
+
+	do {
+		fdn=select(mbox->pipe[0]+1,&rds,NULL,NULL,&tv);
+	} while (fdn < 0 && errno==EINTR);
+
+	if (fdn > 0 && sys_mbox_read(mbox,msg))
+		return 0;
+	else {
+		if (msg != NULL)
+			*msg=NULL;
+		return SYS_MBOX_EMPTY;
+	}
+}
+/*-----------------------------------------------------------------------------------*/
 struct sys_sem *
 sys_sem_new(u8_t count)
 {
@@ -345,6 +379,16 @@ time_now()
 	return tv.tv_sec;
 }
 /*-----------------------------------------------------------------------------------*/
+/* monotonic time in microseconds (used by the stack timer wheel) */
+unsigned long
+sys_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long) ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+/*-----------------------------------------------------------------------------------*/
 void
 sys_init()
 {
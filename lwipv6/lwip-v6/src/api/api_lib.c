@@ -254,6 +254,7 @@ netconn *netconn_new_with_proto_and_callback(struct stack *stack, enum netconn_t
   conn->socket = 0;
   conn->callback = callback;
   conn->recv_avail = 0;
+  conn->aio = NULL;
 
   msg.type = API_MSG_NEWCONN;
   msg.msg.msg.bc.port = proto; /* misusing the port field */
@@ -285,27 +286,16 @@ netconn *netconn_new_with_callback(struct stack *stack, enum netconn_type type,
 }
 
 
-err_t
-netconn_delete(struct netconn *conn)
+/* drain and free the mailboxes of a deleted conn: everything has been
+   posted before the ack of the DELCONN message, no need to wait */
+static void
+netconn_free(struct netconn *conn, err_t (* delete)(struct netconn *conn))
 {
-  struct api_msg msg;
   void *mem;
-	//fprintf(stderr, "netconn_delete %p\n",conn);
-  
-  if (conn == NULL) {
-    return ERR_OK;
-  }
-  
-  msg.type = API_MSG_DELCONN;
-  msg.msg.conn = conn;
-  
-  api_msg_post(conn->stack, &msg);  
-  
-  sys_mbox_fetch(conn->mbox, NULL);
 
   /* Drain the recvmbox. */
   if (conn->recvmbox != SYS_MBOX_NULL) {
-    while (sys_arch_mbox_fetch(conn->recvmbox, &mem, 1) != SYS_ARCH_TIMEOUT) {
+    while (sys_arch_mbox_tryfetch(conn->recvmbox, &mem) != SYS_MBOX_EMPTY) {
       if (conn->type == NETCONN_TCP) {
 				if (mem != NULL)
 					pbuf_free((struct pbuf *)mem);
@@ -319,8 +309,8 @@ netconn_delete(struct netconn *conn)
 
   /* Drain the acceptmbox. */
   if (conn->acceptmbox != SYS_MBOX_NULL) {
-    while (sys_arch_mbox_fetch(conn->acceptmbox, &mem, 1) != SYS_ARCH_TIMEOUT) {
-      netconn_delete((struct netconn *)mem);
+    while (sys_arch_mbox_tryfetch(conn->acceptmbox, &mem) != SYS_MBOX_EMPTY) {
+      delete((struct netconn *)mem);
     }
     
     sys_mbox_free(conn->acceptmbox);
@@ -335,6 +325,49 @@ netconn_delete(struct netconn *conn)
   
   conn->sem = SYS_SEM_NULL; /* this should not be commented out!*/
   memp_free(MEMP_NETCONN, conn);
+}
+
+err_t
+netconn_delete(struct netconn *conn)
+{
+  struct api_msg msg;
+	//fprintf(stderr, "netconn_delete %p\n",conn);
+  
+  if (conn == NULL) {
+    return ERR_OK;
+  }
+  
+  msg.type = API_MSG_DELCONN;
+  msg.msg.conn = conn;
+  
+  api_msg_post(conn->stack, &msg);  
+  
+  sys_mbox_fetch(conn->mbox, NULL);
+
+  netconn_free(conn, netconn_delete);
+  return ERR_OK;
+}
+
+/* The stack thread cannot post to itself and wait: the message is
+   processed in place and its ack is already in conn->mbox */
+err_t
+netconn_delete_tcpip(struct netconn *conn)
+{
+  struct api_msg msg;
+  void *ack;
+
+  if (conn == NULL) {
+    return ERR_OK;
+  }
+
+  msg.type = API_MSG_DELCONN;
+  msg.msg.conn = conn;
+
+  api_msg_input(&msg);
+
+  sys_arch_mbox_tryfetch(conn->mbox, &ack);
+
+  netconn_free(conn, netconn_delete_tcpip);
   return ERR_OK;
 }
 
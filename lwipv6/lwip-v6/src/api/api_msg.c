@@ -56,6 +56,7 @@
 #include "lwip/memp.h"
 #include "lwip/sys.h"
 #include "lwip/tcpip.h"
+#include "lwip/sockring.h"
 
 static inline void pending_conn_mbox(struct netconn *conn)
 {
@@ -346,6 +347,7 @@ accept_function(void *arg, struct tcp_pcb *newpcb, err_t err)
   newconn->ack_pending = 0;
   newconn->err = err;
   newconn->recv_avail = 0;
+  newconn->aio = NULL;
   newconn->socket = conn->socket;
 	newconn->callback = conn->callback;
 	if (newconn->callback) 
@@ -432,6 +434,8 @@ static void
 do_delconn(struct api_msg_msg *msg)
 {
 	pending_conn_mbox(msg->conn);
+	if (msg->conn->aio != NULL)
+		sockring_cancel(msg->conn);
   if (msg->conn->pcb.tcp != NULL) {
     switch (msg->conn->type) {
 #if LWIP_RAW
@@ -587,6 +591,9 @@ do_connected(void *arg, struct tcp_pcb *pcb, err_t err)
   if (conn->type == NETCONN_TCP && err == ERR_OK) {
     setup_tcp(conn);
   }    
+  /* Trigger select() in socket layer (and resume a ring connect) */
+  if (conn->callback)
+    (*conn->callback)(conn, NETCONN_EVT_SENDPLUS, 0);
 	ack_conn_mbox(conn);
   return ERR_OK;
 }
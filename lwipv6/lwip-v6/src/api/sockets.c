@@ -72,6 +72,7 @@
 #include "lwip/sockets.h"
 
 #include "lwip/tcpip.h"
+#include "lwip/sockring.h"
 
 #if LWIP_NL
 #include "lwip/netlink.h"
@@ -365,7 +366,11 @@ static err_t sync_pcb_access(struct netconn *conn, void *arg)
 	struct opt_data *data = arg;
 	switch (data->opfieldtag) {
 		case opfield(OPT_SETBITS, OPT_SO_OPTIONS): 
-			conn->pcb.common->so_options |= *data->value; break;
+			conn->pcb.common->so_options |= *data->value;
+			/* start the KEEPALIVE timer */
+			if (conn->type == NETCONN_TCP && (*data->value & SOF_KEEPALIVE))
+				tcp_timer_idle(conn->pcb.tcp);
+			break;
 		case opfield(OPT_CLRBITS, OPT_SO_OPTIONS): 
 			conn->pcb.common->so_options &= ~(*data->value); break;
 		case opfield(OPT_GETMASKED, OPT_SO_OPTIONS): 
@@ -389,7 +394,9 @@ static err_t sync_pcb_access(struct netconn *conn, void *arg)
 			(*data->value) = conn->pcb.tcp->ttl; break;
 
 		case opfield(OPT_SETVALUE, OPT_KEEPALIVE):
-			conn->pcb.tcp->keepalive = (*data->value); break;
+			conn->pcb.tcp->keepalive = (*data->value);
+			tcp_timer_idle(conn->pcb.tcp);
+			break;
 		case opfield(OPT_GETVALUE, OPT_KEEPALIVE):
 			(*data->value) = conn->pcb.tcp->keepalive; break;
 
@@ -547,10 +554,22 @@ lwip_bind(int s, struct sockaddr *name, socklen_t namelen)
 	}
 }
 
+/* called with socksem held */
+	static void
+sock_release(int s, struct lwip_socket *sock)
+{
+	sockets[get_lwip_sockmap(s)]=NULL;
+	if (! _nofdfake)
+		close(sock->fdfake);
+	set_lwip_sockmap(sock->fdfake, -1);
+	mem_free(sock);
+}
+
 	int
 lwip_close(int s)
 {
 	struct lwip_socket *sock;
+	struct netconn *conn;
 	int err=0;
 
 	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_close(%d)\n", s));
@@ -566,33 +585,85 @@ lwip_close(int s)
 		set_errno(EBADF);
 		return -1;
 	}
+	/* get_socket fails from now on, the slot stays reserved.
+		 socksem is not held while waiting for the stack thread:
+		 the stack thread needs it to allocate (and release) sockets */
+	conn = sock->conn;
+	sock->conn = NULL;
+	sys_sem_signal(socksem);
 
 #if LWIP_NL
-	if (sock->family == PF_NETLINK) {
-		err=netlink_close(sock->conn);
-		sock->conn = NULL;
-	}
+	if (sock->family == PF_NETLINK)
+		err=netlink_close(conn);
 	else 
 #endif
 	{
-		netconn_delete(sock->conn);
+		netconn_delete(conn);
 		if (sock->lastdata) {
 			netbuf_delete(sock->lastdata);
 		}
 		sock->lastdata = NULL;
 		sock->lastoffset = 0;
-		sock->conn = NULL;
 	}
-	sockets[get_lwip_sockmap(s)]=NULL;
-	if (! _nofdfake)
-		close(sock->fdfake);
-	set_lwip_sockmap(sock->fdfake, -1);
+	sys_sem_wait(socksem);
 	sock_set_errno(sock, err);
-	mem_free(sock);
+	sock_release(s, sock);
 	sys_sem_signal(socksem);
 	return err;
 }
 
+/* socket rings (sockring.c) work on the netconns, in the stack thread */
+struct netconn *
+lwip_socket_netconn(int s, u16_t *family)
+{
+	struct lwip_socket *sock = get_socket(s);
+
+	if (!sock
+#if LWIP_NL
+			|| sock->family == PF_NETLINK
+#endif
+		 )
+		return NULL;
+	if (family != NULL)
+		*family = sock->family;
+	return sock->conn;
+}
+
+struct netconn *
+lwip_socket_detach(int s)
+{
+	struct lwip_socket *sock;
+	struct netconn *conn;
+
+	if (!socksem)
+		socksem = sys_sem_new(1);
+
+	sys_sem_wait(socksem);
+
+	sock = get_socket(s);
+	if (!sock
+#if LWIP_NL
+			|| sock->family == PF_NETLINK
+#endif
+		 ) {
+		sys_sem_signal(socksem);
+		return NULL;
+	}
+	conn = sock->conn;
+	if (sock->lastdata)
+		netbuf_delete(sock->lastdata);
+	sock->conn = NULL;
+	sock_release(s, sock);
+	sys_sem_signal(socksem);
+	return conn;
+}
+
+int
+lwip_socket_errno(err_t err)
+{
+	return err_to_errno(err);
+}
+
 	int
 lwip_connect(int s, struct sockaddr *name, socklen_t namelen)
 {
@@ -851,7 +922,9 @@ lwip_recv(int s, void *mem, int len, unsigned int flags)
 
 ssize_t lwip_recvmsg(int fd, struct msghdr *msg, int flags)
 {
+	/* no ancillary data is ever received */
 	msg->msg_controllen=0;
+	msg->msg_flags=0;
 	if (msg->msg_iovlen == 1) {
 		ssize_t ret=lwip_recvfrom(fd, msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
 				msg->msg_name,&(msg->msg_namelen));
@@ -862,23 +935,32 @@ ssize_t lwip_recvmsg(int fd, struct msghdr *msg, int flags)
 	} else {
 		struct iovec *msg_iov;
 		size_t msg_iovlen;
-		unsigned int i,totalsize;
-		size_t size;
-		char *lbuf;
+		size_t i,totalsize,len;
+		ssize_t size;
+		char *buf,*lbuf;
 		msg_iov=msg->msg_iov;
 		msg_iovlen=msg->msg_iovlen;
+		if (msg_iovlen > UIO_MAXIOV) {
+			set_errno(EMSGSIZE);
+			return -1;
+		}
 		for (i=0,totalsize=0;i<msg_iovlen;i++)
 			totalsize += msg_iov[i].iov_len;
-		lbuf=alloca(totalsize);
-		size=lwip_recvfrom(fd, lbuf, totalsize, flags, msg->msg_name,&(msg->msg_namelen));
-		if (size > totalsize)
+		if ((lbuf=buf=mem_malloc(totalsize ? totalsize : 1)) == NULL) {
+			set_errno(ENOMEM);
+			return -1;
+		}
+		size=lwip_recvfrom(fd, buf, totalsize, flags, msg->msg_name,&(msg->msg_namelen));
+		if (size > (ssize_t) totalsize)
 			msg->msg_flags |= MSG_TRUNC;
-		for (i=0;size > 0 && i<msg_iovlen;i++) {
-			int qty=(size > msg_iov[i].iov_len)?msg_iov[i].iov_len:size;
+		/* scatter the data received to the iovecs */
+		for (i=0,len=(size > 0)?size:0;len > 0 && i<msg_iovlen;i++) {
+			size_t qty=(len > msg_iov[i].iov_len)?msg_iov[i].iov_len:len;
 			memcpy(msg_iov[i].iov_base,lbuf,qty);
 			lbuf+=qty;
-			size-=qty;
+			len-=qty;
 		}
+		mem_free(buf);
 		return size;
 	}
 }
@@ -1019,27 +1101,39 @@ lwip_sendto(int s, void *data, int size, unsigned int flags,
 
 ssize_t lwip_sendmsg(int fd, struct msghdr *msg, int flags)
 {
-	msg->msg_controllen=0;
+	/* ancillary data cannot be sent */
+	if (msg->msg_controllen > 0) {
+		set_errno(EOPNOTSUPP);
+		return -1;
+	}
 	if (msg->msg_iovlen == 1) {
 		return lwip_sendto(fd, msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
 				msg->msg_name,msg->msg_namelen);
 	} else {
 		struct iovec *msg_iov;
 		size_t msg_iovlen;
-		unsigned int i,totalsize;
-		size_t size;
-		char *lbuf;
+		size_t i,totalsize;
+		ssize_t size;
+		char *buf,*lbuf;
 		msg_iov=msg->msg_iov;
 		msg_iovlen=msg->msg_iovlen;
+		if (msg_iovlen > UIO_MAXIOV) {
+			set_errno(EMSGSIZE);
+			return -1;
+		}
 		for (i=0,totalsize=0;i<msg_iovlen;i++)
 			totalsize += msg_iov[i].iov_len;
-		for (i=0;size > 0 && i<msg_iovlen;i++) {
-			int qty=msg_iov[i].iov_len;
-			memcpy(lbuf,msg_iov[i].iov_base,qty);
-			lbuf+=qty;
-			size-=qty;
+		if ((lbuf=buf=mem_malloc(totalsize ? totalsize : 1)) == NULL) {
+			set_errno(ENOMEM);
+			return -1;
+		}
+		/* gather the iovecs in a single datagram */
+		for (i=0;i<msg_iovlen;i++) {
+			memcpy(lbuf,msg_iov[i].iov_base,msg_iov[i].iov_len);
+			lbuf+=msg_iov[i].iov_len;
 		}
-		size=lwip_sendto(fd, lbuf, totalsize, flags, msg->msg_name,msg->msg_namelen);
+		size=lwip_sendto(fd, buf, totalsize, flags, msg->msg_name,msg->msg_namelen);
+		mem_free(buf);
 		return size;
 	}
 }
@@ -1299,6 +1393,10 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
 	struct lwip_socket *sock;
 
 	//printf("event_callback %p %d\n",conn,evt);
+	/* resume the ring operations parked on conn */
+	if (conn && conn->aio &&
+			(evt == NETCONN_EVT_RCVPLUS || evt == NETCONN_EVT_SENDPLUS))
+		sockring_event(conn);
 	/* Get socket */
 	if (conn)
 	{
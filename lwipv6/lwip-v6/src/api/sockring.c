@@ -0,0 +1,749 @@
+/*   This is part of LWIPv6
+ *   Developed for the Ale4NET project
+ *   Application Level Environment for Networking
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/api.h"
+#include "lwip/api_msg.h"
+#include "lwip/arch.h"
+#include "lwip/sys.h"
+#include "lwip/mem.h"
+#include "lwip/tcpip.h"
+#include "lwip/stack.h"
+#include "lwip/sockring.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+
+#ifndef SOCKRING_DEBUG
+#define SOCKRING_DEBUG DBG_OFF
+#endif
+
+#define LWIP_RING_MAX_ENTRIES 4096
+
+/* the queue indexes are shared between the caller and the stack thread */
+#define sockring_barrier() __sync_synchronize()
+
+/* an operation taken from the submission queue */
+struct sockring_op {
+	struct lwip_sqe sqe;
+	struct lwip_ring *ring;
+	struct sockring_op *next;
+	u16_t family;
+	u32_t done;              /* send: bytes already queued */
+};
+
+/* per netconn state, allocated at the first ring operation */
+struct sockring_conn {
+	struct netconn *conn;
+	struct sockring_op *rd, **rdtail;    /* recv/accept */
+	struct sockring_op *wr, **wrtail;    /* send/connect */
+	struct sockring_conn *next;          /* stack ready list */
+	struct pbuf *p;                      /* received data not consumed yet */
+	u16_t off;
+	u8_t ready;
+	u8_t connecting;
+	u8_t eof;
+};
+
+struct lwip_ring {
+	struct stack *stack;
+	u32_t sq_mask;
+	u32_t cq_mask;
+	/* submission queue: caller -> stack thread */
+	struct lwip_sqe *sqes;
+	volatile u32_t sq_head;  /* written by the stack thread */
+	volatile u32_t sq_tail;  /* published by lwip_ring_submit */
+	u32_t sq_next;           /* handed out by lwip_ring_get_sqe */
+	/* completion queue: stack thread -> caller */
+	struct lwip_cqe *cqes;
+	volatile u32_t cq_head;  /* written by the caller */
+	volatile u32_t cq_tail;  /* written by the stack thread */
+	volatile u32_t inflight; /* submitted, completion not seen yet */
+	volatile int kicked;     /* a sockring_run message is queued */
+	volatile int notified;   /* the notification pipe is not empty */
+	int pipe[2];
+	struct sockring_op *ops;
+	struct sockring_op *freeops; /* stack thread only */
+};
+
+/*---------------------------------------------------------------------------*/
+/* stack thread side */
+
+static void
+sockring_notify(struct lwip_ring *ring)
+{
+	if (__sync_lock_test_and_set(&ring->notified, 1) == 0) {
+		char c = 0;
+		write(ring->pipe[1], &c, 1);
+	}
+}
+
+static void
+sockring_complete(struct sockring_op *op, s32_t res)
+{
+	struct lwip_ring *ring = op->ring;
+	struct lwip_cqe *cqe = &ring->cqes[ring->cq_tail & ring->cq_mask];
+
+	LWIP_DEBUGF(SOCKRING_DEBUG, ("sockring_complete: op %d fd %d res %d\n",
+				op->sqe.opcode, op->sqe.fd, (int)res));
+	cqe->user_data = op->sqe.user_data;
+	cqe->res = res;
+	cqe->flags = 0;
+	op->next = ring->freeops;
+	ring->freeops = op;
+	sockring_barrier();
+	ring->cq_tail++;
+	sockring_notify(ring);
+}
+
+static void
+sockring_sockaddr(u16_t family, struct sockaddr *addr, socklen_t *paddrlen,
+		struct ip_addr *ip, u16_t port)
+{
+	if (addr == NULL || paddrlen == NULL)
+		return;
+	if (family == PF_INET) {
+		struct sockaddr_in sin;
+		memset(&sin, 0, sizeof(sin));
+		sin.sin_family = PF_INET;
+		sin.sin_port = htons(port);
+		memcpy(&(sin.sin_addr.s_addr), &(ip->addr[3]), sizeof(sin.sin_addr.s_addr));
+		if (*paddrlen > sizeof(sin))
+			*paddrlen = sizeof(sin);
+		memcpy(addr, &sin, *paddrlen);
+	} else if (family == PF_INET6) {
+		struct sockaddr_in6 sin;
+		memset(&sin, 0, sizeof(sin));
+		sin.sin6_family = PF_INET6;
+		sin.sin6_port = htons(port);
+		memcpy(&(sin.sin6_addr), &(ip->addr), sizeof(sin.sin6_addr));
+		if (*paddrlen > sizeof(sin))
+			*paddrlen = sizeof(sin);
+		memcpy(addr, &sin, *paddrlen);
+	} else
+		*paddrlen = 0;
+}
+
+static int
+sockring_ipaddr(u16_t family, struct sockaddr *addr, socklen_t addrlen,
+		struct ip_addr *ip, u16_t *port)
+{
+	if (addr == NULL)
+		return -EFAULT;
+	if (family == PF_INET) {
+		struct sockaddr_in *sin = (struct sockaddr_in *) addr;
+		if (addrlen < sizeof(*sin))
+			return -EINVAL;
+		ip->addr[0] = 0;
+		ip->addr[1] = 0;
+		ip->addr[2] = IP64_PREFIX;
+		memcpy(&(ip->addr[3]), &(sin->sin_addr.s_addr), sizeof(ip->addr[3]));
+		*port = ntohs(sin->sin_port);
+	} else if (family == PF_INET6) {
+		struct sockaddr_in6 *sin = (struct sockaddr_in6 *) addr;
+		if (addrlen < sizeof(*sin))
+			return -EINVAL;
+		memcpy(&(ip->addr), &(sin->sin6_addr), sizeof(ip->addr));
+		*port = ntohs(sin->sin6_port);
+	} else
+		return -EAFNOSUPPORT;
+	return 0;
+}
+
+static int
+sockring_recv(struct sockring_conn *sc, struct sockring_op *op)
+{
+	struct netconn *conn = sc->conn;
+	void *msg;
+	u16_t len;
+
+	if (conn->recvmbox == SYS_MBOX_NULL) {
+		sockring_complete(op, -ENOTCONN);
+		return 1;
+	}
+	if (conn->type == NETCONN_TCP) {
+		struct netbuf nb;
+
+		if (sc->p == NULL) {
+			if (sc->eof) {
+				sockring_complete(op, 0);
+				return 1;
+			}
+			if (!conn->connected && !sc->connecting) {
+				sockring_complete(op, -ENOTCONN);
+				return 1;
+			}
+			if (sys_arch_mbox_tryfetch(conn->recvmbox, &msg) == SYS_MBOX_EMPTY)
+				return 0;
+			if (msg == NULL) {
+				/* end of stream, or error set by err_tcp */
+				sc->eof = 1;
+				if (conn->callback)
+					(*conn->callback)(conn, NETCONN_EVT_RCVMINUS, 0);
+				sockring_complete(op, (conn->err == ERR_OK || conn->err == ERR_CLSD) ?
+						0 : -lwip_socket_errno(conn->err));
+				return 1;
+			}
+			/* the whole pbuf leaves the window, as in netconn_recv */
+			sc->p = (struct pbuf *) msg;
+			sc->off = 0;
+			len = sc->p->tot_len;
+			conn->recv_avail -= len;
+			if (conn->callback)
+				(*conn->callback)(conn, NETCONN_EVT_RCVMINUS, len);
+			if (conn->pcb.tcp != NULL)
+				tcp_recved(conn->pcb.tcp, len);
+		}
+		nb.p = nb.ptr = sc->p;
+		len = sc->p->tot_len - sc->off;
+		if (len > op->sqe.len)
+			len = op->sqe.len;
+		netbuf_copy_partial(&nb, op->sqe.buf, len, sc->off);
+		sc->off += len;
+		if (sc->off >= sc->p->tot_len) {
+			pbuf_free(sc->p);
+			sc->p = NULL;
+		}
+		sockring_complete(op, len);
+	} else {
+		struct netbuf *buf;
+
+		if (sys_arch_mbox_tryfetch(conn->recvmbox, &msg) == SYS_MBOX_EMPTY)
+			return 0;
+		buf = (struct netbuf *) msg;
+		len = netbuf_len(buf);
+		conn->recv_avail -= len;
+		if (conn->callback)
+			(*conn->callback)(conn, NETCONN_EVT_RCVMINUS, len);
+		/* datagrams are truncated */
+		if (len > op->sqe.len)
+			len = op->sqe.len;
+		netbuf_copy_partial(buf, op->sqe.buf, len, 0);
+		sockring_sockaddr(op->family, op->sqe.addr, op->sqe.paddrlen,
+				netbuf_fromaddr(buf), netbuf_fromport(buf));
+		netbuf_delete(buf);
+		sockring_complete(op, len);
+	}
+	return 1;
+}
+
+static int
+sockring_send(struct sockring_conn *sc, struct sockring_op *op)
+{
+	struct netconn *conn = sc->conn;
+
+	if (conn->type == NETCONN_TCP) {
+		struct tcp_pcb *pcb;
+		err_t err = ERR_OK;
+		u32_t queued = 0;
+
+		while (op->done < op->sqe.len) {
+			u32_t len = op->sqe.len - op->done;
+			u16_t avail;
+
+			if ((pcb = conn->pcb.tcp) == NULL) {
+				err = (conn->err != ERR_OK) ? conn->err : ERR_CONN;
+				break;
+			}
+			if ((avail = tcp_sndbuf(pcb)) == 0)
+				break;
+			if (len > avail)
+				len = avail;
+			if ((err = tcp_write(pcb, (u8_t *) op->sqe.buf + op->done, len, 1)) != ERR_OK)
+				break;
+			op->done += len;
+			queued += len;
+		}
+		if ((pcb = conn->pcb.tcp) != NULL && queued > 0) {
+			/* Nagle, as in do_write */
+			if (pcb->unacked == NULL || (pcb->flags & TF_NODELAY))
+				tcp_output(pcb);
+			if (conn->callback && tcp_sndbuf(pcb) <= TCP_SNDLOWAT)
+				(*conn->callback)(conn, NETCONN_EVT_SENDMINUS, queued);
+		}
+		if (op->done == op->sqe.len)
+			sockring_complete(op, op->done);
+		else if (err != ERR_OK && err != ERR_MEM)
+			sockring_complete(op, (op->done > 0) ? op->done : -lwip_socket_errno(err));
+		else
+			/* sndbuf full: sent_tcp resumes the operation */
+			return 0;
+	} else {
+		struct netbuf *buf;
+		struct api_msg msg;
+		void *ack;
+
+		if (op->sqe.len > 0xffff) {
+			sockring_complete(op, -EMSGSIZE);
+			return 1;
+		}
+		if ((buf = netbuf_new()) == NULL) {
+			sockring_complete(op, -ENOMEM);
+			return 1;
+		}
+		netbuf_ref(buf, op->sqe.buf, op->sqe.len);
+		msg.type = API_MSG_SEND;
+		msg.msg.conn = conn;
+		msg.msg.msg.p = buf->p;
+		api_msg_input(&msg);
+		sys_arch_mbox_tryfetch(conn->mbox, &ack);
+		netbuf_delete(buf);
+		sockring_complete(op, (conn->err == ERR_OK) ?
+				(s32_t) op->sqe.len : -lwip_socket_errno(conn->err));
+	}
+	return 1;
+}
+
+static int
+sockring_accept(struct sockring_conn *sc, struct sockring_op *op)
+{
+	struct netconn *conn = sc->conn;
+	struct netconn *newconn;
+	void *msg;
+
+	if (conn->type != NETCONN_TCP || conn->acceptmbox == SYS_MBOX_NULL) {
+		sockring_complete(op, -EINVAL);
+		return 1;
+	}
+	if (sys_arch_mbox_tryfetch(conn->acceptmbox, &msg) == SYS_MBOX_EMPTY)
+		return 0;
+	newconn = (struct netconn *) msg;
+	if (conn->callback)
+		(*conn->callback)(conn, NETCONN_EVT_RCVMINUS, 0);
+	if (newconn == NULL) {
+		sockring_complete(op, -ECONNABORTED);
+		return 1;
+	}
+	/* set by the EVT_ACCEPTPLUS event */
+	if (newconn->socket < 0) {
+		netconn_delete_tcpip(newconn);
+		sockring_complete(op, -ENOBUFS);
+		return 1;
+	}
+	newconn->connected = 1;
+	if (newconn->pcb.tcp != NULL)
+		sockring_sockaddr(op->family, op->sqe.addr, op->sqe.paddrlen,
+				&(newconn->pcb.tcp->remote_ip), newconn->pcb.tcp->remote_port);
+	sockring_complete(op, newconn->socket);
+	return 1;
+}
+
+static int
+sockring_connect(struct sockring_conn *sc, struct sockring_op *op)
+{
+	struct netconn *conn = sc->conn;
+	void *ack;
+
+	if (!sc->connecting) {
+		struct api_msg msg;
+		struct ip_addr ipaddr;
+		u16_t port;
+		int rv;
+
+		if (conn->type == NETCONN_TCP && conn->connected) {
+			sockring_complete(op, -EISCONN);
+			return 1;
+		}
+		rv = sockring_ipaddr(op->family, op->sqe.addr, op->sqe.addrlen, &ipaddr, &port);
+		if (rv < 0) {
+			sockring_complete(op, rv);
+			return 1;
+		}
+		if (conn->recvmbox == SYS_MBOX_NULL &&
+				(conn->recvmbox = sys_mbox_new()) == SYS_MBOX_NULL) {
+			sockring_complete(op, -ENOMEM);
+			return 1;
+		}
+		msg.type = API_MSG_CONNECT;
+		msg.msg.conn = conn;
+		msg.msg.msg.bc.ipaddr = &ipaddr;
+		msg.msg.msg.bc.port = port;
+		api_msg_input(&msg);
+		sc->connecting = 1;
+	}
+	/* do_connect (or do_connected/err_tcp for tcp) acks on conn->mbox */
+	if (sys_arch_mbox_tryfetch(conn->mbox, &ack) == SYS_MBOX_EMPTY)
+		return 0;
+	sc->connecting = 0;
+	if (conn->err != ERR_OK) {
+		sockring_complete(op, -lwip_socket_errno(conn->err));
+		return 1;
+	}
+	conn->connected = 1;
+	sockring_complete(op, 0);
+	return 1;
+}
+
+/* returns 0 when the operation has to wait for an event */
+static int
+sockring_op_run(struct sockring_conn *sc, struct sockring_op *op)
+{
+	switch (op->sqe.opcode) {
+		case LWIP_RING_OP_RECV:
+			return sockring_recv(sc, op);
+		case LWIP_RING_OP_SEND:
+			return sockring_send(sc, op);
+		case LWIP_RING_OP_ACCEPT:
+			return sockring_accept(sc, op);
+		case LWIP_RING_OP_CONNECT:
+			return sockring_connect(sc, op);
+	}
+	sockring_complete(op, -EINVAL);
+	return 1;
+}
+
+static void
+sockring_queue_run(struct sockring_conn *sc,
+		struct sockring_op **head, struct sockring_op ***tail)
+{
+	struct sockring_op *op;
+
+	while ((op = *head) != NULL) {
+		struct sockring_op *next = op->next;
+		if (!sockring_op_run(sc, op))
+			break;
+		*head = next;
+		if (next == NULL)
+			*tail = head;
+	}
+}
+
+static void
+sockring_conn_run(struct sockring_conn *sc)
+{
+	sockring_queue_run(sc, &sc->rd, &sc->rdtail);
+	sockring_queue_run(sc, &sc->wr, &sc->wrtail);
+}
+
+static struct sockring_conn *
+sockring_conn_get(struct netconn *conn)
+{
+	struct sockring_conn *sc = conn->aio;
+
+	if (sc == NULL && (sc = mem_malloc(sizeof(struct sockring_conn))) != NULL) {
+		memset(sc, 0, sizeof(struct sockring_conn));
+		sc->conn = conn;
+		sc->rdtail = &sc->rd;
+		sc->wrtail = &sc->wr;
+		conn->aio = sc;
+	}
+	return sc;
+}
+
+static void
+sockring_close(struct sockring_op *op)
+{
+	struct netconn *conn = lwip_socket_detach(op->sqe.fd);
+
+	if (conn == NULL) {
+		sockring_complete(op, -EBADF);
+		return;
+	}
+	/* do_delconn cancels the operations still parked on conn */
+	netconn_delete_tcpip(conn);
+	sockring_complete(op, 0);
+}
+
+static void
+sockring_start(struct lwip_ring *ring, struct sockring_op *op)
+{
+	struct netconn *conn;
+	struct sockring_conn *sc;
+
+	switch (op->sqe.opcode) {
+		case LWIP_RING_OP_NOP:
+			sockring_complete(op, 0);
+			return;
+		case LWIP_RING_OP_CLOSE:
+			sockring_close(op);
+			return;
+		case LWIP_RING_OP_RECV:
+		case LWIP_RING_OP_SEND:
+		case LWIP_RING_OP_ACCEPT:
+		case LWIP_RING_OP_CONNECT:
+			break;
+		default:
+			sockring_complete(op, -EINVAL);
+			return;
+	}
+	if ((conn = lwip_socket_netconn(op->sqe.fd, &op->family)) == NULL) {
+		sockring_complete(op, -EBADF);
+		return;
+	}
+	if (conn->stack != ring->stack) {
+		sockring_complete(op, -EINVAL);
+		return;
+	}
+	if ((sc = sockring_conn_get(conn)) == NULL) {
+		sockring_complete(op, -ENOMEM);
+		return;
+	}
+	if (op->sqe.opcode == LWIP_RING_OP_RECV || op->sqe.opcode == LWIP_RING_OP_ACCEPT) {
+		*(sc->rdtail) = op;
+		sc->rdtail = &op->next;
+		if (sc->rd == op)
+			sockring_queue_run(sc, &sc->rd, &sc->rdtail);
+	} else {
+		*(sc->wrtail) = op;
+		sc->wrtail = &op->next;
+		if (sc->wr == op)
+			sockring_queue_run(sc, &sc->wr, &sc->wrtail);
+	}
+}
+
+/* one message per lwip_ring_submit batch */
+static void
+sockring_run(void *arg)
+{
+	struct lwip_ring *ring = (struct lwip_ring *) arg;
+	u32_t tail;
+
+	/* a submit from now on queues a new message */
+	__sync_lock_release(&ring->kicked);
+	sockring_barrier();
+	tail = ring->sq_tail;
+	while (ring->sq_head != tail) {
+		struct sockring_op *op = ring->freeops;
+
+		LWIP_ASSERT("sockring_run: no free operation", op != NULL);
+		ring->freeops = op->next;
+		op->sqe = ring->sqes[ring->sq_head & ring->sq_mask];
+		op->ring = ring;
+		op->next = NULL;
+		op->family = 0;
+		op->done = 0;
+		sockring_barrier();
+		ring->sq_head++;
+		sockring_start(ring, op);
+	}
+}
+
+static void
+sockring_ready_run(void *arg)
+{
+	struct stack *stack = (struct stack *) arg;
+	struct sockring_conn *sc;
+
+	stack->sockring_scheduled = 0;
+	while ((sc = stack->sockring_ready) != NULL) {
+		stack->sockring_ready = sc->next;
+		sc->ready = 0;
+		sockring_conn_run(sc);
+	}
+}
+
+/* The event is notified before the data reaches the mailboxes:
+	 the parked operations are resumed by a deferred callback,
+	 once per stack thread loop whatever the number of events */
+void
+sockring_event(struct netconn *conn)
+{
+	struct sockring_conn *sc = conn->aio;
+	struct stack *stack = conn->stack;
+
+	if (sc == NULL || sc->ready || (sc->rd == NULL && sc->wr == NULL))
+		return;
+	sc->ready = 1;
+	sc->next = stack->sockring_ready;
+	stack->sockring_ready = sc;
+	if (!stack->sockring_scheduled &&
+			tcpip_callback(stack, sockring_ready_run, stack, ASYNC) == ERR_OK)
+		stack->sockring_scheduled = 1;
+}
+
+void
+sockring_cancel(struct netconn *conn)
+{
+	struct sockring_conn *sc = conn->aio;
+	struct sockring_op *op;
+
+	if (sc == NULL)
+		return;
+	if (sc->ready) {
+		struct sockring_conn **scan = &(conn->stack->sockring_ready);
+		while (*scan != NULL && *scan != sc)
+			scan = &((*scan)->next);
+		if (*scan != NULL)
+			*scan = sc->next;
+	}
+	while ((op = sc->rd) != NULL) {
+		sc->rd = op->next;
+		sockring_complete(op, -ECANCELED);
+	}
+	while ((op = sc->wr) != NULL) {
+		sc->wr = op->next;
+		sockring_complete(op, -ECANCELED);
+	}
+	if (sc->p != NULL)
+		pbuf_free(sc->p);
+	conn->aio = NULL;
+	mem_free(sc);
+}
+
+/*---------------------------------------------------------------------------*/
+/* caller side */
+
+struct lwip_ring *
+lwip_ring_new(struct stack *stack, unsigned int entries)
+{
+	struct lwip_ring *ring;
+	u32_t size = 1;
+	u32_t i;
+
+	if (stack == NULL || entries == 0 || entries > LWIP_RING_MAX_ENTRIES) {
+		errno = EINVAL;
+		return NULL;
+	}
+	while (size < entries)
+		size <<= 1;
+	if ((ring = mem_malloc(sizeof(struct lwip_ring))) == NULL)
+		goto nomem;
+	memset(ring, 0, sizeof(struct lwip_ring));
+	ring->stack = stack;
+	ring->sq_mask = size - 1;
+	ring->cq_mask = 2 * size - 1;
+	ring->sqes = mem_malloc(size * sizeof(struct lwip_sqe));
+	ring->cqes = mem_malloc(2 * size * sizeof(struct lwip_cqe));
+	ring->ops = mem_malloc(2 * size * sizeof(struct sockring_op));
+	if (ring->sqes == NULL || ring->cqes == NULL || ring->ops == NULL)
+		goto nomem_free;
+	for (i = 0; i < 2 * size; i++) {
+		ring->ops[i].next = ring->freeops;
+		ring->freeops = &ring->ops[i];
+	}
+	if (pipe(ring->pipe) < 0)
+		goto nomem_free;
+	fcntl(ring->pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(ring->pipe[1], F_SETFL, O_NONBLOCK);
+	return ring;
+
+nomem_free:
+	if (ring->sqes) mem_free(ring->sqes);
+	if (ring->cqes) mem_free(ring->cqes);
+	if (ring->ops) mem_free(ring->ops);
+	mem_free(ring);
+nomem:
+	errno = ENOMEM;
+	return NULL;
+}
+
+int
+lwip_ring_free(struct lwip_ring *ring)
+{
+	if (ring->inflight > 0 || ring->sq_next != ring->sq_tail) {
+		errno = EBUSY;
+		return -1;
+	}
+	close(ring->pipe[0]);
+	close(ring->pipe[1]);
+	mem_free(ring->sqes);
+	mem_free(ring->cqes);
+	mem_free(ring->ops);
+	mem_free(ring);
+	return 0;
+}
+
+int
+lwip_ring_fd(struct lwip_ring *ring)
+{
+	return ring->pipe[0];
+}
+
+struct lwip_sqe *
+lwip_ring_get_sqe(struct lwip_ring *ring)
+{
+	struct lwip_sqe *sqe;
+
+	/* the completion queue cannot overflow: an entry is
+		 reserved for each operation in flight */
+	if (ring->sq_next - ring->sq_head > ring->sq_mask ||
+			ring->inflight + (ring->sq_next - ring->sq_tail) > ring->cq_mask)
+		return NULL;
+	sqe = &ring->sqes[ring->sq_next & ring->sq_mask];
+	ring->sq_next++;
+	memset(sqe, 0, sizeof(struct lwip_sqe));
+	return sqe;
+}
+
+int
+lwip_ring_submit(struct lwip_ring *ring)
+{
+	u32_t n = ring->sq_next - ring->sq_tail;
+
+	if (n > 0) {
+		__sync_fetch_and_add(&ring->inflight, n);
+		sockring_barrier();
+		ring->sq_tail = ring->sq_next;
+	}
+	if (ring->sq_head != ring->sq_tail &&
+			__sync_lock_test_and_set(&ring->kicked, 1) == 0 &&
+			tcpip_callback(ring->stack, sockring_run, ring, ASYNC) != ERR_OK) {
+		/* the entries stay queued for the next submit */
+		__sync_lock_release(&ring->kicked);
+		errno = ENOMEM;
+		return -1;
+	}
+	return n;
+}
+
+int
+lwip_ring_peek_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe)
+{
+	if (ring->cq_head == ring->cq_tail) {
+		char buf[16];
+		/* rearm the notification, then check again */
+		while (read(ring->pipe[0], buf, sizeof(buf)) > 0)
+			;
+		__sync_lock_release(&ring->notified);
+		sockring_barrier();
+		if (ring->cq_head == ring->cq_tail)
+			return -EAGAIN;
+	}
+	sockring_barrier();
+	*cqe = &ring->cqes[ring->cq_head & ring->cq_mask];
+	return 0;
+}
+
+int
+lwip_ring_wait_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe)
+{
+	int rv;
+
+	while ((rv = lwip_ring_peek_cqe(ring, cqe)) == -EAGAIN) {
+		struct pollfd pfd;
+		if (ring->inflight == 0)
+			break;
+		pfd.fd = ring->pipe[0];
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		poll(&pfd, 1, -1);
+	}
+	return rv;
+}
+
+void
+lwip_ring_cqe_seen(struct lwip_ring *ring, struct lwip_cqe *cqe)
+{
+	sockring_barrier();
+	ring->cq_head++;
+	__sync_fetch_and_sub(&ring->inflight, 1);
+}
@@ -95,42 +95,6 @@
  * 	exit()
  */
 
-/*---------------------------------------------------------------------------*/
-
-#if LWIP_TCP
-static void
-tcpip_tcp_timer(void *arg)
-{
-	struct stack *stack = (struct stack *) arg;
-	
-	/* call TCP timer handler */
-	tcp_tmr(stack);
-	
-	/* timer still needed? */
-	if (stack->tcp_active_pcbs || stack->tcp_tw_pcbs) {
-		/* restart timer */
-		sys_timeout(TCP_TMR_INTERVAL, tcpip_tcp_timer, (void*)stack);
-	} else {
-		/* disable timer */
-		stack->tcpip_tcp_timer_active = 0;
-	}
-}
-
-#if !NO_SYS
-void
-tcp_timer_needed(struct stack *stack)
-{
-	/* timer is off but needed again? */
-	if (!stack->tcpip_tcp_timer_active && 
-	    (stack->tcp_active_pcbs || stack->tcp_tw_pcbs)) {
-		/* enable and start timer */
-		stack->tcpip_tcp_timer_active = 1;
-		sys_timeout(TCP_TMR_INTERVAL, tcpip_tcp_timer, (void*)stack);
-	}
-}
-#endif /* !NO_SYS */
-#endif /* LWIP_TCP */
-
 /*--------------------------------------------------------------------------*/
 
 static void tcpip_set_down_interfaces(struct stack *stack)
@@ -148,6 +112,8 @@ static void tcpip_set_down_interfaces(struct stack *stack)
 static void 
 init_layers(struct stack *stack)
 {
+	timer_wheel_init(stack);
+
 	netif_init(stack);
 	
 	ip_init(stack);
@@ -175,6 +141,8 @@ shutdown_layers(struct stack *stack)
 	ip_shutdown(stack);
 
 	netif_shutdown(stack);
+
+	timer_wheel_shutdown(stack);
 }
 
 
@@ -213,6 +181,15 @@ tcpip_thread(void *arg)
 
 		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread:  [%d] waiting.\n", stack));
 		
+		msg = NULL;
+#if LWIP_TCP && TCP_GRO
+		/* End of an input batch: deliver the coalesced TCP data
+		 * before waiting for new messages */
+		if (stack->tcp_gro_pcbs != NULL &&
+				sys_arch_mbox_tryfetch(stack->stack_queue, (void *)&msg) == SYS_MBOX_EMPTY)
+			tcp_gro_flush(stack);
+		if (msg == NULL)
+#endif
 		sys_mbox_fetch(stack->stack_queue, (void *)&msg);
 		if (msg==NULL) {
 			printf("tcpip NULL MSG, this should not happen!\n");
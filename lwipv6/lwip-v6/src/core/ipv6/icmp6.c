@@ -200,8 +200,11 @@ icmp_input(struct stack *stack, struct pbuf *p, struct ip_addr_list *inad, struc
 			/* Set ICMP NA fields */
 			ina->type = ICMP6_NA;
 			ina->icode = 0;
-			/* FIX: why R bit set ? */
-			ina->rso_flags = (ICMP6_NA_S | ICMP6_NA_O | ICMP6_NA_R);
+			ina->rso_flags = (ICMP6_NA_S | ICMP6_NA_O);
+#if IPv6_ROUTER_ADVERTISEMENT
+			if (inp->flags & NETIF_FLAG_RADV)
+				ina->rso_flags |= ICMP6_NA_R;
+#endif
 			bzero(ina->reserved, 3);
 
 			/* ina->targetip   Don't touch this field. For solicited 
@@ -242,15 +245,6 @@ icmp_input(struct stack *stack, struct pbuf *p, struct ip_addr_list *inad, struc
 				return;
 			}
 
-			/* The sender is a router? */
-			if (ina->rso_flags & ICMP6_NA_R) {
-				/* TODO: */
-			}
-
-			/* override an existing cache  entry and update the cached link-layer address? */
-			if (ina->rso_flags & ICMP6_NA_O) {
-				/* TODO */
-			}
 
 #if IPv6_AUTO_CONFIGURATION  
 			/* FIX: add MULTISTACK */
@@ -259,8 +253,13 @@ icmp_input(struct stack *stack, struct pbuf *p, struct ip_addr_list *inad, struc
 			ip_autoconf_handle_na(inad->netif, p, iphdr, ina);
 #endif
 
+			/* the neighbor cache handles the router, solicited and
+			   override flags (RFC 4861, 7.2.5) */
 			update_arp_entry(inp, (struct ip_addr *)&ina->targetip, 
-					(struct eth_addr *)&opt->addr, 0); 
+					(struct eth_addr *)&opt->addr, ETHARP_ND_NA |
+					((ina->rso_flags & ICMP6_NA_R) ? ETHARP_ND_ROUTER : 0) |
+					((ina->rso_flags & ICMP6_NA_S) ? ETHARP_ND_SOLICITED : 0) |
+					((ina->rso_flags & ICMP6_NA_O) ? ETHARP_ND_OVERRIDE : 0)); 
 			break;
 
 		/*
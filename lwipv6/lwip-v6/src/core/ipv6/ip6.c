@@ -1122,21 +1122,26 @@ ip_process_exthdr(struct stack *stack, u8_t hdr, char *exthdr, u8_t hpos,
 #if IPv6_FRAGMENTATION 
       {
         struct ip6_fraghdr *fhdr = (struct ip6_fraghdr *) exthdr;
+        /* the fragment may be freed by ip6_reass */
+        u8_t nexthdr = fhdr->nexthdr;
+        u16_t unfragpart_len = exthdr - (char *) (*p)->payload;
         LWIP_DEBUGF(IP_DEBUG, ("Fragment Header\n"));
 
         *p = ip6_reass(stack, *p, fhdr, prevhdr); 
         if (*p == NULL) {
           /* Don't free 'p'. Fragmentation code has "stolen" the packet */
           LWIP_DEBUGF(IP_DEBUG,("\tpacket cached p=%p\n", *p));
+          loop = 0;
+          break;
         } else {
           LWIP_DEBUGF(IP_DEBUG,("\tNew pseudo header p=%p\n", *p));
           ip_build_piphdr(piphdr, *p, piphdr->src, piphdr->dest);
           r = 1;
         }
 
-        /* Go to the next header */
-        hdr    = fhdr->nexthdr;
-        exthdr = exthdr + sizeof(struct ip6_fraghdr);
+        /* Go to the next header: the reassembled packet has no fragment header */
+        hdr    = nexthdr;
+        exthdr = (char *) (*p)->payload + unfragpart_len;
         break;
       }
 #endif
@@ -55,7 +55,6 @@
  * original reassembly code by Adam Dunkels <adam@sics.se>
  * 
  */
-/* TODO  ip_reassembly_pools using memp_alloc */
 
 #include "lwip/opt.h"
 
@@ -65,6 +64,7 @@
 
 #include "lwip/stats.h"
 #include "lwip/sys.h"
+#include "lwip/memp.h"
 #include "lwip/netif.h"
 #include "lwip/ip.h"
 #include "lwip/ip_frag.h"
@@ -81,110 +81,306 @@
 #define  UINT  (unsigned int)
 #endif
 
-/*---------------------------------------------------------------------------*/
-
-/*
- * Copy len bytes from offset in pbuf to buffer 
- *
- * helper used by both ip_reass and ip_frag
- */
-INLINE static struct pbuf *
-copy_from_pbuf(struct pbuf *p, u16_t * offset, u8_t * buffer, u16_t len)
-{
-	u16_t l;
-
-	p->payload = (u8_t *) p->payload + *offset;
-	p->len -= *offset;
-  	while (len) {
-		l = len < p->len ? len : p->len;
-		memcpy(buffer, p->payload, l);
-		buffer += l;
-		len -= l;
-		if (len)
-			p = p->next;
-		else
-			*offset = l;
-	}
-	return p;
-}
-
 /*---------------------------------------------------------------------------*/
 /* Macro and costants */
 /*---------------------------------------------------------------------------*/
 
-static const u8_t bitmap_bits[8] = { 0xff, 0x7f, 0x3f, 0x1f, 0x0f, 0x07, 0x03, 0x01 };
+/* Expire time of a fragmented packet (msecs) */
+#define IP_REASS_MAX_AGE          5000
+
+#define IP_REASS_FLAG_LASTFRAG    0x01
 
+/* Offset of the Next Header field in the IPv6 header */
+#define IP6_NEXTHDR_OFF           6
 
-/* IPv4 reassembly timer timeout */
-#define IP_REASS_TIMER_TIMEOUT  1000
+/* ip_reass_insert return values */
+#define IP_REASS_BAD_DGRAM  -2   /* inconsistent fragment: drop the datagram */
+#define IP_REASS_BAD_FRAG   -1   /* drop the fragment */
+#define IP_REASS_PENDING     0
+#define IP_REASS_COMPLETE    1
 
-/* Expire time of a fragmented packet */
-#define IP4_REASS_MAX_AGE         5
+/* Fragment list link and boundaries of the fragment, stored in the room
+   of the (hidden) header of the fragment, just before its payload */
+#ifdef PACK_STRUCT_USE_INCLUDES
+#  include "arch/bpstruct.h"
+#endif
+PACK_STRUCT_BEGIN
+struct ip_reass_helper {
+	PACK_STRUCT_FIELD(struct pbuf *next);
+	PACK_STRUCT_FIELD(u32_t start);
+	PACK_STRUCT_FIELD(u32_t end);
+} PACK_STRUCT_STRUCT;
+PACK_STRUCT_END
+#ifdef PACK_STRUCT_USE_INCLUDES
+#  include "arch/epstruct.h"
+#endif
 
-#define IP4_REASS_FLAG_USED       0x40
-#define IP4_REASS_FLAG_LASTFRAG   0x01
+#define IP_REASS_HELPER(p) \
+	((struct ip_reass_helper *) ((u8_t *) (p)->payload - sizeof(struct ip_reass_helper)))
 
-#define CLEAR_ENTRY(e) \
-	do { \
-		(e)->ipv = 0; \
-		(e)->id    = 0; \
-		(e)->age = 0; \
-		(e)->flags = 0; \
-		(e)->len = 0; \
-		bzero((e)->bitmap, IP4_REASS_BITMAP_SIZE);  \
-	} while (0)
+/*---------------------------------------------------------------------------*/
+/* Reassembly table */
+/*---------------------------------------------------------------------------*/
 
-#define fill_bitmap(bit, off, len) \
-	do { \
-		int ___i; \
-		bit[(off)/(8*8)] |= bitmap_bits[((off)/8)&7]; \
-		for (___i = 1 + (off)/(8*8); ___i < ((off)+(len))/(8*8); ++___i) \
-			bit[___i] = 0xff; \
-		bit[((off)+(len))/(8*8)] |= ~bitmap_bits[(((off)+(len))/8)&7]; \
-	} while (0); 
+static u32_t
+ip_reass_hashfn(struct ip_addr *src, struct ip_addr *dest, u32_t id)
+{
+	u32_t h = id;
+	int i;
 
+	for (i = 0; i < 4; i++)
+		h ^= src->addr[i] ^ dest->addr[i];
+	h ^= h >> 16;
+	h ^= h >> 8;
+	return h & (IP_REASS_HASH_SIZE - 1);
+}
 
-/* Costants for fragmentation buffers */
-#define MAX_MTU 1500
+static struct ip_reassbuf *
+ip_reass_lookup(struct stack *stack, u8_t ipv, struct ip_addr *src, struct ip_addr *dest, 
+		u32_t id, u8_t proto)
+{
+	struct ip_reassbuf *e;
 
+	for (e = stack->ip_reass_hash[ip_reass_hashfn(src, dest, id)]; e != NULL; e = e->next)
+		if (e->id == id && e->ipv == ipv && e->proto == proto &&
+				ip_addr_cmp(&e->src, src) && ip_addr_cmp(&e->dest, dest))
+			return e;
+	return NULL;
+}
 
-/* Reassembly timer */
-INLINE static void 
-ip_reass_tmr(void *arg)
+static void
+ip_reass_free(struct ip_reassbuf *e)
 {
-	int i;
-	struct stack *stack = (struct stack *) arg;
-
-	struct ip_reassbuf *ip_reassembly_pool = stack->ip_reassembly_pools;
-
-	for (i=0; i < IP_REASS_POOL_SIZE; i++) {
-		/* If this entry is used increment entry age */
-		if (ip_reassembly_pool[i].flags & IP4_REASS_FLAG_USED) {
-		    ip_reassembly_pool[i].age++;
-			/* This entry is too old */
-			if (ip_reassembly_pool[i].age >= IP4_REASS_MAX_AGE) {
-				CLEAR_ENTRY(& ip_reassembly_pool[i] );
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: free entry %d (IPv%d, id=%u)\n", i, ip_reassembly_pool[i].ipv, UINT ip_reassembly_pool[i].id));
-			}
-		}
+	struct stack *stack = e->stack;
+	struct pbuf *q, *next;
+
+	*(e->pprev) = e->next;
+	if (e->next != NULL)
+		e->next->pprev = e->pprev;
+	*(e->lpprev) = e->lnext;
+	if (e->lnext != NULL)
+		e->lnext->lpprev = e->lpprev;
+	else
+		stack->ip_reass_tail = e->lpprev;
+	timer_cancel(stack, &e->tmr);
+
+	for (q = e->frags; q != NULL; q = next) {
+		next = IP_REASS_HELPER(q)->next;
+		pbuf_free(q);
 	}
+	stack->ip_reass_pbufs -= e->nfrags;
+	stack->ip_reass_count--;
+	memp_free(MEMP_REASS, e);
+}
 
-	sys_timeout(IP_REASS_TIMER_TIMEOUT, ip_reass_tmr, arg);
+/* Reassembly timeout */
+static void
+ip_reass_timeout(void *arg)
+{
+	struct ip_reassbuf *e = (struct ip_reassbuf *) arg;
+
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_timeout: free entry (IPv%d, id=%u)\n", e->ipv, UINT e->id));
+	IPFRAG_STATS_INC(ip_frag.drop);
+	ip_reass_free(e);
 }
 
-#if 0
-#define IP_REASS_EXPIRE_TIMEOUT  5000
+static struct ip_reassbuf *
+ip_reass_new(struct stack *stack, u8_t ipv, struct ip_addr *src, struct ip_addr *dest, 
+		u32_t id, u8_t proto)
+{
+	struct ip_reassbuf *e;
+	struct ip_reassbuf **head;
+
+	/* Table full: drop the oldest datagram */
+	while (stack->ip_reass_count >= IP_REASS_POOL_SIZE)
+		ip_reass_free(stack->ip_reass_list);
+	while ((e = memp_malloc(MEMP_REASS)) == NULL) {
+		if (stack->ip_reass_list == NULL) {
+			IPFRAG_STATS_INC(ip_frag.memerr);
+			return NULL;
+		}
+		ip_reass_free(stack->ip_reass_list);
+	}
+
+	e->stack = stack;
+	ip_addr_set(&e->src, src);
+	ip_addr_set(&e->dest, dest);
+	e->id = id;
+	e->ipv = ipv;
+	e->proto = proto;
+	e->flags = 0;
+	e->nhoff = IP6_NEXTHDR_OFF;
+	e->nexthdr = 0;
+	e->nfrags = 0;
+	e->len = 0;
+	e->recvd = 0;
+	e->frags = NULL;
+	e->hlen = 0;
+
+	head = &stack->ip_reass_hash[ip_reass_hashfn(src, dest, id)];
+	e->next = *head;
+	if (e->next != NULL)
+		e->next->pprev = &e->next;
+	e->pprev = head;
+	*head = e;
+
+	e->lnext = NULL;
+	e->lpprev = stack->ip_reass_tail;
+	*(stack->ip_reass_tail) = e;
+	stack->ip_reass_tail = &e->lnext;
+	stack->ip_reass_count++;
+
+	memset(&e->tmr, 0, sizeof(struct timer_entry));
+	timer_set(&e->tmr, ip_reass_timeout, e);
+	timer_arm(stack, &e->tmr, IP_REASS_MAX_AGE);
+
+	return e;
+}
 
-static void ip_reass_expire_tm(void *arg)
+/*
+ * Add a fragment to the datagram. p->payload points to the fragment data,
+ * the header has been hidden by pbuf_header (its room holds the helper).
+ * p is kept by the entry only when the return value is IP_REASS_PENDING
+ * or IP_REASS_COMPLETE.
+ */
+static int
+ip_reass_insert(struct ip_reassbuf *e, struct pbuf *p, u32_t start, u32_t len, u8_t last)
 {
-	struct ip_reassbuf * entry = (struct ip_reassbuf *) arg;
+	struct pbuf *lower;
+	struct pbuf *higher = NULL;
+	struct ip_reass_helper *h;
+	u32_t end = start + len;
+
+	if (len == 0)
+		return IP_REASS_BAD_FRAG;
+	if (last) {
+		if (e->flags & IP_REASS_FLAG_LASTFRAG) {
+			if (end != e->len)
+				return IP_REASS_BAD_DGRAM;
+		} else if (e->frags != NULL && IP_REASS_HELPER(e->frags)->end > end)
+			return IP_REASS_BAD_DGRAM;
+	} else {
+		/* all the fragments but the last one are multiple of 8 bytes */
+		if (len & 7)
+			return IP_REASS_BAD_FRAG;
+		if ((e->flags & IP_REASS_FLAG_LASTFRAG) && end > e->len)
+			return IP_REASS_BAD_DGRAM;
+	}
 
-	CLEAR_ENTRY( entry );
+	/* The list is sorted by decreasing offset: fragments received in order
+	   are inserted in the head */
+	for (lower = e->frags; lower != NULL && IP_REASS_HELPER(lower)->start > start;
+			lower = IP_REASS_HELPER(lower)->next)
+		higher = lower;
+	if (lower != NULL) {
+		h = IP_REASS_HELPER(lower);
+		/* duplicate */
+		if (h->start == start && h->end == end)
+			return IP_REASS_BAD_FRAG;
+		/* overlapping fragments (RFC 5722) */
+		if (h->end > start)
+			return IP_REASS_BAD_DGRAM;
+	}
+	if (higher != NULL && end > IP_REASS_HELPER(higher)->start)
+		return IP_REASS_BAD_DGRAM;
+
+	h = IP_REASS_HELPER(p);
+	h->next = lower;
+	h->start = start;
+	h->end = end;
+	if (higher != NULL)
+		IP_REASS_HELPER(higher)->next = p;
+	else
+		e->frags = p;
+	e->nfrags++;
+	e->stack->ip_reass_pbufs++;
+	e->recvd += len;
+
+	if (last) {
+		e->flags |= IP_REASS_FLAG_LASTFRAG;
+		e->len = end;
+	}
 
-	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: free entry (IPv%d, id=%u)\n", entry->ipv, UINT entry->id));
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_insert: %u:%u recvd %u/%u\n", UINT start, UINT end, UINT e->recvd, UINT e->len));
+	if ((e->flags & IP_REASS_FLAG_LASTFRAG) && e->recvd == e->len && e->hlen > 0)
+		return IP_REASS_COMPLETE;
+	else
+		return IP_REASS_PENDING;
 }
-#endif
 
+/*
+ * Fragments are linked together without copying the data, the header 
+ * saved from the first fragment (already updated by the caller) is 
+ * restored in front of the chain. The entry is freed.
+ */
+static struct pbuf *
+ip_reass_chain(struct ip_reassbuf *e)
+{
+	struct pbuf *p = NULL;
+	struct pbuf *q, *next;
+
+	for (q = e->frags; q != NULL; q = next) {
+		next = IP_REASS_HELPER(q)->next;
+		if (p != NULL)
+			pbuf_cat(q, p);
+		p = q;
+	}
+	e->stack->ip_reass_pbufs -= e->nfrags;
+	e->nfrags = 0;
+	e->frags = NULL;
+
+	/* the room of the header of the first fragment is usually available */
+	if (pbuf_header(p, e->hlen) != 0) {
+		struct pbuf *h = pbuf_alloc(PBUF_RAW, e->hlen, PBUF_RAM);
+		if (h == NULL) {
+			IPFRAG_STATS_INC(ip_frag.memerr);
+			pbuf_free(p);
+			ip_reass_free(e);
+			return NULL;
+		}
+		pbuf_cat(h, p);
+		p = h;
+	}
+	memcpy(p->payload, e->hdr, e->hlen);
+	ip_reass_free(e);
+
+	IPFRAG_STATS_INC(ip_frag.fw);
+	return p;
+}
+
+/* 
+ * Queue the fragment p, its header (hlen bytes) is hidden. 
+ */
+static struct pbuf *
+ip_reass_queue(struct ip_reassbuf *e, struct pbuf *p, u16_t hlen, u32_t start, u32_t len, u8_t last)
+{
+	struct stack *stack = e->stack;
+
+	pbuf_header(p, -(s16_t) hlen);
+	switch (ip_reass_insert(e, p, start, len, last)) {
+		case IP_REASS_COMPLETE:
+			return p;
+		case IP_REASS_PENDING:
+			/* Too many fragments held: drop the oldest datagrams */
+			while (stack->ip_reass_pbufs > IP_REASS_MAX_PBUFS && stack->ip_reass_list != NULL) {
+				struct ip_reassbuf *old = stack->ip_reass_list;
+				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass: too many fragments, drop id=%u\n", UINT old->id));
+				IPFRAG_STATS_INC(ip_frag.drop);
+				ip_reass_free(old);
+				if (old == e)
+					break;
+			}
+			return NULL;
+		case IP_REASS_BAD_DGRAM:
+			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass: inconsistent fragment, drop id=%u\n", UINT e->id));
+			ip_reass_free(e);
+			/* FALLTHROUGH */
+		default:
+			IPFRAG_STATS_INC(ip_frag.drop);
+			pbuf_free(p);
+			return NULL;
+	}
+}
 
 /*---------------------------------------------------------------------------*/
 /* Module functions */
@@ -194,8 +390,11 @@ static void ip_reass_expire_tm(void *arg)
 void 
 ip_frag_reass_init(struct stack *stack)
 {
-	/* FIX: rough init, change it? */
-	bzero(stack->ip_reassembly_pools, IP_REASS_POOL_SIZE * sizeof(struct ip_reassbuf));
+	bzero(stack->ip_reass_hash, IP_REASS_HASH_SIZE * sizeof(struct ip_reassbuf *));
+	stack->ip_reass_list = NULL;
+	stack->ip_reass_tail = &stack->ip_reass_list;
+	stack->ip_reass_count = 0;
+	stack->ip_reass_pbufs = 0;
 
 #if IPv4_FRAGMENTATION
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: IPv4 fragmentation enabled.\n", __func__));
@@ -203,16 +402,50 @@ ip_frag_reass_init(struct stack *stack)
 #if IPv6_FRAGMENTATION
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: IPv6 fragmentation enabled.\n", __func__));
 #endif
-
-	sys_timeout(IP_REASS_TIMER_TIMEOUT, (sys_timeout_handler) ip_reass_tmr, (void*)stack);
 }
 
 void 
 ip_frag_reass_shutdown(struct stack *stack)
 {
-  /* FIX: TODO */
-    
-  sys_untimeout((sys_timeout_handler) ip_reass_tmr, (void*)stack);
+	while (stack->ip_reass_list != NULL)
+		ip_reass_free(stack->ip_reass_list);
+}
+
+/*
+ * Build a fragment: a copy of the header followed by PBUF_REF pbufs 
+ * referring to the next len bytes of the packet (the payload is not copied).
+ * *pq, *poff: current position in the packet, updated.
+ */
+static struct pbuf *
+ip_frag_build(struct pbuf **pq, u16_t *poff, void *hdr, u16_t hlen, u16_t len)
+{
+	struct pbuf *h, *r;
+
+	if ((h = pbuf_alloc(PBUF_LINK, hlen, PBUF_RAM)) == NULL)
+		return NULL;
+	memcpy(h->payload, hdr, hlen);
+	while (len > 0) {
+		struct pbuf *q = *pq;
+		u16_t n;
+
+		if (*poff >= q->len) {
+			*pq = q->next;
+			*poff = 0;
+			continue;
+		}
+		n = q->len - *poff;
+		if (n > len)
+			n = len;
+		if ((r = pbuf_alloc(PBUF_RAW, n, PBUF_REF)) == NULL) {
+			pbuf_free(h);
+			return NULL;
+		}
+		r->payload = (u8_t *) q->payload + *poff;
+		pbuf_cat(h, r);
+		*poff += n;
+		len -= n;
+	}
+	return h;
 }
 
 
@@ -224,180 +457,67 @@ ip_frag_reass_shutdown(struct stack *stack)
 
 struct pbuf *ip4_reass(struct stack *stack, struct pbuf *p)
 {
-	struct pbuf *q;
 	struct ip4_hdr *fragment_hdr, *entry_iphdr;
-	u32_t offset, len;
-	u16_t i;
-	u16_t pos;
-
-	struct ip_reassbuf *ip_reassembly_pool = stack->ip_reassembly_pools;
+	struct ip_reassbuf *e;
+	struct ip_addr src, dest;
+	u16_t hlen, offset;
+	u32_t start, len;
 
 	IPFRAG_STATS_INC(ip_frag.recv);
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: start\n"));
 
 	fragment_hdr = (struct ip4_hdr *) p->payload;
-
-	/* Search in the pool for matching fragments */
-	for (pos=0; pos < IP_REASS_POOL_SIZE; pos++) {
-		/* Lookup for IPv4 entries, If this entry is used check it */
-		if (ip_reassembly_pool[pos].ipv == 4)
-		if (ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_USED) {
-		    entry_iphdr   = (struct ip4_hdr *) ip_reassembly_pool[pos].buf;
-			/* cached fragment matches receivd fragment? */
-			if (ip_reassembly_pool[pos].id == IPH4_ID(fragment_hdr) &&
-				ip4_addr_cmp(&entry_iphdr->src, &fragment_hdr->src) && 
-				ip4_addr_cmp(&entry_iphdr->dest, &fragment_hdr->dest)
-				) 
-				break;
-		}
+	hlen   = IPH4_HL(fragment_hdr) * 4;
+	offset = ntohs(IPH4_OFFSET(fragment_hdr));
+	start  = (offset & IP_OFFMASK) * 8;
+	len    = ntohs(IPH4_LEN(fragment_hdr));
+
+	if (hlen < IP4_HLEN || p->len < hlen || len <= hlen || p->tot_len < len) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: bad fragment\n"));
+		goto nullreturn;
 	}
-
-	/* No match found. Try Create new one. */
-	if (pos >= IP_REASS_POOL_SIZE) {
-		/* Search empty entry for this new fragment */
-		for (pos=0; pos < IP_REASS_POOL_SIZE; pos++) 
-			/* This entry is empty. Let's use it */
-			if (ip_reassembly_pool[pos].ipv == 0)
-			if (!(ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_USED)) {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: new packet (pos=%d)\n", pos));
-
-				/* Reset entry data */
-				ip_reassembly_pool[pos].flags = IP4_REASS_FLAG_USED;
-
-				ip_reassembly_pool[pos].age   = 0;
-#if 0
-				sys_timeout(IP_REASS_EXPIRE_TIMEOUT, ip_reass_expire_tm, &ip_reassembly_pool[pos]);
-#endif
-
-				ip_reassembly_pool[pos].ipv   = 4;
-				ip_reassembly_pool[pos].id    = IPH4_ID(fragment_hdr);
-				ip_reassembly_pool[pos].len   = IP4_HLEN;
-
-				/* Clean bitmap */
-				bzero(ip_reassembly_pool[pos].bitmap, IP4_REASS_BITMAP_SIZE);
-
-				/* Save fragment in the entry */
-				entry_iphdr   = (struct ip4_hdr *) ip_reassembly_pool[pos].buf;
-				memcpy(entry_iphdr, fragment_hdr, IP4_HLEN);
-
-				/* update bitmap */
-				fill_bitmap(ip_reassembly_pool[pos].bitmap, 0, IP4_HLEN); 
-				break;
-			}
+	len -= hlen;
+	/* If the fragment overflows the max datagram len, we discard it. */
+	if (hlen + start + len > IP_REASS_BUFSIZE) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: fragment outside of buffer (%d:%d/%d).\n", UINT start, UINT (start + len), UINT IP_REASS_BUFSIZE));
+		goto nullreturn;
 	}
 
-	/* Entry found */
-	if (pos < IP_REASS_POOL_SIZE) {
-
-		entry_iphdr   = (struct ip4_hdr *) ip_reassembly_pool[pos].buf;
-
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: matching old packet (pos=%d)\n", pos));
-		IPFRAG_STATS_INC(ip_frag.cachehit);
-
-		/* Find out the offset in the reassembly buffer where we should
-		   copy the fragment. */
-		len    = ntohs(IPH4_LEN(fragment_hdr)) - IPH4_HL(fragment_hdr) * 4;
-		offset = IP4_HLEN + (ntohs(IPH4_OFFSET(fragment_hdr)) & IP_OFFMASK) * 8;
-
-		/* If the offset or the offset + fragment length overflows the
-		   reassembly buffer, we discard the entire packet. */
-		if (offset > IP_REASS_BUFSIZE || offset + len > IP_REASS_BUFSIZE) {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: fragment outside of buffer (%d:%d/%d).\n", UINT offset, UINT (offset + len), UINT IP_REASS_BUFSIZE));
-			/* Make this entry empty */
-			CLEAR_ENTRY( & ip_reassembly_pool[pos] );
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: remove entry %d.\n", pos));
+	IP64_CONV(&src, &fragment_hdr->src);
+	IP64_CONV(&dest, &fragment_hdr->dest);
+	e = ip_reass_lookup(stack, 4, &src, &dest, IPH4_ID(fragment_hdr), IPH4_PROTO(fragment_hdr));
+	if (e == NULL) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: new packet\n"));
+		if ((e = ip_reass_new(stack, 4, &src, &dest, IPH4_ID(fragment_hdr), IPH4_PROTO(fragment_hdr))) == NULL)
 			goto nullreturn;
-		}
-
-		/* Copy the fragment into the reassembly buffer, at the right offset. */
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: copying with offset %d into %d:%d\n", UINT offset, UINT (IP4_HLEN + offset), UINT (IP4_HLEN + offset + len)));
-		i = IPH4_HL(fragment_hdr) * 4;
-
-		copy_from_pbuf(p, &i, &ip_reassembly_pool[pos].buf[offset], len);
-
-		/* Update the bitmap. */
-		if (offset / (8 * 8) == (offset + len) / (8 * 8)) {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: updating single byte in bitmap.\n"));
-			/* If the two endpoints are in the same byte, we only update that byte. */
-			ip_reassembly_pool[pos].bitmap[offset / (8 * 8)] |= bitmap_bits[(offset / 8) & 7] & ~bitmap_bits[((offset + len) / 8) & 7];
-		}
-		else {
-			/* If the two endpoints are in different bytes, we update the
-			   bytes in the endpoints and fill the stuff inbetween with
-			   0xff. */
-			fill_bitmap(ip_reassembly_pool[pos].bitmap, offset, len);
-		}
-
-		/* If this fragment has the More Fragments flag set to zero, we
-		   know that this is the last fragment, so we can calculate the
-		   size of the entire packet. We also set the
-		   IP_REASS_FLAG_LASTFRAG flag to indicate that we have received
-		   the final fragment. */
-		if ((ntohs(IPH4_OFFSET(fragment_hdr)) & IP_MF) == 0) {
-			ip_reassembly_pool[pos].flags |= IP4_REASS_FLAG_LASTFRAG;
-			ip_reassembly_pool[pos].len    = offset + len;
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: last fragment seen, total len %d\n", UINT ip_reassembly_pool[pos].len));
-		}
-
-		/* Finally, we check if we have a full packet in the buffer. We do
-		   this by checking if we have the last fragment and if all bits
-		   in the bitmap are set. */
-		if (ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_LASTFRAG) {
-
-			/* Check all bytes up to and including all but the last byte in the bitmap. */
-			for (i = 0; i < ip_reassembly_pool[pos].len / (8 * 8) - 1; ++i) {
-				if (ip_reassembly_pool[pos].bitmap[i] != 0xff) {
-					LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: last fragment seen, bitmap %d/%d failed (%x)\n", i, UINT ip_reassembly_pool[pos].len / (8 * 8) - 1, UINT ip_reassembly_pool[pos].bitmap[i]));
-					goto nullreturn;
-				}
-			}
-
-			/* Check the last byte in the bitmap. It should contain just the
-			   right amount of bits. */
-			if (ip_reassembly_pool[pos].bitmap[ip_reassembly_pool[pos].len / (8 * 8)] != (u8_t) ~ bitmap_bits[ip_reassembly_pool[pos].len / 8 & 7]) {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: last fragment seen, bitmap %d didn't contain %x (%x)\n", UINT ip_reassembly_pool[pos].len / (8 * 8), UINT ~bitmap_bits[ip_reassembly_pool[pos].len / 8 & 7], UINT ip_reassembly_pool[pos].bitmap[ip_reassembly_pool[pos].len / (8 * 8)]));
-				goto nullreturn;
-			}
-
-			/* Pretend to be a "normal" (i.e., not fragmented) IP packet from now on. */
-			IPH4_LEN_SET(entry_iphdr, htons(ip_reassembly_pool[pos].len));
-			IPH4_OFFSET_SET(entry_iphdr, 0);
-			IPH4_CHKSUM_SET(entry_iphdr, 0);
-			IPH4_CHKSUM_SET(entry_iphdr, inet_chksum(entry_iphdr, IP4_HLEN));
-
-			/* If we have come this far, we have a full packet in the
-			   buffer, so we allocate a pbuf and copy the packet into it. We
-			   also reset the timer. */
-
-			pbuf_free(p);
-
-			p = pbuf_alloc(PBUF_LINK, ip_reassembly_pool[pos].len, PBUF_POOL);
-			if (p != NULL) {
-				i = 0;
-				for (q = p; q != NULL; q = q->next) {
-					/* Copy enough bytes to fill this pbuf in the chain. The
-					   available data in the pbuf is given by the q->len
-					   variable. */
-					LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: memcpy from %p (%d) to %p, %ld bytes\n", 
-						(void *) &ip_reassembly_pool[pos].buf[i], i, 
-						q->payload, q->len > (ip_reassembly_pool[pos].len - i) ? ip_reassembly_pool[pos].len - i : q->len));
-
-					memcpy(q->payload, &ip_reassembly_pool[pos].buf[i], q->len > ip_reassembly_pool[pos].len - i ? ip_reassembly_pool[pos].len - i : q->len);
-					i += q->len;
-				}
-				IPFRAG_STATS_INC(ip_frag.fw);
-			}
-			else {
-				IPFRAG_STATS_INC(ip_frag.memerr);
-			}
-
-			CLEAR_ENTRY( & ip_reassembly_pool[pos] );
+	} else {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: matching old packet\n"));
+		IPFRAG_STATS_INC(ip_frag.cachehit);
+	}
 
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass: p %p\n", (void *) p));
-			return p;
-		}
+	/* The header of the reassembled datagram is the one of the first fragment */
+	if (start == 0) {
+		memcpy(e->hdr, fragment_hdr, hlen);
+		e->hlen = hlen;
 	}
 
+	/* drop the link level padding */
+	pbuf_realloc(p, hlen + len);
+	if ((p = ip_reass_queue(e, p, hlen, start, len, (offset & IP_MF) == 0)) == NULL)
+		return NULL;
+
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: complete, total len %d\n", UINT (e->hlen + e->len)));
+	/* Pretend to be a "normal" (i.e., not fragmented) IP packet from now on. */
+	entry_iphdr = (struct ip4_hdr *) e->hdr;
+	IPH4_LEN_SET(entry_iphdr, htons(e->hlen + e->len));
+	IPH4_OFFSET_SET(entry_iphdr, 0);
+	IPH4_CHKSUM_SET(entry_iphdr, 0);
+	IPH4_CHKSUM_SET(entry_iphdr, inet_chksum(entry_iphdr, e->hlen));
+
+	p = ip_reass_chain(e);
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass: p %p\n", (void *) p));
+	return p;
+
 nullreturn:
 	IPFRAG_STATS_INC(ip_frag.drop);
 	pbuf_free(p);
@@ -409,85 +529,68 @@ nullreturn:
 /**
  * Fragment an IP packet if too large
  *
- * Chop the packet in mtu sized chunks and send them in order
- * by using a fixed size static memory buffer (PBUF_ROM)
+ * Chop the packet in mtu sized chunks and send them in order.
+ * Each fragment is a copy of the header followed by references
+ * to the payload of the original packet (PBUF_REF).
  */
 err_t 
 ip4_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_addr *dest)
 {
-	u8_t buf[MAX_MTU];
-
-	struct pbuf *rambuf;
-	struct pbuf *header;
-	struct ip4_hdr *iphdr;
-	u16_t nfb = 0;
+	struct pbuf *frag;
+	struct ip4_hdr *iphdr, *fraghdr;
+	u16_t hlen;
 	u16_t left, cop;
-	u16_t mtu;
+	u16_t maxlen;
 	u16_t ofo, omf;
 	u16_t last;
-	u16_t poff = IP4_HLEN;
+	u16_t poff;
 	u16_t tmp;
 
-	mtu = netif->mtu;
-
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: start\n", __func__));
 
-	/* Get a RAM based MTU sized pbuf */
-	rambuf = pbuf_alloc(PBUF_LINK, 0, PBUF_REF);
-	rambuf->tot_len = rambuf->len = mtu;
-	rambuf->payload = MEM_ALIGN((void *) buf);
-
-	/* Copy the IP header in it */
-	iphdr = rambuf->payload;
-	memcpy(iphdr, p->payload, IP4_HLEN);
+	iphdr = (struct ip4_hdr *) p->payload;
+	hlen = IPH4_HL(iphdr) * 4;
+	/* all the fragments but the last one are multiple of 8 bytes */
+	maxlen = ((netif->mtu - hlen) / 8) * 8;
 
 	/* Save original offset */
 	tmp = ntohs(IPH4_OFFSET(iphdr));
 	ofo = tmp & IP_OFFMASK;
 	omf = tmp & IP_MF;
 
-	left = p->tot_len - IP4_HLEN;
+	poff = hlen;
+	left = p->tot_len - hlen;
 
 	while (left) {
-		last = (left <= mtu - IP4_HLEN);
+		last = (left <= maxlen);
+		cop = last ? left : maxlen;
+
+		if ((frag = ip_frag_build(&p, &poff, iphdr, hlen, cop)) == NULL) {
+			IPFRAG_STATS_INC(ip_frag.memerr);
+			return ERR_MEM;
+		}
+		fraghdr = (struct ip4_hdr *) frag->payload;
 
 		/* Set new offset and MF flag */
-		ofo += nfb;
 		tmp = omf | (IP_OFFMASK & (ofo));
 		if (!last)
 			tmp = tmp | IP_MF;
-		IPH4_OFFSET_SET(iphdr, htons(tmp));
-
-		/* Fill this fragment */
-		nfb = (mtu - IP4_HLEN) / 8;
-		cop = last ? left : nfb * 8;
-
-		p = copy_from_pbuf(p, &poff, (u8_t *) iphdr + IP4_HLEN, cop);
+		IPH4_OFFSET_SET(fraghdr, htons(tmp));
 
 		/* Correct header */
-		IPH4_LEN_SET(iphdr, htons(cop + IP4_HLEN));
-		IPH4_CHKSUM_SET(iphdr, 0);
-		IPH4_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP4_HLEN));
-
-		if (last)
-			pbuf_realloc(rambuf, left + IP4_HLEN);
-		/* This part is ugly: we alloc a RAM based pbuf for 
-		 * the link level header for each chunk and then 
-		 * free it.A PBUF_ROM style pbuf for which pbuf_header
-		 * worked would make things simpler.
-		 */
-		header = pbuf_alloc(PBUF_LINK, 0, PBUF_RAM);
-		pbuf_chain(header, rambuf);
+		IPH4_LEN_SET(fraghdr, htons(cop + hlen));
+		IPH4_CHKSUM_SET(fraghdr, 0);
+		IPH4_CHKSUM_SET(fraghdr, inet_chksum(fraghdr, hlen));
 
 		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: netif->output\n", __func__));
-		netif->output(netif, header, dest);
+		netif->output(netif, frag, dest);
 		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: netif->output finish\n", __func__));
 
 		IPFRAG_STATS_INC(ip_frag.xmit);
-		pbuf_free(header);
+		pbuf_free(frag);
 		left -= cop;
+		ofo += cop / 8;
 	}
-	pbuf_free(rambuf);
 	return ERR_OK;
 }
 
@@ -503,17 +606,14 @@ ip4_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_add
 struct pbuf *
 ip6_reass(struct stack *stack, struct pbuf *p, struct ip6_fraghdr *fragext, struct ip_exthdr *lastext)
 {
-	struct pbuf *q;
 	struct ip_hdr      *entry_iphdr;
 	struct ip_hdr      *fragment_hdr;
-	u32_t offset, len;
-	u16_t i;
-	u16_t pos;
+	struct ip_reassbuf *e;
+	struct ip_addr src, dest;
+	u32_t start, len;
+	u16_t hlen;
 
 	u16_t unfragpart_len; /* length of unfragmentable part */
-	
-	struct ip_reassbuf *ip_reassembly_pool = stack->ip_reassembly_pools;
-	
 
 	IPFRAG_STATS_INC(ip_frag.recv);
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: start\n"));
@@ -523,181 +623,63 @@ ip6_reass(struct stack *stack, struct pbuf *p, struct ip6_fraghdr *fragext, stru
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("M     : %d\n", UINT IP6_M(fragext)       ));
 
 	fragment_hdr = (struct ip_hdr *) p->payload;
-
-	/* Search in the pool for matching fragments */
-	for (pos=0; pos < IP_REASS_POOL_SIZE; pos++) {
-		/* If this entry is used */
-		if (ip_reassembly_pool[pos].ipv == 6)
-		if (ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_USED) {
-
-		    entry_iphdr   = (struct ip_hdr *) ip_reassembly_pool[pos].buf;
-
-			/* cached fragment matches receivd fragment? */
-			if (ip_reassembly_pool[pos].id == IP6_ID(fragext) &&
-				ip_addr_cmp(&entry_iphdr->src , &fragment_hdr->src ) && 
-				ip_addr_cmp(&entry_iphdr->dest, &fragment_hdr->dest)
-				) 
-				break;
-		}
+	unfragpart_len = ((u8_t *) fragext) - ((u8_t *) fragment_hdr);
+	hlen = unfragpart_len + sizeof(struct ip6_fraghdr);
+	start = IP6_OFFSET(fragext);
+	/* Payload Length of the IPv6 header contains the length of this fragment 
+	   packet only (excluding the length of the IPv6 header itself) */
+	len = ntohs(IPH_PAYLOADLEN(fragment_hdr)) + IP_HLEN;
+
+	if (unfragpart_len > IP_REASS_HDRSIZE || p->len < hlen || len <= hlen || p->tot_len < len) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: bad fragment\n"));
+		goto nullreturn;
 	}
-
-	/* No match found. Try Create new one. */
-	if (pos >= IP_REASS_POOL_SIZE) {
-		/* Search empty entry for this new fragment */
-		for (pos=0; pos < IP_REASS_POOL_SIZE; pos++) 
-			if (ip_reassembly_pool[pos].ipv == 0)
-			/* This entry is empty. Let's use it */
-			if (!(ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_USED)) {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: new packet (pos=%d)\n", pos));
-
-				/* Reset entry data */
-				ip_reassembly_pool[pos].ipv    = 6;
-				ip_reassembly_pool[pos].id     = IP6_ID(fragext);
-				ip_reassembly_pool[pos].age    = 0;
-				ip_reassembly_pool[pos].flags  = IP4_REASS_FLAG_USED;
-
-				ip_reassembly_pool[pos].len    = unfragpart_len;
-
-				/* Clean bitmap */
-				bzero(ip_reassembly_pool[pos].bitmap, IP4_REASS_BITMAP_SIZE);
-
-				/* Save fragment in the entry */
-				entry_iphdr   = (struct ip_hdr *) ip_reassembly_pool[pos].buf;
-
-				/* Copy the whole  Unfragmentable Part */
-				unfragpart_len = ((long)fragext) - ((long)fragment_hdr);
-				memcpy(entry_iphdr, fragment_hdr, unfragpart_len);
-
-
-				fill_bitmap(ip_reassembly_pool[pos].bitmap, 0, unfragpart_len); 
-				break;
-			}
+	len -= hlen;
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: Len = %d.\n", UINT len));
+	/* If the fragment overflows the max payload len, we discard it. */
+	if (unfragpart_len - IP_HLEN + start + len > IP_REASS_BUFSIZE) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: fragment outside of buffer (%d:%d/%d).\n", UINT start, UINT (start + len), UINT IP_REASS_BUFSIZE));
+		goto nullreturn;
 	}
 
-	/* Entry found */
-	if (pos < IP_REASS_POOL_SIZE) {
-
-		unfragpart_len = ((long)fragext) - ((long)fragment_hdr);
-
-		entry_iphdr   = (struct ip_hdr *) ip_reassembly_pool[pos].buf;
-
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: matching old packet (pos=%d)\n", pos));
-		IPFRAG_STATS_INC(ip_frag.cachehit);
-
-		/* Find out the offset in the reassembly buffer where we should
-		   copy the fragment. */
-		/* Payload Length of the IPv6 header contains the length of this fragment 
-           packet only (excluding the length of the IPv6 header itself) */
-		len    = ntohs(IPH_PAYLOADLEN(fragment_hdr)) + IP_HLEN - unfragpart_len - sizeof(struct ip6_fraghdr);  
-		offset = unfragpart_len + IP6_OFFSET(fragext);
-
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: Len = %d.\n", UINT len));
-
-		/* If the offset or the offset + fragment length overflows the
-		   reassembly buffer, we discard the entire packet. */
-		if (offset > IP_REASS_BUFSIZE || offset + len > IP_REASS_BUFSIZE) {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: fragment outside of buffer (%d:%d/%d).\n", UINT offset, UINT (offset + len), UINT IP_REASS_BUFSIZE));
-			/* Make this entry empty */
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: remove entry %d.\n", pos));
-			CLEAR_ENTRY( & ip_reassembly_pool[pos] );
+	ip_addr_set(&src, &fragment_hdr->src);
+	ip_addr_set(&dest, &fragment_hdr->dest);
+	e = ip_reass_lookup(stack, 6, &src, &dest, IP6_ID(fragext), 0);
+	if (e == NULL) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: new packet\n"));
+		if ((e = ip_reass_new(stack, 6, &src, &dest, IP6_ID(fragext), 0)) == NULL)
 			goto nullreturn;
-		}
-
-		/* Copy the fragment into the reassembly buffer, at the right offset. */
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: copying with offset %d into %d:%d\n",UINT offset,  UINT (unfragpart_len + offset),  UINT (unfragpart_len + offset + len)));
-		i = unfragpart_len + sizeof(struct ip6_fraghdr);
-		copy_from_pbuf(p, &i, &ip_reassembly_pool[pos].buf[offset], len);
-
-		/* Update the bitmap. */
-		if (offset / (8 * 8) == (offset + len) / (8 * 8)) {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: updating single byte in bitmap.\n"));
-			/* If the two endpoints are in the same byte, we only update that byte. */
-			ip_reassembly_pool[pos].bitmap[offset / (8 * 8)] |= bitmap_bits[(offset / 8) & 7] & ~bitmap_bits[((offset + len) / 8) & 7];
-		}
-		else {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: updating many bytes in bitmap (%ld:%ld).\n", 1 + offset / (8 * 8), (offset + len) / (8 * 8)));
-			/* If the two endpoints are in different bytes, we update the
-			   bytes in the endpoints and fill the stuff inbetween with
-			   0xff. */
-			fill_bitmap(ip_reassembly_pool[pos].bitmap, offset, len);
-		}
-
-		/* If this fragment has the More Fragments flag set to zero, we
-		   know that this is the last fragment, so we can calculate the
-		   size of the entire packet. We also set the
-		   IP_REASS_FLAG_LASTFRAG flag to indicate that we have received
-		   the final fragment. */
-		if (IP6_M(fragext) == 0) {
-			ip_reassembly_pool[pos].flags |= IP4_REASS_FLAG_LASTFRAG;
-			ip_reassembly_pool[pos].len    = offset + len;
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: last fragment seen, total len %d\n", UINT ip_reassembly_pool[pos].len));
-		}
-		else {
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: NOT last fragment.\n"));
-		}
-
-		/* Finally, we check if we have a full packet in the buffer. We do
-		   this by checking if we have the last fragment and if all bits
-		   in the bitmap are set. */
-		if (ip_reassembly_pool[pos].flags & IP4_REASS_FLAG_LASTFRAG) {
-
-			/* Check all bytes up to and including all but the last byte in the bitmap. */
-			for (i = 0; i < ip_reassembly_pool[pos].len / (8 * 8) - 1; ++i) {
-				if (ip_reassembly_pool[pos].bitmap[i] != 0xff) {
-					LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: last fragment seen, bitmap %d/%ld failed (%x)\n", i, ip_reassembly_pool[pos].len / (8 * 8) - 1, ip_reassembly_pool[pos].bitmap[i]));
-					goto nullreturn;
-				}
-			}
-
-			/* Check the last byte in the bitmap. It should contain just the
-			   right amount of bits. */
-			if (ip_reassembly_pool[pos].bitmap[ip_reassembly_pool[pos].len / (8 * 8)] != (u8_t) ~ bitmap_bits[ip_reassembly_pool[pos].len / 8 & 7]) {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: last fragment seen, bitmap %ld didn't contain %x (%x)\n", ip_reassembly_pool[pos].len / (8 * 8), ~bitmap_bits[ip_reassembly_pool[pos].len / 8 & 7], ip_reassembly_pool[pos].bitmap[ip_reassembly_pool[pos].len / (8 * 8)]));
-				goto nullreturn;
-			}
+	} else {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: matching old packet\n"));
+		IPFRAG_STATS_INC(ip_frag.cachehit);
+	}
 
-			/* Pretend to be a "normal" (i.e., not fragmented) IP packet from now on. */
-			IPH_PAYLOADLEN_SET(entry_iphdr, ip_reassembly_pool[pos].len);
-
-			//lastext = ip_last_exthdr_before_fraghdr(p);
-			if (lastext != NULL) {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: memcpy from %p (%d) to %p, %ld bytes\n", (void *) &ip_reassembly_pool[pos].buf[i], i, q->payload, q->len > ip_reassembly_pool[pos].len - i ? ip_reassembly_pool[pos].len - i : q->len));
-				/* FIX FIX FIX */
-			} 
-			else {
-				LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: no extension headers before fragment\n"));
-            	/* No extension header. Modify NextHdr field in IPv6 Header */
-				IPH_NEXTHDR_SET(entry_iphdr, fragext->nexthdr);
-			}
+	/* The Unfragmentable Part and the Next Header of the reassembled 
+	   packet are taken from the first fragment */
+	if (start == 0) {
+		memcpy(e->hdr, fragment_hdr, unfragpart_len);
+		e->hlen = unfragpart_len;
+		e->nexthdr = IP6_NEXTHDR(fragext);
+		/* the Next Header to patch is in the last extension header before
+		   the fragment header, if any */
+		e->nhoff = (lastext != NULL) ? ((u8_t *) lastext) - ((u8_t *) fragment_hdr) : IP6_NEXTHDR_OFF;
+	}
 
-			/* If we have come this far, we have a full packet in the
-			   buffer, so we allocate a pbuf and copy the packet into it. We
-			   also reset the timer. */
-			pbuf_free(p);
+	/* drop the link level padding */
+	pbuf_realloc(p, hlen + len);
+	if ((p = ip_reass_queue(e, p, hlen, start, len, IP6_M(fragext) == 0)) == NULL)
+		return NULL;
 
-			p = pbuf_alloc(PBUF_LINK, ip_reassembly_pool[pos].len, PBUF_POOL);
-			if (p != NULL) {
-				i = 0;
-				for (q = p; q != NULL; q = q->next) {
-					/* Copy enough bytes to fill this pbuf in the chain. The
-					   available data in the pbuf is given by the q->len
-					   variable. */
-					LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: memcpy from %p (%d) to %p, %ld bytes\n", (void *) &ip_reassembly_pool[pos].buf[i], i, q->payload, q->len > ip_reassembly_pool[pos].len - i ? ip_reassembly_pool[pos].len - i : q->len));
-					memcpy(q->payload, &ip_reassembly_pool[pos].buf[i], q->len > ip_reassembly_pool[pos].len - i ? ip_reassembly_pool[pos].len - i : q->len);
-					i += q->len;
-				}
-				IPFRAG_STATS_INC(ip_frag.fw);
-			}
-			else {
-				IPFRAG_STATS_INC(ip_frag.memerr);
-			}
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: complete, total len %d\n", UINT (e->hlen + e->len)));
+	/* Pretend to be a "normal" (i.e., not fragmented) IP packet from now on. */
+	entry_iphdr = (struct ip_hdr *) e->hdr;
+	e->hdr[e->nhoff] = e->nexthdr;
+	IPH_PAYLOADLEN_SET(entry_iphdr, e->hlen - IP_HLEN + e->len);
 
-			CLEAR_ENTRY( & ip_reassembly_pool[pos] );
+	p = ip_reass_chain(e);
+	LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: p %p\n", (void *) p));
+	return p;
 
-			LWIP_DEBUGF(IP_REASS_DEBUG, ("ip6_reass: p %p\n", (void *) p));
-			return p;
-		}
-	}
 nullreturn:
 	IPFRAG_STATS_INC(ip_frag.drop);
 	pbuf_free(p);
@@ -709,16 +691,17 @@ nullreturn:
 /**
  * Fragment an IP packet if too large
  *
- * Chop the packet in mtu sized chunks and send them in order
- * by using a fixed size static memory buffer (PBUF_ROM)
+ * Chop the packet in mtu sized chunks and send them in order.
+ * Each fragment is a copy of the Unfragmentable part and of the 
+ * Fragment header followed by references to the payload of the 
+ * original packet (PBUF_REF).
  */
 err_t 
 ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_addr *dest)
 {
-	u8_t buf6[MAX_MTU];
+	u8_t hdr[IP_REASS_HDRSIZE + IP_EXTFRAG_LEN];
 
-	struct pbuf *rambuf;
-	struct pbuf *linkheader;
+	struct pbuf *frag;
 
 	struct ip_hdr       *iphdr;
 	struct ip6_fraghdr  *fraghdr;
@@ -728,7 +711,7 @@ ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_add
 	u16_t left;
 	u16_t frag_maxlen; /* Len of fragment payload to create */
 	u16_t offset;      /* offset of current frag */
-	u16_t poffset;     /* used for copy_from_pbuf() */
+	u16_t poffset;     /* position in the original packet */
 	u16_t offset_m;    /* offset + M bit field value */
 	u16_t ncopy;
 
@@ -755,28 +738,26 @@ ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_add
 	exthdr = NULL;
 	destext_num = 0; /* Destination header can occour two times. We include the first */
 	do {
-		last_exthdr = exthdr;
-		exthdr = (struct ip_exthdr *)  ((char*)p->payload + unfragpart_len);
-
-		if (nexthdr == IP6_NEXTHDR_HOP) {
-			nexthdr = exthdr->nexthdr;
-		}
-		else if (nexthdr == IP6_NEXTHDR_DEST && destext_num < 1) {
-			nexthdr = exthdr->nexthdr;
-
+		if (nexthdr == IP6_NEXTHDR_DEST && destext_num >= 1)
+			break;
+		if (nexthdr != IP6_NEXTHDR_HOP && nexthdr != IP6_NEXTHDR_DEST && nexthdr != IP6_NEXTHDR_ROUTING)
+			break;
+		if (nexthdr == IP6_NEXTHDR_DEST)
 			destext_num++;
-		}
-		else if (nexthdr == IP6_NEXTHDR_ROUTING) {        
-			nexthdr = exthdr->nexthdr;
-		}
-		else {
-        	break;
-		}
-	} while (1);
+		exthdr = (struct ip_exthdr *)  ((char*)p->payload + unfragpart_len);
+		nexthdr = exthdr->nexthdr;
+		unfragpart_len += (exthdr->len + 1) * 8;
+	} while (unfragpart_len <= IP_REASS_HDRSIZE);
+	last_exthdr = exthdr;
 
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: next header = %d\n", __func__, nexthdr));
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: unfrag part len = %d\n", __func__, unfragpart_len));
 
+	if (unfragpart_len > IP_REASS_HDRSIZE || unfragpart_len > p->len) {
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: unfragmentable part too long\n", __func__));
+		return ERR_VAL;
+	}
+
 	/* The Fragmentable Part of the original packet is divided into
 	 * fragments, each, except possibly the last ("rightmost") one, 
 	 * being an integer multiple of 8 octets long. 
@@ -785,24 +766,19 @@ ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_add
 
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: frag maxlen = %d\n", __func__, frag_maxlen));
 
-	/* Get a RAM based sized pbuf for Unfragmentable part + Frag hdr*/
-	rambuf = pbuf_alloc(PBUF_LINK, 0, PBUF_REF);
-	rambuf->tot_len = rambuf->len = unfragpart_len + IP_EXTFRAG_LEN + frag_maxlen;
-	rambuf->payload = MEM_ALIGN((void *) buf6);
-
 	/* Copy Unfragmentable part (IP hdr + Ext hdrs) */
-	iphdr = rambuf->payload;
-	memcpy(iphdr, p->payload, unfragpart_len);
+	memcpy(hdr, p->payload, unfragpart_len);
 
 	/* Set NextHeader field in the IP header or the last Extension header */
 	if (last_exthdr == NULL)
-		IPH_NEXTHDR_SET(iphdr, IP6_NEXTHDR_FRAGMENT);
+		IPH_NEXTHDR_SET((struct ip_hdr *) hdr, IP6_NEXTHDR_FRAGMENT);
 	else
-		last_exthdr->nexthdr = IP6_NEXTHDR_FRAGMENT;
+		hdr[((u8_t *) last_exthdr) - ((u8_t *) p->payload)] = IP6_NEXTHDR_FRAGMENT;
 
 	/* Fill Frag header's fields common to all fragments */
-	fraghdr = (struct ip6_fraghdr *) (((char *)iphdr) + unfragpart_len);
+	fraghdr = (struct ip6_fraghdr *) (hdr + unfragpart_len);
 	fraghdr->nexthdr = nexthdr;
+	fraghdr->reserved = 0;
 	fraghdr->id      = htonl(stack->ip_id++);
 
 	LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: id = %d\n", __func__, UINT fraghdr->id));
@@ -830,37 +806,26 @@ ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct ip_add
 		/* Payload Length of the original IPv6 header changed to contain
 		   the length of this fragment packet only (excluding the length
 		 * of the IPv6 header itself), */
-		IPH_PAYLOADLEN_SET(iphdr, (unfragpart_len - IP_HLEN) + IP_EXTFRAG_LEN + ncopy);
-
+		IPH_PAYLOADLEN_SET((struct ip_hdr *) hdr, (unfragpart_len - IP_HLEN) + IP_EXTFRAG_LEN + ncopy);
 
 		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: offset = %d (%4x) (last=%d) copy=%d\n", __func__, offset, offset_m, last, ncopy));
 
-		p = copy_from_pbuf(p, &poffset, 
-			((u8_t *) iphdr) + unfragpart_len + IP_EXTFRAG_LEN, ncopy);
-
-		if (last)
-			pbuf_realloc(rambuf, unfragpart_len + IP_EXTFRAG_LEN + left);
-
-		/* This part is ugly: we alloc a RAM based pbuf for 
-		 * the link level header for each chunk and then 
-		 * free it.A PBUF_ROM style pbuf for which pbuf_header
-		 * worked would make things simpler.
-		 */
-		linkheader = pbuf_alloc(PBUF_LINK, 0, PBUF_RAM);
-		pbuf_chain(linkheader, rambuf);
+		if ((frag = ip_frag_build(&p, &poffset, hdr, unfragpart_len + IP_EXTFRAG_LEN, ncopy)) == NULL) {
+			IPFRAG_STATS_INC(ip_frag.memerr);
+			return ERR_MEM;
+		}
 
-		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: netif->output (pbuf len/tot=%d/%d)\n", __func__, linkheader->len, linkheader->tot_len ));
-		netif->output(netif, linkheader, dest);
+		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: netif->output (pbuf len/tot=%d/%d)\n", __func__, frag->len, frag->tot_len ));
+		netif->output(netif, frag, dest);
 		LWIP_DEBUGF(IP_REASS_DEBUG, ("%s: netif->output finish\n", __func__));
 
 		IPFRAG_STATS_INC(ip_frag.xmit);
-		pbuf_free(linkheader);
+		pbuf_free(frag);
 
 		left   -= ncopy;
 		offset += ncopy;
 	}
 
-	pbuf_free(rambuf);
 	return ERR_OK;
 }
 
@@ -323,6 +323,7 @@ struct netif * netif_add(
   netif->state = state;
   netif->num = 0;
   netif->addrs = NULL;
+  netif->arp = NULL;
 
   netif->input = input;
   netif->netifctl = NULL;
@@ -285,12 +285,8 @@ pbuf_realloc(struct pbuf *p, u16_t new_len)
   /* we have now reached the new last pbuf (in q) */
   /* rem_len == desired length for pbuf q */
 
-  /* shrink allocated memory for PBUF_RAM */
-  /* (other types merely adjust their length fields */
-  if ((q->flags == PBUF_FLAG_RAM) && (rem_len != q->len)) {
-    /* reallocate and adjust the length of the pbuf that will be split */
-    mem_realloc(q, (u8_t *)q->payload - (u8_t *)q + rem_len);
-  }
+  /* PBUF_RAM memory is not shrunk: mem_realloc is realloc(3) here and
+   * it could move the pbuf, all types merely adjust their length fields */
   /* adjust length fields for new last pbuf */
   q->len = rem_len;
   q->tot_len = q->len;
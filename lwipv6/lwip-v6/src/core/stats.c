@@ -65,7 +65,8 @@ stats_display_proto(struct stats_proto *proto, char *name)
   LWIP_PLATFORM_DIAG(("proterr: %d\n\t", proto->proterr)); 
   LWIP_PLATFORM_DIAG(("opterr: %d\n\t", proto->opterr)); 
   LWIP_PLATFORM_DIAG(("err: %d\n\t", proto->err)); 
-  LWIP_PLATFORM_DIAG(("cachehit: %d\n", proto->cachehit)); 
+  LWIP_PLATFORM_DIAG(("cachehit: %d\n\t", proto->cachehit)); 
+  LWIP_PLATFORM_DIAG(("coalesced: %d\n", proto->coalesced)); 
 }
 
 void
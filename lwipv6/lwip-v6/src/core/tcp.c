@@ -82,10 +82,6 @@ const u8_t tcp_backoff[13] =
 
 #if 0
 STACK FIELDS
-/* Incremented every coarse grained timer shot
-   (typically every 500 ms, determined by TCP_COARSE_TIMEOUT). */
-u32_t tcp_ticks;
-
 /* The TCP PCB lists. */
 
 /* List of all TCP PCBs in LISTEN state. */
@@ -117,10 +113,6 @@ tcp_init(struct stack *stack)
   stack->tcp_listen_pcbs.listen_pcbs = NULL;
   stack->tcp_active_pcbs             = NULL;
   stack->tcp_tw_pcbs                 = NULL;
-  
-  /* initialize timer */
-  stack->tcp_ticks = 0;
-  stack->tcp_timer = 0; 
 }
 
 void
@@ -129,26 +121,6 @@ tcp_shutdown(struct stack *stack)
   /* FIX: TODO */
 }
 
-/*
- * tcp_tmr():
- *
- * Called periodically to dispatch TCP timers.
- *
- */
-
-void
-tcp_tmr(struct stack *stack)
-{
-  /* Call tcp_fasttmr() every 250 ms */
-  tcp_fasttmr(stack);
-
-  if (++stack->tcp_timer & 1) {
-    /* Call tcp_tmr() every 500 ms, i.e., every other timer
-       tcp_tmr() is called. */
-    tcp_slowtmr(stack);
-  }
-}
-
 /*
  * tcp_close():
  *
@@ -631,214 +603,276 @@ tcp_connect(struct tcp_pcb *pcb, struct ip_addr *ipaddr, u16_t port,
 } 
 
 /*
- * tcp_slowtmr():
+ * TCP timers.
  *
- * Called every 500 ms and implements the retransmission timer and the timer that
- * removes PCBs that have been in TIME-WAIT for enough time. It also increments
- * various timers such as the inactivity timer in each PCB.
+ * Each pcb has its own timers on the stack timer wheel (timerwheel.c).
+ * A timer is armed only when there is a deadline to enforce: a segment
+ * to retransmit, a delayed ACK, the application poll or a timeout
+ * depending on the state of the connection.
  */
 
-void
-tcp_slowtmr(struct stack *stack)
+/* Removes an active PCB whose timer has expired. */
+static void
+tcp_timer_remove(struct tcp_pcb *pcb)
 {
-  struct tcp_pcb *pcb, *pcb2, *prev;
-  u32_t eff_wnd;
-  u8_t pcb_remove;      /* flag if a PCB should be removed */
-  err_t err;
+  struct stack *stack = pcb->stack;
 
-  err = ERR_OK;
+  tcp_pcb_purge(pcb);
+  TCP_RMV(&stack->tcp_active_pcbs, pcb);
+  TCP_EVENT_ERR(pcb->errf, pcb->callback_arg, ERR_ABRT);
+  memp_free(MEMP_TCP_PCB, pcb);
+}
 
-  ++stack->tcp_ticks;
+/*
+ * tcp_rtx_tmr():
+ *
+ * Expires pcb->rto slow ticks after the last segment has been sent.
+ */
+static void
+tcp_rtx_tmr(void *arg)
+{
+  struct tcp_pcb *pcb = arg;
+  u32_t eff_wnd;
 
-  /* Steps through all of the active PCBs. */
-  prev = NULL;
-  pcb = stack->tcp_active_pcbs;
-  if (pcb == NULL) {
-    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: no active pcbs\n"));
+  if (pcb->state == SYN_SENT && pcb->nrtx == TCP_SYNMAXRTX) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_rtx_tmr: max SYN retries reached\n"));
+    tcp_timer_remove(pcb);
+    return;
   }
-  while (pcb != NULL) {
-    LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: processing active pcb\n"));
-    LWIP_ASSERT("tcp_slowtmr: active pcb->state != CLOSED\n", pcb->state != CLOSED);
-    LWIP_ASSERT("tcp_slowtmr: active pcb->state != LISTEN\n", pcb->state != LISTEN);
-    LWIP_ASSERT("tcp_slowtmr: active pcb->state != TIME-WAIT\n", pcb->state != TIME_WAIT);
+  if (pcb->nrtx == TCP_MAXRTX) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_rtx_tmr: max DATA retries reached\n"));
+    tcp_timer_remove(pcb);
+    return;
+  }
+  if (pcb->unacked != NULL) {
+    /* Time for a retransmission. */
+    LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rtx_tmr: pcb->rto %u\n", pcb->rto));
+
+    /* Double retransmission time-out unless we are trying to
+     * connect to somebody (i.e., we are in SYN_SENT). */
+    if (pcb->state != SYN_SENT) {
+      pcb->rto = ((pcb->sa >> 3) + pcb->sv) << tcp_backoff[pcb->nrtx];
+    }
+    /* Reduce congestion window and ssthresh. */
+    eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
+    pcb->ssthresh = eff_wnd >> 1;
+    if (pcb->ssthresh < pcb->mss) {
+      pcb->ssthresh = pcb->mss * 2;
+    }
+    pcb->cwnd = pcb->mss;
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_rtx_tmr: cwnd %u ssthresh %u\n",
+                            pcb->cwnd, pcb->ssthresh));
 
-    pcb_remove = 0;
+    /* The following needs to be called AFTER cwnd is set to one mss - STJ */
+    tcp_rexmit_rto(pcb);
 
-    if (pcb->state == SYN_SENT && pcb->nrtx == TCP_SYNMAXRTX) {
-      ++pcb_remove;
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max SYN retries reached\n"));
+    /* nothing has been sent (e.g. zero window): keep on checking */
+    if (!timer_pending(&pcb->tmr_rtx)) {
+      tcp_timer_rtx(pcb);
     }
-    else if (pcb->nrtx == TCP_MAXRTX) {
-      ++pcb_remove;
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: max DATA retries reached\n"));
-    } else {
-      ++pcb->rtime;
-      if (pcb->unacked != NULL && pcb->rtime >= pcb->rto) {
-
-        /* Time for a retransmission. */
-        LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_slowtmr: rtime %u pcb->rto %u\n",
-          pcb->rtime, pcb->rto));
-
-        /* Double retransmission time-out unless we are trying to
-         * connect to somebody (i.e., we are in SYN_SENT). */
-        if (pcb->state != SYN_SENT) {
-          pcb->rto = ((pcb->sa >> 3) + pcb->sv) << tcp_backoff[pcb->nrtx];
-        }
-        /* Reduce congestion window and ssthresh. */
-        eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
-        pcb->ssthresh = eff_wnd >> 1;
-        if (pcb->ssthresh < pcb->mss) {
-          pcb->ssthresh = pcb->mss * 2;
-        }
-        pcb->cwnd = pcb->mss;
-        LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %u ssthresh %u\n",
-                                pcb->cwnd, pcb->ssthresh));
- 
-        /* The following needs to be called AFTER cwnd is set to one mss - STJ */
-        tcp_rexmit_rto(pcb);
-     }
+  }
+}
+
+void
+tcp_timer_rtx(struct tcp_pcb *pcb)
+{
+  timer_arm(pcb->stack, &pcb->tmr_rtx, pcb->rto * TCP_SLOW_INTERVAL);
+}
+
+/*
+ * tcp_idle_tmr():
+ *
+ * Timeouts measured from the last activity on the connection (pcb->tmr):
+ * SYN-RCVD, FIN-WAIT-2 and TIME-WAIT timeouts, KEEPALIVE probes and
+ * the expiration of out of sequence data.
+ */
+static void
+tcp_idle_tmr(void *arg)
+{
+  struct tcp_pcb *pcb = arg;
+  struct stack *stack = pcb->stack;
+  u32_t idle = tcp_ticks_now(stack) - pcb->tmr;
+
+  switch (pcb->state) {
+  case SYN_RCVD:
+    /* Check if this PCB has stayed too long in SYN-RCVD */
+    if (idle > TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL) {
+      LWIP_DEBUGF(TCP_DEBUG, ("tcp_idle_tmr: removing pcb stuck in SYN-RCVD\n"));
+      tcp_timer_remove(pcb);
+      return;
     }
+    break;
+  case FIN_WAIT_2:
     /* Check if this PCB has stayed too long in FIN-WAIT-2 */
-    if (pcb->state == FIN_WAIT_2) {
-      if ((u32_t)(stack->tcp_ticks - pcb->tmr) >
-        TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL) {
-        ++pcb_remove;
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in FIN-WAIT-2\n"));
-      }
+    if (idle > TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL) {
+      LWIP_DEBUGF(TCP_DEBUG, ("tcp_idle_tmr: removing pcb stuck in FIN-WAIT-2\n"));
+      tcp_timer_remove(pcb);
+      return;
     }
-
-   /* Check if KEEPALIVE should be sent */
-   if((pcb->so_options & SOF_KEEPALIVE) && ((pcb->state == ESTABLISHED) || (pcb->state == CLOSE_WAIT))) {
-      if((u32_t)(stack->tcp_ticks - pcb->tmr) > (pcb->keepalive + TCP_MAXIDLE) / TCP_SLOW_INTERVAL)  {
+    break;
+  case ESTABLISHED:
+  case CLOSE_WAIT:
+    /* Check if KEEPALIVE should be sent */
+    if (pcb->so_options & SOF_KEEPALIVE) {
+      if (idle > (pcb->keepalive + TCP_MAXIDLE) / TCP_SLOW_INTERVAL) {
 #ifndef IPv6
-         LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: KEEPALIVE timeout. Aborting connection to %u.%u.%u.%u.\n",
-                                 ip4_addr1(&pcb->remote_ip), ip4_addr2(&pcb->remote_ip),
-                                 ip4_addr3(&pcb->remote_ip), ip4_addr4(&pcb->remote_ip)));
+        LWIP_DEBUGF(TCP_DEBUG, ("tcp_idle_tmr: KEEPALIVE timeout. Aborting connection to %u.%u.%u.%u.\n",
+                                ip4_addr1(&pcb->remote_ip), ip4_addr2(&pcb->remote_ip),
+                                ip4_addr3(&pcb->remote_ip), ip4_addr4(&pcb->remote_ip)));
 #endif
-
-         tcp_abort(pcb);
+        tcp_abort(pcb);
+        return;
       }
-      else if((u32_t)(stack->tcp_ticks - pcb->tmr) > (pcb->keepalive + pcb->keep_cnt * TCP_KEEPINTVL) / TCP_SLOW_INTERVAL) {
-         tcp_keepalive(pcb);
-         pcb->keep_cnt++;
+      else if (idle > (pcb->keepalive + pcb->keep_cnt * TCP_KEEPINTVL) / TCP_SLOW_INTERVAL) {
+        tcp_keepalive(pcb);
+        pcb->keep_cnt++;
       }
-   }
-
-    /* If this PCB has queued out of sequence data, but has been
-       inactive for too long, will drop the data (it will eventually
-       be retransmitted). */
-#if TCP_QUEUE_OOSEQ    
-    if (pcb->ooseq != NULL &&
-       (u32_t)stack->tcp_ticks - pcb->tmr >=
-       pcb->rto * TCP_OOSEQ_TIMEOUT) {
-      tcp_segs_free(pcb->ooseq);
-      pcb->ooseq = NULL;
-      LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: dropping OOSEQ queued data\n"));
     }
-#endif /* TCP_QUEUE_OOSEQ */
-
-    /* Check if this PCB has stayed too long in SYN-RCVD */
-    if (pcb->state == SYN_RCVD) {
-      if ((u32_t)(stack->tcp_ticks - pcb->tmr) >
-   TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL) {
-        ++pcb_remove;
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: removing pcb stuck in SYN-RCVD\n"));
-      }
+    break;
+  case TIME_WAIT:
+    /* Check if this PCB has stayed long enough in TIME-WAIT */
+    if (idle > 2 * TCP_MSL / TCP_SLOW_INTERVAL) {
+      tcp_pcb_purge(pcb);
+      TCP_RMV(&stack->tcp_tw_pcbs, pcb);
+      memp_free(MEMP_TCP_PCB, pcb);
+      return;
     }
+    break;
+  default:
+    break;
+  }
 
+  /* If this PCB has queued out of sequence data, but has been
+     inactive for too long, will drop the data (it will eventually
+     be retransmitted). */
+#if TCP_QUEUE_OOSEQ
+  if (pcb->ooseq != NULL &&
+      idle >= (u32_t)pcb->rto * TCP_OOSEQ_TIMEOUT) {
+    tcp_segs_free(pcb->ooseq);
+    pcb->ooseq = NULL;
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_idle_tmr: dropping OOSEQ queued data\n"));
+  }
+#endif /* TCP_QUEUE_OOSEQ */
 
-    /* If the PCB should be removed, do it. */
-    if (pcb_remove) {
-      tcp_pcb_purge(pcb);      
-      /* Remove PCB from tcp_active_pcbs list. */
-      if (prev != NULL) {
-  LWIP_ASSERT("tcp_slowtmr: middle tcp != tcp_active_pcbs", pcb != stack->tcp_active_pcbs);
-        prev->next = pcb->next;
-      } else {
-        /* This PCB was the first. */
-        LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", stack->tcp_active_pcbs == pcb);
-        stack->tcp_active_pcbs = pcb->next;
-      }
+  tcp_timer_idle(pcb);
+}
 
-      TCP_EVENT_ERR(pcb->errf, pcb->callback_arg, ERR_ABRT);
+/*
+ * tcp_timer_idle():
+ *
+ * (Re)computes the next idle timeout of the PCB. It must be called
+ * when the state, the KEEPALIVE settings or the ooseq queue change.
+ */
+void
+tcp_timer_idle(struct tcp_pcb *pcb)
+{
+  u32_t timeout, idle;
 
-      pcb2 = pcb->next;
-      memp_free(MEMP_TCP_PCB, pcb);
-      pcb = pcb2;
-    } else {
-
-      /* We check if we should poll the connection. */
-      ++pcb->polltmr;
-      if (pcb->polltmr >= pcb->pollinterval) {
-        pcb->polltmr = 0;
-        LWIP_DEBUGF(TCP_DEBUG, ("tcp_slowtmr: polling application\n"));
-        TCP_EVENT_POLL(pcb, err);
-        if (err == ERR_OK) {
-          tcp_output(pcb);
-        }
-      }
-      
-      prev = pcb;
-      pcb = pcb->next;
-    }
+  /* timeout: slow ticks since the last activity, 0 = none */
+  switch (pcb->state) {
+  case SYN_RCVD:
+    timeout = TCP_SYN_RCVD_TIMEOUT / TCP_SLOW_INTERVAL + 1;
+    break;
+  case FIN_WAIT_2:
+    timeout = TCP_FIN_WAIT_TIMEOUT / TCP_SLOW_INTERVAL + 1;
+    break;
+  case ESTABLISHED:
+  case CLOSE_WAIT:
+    timeout = (pcb->so_options & SOF_KEEPALIVE) ?
+      (pcb->keepalive + pcb->keep_cnt * TCP_KEEPINTVL) / TCP_SLOW_INTERVAL + 1 : 0;
+    break;
+  case TIME_WAIT:
+    timeout = 2 * TCP_MSL / TCP_SLOW_INTERVAL + 1;
+    break;
+  case CLOSED:
+  case LISTEN:
+    return;
+  default:
+    timeout = 0;
+    break;
   }
+#if TCP_QUEUE_OOSEQ
+  if (pcb->ooseq != NULL && pcb->state != TIME_WAIT &&
+      (timeout == 0 || (u32_t)pcb->rto * TCP_OOSEQ_TIMEOUT < timeout)) {
+    timeout = (u32_t)pcb->rto * TCP_OOSEQ_TIMEOUT;
+  }
+#endif /* TCP_QUEUE_OOSEQ */
 
-  
-  /* Steps through all of the TIME-WAIT PCBs. */
-  prev = NULL;    
-  pcb = stack->tcp_tw_pcbs;
-  while (pcb != NULL) {
-    LWIP_ASSERT("tcp_slowtmr: TIME-WAIT pcb->state == TIME-WAIT", pcb->state == TIME_WAIT);
-    pcb_remove = 0;
+  if (timeout > 0) {
+    idle = tcp_ticks_now(pcb->stack) - pcb->tmr;
+    timeout = (timeout > idle) ? timeout - idle : 1;
+    timer_reduce(pcb->stack, &pcb->tmr_idle, timeout * TCP_SLOW_INTERVAL);
+  }
+}
 
-    /* Check if this PCB has stayed long enough in TIME-WAIT */
-    if ((u32_t)(stack->tcp_ticks - pcb->tmr) > 2 * TCP_MSL / TCP_SLOW_INTERVAL) {
-      ++pcb_remove;
-    }
-    
+/*
+ * tcp_poll_tmr():
+ *
+ * Polls the application every pcb->pollinterval slow ticks.
+ */
+static void
+tcp_poll_tmr(void *arg)
+{
+  struct tcp_pcb *pcb = arg;
+  err_t err = ERR_OK;
+
+  /* re-armed first: the application may close or abort the pcb */
+  tcp_timer_poll(pcb);
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_poll_tmr: polling application\n"));
+  TCP_EVENT_POLL(pcb, err);
+  if (err == ERR_OK) {
+    tcp_output(pcb);
+  }
+}
 
+void
+tcp_timer_poll(struct tcp_pcb *pcb)
+{
+  u32_t interval = (pcb->pollinterval > 0) ? pcb->pollinterval : 1;
 
-    /* If the PCB should be removed, do it. */
-    if (pcb_remove) {
-      tcp_pcb_purge(pcb);      
-      /* Remove PCB from tcp_tw_pcbs list. */
-      if (prev != NULL) {
-  LWIP_ASSERT("tcp_slowtmr: middle tcp != tcp_tw_pcbs", pcb != stack->tcp_tw_pcbs);
-        prev->next = pcb->next;
-      } else {
-        /* This PCB was the first. */
-        LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", stack->stackw_pcbs == pcb);
-        stack->tcp_tw_pcbs = pcb->next;
-      }
-      pcb2 = pcb->next;
-      memp_free(MEMP_TCP_PCB, pcb);
-      pcb = pcb2;
-    } else {
-      prev = pcb;
-      pcb = pcb->next;
-    }
-  }
+  timer_arm(pcb->stack, &pcb->tmr_poll, interval * TCP_SLOW_INTERVAL);
 }
 
 /*
- * tcp_fasttmr():
+ * tcp_dack_tmr():
  *
- * Is called every TCP_FAST_INTERVAL (250 ms) and sends delayed ACKs.
+ * Sends the delayed ACK.
  */
+static void
+tcp_dack_tmr(void *arg)
+{
+  struct tcp_pcb *pcb = arg;
+
+  if (pcb->flags & TF_ACK_DELAY) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_dack_tmr: delayed ACK\n"));
+    tcp_ack_now(pcb);
+    pcb->flags &= ~(TF_ACK_DELAY | TF_ACK_NOW);
+  }
+}
 
 void
-tcp_fasttmr(struct stack *stack)
+tcp_timer_dack(struct tcp_pcb *pcb)
 {
-  struct tcp_pcb *pcb;
+  if (!timer_pending(&pcb->tmr_dack)) {
+    timer_arm(pcb->stack, &pcb->tmr_dack, TCP_DELACK_TIMEOUT);
+  }
+}
 
-  /* send delayed ACKs */  
-  for(pcb = stack->tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
-    if (pcb->flags & TF_ACK_DELAY) {
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_fasttmr: delayed ACK\n"));
-      tcp_ack_now(pcb);
-      pcb->flags &= ~(TF_ACK_DELAY | TF_ACK_NOW);
-    }
+/*
+ * tcp_timers_start():
+ *
+ * Called by TCP_REG when a PCB enters the active or the TIME-WAIT list.
+ */
+void
+tcp_timers_start(struct tcp_pcb *pcb)
+{
+  if (pcb->state == LISTEN || pcb->state == CLOSED) {
+    return;
   }
+  if (pcb->state != TIME_WAIT) {
+    tcp_timer_poll(pcb);
+  }
+  tcp_timer_idle(pcb);
 }
 
 /*
@@ -940,6 +974,7 @@ tcp_kill_prio(struct stack *stack, u8_t prio)
 {
   struct tcp_pcb *pcb, *inactive;
   u32_t inactivity;
+  u32_t now = tcp_ticks_now(stack);
   u8_t mprio;
 
 
@@ -952,8 +987,8 @@ tcp_kill_prio(struct stack *stack, u8_t prio)
   for(pcb = stack->tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
     if (pcb->prio <= prio &&
        pcb->prio <= mprio &&
-       (u32_t)(stack->tcp_ticks - pcb->tmr) >= inactivity) {
-      inactivity = stack->tcp_ticks - pcb->tmr;
+       (u32_t)(now - pcb->tmr) >= inactivity) {
+      inactivity = now - pcb->tmr;
       inactive = pcb;
       mprio = pcb->prio;
     }
@@ -971,12 +1006,13 @@ tcp_kill_timewait(struct stack *stack)
 {
   struct tcp_pcb *pcb, *inactive;
   u32_t inactivity;
+  u32_t now = tcp_ticks_now(stack);
 
   inactivity = 0;
   inactive = NULL;
   for(pcb = stack->tcp_tw_pcbs; pcb != NULL; pcb = pcb->next) {
-    if ((u32_t)(stack->tcp_ticks - pcb->tmr) >= inactivity) {
-      inactivity = stack->tcp_ticks - pcb->tmr;
+    if ((u32_t)(now - pcb->tmr) >= inactivity) {
+      inactivity = now - pcb->tmr;
       inactive = pcb;
     }
   }
@@ -1025,7 +1061,6 @@ tcp_alloc(struct stack *stack, u8_t prio)
     pcb->rto = 3000 / TCP_SLOW_INTERVAL;
     pcb->sa = 0;
     pcb->sv = 3000 / TCP_SLOW_INTERVAL;
-    pcb->rtime = 0;
     pcb->cwnd = 1;
     iss = tcp_next_iss(stack);
     pcb->snd_wl2 = iss;
@@ -1033,9 +1068,12 @@ tcp_alloc(struct stack *stack, u8_t prio)
     pcb->snd_max = iss;
     pcb->lastack = iss;
     pcb->snd_lbb = iss;   
-    pcb->tmr = stack->tcp_ticks;
+    pcb->tmr = tcp_ticks_now(stack);
 
-    pcb->polltmr = 0;
+    timer_set(&pcb->tmr_rtx, tcp_rtx_tmr, pcb);
+    timer_set(&pcb->tmr_idle, tcp_idle_tmr, pcb);
+    timer_set(&pcb->tmr_poll, tcp_poll_tmr, pcb);
+    timer_set(&pcb->tmr_dack, tcp_dack_tmr, pcb);
 
 #if LWIP_CALLBACK_API
     pcb->recv = tcp_recv_null;
@@ -1161,6 +1199,9 @@ tcp_poll(struct tcp_pcb *pcb,
   pcb->poll = poll;
 #endif /* LWIP_CALLBACK_API */  
   pcb->pollinterval = interval;
+  if (pcb->state > LISTEN && pcb->state < TIME_WAIT) {
+    tcp_timer_poll(pcb);
+  }
 }
 
 /*
@@ -1201,6 +1242,17 @@ tcp_pcb_purge(struct tcp_pcb *pcb)
     tcp_segs_free(pcb->unsent);
     tcp_segs_free(pcb->unacked);
     pcb->unacked = pcb->unsent = NULL;
+#if TCP_GRO
+    tcp_gro_drop(pcb);
+#endif /* TCP_GRO */
+  }
+  if (pcb->state != LISTEN) {
+    struct stack *stack = pcb->stack;
+
+    timer_cancel(stack, &pcb->tmr_rtx);
+    timer_cancel(stack, &pcb->tmr_idle);
+    timer_cancel(stack, &pcb->tmr_poll);
+    timer_cancel(stack, &pcb->tmr_dack);
   }
 }
 
@@ -1242,7 +1294,7 @@ tcp_next_iss(struct stack *stack)
 {
   static u32_t iss = 6510;
   
-  iss += stack->tcp_ticks;       /* XXX */
+  iss += tcp_ticks_now(stack);       /* XXX */
   return iss;
 }
 
@@ -99,6 +99,121 @@ static err_t tcp_listen_input(struct tcp_pcb_listen *pcb,struct pseudo_iphdr *pi
 
 static err_t tcp_timewait_input(struct tcp_pcb *pcb);
 
+#if TCP_GRO
+/* An in-order data segment whose payload can be held back and merged
+	 with the following segments of the same input batch */
+#define TCP_GRO_ELIGIBLE(pcb, stack) ((pcb)->state == ESTABLISHED && \
+		(stack)->recv_data != NULL && (stack)->recv_flags == 0 && \
+		((stack)->flags & ~(TCP_ACK | TCP_PSH)) == 0)
+
+/* tcp_gro_flush_pcb:
+ *
+ * Passes the coalesced data of a pcb to the application (one recv event)
+ * and sends the stretch ACK for all the segments merged in it.
+ */
+	static err_t
+tcp_gro_flush_pcb(struct tcp_pcb *pcb)
+{
+	struct stack *stack = pcb->stack;
+	struct tcp_pcb **pp;
+	struct pbuf *p = pcb->gro_data;
+	u16_t segs = pcb->gro_segs;
+	err_t err = ERR_OK;
+
+	for (pp = &stack->tcp_gro_pcbs; *pp != NULL; pp = &((*pp)->gro_next)) {
+		if (*pp == pcb) {
+			*pp = pcb->gro_next;
+			break;
+		}
+	}
+	pcb->gro_next = NULL;
+	pcb->gro_data = NULL;
+	pcb->gro_segs = 0;
+
+	if (p != NULL) {
+		LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_gro_flush: %u bytes, %u segments\n",
+					p->tot_len, segs));
+		TCP_EVENT_RECV(pcb, p, ERR_OK, err);
+		if (err == ERR_ABRT)
+			return err;
+	}
+	if (err == ERR_OK) {
+		if (segs > 1 && (pcb->flags & TF_ACK_DELAY))
+			pcb->flags |= TF_ACK_NOW;
+		tcp_output(pcb);
+	}
+	return err;
+}
+
+/* tcp_gro_queue:
+ *
+ * Holds back the in-sequence data of the current segment, merging it with
+ * the data already coalesced for the pcb during this input batch.
+ */
+	static err_t
+tcp_gro_queue(struct tcp_pcb *pcb, struct pbuf *p)
+{
+	struct stack *stack = pcb->stack;
+	err_t err = ERR_OK;
+
+	if (pcb->gro_data != NULL) {
+		if (pcb->gro_data->tot_len + p->tot_len <= TCP_GRO_MAXLEN) {
+			pbuf_cat(pcb->gro_data, p);
+			pcb->gro_segs++;
+			TCP_STATS_INC(tcp.coalesced);
+			return ERR_OK;
+		}
+		/* enough data held back: deliver it and start a new run */
+		err = tcp_gro_flush_pcb(pcb);
+		if (err == ERR_ABRT) {
+			pbuf_free(p);
+			return err;
+		}
+	}
+	pcb->gro_data = p;
+	pcb->gro_segs = 1;
+	pcb->gro_next = stack->tcp_gro_pcbs;
+	stack->tcp_gro_pcbs = pcb;
+	return err;
+}
+
+/* tcp_gro_flush:
+ *
+ * Called by the tcpip thread when the current input batch is over
+ * (there are no more messages waiting in the stack queue).
+ */
+	void
+tcp_gro_flush(struct stack *stack)
+{
+	while (stack->tcp_gro_pcbs != NULL)
+		tcp_gro_flush_pcb(stack->tcp_gro_pcbs);
+}
+
+/* tcp_gro_drop:
+ *
+ * Discards the coalesced data of a pcb which is being purged.
+ */
+	void
+tcp_gro_drop(struct tcp_pcb *pcb)
+{
+	struct stack *stack = pcb->stack;
+	struct tcp_pcb **pp;
+
+	if (pcb->gro_data == NULL)
+		return;
+	for (pp = &stack->tcp_gro_pcbs; *pp != NULL; pp = &((*pp)->gro_next)) {
+		if (*pp == pcb) {
+			*pp = pcb->gro_next;
+			break;
+		}
+	}
+	pbuf_free(pcb->gro_data);
+	pcb->gro_next = NULL;
+	pcb->gro_data = NULL;
+	pcb->gro_segs = 0;
+}
+#endif /* TCP_GRO */
+
 #ifdef LWSLIRP
 #define DROPWITHRESET(stack, tcphdr, piphdr) do {\
 	tcp_rst(stack, 0, \
@@ -472,6 +587,18 @@ again_1:
 		stack->recv_data = NULL;
 		stack->recv_flags = 0;
 
+#if TCP_GRO
+		/* The data held back for this pcb must reach the application before
+			 anything which is not plain in-sequence data (FIN, RST...) */
+		if (pcb->gro_data != NULL &&
+				((stack->flags & ~(TCP_ACK | TCP_PSH)) != 0 || pcb->state != ESTABLISHED)) {
+			if (tcp_gro_flush_pcb(pcb) == ERR_ABRT) {
+				pbuf_free(p);
+				return;
+			}
+		}
+#endif /* TCP_GRO */
+
 		stack->tcp_input_pcb = pcb;
 		err = tcp_process(pcb,piphdr);
 		stack->tcp_input_pcb = NULL;
@@ -501,6 +628,12 @@ again_1:
 				}
 
 				if (stack->recv_data != NULL) {
+#if TCP_GRO
+					if (TCP_GRO_ELIGIBLE(pcb, stack))
+						/* Coalesce, the application is notified by tcp_gro_flush() */
+						err = tcp_gro_queue(pcb, stack->recv_data);
+					else
+#endif /* TCP_GRO */
 					/* Notify application that data has been received. */
 					TCP_EVENT_RECV(pcb, stack->recv_data, ERR_OK, err);
 				}
@@ -801,7 +934,7 @@ tcp_process(struct tcp_pcb *pcb,struct pseudo_iphdr *piphdr)
 	}
 
 	/* Update the PCB (in)activity timer. */
-	pcb->tmr = stack->tcp_ticks;
+	pcb->tmr = tcp_ticks_now(stack);
 	pcb->keep_cnt = 0;
 
 	/* Do different things depending on the TCP state. */
@@ -817,6 +950,7 @@ tcp_process(struct tcp_pcb *pcb,struct pseudo_iphdr *piphdr)
 				pcb->snd_wnd = stack->tcphdr->wnd;
 				pcb->snd_wl1 = stack->seqno - 1; /* initialise to seqno - 1 to force window update */
 				pcb->state = ESTABLISHED;
+				tcp_timer_idle(pcb);
 				pcb->cwnd = pcb->mss;
 				--pcb->snd_queuelen;
 				LWIP_DEBUGF(TCP_QLEN_DEBUG, ("tcp_process: SYN-SENT --queuelen %u\n", (unsigned int)pcb->snd_queuelen));
@@ -846,6 +980,7 @@ tcp_process(struct tcp_pcb *pcb,struct pseudo_iphdr *piphdr)
 				/* expected ACK number? */
 				if(TCP_SEQ_BETWEEN(stack->ackno, pcb->lastack+1, pcb->snd_nxt)){
 					pcb->state = ESTABLISHED;
+					tcp_timer_idle(pcb);
 					LWIP_DEBUGF(TCP_DEBUG, ("TCP connection established %u -> %u.\n", stack->inseg.tcphdr->src, stack->inseg.tcphdr->dest));
 #if LWIP_CALLBACK_API
 					LWIP_ASSERT("pcb->accept != NULL", pcb->accept != NULL);
@@ -897,6 +1032,7 @@ tcp_process(struct tcp_pcb *pcb,struct pseudo_iphdr *piphdr)
 				}
 			} else if (stack->flags & TCP_ACK && stack->ackno == pcb->snd_nxt) {
 				pcb->state = FIN_WAIT_2;
+				tcp_timer_idle(pcb);
 			}
 			break;
 		case FIN_WAIT_2:
@@ -1098,7 +1234,7 @@ tcp_receive(struct tcp_pcb *pcb)
 								pcb->unsent != NULL);
 					}
 				}
-				pcb->polltmr = 0;
+				tcp_timer_poll(pcb);
 			}
 		}
 		/* We go through the ->unsent list to see if any of the segments
@@ -1140,7 +1276,7 @@ tcp_receive(struct tcp_pcb *pcb)
 			 incoming segment acknowledges the segment we use to take a
 			 round-trip time measurement. */
 		if (pcb->rttest && TCP_SEQ_LT(pcb->rtseq, stack->ackno)) {
-			m = stack->tcp_ticks - pcb->rttest;
+			m = tcp_ticks_now(stack) - pcb->rttest;
 
 			LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: experienced rtt %u ticks (%u msec).\n",
 						m, m * TCP_SLOW_INTERVAL));
@@ -1339,6 +1475,12 @@ tcp_receive(struct tcp_pcb *pcb)
 
 
 				/* Acknowledge the segment(s). */
+#if TCP_GRO
+				if (pcb->gro_data != NULL && TCP_GRO_ELIGIBLE(pcb, stack))
+					/* a single stretch ACK is sent by tcp_gro_flush() */
+					tcp_ack_delay(pcb);
+				else
+#endif /* TCP_GRO */
 				tcp_ack(pcb);
 
 			} else {
@@ -1348,6 +1490,8 @@ tcp_receive(struct tcp_pcb *pcb)
 				/* We queue the segment on the ->ooseq queue. */
 				if (pcb->ooseq == NULL) {
 					pcb->ooseq = tcp_seg_copy(&stack->inseg);
+					/* arm the OOSEQ timeout */
+					tcp_timer_idle(pcb);
 				} else {
 					/* If the queue is not empty, we walk through the queue and
 						 try to find a place where the sequence number of the
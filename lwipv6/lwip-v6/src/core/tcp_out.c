@@ -444,6 +444,7 @@ tcp_output(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output: sending ACK for %lu\n", pcb->rcv_nxt));
     /* remove ACK flags from the PCB, as we send an empty ACK now */
     pcb->flags &= ~(TF_ACK_DELAY | TF_ACK_NOW);
+    timer_cancel(stack, &pcb->tmr_dack);
 
     tcphdr = p->payload;
     tcphdr->src = htons(pcb->local_port);
@@ -498,6 +499,7 @@ tcp_output(struct tcp_pcb *pcb)
     if (pcb->state != SYN_SENT) {
       TCPH_SET_FLAG(seg->tcphdr, TCP_ACK);
       pcb->flags &= ~(TF_ACK_DELAY | TF_ACK_NOW);
+      timer_cancel(stack, &pcb->tmr_dack);
     }
 
     tcp_output_segment(seg, pcb);
@@ -562,6 +564,10 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
     seg->tcphdr->wnd = htons(pcb->rcv_wnd);
   }
 
+  /* (re)start the retransmission timer, also when there is no route:
+     the segment is already on the unacked queue */
+  tcp_timer_rtx(pcb);
+
   /* If we don't have a local IP address, we get one by
      calling ip_route(). */
   if (ip_addr_isany(&(pcb->local_ip))) {
@@ -580,10 +586,8 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
     ip_addr_set(&(pcb->local_ip), &(el->ipaddr));
   }
 
-  pcb->rtime = 0;
-
   if (pcb->rttest == 0) {
-    pcb->rttest = stack->tcp_ticks;
+    pcb->rttest = tcp_ticks_now(stack);
     pcb->rtseq = ntohl(seg->tcphdr->seqno);
 
     LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_output_segment: rtseq %lu\n", pcb->rtseq));
@@ -723,7 +727,7 @@ tcp_keepalive(struct tcp_pcb *pcb)
                            ip4_addr3(&pcb->remote_ip), ip4_addr4(&pcb->remote_ip)));
 #endif
 
-   LWIP_DEBUGF(TCP_DEBUG, ("tcp_keepalive: tcp_ticks %lu   pcb->tmr %lu  pcb->keep_cnt %u\n", stack->tcp_ticks, pcb->tmr, pcb->keep_cnt));
+   LWIP_DEBUGF(TCP_DEBUG, ("tcp_keepalive: tcp_ticks %lu   pcb->tmr %lu  pcb->keep_cnt %u\n", tcp_ticks_now(stack), pcb->tmr, pcb->keep_cnt));
    
    p = pbuf_alloc(PBUF_IP, TCP_HLEN, PBUF_RAM);
 
@@ -0,0 +1,276 @@
+/*   This is part of LWIPv6
+ *   Developed for the Ale4NET project
+ *   Application Level Environment for Networking
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/debug.h"
+#include "lwip/stack.h"
+#include "lwip/timerwheel.h"
+
+#ifndef TIMER_DEBUG
+#define TIMER_DEBUG DBG_OFF
+#endif
+
+/* number of ticks covered by the wheel */
+#define TIMER_WHEEL_RANGE ((u32_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+/* sys_now() is in microseconds */
+#define TIMER_TICK_USEC ((unsigned long)TIMER_WHEEL_TICK * 1000)
+
+static void timer_wheel_run(void *arg);
+
+/* ticks elapsed since the last processed tick (w->jiffies) */
+static u32_t
+timer_lag(struct timer_wheel *w)
+{
+	return (sys_now() - w->last) / TIMER_TICK_USEC;
+}
+
+/* nothing is armed: the clock of the wheel jumps to the current tick */
+static void
+timer_catch_up(struct timer_wheel *w)
+{
+	u32_t elapsed = timer_lag(w);
+
+	w->jiffies += elapsed;
+	w->last += elapsed * TIMER_TICK_USEC;
+}
+
+static void
+timer_enqueue(struct timer_wheel *w, struct timer_entry *t)
+{
+	struct timer_entry **head;
+	u32_t delta = t->expires - w->jiffies;
+	int level;
+
+	if ((s32_t) delta < 0) {
+		t->expires = w->jiffies;
+		delta = 0;
+	} else if (delta >= TIMER_WHEEL_RANGE) {
+		/* clamped: the handler re-arms itself */
+		delta = TIMER_WHEEL_RANGE - 1;
+		t->expires = w->jiffies + delta;
+	}
+	for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+		if (delta < ((u32_t)1 << (TIMER_WHEEL_BITS * (level + 1))))
+			break;
+	head = &w->slot[level][(t->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+
+	t->next = *head;
+	if (t->next != NULL)
+		t->next->pprev = &t->next;
+	t->pprev = head;
+	*head = t;
+}
+
+static void
+timer_unlink(struct timer_entry *t)
+{
+	*(t->pprev) = t->next;
+	if (t->next != NULL)
+		t->next->pprev = t->pprev;
+	t->next = NULL;
+	t->pprev = NULL;
+}
+
+/* first tick when something has to be done: a level 0 timer expires
+   or an upper level slot has to be cascaded */
+static u32_t
+timer_next(struct timer_wheel *w)
+{
+	u32_t next = w->jiffies + TIMER_WHEEL_RANGE;
+	int level;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		int shift = TIMER_WHEEL_BITS * level;
+		u32_t base = w->jiffies >> shift;
+		u32_t i;
+
+		for (i = 1; i <= TIMER_WHEEL_SIZE; i++) {
+			if (w->slot[level][(base + i) & TIMER_WHEEL_MASK] != NULL) {
+				u32_t tick = (base + i) << shift;
+				if ((s32_t) (tick - next) < 0)
+					next = tick;
+				break;
+			}
+		}
+	}
+	return next;
+}
+
+/* wake up the stack thread at the given tick */
+static void
+timer_schedule(struct stack *stack, u32_t tick)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+	unsigned long elapsed;
+	u32_t msecs;
+
+	if (w->running)
+		return;
+	if (w->scheduled) {
+		if ((s32_t) (tick - w->wakeup) >= 0)
+			return;
+		sys_untimeout(timer_wheel_run, stack);
+	}
+
+	elapsed = (sys_now() - w->last) / 1000;
+	msecs = (tick - w->jiffies) * TIMER_WHEEL_TICK;
+	msecs = (msecs > elapsed) ? msecs - elapsed : 0;
+
+	w->wakeup = tick;
+	w->scheduled = 1;
+	sys_timeout(msecs, timer_wheel_run, stack);
+}
+
+/* process one tick: cascade the upper levels and run the expired timers */
+static void
+timer_wheel_tick(struct timer_wheel *w)
+{
+	struct timer_entry *t, *work;
+	u32_t index;
+	int level;
+
+	w->jiffies++;
+	w->last += TIMER_TICK_USEC;
+
+	index = w->jiffies & TIMER_WHEEL_MASK;
+	for (level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++) {
+		index = (w->jiffies >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+		t = w->slot[level][index];
+		w->slot[level][index] = NULL;
+		while (t != NULL) {
+			struct timer_entry *next = t->next;
+			timer_enqueue(w, t);
+			t = next;
+		}
+	}
+
+	/* handlers may arm and cancel any timer, even those in the work list */
+	index = w->jiffies & TIMER_WHEEL_MASK;
+	work = w->slot[0][index];
+	w->slot[0][index] = NULL;
+	if (work != NULL)
+		work->pprev = &work;
+	while ((t = work) != NULL) {
+		timer_unlink(t);
+		w->armed--;
+		LWIP_DEBUGF(TIMER_DEBUG, ("timer_wheel_tick: %p expired at %u\n", (void *)t, (unsigned int)w->jiffies));
+		t->h(t->arg);
+	}
+}
+
+static void
+timer_wheel_run(void *arg)
+{
+	struct stack *stack = (struct stack *) arg;
+	struct timer_wheel *w = &stack->stack_timers;
+	u32_t elapsed = timer_lag(w);
+
+	w->scheduled = 0;
+	w->running = 1;
+	while (elapsed > 0) {
+		if (w->armed == 0) {
+			timer_catch_up(w);
+			break;
+		}
+		timer_wheel_tick(w);
+		elapsed--;
+	}
+	w->running = 0;
+
+	if (w->armed > 0)
+		timer_schedule(stack, timer_next(w));
+}
+
+void
+timer_wheel_init(struct stack *stack)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+
+	memset(w, 0, sizeof(struct timer_wheel));
+	w->last = sys_now();
+}
+
+void
+timer_wheel_shutdown(struct stack *stack)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+
+	if (w->scheduled) {
+		sys_untimeout(timer_wheel_run, stack);
+		w->scheduled = 0;
+	}
+}
+
+u32_t
+timer_now(struct stack *stack)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+
+	return w->jiffies + timer_lag(w);
+}
+
+void
+timer_arm(struct stack *stack, struct timer_entry *t, u32_t msecs)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+	u32_t ticks = (msecs + TIMER_WHEEL_TICK - 1) / TIMER_WHEEL_TICK;
+
+	if (ticks == 0)
+		ticks = 1;
+	/* after an idle period the wheel would tick once per idle tick and
+	   the timers armed now would look too far in the future */
+	if (w->armed == 0 && !w->running)
+		timer_catch_up(w);
+	if (timer_pending(t))
+		timer_unlink(t);
+	else
+		w->armed++;
+	t->expires = w->jiffies + timer_lag(w) + ticks;
+	timer_enqueue(w, t);
+	timer_schedule(stack, t->expires);
+}
+
+void
+timer_reduce(struct stack *stack, struct timer_entry *t, u32_t msecs)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+	u32_t ticks = (msecs + TIMER_WHEEL_TICK - 1) / TIMER_WHEEL_TICK;
+
+	if (ticks == 0)
+		ticks = 1;
+	if (timer_pending(t) &&
+			(s32_t) (t->expires - (w->jiffies + timer_lag(w) + ticks)) <= 0)
+		return;
+	timer_arm(stack, t, msecs);
+}
+
+void
+timer_cancel(struct stack *stack, struct timer_entry *t)
+{
+	struct timer_wheel *w = &stack->stack_timers;
+
+	if (timer_pending(t)) {
+		timer_unlink(t);
+		w->armed--;
+	}
+}
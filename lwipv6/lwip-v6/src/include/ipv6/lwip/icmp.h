@@ -222,9 +222,9 @@ struct icmp_na_hdr {
   PACK_STRUCT_FIELD(u8_t icode); 
   PACK_STRUCT_FIELD(u16_t chksum);
   PACK_STRUCT_FIELD(u8_t rso_flags);
-#define ICMP6_NA_R  0x01
-#define ICMP6_NA_S  0x02
-#define ICMP6_NA_O  0x04
+#define ICMP6_NA_R  0x80
+#define ICMP6_NA_S  0x40
+#define ICMP6_NA_O  0x20
   PACK_STRUCT_FIELD(u8_t reserved[3]);
   PACK_STRUCT_FIELD(u32_t targetip[4]);
   //struct icmp_opt option;  /* for Target link-layer address */
@@ -74,6 +74,9 @@
 
 #ifndef __LWIP_IP_FRAG_H__
 #define __LWIP_IP_FRAG_H__
+
+#include "lwip/timerwheel.h"
+
 struct stack;
 
 /* Module init */
@@ -137,19 +140,40 @@ err_t ip6_frag(struct stack *stack, struct pbuf *p, struct netif *netif, struct
 /* Max IP Payload len */
 #define IP_REASS_BUFSIZE         65535
 
-/* Reassembly buffer */
+/* Max length of the unfragmentable part (IPv4 header with options,
+   IPv6 header and the extension headers preceding the fragment header) */
+#define IP_REASS_HDRSIZE         128
+
+/* Datagram being reassembled.
+ * The fragments are kept as they were received (no copy): their pbufs are
+ * linked in a list sorted by decreasing offset, the header of each
+ * fragment is hidden and the room is used to store the list link and
+ * the fragment boundaries. */
 struct ip_reassbuf {
-	u8_t  ipv;     /* ip version (4, 6).  0 if the entry is empty */
-	u32_t id;      /* fragmentation id (16bit Ipv4, 32bit Ipv6) */
+	struct ip_reassbuf *next;     /* hash chain */
+	struct ip_reassbuf **pprev;
+	struct ip_reassbuf *lnext;    /* stack->ip_reass_list, oldest first */
+	struct ip_reassbuf **lpprev;
 
-	u8_t  age;     /* seconds */
-	u8_t  flags;   /* entry's state */
-	u32_t len;
+	struct stack *stack;
+	struct timer_entry tmr;       /* expiration of the datagram */
 
-	u8_t  buf[IP_REASS_BUFSIZE];
+	struct ip_addr src;           /* IPv4 addresses are IPv4-mapped */
+	struct ip_addr dest;
+	u32_t id;      /* fragmentation id (16bit Ipv4, 32bit Ipv6) */
+	u8_t  ipv;     /* ip version (4, 6) */
+	u8_t  proto;   /* IPv4 protocol, 0 for IPv6 */
 
-#define IP4_REASS_BITMAP_SIZE  (IP_REASS_BUFSIZE / (8 * 8))
-	u8_t  bitmap[IP4_REASS_BITMAP_SIZE];
+	u8_t  flags;   /* entry's state */
+	u8_t  nhoff;   /* IPv6: offset in hdr of the Next Header to patch */
+	u8_t  nexthdr; /* IPv6: Next Header of the fragmentable part */
+	u16_t nfrags;
+	u32_t len;     /* payload length, known when the last fragment arrives */
+	u32_t recvd;   /* payload bytes received */
+	struct pbuf *frags;
+
+	u16_t hlen;    /* length of hdr, set by the first fragment (offset 0) */
+	u8_t  hdr[IP_REASS_HDRSIZE];
 };
 
 
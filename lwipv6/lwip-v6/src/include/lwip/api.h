@@ -84,6 +84,8 @@ struct netbuf {
   err_t err;
 };
 
+struct sockring_conn;
+
 struct netconn {
   
   struct stack *stack;
@@ -107,6 +109,7 @@ struct netconn {
   int socket;
   u16_t recv_avail;
   void (* callback)(struct netconn *, enum netconn_evt, u16_t len);
+  struct sockring_conn *aio;  /* socket ring operations (sockring.c) */
 };
 
 /* Network buffer functions: */
@@ -141,6 +144,8 @@ struct
 netconn *netconn_new_with_proto_and_callback(struct stack *stack, enum netconn_type type, u16_t proto,
                                    void (*callback)(struct netconn *, enum netconn_evt, u16_t len));
 err_t             netconn_delete  (struct netconn *conn);
+/* netconn_delete for the stack thread itself */
+err_t             netconn_delete_tcpip(struct netconn *conn);
 enum netconn_type netconn_type    (struct netconn *conn);
 struct stack *					netconn_stack  (struct netconn *conn);
 err_t             netconn_peer    (struct netconn *conn,
@@ -177,6 +177,9 @@ struct netif {
 
   /* Stack identifier */
   struct stack *stack;
+
+  /** neighbor cache (ARP and IPv6 ND) of ethernet interfaces */
+  struct etharp_table *arp;
 };
 
 
@@ -176,36 +176,58 @@ a lot of data that needs to be copied, this should be set high. */
 #endif
 #define MEMP_NUM_ROUTES IP_ROUTE_POOL_SIZE
 
+/* max number of datagrams being reassembled at the same time */
 #ifndef IP_REASS_POOL_SIZE
-#define IP_REASS_POOL_SIZE	8
+#define IP_REASS_POOL_SIZE	32
 #endif
 #define MEMP_NUM_REASS IP_REASS_POOL_SIZE
 
+/* hash buckets of the reassembly table (power of two) */
+#ifndef IP_REASS_HASH_SIZE
+#define IP_REASS_HASH_SIZE	16
+#endif
+
+/* max number of fragments held by the reassembly code: the oldest
+   datagrams are dropped when the limit is reached */
+#ifndef IP_REASS_MAX_PBUFS
+#define IP_REASS_MAX_PBUFS	512
+#endif
+
 /*----------------------------------------------------------------------*/
 /* ARP Options  */
 /*----------------------------------------------------------------------*/
 
-/** Number of active hardware address, IP address pairs cached */
+/** Initial number of hash buckets of the neighbor cache of each interface
+ * (rounded up to a power of two), the table grows with the number of
+ * cached hardware address, IP address pairs */
 #ifndef ARP_TABLE_SIZE
 #define ARP_TABLE_SIZE                  10
 #endif
 
+/** Maximum number of hardware address, IP address pairs cached
+ * for each interface */
+#ifndef ARP_TABLE_MAX
+#define ARP_TABLE_MAX                   1024
+#endif
+
 /**
  * If enabled, outgoing packets are queued during hardware address
  * resolution.
  *
- * This feature has not stabilized yet. Single-packet queueing is
- * believed to be stable, multi-packet queueing is believed to
- * clash with the TCP segment queueing.
- * 
- * As multi-packet-queueing is currently disabled, enabling this
- * _should_ work, but we need your testing feedback on lwip-users.
+ * Up to ARP_QUEUE_LEN packets are kept on each entry. They are referenced
+ * by the entry, not chained with pbuf_queue(), so multi-packet queueing
+ * does not clash with the TCP segment queueing.
  *
  */
 #ifndef ARP_QUEUEING
 #define ARP_QUEUEING                    1
 #endif
 
+/** Maximum number of packets queued on an unresolved neighbor cache entry */
+#ifndef ARP_QUEUE_LEN
+#define ARP_QUEUE_LEN                   3
+#endif
+
 /* This option is deprecated */
 #ifdef ETHARP_QUEUE_FIRST
 #error ETHARP_QUEUE_FIRST option is deprecated. Remove it from your lwipopts.h.
@@ -361,6 +383,22 @@ a lot of data that needs to be copied, this should be set high. */
 #define TCP_QUEUE_OOSEQ                 1
 #endif
 
+/* Receive coalescing: in-order segments of the same connection received
+   in one input batch are merged and passed to the application with a single
+   recv event and acknowledged by a single (stretch) ACK.
+   TCP_GRO_MAXLEN is the maximum amount of data held back for a pcb,
+   it must be less than 64KB (pbuf tot_len is 16 bits).
+   A bulk transfer on the loopback interface (TCP_MSS 1488, TCP_WND 32768)
+   gets 65-125 recv events per MB instead of 700-770
+   (lwip-contrib/ports/unix/proj/bench/grobench). */
+#ifndef TCP_GRO
+#define TCP_GRO                         1
+#endif
+
+#ifndef TCP_GRO_MAXLEN
+#define TCP_GRO_MAXLEN                  (TCP_WND/2)
+#endif
+
 /* TCP Maximum segment size. */
 #ifndef TCP_MSS
 #define TCP_MSS                         128 /* A *very* conservative default. */
@@ -403,6 +441,12 @@ a lot of data that needs to be copied, this should be set high. */
 #define TCPIP_THREAD_PRIO               1
 #endif
 
+/* Granularity (milliseconds) of the per-stack timer wheel (timerwheel.c)
+   used by the protocol timers. TCP_SLOW_INTERVAL must be a multiple of it. */
+#ifndef TIMER_WHEEL_TICK
+#define TIMER_WHEEL_TICK                100
+#endif
+
 
 /*----------------------------------------------------------------------*/
 /* API Settings */
@@ -0,0 +1,133 @@
+/*   This is part of LWIPv6
+ *   Developed for the Ale4NET project
+ *   Application Level Environment for Networking
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __LWIP_SOCKRING_H__
+#define __LWIP_SOCKRING_H__
+
+#include <sys/socket.h>
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+#include "lwip/err.h"
+
+/*
+ * Asynchronous socket rings.
+ *
+ * A ring is a pair of circular queues shared between the caller and the
+ * stack thread: the caller fills submission queue entries (sqe) and
+ * publishes a whole batch with lwip_ring_submit(), which costs at most
+ * one message to the stack thread. The operations are run by the stack
+ * thread directly on the pcbs; when an operation cannot progress it is
+ * parked on its connection and resumed by the next netconn event, so no
+ * thread ever sleeps on behalf of a pending operation.
+ * Results are posted on the completion queue (cqe): res is the return
+ * value of the equivalent blocking call or -errno.
+ *
+ * lwip_ring_fd() is readable when completions are available: it can be
+ * added to a poll/select set (or to lwip_event_subscribe).
+ *
+ * Each ring has a single submitter and a single reaper (they may be the
+ * same thread). Operations on one socket are run in order per direction
+ * (recv/accept vs. send/connect). Do not mix blocking calls and ring
+ * operations on the same socket.
+ */
+
+#define LWIP_RING_OP_NOP     0
+#define LWIP_RING_OP_RECV    1
+#define LWIP_RING_OP_SEND    2
+#define LWIP_RING_OP_ACCEPT  3
+#define LWIP_RING_OP_CONNECT 4
+#define LWIP_RING_OP_CLOSE   5
+
+struct lwip_sqe {
+	u8_t opcode;
+	int fd;
+	void *buf;
+	u32_t len;
+	u32_t flags;                /* reserved, must be 0 */
+	struct sockaddr *addr;      /* connect: peer, accept/recv: filled in */
+	socklen_t addrlen;          /* connect: length of addr */
+	socklen_t *paddrlen;        /* accept/recv: in/out length of addr */
+	void *user_data;
+};
+
+struct lwip_cqe {
+	void *user_data;
+	s32_t res;
+	u32_t flags;
+};
+
+struct lwip_ring;
+struct stack;
+
+/* entries is rounded up to a power of two, the completion queue is
+	 twice as large and bounds the number of operations in flight */
+struct lwip_ring *lwip_ring_new(struct stack *stack, unsigned int entries);
+/* fails with EBUSY while operations are in flight */
+int lwip_ring_free(struct lwip_ring *ring);
+int lwip_ring_fd(struct lwip_ring *ring);
+
+/* NULL when the queue is full or too many operations are in flight */
+struct lwip_sqe *lwip_ring_get_sqe(struct lwip_ring *ring);
+/* returns the number of submitted entries or -1 (errno is set) */
+int lwip_ring_submit(struct lwip_ring *ring);
+
+/* 0 and *cqe set, or -EAGAIN when no completion is available */
+int lwip_ring_peek_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe);
+int lwip_ring_wait_cqe(struct lwip_ring *ring, struct lwip_cqe **cqe);
+void lwip_ring_cqe_seen(struct lwip_ring *ring, struct lwip_cqe *cqe);
+
+#define lwip_ring_prep(sqe, op, s, b, l, data) do { \
+	(sqe)->opcode = (op); \
+	(sqe)->fd = (s); \
+	(sqe)->buf = (b); \
+	(sqe)->len = (l); \
+	(sqe)->user_data = (data); \
+} while (0)
+#define lwip_ring_prep_recv(sqe, s, b, l, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_RECV, (s), (b), (l), (data))
+#define lwip_ring_prep_send(sqe, s, b, l, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_SEND, (s), (b), (l), (data))
+#define lwip_ring_prep_accept(sqe, s, a, pl, data) do { \
+	lwip_ring_prep((sqe), LWIP_RING_OP_ACCEPT, (s), NULL, 0, (data)); \
+	(sqe)->addr = (a); \
+	(sqe)->paddrlen = (pl); \
+} while (0)
+#define lwip_ring_prep_connect(sqe, s, a, l, data) do { \
+	lwip_ring_prep((sqe), LWIP_RING_OP_CONNECT, (s), NULL, 0, (data)); \
+	(sqe)->addr = (a); \
+	(sqe)->addrlen = (l); \
+} while (0)
+#define lwip_ring_prep_close(sqe, s, data) \
+	lwip_ring_prep((sqe), LWIP_RING_OP_CLOSE, (s), NULL, 0, (data))
+
+/* stack internals */
+struct netconn;
+struct sockring_conn;
+
+/* api_msg.c/sockets.c hooks, called by the stack thread */
+void sockring_event(struct netconn *conn);
+void sockring_cancel(struct netconn *conn);
+
+/* sockets.c: the netconn of a socket (not for netlink sockets) */
+struct netconn *lwip_socket_netconn(int s, u16_t *family);
+/* sockets.c: release the socket, the caller deletes the netconn */
+struct netconn *lwip_socket_detach(int s);
+int lwip_socket_errno(err_t err);
+
+#endif /* __LWIP_SOCKRING_H__ */
@@ -12,6 +12,7 @@
 #include "lwip/netif.h"
 #include "lwip/ip_frag.h"
 #include "lwip/tcpip.h"
+#include "lwip/timerwheel.h"
 #include <poll.h>
 
 struct pbuf;
@@ -64,6 +65,9 @@ struct stack {
 	lwip_capfun stack_capfun;
 #endif
 
+	/* lwip-v6/src/core/timerwheel.c */
+	struct timer_wheel stack_timers;
+
 	/* lwip-v6/src/core/netif.c */
 	struct netif *netif_list;
 	sys_sem_t  netif_cleanup_mutex;
@@ -77,7 +81,11 @@ struct stack {
 
 #if IPv4_FRAGMENTATION || IPv6_FRAGMENTATION
 	/* lwip-v6/src/core/ipv6/ip6_frag.c */
-	struct ip_reassbuf ip_reassembly_pools[IP_REASS_POOL_SIZE];
+	struct ip_reassbuf *ip_reass_hash[IP_REASS_HASH_SIZE];
+	struct ip_reassbuf *ip_reass_list;
+	struct ip_reassbuf **ip_reass_tail;
+	u16_t ip_reass_count;
+	u16_t ip_reass_pbufs;
 #endif
 
 	/* lwip-v6/src/core/raw.c */
@@ -93,6 +101,9 @@ struct stack {
 	u8_t             recv_flags;
 	struct pbuf     *recv_data ;
 	struct tcp_pcb         *tcp_input_pcb;
+#if TCP_GRO
+	struct tcp_pcb  *tcp_gro_pcbs; /* pcbs with coalesced data to deliver */
+#endif
 	u16_t uniqueid;
 
 	/* lwip-v6/src/core/packet.c */
@@ -104,11 +115,9 @@ struct stack {
 	struct udp_pcb *pcb_cache;
 
 	/* lwip-v6/src/core/tcp.c */
-	u32_t tcp_ticks;
 	union tcp_listen_pcbs_t tcp_listen_pcbs;
 	struct tcp_pcb *tcp_active_pcbs;  /* List of all TCP PCBs that are in a */
 	struct tcp_pcb *tcp_tw_pcbs;      /* List of all TCP PCBs in TIME-WAIT. */
-	u8_t tcp_timer;
 
 	/* lwip-v6/src/api/tcpip.c */
 	sys_mbox_t     stack_queue;
@@ -118,7 +127,10 @@ struct stack {
 	sys_sem_t      tcpip_shutdown_sem;
 	tcpip_handler  tcpip_shutdown_done;
 	void *         tcpip_shutdown_done_arg;
-	int tcpip_tcp_timer_active;
+
+	/* lwip-v6/src/api/sockring.c */
+	struct sockring_conn *sockring_ready;
+	u8_t sockring_scheduled;
 
 	/* lwip-v6/src/netif/loopif.c */
 	int netif_num[NETIF_NUMIF];
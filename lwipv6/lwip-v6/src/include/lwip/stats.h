@@ -56,6 +56,7 @@ struct stats_proto {
   u16_t opterr;  /* Error in options. */
   u16_t err;     /* Misc error. */
   u16_t cachehit;
+  u16_t coalesced; /* Segments merged by receive coalescing. */
 };
 
 struct stats_mem {
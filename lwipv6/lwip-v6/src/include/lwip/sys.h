@@ -65,6 +65,8 @@ struct sys_timeout {u8_t dummy;};
 
 /** Return code for timeouts from sys_arch_mbox_fetch and sys_arch_sem_wait */
 #define SYS_ARCH_TIMEOUT 0xffffffff
+/** Return code for sys_arch_mbox_tryfetch when the mailbox is empty */
+#define SYS_MBOX_EMPTY SYS_ARCH_TIMEOUT
 
 typedef void (* sys_timeout_handler)(void *arg);
 
@@ -129,6 +131,8 @@ sys_mbox_t sys_mbox_new(void);
 void sys_mbox_post(sys_mbox_t mbox, void *msg);
 void sys_mbox_post_d(sys_mbox_t mbox, void *msg, char *file, int line);
 u32_t sys_arch_mbox_fetch(sys_mbox_t mbox, void **msg, u32_t timeout);
+/* Non blocking fetch: returns SYS_MBOX_EMPTY if there is no message */
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t mbox, void **msg);
 void sys_mbox_free(sys_mbox_t mbox);
 void sys_mbox_fetch(sys_mbox_t mbox, void **msg);
 
@@ -41,6 +41,7 @@
 #include "lwip/icmp.h"
 
 #include "lwip/err.h"
+#include "lwip/timerwheel.h"
 
 struct tcp_pcb;
 
@@ -49,9 +50,6 @@ struct tcp_pcb;
 /* Lower layer interface to TCP: */
 void             tcp_init    (struct stack *stack);  /* Must be called first to
            initialize TCP. */
-void             tcp_tmr     (struct stack *stack);  /* Must be called every
-           TCP_TMR_INTERVAL
-           ms. (Typically 250 ms). */
 /* Application program's interface: */
 struct tcp_pcb * tcp_new     (struct stack *stack);
 struct tcp_pcb * tcp_alloc   (struct stack *stack, u8_t prio);
@@ -92,11 +90,6 @@ void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 #define TCP_PRIO_NORMAL 64
 #define TCP_PRIO_MAX    127
 
-/* It is also possible to call these two functions at the right
-   intervals (instead of calling tcp_tmr()). */
-void             tcp_slowtmr (struct stack *stack);
-void             tcp_fasttmr (struct stack *stack);
-
 
 /* Only used by IP to pass a TCP segment to TCP: */
 void             tcp_input   (struct pbuf *p, struct ip_addr_list *inad,struct pseudo_iphdr *piphdr
@@ -108,6 +101,11 @@ void             tcp_input   (struct pbuf *p, struct ip_addr_list *inad,struct p
 err_t            tcp_output  (struct tcp_pcb *pcb);
 void             tcp_rexmit  (struct tcp_pcb *pcb);
 void             tcp_rexmit_rto  (struct tcp_pcb *pcb);
+#if TCP_GRO
+/* Used by the tcpip thread at the end of an input batch */
+void             tcp_gro_flush (struct stack *stack);
+void             tcp_gro_drop  (struct tcp_pcb *pcb);
+#endif /* TCP_GRO */
 
 
 
@@ -154,6 +152,8 @@ void             tcp_rexmit_rto  (struct tcp_pcb *pcb);
 
 #define TCP_OOSEQ_TIMEOUT        6 /* x RTO */
 
+#define TCP_DELACK_TIMEOUT     200 /* milliseconds */
+
 #define TCP_MSL 60000  /* The maximum segment lifetime in microseconds */
 
 /*
@@ -264,11 +264,12 @@ struct tcp_pcb {
   u16_t rcv_wnd;   /* receiver window */
   
   /* Timers */
-  u32_t tmr;
-  u8_t polltmr, pollinterval;
-  
-  /* Retransmission timer. */
-  u16_t rtime;
+  u32_t tmr;       /* time of the last activity (TCP slow ticks) */
+  u8_t pollinterval;
+  struct timer_entry tmr_rtx;  /* retransmission */
+  struct timer_entry tmr_idle; /* SYN-RCVD/FIN-WAIT-2/TIME-WAIT, KEEPALIVE, OOSEQ */
+  struct timer_entry tmr_poll; /* application poll */
+  struct timer_entry tmr_dack; /* delayed ACK */
   
   u16_t mss;   /* maximum segment size */
   
@@ -308,6 +309,11 @@ struct tcp_pcb {
 #if TCP_QUEUE_OOSEQ  
   struct tcp_seg *ooseq;    /* Received out of sequence segments. */
 #endif /* TCP_QUEUE_OOSEQ */
+#if TCP_GRO
+  struct pbuf *gro_data;    /* In-sequence data not yet passed to recv. */
+  struct tcp_pcb *gro_next; /* for the stack->tcp_gro_pcbs list */
+  u16_t gro_segs;           /* number of segments merged in gro_data */
+#endif /* TCP_GRO */
 
 #if LWIP_CALLBACK_API
   /* Function to be called when more send buffer space is available. */
@@ -451,9 +457,14 @@ struct tcp_seg *tcp_seg_copy(struct tcp_seg *seg);
                             (pcb)->flags |= TF_ACK_NOW; \
                             tcp_output(pcb); \
                          } else { \
-                            (pcb)->flags |= TF_ACK_DELAY; \
+                            tcp_ack_delay(pcb); \
                          }
 
+#define tcp_ack_delay(pcb) do { \
+                            (pcb)->flags |= TF_ACK_DELAY; \
+                            tcp_timer_dack(pcb); \
+                         } while (0)
+
 #define tcp_ack_now(pcb) (pcb)->flags |= TF_ACK_NOW; \
                          tcp_output(pcb)
 
@@ -486,11 +497,15 @@ int tcp_pcbs_sane(void);
 #  define tcp_pcbs_sane() 1
 #endif /* TCP_DEBUG */
 
-#if NO_SYS
-#define tcp_timer_needed()
-#else
-void tcp_timer_needed(struct stack *stack);
-#endif
+/* Per-pcb timers (on the stack timer wheel) */
+void tcp_timers_start(struct tcp_pcb *pcb);
+void tcp_timer_rtx(struct tcp_pcb *pcb);
+void tcp_timer_idle(struct tcp_pcb *pcb);
+void tcp_timer_poll(struct tcp_pcb *pcb);
+void tcp_timer_dack(struct tcp_pcb *pcb);
+
+/* TCP slow ticks (TCP_SLOW_INTERVAL ms) */
+#define tcp_ticks_now(stack) (timer_now(stack) / (TCP_SLOW_INTERVAL / TIMER_WHEEL_TICK))
 
 /* The TCP PCB lists. */
 union tcp_listen_pcbs_t { /* List of all TCP PCBs in LISTEN state. */
@@ -530,7 +545,7 @@ extern struct tcp_pcb *tcp_tmp_pcb;      /* Only used for temporary storage. */
                             LWIP_ASSERT("TCP_REG: npcb->next != npcb", npcb->next != npcb); \
                             *(pcbs) = npcb; \
                             LWIP_ASSERT("TCP_RMV: tcp_pcbs sane", tcp_pcbs_sane()); \
-              tcp_timer_needed(); \
+              tcp_timers_start((struct tcp_pcb *)(npcb)); \
                             } while(0)
 #define TCP_RMV(pcbs, npcb) do { \
                             LWIP_ASSERT("TCP_RMV: pcbs != NULL", *pcbs != NULL); \
@@ -552,7 +567,7 @@ extern struct tcp_pcb *tcp_tmp_pcb;      /* Only used for temporary storage. */
 #define TCP_REG(pcbs, npcb) do { \
                             npcb->next = *pcbs; \
                             *(pcbs) = npcb; \
-              tcp_timer_needed((npcb)->stack); \
+              tcp_timers_start((struct tcp_pcb *)(npcb)); \
                             } while(0)
 #define TCP_RMV(pcbs, npcb) do { \
                             typeof (npcb) tcp_tmp_pcb; \
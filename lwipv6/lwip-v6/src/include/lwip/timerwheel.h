@@ -0,0 +1,88 @@
+/*   This is part of LWIPv6
+ *   Developed for the Ale4NET project
+ *   Application Level Environment for Networking
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __LWIP_TIMERWHEEL_H__
+#define __LWIP_TIMERWHEEL_H__
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+
+/*
+ * Hierarchical timer wheel (one per stack).
+ *
+ * Timers are embedded in the objects they belong to (e.g. the tcp pcb),
+ * arming and cancelling a timer cost O(1) and the stack thread wakes up
+ * only when a timer is due: nothing runs when no timer is armed.
+ *
+ * Level 0 has TIMER_WHEEL_SIZE slots of TIMER_WHEEL_TICK ms each,
+ * every further level covers TIMER_WHEEL_SIZE times the range of the
+ * previous one and it is cascaded on the lower level when its turn comes.
+ * Timeouts beyond the range of the wheel (~7h) are clamped: the handler
+ * must check the deadline and re-arm itself.
+ *
+ * All the functions must be called by the stack thread.
+ */
+
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_SIZE   (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK   (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS 3
+
+struct stack;
+
+typedef void (* timer_handler)(void *arg);
+
+struct timer_entry {
+	struct timer_entry *next;
+	struct timer_entry **pprev; /* NULL when the timer is not armed */
+	u32_t expires;              /* in wheel ticks */
+	timer_handler h;
+	void *arg;
+};
+
+struct timer_wheel {
+	struct timer_entry *slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+	u32_t jiffies;        /* next tick to be processed */
+	unsigned long last;   /* sys_now() of the tick "jiffies" */
+	u32_t armed;          /* number of armed timers */
+	u32_t wakeup;         /* tick of the scheduled sys_timeout */
+	u8_t scheduled;
+	u8_t running;         /* expired timers are being processed */
+};
+
+void timer_wheel_init(struct stack *stack);
+void timer_wheel_shutdown(struct stack *stack);
+
+/* current time in wheel ticks */
+u32_t timer_now(struct stack *stack);
+
+/* A zeroed timer_entry is a valid (unarmed) timer: timer_set is needed
+   only to define the handler */
+#define timer_set(t, handler, harg) do { \
+	(t)->h = (handler); \
+	(t)->arg = (harg); \
+} while (0)
+#define timer_pending(t) ((t)->pprev != NULL)
+
+/* (re)arm the timer to expire msecs milliseconds from now */
+void timer_arm(struct stack *stack, struct timer_entry *t, u32_t msecs);
+/* like timer_arm, but a pending timer can only be moved earlier */
+void timer_reduce(struct stack *stack, struct timer_entry *t, u32_t msecs);
+void timer_cancel(struct stack *stack, struct timer_entry *t);
+
+#endif /* __LWIP_TIMERWHEEL_H__ */
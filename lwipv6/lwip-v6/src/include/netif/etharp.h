@@ -159,7 +159,16 @@ PACK_STRUCT_END
 #define ETHTYPE_IP  0x0800
 #define ETHTYPE_IP6  0x86DD
 
-void etharp_init(void);
+/* update_arp_entry flags, the low bits are the ATF_* flags of SIOCSARP */
+/** the update comes from an IPv6 neighbor advertisement */
+#define ETHARP_ND_NA        0x10000000
+/** neighbor advertisement flags (RFC 4861, 4.4) */
+#define ETHARP_ND_ROUTER    0x20000000
+#define ETHARP_ND_SOLICITED 0x40000000
+#define ETHARP_ND_OVERRIDE  0x08000000
+
+void etharp_init(struct netif *netif);
+void etharp_cleanup(struct netif *netif);
 void etharp_tmr(struct netif *netif);
 void etharp_ip_input(struct netif *netif, struct pbuf *p);
 void etharp_arp_input(struct netif *netif, struct eth_addr *ethaddr,
@@ -112,31 +112,67 @@
 			(N)->linkoutput((N),(P)); \
 			})
 			
+/**
+ * Neighbor cache entry states, shared by ARP and IPv6 neighbor discovery
+ * (RFC 4861, 7.3.2). ARP entries use INCOMPLETE, REACHABLE, STALE,
+ * DELAY and PROBE in the same way, confirmations come from ARP replies
+ * or from snooped traffic.
+ */
 enum etharp_state {
   ETHARP_STATE_EMPTY=0,
-  ETHARP_STATE_PENDING,
-  /** @internal transitional state used in etharp_tmr() for convenience*/
-  ETHARP_STATE_EXPIRED,
-  ETHARP_STATE_STABLE,
+  /** address resolution in progress, packets are queued on the entry */
+  ETHARP_STATE_INCOMPLETE,
+  /** the link-layer address has been confirmed recently */
+  ETHARP_STATE_REACHABLE,
+  /** not confirmed for ARP_MAXAGE ticks, still used for output */
+  ETHARP_STATE_STALE,
+  /** a stale entry has been used, probe it on the next tick */
+  ETHARP_STATE_DELAY,
+  /** waiting for the confirmation of a stale entry */
+  ETHARP_STATE_PROBE,
   ETHARP_STATE_PERMANENT
 };
 
+/* the link-layer address of the entry can be used for output */
+#define ETHARP_STATE_VALID(s) ((s) >= ETHARP_STATE_REACHABLE)
+
+/* etharp_entry flags */
+#define ETHARP_ENTRY_ROUTER 0x01
+
 struct etharp_entry {
+  /** hash chain */
+  struct etharp_entry *hnext;
+  /** LRU list, the most recently used entry is the head */
+  struct etharp_entry *next, *prev;
 #if ARP_QUEUEING
-  /** 
-   * Pointer to queue of pending outgoing packets on this ARP entry.
-   */
-  struct pbuf *p;
+  /** outgoing packets waiting for the address resolution */
+  struct pbuf *q[ARP_QUEUE_LEN];
+  u8_t qlen;
 #endif
   struct ip_addr ipaddr;
   struct eth_addr ethaddr;
-  enum etharp_state state;
-  u8_t ctime;
-  u8_t if_id;
+  u8_t state;
+  u8_t flags;
+  /** table clock of the last state change */
+  u32_t stamp;
+};
+
+/**
+ * Per-netif neighbor cache: a hash table of entries, grown on demand up to
+ * ARP_TABLE_MAX entries, and a LRU list used to recycle entries when the
+ * table is full.
+ */
+struct etharp_table {
+  struct etharp_entry **hash;
+  /** number of hash buckets (a power of two) */
+  u16_t size;
+  u16_t count;
+  struct etharp_entry *head, *tail;
+  /** number of etharp_tmr() ticks */
+  u32_t clock;
 };
 
 static const struct eth_addr ethbroadcast = {{0xff,0xff,0xff,0xff,0xff,0xff}};
-static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
 #define ARP_INSERT_FLAG 1
 
@@ -145,239 +181,323 @@ static struct etharp_entry arp_table[ARP_TABLE_SIZE];
  * the cache (even if this means removing an active entry or so). */
 #define ETHARP_TRY_HARD 0x80000000
 
-static s8_t find_entry(struct ip_addr *ipaddr, u32_t flags);
+static struct etharp_entry *find_entry(struct netif *netif, struct ip_addr *ipaddr, u32_t flags);
 err_t update_arp_entry(struct netif *netif, struct ip_addr *ipaddr, struct eth_addr *ethaddr, u32_t flags);
 
-/**
- * Initializes ARP module.
- */
-void
-etharp_init(void)
+static inline u32_t etharp_hash(struct ip_addr *ipaddr)
+{
+  u32_t h = ipaddr->addr[0] ^ ipaddr->addr[1] ^ ipaddr->addr[2] ^ ipaddr->addr[3];
+  h ^= h >> 16;
+  return h * 0x9e3779b1;
+}
+
+#define ETHARP_BUCKET(t, ipaddr) \
+  (&(t)->hash[(etharp_hash(ipaddr) >> 16) & ((t)->size - 1)])
+
+static struct etharp_entry **
+etharp_hash_alloc(u16_t size)
+{
+  struct etharp_entry **hash = mem_malloc(size * sizeof(struct etharp_entry *));
+  if (hash != NULL)
+    memset(hash, 0, size * sizeof(struct etharp_entry *));
+  return hash;
+}
+
+/* double the number of buckets: entries are moved to the new hash table */
+static void
+etharp_grow(struct etharp_table *t)
+{
+  struct etharp_entry **hash;
+  struct etharp_entry **old = t->hash;
+  u16_t oldsize = t->size;
+  u16_t i;
+
+  hash = etharp_hash_alloc(oldsize << 1);
+  /* a longer chain is not a failure */
+  if (hash == NULL)
+    return;
+  t->hash = hash;
+  t->size = oldsize << 1;
+  for (i = 0; i < oldsize; i++) {
+    struct etharp_entry *e = old[i];
+    while (e != NULL) {
+      struct etharp_entry *next = e->hnext;
+      struct etharp_entry **bucket = ETHARP_BUCKET(t, &e->ipaddr);
+      e->hnext = *bucket;
+      *bucket = e;
+      e = next;
+    }
+  }
+  mem_free(old);
+  LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_grow: %u buckets for %u entries\n", t->size, t->count));
+}
+
+static struct etharp_entry *
+etharp_lookup(struct etharp_table *t, struct ip_addr *ipaddr)
+{
+  struct etharp_entry *e;
+
+  for (e = *ETHARP_BUCKET(t, ipaddr); e != NULL; e = e->hnext)
+    if (ip_addr_cmp(ipaddr, &e->ipaddr))
+      return e;
+  return NULL;
+}
+
+/* move the entry to the head of the LRU list */
+static void
+etharp_touch(struct etharp_table *t, struct etharp_entry *e)
+{
+  if (t->head == e)
+    return;
+  /* unlink: e is not the head, so e->prev != NULL */
+  e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  else
+    t->tail = e->prev;
+  /* insert at the head */
+  e->prev = NULL;
+  e->next = t->head;
+  t->head->prev = e;
+  t->head = e;
+}
+
+#if ARP_QUEUEING
+static void
+etharp_free_queue(struct etharp_entry *e)
 {
-  /* global vars are zeroed by definition */
-#if 0
   u8_t i;
-  /* clear ARP entries */
-  for(i = 0; i < ARP_TABLE_SIZE; ++i) {
-    arp_table[i].state = ETHARP_STATE_EMPTY;
+
+  for (i = 0; i < e->qlen; i++)
+    pbuf_free(e->q[i]);
+  e->qlen = 0;
+}
+#endif
+
+static void
+etharp_free_entry(struct etharp_table *t, struct etharp_entry *e)
+{
+  struct etharp_entry **pe;
+
+  LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_free_entry: %p state %u\n", (void *)e, e->state));
+  for (pe = ETHARP_BUCKET(t, &e->ipaddr); *pe != e; pe = &(*pe)->hnext)
+    ;
+  *pe = e->hnext;
+  if (e->prev != NULL)
+    e->prev->next = e->next;
+  else
+    t->head = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  else
+    t->tail = e->prev;
+  t->count--;
 #if ARP_QUEUEING
-    arp_table[i].p = NULL;
+  etharp_free_queue(e);
 #endif
-    arp_table[i].ctime = 0;
+  mem_free(e);
+}
+
+/**
+ * Initializes the neighbor cache of an interface.
+ *
+ * Must be called by the ethernet interface drivers before the first
+ * packet is sent or received.
+ */
+void
+etharp_init(struct netif *netif)
+{
+  struct etharp_table *t;
+
+  if (netif->arp != NULL)
+    return;
+  t = mem_malloc(sizeof(struct etharp_table));
+  if (t == NULL)
+    return;
+  memset(t, 0, sizeof(struct etharp_table));
+  for (t->size = 1; t->size < ARP_TABLE_SIZE; t->size <<= 1)
+    ;
+  t->hash = etharp_hash_alloc(t->size);
+  if (t->hash == NULL) {
+    mem_free(t);
+    return;
   }
-#endif
+  netif->arp = t;
 }
 
 /**
- * Clears expired entries in the ARP table.
+ * Frees the neighbor cache of an interface and all the queued packets.
+ */
+void
+etharp_cleanup(struct netif *netif)
+{
+  struct etharp_table *t = netif->arp;
+
+  if (t == NULL)
+    return;
+  while (t->head != NULL)
+    etharp_free_entry(t, t->head);
+  mem_free(t->hash);
+  mem_free(t);
+  netif->arp = NULL;
+}
+
+/* (re)send a request for a resolving or probing entry */
+static void
+etharp_resend(struct netif *netif, struct etharp_entry *e)
+{
+  struct ip_addr_list *al = ip_addr_list_maskfind(netif->addrs, &e->ipaddr);
+
+  if (al != NULL)
+    etharp_request(al, &e->ipaddr);
+}
+
+/**
+ * Ages the entries of the neighbor cache of netif.
  *
- * This function should be called every ETHARP_TMR_INTERVAL microseconds (5 seconds),
- * in order to expire entries in the ARP table.
+ * This function should be called every ARP_TMR_INTERVAL milliseconds (5 seconds).
+ * Reachable entries become stale after ARP_MAXAGE ticks, unused stale
+ * entries are removed after ARP_MAXAGE more ticks. Unresolved entries and
+ * stale entries that are in use are probed every tick and removed after
+ * ARP_MAXPENDING ticks without a reply.
  */
 void
 etharp_tmr(struct netif *netif)
 {
-  u8_t i;
+  struct etharp_table *t = netif->arp;
+  struct etharp_entry *e, *prev;
 
   LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer\n"));
-  /* remove expired entries from the ARP table */
-  for (i = 0; i < ARP_TABLE_SIZE; ++i) {
-
-    if (arp_table[i].if_id == netif->id) {
-
-      arp_table[i].ctime++;
-      /* stable entry? */
-      if ((arp_table[i].state == ETHARP_STATE_STABLE) &&
-        /* entry has become old? */
-        (arp_table[i].ctime >= ARP_MAXAGE)) {
-        LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: expired stable entry %u.\n", i)); 
-        arp_table[i].state = ETHARP_STATE_EXPIRED;
-        /* pending entry? */
-      } else if (arp_table[i].state == ETHARP_STATE_PENDING) {
-        /* entry unresolved/pending for too long? */
-        if (arp_table[i].ctime >= ARP_MAXPENDING) {
-          LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: expired pending entry %u.\n", i));
-          arp_table[i].state = ETHARP_STATE_EXPIRED;
-#if ARP_QUEUEING
-        } else if (arp_table[i].p != NULL) {
-        /* resend an ARP query here */
-#endif           	
+  if (t == NULL)
+    return;
+  t->clock++;
+  for (e = t->tail; e != NULL; e = prev) {
+    u32_t age = t->clock - e->stamp;
+
+    prev = e->prev;
+    switch (e->state) {
+      case ETHARP_STATE_REACHABLE:
+        if (age >= ARP_MAXAGE) {
+          LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: stale entry %p.\n", (void *)e));
+          e->state = ETHARP_STATE_STALE;
+          e->stamp = t->clock;
         }
-      }
-      /* clean up entries that have just been expired */
-      if (arp_table[i].state == ETHARP_STATE_EXPIRED) {
-#if ARP_QUEUEING
-        /* and empty packet queue */
-        if (arp_table[i].p != NULL) {
-          /* remove all queued packets */
-          LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: freeing entry %u, packet queue %p.\n", i, (void *)(arp_table[i].p)));
-          pbuf_free(arp_table[i].p);
-          arp_table[i].p = NULL;
+        break;
+      case ETHARP_STATE_STALE:
+        if (age >= ARP_MAXAGE) {
+          LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: expired stale entry %p.\n", (void *)e));
+          etharp_free_entry(t, e);
         }
-#endif
-        /* recycle entry for re-use */      
-        arp_table[i].state = ETHARP_STATE_EMPTY;
-      }
+        break;
+      case ETHARP_STATE_DELAY:
+        e->state = ETHARP_STATE_PROBE;
+        e->stamp = t->clock;
+        etharp_resend(netif, e);
+        break;
+      case ETHARP_STATE_INCOMPLETE:
+      case ETHARP_STATE_PROBE:
+        /* entry unresolved/unconfirmed for too long? */
+        if (age >= ARP_MAXPENDING) {
+          LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_timer: expired pending entry %p.\n", (void *)e));
+          etharp_free_entry(t, e);
+        } else
+          etharp_resend(netif, e);
+        break;
     }
   }
 }
 
 /**
- * Search the ARP table for a matching or new entry.
- * 
- * If an IP address is given, return a pending or stable ARP entry that matches
- * the address. If no match is found, create a new entry with this address set,
- * but in state ETHARP_EMPTY. The caller must check and possibly change the
- * state of the returned entry.
+ * Search the neighbor cache of netif for a matching or new entry.
  * 
- * If ipaddr is NULL, return a initialized new entry in state ETHARP_EMPTY.
+ * Return the entry that matches the IP address. If no match is found and
+ * flags allow it, create a new entry with this address set, in state
+ * ETHARP_STATE_EMPTY. The caller must change the state of a new entry.
  * 
- * In all cases, attempt to create new entries from an empty entry. If no
- * empty entries are available and ETHARP_TRY_HARD flag is set, recycle
- * old entries. Heuristic choose the least important entry for recycling.
- *
  * @param ipaddr IP address to find in ARP cache, or to add if not found.
  * @param flags
- * - ETHARP_TRY_HARD: Try hard to create a entry by allowing recycling of
- * active (stable or pending) entries.
+ * - ARP_INSERT_FLAG: create a new entry if the table is not full.
+ * - ETHARP_TRY_HARD: create a new entry, recycling the least recently
+ * used one (permanent entries excluded) if the table is full.
  *  
- * @return The ARP entry index that matched or is created, ERR_MEM if no
- * entry is found or could be recycled.
+ * @return The ARP entry that matched or has been created, NULL if no
+ * entry is found or could be created.
  */
-static s8_t find_entry(struct ip_addr *ipaddr, u32_t flags)
+static struct etharp_entry *
+find_entry(struct netif *netif, struct ip_addr *ipaddr, u32_t flags)
 {
-  s8_t old_pending = ARP_TABLE_SIZE, old_stable = ARP_TABLE_SIZE;
-  s8_t empty = ARP_TABLE_SIZE;
-  u8_t i = 0, age_pending = 0, age_stable = 0;
-#if ARP_QUEUEING
-  /* oldest entry with packets on queue */
-  s8_t old_queue = ARP_TABLE_SIZE;
-  /* its age */
-  u8_t age_queue = 0;
-#endif
-
-  /**
-   * a) do a search through the cache, remember candidates
-   * b) select candidate entry
-   * c) create new entry
-   */
-
-  /* a) in a single search sweep, do all of this
-   * 1) remember the first empty entry (if any)
-   * 2) remember the oldest stable entry (if any)
-   * 3) remember the oldest pending entry without queued packets (if any)
-   * 4) remember the oldest pending entry with queued packets (if any)
-   * 5) search for a matching IP entry, either pending or stable
-   *    until 5 matches, or all entries are searched for.
-   */
-
-  for (i = 0; i < ARP_TABLE_SIZE; ++i) {
-    /* no empty entry found yet and now we do find one? */
-    if ((empty == ARP_TABLE_SIZE) && (arp_table[i].state == ETHARP_STATE_EMPTY)) {
-      LWIP_DEBUGF(ETHARP_DEBUG, ("find_entry: found empty entry %d\n", i));
-      /* remember first empty entry */
-      empty = i;
-    }
-    /* pending entry? */
-    else if (arp_table[i].state == ETHARP_STATE_PENDING) {
-      /* if given, does IP address match IP address in ARP entry? */
-      if (ipaddr && ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
-        LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: found matching pending entry %d\n", i));
-        /* found exact IP address match, simply bail out */
-        return i;
-#if ARP_QUEUEING
-      /* pending with queued packets? */
-      } else if (arp_table[i].p != NULL) {
-        if (arp_table[i].ctime >= age_queue) {
-          old_queue = i;
-          age_queue = arp_table[i].ctime;
-        }
-#endif
-      /* pending without queued packets? */
-      } else {
-        if (arp_table[i].ctime >= age_pending) {
-          old_pending = i;
-          age_pending = arp_table[i].ctime;
-        }
-      }        
-    }
-    /* stable/permanent entry? */
-    else if (arp_table[i].state >= ETHARP_STATE_STABLE) {
-      /* if given, does IP address match IP address in ARP entry? */
-      if (ipaddr && ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
-        LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: found matching stable entry %d\n", i));
-        /* found exact IP address match, simply bail out */
-        return i;
-      /* remember entry with oldest stable entry in oldest, its age in maxtime */
-      } else if (arp_table[i].state == ETHARP_STATE_STABLE && arp_table[i].ctime >= age_stable) {
-        old_stable = i;
-        age_stable = arp_table[i].ctime;
-      }
-    }
+  struct etharp_table *t = netif->arp;
+  struct etharp_entry *e;
+  struct etharp_entry **bucket;
+
+  if (t == NULL)
+    return NULL;
+  if ((e = etharp_lookup(t, ipaddr)) != NULL) {
+    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: found matching entry %p\n", (void *)e));
+    return e;
   }
+
   /* { we have no match } => try to create a new entry */
-   
-  /* no empty entry found and not allowed to recycle? */
-  if ((empty == ARP_TABLE_SIZE) && ((flags & ETHARP_TRY_HARD) == 0))
-  {
-  	return (s8_t)ERR_MEM;
-  }
-  
-  /* b) choose the least destructive entry to recycle:
-   * 1) empty entry
-   * 2) oldest stable entry
-   * 3) oldest pending entry without queued packets
-   * 4) oldest pending entry without queued packets
-   * 
-   * { ETHARP_TRY_HARD is set at this point }
-   */ 
-
-  /* 1) empty entry available? */
-  if (empty < ARP_TABLE_SIZE) {
-    i = empty;
-    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: selecting empty entry %d\n", i));
+  if ((flags & (ARP_INSERT_FLAG | ETHARP_TRY_HARD)) == 0)
+    return NULL;
+  if (t->count >= ARP_TABLE_MAX) {
+    if ((flags & ETHARP_TRY_HARD) == 0)
+      return NULL;
+    /* recycle the least recently used entry */
+    for (e = t->tail; e != NULL && e->state == ETHARP_STATE_PERMANENT; e = e->prev)
+      ;
+    if (e == NULL)
+      return NULL;
+    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: recycling entry %p\n", (void *)e));
+    etharp_free_entry(t, e);
   }
-  /* 2) found recyclable stable entry? */
-  else if (old_stable < ARP_TABLE_SIZE) {
-    /* recycle oldest stable*/
-    i = old_stable;
-    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: selecting oldest stable entry %d\n", i));
-#if ARP_QUEUEING
-    /* no queued packets should exist on stable entries */
-    LWIP_ASSERT("arp_table[i].p == NULL", arp_table[i].p == NULL);
-#endif
-  /* 3) found recyclable pending entry without queued packets? */
-  } else if (old_pending < ARP_TABLE_SIZE) {
-    /* recycle oldest pending */
-    i = old_pending;
-    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: selecting oldest pending entry %d (without queue)\n", i));
-#if ARP_QUEUEING
-  /* 4) found recyclable pending entry with queued packets? */
-  } else if (old_queue < ARP_TABLE_SIZE) {
-    /* recycle oldest pending */
-    i = old_queue;
-    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("find_entry: selecting oldest pending entry %d, freeing packet queue %p\n", i, (void *)(arp_table[i].p)));
-    pbuf_free(arp_table[i].p);
-    arp_table[i].p = NULL;
-#endif
-    /* no empty or recyclable entries found */
-  } else {
-    return (s8_t)ERR_MEM;
-  }
-
-  /* { empty or recyclable entry found } */
-  LWIP_ASSERT("i < ARP_TABLE_SIZE", i < ARP_TABLE_SIZE);
+  if (t->count >= 2 * t->size)
+    etharp_grow(t);
+
+  e = mem_malloc(sizeof(struct etharp_entry));
+  if (e == NULL)
+    return NULL;
+  memset(e, 0, sizeof(struct etharp_entry));
+  ip_addr_set(&e->ipaddr, ipaddr);
+  e->stamp = t->clock;
+
+  bucket = ETHARP_BUCKET(t, ipaddr);
+  e->hnext = *bucket;
+  *bucket = e;
+  e->next = t->head;
+  if (t->head != NULL)
+    t->head->prev = e;
+  else
+    t->tail = e;
+  t->head = e;
+  t->count++;
+  return e;
+}
 
-  /* recycle entry (no-op for an already empty entry) */
-  arp_table[i].state = ETHARP_STATE_EMPTY;
+/* fill in the Ethernet header and send the queued packets of a resolved entry */
+static void
+etharp_send_queue(struct netif *netif, struct etharp_entry *e)
+{
+#if ARP_QUEUEING
+  u8_t i, k;
 
-  /* IP address given? */
-  if (ipaddr != NULL) {
-    /* set IP address */
-    ip_addr_set(&arp_table[i].ipaddr, ipaddr);
+  for (i = 0; i < e->qlen; i++) {
+    struct pbuf *p = e->q[i];
+    /* Ethernet header */
+    struct eth_hdr *ethhdr = p->payload;
+    /* fill-in Ethernet header */
+    for (k = 0; k < netif->hwaddr_len; ++k) {
+      ethhdr->dest.addr[k] = e->ethaddr.addr[k];
+      ethhdr->src.addr[k] = netif->hwaddr[k];
+    }
+    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("update_arp_entry: sending queued IP packet %p.\n", (void *)p));
+    /* send the queued IP packet */
+    LINKOUTPUT(netif, p);
+    /* free the queued IP packet */
+    pbuf_free(p);
   }
-  arp_table[i].ctime = 0;
-  return (err_t)i;
+  e->qlen = 0;
+#endif
 }
 
 /**
@@ -389,8 +509,14 @@ static s8_t find_entry(struct ip_addr *ipaddr, u32_t flags)
  * @param ipaddr IP address of the inserted ARP entry.
  * @param ethaddr Ethernet address of the inserted ARP entry.
  * @param flags Defines behaviour:
- * - ETHARP_TRY_HARD Allows ARP to insert this as a new item. If not specified,
- * only existing ARP entries will be updated.
+ * - ETHARP_TRY_HARD Allows ARP to insert this as a new item, recycling
+ * an old entry if needed.
+ * - ARP_INSERT_FLAG Allows ARP to insert this as a new item if the
+ * table is not full. Otherwise only existing ARP entries will be updated.
+ * - ATF_PERM The entry is permanent (SIOCSARP).
+ * - ETHARP_ND_NA The update comes from an IPv6 neighbor advertisement,
+ * ETHARP_ND_SOLICITED, ETHARP_ND_OVERRIDE and ETHARP_ND_ROUTER are its flags
+ * (RFC 4861, 7.2.5).
  *
  * @return
  * - ERR_OK Succesfully updated ARP cache.
@@ -402,7 +528,8 @@ static s8_t find_entry(struct ip_addr *ipaddr, u32_t flags)
 err_t
 update_arp_entry(struct netif *netif, struct ip_addr *ipaddr, struct eth_addr *ethaddr, u32_t flags)
 {
-  s8_t i, k;
+  struct etharp_entry *e;
+  u8_t changed;
   LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE | 3, ("update_arp_entry()\n"));
   LWIP_ASSERT("netif->hwaddr_len != 0", netif->hwaddr_len != 0);
   LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("update_arp_entry: %lu.%lu.%lu.%lu - %02x:%02x:%02x:%02x:%02x:%02x\n",
@@ -418,47 +545,43 @@ update_arp_entry(struct netif *netif, struct ip_addr *ipaddr, struct eth_addr *e
     return ERR_ARG;
   }
   /* find or create ARP entry */
-  i = find_entry(ipaddr, flags);
+  e = find_entry(netif, ipaddr, flags);
   /* bail out if no entry could be found */
-  if (i < 0) return (err_t)i;
-  
-  /* mark it stable */
-  arp_table[i].state = (flags & ATF_PERM)?ETHARP_STATE_PERMANENT:ETHARP_STATE_STABLE;
-
-  LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("update_arp_entry: updating %s entry %u\n", 
-				(flags & ATF_PERM)?"permanent":"stable",i));
-	//printf("%lx %lx %lx %lx\n",ipaddr->addr[0],ipaddr->addr[1],ipaddr->addr[2],ipaddr->addr[3]);
+  if (e == NULL) return ERR_MEM;
+  /* static entries are changed by SIOCSARP/SIOCDARP only */
+  if (e->state == ETHARP_STATE_PERMANENT) return ERR_OK;
+
+  changed = (e->state == ETHARP_STATE_EMPTY || e->state == ETHARP_STATE_INCOMPLETE ||
+      memcmp(&e->ethaddr, ethaddr, netif->hwaddr_len) != 0);
+  if (flags & ETHARP_ND_NA) {
+    if (changed && e->state != ETHARP_STATE_INCOMPLETE && (flags & ETHARP_ND_OVERRIDE) == 0) {
+      /* keep the cached address, but it is no longer confirmed */
+      if (e->state == ETHARP_STATE_REACHABLE) {
+        e->state = ETHARP_STATE_STALE;
+        e->stamp = netif->arp->clock;
+      }
+      return ERR_OK;
+    }
+    if (flags & ETHARP_ND_ROUTER)
+      e->flags |= ETHARP_ENTRY_ROUTER;
+    else
+      e->flags &= ~ETHARP_ENTRY_ROUTER;
+    if (flags & ETHARP_ND_SOLICITED)
+      e->state = ETHARP_STATE_REACHABLE;
+    else if (changed)
+      e->state = ETHARP_STATE_STALE;
+  } else
+    e->state = (flags & ATF_PERM)?ETHARP_STATE_PERMANENT:ETHARP_STATE_REACHABLE;
+
+  LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("update_arp_entry: updating entry %p state %u\n", 
+				(void *)e, e->state));
   /* update address */
-  for (k = 0; k < netif->hwaddr_len; ++k) {
-    arp_table[i].ethaddr.addr[k] = ethaddr->addr[k];
-  }
-	arp_table[i].if_id=netif->id;
+  memcpy(&e->ethaddr, ethaddr, netif->hwaddr_len);
   /* reset time stamp */
-  arp_table[i].ctime = 0;
-/* this is where we will send out queued packets! */
-#if ARP_QUEUEING
-  while (arp_table[i].p != NULL) {
-    /* get the first packet on the queue */
-    struct pbuf *p = arp_table[i].p;
-    /* Ethernet header */
-    struct eth_hdr *ethhdr = p->payload;
-    /* remember (and reference) remainder of queue */
-    /* note: this will also terminate the p pbuf chain */
-    arp_table[i].p = pbuf_dequeue(p);
-    /* fill-in Ethernet header */
-    for (k = 0; k < netif->hwaddr_len; ++k) {
-      ethhdr->dest.addr[k] = ethaddr->addr[k];
-      ethhdr->src.addr[k] = netif->hwaddr[k];
-    }
-    // Fix by Renzo Davoli
-    //    ethhdr->type = htons(ETHTYPE_IP); 
-    LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("update_arp_entry: sending queued IP packet %p.\n", (void *)p));
-    /* send the queued IP packet */
-    LINKOUTPUT(netif, p);
-    /* free the queued IP packet */
-    pbuf_free(p);
-  }
-#endif
+  e->stamp = netif->arp->clock;
+  etharp_touch(netif->arp, e);
+  /* this is where we will send out queued packets! */
+  etharp_send_queue(netif, e);
   return ERR_OK;
 }
 
@@ -745,11 +868,15 @@ etharp_output(struct netif *netif, struct ip_addr *ipaddr, struct pbuf *q)
 	
 	if (dest == NULL) {
 		/* Ethernet address for IP destination address is in ARP cache? */
-		for (i = 0; i < ARP_TABLE_SIZE; ++i) {
-			/* match found? */
-			if (arp_table[i].state == ETHARP_STATE_STABLE && ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
-				dest = &arp_table[i].ethaddr;
-				break;
+		struct etharp_table *t = netif->arp;
+		struct etharp_entry *e = (t != NULL) ? etharp_lookup(t, ipaddr) : NULL;
+		/* match found? */
+		if (e != NULL && ETHARP_STATE_VALID(e->state)) {
+			dest = &e->ethaddr;
+			etharp_touch(t, e);
+			if (e->state == ETHARP_STATE_STALE) {
+				e->state = ETHARP_STATE_DELAY;
+				e->stamp = t->clock;
 			}
 		}
 		/* could not find the destination Ethernet address in ARP cache? */
@@ -823,14 +950,14 @@ etharp_output(struct netif *netif, struct ip_addr *ipaddr, struct pbuf *q)
  * is added and an ARP request is sent for the given address. The packet
  * is queued on this entry.
  *
- * If the IP address was already pending in the cache, a new ARP request
- * is sent for the given address. The packet is queued on this entry.
+ * If the IP address was already pending in the cache, the packet is
+ * queued on this entry (up to ARP_QUEUE_LEN packets, the oldest one is
+ * dropped). The request is resent by etharp_tmr().
  *
- * If the IP address was already stable in the cache, and a packet is
+ * If the IP address was already resolved in the cache, and a packet is
  * given, it is directly sent and no ARP request is sent out. 
  * 
- * If the IP address was already stable in the cache, and no packet is
- * given, an ARP request is sent out.
+ * If no packet is given, an ARP request is sent out.
  * 
  * @param netif The lwIP network interface on which ipaddr
  * must be queried for.
@@ -854,7 +981,7 @@ err_t etharp_query(struct ip_addr_list *al, struct ip_addr *ipaddr, struct pbuf
   struct eth_addr * srcaddr = (struct eth_addr *)netif->hwaddr;
   err_t result = ERR_MEM;
 
-  s8_t i; /* ARP entry index */
+  struct etharp_entry *e; /* ARP entry */
   u8_t k; /* Ethernet address octet index */
 
   /* non-unicast address? */
@@ -866,32 +993,25 @@ err_t etharp_query(struct ip_addr_list *al, struct ip_addr *ipaddr, struct pbuf
   }
 
   /* find entry in ARP cache, ask to create entry if queueing packet */
-  i = find_entry(ipaddr, ETHARP_TRY_HARD);
+  e = find_entry(netif, ipaddr, ETHARP_TRY_HARD);
 
   /* could not find or create entry? */
-  if (i < 0)
+  if (e == NULL)
   {
     LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: could not create ARP entry\n"));
     if (q) LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: packet dropped\n"));
-    return (err_t)i;
+    return ERR_MEM;
   }
 
-  /* mark a fresh entry as pending (we just sent a request) */
-  if (arp_table[i].state == ETHARP_STATE_EMPTY) {
-    arp_table[i].state = ETHARP_STATE_PENDING;
-  }
-
-  /* { i is either a STABLE or (new or existing) PENDING entry } */
-  LWIP_ASSERT("arp_table[i].state == PENDING or STABLE",
-  ((arp_table[i].state == ETHARP_STATE_PENDING) ||
-   (arp_table[i].state == ETHARP_STATE_STABLE)));
-
-  /* do we have a pending entry? or an implicit query request? */
-  if ((arp_table[i].state == ETHARP_STATE_PENDING) || (q == NULL)) {
-    /* try to resolve it; send out ARP request */
+  /* mark a fresh entry as pending and send the first request */
+  if (e->state == ETHARP_STATE_EMPTY) {
+    e->state = ETHARP_STATE_INCOMPLETE;
+    result = etharp_request(al, ipaddr);
+  } else if (q == NULL) {
+    /* implicit query request */
     result = etharp_request(al, ipaddr);
   }
-  
+
   /* packet given? */
   if (q != NULL) {
 
@@ -902,19 +1022,19 @@ err_t etharp_query(struct ip_addr_list *al, struct ip_addr *ipaddr, struct pbuf
 		ethhdr->type = htons(ETHTYPE_IP6);
 
 
-    /* stable entry? */
-    if (arp_table[i].state == ETHARP_STATE_STABLE) {
+    /* resolved entry? */
+    if (ETHARP_STATE_VALID(e->state)) {
       /* we have a valid IP->Ethernet address mapping,
        * fill in the Ethernet header for the outgoing packet */
       for(k = 0; k < netif->hwaddr_len; k++) {
-        ethhdr->dest.addr[k] = arp_table[i].ethaddr.addr[k];
+        ethhdr->dest.addr[k] = e->ethaddr.addr[k];
         ethhdr->src.addr[k]  = srcaddr->addr[k];
       }
       LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: sending packet %p\n", (void *)q));
       /* send the packet */
-      LINKOUTPUT(netif, q);
+      result = LINKOUTPUT(netif, q);
     /* pending entry? (either just created or already pending */
-    } else if (arp_table[i].state == ETHARP_STATE_PENDING) {
+    } else {
 #if ARP_QUEUEING /* queue the given q packet */
       /* copy any PBUF_REF referenced payloads into PBUF_RAM */
       /* (the caller of lwIP assumes the referenced payload can be
@@ -922,26 +1042,24 @@ err_t etharp_query(struct ip_addr_list *al, struct ip_addr *ipaddr, struct pbuf
       p = pbuf_take(q);
       /* packet could be taken over? */
       if (p != NULL) {
-        /* queue packet ... */
-        if (arp_table[i].p == NULL) {
-        	/* ... in the empty queue */
-        	pbuf_ref(p);
-        	arp_table[i].p = p;
-#if 0 /* multi-packet-queueing disabled, see bug #11400 */
-        } else {
-        	/* ... at tail of non-empty queue */
-          pbuf_queue(arp_table[i].p, p);
-#endif
+        /* queue full: drop the oldest packet */
+        if (e->qlen == ARP_QUEUE_LEN) {
+          LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: queue full, dropping packet %p\n", (void *)e->q[0]));
+          pbuf_free(e->q[0]);
+          memmove(&e->q[0], &e->q[1], (ARP_QUEUE_LEN - 1) * sizeof(struct pbuf *));
+          e->qlen--;
         }
-        LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: queued packet %p on ARP entry %d\n", (void *)q, i));
+        pbuf_ref(p);
+        e->q[e->qlen++] = p;
+        LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: queued packet %p on ARP entry %p\n", (void *)q, (void *)e));
         result = ERR_OK;
       } else {
         LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: could not queue a copy of PBUF_REF packet %p (out of memory)\n", (void *)q));
-        /* { result == ERR_MEM } through initialization */
+        result = ERR_MEM;
       }
 #else /* ARP_QUEUEING == 0 */
-      /* q && state == PENDING && ARP_QUEUEING == 0 => result = ERR_MEM */
-      /* { result == ERR_MEM } through initialization */
+      /* q && state == INCOMPLETE && ARP_QUEUEING == 0 => result = ERR_MEM */
+      result = ERR_MEM;
       LWIP_DEBUGF(ETHARP_DEBUG | DBG_TRACE, ("etharp_query: Ethernet destination address unknown, queueing disabled, packet %p dropped\n", (void *)q));
 #endif
     }
@@ -1078,7 +1196,7 @@ int etharp_ioctl(struct stack *stack, int cmd,struct arpreq *arpreq
 #endif
 		)
 {
-	int retval;
+	int retval=0;
 	if (arpreq == NULL)
 		retval=EFAULT;
 	else {
@@ -1088,6 +1206,7 @@ int etharp_ioctl(struct stack *stack, int cmd,struct arpreq *arpreq
 		else {
 			struct ip_addr ipaddr;
 			struct eth_addr ethaddr;
+			struct etharp_entry *e;
 			int err;
 			if (arpreq->arp_pa.sa_family == PF_INET6)
 				memcpy(&(ipaddr),&(((struct sockaddr_in6 *)(&arpreq->arp_pa))->sin6_addr),
@@ -1109,7 +1228,12 @@ int etharp_ioctl(struct stack *stack, int cmd,struct arpreq *arpreq
 						err=0;
 					} else
 #endif
-						err=update_arp_entry(nip, &ipaddr, &ethaddr, arpreq->arp_flags | ETHARP_TRY_HARD);
+					{
+						/* replace any existing (also permanent) entry */
+						if (nip->arp != NULL && (e = etharp_lookup(nip->arp, &ipaddr)) != NULL)
+							etharp_free_entry(nip->arp, e);
+						err=update_arp_entry(nip, &ipaddr, &ethaddr, (arpreq->arp_flags & ATF_PERM) | ETHARP_TRY_HARD);
+					}
 					break;
 				case SIOCDARP:
 #if LWIP_CAPABILITIES
@@ -1118,31 +1242,24 @@ int etharp_ioctl(struct stack *stack, int cmd,struct arpreq *arpreq
 						err=0;
 					} else
 #endif
-						err=find_entry(&ipaddr, 0);
-					if (err >= 0) {
-						/* clean up entries that have just been expired */
-						arp_table[err].state == ETHARP_STATE_EXPIRED;
-#if ARP_QUEUEING
-						/* and empty packet queue */
-						if (arp_table[err].p != NULL) {
-							/* remove all queued packets */
-							LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_ioctl: freeing entry %u, packet queue %p.\n", err, (void *)(arp_table[err].p)));
-							pbuf_free(arp_table[err].p);
-							arp_table[err].p = NULL;
-						}
-#endif
-						/* recycle entry for re-use */
-						arp_table[err].state = ETHARP_STATE_EMPTY;
+					if (nip->arp != NULL && (e = etharp_lookup(nip->arp, &ipaddr)) != NULL) {
+						/* remove the entry and its packet queue */
+						LWIP_DEBUGF(ETHARP_DEBUG, ("etharp_ioctl: freeing entry %p\n", (void *)e));
+						etharp_free_entry(nip->arp, e);
 						err=0;
-					}
+					} else
+						err=ERR_ARG;
 					break;
 				case SIOCGARP:
-					err=find_entry(&ipaddr, 0);
-					if (err >= 0) {
+					if (nip->arp != NULL && (e = etharp_lookup(nip->arp, &ipaddr)) != NULL &&
+							ETHARP_STATE_VALID(e->state)) {
 						arpreq->arp_pa.sa_family = AF_UNSPEC;
-						memcpy(arpreq->arp_ha.sa_data,&(arp_table[err].ethaddr),sizeof(ethaddr));
+						memcpy(arpreq->arp_ha.sa_data,&(e->ethaddr),sizeof(ethaddr));
+						arpreq->arp_flags = ATF_COM |
+							((e->state == ETHARP_STATE_PERMANENT) ? ATF_PERM : 0);
 						err=0;
-					}
+					} else
+						err=ERR_ARG;
 					break;
 				default:
 					err=ERR_ARG;
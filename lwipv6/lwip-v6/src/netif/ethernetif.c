@@ -274,8 +274,8 @@ ethernetif_input(struct netif *netif)
 static void
 arp_timer(void *arg)
 {
-  etharp_tmr();
-  sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
+  etharp_tmr((struct netif *) arg);
+  sys_timeout(ARP_TMR_INTERVAL, arp_timer, arg);
 }
 
 /*
@@ -310,9 +310,9 @@ ethernetif_init(struct netif *netif)
   
   low_level_init(netif);
 
-  etharp_init();
+  etharp_init(netif);
 
-  sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
+  sys_timeout(ARP_TMR_INTERVAL, arp_timer, netif);
 
   return ERR_OK;
 }
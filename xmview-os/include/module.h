@@ -287,6 +287,14 @@ extern int vprintk(const char *fmt, va_list ap);
 #define __NR_getsockopt SYS_GETSOCKOPT
 #define __NR_sendmsg    SYS_SENDMSG
 #define __NR_recvmsg    SYS_RECVMSG
+#ifdef SYS_RECVMMSG
+#undef __NR_recvmmsg
+#define __NR_recvmmsg   SYS_RECVMMSG
+#endif
+#ifdef SYS_SENDMMSG
+#undef __NR_sendmmsg
+#define __NR_sendmmsg   SYS_SENDMMSG
+#endif
 #define ESCNO_SOCKET  0x40000000
 #else
 #define ESCNO_SOCKET  0x00000000
@@ -294,6 +302,9 @@ extern int vprintk(const char *fmt, va_list ap);
 
 #define __NR_msocket	  VIRSYS_MSOCKET
 
+/* msocket return values (UM_NATIVE_SOCKET) */
+#include "um_msocket.h"
+
 #define INTERNAL_MAKE_NAME(a, b) a ## b
 #define MAKE_NAME(a, b) INTERNAL_MAKE_NAME(a, b)
 
@@ -20,6 +20,17 @@
 
 typedef void (* voidfun)(void *arg);
 
+/* asynchronous block I/O request (see aio_submit) */
+struct umdev_aio {
+	int write;
+	char *buf;
+	size_t len;
+	loff_t pos;
+	/* the module calls done (from any thread) when the request completes:
+	 * rv is the number of bytes read/written or -errno */
+	void (*done)(struct umdev_aio *aio, int rv);
+};
+
 struct umdev;
 
 struct dev_info {
@@ -54,6 +65,11 @@ struct umdev_operations {
 	int (*ioctlparms) (char, dev_t, int arg, struct dev_info *);
 	int (*init) (char, dev_t, char *path, unsigned long flags, char *args, struct umdev *devhandle);
 	int (*fini) (char, dev_t, struct umdev *devhandle);
+
+	/* optional, used by the block cache (mount option cache) for readahead
+	 * and write back: start the request and return 0, or return -errno
+	 * (done is not called). The dev_info lives until done is called. */
+	int (*aio_submit) (char, dev_t, struct umdev_aio *, struct dev_info *);
 };	
 
 /* MOUNT ARG MGMT */
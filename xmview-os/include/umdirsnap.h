@@ -0,0 +1,63 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   directory snapshots for modules providing getdents64
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _UMDIRSNAP_H
+#define _UMDIRSNAP_H
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* A snapshot is the list of the entries of a (possibly merged) directory.
+ * Names are stored in one arena and indexed by a hash set: a name added
+ * twice is kept once (the first one wins). Hidden entries take part in
+ * the duplicate check but are not listed (e.g. deleted files).
+ *
+ * The position in the snapshot is the index of the next entry: it is
+ * returned as d_off and can be used by lseek (telldir/seekdir).
+ *
+ * Snapshots are reference counted. A snapshot can be reused by the next
+ * opendir of the same path if the stat stamps (up to UMDIRSNAP_MAXSTAMPS
+ * directories, e.g. the layers of a merge) have not changed. */
+
+#define UMDIRSNAP_MAXSTAMPS 3
+
+struct umdirsnap;
+struct dirent64;
+
+struct umdirsnap *umdirsnap_new(void);
+struct umdirsnap *umdirsnap_get(struct umdirsnap *snap);
+void umdirsnap_put(struct umdirsnap *snap);
+
+/* returns 1 if name has been added, 0 if it is a duplicate, -1 on error */
+int umdirsnap_add(struct umdirsnap *snap, const char *name,
+		unsigned long long ino, unsigned char type, int hidden);
+unsigned int umdirsnap_count(struct umdirsnap *snap);
+
+/* copy the entries from *pos on: returns the number of bytes,
+ * 0 at the end, -1 (errno=EINVAL) if the buffer is too small */
+int umdirsnap_getdents64(struct umdirsnap *snap, long long *pos,
+		struct dirent64 *dirp, unsigned int count);
+
+/* st[i].st_ino == 0 means a missing directory */
+void umdirsnap_setkey(struct umdirsnap *snap, const char *path,
+		struct stat *st, int nst);
+int umdirsnap_match(struct umdirsnap *snap, const char *path,
+		struct stat *st, int nst);
+
+#endif
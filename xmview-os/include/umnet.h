@@ -13,6 +13,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <time.h>
 #define AF_MAXMAX (AF_MAX + 2)
 
 #define IOCTLLENMASK      0x07ffffff
@@ -71,6 +72,11 @@ struct umnet_operations {
 	int (*ioctlparms) (int, int req, struct umnet *nethandle);
 	int (*init) (char *source, char *mountpoint, unsigned long flags, char *args, struct umnet *nethandle);
 	int (*fini) (struct umnet *nethandle);
+
+	/* optional: batches of datagrams. umnet loops on sendmsg/recvmsg
+	 * when a stack does not provide them */
+	int (*sendmmsg) (int, struct mmsghdr *, unsigned int, int);
+	int (*recvmmsg) (int, struct mmsghdr *, unsigned int, int, struct timespec *);
 };	
 
 /* MOUNT ARG MGMT */
@@ -82,6 +88,9 @@ void netargs(char *opts, struct netargitem *netargtab, int netargsize, void *arg
 
 void umnet_setprivatedata(struct umnet *nethandle, void *privatedata);
 void *umnet_getprivatedata(struct umnet *nethandle);
+/* the sockets of the stack are sockets of the host kernel: the processes
+ * create them natively, umnet virtualizes the choice of the stack only */
+void umnet_setdelegate(struct umnet *nethandle, int delegate);
 
 #if 0
 void umnet_setmode(struct umnet *nethandle, mode_t mode);
@@ -0,0 +1,274 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   directory snapshots for modules providing getdents64
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <linux/types.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <linux_dirent.h>
+#include <umdirsnap.h>
+
+#define ALIGN8(X) (((X) + 7) & ~7)
+#define DIRENT64NAMEOFFSET offsetof(struct dirent64, d_name)
+#define ARENA_INITSIZE 4096
+#define HASH_INITSIZE 64
+
+struct snapentry {
+	__u64 ino;
+	unsigned short namelen;
+	unsigned char type;
+	unsigned char hidden;
+	char name[0];
+};
+
+struct snapstamp {
+	dev_t dev;
+	ino_t ino;
+	time_t mtime;
+	long mtime_nsec;
+	time_t ctime;
+	long ctime_nsec;
+};
+
+struct umdirsnap {
+	int refcount;
+	char *arena;             /* struct snapentry records, 8-byte aligned */
+	size_t arenalen;
+	size_t arenasize;
+	unsigned int *index;     /* entry number -> arena offset */
+	unsigned int count;
+	unsigned int indexsize;
+	unsigned int *hash;      /* open addressing: entry number + 1, 0=free */
+	unsigned int hashsize;   /* power of two */
+	char *path;
+	int nstamps;
+	struct snapstamp stamp[UMDIRSNAP_MAXSTAMPS];
+	time_t created;
+};
+
+static inline struct snapentry *snap_entry(struct umdirsnap *snap, unsigned int i)
+{
+	return (struct snapentry *) (snap->arena + snap->index[i]);
+}
+
+static inline unsigned int snap_hashsum(const char *name, int len)
+{
+	unsigned int sum = 2166136261U;
+	while (len-- > 0)
+		sum = (sum ^ (unsigned char) *name++) * 16777619U;
+	return sum;
+}
+
+struct umdirsnap *umdirsnap_new(void)
+{
+	struct umdirsnap *snap = calloc(1, sizeof(struct umdirsnap));
+	if (snap != NULL) {
+		snap->refcount = 1;
+		snap->arena = malloc(ARENA_INITSIZE);
+		snap->arenasize = ARENA_INITSIZE;
+		snap->hash = calloc(HASH_INITSIZE, sizeof(unsigned int));
+		snap->hashsize = HASH_INITSIZE;
+		if (snap->arena == NULL || snap->hash == NULL) {
+			free(snap->arena);
+			free(snap->hash);
+			free(snap);
+			return NULL;
+		}
+		snap->created = time(NULL);
+	}
+	return snap;
+}
+
+struct umdirsnap *umdirsnap_get(struct umdirsnap *snap)
+{
+	if (snap)
+		snap->refcount++;
+	return snap;
+}
+
+void umdirsnap_put(struct umdirsnap *snap)
+{
+	if (snap && --snap->refcount == 0) {
+		free(snap->arena);
+		free(snap->index);
+		free(snap->hash);
+		free(snap->path);
+		free(snap);
+	}
+}
+
+static int snap_rehash(struct umdirsnap *snap)
+{
+	unsigned int newsize = snap->hashsize << 1;
+	unsigned int *newhash = calloc(newsize, sizeof(unsigned int));
+	unsigned int i;
+	if (newhash == NULL)
+		return -1;
+	for (i = 0; i < snap->count; i++) {
+		struct snapentry *e = snap_entry(snap, i);
+		unsigned int h = snap_hashsum(e->name, e->namelen) & (newsize - 1);
+		while (newhash[h] != 0)
+			h = (h + 1) & (newsize - 1);
+		newhash[h] = i + 1;
+	}
+	free(snap->hash);
+	snap->hash = newhash;
+	snap->hashsize = newsize;
+	return 0;
+}
+
+int umdirsnap_add(struct umdirsnap *snap, const char *name,
+		unsigned long long ino, unsigned char type, int hidden)
+{
+	int len = strlen(name);
+	unsigned int h;
+	size_t reclen = ALIGN8(sizeof(struct snapentry) + len + 1);
+	struct snapentry *e;
+	if (len > 0xffff) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	for (h = snap_hashsum(name, len) & (snap->hashsize - 1);
+			snap->hash[h] != 0; h = (h + 1) & (snap->hashsize - 1)) {
+		e = snap_entry(snap, snap->hash[h] - 1);
+		if (e->namelen == len && memcmp(e->name, name, len) == 0)
+			return 0;
+	}
+	if (snap->arenalen + reclen > snap->arenasize) {
+		size_t newsize = snap->arenasize << 1;
+		char *newarena;
+		while (snap->arenalen + reclen > newsize)
+			newsize <<= 1;
+		if ((newarena = realloc(snap->arena, newsize)) == NULL)
+			return -1;
+		snap->arena = newarena;
+		snap->arenasize = newsize;
+	}
+	if (snap->count >= snap->indexsize) {
+		unsigned int newsize = snap->indexsize ? snap->indexsize << 1 : 256;
+		unsigned int *newindex = realloc(snap->index, newsize * sizeof(unsigned int));
+		if (newindex == NULL)
+			return -1;
+		snap->index = newindex;
+		snap->indexsize = newsize;
+	}
+	e = (struct snapentry *) (snap->arena + snap->arenalen);
+	e->ino = ino;
+	e->namelen = len;
+	e->type = type;
+	e->hidden = (hidden != 0);
+	memcpy(e->name, name, len + 1);
+	snap->index[snap->count] = snap->arenalen;
+	snap->arenalen += reclen;
+	snap->hash[h] = ++snap->count;
+	/* load factor <= 1/2 */
+	if (snap->count * 2 > snap->hashsize)
+		snap_rehash(snap);
+	return 1;
+}
+
+unsigned int umdirsnap_count(struct umdirsnap *snap)
+{
+	return snap->count;
+}
+
+int umdirsnap_getdents64(struct umdirsnap *snap, long long *pos,
+		struct dirent64 *dirp, unsigned int count)
+{
+	char *base = (char *) dirp;
+	unsigned int curoffs = 0;
+	long long i;
+	for (i = (*pos < 0) ? 0 : *pos; i < snap->count; i++) {
+		struct snapentry *e = snap_entry(snap, i);
+		struct dirent64 *current;
+		unsigned short reclen;
+		if (e->hidden)
+			continue;
+		reclen = ALIGN8(DIRENT64NAMEOFFSET + e->namelen + 1);
+		if (curoffs + reclen > count)
+			break;
+		current = (struct dirent64 *) base;
+		/* workaround: some FS do not set d_ino, but
+		 * inode 0 is special and is skipped by libc */
+		current->d_ino = (e->ino == 0) ? 2 : e->ino;
+		current->d_off = i + 1;
+		current->d_reclen = reclen;
+		current->d_type = e->type;
+		memcpy(current->d_name, e->name, e->namelen + 1);
+		base += reclen;
+		curoffs += reclen;
+	}
+	if (curoffs == 0 && i < snap->count) {
+		errno = EINVAL;
+		return -1;
+	}
+	*pos = i;
+	return curoffs;
+}
+
+static void snap_setstamp(struct snapstamp *stamp, struct stat *st)
+{
+	memset(stamp, 0, sizeof(struct snapstamp));
+	stamp->dev = st->st_dev;
+	stamp->ino = st->st_ino;
+	stamp->mtime = st->st_mtim.tv_sec;
+	stamp->mtime_nsec = st->st_mtim.tv_nsec;
+	stamp->ctime = st->st_ctim.tv_sec;
+	stamp->ctime_nsec = st->st_ctim.tv_nsec;
+}
+
+void umdirsnap_setkey(struct umdirsnap *snap, const char *path,
+		struct stat *st, int nst)
+{
+	int i;
+	free(snap->path);
+	snap->path = strdup(path);
+	if (nst > UMDIRSNAP_MAXSTAMPS)
+		nst = UMDIRSNAP_MAXSTAMPS;
+	snap->nstamps = nst;
+	for (i = 0; i < nst; i++)
+		snap_setstamp(&snap->stamp[i], &st[i]);
+}
+
+int umdirsnap_match(struct umdirsnap *snap, const char *path,
+		struct stat *st, int nst)
+{
+	int i;
+	if (snap == NULL || snap->path == NULL || nst != snap->nstamps ||
+			strcmp(snap->path, path) != 0)
+		return 0;
+	for (i = 0; i < nst; i++) {
+		struct snapstamp stamp;
+		snap_setstamp(&stamp, &st[i]);
+		if (memcmp(&stamp, &snap->stamp[i], sizeof(stamp)) != 0)
+			return 0;
+		/* a change in the same second of the snapshot could have
+		 * the same timestamp (coarse grained file systems) */
+		if (stamp.ino != 0 &&
+				(stamp.mtime >= snap->created - 1 || stamp.ctime >= snap->created - 1))
+			return 0;
+	}
+	return 1;
+}
@@ -0,0 +1,119 @@
+/*
+ *   This is part of Remote System Call (RSC) Library.
+ *
+ *   rsc_cache.h: client side cache of attributes, directories and
+ *                file data
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#ifndef __RSC_CACHE_HEADER__
+#define __RSC_CACHE_HEADER__
+
+#include "rsc_client.h"
+
+/* The rscc_cache_* functions have the same arguments and results of the
+ * rscc_* ones. The answers of stat64, lstat64, access, readlink and
+ * getdents64 are kept for a while, the data of the regular files opened
+ * read-only is read in blocks of RSCC_CACHE_BLOCK_SIZE bytes and their
+ * fstat64 is the stat64 of their path; the calls changing something
+ * forget what they change. The entries are valid
+ * until the lease expires or the server pushes an invalidation. */
+#define RSCC_CACHE_BLOCK_SIZE (64 * 1024)
+
+enum rscc_cache_op {
+  RSCC_CACHE_STAT = 0,
+  RSCC_CACHE_LSTAT,
+  RSCC_CACHE_ACCESS,
+  RSCC_CACHE_READLINK,
+  RSCC_CACHE_GETDENTS,
+  RSCC_CACHE_READ,
+  RSCC_CACHE_NOPS
+};
+
+struct rscc_cache_stats {
+  /* Every hit is a round trip saved */
+  unsigned long hits[RSCC_CACHE_NOPS];
+  unsigned long misses[RSCC_CACHE_NOPS];
+  /* Opens with prefetch: a single round trip each */
+  unsigned long prefetches;
+  /* Invalidations received from the server */
+  unsigned long pushed;
+  unsigned long evictions;
+  /* Validity of the entries (ms) */
+  int lease;
+  /* 1 if the server pushes the invalidations */
+  int coherent;
+};
+
+/* Enables the cache; it must be called after rscc_init().
+ * Without invalidations from the server (an old server, or 'event_sub_fd'
+ * equal to -1) the entries are valid for 'max_ms' milliseconds, otherwise
+ * for the lease granted by the server, if shorter. At most 'max_data'
+ * bytes of file data are cached. Returns the validity of the entries,
+ * -1 on error. */
+int rscc_cache_init(int event_sub_fd, int max_ms, size_t max_data);
+void rscc_cache_get_stats(struct rscc_cache_stats *stats);
+/* Invalidation received from the server ('flags' as in rsc_es_inval) */
+void rscc_cache_invalidate(char *path, int flags);
+/* Enables the prefetch: the read-only opens of the absolute paths get,
+ * in the same compound request, the attributes and the first 'bytes'
+ * bytes (in blocks) of a file, or the content of a directory, if they
+ * are not cached. The closes of the fds opened in this way are sent with
+ * the next open. Returns the bytes prefetched, -1 if the server doesn't
+ * execute the compound requests. */
+int rscc_cache_prefetch(size_t bytes);
+/* Sends the closes not sent yet */
+void rscc_cache_flush(void);
+
+/* Cached calls */
+int rscc_cache_stat64(char *path, struct stat64 *buf);
+int rscc_cache_lstat64(char *path, struct stat64 *buf);
+int rscc_cache_fstat64(int filedes, struct stat64 *buf);
+int rscc_cache_access(char *pathname, int mode);
+int rscc_cache_readlink(char *path, char *buf, size_t bufsiz);
+int rscc_cache_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count);
+int rscc_cache_read(int fd, void *buf, size_t count);
+int rscc_cache_pread64(int fd, void *buf, size_t count, off_t offset);
+/* Calls following the position and the path of the fds */
+int rscc_cache_open(char *pathname, int flags);
+int rscc_cache_close(int fd);
+int rscc_cache_lseek(int fildes, off_t offset, int whence);
+int rscc_cache__llseek(unsigned int fd, unsigned long int offset_high, unsigned long int offset_low, loff_t *result, unsigned int whence);
+int rscc_cache_dup(int oldfd);
+int rscc_cache_dup2(int oldfd, int newfd);
+int rscc_cache_fcntl(int fd, int cmd, ...);
+/* Calls changing the cached data */
+int rscc_cache_write(int fd, void *buf, size_t count);
+int rscc_cache_pwrite64(int fd, void *buf, size_t count, off_t offset);
+int rscc_cache_ftruncate64(int fd, __off64_t length);
+int rscc_cache_truncate64(char *path, __off64_t length);
+int rscc_cache_fchmod(int fildes, mode_t mode);
+int rscc_cache_fchown(int fd, uid_t owner, gid_t group);
+int rscc_cache_fchown32(int fd, uid_t owner, gid_t group);
+int rscc_cache_chmod(char *path, mode_t mode);
+int rscc_cache_chown(char *path, uid_t owner, gid_t group);
+int rscc_cache_lchown(char *path, uid_t owner, gid_t group);
+int rscc_cache_chown32(char *path, uid_t owner, gid_t group);
+int rscc_cache_lchown32(char *path, uid_t owner, gid_t group);
+int rscc_cache_utime(char *filename, struct utimbuf *buf);
+int rscc_cache_utimes(char *filename, struct timeval tv[2]);
+int rscc_cache_unlink(char *pathname);
+int rscc_cache_rmdir(char *pathname);
+int rscc_cache_mkdir(char *pathname, mode_t mode);
+int rscc_cache_rename(char *oldpath, char *newpath);
+int rscc_cache_symlink(char *oldpath, char *newpath);
+int rscc_cache_link(char *oldpath, char *newpath);
+
+#endif /* __RSC_CACHE_HEADER__ */
@@ -74,7 +74,61 @@ struct reg_cb {
 /*************************************************/
 /*   INIT FUNCTION                               */
 /*************************************************/
+/* If 'client_fd' is a unix domain socket and the server has the same
+ * architecture, the requests and the responses go through a memory region
+ * shared with the server (see rsc_shm.h) when the server accepts it */
 int rscc_init(int client_fd, int event_sub_fd, struct reg_cbs **rc, enum arch c_arch, enum arch s_arch);
+/* Asks the server for the protocol 'version' and returns the version in
+ * use (-1 on error): a v1 server negotiates down to RSC_PROTO_V1. With
+ * RSC_PROTO_V2 the rscc_* functions can be called by many threads at once,
+ * their requests are pipelined on the connection. It must be called after
+ * rscc_init() and before the other rscc_* functions. With the shared
+ * memory the calls are one at a time and the version is RSC_PROTO_V1. */
+int rscc_set_proto(int version);
+/* Sends an ioctl request with the reserved code 'probe' (see rsc_messages.h)
+ * and returns the value answered by the server, IOCTL_UNMANAGED if the
+ * server doesn't know the probe, -1 on error. */
+int rscc_probe(u_int32_t probe);
+
+/*************************************************/
+/*   COMPOUND REQUESTS                           */
+/*************************************************/
+/* The calls which can be part of a compound request (see rsc_messages.h) */
+enum rscc_compound_op {
+  RSCC_COMPOUND_OPEN,
+  RSCC_COMPOUND_CLOSE,
+  RSCC_COMPOUND_FSTAT64,
+  RSCC_COMPOUND_PREAD64,
+  RSCC_COMPOUND_GETDENTS64
+};
+
+/* A call of a compound request. The arguments are 'path' and 'open_flags'
+ * for open, 'fd', 'buf' (a struct stat64 for fstat64), 'count' and
+ * 'offset' for the others. If 'chain' is not RSC_COMPOUND_NOCHAIN, the fd
+ * is the result of the call number 'chain'; 'flags' are the
+ * RSC_COMPOUND_* flags of the items. The result of the call and its
+ * errno are saved in 'retval' and 'err'. */
+struct rscc_compound_call {
+  enum rscc_compound_op op;
+  int chain;
+  int flags;
+  char *path;
+  int open_flags;
+  int fd;
+  void *buf;
+  size_t count;
+  off_t offset;
+  int retval;
+  int err;
+};
+
+/* The maximum number of calls of a compound request executed by the
+ * server, 0 if the server doesn't know the compound requests */
+int rscc_compound_max(void);
+/* Executes the 'ncalls' calls in order, with a single round trip if the
+ * server supports it, otherwise one call at a time. Returns 0, -1 if the
+ * calls have not been executed or their results have been lost. */
+int rscc_compound(struct rscc_compound_call *calls, int ncalls);
 
 
 /*************************************************/
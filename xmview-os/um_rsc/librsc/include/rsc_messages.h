@@ -44,6 +44,9 @@
 #define RSC_SYS_RESP   3
 #define RSC_IOCTL_RESP 4
 
+#define RSC_COMPOUND_REQ  5
+#define RSC_COMPOUND_RESP 6
+
 #define NO_SYS_CONST 0
 
 
@@ -110,6 +113,82 @@ struct ioctl_resp_header {
 } __attribute__((packed));
 
 
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  PROTOCOL VERSION 2                                                ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+/* A v1 connection carries one request at a time. After the handshake the
+ * client can send an ioctl request for RSC_PROTO_PROBE: a v1 server answers
+ * IOCTL_UNMANAGED, a v2 server answers RSC_PROTO_V2 and from then on every
+ * message, in both directions, is preceded by a frame header. The response
+ * has the id of its request, so many requests can be in flight and the
+ * responses can be sent in any order. */
+#define RSC_PROTO_V1      1
+#define RSC_PROTO_V2      2
+#define RSC_PROTO_PROBE   0x52534300
+/* A server which pushes the invalidations of the client caches answers
+ * this probe with the lease time (in ms); it starts to send them on the
+ * event subscription connections where the client sends EVENT_SUB_CACHE */
+#define RSC_CACHE_PROBE   0x52534301
+/* A server which executes the compound requests answers this probe with
+ * the maximum number of calls in a request */
+#define RSC_COMPOUND_PROBE 0x52534302
+/* On a unix domain connection, a v1 client of the same architecture of
+ * the server sends this probe together with the fd of a memory region
+ * (see rsc_shm.h): a server which maps it answers RSC_SHM_PROBE, and the
+ * next messages go through the region */
+#define RSC_SHM_PROBE     0x52534303
+
+struct rsc_frame_header {
+  u_int32_t frame_id;
+  /* size of the message following the header */
+  u_int32_t frame_size;
+} __attribute__((packed));
+/* The largest message a frame can carry: a peer announcing a larger one
+ * is broken and the connection is closed */
+#define RSC_FRAME_MAX     (1 << 30)
+
+
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  COMPOUND REQUEST/RESPONSE                                         ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+/* A compound request carries a sequence of syscall execution requests
+ * that the server executes in order: a common access pattern, like
+ * open-fstat-read-close, costs a single round trip.
+ * The request is a 'compound_req_header' followed by 'req_count' items,
+ * each one a 'compound_item' followed by a syscall request with its own
+ * header and size. If 'chain' is the index of a previous item, the result
+ * of that call (e.g. the fd returned by open) replaces the first argument
+ * of the request, which must be an int; the item is skipped if that call
+ * failed or was skipped. A skipped item is answered with a
+ * 'sys_resp_header' with 'resp_retval' -1 and 'resp_errno' ECANCELED.
+ * The response is a 'compound_resp_header' followed by the responses of
+ * the items, in order, each one as the response to the single request. */
+#define RSC_COMPOUND_MAX      16
+#define RSC_COMPOUND_NOCHAIN  0xff
+/* Flags of the items: the item is executed only if the chained fd is a
+ * regular file, the speculative reads don't touch devices and pipes */
+#define RSC_COMPOUND_IFREG    0x01
+
+struct compound_req_header {
+  REQ_HEADER
+  u_int8_t req_count;
+} __attribute__((packed));
+
+struct compound_item {
+  u_int8_t chain;
+  u_int8_t flags;
+} __attribute__((packed));
+
+struct compound_resp_header {
+  RESP_HEADER
+  u_int8_t resp_count;
+} __attribute__((packed));
+
+
 /*########################################################################*/
 /*##                                                                    ##*/
 /*##  SYSCALL EXECUTION REQUEST/RESPONSE                                ##*/
@@ -643,7 +722,9 @@ enum event_sub_type {
   EVENT_SUB_REQ = 1,
   EVENT_SUB_ACK, 
   EVENT_SUB_RESP,
-  EVENT_SUB_DEREG
+  EVENT_SUB_DEREG,
+  EVENT_SUB_CACHE,
+  EVENT_SUB_INVAL
 };
 
 /* These constants are used by the ACK messages */
@@ -693,4 +774,19 @@ struct rsc_es_dereg {
   int how;
 }__attribute__((packed));
 
+/* Used by the client to receive the invalidations of its cache */
+struct rsc_es_cache {
+  RSC_ES_COMMON_FIELDS
+}__attribute__((packed));
+
+/* Used by the server to inform that 'path' has changed: it is followed
+ * by the 'len' bytes of the path (not terminated). With RSC_INVAL_RECURSIVE
+ * the paths below 'path' are changed too. */
+#define RSC_INVAL_RECURSIVE 0x01
+struct rsc_es_inval {
+  RSC_ES_COMMON_FIELDS
+  u_int8_t flags;
+  u_int32_t len;
+}__attribute__((packed));
+
 #endif /* __RSC_MESSAGE_H__ */
@@ -0,0 +1,97 @@
+/*
+ *   This is part of Remote System Call (RSC) Library.
+ *
+ *   rsc_shm.h: local transport, the messages go through rings in a
+ *              memory region shared by the client and the server
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#ifndef __RSC_SHM_HEADER__
+#define __RSC_SHM_HEADER__
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* A client connected to the server with a unix domain socket creates a
+ * memory region (a sealed memfd) and sends its fd to the server with the
+ * RSC_SHM_PROBE (see rsc_messages.h). From then on the client writes the
+ * v1 messages into the RSC_RING_REQ ring and reads the answers from the
+ * RSC_RING_RESP ring, without system calls while the other side is
+ * running; a side waiting for the other sleeps on a futex in the ring,
+ * and is woken up only if it sleeps. The socket is kept open: a side
+ * which finds the other one silent for RSC_SHM_CHECK ms checks the socket
+ * to know if it is gone. */
+#define RSC_SHM_MAGIC       0x52534d31
+#define RSC_SHM_RING_SIZE   (256 * 1024)
+#define RSC_SHM_CHECK       1000
+
+/* A single producer, single consumer ring of bytes. The counters run
+ * freely, the data is at offset 'counter % size'. The producer and the
+ * consumer update their counter on different cache lines. */
+struct rsc_ring {
+  /* Bytes written, the consumer sleeps on it if 'head_wait' */
+  u_int32_t head __attribute__((aligned(64)));
+  u_int32_t head_wait;
+  /* Bytes read, the producer sleeps on it if 'tail_wait' */
+  u_int32_t tail __attribute__((aligned(64)));
+  u_int32_t tail_wait;
+};
+
+#define RSC_RING_REQ        0   /* client to server */
+#define RSC_RING_RESP       1   /* server to client */
+
+/* The beginning of the region: the data of the rings follows it, at
+ * offset RSC_SHM_DATA, 'ring_size' bytes each (a power of 2) */
+#define RSC_SHM_DATA        4096
+struct rsc_shm_region {
+  u_int32_t magic;
+  u_int32_t ring_size;
+  /* Set by the side which leaves */
+  u_int32_t closed;
+  struct rsc_ring ring[2];
+};
+
+/* The region as mapped by one side: the server doesn't trust the values
+ * in the region, which the client can change at any time */
+struct rsc_shm {
+  struct rsc_shm_region *region;
+  u_int32_t ring_size;
+  size_t len;
+};
+
+/* The client creates a region with rings of 'ring_size' bytes; '*fd' is
+ * the fd to send to the server. Returns NULL on error */
+struct rsc_shm *rsc_shm_create(int ring_size, int *fd);
+/* The server maps the region of 'fd', NULL if it is not valid (a region
+ * which can shrink is not valid) */
+struct rsc_shm *rsc_shm_map(int fd);
+/* The side leaving wakes up the other one and unmaps the region */
+void rsc_shm_close(struct rsc_shm *shm);
+
+/* Write/read 'nbytes' into/from the ring 'ring' of 'shm', waiting for the
+ * other side if needed; 'ctlfd' is the socket connected to it. They
+ * return the bytes written/read, less than 'nbytes' if the other side is
+ * gone. A ring has a single writer and a single reader at a time */
+int rsc_ring_writev(struct rsc_shm *shm, int ring, int ctlfd, struct iovec *v, int count, int nbytes);
+int rsc_ring_read(struct rsc_shm *shm, int ring, int ctlfd, void *buf, int nbytes);
+int rsc_ring_readv(struct rsc_shm *shm, int ring, int ctlfd, struct iovec *v, int count, int nbytes);
+
+/* Send/receive 'len' bytes on the unix socket 'sockfd' together with an
+ * fd. If an fd comes with the data rsc_shm_recv_fd() puts it in '*fd',
+ * closing the one already there (if not -1); it returns as read(2) */
+int rsc_shm_send_fd(int sockfd, void *buf, int len, int fd);
+int rsc_shm_recv_fd(int sockfd, void *buf, int len, int *fd);
+
+#endif /* __RSC_SHM_HEADER__ */
@@ -33,6 +33,11 @@ int rsc_es_msg_size(u_int8_t type) {
       size = sizeof(struct rsc_es_resp); break;
     case EVENT_SUB_DEREG:
       size = sizeof(struct rsc_es_dereg); break;
+    case EVENT_SUB_CACHE:
+      size = sizeof(struct rsc_es_cache); break;
+    /* Without the path */
+    case EVENT_SUB_INVAL:
+      size = sizeof(struct rsc_es_inval); break;
     default:
       size = -1; break;
   }
@@ -29,6 +29,7 @@
 #include "utils.h"
 #include "debug.h"
 #include "rsc_client.h"
+#include "rsc_cache.h"
 #include "registered_callbacks.h"
 
 /******************************************/
@@ -138,6 +139,24 @@ static void *rscc_es_thread(void *thread_arg) {
 		        cb(arg);
 		      }
         }
+      } else if(hdr.type == EVENT_SUB_INVAL) {
+        struct rsc_es_inval inval;
+        int size = sizeof(inval) - sizeof(hdr);
+        char *path;
+        RSC_DEBUG(RSCD_EVENT_SUB, "It's a cache invalidation");
+        ret = read_n_bytes(event_sub_fd, ((char *)&inval) + sizeof(hdr), size);
+        if(ret == size) {
+          inval.len = ntohl(inval.len);
+          if((path = malloc(inval.len + 1)) == NULL)
+            return NULL;
+          ret = read_n_bytes(event_sub_fd, path, inval.len);
+          if(ret == inval.len) {
+            path[inval.len] = '\0';
+            RSC_DEBUG(RSCD_EVENT_SUB, "invalidation of '%s', flags = %d", path, inval.flags);
+            rscc_cache_invalidate(path, inval.flags);
+          }
+          free(path);
+        }
       } else { /* else: error, I do nothing */
         printf("Error, hdr.type = %d\n", hdr.type);
       }
@@ -43,7 +43,7 @@ struct ioctl_cache {
   int nentry;
 };
 
-struct ioctl_cache *ioctl_cache;
+extern struct ioctl_cache *ioctl_cache;
 struct ioctl_cache *ioctl_cache_init(int size);
 void ioctl_cache_add(struct ioctl_cache *cache, int request, u_int32_t size_type);
 u_int32_t ioctl_cache_search(struct ioctl_cache *cache, int request);
@@ -0,0 +1,1437 @@
+/*
+ *   This is part of Remote System Call (RSC) Library.
+ *
+ *   rsc_cache.c: client side cache of attributes, directories and
+ *                file data
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "utils.h"
+#include "debug.h"
+#include "rsc_client.h"
+#include "rsc_cache.h"
+
+/* The entries are indexed by path. Every answer kept in an entry has its
+ * own expiration time; the file data is kept in blocks of
+ * RSCC_CACHE_BLOCK_SIZE bytes. The least recently used entries are
+ * evicted when there are more than CACHE_MAX_ENTRIES entries or more than
+ * 'max_data' bytes of data.
+ *
+ * The requests are sent without holding the cache mutex: an answer is
+ * saved only if nobody invalidated its path in the meantime. To detect it
+ * each bucket has a generation counter, incremented by the invalidations
+ * of the paths of the bucket; the recursive invalidations increment
+ * 'rgen'.
+ *
+ * With the prefetch, a read-only open is a compound request which gets
+ * the attributes and the first blocks of a file, or the content of a
+ * directory, together with the new fd. The closes of the fds in local
+ * mode cannot fail: they are deferred and sent with the next open. */
+#define CACHE_HASH_SIZE 1024
+#define CACHE_MAX_ENTRIES 4096
+#define DENTS_BUF_SIZE (32 * 1024)
+/* An empty read after the first one: the directory is complete */
+#define DENTS_END_SIZE 1024
+#define PENDING_MAX 8
+#define PREFETCH_MAX_BLOCKS 4
+
+/* The answers kept in an entry (bits of 'valid' and indexes of 'expire') */
+enum {
+  CE_STAT = 0,
+  CE_LSTAT,
+  CE_READLINK,
+  CE_DENTS,
+  CE_ACCESS,  /* CE_ACCESS + mode, mode = 0..7 */
+  CE_NFIELDS = CE_ACCESS + 8
+};
+
+struct cblock {
+  off_t idx;
+  int len;
+  long long expire;
+  struct cblock *next;
+  char data[];
+};
+
+struct centry {
+  char *path;
+  unsigned int hash;
+  int valid;
+  long long expire[CE_NFIELDS];
+  /* The results: 0 or the errno */
+  int err[CE_NFIELDS];
+  struct stat64 st;
+  struct stat64 lst;
+  char *link;
+  int link_len;
+  char *dents;
+  int dents_len;
+  struct cblock *blocks;
+  /* Bytes of data kept by the entry */
+  size_t size;
+  struct centry *hnext;
+  struct centry *prev, *next;
+};
+
+/* A fd opened through the cache. In local mode the position is kept
+ * here: the data of the files is read with pread, the directories are read
+ * from a snapshot of their content. */
+struct cfd {
+  char *path;
+  int flags;
+  int local;
+  int isdir;
+  off_t pos;
+  /* Directories */
+  char *dents;
+  int dents_len;
+  off_t last_doff;
+  /* 0 if the server position of the directory is not at the beginning */
+  int srv_start;
+};
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int cache_enabled;
+static int cache_ms;
+static size_t cache_max_data;
+static size_t cache_data;
+static int cache_nentries;
+static struct centry *cache_hash[CACHE_HASH_SIZE];
+static unsigned int cache_bgen[CACHE_HASH_SIZE];
+static unsigned int cache_rgen;
+/* LRU list: the head is the most recently used entry */
+static struct centry *lru_head, *lru_tail;
+static struct cfd **cache_fds;
+static int cache_nfds;
+static struct rscc_cache_stats stats;
+/* Blocks read by an open, 0 if the prefetch is disabled */
+static int prefetch_blocks;
+/* Calls of a compound request */
+static int prefetch_room;
+static int pending_fds[PENDING_MAX];
+static int npending;
+
+static int prefetch_open(char *pathname, int flags, int *srv_moved);
+static void send_closes(int *fds, int n);
+
+static long long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static unsigned int path_hash(char *path) {
+  unsigned int h = 5381;
+  while(*path)
+    h = h * 33 + (unsigned char)*path++;
+  return h;
+}
+
+/* Relative paths depend on the cwd, they are not cached */
+static inline int cacheable(char *path) {
+  return cache_enabled && path != NULL && path[0] == '/';
+}
+
+/* The generation of 'path': a result can be saved only if it
+ * has not changed since the request was sent. */
+static unsigned int cache_gen_locked(char *path) {
+  return cache_bgen[path_hash(path) % CACHE_HASH_SIZE] + cache_rgen;
+}
+
+/**************************************************************************/
+/* Entries                                                                */
+/**************************************************************************/
+static void lru_unlink(struct centry *e) {
+  if(e->prev)
+    e->prev->next = e->next;
+  else
+    lru_head = e->next;
+  if(e->next)
+    e->next->prev = e->prev;
+  else
+    lru_tail = e->prev;
+  e->prev = e->next = NULL;
+}
+
+static void lru_push(struct centry *e) {
+  e->prev = NULL;
+  e->next = lru_head;
+  if(lru_head)
+    lru_head->prev = e;
+  lru_head = e;
+  if(lru_tail == NULL)
+    lru_tail = e;
+}
+
+static void centry_drop_data(struct centry *e) {
+  struct cblock *b;
+  while((b = e->blocks) != NULL) {
+    e->blocks = b->next;
+    free(b);
+  }
+  free(e->link);
+  free(e->dents);
+  e->link = e->dents = NULL;
+  cache_data -= e->size;
+  e->size = 0;
+}
+
+static void centry_free(struct centry *e) {
+  struct centry **pe;
+  for(pe = &cache_hash[e->hash % CACHE_HASH_SIZE]; *pe != e; pe = &(*pe)->hnext)
+    ;
+  *pe = e->hnext;
+  lru_unlink(e);
+  centry_drop_data(e);
+  free(e->path);
+  free(e);
+  cache_nentries--;
+}
+
+static struct centry *centry_lookup(char *path) {
+  unsigned int h = path_hash(path);
+  struct centry *e;
+  for(e = cache_hash[h % CACHE_HASH_SIZE]; e != NULL; e = e->hnext)
+    if(e->hash == h && strcmp(e->path, path) == 0) {
+      lru_unlink(e);
+      lru_push(e);
+      return e;
+    }
+  return NULL;
+}
+
+/* I evict the least recently used entries, but not 'keep' */
+static void cache_shrink(struct centry *keep) {
+  struct centry *e = lru_tail;
+  while(e != NULL && (cache_nentries > CACHE_MAX_ENTRIES || cache_data > cache_max_data)) {
+    struct centry *prev = e->prev;
+    if(e != keep) {
+      centry_free(e);
+      stats.evictions++;
+    }
+    e = prev;
+  }
+}
+
+static struct centry *centry_get(char *path) {
+  struct centry *e;
+  if((e = centry_lookup(path)) != NULL)
+    return e;
+  if((e = calloc(1, sizeof(struct centry))) == NULL)
+    return NULL;
+  if((e->path = strdup(path)) == NULL) {
+    free(e);
+    return NULL;
+  }
+  e->hash = path_hash(path);
+  e->hnext = cache_hash[e->hash % CACHE_HASH_SIZE];
+  cache_hash[e->hash % CACHE_HASH_SIZE] = e;
+  lru_push(e);
+  cache_nentries++;
+  cache_shrink(e);
+  return e;
+}
+
+/* Returns the entry if the field is valid, NULL otherwise */
+static struct centry *centry_field(char *path, int field) {
+  struct centry *e = centry_lookup(path);
+  if(e == NULL || !(e->valid & (1 << field)))
+    return NULL;
+  if(e->expire[field] <= now_ms()) {
+    e->valid &= ~(1 << field);
+    return NULL;
+  }
+  return e;
+}
+
+/* Returns the entry where the field can be saved, NULL if the answer
+ * is too old */
+static struct centry *centry_set(char *path, int field, int err, unsigned int gen) {
+  struct centry *e;
+  if(cache_gen_locked(path) != gen || (e = centry_get(path)) == NULL)
+    return NULL;
+  e->valid |= 1 << field;
+  e->expire[field] = now_ms() + cache_ms;
+  e->err[field] = err;
+  return e;
+}
+
+static void centry_add_size(struct centry *e, int size) {
+  e->size += size;
+  cache_data += size;
+  cache_shrink(e);
+}
+
+/* Forgets 'path' and, if 'recursive', everything below it */
+static void cache_forget_locked(char *path, int recursive) {
+  unsigned int h = path_hash(path);
+  struct centry *e, *next;
+  size_t len;
+  cache_bgen[h % CACHE_HASH_SIZE]++;
+  if((e = centry_lookup(path)) != NULL)
+    centry_free(e);
+  if(!recursive)
+    return;
+  cache_rgen++;
+  len = strlen(path);
+  while(len > 0 && path[len - 1] == '/')
+    len--;
+  for(e = lru_head; e != NULL; e = next) {
+    next = e->next;
+    if(strncmp(e->path, path, len) == 0 && (e->path[len] == '/' || e->path[len] == 0))
+      centry_free(e);
+  }
+}
+
+/* The changes of 'path' change its parent directory too */
+static void cache_forget(char *path, int recursive) {
+  char *slash;
+  if(!cacheable(path))
+    return;
+  pthread_mutex_lock(&cache_mutex);
+  cache_forget_locked(path, recursive);
+  if((slash = strrchr(path, '/')) != NULL) {
+    char *parent = strndup(path, slash == path ? 1 : slash - path);
+    if(parent != NULL) {
+      cache_forget_locked(parent, 0);
+      free(parent);
+    }
+  }
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+static int negative_err(int err) {
+  return err == ENOENT || err == ENOTDIR || err == EACCES;
+}
+
+/**************************************************************************/
+/* Fds                                                                    */
+/**************************************************************************/
+static struct cfd *cfd_get(int fd) {
+  if(fd < 0 || fd >= cache_nfds)
+    return NULL;
+  return cache_fds[fd];
+}
+
+static void cfd_free(int fd) {
+  struct cfd *cf = cfd_get(fd);
+  if(cf == NULL)
+    return;
+  cache_fds[fd] = NULL;
+  free(cf->path);
+  free(cf->dents);
+  free(cf);
+}
+
+static struct cfd *cfd_new(int fd, char *path, int flags) {
+  struct cfd *cf;
+  if(fd < 0)
+    return NULL;
+  if(fd >= cache_nfds) {
+    int n = (fd + 64) & ~63;
+    struct cfd **fds = realloc(cache_fds, n * sizeof(struct cfd *));
+    if(fds == NULL)
+      return NULL;
+    memset(fds + cache_nfds, 0, (n - cache_nfds) * sizeof(struct cfd *));
+    cache_fds = fds;
+    cache_nfds = n;
+  }
+  cfd_free(fd);
+  if((cf = calloc(1, sizeof(struct cfd))) == NULL)
+    return NULL;
+  if((cf->path = strdup(path)) == NULL) {
+    free(cf);
+    return NULL;
+  }
+  cf->flags = flags;
+  cf->srv_start = 1;
+  cache_fds[fd] = cf;
+  return cf;
+}
+
+/* The fd leaves the local mode: I move the server position where the
+ * local one is. */
+static void cfd_sync(int fd, struct cfd *cf) {
+  if(!cf->local)
+    return;
+  cf->local = 0;
+  if(cf->isdir) {
+    if(cf->dents != NULL || !cf->srv_start)
+      rscc_lseek(fd, cf->dents != NULL ? cf->last_doff : 0, SEEK_SET);
+  } else
+    rscc_lseek(fd, cf->pos, SEEK_SET);
+}
+
+static char *cfd_path(int fd) {
+  struct cfd *cf;
+  char *path = NULL;
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fd)) != NULL)
+    path = strdup(cf->path);
+  pthread_mutex_unlock(&cache_mutex);
+  return path;
+}
+
+static void cache_forget_fd(int fd) {
+  char *path;
+  if(!cache_enabled)
+    return;
+  if((path = cfd_path(fd)) != NULL) {
+    cache_forget(path, 0);
+    free(path);
+  }
+}
+
+/**************************************************************************/
+/* Init                                                                   */
+/**************************************************************************/
+int rscc_cache_init(int event_sub_fd, int max_ms, size_t max_data) {
+  int lease;
+  if(max_ms <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  cache_ms = max_ms;
+  cache_max_data = max_data;
+  /* If the server can push the invalidations, the entries
+   * are valid until the end of its lease. */
+  if(event_sub_fd >= 0 &&
+      (lease = rscc_probe(RSC_CACHE_PROBE)) > 0 && lease != IOCTL_UNMANAGED) {
+    struct rsc_es_cache req;
+    req.type = EVENT_SUB_CACHE;
+    if(write_n_bytes(event_sub_fd, &req, sizeof(req)) == sizeof(req)) {
+      stats.coherent = 1;
+      if(lease < cache_ms)
+        cache_ms = lease;
+    }
+  }
+  stats.lease = cache_ms;
+  cache_enabled = 1;
+  RSC_DEBUG(RSCD_REQ_RESP, "cache enabled: lease = %d ms, coherent = %d", cache_ms, stats.coherent);
+  return cache_ms;
+}
+
+void rscc_cache_get_stats(struct rscc_cache_stats *s) {
+  pthread_mutex_lock(&cache_mutex);
+  *s = stats;
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+void rscc_cache_invalidate(char *path, int flags) {
+  pthread_mutex_lock(&cache_mutex);
+  stats.pushed++;
+  cache_forget_locked(path, flags & RSC_INVAL_RECURSIVE);
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+/**************************************************************************/
+/* Attributes                                                             */
+/**************************************************************************/
+static int cached_stat(char *path, struct stat64 *buf, int field) {
+  struct centry *e;
+  unsigned int gen;
+  int ret, err;
+  int op = field == CE_STAT ? RSCC_CACHE_STAT : RSCC_CACHE_LSTAT;
+
+  pthread_mutex_lock(&cache_mutex);
+  if((e = centry_field(path, field)) != NULL) {
+    stats.hits[op]++;
+    err = e->err[field];
+    if(err == 0)
+      *buf = field == CE_STAT ? e->st : e->lst;
+    pthread_mutex_unlock(&cache_mutex);
+    if(err == 0)
+      return 0;
+    errno = err;
+    return -1;
+  }
+  stats.misses[op]++;
+  gen = cache_gen_locked(path);
+  pthread_mutex_unlock(&cache_mutex);
+
+  if(field == CE_STAT)
+    ret = rscc_stat64(path, buf);
+  else
+    ret = rscc_lstat64(path, buf);
+  err = errno;
+  if(ret == 0 || negative_err(err)) {
+    pthread_mutex_lock(&cache_mutex);
+    if((e = centry_set(path, field, ret == 0 ? 0 : err, gen)) != NULL) {
+      if(ret == 0) {
+        if(field == CE_STAT)
+          e->st = *buf;
+        else
+          e->lst = *buf;
+      }
+      /* The lstat of anything but a symlink is its stat too */
+      if(field == CE_LSTAT && (ret != 0 || !S_ISLNK(buf->st_mode)) &&
+          centry_set(path, CE_STAT, e->err[CE_LSTAT], gen) != NULL && ret == 0)
+        e->st = *buf;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  errno = err;
+  return ret;
+}
+
+int rscc_cache_stat64(char *path, struct stat64 *buf) {
+  if(!cacheable(path))
+    return rscc_stat64(path, buf);
+  return cached_stat(path, buf, CE_STAT);
+}
+
+int rscc_cache_lstat64(char *path, struct stat64 *buf) {
+  if(!cacheable(path))
+    return rscc_lstat64(path, buf);
+  return cached_stat(path, buf, CE_LSTAT);
+}
+
+/* The fds in local mode have the attributes of their path */
+int rscc_cache_fstat64(int filedes, struct stat64 *buf) {
+  struct cfd *cf;
+  struct centry *e;
+  if(!cache_enabled)
+    return rscc_fstat64(filedes, buf);
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(filedes)) != NULL && cf->local &&
+      (e = centry_field(cf->path, CE_STAT)) != NULL && e->err[CE_STAT] == 0) {
+    stats.hits[RSCC_CACHE_STAT]++;
+    *buf = e->st;
+    pthread_mutex_unlock(&cache_mutex);
+    return 0;
+  }
+  pthread_mutex_unlock(&cache_mutex);
+  return rscc_fstat64(filedes, buf);
+}
+
+int rscc_cache_access(char *pathname, int mode) {
+  struct centry *e;
+  unsigned int gen;
+  int ret, err;
+  int field = CE_ACCESS + (mode & 7);
+
+  if(!cacheable(pathname) || (mode & ~7) != 0)
+    return rscc_access(pathname, mode);
+  pthread_mutex_lock(&cache_mutex);
+  if((e = centry_field(pathname, field)) != NULL) {
+    stats.hits[RSCC_CACHE_ACCESS]++;
+    err = e->err[field];
+    pthread_mutex_unlock(&cache_mutex);
+    if(err == 0)
+      return 0;
+    errno = err;
+    return -1;
+  }
+  stats.misses[RSCC_CACHE_ACCESS]++;
+  gen = cache_gen_locked(pathname);
+  pthread_mutex_unlock(&cache_mutex);
+
+  ret = rscc_access(pathname, mode);
+  err = errno;
+  if(ret == 0 || negative_err(err)) {
+    pthread_mutex_lock(&cache_mutex);
+    centry_set(pathname, field, ret == 0 ? 0 : err, gen);
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  errno = err;
+  return ret;
+}
+
+int rscc_cache_readlink(char *path, char *buf, size_t bufsiz) {
+  struct centry *e;
+  unsigned int gen;
+  int ret, err;
+  char *link;
+
+  if(!cacheable(path))
+    return rscc_readlink(path, buf, bufsiz);
+  pthread_mutex_lock(&cache_mutex);
+  if((e = centry_field(path, CE_READLINK)) != NULL) {
+    stats.hits[RSCC_CACHE_READLINK]++;
+    err = e->err[CE_READLINK];
+    if(err == 0) {
+      ret = e->link_len < bufsiz ? e->link_len : bufsiz;
+      memcpy(buf, e->link, ret);
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    if(err == 0)
+      return ret;
+    errno = err;
+    return -1;
+  }
+  stats.misses[RSCC_CACHE_READLINK]++;
+  gen = cache_gen_locked(path);
+  pthread_mutex_unlock(&cache_mutex);
+
+  ret = rscc_readlink(path, buf, bufsiz);
+  err = errno;
+  /* A truncated link is not saved, EINVAL means "not a symlink" */
+  if((ret >= 0 && ret < bufsiz) || (ret < 0 && (negative_err(err) || err == EINVAL))) {
+    link = NULL;
+    if(ret <= 0 || (link = malloc(ret)) != NULL) {
+      pthread_mutex_lock(&cache_mutex);
+      if((e = centry_set(path, CE_READLINK, ret < 0 ? err : 0, gen)) != NULL) {
+        if(link != NULL)
+          memcpy(link, buf, ret);
+        e->size -= e->link_len;
+        cache_data -= e->link_len;
+        free(e->link);
+        e->link = link;
+        e->link_len = ret > 0 ? ret : 0;
+        link = NULL;
+        centry_add_size(e, e->link_len);
+      }
+      pthread_mutex_unlock(&cache_mutex);
+      free(link);
+    }
+  }
+  errno = err;
+  return ret;
+}
+
+/**************************************************************************/
+/* Fds                                                                    */
+/**************************************************************************/
+int rscc_cache_open(char *pathname, int flags) {
+  struct centry *e;
+  struct cfd *cf;
+  int ret, err, srv_moved = 0;
+
+  if(prefetch_blocks > 0 && cacheable(pathname) &&
+      (flags & O_ACCMODE) == O_RDONLY && !(flags & (O_CREAT | O_TRUNC)))
+    ret = prefetch_open(pathname, flags, &srv_moved);
+  else
+    ret = rscc_open(pathname, flags);
+  err = errno;
+  if(!cacheable(pathname))
+    return ret;
+  if((flags & O_ACCMODE) != O_RDONLY || (flags & (O_CREAT | O_TRUNC)))
+    cache_forget(pathname, 0);
+  if(ret >= 0) {
+    pthread_mutex_lock(&cache_mutex);
+    if((cf = cfd_new(ret, pathname, flags)) != NULL) {
+      /* The local mode is used for what is surely a regular file or a
+       * directory, according to the cache. */
+      if((e = centry_field(pathname, CE_STAT)) == NULL || e->err[CE_STAT] != 0)
+        e = NULL;
+      if(flags & O_DIRECTORY || (e != NULL && S_ISDIR(e->st.st_mode))) {
+        cf->isdir = 1;
+        cf->local = 1;
+      } else if(e != NULL && S_ISREG(e->st.st_mode) && (flags & O_ACCMODE) == O_RDONLY)
+        cf->local = 1;
+      /* The prefetch has read the directory */
+      if(srv_moved)
+        cf->srv_start = 0;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  errno = err;
+  return ret;
+}
+
+/* Removes 'fd' from the deferred closes, returns 1 if it was there */
+static int pending_del(int fd) {
+  int i;
+  for(i = 0; i < npending; i++)
+    if(pending_fds[i] == fd) {
+      pending_fds[i] = pending_fds[--npending];
+      return 1;
+    }
+  return 0;
+}
+
+int rscc_cache_close(int fd) {
+  struct cfd *cf;
+  int fds[PENDING_MAX], n = 0;
+  if(cache_enabled) {
+    pthread_mutex_lock(&cache_mutex);
+    /* The fd is already closed for the caller */
+    if(pending_del(fd)) {
+      pthread_mutex_unlock(&cache_mutex);
+      rscc_close(fd);
+      errno = EBADF;
+      return -1;
+    }
+    if(prefetch_blocks > 0 && (cf = cfd_get(fd)) != NULL && cf->local) {
+      cfd_free(fd);
+      pending_fds[npending++] = fd;
+      if(npending == PENDING_MAX) {
+        memcpy(fds, pending_fds, sizeof(fds));
+        n = npending;
+        npending = 0;
+      }
+      pthread_mutex_unlock(&cache_mutex);
+      send_closes(fds, n);
+      return 0;
+    }
+    cfd_free(fd);
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  return rscc_close(fd);
+}
+
+/* The block 'idx' of 'path'. Returns the number of bytes copied in 'buf'
+ * from 'off' bytes within the block, -1 if the block is not cached */
+static int block_copy(char *path, off_t idx, int off, char *buf, size_t count) {
+  struct centry *e;
+  struct cblock *b;
+  int n = -1;
+  long long now = now_ms();
+  if((e = centry_lookup(path)) == NULL)
+    return -1;
+  for(b = e->blocks; b != NULL; b = b->next)
+    if(b->idx == idx) {
+      if(b->expire <= now)
+        break;
+      n = b->len > off ? b->len - off : 0;
+      if(n > count)
+        n = count;
+      memcpy(buf, b->data + off, n);
+      break;
+    }
+  return n;
+}
+
+static void block_save(char *path, off_t idx, struct cblock *nb, unsigned int gen) {
+  struct centry *e;
+  struct cblock **pb, *b;
+  if(cache_gen_locked(path) != gen || (e = centry_get(path)) == NULL) {
+    free(nb);
+    return;
+  }
+  for(pb = &e->blocks; *pb != NULL; pb = &(*pb)->next)
+    if((*pb)->idx == idx) {
+      b = *pb;
+      *pb = b->next;
+      e->size -= RSCC_CACHE_BLOCK_SIZE;
+      cache_data -= RSCC_CACHE_BLOCK_SIZE;
+      free(b);
+      break;
+    }
+  nb->idx = idx;
+  nb->expire = now_ms() + cache_ms;
+  nb->next = e->blocks;
+  e->blocks = nb;
+  centry_add_size(e, RSCC_CACHE_BLOCK_SIZE);
+}
+
+/**************************************************************************/
+/* Prefetch                                                               */
+/**************************************************************************/
+int rscc_cache_prefetch(size_t bytes) {
+  int max;
+  if(!cache_enabled) {
+    errno = EINVAL;
+    return -1;
+  }
+  /* open, fstat64 and two getdents64 at least */
+  if((max = rscc_compound_max()) < 4) {
+    errno = ENOSYS;
+    return -1;
+  }
+  pthread_mutex_lock(&cache_mutex);
+  prefetch_room = max;
+  prefetch_blocks = (bytes + RSCC_CACHE_BLOCK_SIZE - 1) / RSCC_CACHE_BLOCK_SIZE;
+  if(prefetch_blocks > PREFETCH_MAX_BLOCKS)
+    prefetch_blocks = PREFETCH_MAX_BLOCKS;
+  if(prefetch_blocks > max - 2)
+    prefetch_blocks = max - 2;
+  pthread_mutex_unlock(&cache_mutex);
+  RSC_DEBUG(RSCD_REQ_RESP, "prefetch: %d blocks", prefetch_blocks);
+  return prefetch_blocks * RSCC_CACHE_BLOCK_SIZE;
+}
+
+/* The results are useless: the fds are already closed for the caller */
+static void send_closes(int *fds, int n) {
+  struct rscc_compound_call calls[PENDING_MAX];
+  int i;
+  if(n == 0)
+    return;
+  memset(calls, 0, n * sizeof(struct rscc_compound_call));
+  for(i = 0; i < n; i++) {
+    calls[i].op = RSCC_COMPOUND_CLOSE;
+    calls[i].chain = RSC_COMPOUND_NOCHAIN;
+    calls[i].fd = fds[i];
+  }
+  rscc_compound(calls, n);
+}
+
+void rscc_cache_flush(void) {
+  int fds[PENDING_MAX], n;
+  pthread_mutex_lock(&cache_mutex);
+  n = npending;
+  memcpy(fds, pending_fds, n * sizeof(int));
+  npending = 0;
+  pthread_mutex_unlock(&cache_mutex);
+  send_closes(fds, n);
+}
+
+static int block_cached(struct centry *e, off_t idx, long long now) {
+  struct cblock *b;
+  for(b = e->blocks; b != NULL; b = b->next)
+    if(b->idx == idx)
+      return b->expire > now;
+  return 0;
+}
+
+/* Opens 'pathname' with a compound request which carries the deferred
+ * closes and reads what the cache doesn't know: the attributes, the
+ * first blocks of a regular file or the content of a directory.
+ * '*srv_moved' is set if the position of the new fd is changed. */
+static int prefetch_open(char *pathname, int flags, int *srv_moved) {
+  struct rscc_compound_call calls[RSC_COMPOUND_MAX];
+  struct cblock *blocks[PREFETCH_MAX_BLOCKS];
+  off_t idxs[PREFETCH_MAX_BLOCKS];
+  struct stat64 st;
+  struct centry *e;
+  char *dents = NULL, *d, dents_end[DENTS_END_SIZE];
+  int closefds[PENDING_MAX];
+  int nclose = 0, nblocks = 0, n = 0, i, op;
+  int stat_i = -1, dents_i = -1, block_i = -1;
+  int ret, err, need_stat, isdir, maxb;
+  long long now = now_ms();
+  unsigned int gen;
+
+  pthread_mutex_lock(&cache_mutex);
+  gen = cache_gen_locked(pathname);
+  if((e = centry_field(pathname, CE_STAT)) != NULL && e->err[CE_STAT] != 0) {
+    /* The open fails */
+    pthread_mutex_unlock(&cache_mutex);
+    return rscc_open(pathname, flags);
+  }
+  need_stat = (e == NULL);
+  isdir = (flags & O_DIRECTORY) || (e != NULL && S_ISDIR(e->st.st_mode));
+  if(isdir) {
+    if(centry_field(pathname, CE_DENTS) == NULL)
+      dents = malloc(DENTS_BUF_SIZE);
+  } else if(e == NULL || S_ISREG(e->st.st_mode)) {
+    /* The first block of an empty file is an empty block */
+    maxb = prefetch_blocks;
+    if(e != NULL && e->st.st_size / RSCC_CACHE_BLOCK_SIZE + 1 < maxb)
+      maxb = e->st.st_size / RSCC_CACHE_BLOCK_SIZE + 1;
+    if((e = centry_lookup(pathname)) != NULL) {
+      for(i = 0; i < maxb; i++)
+        if(!block_cached(e, i, now))
+          idxs[nblocks++] = i;
+    } else
+      for(i = 0; i < maxb; i++)
+        idxs[nblocks++] = i;
+  }
+  /* The deferred closes fill the rest of the request */
+  nclose = prefetch_room - 1 - need_stat - (dents != NULL ? 2 : nblocks);
+  if(nclose > npending)
+    nclose = npending;
+  for(i = 0; i < nclose; i++)
+    closefds[i] = pending_fds[--npending];
+  pthread_mutex_unlock(&cache_mutex);
+
+  for(i = 0; i < nblocks; i++)
+    if((blocks[i] = malloc(sizeof(struct cblock) + RSCC_CACHE_BLOCK_SIZE)) == NULL)
+      break;
+  nblocks = i;
+  if(!need_stat && dents == NULL && nblocks == 0 && nclose == 0)
+    return rscc_open(pathname, flags);
+
+  memset(calls, 0, sizeof(calls));
+  for(i = 0; i < nclose; i++, n++) {
+    calls[n].op = RSCC_COMPOUND_CLOSE;
+    calls[n].chain = RSC_COMPOUND_NOCHAIN;
+    calls[n].fd = closefds[i];
+  }
+  op = n++;
+  calls[op].op = RSCC_COMPOUND_OPEN;
+  calls[op].chain = RSC_COMPOUND_NOCHAIN;
+  calls[op].path = pathname;
+  calls[op].open_flags = flags;
+  if(need_stat) {
+    stat_i = n++;
+    calls[stat_i].op = RSCC_COMPOUND_FSTAT64;
+    calls[stat_i].chain = op;
+    calls[stat_i].buf = &st;
+  }
+  if(dents != NULL) {
+    dents_i = n;
+    calls[n].op = calls[n + 1].op = RSCC_COMPOUND_GETDENTS64;
+    calls[n].chain = calls[n + 1].chain = op;
+    calls[n].buf = dents;
+    calls[n].count = DENTS_BUF_SIZE;
+    calls[n + 1].buf = dents_end;
+    calls[n + 1].count = DENTS_END_SIZE;
+    n += 2;
+  }
+  /* The reads of something else than a regular file could have side
+   * effects */
+  for(i = 0, block_i = n; i < nblocks; i++, n++) {
+    calls[n].op = RSCC_COMPOUND_PREAD64;
+    calls[n].chain = op;
+    calls[n].flags = RSC_COMPOUND_IFREG;
+    calls[n].buf = blocks[i]->data;
+    calls[n].count = RSCC_CACHE_BLOCK_SIZE;
+    calls[n].offset = idxs[i] * RSCC_CACHE_BLOCK_SIZE;
+  }
+
+  if(rscc_compound(calls, n) < 0) {
+    ret = -1;
+    err = EIO;
+  } else {
+    ret = calls[op].retval;
+    err = calls[op].err;
+  }
+
+  pthread_mutex_lock(&cache_mutex);
+  stats.prefetches++;
+  if(ret >= 0) {
+    if(stat_i >= 0 && calls[stat_i].retval == 0 &&
+        (e = centry_set(pathname, CE_STAT, 0, gen)) != NULL)
+      e->st = st;
+    if(dents_i >= 0 && calls[dents_i].retval >= 0) {
+      int len = calls[dents_i].retval;
+      *srv_moved = 1;
+      /* Only a complete content is saved */
+      if(calls[dents_i + 1].retval == 0 && (e = centry_set(pathname, CE_DENTS, 0, gen)) != NULL &&
+          (d = malloc(len > 0 ? len : 1)) != NULL) {
+        memcpy(d, dents, len);
+        e->size -= e->dents_len;
+        cache_data -= e->dents_len;
+        free(e->dents);
+        e->dents = d;
+        e->dents_len = len;
+        centry_add_size(e, len);
+      }
+    }
+    /* The blocks after the end of the file are not saved */
+    for(i = 0; i < nblocks; i++) {
+      int len = calls[block_i + i].retval;
+      if(len < 0)
+        break;
+      blocks[i]->len = len;
+      block_save(pathname, idxs[i], blocks[i], gen);
+      blocks[i] = NULL;
+      if(len < RSCC_CACHE_BLOCK_SIZE) {
+        i++;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&cache_mutex);
+  for(i = 0; i < nblocks; i++)
+    free(blocks[i]);
+  free(dents);
+  errno = err;
+  return ret;
+}
+
+/* Reads from the blocks of the file. Returns -2 if the data cannot be
+ * read with pread. */
+static int cached_read(int fd, char *path, void *buf, size_t count, off_t offset) {
+  size_t done = 0;
+  int hit = 1;
+
+  while(done < count) {
+    off_t pos = offset + done;
+    off_t idx = pos / RSCC_CACHE_BLOCK_SIZE;
+    int off = pos % RSCC_CACHE_BLOCK_SIZE;
+    struct cblock *nb;
+    unsigned int gen;
+    int n;
+
+    pthread_mutex_lock(&cache_mutex);
+    n = block_copy(path, idx, off, (char *)buf + done, count - done);
+    gen = cache_gen_locked(path);
+    pthread_mutex_unlock(&cache_mutex);
+    if(n < 0) {
+      hit = 0;
+      if((nb = malloc(sizeof(struct cblock) + RSCC_CACHE_BLOCK_SIZE)) == NULL) {
+        errno = ENOMEM;
+        return done > 0 ? done : -1;
+      }
+      nb->len = rscc_pread64(fd, nb->data, RSCC_CACHE_BLOCK_SIZE, idx * RSCC_CACHE_BLOCK_SIZE);
+      if(nb->len < 0) {
+        int err = errno;
+        free(nb);
+        errno = err;
+        if(done > 0)
+          return done;
+        return (err == ESPIPE || err == EINVAL) ? -2 : -1;
+      }
+      n = nb->len > off ? nb->len - off : 0;
+      if(n > count - done)
+        n = count - done;
+      memcpy((char *)buf + done, nb->data + off, n);
+      pthread_mutex_lock(&cache_mutex);
+      stats.misses[RSCC_CACHE_READ]++;
+      block_save(path, idx, nb, gen);
+      pthread_mutex_unlock(&cache_mutex);
+    }
+    done += n;
+    /* End of file */
+    if(off + n < RSCC_CACHE_BLOCK_SIZE && done < count)
+      break;
+  }
+  if(hit) {
+    pthread_mutex_lock(&cache_mutex);
+    stats.hits[RSCC_CACHE_READ]++;
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  return done;
+}
+
+/* Returns a copy of the path and the position of the fd in local mode */
+static char *cfd_local_file(int fd, off_t *pos) {
+  struct cfd *cf;
+  char *path = NULL;
+  if(!cache_enabled)
+    return NULL;
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fd)) != NULL && cf->local && !cf->isdir) {
+    path = strdup(cf->path);
+    *pos = cf->pos;
+  }
+  pthread_mutex_unlock(&cache_mutex);
+  return path;
+}
+
+/* pread is not supported by the file: it leaves the local mode */
+static void cfd_no_pread(int fd) {
+  struct cfd *cf;
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fd)) != NULL)
+    cfd_sync(fd, cf);
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+int rscc_cache_read(int fd, void *buf, size_t count) {
+  off_t pos;
+  char *path;
+  int ret;
+  struct cfd *cf;
+
+  if((path = cfd_local_file(fd, &pos)) == NULL)
+    return rscc_read(fd, buf, count);
+  ret = cached_read(fd, path, buf, count, pos);
+  free(path);
+  if(ret == -2) {
+    cfd_no_pread(fd);
+    return rscc_read(fd, buf, count);
+  }
+  if(ret > 0) {
+    pthread_mutex_lock(&cache_mutex);
+    if((cf = cfd_get(fd)) != NULL && cf->local)
+      cf->pos += ret;
+    pthread_mutex_unlock(&cache_mutex);
+  }
+  return ret;
+}
+
+int rscc_cache_pread64(int fd, void *buf, size_t count, off_t offset) {
+  off_t pos;
+  char *path;
+  int ret;
+
+  if((path = cfd_local_file(fd, &pos)) == NULL)
+    return rscc_pread64(fd, buf, count, offset);
+  ret = cached_read(fd, path, buf, count, offset);
+  free(path);
+  if(ret == -2) {
+    cfd_no_pread(fd);
+    return rscc_pread64(fd, buf, count, offset);
+  }
+  return ret;
+}
+
+/* Sets the local position, returns -1 if the fd must use the server one */
+static int cfd_seek(struct cfd *cf, off_t offset, int whence, off_t *result) {
+  off_t pos;
+  char *d;
+  if(cf->isdir) {
+    struct dirent64 *de;
+    if(whence == SEEK_CUR && offset == 0) {
+      *result = cf->dents != NULL ? cf->last_doff : 0;
+      return 0;
+    }
+    if(whence != SEEK_SET)
+      return -1;
+    /* rewinddir: the next getdents gets a new snapshot */
+    if(offset == 0) {
+      free(cf->dents);
+      cf->dents = NULL;
+      cf->pos = cf->last_doff = 0;
+      *result = 0;
+      return 0;
+    }
+    /* seekdir: the offset must be one of the snapshot */
+    if(cf->dents == NULL)
+      return -1;
+    for(d = cf->dents; d < cf->dents + cf->dents_len; d += de->d_reclen) {
+      de = (struct dirent64 *)d;
+      if(de->d_off == offset) {
+        cf->pos = d + de->d_reclen - cf->dents;
+        cf->last_doff = offset;
+        *result = offset;
+        return 0;
+      }
+    }
+    return -1;
+  }
+  switch(whence) {
+    case SEEK_SET: pos = offset; break;
+    case SEEK_CUR: pos = cf->pos + offset; break;
+    default: return -1;
+  }
+  if(pos < 0)
+    return -2;
+  *result = cf->pos = pos;
+  return 0;
+}
+
+int rscc_cache_lseek(int fildes, off_t offset, int whence) {
+  struct cfd *cf;
+  off_t result;
+  int ret = -1, local = 0;
+
+  if(!cache_enabled)
+    return rscc_lseek(fildes, offset, whence);
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fildes)) != NULL && cf->local) {
+    local = 1;
+    if((ret = cfd_seek(cf, offset, whence, &result)) == -1)
+      cfd_sync(fildes, cf);
+  }
+  pthread_mutex_unlock(&cache_mutex);
+  if(local && ret == 0)
+    return result;
+  if(local && ret == -2) {
+    errno = EINVAL;
+    return -1;
+  }
+  return rscc_lseek(fildes, offset, whence);
+}
+
+int rscc_cache__llseek(unsigned int fd, unsigned long int offset_high, unsigned long int offset_low, loff_t *result, unsigned int whence) {
+  struct cfd *cf;
+  off_t res;
+  int ret = -1, local = 0;
+
+  if(!cache_enabled)
+    return rscc__llseek(fd, offset_high, offset_low, result, whence);
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fd)) != NULL && cf->local) {
+    local = 1;
+    if((ret = cfd_seek(cf, (off_t)(((unsigned long long)offset_high << 32) | offset_low), whence, &res)) == -1)
+      cfd_sync(fd, cf);
+  }
+  pthread_mutex_unlock(&cache_mutex);
+  if(local && ret == 0) {
+    *result = res;
+    return 0;
+  }
+  if(local && ret == -2) {
+    errno = EINVAL;
+    return -1;
+  }
+  return rscc__llseek(fd, offset_high, offset_low, result, whence);
+}
+
+/* Reads all the directory from the server */
+static char *read_dents(unsigned int fd, int *len) {
+  char *buf = NULL, *nbuf;
+  int size = 0, n;
+  *len = 0;
+  do {
+    if(size - *len < DENTS_BUF_SIZE) {
+      size += DENTS_BUF_SIZE;
+      if((nbuf = realloc(buf, size)) == NULL) {
+        free(buf);
+        errno = ENOMEM;
+        return NULL;
+      }
+      buf = nbuf;
+    }
+    n = rscc_getdents64(fd, (struct dirent64 *)(buf + *len), size - *len);
+    if(n < 0) {
+      int err = errno;
+      free(buf);
+      errno = err;
+      return NULL;
+    }
+    *len += n;
+  } while(n > 0);
+  return buf;
+}
+
+int rscc_cache_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count) {
+  struct cfd *cf;
+  struct centry *e;
+  char *path, *dents, *d;
+  int len, ret, srv_start;
+  unsigned int gen;
+
+  if(!cache_enabled)
+    return rscc_getdents64(fd, dirp, count);
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(fd)) == NULL || !cf->local || !cf->isdir) {
+    pthread_mutex_unlock(&cache_mutex);
+    return rscc_getdents64(fd, dirp, count);
+  }
+  if(cf->dents == NULL) {
+    /* A new snapshot, from the cache or from the server */
+    if((e = centry_field(cf->path, CE_DENTS)) != NULL && e->err[CE_DENTS] == 0 &&
+        (cf->dents = malloc(e->dents_len > 0 ? e->dents_len : 1)) != NULL) {
+      stats.hits[RSCC_CACHE_GETDENTS]++;
+      memcpy(cf->dents, e->dents, e->dents_len);
+      cf->dents_len = e->dents_len;
+    } else {
+      stats.misses[RSCC_CACHE_GETDENTS]++;
+      path = strdup(cf->path);
+      srv_start = cf->srv_start;
+      gen = cache_gen_locked(cf->path);
+      pthread_mutex_unlock(&cache_mutex);
+      if(path == NULL) {
+        errno = ENOMEM;
+        return -1;
+      }
+      if(!srv_start && rscc_lseek(fd, 0, SEEK_SET) != 0)
+        dents = NULL;
+      else
+        dents = read_dents(fd, &len);
+      ret = errno;
+      pthread_mutex_lock(&cache_mutex);
+      if((cf = cfd_get(fd)) != NULL)
+        cf->srv_start = 0;
+      if(dents == NULL || cf == NULL) {
+        pthread_mutex_unlock(&cache_mutex);
+        free(path);
+        free(dents);
+        errno = dents == NULL ? ret : EBADF;
+        return -1;
+      }
+      /* Another thread got its snapshot first */
+      if(cf->dents != NULL) {
+        free(dents);
+        dents = NULL;
+      } else {
+        cf->dents = dents;
+        cf->dents_len = len;
+      }
+      if(dents != NULL && (e = centry_set(path, CE_DENTS, 0, gen)) != NULL &&
+          (d = malloc(len > 0 ? len : 1)) != NULL) {
+        memcpy(d, dents, len);
+        e->size -= e->dents_len;
+        cache_data -= e->dents_len;
+        free(e->dents);
+        e->dents = d;
+        e->dents_len = len;
+        centry_add_size(e, len);
+      } else if(e != NULL)
+        e->valid &= ~(1 << CE_DENTS);
+      free(path);
+    }
+    cf->pos = 0;
+  }
+  /* I copy the whole records fitting in 'dirp' */
+  for(len = 0; cf->pos < cf->dents_len; ) {
+    struct dirent64 *de = (struct dirent64 *)(cf->dents + cf->pos);
+    if(len + de->d_reclen > count)
+      break;
+    memcpy((char *)dirp + len, de, de->d_reclen);
+    len += de->d_reclen;
+    cf->pos += de->d_reclen;
+    cf->last_doff = de->d_off;
+  }
+  ret = len == 0 && cf->pos < cf->dents_len;
+  pthread_mutex_unlock(&cache_mutex);
+  if(ret) {
+    errno = EINVAL;
+    return -1;
+  }
+  return len;
+}
+
+/* The new fd shares the position of the old one: both leave the
+ * local mode */
+static void cfd_dup(int oldfd, int newfd) {
+  struct cfd *cf, *ncf;
+  pthread_mutex_lock(&cache_mutex);
+  if((cf = cfd_get(oldfd)) != NULL) {
+    cfd_sync(oldfd, cf);
+    if(newfd >= 0 && newfd != oldfd && (ncf = cfd_new(newfd, cf->path, cf->flags)) != NULL)
+      ncf->isdir = cf->isdir;
+  }
+  pthread_mutex_unlock(&cache_mutex);
+}
+
+int rscc_cache_dup(int oldfd) {
+  int ret;
+  if(!cache_enabled)
+    return rscc_dup(oldfd);
+  cfd_dup(oldfd, -1);
+  if((ret = rscc_dup(oldfd)) >= 0)
+    cfd_dup(oldfd, ret);
+  return ret;
+}
+
+int rscc_cache_dup2(int oldfd, int newfd) {
+  int ret, pending;
+  if(!cache_enabled)
+    return rscc_dup2(oldfd, newfd);
+  /* dup2 closes the deferred close of 'newfd' */
+  pthread_mutex_lock(&cache_mutex);
+  pending = pending_del(newfd);
+  pthread_mutex_unlock(&cache_mutex);
+  cfd_dup(oldfd, -1);
+  ret = rscc_dup2(oldfd, newfd);
+  if(ret < 0 && pending) {
+    int err = errno;
+    rscc_close(newfd);
+    errno = err;
+  }
+  if(ret >= 0 && ret != oldfd) {
+    pthread_mutex_lock(&cache_mutex);
+    cfd_free(ret);
+    pthread_mutex_unlock(&cache_mutex);
+    cfd_dup(oldfd, ret);
+  }
+  return ret;
+}
+
+int rscc_cache_fcntl(int fd, int cmd, ...) {
+  va_list ap;
+  long arg;
+  int ret;
+  va_start(ap, cmd);
+  arg = va_arg(ap, long);
+  va_end(ap);
+  if(!cache_enabled || (cmd != F_DUPFD && cmd != F_DUPFD_CLOEXEC))
+    return rscc_fcntl(fd, cmd, arg);
+  cfd_dup(fd, -1);
+  if((ret = rscc_fcntl(fd, cmd, arg)) >= 0)
+    cfd_dup(fd, ret);
+  return ret;
+}
+
+/**************************************************************************/
+/* Calls changing the cached data                                         */
+/**************************************************************************/
+/* They return 'ret' of the call, after forgetting what it changed */
+static int forget_fd_ret(int ret, int fd) {
+  int err = errno;
+  cache_forget_fd(fd);
+  errno = err;
+  return ret;
+}
+
+static int forget_path_ret(int ret, char *path, int recursive) {
+  int err = errno;
+  cache_forget(path, recursive);
+  errno = err;
+  return ret;
+}
+
+int rscc_cache_write(int fd, void *buf, size_t count) {
+  return forget_fd_ret(rscc_write(fd, buf, count), fd);
+}
+
+int rscc_cache_pwrite64(int fd, void *buf, size_t count, off_t offset) {
+  return forget_fd_ret(rscc_pwrite64(fd, buf, count, offset), fd);
+}
+
+int rscc_cache_ftruncate64(int fd, __off64_t length) {
+  return forget_fd_ret(rscc_ftruncate64(fd, length), fd);
+}
+
+int rscc_cache_fchmod(int fildes, mode_t mode) {
+  return forget_fd_ret(rscc_fchmod(fildes, mode), fildes);
+}
+
+int rscc_cache_fchown(int fd, uid_t owner, gid_t group) {
+  return forget_fd_ret(rscc_fchown(fd, owner, group), fd);
+}
+
+int rscc_cache_fchown32(int fd, uid_t owner, gid_t group) {
+  return forget_fd_ret(rscc_fchown32(fd, owner, group), fd);
+}
+
+int rscc_cache_truncate64(char *path, __off64_t length) {
+  return forget_path_ret(rscc_truncate64(path, length), path, 0);
+}
+
+int rscc_cache_utime(char *filename, struct utimbuf *buf) {
+  return forget_path_ret(rscc_utime(filename, buf), filename, 0);
+}
+
+int rscc_cache_utimes(char *filename, struct timeval tv[2]) {
+  return forget_path_ret(rscc_utimes(filename, tv), filename, 0);
+}
+
+/* The permissions of a directory and the namespace changes affect
+ * also the paths below it */
+int rscc_cache_chmod(char *path, mode_t mode) {
+  return forget_path_ret(rscc_chmod(path, mode), path, 1);
+}
+
+int rscc_cache_chown(char *path, uid_t owner, gid_t group) {
+  return forget_path_ret(rscc_chown(path, owner, group), path, 1);
+}
+
+int rscc_cache_lchown(char *path, uid_t owner, gid_t group) {
+  return forget_path_ret(rscc_lchown(path, owner, group), path, 1);
+}
+
+int rscc_cache_chown32(char *path, uid_t owner, gid_t group) {
+  return forget_path_ret(rscc_chown32(path, owner, group), path, 1);
+}
+
+int rscc_cache_lchown32(char *path, uid_t owner, gid_t group) {
+  return forget_path_ret(rscc_lchown32(path, owner, group), path, 1);
+}
+
+int rscc_cache_unlink(char *pathname) {
+  return forget_path_ret(rscc_unlink(pathname), pathname, 1);
+}
+
+int rscc_cache_rmdir(char *pathname) {
+  return forget_path_ret(rscc_rmdir(pathname), pathname, 1);
+}
+
+int rscc_cache_mkdir(char *pathname, mode_t mode) {
+  return forget_path_ret(rscc_mkdir(pathname, mode), pathname, 1);
+}
+
+int rscc_cache_symlink(char *oldpath, char *newpath) {
+  return forget_path_ret(rscc_symlink(oldpath, newpath), newpath, 1);
+}
+
+int rscc_cache_link(char *oldpath, char *newpath) {
+  int ret = rscc_link(oldpath, newpath);
+  /* The link count of 'oldpath' changes too */
+  forget_path_ret(ret, oldpath, 0);
+  return forget_path_ret(ret, newpath, 1);
+}
+
+int rscc_cache_rename(char *oldpath, char *newpath) {
+  int ret = rscc_rename(oldpath, newpath);
+  forget_path_ret(ret, oldpath, 1);
+  return forget_path_ret(ret, newpath, 1);
+}
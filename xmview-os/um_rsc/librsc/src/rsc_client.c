@@ -31,6 +31,7 @@
 #include "rsc_client.h"
 #include "rsc_consts.h"
 #include "event_sub.h"
+#include "rsc_shm.h"
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -40,6 +41,8 @@
 #include <arpa/inet.h>
 #include <sys/uio.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <sys/un.h>
 
 
 #include <dirent.h>
@@ -92,6 +95,11 @@ static int rsc_event_sub_fd;
 static 
 #endif
 struct ioctl_cache *ioctl_cache;
+static pthread_mutex_t ioctl_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct rscc_call;
+static void rscc_call_end(struct rscc_call *call);
+static int rscc_shm_init(void);
 
 int rscc_init(int client_fd, int event_sub_fd, struct reg_cbs **rc, enum arch c_arch, enum arch s_arch) {
   if(c_arch < ARCH_FIRST || c_arch > ARCH_LAST) 
@@ -113,6 +121,385 @@ int rscc_init(int client_fd, int event_sub_fd, struct reg_cbs **rc, enum arch c_
   ioctl_cache = ioctl_cache_init(20);
   if(ioctl_cache == NULL)
     return -1;
+  /* A server on the same host can share the memory with me */
+  if(c_arch == s_arch && rscc_shm_init() == -1)
+    return -1;
+  return 0;
+}
+
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  Calls in flight                                                   ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+/* With protocol v1 there is a single call at a time: the socket is locked
+ * from the request to the end of the response. With protocol v2 every
+ * message is preceded by a rsc_frame_header: the requests are sent as soon
+ * as they are ready and a receiving thread gives each response to the
+ * call with the same id, in the order they arrive. The responses of at
+ * least RSC_DIRECT_MIN bytes are read from the socket by the call itself,
+ * directly into the buffers of the caller. With the shared memory the v1
+ * messages go through the rings of the region instead of the socket. */
+#define RSC_DIRECT_MIN (16 * 1024)
+
+struct rscc_call {
+  u_int32_t id;
+  /* The whole response message (v2) */
+  void *resp;
+  int resp_size;
+  int pos;
+  /* 1 when the response is arrived, -1 if the connection was lost */
+  int done;
+  /* 1 if the response is still in the socket ('resp' is NULL), -1 if
+   * the connection broke while the call was reading it */
+  int direct;
+  pthread_cond_t cond;
+  struct rscc_call *next;
+};
+
+static int rsc_proto = RSC_PROTO_V1;
+/* v1: the call in progress; v2: the list of pending calls */
+static pthread_mutex_t rsc_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t rsc_send_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct rscc_call rsc_v1_call;
+static struct rscc_call *rsc_pending;
+static u_int32_t rsc_next_id;
+static int rsc_conn_lost;
+/* The region shared with a server on the same host, NULL if none */
+static struct rsc_shm *rsc_shm;
+/* The socket belongs to a call reading its response: 1 while it 
+ * reads, 0 when it has finished, -1 if the connection broke */
+static int rsc_direct;
+static pthread_cond_t rsc_direct_cond = PTHREAD_COND_INITIALIZER;
+
+/* Removes the call 'id' from the pending ones, NULL if there isn't.
+ * rsc_call_mutex must be locked */
+static struct rscc_call *rscc_call_take(u_int32_t id) {
+  struct rscc_call *call, **pp;
+  for(pp = &rsc_pending; *pp != NULL && (*pp)->id != id; pp = &((*pp)->next))
+    ;
+  if((call = *pp) != NULL)
+    *pp = call->next;
+  return call;
+}
+
+/* Reads and throws away the next 'size' bytes of the socket */
+static int rscc_discard(int size) {
+  char buf[4096];
+  int n;
+  while(size > 0) {
+    n = size > sizeof(buf) ? sizeof(buf) : size;
+    if(read_n_bytes(rsc_sockfd, buf, n) != n)
+      return -1;
+    size -= n;
+  }
+  return 0;
+}
+
+static void *rscc_recv_loop(void *arg) {
+  struct rsc_frame_header frame;
+  struct rscc_call *call;
+  void *resp;
+  int size;
+
+  while(read_n_bytes(rsc_sockfd, &frame, sizeof(frame)) == sizeof(frame)) {
+    if(ntohl(frame.frame_size) > RSC_FRAME_MAX) {
+      RSC_DEBUG(RSCD_MINIMAL, "Frame of %u bytes, closing the connection", ntohl(frame.frame_size));
+      break;
+    }
+    size = ntohl(frame.frame_size);
+    pthread_mutex_lock(&rsc_call_mutex);
+    call = rscc_call_take(ntohl(frame.frame_id));
+    if(call != NULL && size >= RSC_DIRECT_MIN) {
+      /* I wait for the call to read the response */
+      call->resp_size = size;
+      call->direct = 1;
+      call->done = 1;
+      rsc_direct = 1;
+      pthread_cond_signal(&call->cond);
+      while(rsc_direct == 1)
+        pthread_cond_wait(&rsc_direct_cond, &rsc_call_mutex);
+      pthread_mutex_unlock(&rsc_call_mutex);
+      if(rsc_direct == -1)
+        break;
+      continue;
+    }
+    pthread_mutex_unlock(&rsc_call_mutex);
+    if(call == NULL) {
+      /* Nobody waits for it, I throw it away without buffering it */
+      RSC_DEBUG(RSCD_MINIMAL, "Response for the unknown request %u", ntohl(frame.frame_id));
+      if(rscc_discard(size) < 0)
+        break;
+      continue;
+    }
+    /* Only the small responses are buffered (size < RSC_DIRECT_MIN) */
+    if((resp = malloc(size)) == NULL || read_n_bytes(rsc_sockfd, resp, size) != size) {
+      free(resp);
+      pthread_mutex_lock(&rsc_call_mutex);
+      call->done = -1;
+      pthread_cond_signal(&call->cond);
+      pthread_mutex_unlock(&rsc_call_mutex);
+      break;
+    }
+    pthread_mutex_lock(&rsc_call_mutex);
+    call->resp = resp;
+    call->resp_size = size;
+    call->done = 1;
+    pthread_cond_signal(&call->cond);
+    pthread_mutex_unlock(&rsc_call_mutex);
+  }
+
+  /* The connection is lost or the server is broken: I close it, the
+   * pending calls fail and no new one is sent */
+  shutdown(rsc_sockfd, SHUT_RDWR);
+  pthread_mutex_lock(&rsc_call_mutex);
+  rsc_conn_lost = 1;
+  for(call = rsc_pending; call != NULL; call = call->next) {
+    call->done = -1;
+    pthread_cond_signal(&call->cond);
+  }
+  rsc_pending = NULL;
+  pthread_mutex_unlock(&rsc_call_mutex);
+  return NULL;
+}
+
+/* Sends the request in 'v' and returns the number of bytes sent; if
+ * the request has been sent, '*callp' is the call that receives
+ * the response and that must be closed by rscc_call_end(). */
+static int rscc_call_send(struct rscc_call **callp, struct iovec *v, int count, int nbytes) {
+  struct rscc_call *call;
+  struct rsc_frame_header frame;
+  struct iovec *fv;
+  int nwrite;
+
+  *callp = NULL;
+  if(rsc_proto == RSC_PROTO_V1) {
+    pthread_mutex_lock(&rsc_call_mutex);
+    if(rsc_shm != NULL)
+      nwrite = rsc_ring_writev(rsc_shm, RSC_RING_REQ, rsc_sockfd, v, count, nbytes);
+    else
+      nwrite = writev_n_bytes(rsc_sockfd, v, count, nbytes);
+    if(nwrite == nbytes)
+      *callp = &rsc_v1_call;
+    else
+      pthread_mutex_unlock(&rsc_call_mutex);
+    return nwrite;
+  }
+
+  call = calloc(1, sizeof(struct rscc_call));
+  fv = calloc(count + 1, sizeof(struct iovec));
+  if(call == NULL || fv == NULL) {
+    free(call); free(fv);
+    return -1;
+  }
+  pthread_cond_init(&call->cond, NULL);
+  pthread_mutex_lock(&rsc_call_mutex);
+  if(rsc_conn_lost) {
+    pthread_mutex_unlock(&rsc_call_mutex);
+    pthread_cond_destroy(&call->cond);
+    free(call); free(fv);
+    return -1;
+  }
+  call->id = rsc_next_id++;
+  call->next = rsc_pending;
+  rsc_pending = call;
+  pthread_mutex_unlock(&rsc_call_mutex);
+
+  frame.frame_id = htonl(call->id);
+  frame.frame_size = htonl(nbytes);
+  fv[0].iov_base = &frame;
+  fv[0].iov_len = sizeof(frame);
+  memcpy(fv + 1, v, count * sizeof(struct iovec));
+  /* The frames must not be interleaved */
+  pthread_mutex_lock(&rsc_send_mutex);
+  nwrite = writev_n_bytes(rsc_sockfd, fv, count + 1, sizeof(frame) + nbytes);
+  pthread_mutex_unlock(&rsc_send_mutex);
+  free(fv);
+  if(nwrite != sizeof(frame) + nbytes) {
+    call->done = -1;
+    rscc_call_end(call);
+    return -1;
+  }
+  *callp = call;
+  return nbytes;
+}
+
+/* v2: waits for the response of 'call' */
+static int rscc_call_wait(struct rscc_call *call) {
+  pthread_mutex_lock(&rsc_call_mutex);
+  while(call->done == 0)
+    pthread_cond_wait(&call->cond, &rsc_call_mutex);
+  pthread_mutex_unlock(&rsc_call_mutex);
+  return call->done;
+}
+
+/* Reads the next 'size' bytes of the response of 'call' */
+static int rscc_call_recv(struct rscc_call *call, void *buf, int size) {
+  if(rsc_proto == RSC_PROTO_V1 && rsc_shm != NULL)
+    return rsc_ring_read(rsc_shm, RSC_RING_RESP, rsc_sockfd, buf, size);
+  if(rsc_proto == RSC_PROTO_V1)
+    return read_n_bytes(rsc_sockfd, buf, size);
+  if(rscc_call_wait(call) < 0 || call->direct == -1)
+    return -1;
+  if(size > call->resp_size - call->pos)
+    size = call->resp_size - call->pos;
+  if(call->direct) {
+    if(size > 0 && read_n_bytes(rsc_sockfd, buf, size) != size) {
+      call->direct = -1;
+      return -1;
+    }
+  } else
+    memcpy(buf, call->resp + call->pos, size);
+  call->pos += size;
+  return size;
+}
+
+static int rscc_call_recvv(struct rscc_call *call, struct iovec *v, int count, int nbytes) {
+  int i, n, nread;
+  if(rsc_proto == RSC_PROTO_V1 && rsc_shm != NULL)
+    return rsc_ring_readv(rsc_shm, RSC_RING_RESP, rsc_sockfd, v, count, nbytes);
+  if(rsc_proto == RSC_PROTO_V1)
+    return readv_n_bytes(rsc_sockfd, v, count, nbytes);
+  for(i = 0, nread = 0; i < count; i++) {
+    n = rscc_call_recv(call, v[i].iov_base, v[i].iov_len);
+    if(n < 0)
+      return -1;
+    nread += n;
+    if(n < v[i].iov_len)
+      break;
+  }
+  return nread;
+}
+
+static void rscc_call_end(struct rscc_call *call) {
+  struct rscc_call **pp;
+  if(rsc_proto == RSC_PROTO_V1) {
+    pthread_mutex_unlock(&rsc_call_mutex);
+    return;
+  }
+  if(call->direct) {
+    char buf[4096];
+    int n;
+    /* The rest of the response is not wanted, then the socket
+     * goes back to the receiving thread */
+    while(call->direct == 1 && call->pos < call->resp_size) {
+      n = call->resp_size - call->pos;
+      if(rscc_call_recv(call, buf, n > sizeof(buf) ? sizeof(buf) : n) < 0)
+        break;
+    }
+    pthread_mutex_lock(&rsc_call_mutex);
+    rsc_direct = (call->direct == 1) ? 0 : -1;
+    pthread_cond_signal(&rsc_direct_cond);
+    pthread_mutex_unlock(&rsc_call_mutex);
+  }
+  /* The call is still pending if the send failed */
+  pthread_mutex_lock(&rsc_call_mutex);
+  for(pp = &rsc_pending; *pp != NULL && *pp != call; pp = &((*pp)->next))
+    ;
+  if(*pp != NULL)
+    *pp = call->next;
+  pthread_mutex_unlock(&rsc_call_mutex);
+  pthread_cond_destroy(&call->cond);
+  free(call->resp);
+  free(call);
+}
+
+int rscc_set_proto(int version) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
+  pthread_t recv_thread;
+  int ret;
+
+  /* The rings carry a call at a time */
+  if(version < RSC_PROTO_V2 || rsc_proto == RSC_PROTO_V2 || rsc_shm != NULL)
+    return rsc_proto;
+
+  /* The probe is an ioctl request with a reserved code: a v1 server
+   * answers IOCTL_UNMANAGED. */
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(RSC_PROTO_PROBE);
+  v.iov_base = &req;
+  v.iov_len = sizeof(struct ioctl_req_header);
+  if(rscc_call_send(&call, &v, 1, v.iov_len) != v.iov_len)
+    return -1;
+  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+  if(ret == sizeof(struct ioctl_resp_header) &&
+      ntohl(resp.resp_size_type) == RSC_PROTO_V2) {
+    /* From now on the server speaks v2 */
+    if(pthread_create(&recv_thread, NULL, rscc_recv_loop, NULL) != 0)
+      ret = -1;
+    else {
+      pthread_detach(recv_thread);
+      rsc_proto = RSC_PROTO_V2;
+    }
+  }
+  pthread_mutex_unlock(&rsc_call_mutex);
+  if(ret != sizeof(struct ioctl_resp_header))
+    return -1;
+  RSC_DEBUG(RSCD_MINIMAL, "RSC protocol version %d", rsc_proto);
+  return rsc_proto;
+}
+
+int rscc_probe(u_int32_t probe) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
+  int ret;
+
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(probe);
+  v.iov_base = &req;
+  v.iov_len = sizeof(struct ioctl_req_header);
+  if(rscc_call_send(&call, &v, 1, v.iov_len) != v.iov_len)
+    return -1;
+  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+  rscc_call_end(call);
+  if(ret != sizeof(struct ioctl_resp_header))
+    return -1;
+  return ntohl(resp.resp_size_type);
+}
+
+/* On a unix domain socket the server is asked to share a memory region
+ * with me, sending the probe with the fd of the region. Returns -1 if the
+ * connection is lost, 0 with or without the region */
+static int rscc_shm_init(void) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct sockaddr_un addr;
+  socklen_t len = sizeof(addr);
+  struct rsc_shm *shm;
+  int fd, ret;
+
+  if(getsockname(rsc_sockfd, (struct sockaddr *)&addr, &len) == -1 || 
+      addr.sun_family != AF_UNIX)
+    return 0;
+  if((shm = rsc_shm_create(RSC_SHM_RING_SIZE, &fd)) == NULL)
+    return 0;
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(RSC_SHM_PROBE);
+  ret = rsc_shm_send_fd(rsc_sockfd, &req, sizeof(struct ioctl_req_header), fd);
+  close(fd);
+  if(ret != sizeof(struct ioctl_req_header) ||
+      read_n_bytes(rsc_sockfd, &resp, sizeof(struct ioctl_resp_header)) != sizeof(struct ioctl_resp_header)) {
+    rsc_shm_close(shm);
+    return -1;
+  }
+  /* An older server answers IOCTL_UNMANAGED */
+  if(ntohl(resp.resp_size_type) != RSC_SHM_PROBE) {
+    rsc_shm_close(shm);
+    return 0;
+  }
+  rsc_shm = shm;
+  RSC_DEBUG(RSCD_MINIMAL, "Requests through the shared memory");
   return 0;
 }
 
@@ -9485,6 +9872,7 @@ struct iovec *rscc_manage_write_response(struct sys_resp_header *resp_header, in
 /*##########################################################*/
 int rscc__llseek(unsigned int fd, unsigned long int offset_high, unsigned long int offset_low, loff_t *result, unsigned int whence) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9497,7 +9885,7 @@ int rscc__llseek(unsigned int fd, unsigned long int offset_high, unsigned long i
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9507,9 +9895,10 @@ int rscc__llseek(unsigned int fd, unsigned long int offset_high, unsigned long i
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9521,19 +9910,23 @@ int rscc__llseek(unsigned int fd, unsigned long int offset_high, unsigned long i
   v = rscc_manage__llseek_response(&resp_header, &iovec_count, &nbytes, fd, offset_high, offset_low, result, whence);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9546,7 +9939,7 @@ int rscc_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9556,9 +9949,10 @@ int rscc_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9570,19 +9964,23 @@ int rscc_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
   v = rscc_manage_accept_response(&resp_header, &iovec_count, &nbytes, sockfd, addr, addrlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_access(char *pathname, int mode) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9595,7 +9993,7 @@ int rscc_access(char *pathname, int mode) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9605,9 +10003,10 @@ int rscc_access(char *pathname, int mode) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9619,19 +10018,23 @@ int rscc_access(char *pathname, int mode) {
   v = rscc_manage_access_response(&resp_header, &iovec_count, &nbytes, pathname, mode);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_adjtimex(struct timex *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9644,7 +10047,7 @@ int rscc_adjtimex(struct timex *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9654,9 +10057,10 @@ int rscc_adjtimex(struct timex *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9668,19 +10072,23 @@ int rscc_adjtimex(struct timex *buf) {
   v = rscc_manage_adjtimex_response(&resp_header, &iovec_count, &nbytes, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_bind(int sockfd, struct sockaddr *my_addr, socklen_t addrlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9693,7 +10101,7 @@ int rscc_bind(int sockfd, struct sockaddr *my_addr, socklen_t addrlen) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9703,9 +10111,10 @@ int rscc_bind(int sockfd, struct sockaddr *my_addr, socklen_t addrlen) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9717,19 +10126,23 @@ int rscc_bind(int sockfd, struct sockaddr *my_addr, socklen_t addrlen) {
   v = rscc_manage_bind_response(&resp_header, &iovec_count, &nbytes, sockfd, my_addr, addrlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_chdir(char *path) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9742,7 +10155,7 @@ int rscc_chdir(char *path) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9752,9 +10165,10 @@ int rscc_chdir(char *path) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9766,19 +10180,23 @@ int rscc_chdir(char *path) {
   v = rscc_manage_chdir_response(&resp_header, &iovec_count, &nbytes, path);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_chmod(char *path, mode_t mode) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9791,7 +10209,7 @@ int rscc_chmod(char *path, mode_t mode) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9801,9 +10219,10 @@ int rscc_chmod(char *path, mode_t mode) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9815,19 +10234,23 @@ int rscc_chmod(char *path, mode_t mode) {
   v = rscc_manage_chmod_response(&resp_header, &iovec_count, &nbytes, path, mode);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_chown(char *path, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9840,7 +10263,7 @@ int rscc_chown(char *path, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9850,9 +10273,10 @@ int rscc_chown(char *path, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9864,19 +10288,23 @@ int rscc_chown(char *path, uid_t owner, gid_t group) {
   v = rscc_manage_chown_response(&resp_header, &iovec_count, &nbytes, path, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_chown32(char *path, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9889,7 +10317,7 @@ int rscc_chown32(char *path, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9899,9 +10327,10 @@ int rscc_chown32(char *path, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9913,19 +10342,23 @@ int rscc_chown32(char *path, uid_t owner, gid_t group) {
   v = rscc_manage_chown32_response(&resp_header, &iovec_count, &nbytes, path, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_clock_getres(clockid_t clk_id, struct timespec *res) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9938,7 +10371,7 @@ int rscc_clock_getres(clockid_t clk_id, struct timespec *res) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9948,9 +10381,10 @@ int rscc_clock_getres(clockid_t clk_id, struct timespec *res) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -9962,19 +10396,23 @@ int rscc_clock_getres(clockid_t clk_id, struct timespec *res) {
   v = rscc_manage_clock_getres_response(&resp_header, &iovec_count, &nbytes, clk_id, res);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_clock_gettime(clockid_t clk_id, struct timespec *tp) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -9987,7 +10425,7 @@ int rscc_clock_gettime(clockid_t clk_id, struct timespec *tp) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -9997,9 +10435,10 @@ int rscc_clock_gettime(clockid_t clk_id, struct timespec *tp) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10011,19 +10450,23 @@ int rscc_clock_gettime(clockid_t clk_id, struct timespec *tp) {
   v = rscc_manage_clock_gettime_response(&resp_header, &iovec_count, &nbytes, clk_id, tp);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_clock_settime(clockid_t clk_id, struct timespec *tp) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10036,7 +10479,7 @@ int rscc_clock_settime(clockid_t clk_id, struct timespec *tp) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10046,9 +10489,10 @@ int rscc_clock_settime(clockid_t clk_id, struct timespec *tp) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10060,19 +10504,23 @@ int rscc_clock_settime(clockid_t clk_id, struct timespec *tp) {
   v = rscc_manage_clock_settime_response(&resp_header, &iovec_count, &nbytes, clk_id, tp);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_close(int fd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10085,7 +10533,7 @@ int rscc_close(int fd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10095,9 +10543,10 @@ int rscc_close(int fd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10109,19 +10558,23 @@ int rscc_close(int fd) {
   v = rscc_manage_close_response(&resp_header, &iovec_count, &nbytes, fd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_connect(int sockfd, struct sockaddr *serv_addr, socklen_t addrlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10134,7 +10587,7 @@ int rscc_connect(int sockfd, struct sockaddr *serv_addr, socklen_t addrlen) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10144,9 +10597,10 @@ int rscc_connect(int sockfd, struct sockaddr *serv_addr, socklen_t addrlen) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10158,19 +10612,23 @@ int rscc_connect(int sockfd, struct sockaddr *serv_addr, socklen_t addrlen) {
   v = rscc_manage_connect_response(&resp_header, &iovec_count, &nbytes, sockfd, serv_addr, addrlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_dup(int oldfd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10183,7 +10641,7 @@ int rscc_dup(int oldfd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10193,9 +10651,10 @@ int rscc_dup(int oldfd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10207,19 +10666,23 @@ int rscc_dup(int oldfd) {
   v = rscc_manage_dup_response(&resp_header, &iovec_count, &nbytes, oldfd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_dup2(int oldfd, int newfd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10232,7 +10695,7 @@ int rscc_dup2(int oldfd, int newfd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10242,9 +10705,10 @@ int rscc_dup2(int oldfd, int newfd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10256,19 +10720,23 @@ int rscc_dup2(int oldfd, int newfd) {
   v = rscc_manage_dup2_response(&resp_header, &iovec_count, &nbytes, oldfd, newfd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fchdir(int fd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10281,7 +10749,7 @@ int rscc_fchdir(int fd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10291,9 +10759,10 @@ int rscc_fchdir(int fd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10305,19 +10774,23 @@ int rscc_fchdir(int fd) {
   v = rscc_manage_fchdir_response(&resp_header, &iovec_count, &nbytes, fd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fchmod(int fildes, mode_t mode) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10330,7 +10803,7 @@ int rscc_fchmod(int fildes, mode_t mode) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10340,9 +10813,10 @@ int rscc_fchmod(int fildes, mode_t mode) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10354,19 +10828,23 @@ int rscc_fchmod(int fildes, mode_t mode) {
   v = rscc_manage_fchmod_response(&resp_header, &iovec_count, &nbytes, fildes, mode);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fchown(int fd, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10379,7 +10857,7 @@ int rscc_fchown(int fd, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10389,9 +10867,10 @@ int rscc_fchown(int fd, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10403,19 +10882,23 @@ int rscc_fchown(int fd, uid_t owner, gid_t group) {
   v = rscc_manage_fchown_response(&resp_header, &iovec_count, &nbytes, fd, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fchown32(int fd, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10428,7 +10911,7 @@ int rscc_fchown32(int fd, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10438,9 +10921,10 @@ int rscc_fchown32(int fd, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10452,19 +10936,23 @@ int rscc_fchown32(int fd, uid_t owner, gid_t group) {
   v = rscc_manage_fchown32_response(&resp_header, &iovec_count, &nbytes, fd, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fdatasync(int fd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10477,7 +10965,7 @@ int rscc_fdatasync(int fd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10487,9 +10975,10 @@ int rscc_fdatasync(int fd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10501,19 +10990,23 @@ int rscc_fdatasync(int fd) {
   v = rscc_manage_fdatasync_response(&resp_header, &iovec_count, &nbytes, fd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fgetxattr(int filedes, char *name, void *value, size_t size) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10526,7 +11019,7 @@ int rscc_fgetxattr(int filedes, char *name, void *value, size_t size) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10536,9 +11029,10 @@ int rscc_fgetxattr(int filedes, char *name, void *value, size_t size) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10550,19 +11044,23 @@ int rscc_fgetxattr(int filedes, char *name, void *value, size_t size) {
   v = rscc_manage_fgetxattr_response(&resp_header, &iovec_count, &nbytes, filedes, name, value, size);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fstat64(int filedes, struct stat64 *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10575,7 +11073,7 @@ int rscc_fstat64(int filedes, struct stat64 *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10585,9 +11083,10 @@ int rscc_fstat64(int filedes, struct stat64 *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10599,19 +11098,23 @@ int rscc_fstat64(int filedes, struct stat64 *buf) {
   v = rscc_manage_fstat64_response(&resp_header, &iovec_count, &nbytes, filedes, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fstatfs64(unsigned int fd, struct statfs64 *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10624,7 +11127,7 @@ int rscc_fstatfs64(unsigned int fd, struct statfs64 *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10634,9 +11137,10 @@ int rscc_fstatfs64(unsigned int fd, struct statfs64 *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10648,19 +11152,23 @@ int rscc_fstatfs64(unsigned int fd, struct statfs64 *buf) {
   v = rscc_manage_fstatfs64_response(&resp_header, &iovec_count, &nbytes, fd, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_fsync(int fd) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10673,7 +11181,7 @@ int rscc_fsync(int fd) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10683,9 +11191,10 @@ int rscc_fsync(int fd) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10697,19 +11206,23 @@ int rscc_fsync(int fd) {
   v = rscc_manage_fsync_response(&resp_header, &iovec_count, &nbytes, fd);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_ftruncate64(int fd, __off64_t length) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10722,7 +11235,7 @@ int rscc_ftruncate64(int fd, __off64_t length) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10732,9 +11245,10 @@ int rscc_ftruncate64(int fd, __off64_t length) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10746,19 +11260,23 @@ int rscc_ftruncate64(int fd, __off64_t length) {
   v = rscc_manage_ftruncate64_response(&resp_header, &iovec_count, &nbytes, fd, length);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10771,7 +11289,7 @@ int rscc_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count)
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10781,9 +11299,10 @@ int rscc_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count)
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10795,19 +11314,23 @@ int rscc_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count)
   v = rscc_manage_getdents64_response(&resp_header, &iovec_count, &nbytes, fd, dirp, count);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_getpeername(int s, struct sockaddr *name, socklen_t *namelen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10820,7 +11343,7 @@ int rscc_getpeername(int s, struct sockaddr *name, socklen_t *namelen) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10830,9 +11353,10 @@ int rscc_getpeername(int s, struct sockaddr *name, socklen_t *namelen) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10844,19 +11368,23 @@ int rscc_getpeername(int s, struct sockaddr *name, socklen_t *namelen) {
   v = rscc_manage_getpeername_response(&resp_header, &iovec_count, &nbytes, s, name, namelen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_getsockname(int s, struct sockaddr *name, socklen_t *namelen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10869,7 +11397,7 @@ int rscc_getsockname(int s, struct sockaddr *name, socklen_t *namelen) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10879,9 +11407,10 @@ int rscc_getsockname(int s, struct sockaddr *name, socklen_t *namelen) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10893,19 +11422,23 @@ int rscc_getsockname(int s, struct sockaddr *name, socklen_t *namelen) {
   v = rscc_manage_getsockname_response(&resp_header, &iovec_count, &nbytes, s, name, namelen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_getsockopt(int s, int level, int optname, void *optval, socklen_t *optlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10918,7 +11451,7 @@ int rscc_getsockopt(int s, int level, int optname, void *optval, socklen_t *optl
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10928,9 +11461,10 @@ int rscc_getsockopt(int s, int level, int optname, void *optval, socklen_t *optl
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10942,19 +11476,23 @@ int rscc_getsockopt(int s, int level, int optname, void *optval, socklen_t *optl
   v = rscc_manage_getsockopt_response(&resp_header, &iovec_count, &nbytes, s, level, optname, optval, optlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_gettimeofday(struct timeval *tv, struct timezone *tz) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -10967,7 +11505,7 @@ int rscc_gettimeofday(struct timeval *tv, struct timezone *tz) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -10977,9 +11515,10 @@ int rscc_gettimeofday(struct timeval *tv, struct timezone *tz) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -10991,19 +11530,23 @@ int rscc_gettimeofday(struct timeval *tv, struct timezone *tz) {
   v = rscc_manage_gettimeofday_response(&resp_header, &iovec_count, &nbytes, tv, tz);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_getxattr(char *path, char *name, void *value, size_t size) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11016,7 +11559,7 @@ int rscc_getxattr(char *path, char *name, void *value, size_t size) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11026,9 +11569,10 @@ int rscc_getxattr(char *path, char *name, void *value, size_t size) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11040,19 +11584,23 @@ int rscc_getxattr(char *path, char *name, void *value, size_t size) {
   v = rscc_manage_getxattr_response(&resp_header, &iovec_count, &nbytes, path, name, value, size);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_lchown(char *path, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11065,7 +11613,7 @@ int rscc_lchown(char *path, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11075,9 +11623,10 @@ int rscc_lchown(char *path, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11089,19 +11638,23 @@ int rscc_lchown(char *path, uid_t owner, gid_t group) {
   v = rscc_manage_lchown_response(&resp_header, &iovec_count, &nbytes, path, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_lchown32(char *path, uid_t owner, gid_t group) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11114,7 +11667,7 @@ int rscc_lchown32(char *path, uid_t owner, gid_t group) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11124,9 +11677,10 @@ int rscc_lchown32(char *path, uid_t owner, gid_t group) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11138,19 +11692,23 @@ int rscc_lchown32(char *path, uid_t owner, gid_t group) {
   v = rscc_manage_lchown32_response(&resp_header, &iovec_count, &nbytes, path, owner, group);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_lgetxattr(char *path, char *name, void *value, size_t size) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11163,7 +11721,7 @@ int rscc_lgetxattr(char *path, char *name, void *value, size_t size) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11173,9 +11731,10 @@ int rscc_lgetxattr(char *path, char *name, void *value, size_t size) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11187,19 +11746,23 @@ int rscc_lgetxattr(char *path, char *name, void *value, size_t size) {
   v = rscc_manage_lgetxattr_response(&resp_header, &iovec_count, &nbytes, path, name, value, size);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_link(char *oldpath, char *newpath) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11212,7 +11775,7 @@ int rscc_link(char *oldpath, char *newpath) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11222,9 +11785,10 @@ int rscc_link(char *oldpath, char *newpath) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11236,19 +11800,23 @@ int rscc_link(char *oldpath, char *newpath) {
   v = rscc_manage_link_response(&resp_header, &iovec_count, &nbytes, oldpath, newpath);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_listen(int sockfd, int backlog) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11261,7 +11829,7 @@ int rscc_listen(int sockfd, int backlog) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11271,9 +11839,10 @@ int rscc_listen(int sockfd, int backlog) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11285,19 +11854,23 @@ int rscc_listen(int sockfd, int backlog) {
   v = rscc_manage_listen_response(&resp_header, &iovec_count, &nbytes, sockfd, backlog);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_lseek(int fildes, off_t offset, int whence) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11310,7 +11883,7 @@ int rscc_lseek(int fildes, off_t offset, int whence) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11320,9 +11893,10 @@ int rscc_lseek(int fildes, off_t offset, int whence) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11334,19 +11908,23 @@ int rscc_lseek(int fildes, off_t offset, int whence) {
   v = rscc_manage_lseek_response(&resp_header, &iovec_count, &nbytes, fildes, offset, whence);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_lstat64(char *path, struct stat64 *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11359,7 +11937,7 @@ int rscc_lstat64(char *path, struct stat64 *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11369,9 +11947,10 @@ int rscc_lstat64(char *path, struct stat64 *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11383,19 +11962,23 @@ int rscc_lstat64(char *path, struct stat64 *buf) {
   v = rscc_manage_lstat64_response(&resp_header, &iovec_count, &nbytes, path, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_mkdir(char *pathname, mode_t mode) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11408,7 +11991,7 @@ int rscc_mkdir(char *pathname, mode_t mode) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11418,9 +12001,10 @@ int rscc_mkdir(char *pathname, mode_t mode) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11432,19 +12016,23 @@ int rscc_mkdir(char *pathname, mode_t mode) {
   v = rscc_manage_mkdir_response(&resp_header, &iovec_count, &nbytes, pathname, mode);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_mount(char *source, char *target, char *filesystemtype, unsigned long int mountflags, void *data) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11457,7 +12045,7 @@ int rscc_mount(char *source, char *target, char *filesystemtype, unsigned long i
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11467,9 +12055,10 @@ int rscc_mount(char *source, char *target, char *filesystemtype, unsigned long i
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11481,19 +12070,23 @@ int rscc_mount(char *source, char *target, char *filesystemtype, unsigned long i
   v = rscc_manage_mount_response(&resp_header, &iovec_count, &nbytes, source, target, filesystemtype, mountflags, data);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_open(char *pathname, int flags) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11506,7 +12099,7 @@ int rscc_open(char *pathname, int flags) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11516,9 +12109,10 @@ int rscc_open(char *pathname, int flags) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11530,19 +12124,23 @@ int rscc_open(char *pathname, int flags) {
   v = rscc_manage_open_response(&resp_header, &iovec_count, &nbytes, pathname, flags);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_pread64(int fd, void *buf, size_t count, off_t offset) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11555,7 +12153,7 @@ int rscc_pread64(int fd, void *buf, size_t count, off_t offset) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11565,9 +12163,10 @@ int rscc_pread64(int fd, void *buf, size_t count, off_t offset) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11579,19 +12178,23 @@ int rscc_pread64(int fd, void *buf, size_t count, off_t offset) {
   v = rscc_manage_pread64_response(&resp_header, &iovec_count, &nbytes, fd, buf, count, offset);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_pwrite64(int fd, void *buf, size_t count, off_t offset) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11604,7 +12207,7 @@ int rscc_pwrite64(int fd, void *buf, size_t count, off_t offset) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11614,9 +12217,10 @@ int rscc_pwrite64(int fd, void *buf, size_t count, off_t offset) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11628,19 +12232,23 @@ int rscc_pwrite64(int fd, void *buf, size_t count, off_t offset) {
   v = rscc_manage_pwrite64_response(&resp_header, &iovec_count, &nbytes, fd, buf, count, offset);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_read(int fd, void *buf, size_t count) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11653,7 +12261,7 @@ int rscc_read(int fd, void *buf, size_t count) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11663,9 +12271,10 @@ int rscc_read(int fd, void *buf, size_t count) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11677,19 +12286,23 @@ int rscc_read(int fd, void *buf, size_t count) {
   v = rscc_manage_read_response(&resp_header, &iovec_count, &nbytes, fd, buf, count);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_readlink(char *path, char *buf, size_t bufsiz) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11702,7 +12315,7 @@ int rscc_readlink(char *path, char *buf, size_t bufsiz) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11712,9 +12325,10 @@ int rscc_readlink(char *path, char *buf, size_t bufsiz) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11726,19 +12340,23 @@ int rscc_readlink(char *path, char *buf, size_t bufsiz) {
   v = rscc_manage_readlink_response(&resp_header, &iovec_count, &nbytes, path, buf, bufsiz);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_recv(int s, void *buf, size_t len, int flags) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11751,7 +12369,7 @@ int rscc_recv(int s, void *buf, size_t len, int flags) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11761,9 +12379,10 @@ int rscc_recv(int s, void *buf, size_t len, int flags) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11775,19 +12394,23 @@ int rscc_recv(int s, void *buf, size_t len, int flags) {
   v = rscc_manage_recv_response(&resp_header, &iovec_count, &nbytes, s, buf, len, flags);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr *from, socklen_t *fromlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11800,7 +12423,7 @@ int rscc_recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr *from
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11810,9 +12433,10 @@ int rscc_recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr *from
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11824,19 +12448,23 @@ int rscc_recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr *from
   v = rscc_manage_recvfrom_response(&resp_header, &iovec_count, &nbytes, s, buf, len, flags, from, fromlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_rename(char *oldpath, char *newpath) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11849,7 +12477,7 @@ int rscc_rename(char *oldpath, char *newpath) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11859,9 +12487,10 @@ int rscc_rename(char *oldpath, char *newpath) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11873,19 +12502,23 @@ int rscc_rename(char *oldpath, char *newpath) {
   v = rscc_manage_rename_response(&resp_header, &iovec_count, &nbytes, oldpath, newpath);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_rmdir(char *pathname) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11898,7 +12531,7 @@ int rscc_rmdir(char *pathname) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11908,9 +12541,10 @@ int rscc_rmdir(char *pathname) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11922,19 +12556,23 @@ int rscc_rmdir(char *pathname) {
   v = rscc_manage_rmdir_response(&resp_header, &iovec_count, &nbytes, pathname);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_send(int s, void *buf, size_t len, int flags) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11947,7 +12585,7 @@ int rscc_send(int s, void *buf, size_t len, int flags) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -11957,9 +12595,10 @@ int rscc_send(int s, void *buf, size_t len, int flags) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -11971,19 +12610,23 @@ int rscc_send(int s, void *buf, size_t len, int flags) {
   v = rscc_manage_send_response(&resp_header, &iovec_count, &nbytes, s, buf, len, flags);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_sendto(int s, void *buf, size_t len, int flags, struct sockaddr *to, socklen_t tolen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -11996,7 +12639,7 @@ int rscc_sendto(int s, void *buf, size_t len, int flags, struct sockaddr *to, so
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12006,9 +12649,10 @@ int rscc_sendto(int s, void *buf, size_t len, int flags, struct sockaddr *to, so
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12020,19 +12664,23 @@ int rscc_sendto(int s, void *buf, size_t len, int flags, struct sockaddr *to, so
   v = rscc_manage_sendto_response(&resp_header, &iovec_count, &nbytes, s, buf, len, flags, to, tolen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_setdomainname(char *name, size_t len) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12045,7 +12693,7 @@ int rscc_setdomainname(char *name, size_t len) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12055,9 +12703,10 @@ int rscc_setdomainname(char *name, size_t len) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12069,19 +12718,23 @@ int rscc_setdomainname(char *name, size_t len) {
   v = rscc_manage_setdomainname_response(&resp_header, &iovec_count, &nbytes, name, len);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_sethostname(char *name, size_t len) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12094,7 +12747,7 @@ int rscc_sethostname(char *name, size_t len) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12104,9 +12757,10 @@ int rscc_sethostname(char *name, size_t len) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12118,19 +12772,23 @@ int rscc_sethostname(char *name, size_t len) {
   v = rscc_manage_sethostname_response(&resp_header, &iovec_count, &nbytes, name, len);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_setsockopt(int s, int level, int optname, void *optval, socklen_t optlen) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12143,7 +12801,7 @@ int rscc_setsockopt(int s, int level, int optname, void *optval, socklen_t optle
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12153,9 +12811,10 @@ int rscc_setsockopt(int s, int level, int optname, void *optval, socklen_t optle
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12167,19 +12826,23 @@ int rscc_setsockopt(int s, int level, int optname, void *optval, socklen_t optle
   v = rscc_manage_setsockopt_response(&resp_header, &iovec_count, &nbytes, s, level, optname, optval, optlen);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_settimeofday(struct timeval *tv, struct timezone *tz) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12192,7 +12855,7 @@ int rscc_settimeofday(struct timeval *tv, struct timezone *tz) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12202,9 +12865,10 @@ int rscc_settimeofday(struct timeval *tv, struct timezone *tz) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12216,19 +12880,23 @@ int rscc_settimeofday(struct timeval *tv, struct timezone *tz) {
   v = rscc_manage_settimeofday_response(&resp_header, &iovec_count, &nbytes, tv, tz);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_shutdown(int s, int how) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12241,7 +12909,7 @@ int rscc_shutdown(int s, int how) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12251,9 +12919,10 @@ int rscc_shutdown(int s, int how) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12265,19 +12934,23 @@ int rscc_shutdown(int s, int how) {
   v = rscc_manage_shutdown_response(&resp_header, &iovec_count, &nbytes, s, how);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_socket(int domain, int type, int protocol) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12290,7 +12963,7 @@ int rscc_socket(int domain, int type, int protocol) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12300,9 +12973,10 @@ int rscc_socket(int domain, int type, int protocol) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12314,19 +12988,23 @@ int rscc_socket(int domain, int type, int protocol) {
   v = rscc_manage_socket_response(&resp_header, &iovec_count, &nbytes, domain, type, protocol);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_stat64(char *path, struct stat64 *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12339,7 +13017,7 @@ int rscc_stat64(char *path, struct stat64 *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12349,9 +13027,10 @@ int rscc_stat64(char *path, struct stat64 *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12363,19 +13042,23 @@ int rscc_stat64(char *path, struct stat64 *buf) {
   v = rscc_manage_stat64_response(&resp_header, &iovec_count, &nbytes, path, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_statfs64(char *path, struct statfs64 *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12388,7 +13071,7 @@ int rscc_statfs64(char *path, struct statfs64 *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12398,9 +13081,10 @@ int rscc_statfs64(char *path, struct statfs64 *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12412,19 +13096,23 @@ int rscc_statfs64(char *path, struct statfs64 *buf) {
   v = rscc_manage_statfs64_response(&resp_header, &iovec_count, &nbytes, path, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_symlink(char *oldpath, char *newpath) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12437,7 +13125,7 @@ int rscc_symlink(char *oldpath, char *newpath) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12447,9 +13135,10 @@ int rscc_symlink(char *oldpath, char *newpath) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12461,19 +13150,23 @@ int rscc_symlink(char *oldpath, char *newpath) {
   v = rscc_manage_symlink_response(&resp_header, &iovec_count, &nbytes, oldpath, newpath);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_truncate64(char *path, __off64_t length) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12486,7 +13179,7 @@ int rscc_truncate64(char *path, __off64_t length) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12496,9 +13189,10 @@ int rscc_truncate64(char *path, __off64_t length) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12510,19 +13204,23 @@ int rscc_truncate64(char *path, __off64_t length) {
   v = rscc_manage_truncate64_response(&resp_header, &iovec_count, &nbytes, path, length);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_umount2(char *target, int flags) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12535,7 +13233,7 @@ int rscc_umount2(char *target, int flags) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12545,9 +13243,10 @@ int rscc_umount2(char *target, int flags) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12559,19 +13258,23 @@ int rscc_umount2(char *target, int flags) {
   v = rscc_manage_umount2_response(&resp_header, &iovec_count, &nbytes, target, flags);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_uname(struct utsname *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12584,7 +13287,7 @@ int rscc_uname(struct utsname *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12594,9 +13297,10 @@ int rscc_uname(struct utsname *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12608,19 +13312,23 @@ int rscc_uname(struct utsname *buf) {
   v = rscc_manage_uname_response(&resp_header, &iovec_count, &nbytes, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_unlink(char *pathname) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12633,7 +13341,7 @@ int rscc_unlink(char *pathname) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12643,9 +13351,10 @@ int rscc_unlink(char *pathname) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12657,19 +13366,23 @@ int rscc_unlink(char *pathname) {
   v = rscc_manage_unlink_response(&resp_header, &iovec_count, &nbytes, pathname);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_utime(char *filename, struct utimbuf *buf) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12682,7 +13395,7 @@ int rscc_utime(char *filename, struct utimbuf *buf) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12692,9 +13405,10 @@ int rscc_utime(char *filename, struct utimbuf *buf) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12706,19 +13420,23 @@ int rscc_utime(char *filename, struct utimbuf *buf) {
   v = rscc_manage_utime_response(&resp_header, &iovec_count, &nbytes, filename, buf);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_utimes(char *filename, struct timeval tv[2]) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12731,7 +13449,7 @@ int rscc_utimes(char *filename, struct timeval tv[2]) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12741,9 +13459,10 @@ int rscc_utimes(char *filename, struct timeval tv[2]) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12755,19 +13474,23 @@ int rscc_utimes(char *filename, struct timeval tv[2]) {
   v = rscc_manage_utimes_response(&resp_header, &iovec_count, &nbytes, filename, tv);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
 int rscc_write(int fd, void *buf, size_t count) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -12780,7 +13503,7 @@ int rscc_write(int fd, void *buf, size_t count) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -12790,9 +13513,10 @@ int rscc_write(int fd, void *buf, size_t count) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -12804,14 +13528,17 @@ int rscc_write(int fd, void *buf, size_t count) {
   v = rscc_manage_write_response(&resp_header, &iovec_count, &nbytes, fd, buf, count);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
@@ -13035,6 +13762,7 @@ struct iovec *rscc_manage_ioctl_response(struct sys_resp_header *resp_header, in
 
 int rscc_ioctl(int d, int request, void *arg) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -13056,7 +13784,7 @@ int rscc_ioctl(int d, int request, void *arg) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -13065,22 +13793,27 @@ int rscc_ioctl(int d, int request, void *arg) {
   }
   free(v[0].iov_base); free(v);
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
   
   /* I read the additional data, if there is. */
   v = rscc_manage_ioctl_response(&resp_header, &iovec_count, &nbytes, size_type, arg);
   if(v != NULL) {
-    nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+    nread = rscc_call_recvv(call, v, iovec_count, nbytes);
     if(nread != nbytes) {
       fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
+      free(v);
+      rscc_call_end(call);
       return -1;
     }
+    free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
@@ -13151,11 +13884,15 @@ u_int32_t ioctl_cache_search(struct ioctl_cache *cache, int request) {
 u_int32_t rscc_check_ioctl_request(int request) {
   struct ioctl_req_header req;
   struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
   int ret;
   u_int32_t size_type;
 
   /* I control if the request is in the cache */
+  pthread_mutex_lock(&ioctl_cache_mutex);
   size_type = ioctl_cache_search(ioctl_cache, request);
+  pthread_mutex_unlock(&ioctl_cache_mutex);
   if(size_type == 0) {
 	  /* otherwise I call the server */
 	  bzero(&req, sizeof(struct ioctl_req_header));
@@ -13164,18 +13901,23 @@ u_int32_t rscc_check_ioctl_request(int request) {
 	  req.req_ioctl_request = htonl(request);
 	
 	  /* I send the request */
-	  ret = write_n_bytes(rsc_sockfd, &req, sizeof(struct ioctl_req_header));
+	  v.iov_base = &req;
+	  v.iov_len = sizeof(struct ioctl_req_header);
+	  ret = rscc_call_send(&call, &v, 1, sizeof(struct ioctl_req_header));
 	  if(ret != sizeof(struct ioctl_req_header))
 	    return 0;
 	
 	  /* I wait the answer */
-	  ret = read_n_bytes(rsc_sockfd, &resp, sizeof(struct ioctl_resp_header));
+	  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+	  rscc_call_end(call);
 	  if(ret != sizeof(struct ioctl_resp_header))
 	    return 0;
 	  resp.resp_size = ntohl(resp.resp_size);
 	  resp.resp_size_type = ntohl(resp.resp_size_type);
 	  /* I add it to the cache */
+	  pthread_mutex_lock(&ioctl_cache_mutex);
 	  ioctl_cache_add(ioctl_cache, request, resp.resp_size_type);
+	  pthread_mutex_unlock(&ioctl_cache_mutex);
 
     size_type = resp.resp_size_type;
   }
@@ -13355,6 +14097,7 @@ struct iovec *rscc_manage_fcntl_response(struct sys_resp_header *resp_header, in
 int rscc_fcntl(int fd, int cmd, ...) {
   va_list ap;
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -13379,7 +14122,7 @@ int rscc_fcntl(int fd, int cmd, ...) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -13388,23 +14131,208 @@ int rscc_fcntl(int fd, int cmd, ...) {
   }
   free(v[0].iov_base); free(v);
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
   /* I read the additional data, if there is. */
   v = rscc_manage_fcntl_response(&resp_header, &iovec_count, &nbytes, cmd_type, third_arg);
   if(v != NULL) {
-    nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+    nread = rscc_call_recvv(call, v, iovec_count, nbytes);
     if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
 
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
+
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  COMPOUND REQUESTS                                                 ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+static pthread_once_t compound_once = PTHREAD_ONCE_INIT;
+static int compound_max;
+
+static void compound_probe(void) {
+  int ret = rscc_probe(RSC_COMPOUND_PROBE);
+  if(ret <= 0 || ret == IOCTL_UNMANAGED)
+    compound_max = 0;
+  else
+    compound_max = ret < RSC_COMPOUND_MAX ? ret : RSC_COMPOUND_MAX;
+  RSC_DEBUG(RSCD_MINIMAL, "compound requests: max %d calls", compound_max);
+}
+
+int rscc_compound_max(void) {
+  pthread_once(&compound_once, compound_probe);
+  return compound_max;
+}
+
+/* The request of the call 'c' with 'fd' as first argument */
+static struct iovec *compound_create_request(struct rscc_compound_call *c, int fd, int *nbytes, int *count) {
+  switch(c->op) {
+    case RSCC_COMPOUND_OPEN:
+      return rscc_create_open_request(nbytes, count, c->path, c->open_flags);
+    case RSCC_COMPOUND_CLOSE:
+      return rscc_create_close_request(nbytes, count, fd);
+    case RSCC_COMPOUND_FSTAT64:
+      return rscc_create_fstat64_request(nbytes, count, fd, c->buf);
+    case RSCC_COMPOUND_PREAD64:
+      return rscc_create_pread64_request(nbytes, count, fd, c->buf, c->count, c->offset);
+    case RSCC_COMPOUND_GETDENTS64:
+      return rscc_create_getdents64_request(nbytes, count, fd, c->buf, c->count);
+  }
+  return NULL;
+}
+
+static struct iovec *compound_manage_response(struct rscc_compound_call *c, struct sys_resp_header *resp_header, int *nbytes, int *count) {
+  switch(c->op) {
+    case RSCC_COMPOUND_OPEN:
+      return rscc_manage_open_response(resp_header, count, nbytes, c->path, c->open_flags);
+    case RSCC_COMPOUND_CLOSE:
+      return rscc_manage_close_response(resp_header, count, nbytes, c->fd);
+    case RSCC_COMPOUND_FSTAT64:
+      return rscc_manage_fstat64_response(resp_header, count, nbytes, c->fd, c->buf);
+    case RSCC_COMPOUND_PREAD64:
+      return rscc_manage_pread64_response(resp_header, count, nbytes, c->fd, c->buf, c->count, c->offset);
+    case RSCC_COMPOUND_GETDENTS64:
+      return rscc_manage_getdents64_response(resp_header, count, nbytes, c->fd, c->buf, c->count);
+  }
+  return NULL;
+}
+
+/* The server doesn't know the compound requests: the calls are executed
+ * one by one, with the same rules */
+static int compound_one_by_one(struct rscc_compound_call *calls, int ncalls) {
+  struct stat64 st;
+  int i, fd;
+  for(i = 0; i < ncalls; i++) {
+    struct rscc_compound_call *c = &calls[i];
+    fd = c->fd;
+    if(c->chain != RSC_COMPOUND_NOCHAIN) {
+      fd = calls[c->chain].retval;
+      if(fd < 0 || ((c->flags & RSC_COMPOUND_IFREG) &&
+            (rscc_fstat64(fd, &st) < 0 || !S_ISREG(st.st_mode)))) {
+        c->retval = -1;
+        c->err = ECANCELED;
+        continue;
+      }
+    }
+    switch(c->op) {
+      case RSCC_COMPOUND_OPEN:
+        c->retval = rscc_open(c->path, c->open_flags); break;
+      case RSCC_COMPOUND_CLOSE:
+        c->retval = rscc_close(fd); break;
+      case RSCC_COMPOUND_FSTAT64:
+        c->retval = rscc_fstat64(fd, c->buf); break;
+      case RSCC_COMPOUND_PREAD64:
+        c->retval = rscc_pread64(fd, c->buf, c->count, c->offset); break;
+      case RSCC_COMPOUND_GETDENTS64:
+        c->retval = rscc_getdents64(fd, c->buf, c->count); break;
+    }
+    c->err = errno;
+  }
+  return 0;
+}
+
+int rscc_compound(struct rscc_compound_call *calls, int ncalls) {
+  struct compound_req_header req;
+  struct compound_resp_header resp;
+  struct compound_item items[RSC_COMPOUND_MAX];
+  struct iovec *reqs[RSC_COMPOUND_MAX], *v;
+  int counts[RSC_COMPOUND_MAX];
+  struct rscc_call *call;
+  int i, n, nbytes, iovec_count, size, ret = -1;
+
+  if(ncalls <= 0 || ncalls > RSC_COMPOUND_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  for(i = 0; i < ncalls; i++)
+    if(calls[i].chain != RSC_COMPOUND_NOCHAIN && (calls[i].chain < 0 || calls[i].chain >= i)) {
+      errno = EINVAL;
+      return -1;
+    }
+  if(ncalls > rscc_compound_max())
+    return compound_one_by_one(calls, ncalls);
+
+  /* I build the request: the header, then an item and a syscall
+   * request for each call. The chained fds are set by the server. */
+  size = sizeof(struct compound_req_header);
+  iovec_count = 1;
+  for(n = 0; n < ncalls; n++) {
+    struct rscc_compound_call *c = &calls[n];
+    reqs[n] = compound_create_request(c, c->chain != RSC_COMPOUND_NOCHAIN ? -1 : c->fd, &nbytes, &counts[n]);
+    if(reqs[n] == NULL)
+      goto free_reqs;
+    items[n].chain = c->chain;
+    items[n].flags = c->flags;
+    size += sizeof(struct compound_item) + nbytes;
+    iovec_count += 1 + counts[n];
+  }
+  if((v = calloc(iovec_count, sizeof(struct iovec))) == NULL)
+    goto free_reqs;
+  bzero(&req, sizeof(struct compound_req_header));
+  req.req_type = RSC_COMPOUND_REQ;
+  req.req_size = htonl(size);
+  req.req_count = ncalls;
+  v[0].iov_base = &req;
+  v[0].iov_len = sizeof(struct compound_req_header);
+  for(i = 0, iovec_count = 1; i < ncalls; i++) {
+    v[iovec_count].iov_base = &items[i];
+    v[iovec_count].iov_len = sizeof(struct compound_item);
+    memcpy(&v[iovec_count + 1], reqs[i], counts[i] * sizeof(struct iovec));
+    iovec_count += 1 + counts[i];
+  }
+  RSC_DEBUG(RSCD_REQ_RESP, "==> COMPOUND REQUEST: %d calls, %d bytes", ncalls, size);
+  nbytes = rscc_call_send(&call, v, iovec_count, size);
+  free(v);
+  if(nbytes != size) {
+    fprintf(stderr, "I've sent only %d/%d bytes.\n", nbytes, size);
+    goto free_reqs;
+  }
+
+  /* ... and I read the responses, in the same order */
+  if(rscc_call_recv(call, &resp, sizeof(struct compound_resp_header)) != sizeof(struct compound_resp_header) ||
+      resp.resp_type != RSC_COMPOUND_RESP || resp.resp_count != ncalls) {
+    fprintf(stderr, "Bad response to the compound request.\n");
+    rscc_call_end(call);
+    goto free_reqs;
+  }
+  for(i = 0; i < ncalls; i++) {
+    struct sys_resp_header resp_header;
+    if(rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header)) != sizeof(struct sys_resp_header))
+      break;
+    v = compound_manage_response(&calls[i], &resp_header, &nbytes, &iovec_count);
+    if(v != NULL) {
+      int nread = rscc_call_recvv(call, v, iovec_count, nbytes);
+      free(v);
+      if(nread != nbytes)
+        break;
+    }
+    calls[i].retval = resp_header.resp_retval;
+    calls[i].err = resp_header.resp_errno;
+  }
+  rscc_call_end(call);
+  if(i == ncalls)
+    ret = 0;
+  else
+    fprintf(stderr, "I've read only %d/%d responses.\n", i, ncalls);
+
+free_reqs:
+  for(i = 0; i < n; i++) {
+    free(reqs[i][0].iov_base);
+    free(reqs[i]);
+  }
+  return ret;
+}
@@ -62,6 +62,8 @@
 #include <sys/utsname.h>
 #include <time.h>
 #include <unistd.h>
+/* Written only by rscs_init() and rscs_ioctl_register_request(), before
+ * the requests are executed: the threads of the server only read them */
 static enum arch my_arch;
 static struct list *ioctl_list;
 /*########################################################################*/
@@ -9690,6 +9692,136 @@ void rsc_server_teardown() {
   ioctl_list = NULL;
 }
 
+/* Executes a syscall request, the result of the call is saved in '*retval' */
+static struct iovec *rscs_manage_sys_request(int client_arch, void *request, int *retval) {
+  struct sys_req_header *req_hd;
+  struct sys_resp_header *resp_hd;
+  rscs_pre_exec pre_exec_f;
+  rscs_exec exec_f;
+  rscs_post_exec post_exec_f;
+  req_hd = (struct sys_req_header *)request;
+  /* I convert the filed of the RSC SYS request header */ 
+  req_hd->req_rsc_const = ntohs(req_hd->req_rsc_const);
+  RSC_DEBUG(RSCD_REQ_RESP,"RSC SYS Request management: %X(%s)", req_hd->req_rsc_const, rsc2str(req_hd->req_rsc_const));
+  if( req_hd->req_rsc_const < __RSC_FIRST || req_hd->req_rsc_const > __RSC_LAST )
+    return NULL;
+  /* The 64 bit architectures send the calls without the 64 suffix,
+   * the request and the response are the same */
+  switch(req_hd->req_rsc_const) {
+    case __RSC_stat: req_hd->req_rsc_const = __RSC_stat64; break;
+    case __RSC_lstat: req_hd->req_rsc_const = __RSC_lstat64; break;
+    case __RSC_fstat: req_hd->req_rsc_const = __RSC_fstat64; break;
+    case __RSC_statfs: req_hd->req_rsc_const = __RSC_statfs64; break;
+    case __RSC_fstatfs: req_hd->req_rsc_const = __RSC_fstatfs64; break;
+    case __RSC_truncate: req_hd->req_rsc_const = __RSC_truncate64; break;
+    case __RSC_ftruncate: req_hd->req_rsc_const = __RSC_ftruncate64; break;
+    default: break;
+  }
+  pre_exec_f = rscs_pre_exec_table[req_hd->req_rsc_const];
+  exec_f = rscs_exec_table[req_hd->req_rsc_const];
+  post_exec_f = rscs_post_exec_table[req_hd->req_rsc_const];
+  if(pre_exec_f == NULL || exec_f == NULL || post_exec_f == NULL)
+    return NULL;
+  if((resp_hd = pre_exec_f(request, client_arch)) == NULL)
+    return NULL;
+  *retval = exec_f(request);
+  return post_exec_f(request, resp_hd, *retval, errno, client_arch);
+}
+
+/* The response to an item of a compound request which is not executed.
+ * 'req_hd' is still in network byte order. */
+static struct iovec *rscs_compound_skipped(struct sys_req_header *req_hd) {
+  struct sys_resp_header *resp_hd;
+  struct iovec *v;
+  v = calloc(1, sizeof(struct iovec));
+  resp_hd = calloc(1, sizeof(struct sys_resp_header));
+  if(v == NULL || resp_hd == NULL) {
+    free(v); free(resp_hd);
+    return NULL;
+  }
+  resp_hd->resp_type = RSC_SYS_RESP;
+  resp_hd->resp_size = htonl(sizeof(struct sys_resp_header));
+  resp_hd->resp_rsc_const = req_hd->req_rsc_const;
+  resp_hd->resp_retval = htonl(-1);
+  resp_hd->resp_errno = htonl(ECANCELED);
+  v[0].iov_base = resp_hd;
+  v[0].iov_len = sizeof(struct sys_resp_header);
+  return v;
+}
+
+/* Executes the items of a compound request (see rsc_messages.h) and
+ * returns the responses in a single buffer */
+static struct iovec *rscs_manage_compound_request(int client_arch, struct compound_req_header *req_hd) {
+  struct iovec *resps[RSC_COMPOUND_MAX], *ret_data = NULL;
+  struct compound_resp_header *resp_hd;
+  int results[RSC_COMPOUND_MAX];
+  char *p, *end;
+  int i, n, size;
+
+  if(req_hd->req_size < sizeof(struct compound_req_header) || req_hd->req_count > RSC_COMPOUND_MAX)
+    return NULL;
+  RSC_DEBUG(RSCD_REQ_RESP,"RSC COMPOUND Request management: %d calls", req_hd->req_count);
+  p = (char *)req_hd + sizeof(struct compound_req_header);
+  end = (char *)req_hd + req_hd->req_size;
+  size = sizeof(struct compound_resp_header);
+  for(n = 0; n < req_hd->req_count; n++) {
+    struct compound_item *item = (struct compound_item *)p;
+    struct sys_req_header *sys_hd = (struct sys_req_header *)(p + sizeof(struct compound_item));
+    int sys_size, skip = 0;
+    if(end - p < sizeof(struct compound_item) + sizeof(struct sys_req_header) ||
+        sys_hd->req_type != RSC_SYS_REQ ||
+        (sys_size = ntohl(sys_hd->req_size)) < sizeof(struct sys_req_header) ||
+        sys_size > end - (char *)sys_hd)
+      break;
+    sys_hd->req_size = sys_size;
+    if(item->chain != RSC_COMPOUND_NOCHAIN) {
+      /* The first argument of the request is the result of the chained call */
+      if(item->chain >= n || results[item->chain] < 0 ||
+          sys_size < sizeof(struct sys_req_header) + sizeof(int))
+        skip = 1;
+      else {
+        memcpy(sys_hd + 1, &results[item->chain], sizeof(int));
+        if(item->flags & RSC_COMPOUND_IFREG) {
+          struct stat64 st;
+          if(fstat64(results[item->chain], &st) < 0 || !S_ISREG(st.st_mode))
+            skip = 1;
+        }
+      }
+    }
+    if(skip) {
+      results[n] = -1;
+      resps[n] = rscs_compound_skipped(sys_hd);
+    } else
+      resps[n] = rscs_manage_sys_request(client_arch, sys_hd, &results[n]);
+    if(resps[n] == NULL)
+      break;
+    size += resps[n][0].iov_len;
+    p = (char *)sys_hd + sys_size;
+  }
+
+  if(n == req_hd->req_count && (ret_data = calloc(1, sizeof(struct iovec))) != NULL &&
+      (resp_hd = malloc(size)) != NULL) {
+    resp_hd->resp_type = RSC_COMPOUND_RESP;
+    resp_hd->resp_size = htonl(size);
+    resp_hd->resp_count = n;
+    ret_data[0].iov_base = resp_hd;
+    ret_data[0].iov_len = size;
+    p = (char *)resp_hd + sizeof(struct compound_resp_header);
+    for(i = 0; i < n; i++) {
+      memcpy(p, resps[i][0].iov_base, resps[i][0].iov_len);
+      p += resps[i][0].iov_len;
+    }
+  } else {
+    free(ret_data);
+    ret_data = NULL;
+  }
+  for(i = 0; i < n; i++) {
+    free(resps[i][0].iov_base);
+    free(resps[i]);
+  }
+  return ret_data;
+}
+
 struct iovec*rscs_manage_request(int client_arch, void *request) {
   struct iovec*ret_data;
   struct req_header *req_hd;
@@ -9700,27 +9832,10 @@ struct iovec*rscs_manage_request(int client_arch, void *request) {
 	  RSC_DEBUG(RSCD_REQ_RESP,"RSC IOCTL Request management");
     ret_data = rscs_manage_ioctl_request((struct ioctl_req_header *)request);
   } else if( req_hd->req_type == RSC_SYS_REQ) {
-    struct sys_req_header *req_hd;
-    struct sys_resp_header *resp_hd;
-    rscs_pre_exec pre_exec_f;
     int ret;
-    rscs_exec exec_f;
-    rscs_post_exec post_exec_f;
-    req_hd = (struct sys_req_header *)request;
-    /* I convert the filed of the RSC SYS request header */ 
-    req_hd->req_rsc_const = ntohs(req_hd->req_rsc_const);
-	  RSC_DEBUG(RSCD_REQ_RESP,"RSC SYS Request management: %X(%s)", req_hd->req_rsc_const, rsc2str(req_hd->req_rsc_const));
-    if( req_hd->req_rsc_const < __RSC_FIRST || req_hd->req_rsc_const > __RSC_LAST )
-      return NULL;
-    pre_exec_f = rscs_pre_exec_table[req_hd->req_rsc_const];
-    exec_f = rscs_exec_table[req_hd->req_rsc_const];
-    post_exec_f = rscs_post_exec_table[req_hd->req_rsc_const];
-    if(pre_exec_f == NULL || exec_f == NULL || post_exec_f == NULL)
-      return NULL;
-    if((resp_hd = pre_exec_f(request, client_arch)) == NULL)
-      return NULL;
-    ret = exec_f(request);
-    ret_data = post_exec_f(request, resp_hd, ret, errno, client_arch);
+    ret_data = rscs_manage_sys_request(client_arch, request, &ret);
+  } else if( req_hd->req_type == RSC_COMPOUND_REQ) {
+    ret_data = rscs_manage_compound_request(client_arch, (struct compound_req_header *)request);
   } else {
     /* Bad request type */
     ret_data = NULL;
@@ -0,0 +1,335 @@
+/*
+ *   This is part of Remote System Call (RSC) Library.
+ *
+ *   rsc_shm.c: local transport, the messages go through rings in a
+ *              memory region shared by the client and the server
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "utils.h"
+#include "rsc_shm.h"
+
+/* Before sleeping, a side waits a bit for the other one running on
+ * another CPU: a short answer comes back without a futex wake up */
+#define SPIN 2000
+
+#if defined(__i386__) || defined(__x86_64__)
+# define cpu_relax() __asm__ __volatile__("pause" ::: "memory")
+#else
+# define cpu_relax() __sync_synchronize()
+#endif
+
+static int spin = -1;
+
+static inline u_int32_t get(u_int32_t *p) {
+  return *(volatile u_int32_t *)p;
+}
+
+static inline void set(u_int32_t *p, u_int32_t v) {
+  *(volatile u_int32_t *)p = v;
+}
+
+static int futex(u_int32_t *addr, int op, u_int32_t val, struct timespec *timeout) {
+  return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+static inline char *ring_data(struct rsc_shm *shm, int ring) {
+  return (char *)shm->region + RSC_SHM_DATA + ring * shm->ring_size;
+}
+
+/*************************/
+/* Region                */
+/*************************/
+static struct rsc_shm *shm_new(int fd, u_int32_t ring_size) {
+  struct rsc_shm *shm;
+  if((shm = calloc(1, sizeof(struct rsc_shm))) == NULL)
+    return NULL;
+  shm->ring_size = ring_size;
+  shm->len = RSC_SHM_DATA + 2 * (size_t)ring_size;
+  shm->region = mmap(NULL, shm->len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(shm->region == MAP_FAILED) {
+    free(shm);
+    return NULL;
+  }
+  if(spin == -1)
+    spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN : 0;
+  return shm;
+}
+
+struct rsc_shm *rsc_shm_create(int ring_size, int *fd) {
+  struct rsc_shm *shm;
+  if(ring_size <= 0 || (ring_size & (ring_size - 1)) != 0)
+    return NULL;
+  if((*fd = memfd_create("rsc", MFD_CLOEXEC | MFD_ALLOW_SEALING)) == -1)
+    return NULL;
+  /* The server must not find the region shorter than it was */
+  if(ftruncate(*fd, RSC_SHM_DATA + 2 * (off_t)ring_size) == -1 ||
+      fcntl(*fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1 ||
+      (shm = shm_new(*fd, ring_size)) == NULL) {
+    close(*fd);
+    return NULL;
+  }
+  shm->region->magic = RSC_SHM_MAGIC;
+  shm->region->ring_size = ring_size;
+  return shm;
+}
+
+struct rsc_shm *rsc_shm_map(int fd) {
+  struct rsc_shm_region region;
+  struct stat st;
+  u_int32_t size;
+  int seals;
+
+  /* A region which can shrink would kill the server with a SIGBUS */
+  if((seals = fcntl(fd, F_GET_SEALS)) == -1 || !(seals & F_SEAL_SHRINK))
+    return NULL;
+  if(fstat(fd, &st) == -1 || st.st_size < sizeof(region) ||
+      pread(fd, &region, sizeof(region), 0) != sizeof(region))
+    return NULL;
+  size = region.ring_size;
+  if(region.magic != RSC_SHM_MAGIC || size < 4096 || (size & (size - 1)) != 0 ||
+      st.st_size != RSC_SHM_DATA + 2 * (off_t)size)
+    return NULL;
+  return shm_new(fd, size);
+}
+
+void rsc_shm_close(struct rsc_shm *shm) {
+  int i;
+  set(&shm->region->closed, 1);
+  __sync_synchronize();
+  for(i = 0; i < 2; i++) {
+    futex(&shm->region->ring[i].head, FUTEX_WAKE, 1, NULL);
+    futex(&shm->region->ring[i].tail, FUTEX_WAKE, 1, NULL);
+  }
+  munmap(shm->region, shm->len);
+  free(shm);
+}
+
+/*************************/
+/* Rings                 */
+/*************************/
+/* The other side doesn't write on the socket after the RSC_SHM_PROBE:
+ * a readable socket has been closed */
+static int peer_gone(int ctlfd) {
+  struct pollfd pfd;
+  pfd.fd = ctlfd;
+  pfd.events = POLLIN | POLLRDHUP;
+  pfd.revents = 0;
+  return poll(&pfd, 1, 0) != 0;
+}
+
+/* Waits for the other side to move '*counter' from 'seen'; 'waiting' is
+ * the flag telling the other side to wake me up. Returns -1 if the other
+ * side is gone */
+static int ring_wait(struct rsc_shm *shm, u_int32_t *counter, u_int32_t *waiting, u_int32_t seen, int ctlfd) {
+  struct timespec timeout;
+  int i;
+  for(i = 0; i < spin; i++) {
+    if(get(counter) != seen)
+      return 0;
+    cpu_relax();
+  }
+  timeout.tv_sec = RSC_SHM_CHECK / 1000;
+  timeout.tv_nsec = (RSC_SHM_CHECK % 1000) * 1000000;
+  while(1) {
+    set(waiting, 1);
+    /* The other side reads 'waiting' after updating the counter */
+    __sync_synchronize();
+    if(get(counter) != seen)
+      break;
+    if(get(&shm->region->closed) ||
+        (futex(counter, FUTEX_WAIT, seen, &timeout) == -1 && errno == ETIMEDOUT &&
+         peer_gone(ctlfd))) {
+      set(waiting, 0);
+      return -1;
+    }
+  }
+  set(waiting, 0);
+  return 0;
+}
+
+static inline void ring_wake(u_int32_t *counter, u_int32_t *waiting) {
+  /* The update of the counter is seen before 'waiting' is read */
+  __sync_synchronize();
+  if(get(waiting))
+    futex(counter, FUTEX_WAKE, 1, NULL);
+}
+
+int rsc_ring_writev(struct rsc_shm *shm, int ring, int ctlfd, struct iovec *v, int count, int nbytes) {
+  struct rsc_ring *r = &shm->region->ring[ring];
+  char *data = ring_data(shm, ring);
+  u_int32_t size = shm->ring_size, head, tail, space, pos, n;
+  int i = 0, off = 0, nwrite = 0;
+
+  /* Only the writer moves 'head' */
+  head = get(&r->head);
+  while(nwrite < nbytes) {
+    tail = get(&r->tail);
+    if((space = size - (head - tail)) == 0 || space > size) {
+      if(space > size || ring_wait(shm, &r->tail, &r->tail_wait, tail, ctlfd) == -1)
+        break;
+      continue;
+    }
+    /* I fill the space free, then the reader can go on */
+    while(space > 0 && nwrite < nbytes) {
+      n = v[i].iov_len - off;
+      if(n > space)
+        n = space;
+      if(n > nbytes - nwrite)
+        n = nbytes - nwrite;
+      pos = head & (size - 1);
+      if(n > size - pos) {
+        memcpy(data + pos, v[i].iov_base + off, size - pos);
+        memcpy(data, v[i].iov_base + off + size - pos, n - (size - pos));
+      } else
+        memcpy(data + pos, v[i].iov_base + off, n);
+      head += n;
+      space -= n;
+      nwrite += n;
+      if((off += n) == v[i].iov_len) {
+        if(++i == count)
+          break;
+        off = 0;
+      }
+    }
+    /* The data is written before the counter */
+    __sync_synchronize();
+    set(&r->head, head);
+    ring_wake(&r->head, &r->head_wait);
+    if(i == count)
+      break;
+  }
+  return nwrite;
+}
+
+int rsc_ring_read(struct rsc_shm *shm, int ring, int ctlfd, void *buf, int nbytes) {
+  struct rsc_ring *r = &shm->region->ring[ring];
+  char *data = ring_data(shm, ring);
+  u_int32_t size = shm->ring_size, head, tail, avail, pos, n;
+  int nread = 0;
+
+  /* Only the reader moves 'tail' */
+  tail = get(&r->tail);
+  while(nread < nbytes) {
+    head = get(&r->head);
+    if((avail = head - tail) == 0 || avail > size) {
+      if(avail > size || ring_wait(shm, &r->head, &r->head_wait, head, ctlfd) == -1)
+        break;
+      continue;
+    }
+    /* The data is read after the counter */
+    __sync_synchronize();
+    n = nbytes - nread;
+    if(n > avail)
+      n = avail;
+    pos = tail & (size - 1);
+    if(n > size - pos) {
+      memcpy(buf + nread, data + pos, size - pos);
+      memcpy(buf + nread + size - pos, data, n - (size - pos));
+    } else
+      memcpy(buf + nread, data + pos, n);
+    tail += n;
+    nread += n;
+    /* The data is copied before the space is given back */
+    __sync_synchronize();
+    set(&r->tail, tail);
+    ring_wake(&r->tail, &r->tail_wait);
+  }
+  return nread;
+}
+
+int rsc_ring_readv(struct rsc_shm *shm, int ring, int ctlfd, struct iovec *v, int count, int nbytes) {
+  int i, n, len, nread = 0;
+  for(i = 0; i < count && nread < nbytes; i++) {
+    len = v[i].iov_len;
+    if(len > nbytes - nread)
+      len = nbytes - nread;
+    n = rsc_ring_read(shm, ring, ctlfd, v[i].iov_base, len);
+    nread += n;
+    if(n < len)
+      break;
+  }
+  return nread;
+}
+
+/*************************/
+/* Fd passing            */
+/*************************/
+int rsc_shm_send_fd(int sockfd, void *buf, int len, int fd) {
+  struct msghdr mh;
+  struct iovec v;
+  struct cmsghdr *cmsg;
+  char control[CMSG_SPACE(sizeof(int))];
+  int n;
+
+  bzero(&mh, sizeof(mh));
+  bzero(control, sizeof(control));
+  v.iov_base = buf;
+  v.iov_len = len;
+  mh.msg_iov = &v;
+  mh.msg_iovlen = 1;
+  mh.msg_control = control;
+  mh.msg_controllen = sizeof(control);
+  cmsg = CMSG_FIRSTHDR(&mh);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  while((n = sendmsg(sockfd, &mh, 0)) == -1 && errno == EINTR)
+    ;
+  /* The fd goes with the first byte: the rest is sent as usual */
+  if(n > 0 && n < len && write_n_bytes(sockfd, buf + n, len - n) != len - n)
+    return -1;
+  return n > 0 ? len : n;
+}
+
+int rsc_shm_recv_fd(int sockfd, void *buf, int len, int *fd) {
+  struct msghdr mh;
+  struct iovec v;
+  struct cmsghdr *cmsg;
+  char control[CMSG_SPACE(sizeof(int))];
+  int n;
+
+  bzero(&mh, sizeof(mh));
+  v.iov_base = buf;
+  v.iov_len = len;
+  mh.msg_iov = &v;
+  mh.msg_iovlen = 1;
+  mh.msg_control = control;
+  mh.msg_controllen = sizeof(control);
+  if((n = recvmsg(sockfd, &mh, MSG_CMSG_CLOEXEC)) <= 0)
+    return n;
+  for(cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg))
+    if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+      if(*fd != -1)
+        close(*fd);
+      memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  return n;
+}
@@ -0,0 +1,351 @@
+/*
+ *   This is part of Remote System Call (RSC) Library.
+ *
+ *   proto.c: round trips of the protocol with a rsc_server started by the
+ *            program: v1/v2 negotiation, out of order completion, lease
+ *            invalidation and shared memory transport
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "rsc_client.h"
+#include "rsc_server.h"
+#include "rsc_cache.h"
+#include "utils.h"
+#include "client_server.h"
+
+#define SERVER_ADDR "127.0.0.1"
+/* The lease is longer than every test: a cached answer changes only
+ * if the server pushes the invalidation */
+#define SERVER_LEASE "60000"
+#define TRANSFER_SIZE (1 << 20)
+/* A test stuck for longer fails */
+#define TEST_TIMEOUT 10
+
+/* As in server/handshake.h */
+struct handshake {
+  enum arch arch;
+};
+
+static char dir[] = "/tmp/rsc_proto.XXXXXX";
+static char server_port[8], es_port[8];
+
+static char *path(char *name) {
+  static char buf[256];
+  snprintf(buf, sizeof(buf), "%s/%s", dir, name);
+  return buf;
+}
+
+/* A free port of the loopback, for the server */
+static void free_port(char *port) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  int fd;
+
+  fd = socket(PF_INET, SOCK_STREAM, 0);
+  assert(fd != -1);
+  bzero(&addr, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  assert(bind(fd, (struct sockaddr *)&addr, len) == 0);
+  assert(getsockname(fd, (struct sockaddr *)&addr, &len) == 0);
+  snprintf(port, 8, "%d", ntohs(addr.sin_port));
+  close(fd);
+}
+
+static int unix_connect(char *name) {
+  struct sockaddr_un addr;
+  int fd;
+
+  bzero(&addr, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path(name), sizeof(addr.sun_path) - 1);
+  if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+    return -1;
+  if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* The handshake and the initialization of librsc, as done by the module */
+static void init_client(int fd, int event_sub_fd) {
+  struct handshake hs;
+  struct reg_cbs *rc;
+  enum arch my_arch;
+
+  assert(fd != -1);
+  my_arch = aconv_get_host_arch();
+  hs.arch = htonl(my_arch);
+  assert(write_n_bytes(fd, &hs, sizeof(hs)) == sizeof(hs));
+  assert(read_n_bytes(fd, &hs, sizeof(hs)) == sizeof(hs));
+  assert(rscc_init(fd, event_sub_fd, event_sub_fd != -1 ? &rc : NULL,
+        my_arch, ntohl(hs.arch)) == 0);
+}
+
+/* librsc alone answers the probes as unknown ioctls, as a v1 server */
+static void *v1_server(void *arg) {
+  int fd = *(int *)arg;
+  struct req_header hd;
+  struct iovec *resp;
+  void *req;
+  int size;
+
+  rscs_init(aconv_get_host_arch());
+  while(read_n_bytes(fd, &hd, sizeof(hd)) == sizeof(hd)) {
+    size = rsc_req_msg_size(&hd);
+    assert(size >= sizeof(hd) && (req = malloc(size)) != NULL);
+    memcpy(req, &hd, sizeof(hd));
+    assert(read_n_bytes(fd, req + sizeof(hd), size - sizeof(hd)) == size - sizeof(hd));
+    assert((resp = rscs_manage_request(aconv_get_host_arch(), req)) != NULL);
+    assert(write_n_bytes(fd, resp[0].iov_base, resp[0].iov_len) == resp[0].iov_len);
+    free(resp[0].iov_base);
+    free(resp);
+    free(req);
+  }
+  return NULL;
+}
+
+static void test_negotiation_v1(void) {
+  pthread_t server_thread;
+  struct stat64 st;
+  int fd[2];
+
+  assert(socketpair(PF_UNIX, SOCK_STREAM, 0, fd) == 0);
+  pthread_create(&server_thread, NULL, v1_server, &fd[1]);
+  assert(rscc_init(fd[0], -1, NULL, aconv_get_host_arch(), aconv_get_host_arch()) == 0);
+  assert(rscc_set_proto(RSC_PROTO_V2) == RSC_PROTO_V1);
+  /* The v1 messages still work after the negotiation */
+  assert(rscc_stat64(dir, &st) == 0 && S_ISDIR(st.st_mode));
+}
+
+static void test_negotiation_v2(void) {
+  struct stat64 st;
+
+  init_client(setup_client(SERVER_ADDR, server_port), -1);
+  assert(rscc_set_proto(RSC_PROTO_V2) == RSC_PROTO_V2);
+  assert(rscc_stat64(dir, &st) == 0 && S_ISDIR(st.st_mode));
+  assert(rscc_stat64(path("nonexistent"), &st) == -1 && errno == ENOENT);
+}
+
+static int fifo_fd;
+static volatile int fifo_read_done;
+
+static void *fifo_reader(void *arg) {
+  char *buf = arg;
+  int ret;
+
+  ret = rscc_read(fifo_fd, buf, 4);
+  fifo_read_done = 1;
+  return (void *)(long)ret;
+}
+
+/* A read blocked on a fifo of the server doesn't delay the requests sent
+ * after it */
+static void test_out_of_order(void) {
+  pthread_t reader_thread;
+  struct stat64 st;
+  char buf[4];
+  void *ret;
+  int fd;
+
+  init_client(setup_client(SERVER_ADDR, server_port), -1);
+  assert(rscc_set_proto(RSC_PROTO_V2) == RSC_PROTO_V2);
+  assert((fifo_fd = rscc_open(path("fifo"), O_RDWR)) != -1);
+  pthread_create(&reader_thread, NULL, fifo_reader, buf);
+  usleep(200000);
+  assert(rscc_stat64(path("fifo"), &st) == 0 && S_ISFIFO(st.st_mode));
+  assert(!fifo_read_done);
+
+  assert((fd = open(path("fifo"), O_WRONLY | O_NONBLOCK)) != -1);
+  assert(write(fd, "ping", 4) == 4);
+  close(fd);
+  pthread_join(reader_thread, &ret);
+  assert((long)ret == 4 && memcmp(buf, "ping", 4) == 0);
+  assert(rscc_close(fifo_fd) == 0);
+}
+
+/* The server pushes the invalidation of a cached answer when the file
+ * changes on its host */
+static void test_lease_invalidation(void) {
+  struct rscc_cache_stats stats;
+  struct stat64 st;
+  int fd, event_sub_fd, i;
+
+  event_sub_fd = setup_client(SERVER_ADDR, es_port);
+  assert(event_sub_fd != -1);
+  init_client(setup_client(SERVER_ADDR, server_port), event_sub_fd);
+  assert(rscc_cache_init(event_sub_fd, atoi(SERVER_LEASE), TRANSFER_SIZE) == atoi(SERVER_LEASE));
+  rscc_cache_get_stats(&stats);
+  assert(stats.coherent);
+
+  assert((fd = open(path("lease"), O_CREAT | O_TRUNC | O_WRONLY, 0644)) != -1);
+  assert(write(fd, "abc", 3) == 3);
+  assert(rscc_cache_stat64(path("lease"), &st) == 0 && st.st_size == 3);
+  assert(rscc_cache_stat64(path("lease"), &st) == 0 && st.st_size == 3);
+  rscc_cache_get_stats(&stats);
+  assert(stats.hits[RSCC_CACHE_STAT] == 1);
+
+  assert(write(fd, "def", 3) == 3);
+  close(fd);
+  for(i = 0; i < 100; i++) {
+    assert(rscc_cache_stat64(path("lease"), &st) == 0);
+    if(st.st_size == 6)
+      break;
+    usleep(20000);
+  }
+  assert(st.st_size == 6);
+  rscc_cache_get_stats(&stats);
+  assert(stats.pushed > 0);
+}
+
+/* The client maps the region if it's listed among its mappings */
+static int shm_mapped(void) {
+  char line[512];
+  FILE *maps;
+  int found = 0;
+
+  assert((maps = fopen("/proc/self/maps", "r")) != NULL);
+  while(!found && fgets(line, sizeof(line), maps) != NULL)
+    found = (strstr(line, "/memfd:rsc") != NULL);
+  fclose(maps);
+  return found;
+}
+
+/* A transfer larger than the rings, through the shared memory */
+static void test_shm_transfer(void) {
+  char *data, *buf;
+  int fd, i;
+
+  init_client(unix_connect("sock"), -1);
+  assert(rscc_set_proto(RSC_PROTO_V2) == RSC_PROTO_V1);
+  assert(shm_mapped());
+
+  assert((data = malloc(TRANSFER_SIZE)) != NULL && (buf = malloc(TRANSFER_SIZE)) != NULL);
+  for(i = 0; i < TRANSFER_SIZE; i++)
+    data[i] = random();
+  assert((fd = rscc_open(path("shm"), O_RDWR)) != -1);
+  assert(rscc_write(fd, data, TRANSFER_SIZE) == TRANSFER_SIZE);
+  assert(rscc_pread64(fd, buf, TRANSFER_SIZE, 0) == TRANSFER_SIZE);
+  assert(memcmp(data, buf, TRANSFER_SIZE) == 0);
+  assert(rscc_close(fd) == 0);
+
+  /* The data reached the file of the server */
+  bzero(buf, TRANSFER_SIZE);
+  assert((fd = open(path("shm"), O_RDONLY)) != -1);
+  assert(read_n_bytes(fd, buf, TRANSFER_SIZE) == TRANSFER_SIZE);
+  assert(memcmp(data, buf, TRANSFER_SIZE) == 0);
+  close(fd);
+  free(data);
+  free(buf);
+}
+
+/* The client state of librsc is global: every test runs in its own process */
+static int run(char *name, void (*test)(void)) {
+  int status;
+  pid_t pid;
+
+  fflush(stdout);
+  if((pid = fork()) == 0) {
+    alarm(TEST_TIMEOUT);
+    test();
+    exit(0);
+  }
+  assert(pid != -1 && waitpid(pid, &status, 0) == pid);
+  status = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  printf("%-24s %s\n", name, status ? "OK" : "FAILED");
+  return !status;
+}
+
+static pid_t start_server(char *server) {
+  char unix_path[256];
+  pid_t pid;
+  int fd, i;
+
+  free_port(server_port);
+  free_port(es_port);
+  strncpy(unix_path, path("sock"), sizeof(unix_path));
+  if((pid = fork()) == 0) {
+    execl(server, server, "-a", SERVER_ADDR, "-p", server_port, "-e", es_port,
+        "-u", unix_path, "-l", SERVER_LEASE, NULL);
+    fprintf(stderr, "execl() error: %s: %s\n", server, strerror(errno));
+    exit(-1);
+  }
+  assert(pid != -1);
+  /* The server is ready when it accepts on the unix socket */
+  for(i = 0; i < 100; i++) {
+    if((fd = unix_connect("sock")) != -1) {
+      close(fd);
+      return pid;
+    }
+    usleep(50000);
+  }
+  kill(pid, SIGTERM);
+  return -1;
+}
+
+int main(int argc, char *argv[]) {
+  char *server = "../../server/rsc_server";
+  pid_t pid;
+  int fd, fails = 0;
+
+  if(argc > 2) {
+    fprintf(stderr, "USAGE: %s [RSC_SERVER]\n", argv[0]);
+    exit(-1);
+  }
+  if(argc == 2)
+    server = argv[1];
+  assert(mkdtemp(dir) != NULL);
+  assert(mkfifo(path("fifo"), 0644) == 0);
+  assert((fd = creat(path("shm"), 0644)) != -1);
+  close(fd);
+  if((pid = start_server(server)) == -1) {
+    fprintf(stderr, "%s doesn't start\n", server);
+    exit(-1);
+  }
+
+  fails += run("negotiation v1", test_negotiation_v1);
+  fails += run("negotiation v2", test_negotiation_v2);
+  fails += run("out of order completion", test_out_of_order);
+  fails += run("lease invalidation", test_lease_invalidation);
+  fails += run("shm transfer", test_shm_transfer);
+
+  kill(pid, SIGTERM);
+  waitpid(pid, NULL, 0);
+  unlink(path("fifo"));
+  unlink(path("lease"));
+  unlink(path("shm"));
+  unlink(path("sock"));
+  unlink(path("sock.es"));
+  rmdir(dir);
+  return fails;
+}
@@ -134,15 +134,17 @@ static void test_cache(void)
 static void test_server_query(int fd) {
   int ret, i;
   struct ioctl_req_header req;
-  struct ioctl_resp_header *resp;
+  struct iovec *resp;
 
   for(i = 0; i < 4; i++) {
     ret = read(fd, &req, sizeof(struct ioctl_req_header));
     assert(!(ret != sizeof(struct ioctl_req_header)));
     req.req_size = ntohl(req.req_size);
     resp = rscs_manage_ioctl_request(&req);
-    ret = write(fd, resp, sizeof(struct ioctl_resp_header));
+    ret = write(fd, resp[0].iov_base, resp[0].iov_len);
     assert(ret == sizeof(struct ioctl_resp_header));
+    free(resp[0].iov_base);
+    free(resp);
   }
 }
 
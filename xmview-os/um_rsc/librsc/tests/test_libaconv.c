@@ -1711,11 +1711,20 @@ static void test_struct_statfs64_w(int fd, enum arch from, enum arch to) {
   s.f_fsid.__val[1] = 0x12345ade;
   s.f_namelen	= 0x09876543;
   s.f_frsize	= 0x0aacaabb;
+#ifdef _STATFS_F_FLAGS
+  /* f_flags takes the place of the first spare word */
+  s.f_flags   = 0x01112234;
+  s.f_spare[0]= 0x02412234;
+  s.f_spare[1]= 0x0111ab34;
+  s.f_spare[2]= 0x0fd12254;
+  s.f_spare[3]= 0x011a22a4;
+#else
   s.f_spare[0]= 0x01112234;
   s.f_spare[1]= 0x02412234;
   s.f_spare[2]= 0x0111ab34;
   s.f_spare[3]= 0x0fd12254;
   s.f_spare[4]= 0x011a22a4;
+#endif
 
   assert((out = malloc(size)) != NULL);
   ret = aconv_struct_statfs64(&s, from, to, out);
@@ -1742,11 +1751,20 @@ static void test_struct_statfs64_r(int fd, enum arch from, enum arch to) {
   s.f_fsid.__val[1] = 0x12345ade;
   s.f_namelen	= 0x09876543;
   s.f_frsize	= 0x0aacaabb;
+#ifdef _STATFS_F_FLAGS
+  /* f_flags takes the place of the first spare word */
+  s.f_flags   = 0x01112234;
+  s.f_spare[0]= 0x02412234;
+  s.f_spare[1]= 0x0111ab34;
+  s.f_spare[2]= 0x0fd12254;
+  s.f_spare[3]= 0x011a22a4;
+#else
   s.f_spare[0]= 0x01112234;
   s.f_spare[1]= 0x02412234;
   s.f_spare[2]= 0x0111ab34;
   s.f_spare[3]= 0x0fd12254;
   s.f_spare[4]= 0x011a22a4;
+#endif
 
   assert((in = malloc(size)) != NULL);
   assert(read(fd, in, size) == size);
@@ -1761,11 +1779,15 @@ static void test_struct_statfs64_r(int fd, enum arch from, enum arch to) {
   assert(s.f_fsid.__val[1] == in->f_fsid.__val[1]);
   assert(s.f_namelen == in->f_namelen);	
   assert(s.f_frsize == in->f_frsize);	
+#ifdef _STATFS_F_FLAGS
+  assert(s.f_flags == in->f_flags);
+#else
+  assert(s.f_spare[4] == in->f_spare[4]);
+#endif
   assert(s.f_spare[0] == in->f_spare[0]);
   assert(s.f_spare[1] == in->f_spare[1]);
   assert(s.f_spare[2] == in->f_spare[2]);
   assert(s.f_spare[3] == in->f_spare[3]);
-  assert(s.f_spare[4] == in->f_spare[4]);
 
   free(in);
 }
@@ -107,6 +107,7 @@ void server_test__llseek(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct _llseek_req *input = fill__llseek_request();
   struct _llseek_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -136,17 +137,13 @@ void server_test__llseek(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post__llseek_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post__llseek_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled__llseek_request(input, 0);
 #endif
  
@@ -188,6 +185,7 @@ void server_test_accept(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct accept_req *input = fill_accept_request(FALSE);
   struct accept_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -214,17 +212,13 @@ void server_test_accept(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_accept_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_accept_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_accept_request(input, 0);
  
 }
@@ -258,6 +252,7 @@ void server_test_access(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct access_req *input = fill_access_request(FALSE);
   struct access_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -283,17 +278,13 @@ void server_test_access(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_access_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_access_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_access_request(input, 0);
  
 }
@@ -332,6 +323,7 @@ void server_test_adjtimex(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct adjtimex_req *input = fill_adjtimex_request(FALSE);
   struct adjtimex_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -357,17 +349,13 @@ void server_test_adjtimex(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_adjtimex_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_adjtimex_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_adjtimex_request(input, 0);
  
 }
@@ -402,6 +390,7 @@ void server_test_bind(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct bind_req *input = fill_bind_request(FALSE);
   struct bind_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -428,17 +417,13 @@ void server_test_bind(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_bind_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_bind_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_bind_request(input, 0);
  
 }
@@ -471,6 +456,7 @@ void server_test_chdir(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct chdir_req *input = fill_chdir_request(FALSE);
   struct chdir_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -495,17 +481,13 @@ void server_test_chdir(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_chdir_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_chdir_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_chdir_request(input, 0);
  
 }
@@ -539,6 +521,7 @@ void server_test_chmod(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct chmod_req *input = fill_chmod_request(FALSE);
   struct chmod_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -564,17 +547,13 @@ void server_test_chmod(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_chmod_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_chmod_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_chmod_request(input, 0);
  
 }
@@ -609,6 +588,7 @@ void server_test_chown(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct chown_req *input = fill_chown_request(FALSE);
   struct chown_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -635,17 +615,13 @@ void server_test_chown(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_chown_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_chown_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_chown_request(input, 0);
  
 }
@@ -691,6 +667,7 @@ void server_test_chown32(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct chown32_req *input = fill_chown32_request(FALSE);
   struct chown32_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -717,17 +694,13 @@ void server_test_chown32(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_chown32_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_chown32_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_chown32_request(input, 0);
 #endif
  
@@ -768,6 +741,7 @@ void server_test_clock_getres(int fd, enum arch server_arch, enum arch client_ar
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct clock_getres_req *input = fill_clock_getres_request();
   struct clock_getres_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -794,17 +768,13 @@ void server_test_clock_getres(int fd, enum arch server_arch, enum arch client_ar
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_clock_getres_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_clock_getres_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_clock_getres_request(input, 0);
  
 }
@@ -844,6 +814,7 @@ void server_test_clock_gettime(int fd, enum arch server_arch, enum arch client_a
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct clock_gettime_req *input = fill_clock_gettime_request();
   struct clock_gettime_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -870,17 +841,13 @@ void server_test_clock_gettime(int fd, enum arch server_arch, enum arch client_a
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_clock_gettime_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_clock_gettime_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_clock_gettime_request(input, 0);
  
 }
@@ -914,6 +881,7 @@ void server_test_clock_settime(int fd, enum arch server_arch, enum arch client_a
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct clock_settime_req *input = fill_clock_settime_request(FALSE);
   struct clock_settime_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -939,17 +907,13 @@ void server_test_clock_settime(int fd, enum arch server_arch, enum arch client_a
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_clock_settime_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_clock_settime_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_clock_settime_request(input, 0);
  
 }
@@ -982,6 +946,7 @@ void server_test_close(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct close_req *input = fill_close_request();
   struct close_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1006,17 +971,13 @@ void server_test_close(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_close_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_close_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_close_request(input, 0);
  
 }
@@ -1051,6 +1012,7 @@ void server_test_connect(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct connect_req *input = fill_connect_request(FALSE);
   struct connect_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1077,17 +1039,13 @@ void server_test_connect(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_connect_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_connect_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_connect_request(input, 0);
  
 }
@@ -1120,6 +1078,7 @@ void server_test_dup(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct dup_req *input = fill_dup_request();
   struct dup_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1144,17 +1103,13 @@ void server_test_dup(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_dup_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_dup_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_dup_request(input, 0);
  
 }
@@ -1188,6 +1143,7 @@ void server_test_dup2(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct dup2_req *input = fill_dup2_request();
   struct dup2_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1213,17 +1169,13 @@ void server_test_dup2(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_dup2_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_dup2_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_dup2_request(input, 0);
  
 }
@@ -1256,6 +1208,7 @@ void server_test_fchdir(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fchdir_req *input = fill_fchdir_request();
   struct fchdir_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1280,17 +1233,13 @@ void server_test_fchdir(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fchdir_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_fchdir_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fchdir_request(input, 0);
  
 }
@@ -1324,6 +1273,7 @@ void server_test_fchmod(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fchmod_req *input = fill_fchmod_request();
   struct fchmod_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1349,17 +1299,13 @@ void server_test_fchmod(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fchmod_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_fchmod_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fchmod_request(input, 0);
  
 }
@@ -1394,6 +1340,7 @@ void server_test_fchown(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fchown_req *input = fill_fchown_request();
   struct fchown_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1420,17 +1367,13 @@ void server_test_fchown(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fchown_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fchown_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fchown_request(input, 0);
  
 }
@@ -1476,6 +1419,7 @@ void server_test_fchown32(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fchown32_req *input = fill_fchown32_request();
   struct fchown32_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1502,17 +1446,13 @@ void server_test_fchown32(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fchown32_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fchown32_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fchown32_request(input, 0);
 #endif
  
@@ -1546,6 +1486,7 @@ void server_test_fdatasync(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fdatasync_req *input = fill_fdatasync_request();
   struct fdatasync_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1570,17 +1511,13 @@ void server_test_fdatasync(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fdatasync_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fdatasync_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fdatasync_request(input, 0);
  
 }
@@ -1622,6 +1559,7 @@ void server_test_fgetxattr(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fgetxattr_req *input = fill_fgetxattr_request(FALSE);
   struct fgetxattr_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1650,17 +1588,13 @@ void server_test_fgetxattr(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fgetxattr_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fgetxattr_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fgetxattr_request(input, 0);
  
 }
@@ -1700,6 +1634,7 @@ void server_test_fstat64(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fstat64_req *input = fill_fstat64_request();
   struct fstat64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1726,17 +1661,13 @@ void server_test_fstat64(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fstat64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fstat64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fstat64_request(input, 0);
  
 }
@@ -1776,6 +1707,7 @@ void server_test_fstatfs64(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fstatfs64_req *input = fill_fstatfs64_request();
   struct fstatfs64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1802,17 +1734,13 @@ void server_test_fstatfs64(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fstatfs64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fstatfs64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fstatfs64_request(input, 0);
  
 }
@@ -1845,6 +1773,7 @@ void server_test_fsync(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct fsync_req *input = fill_fsync_request();
   struct fsync_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1869,17 +1798,13 @@ void server_test_fsync(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_fsync_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_fsync_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_fsync_request(input, 0);
  
 }
@@ -1913,6 +1838,7 @@ void server_test_ftruncate64(int fd, enum arch server_arch, enum arch client_arc
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct ftruncate64_req *input = fill_ftruncate64_request();
   struct ftruncate64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -1938,17 +1864,13 @@ void server_test_ftruncate64(int fd, enum arch server_arch, enum arch client_arc
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_ftruncate64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_ftruncate64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_ftruncate64_request(input, 0);
  
 }
@@ -1989,6 +1911,7 @@ void server_test_getdents64(int fd, enum arch server_arch, enum arch client_arch
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct getdents64_req *input = fill_getdents64_request();
   struct getdents64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2016,17 +1939,13 @@ void server_test_getdents64(int fd, enum arch server_arch, enum arch client_arch
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_getdents64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_getdents64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_getdents64_request(input, 0);
  
 }
@@ -2067,6 +1986,7 @@ void server_test_getpeername(int fd, enum arch server_arch, enum arch client_arc
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct getpeername_req *input = fill_getpeername_request(FALSE);
   struct getpeername_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2093,17 +2013,13 @@ void server_test_getpeername(int fd, enum arch server_arch, enum arch client_arc
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_getpeername_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_getpeername_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_getpeername_request(input, 0);
  
 }
@@ -2144,6 +2060,7 @@ void server_test_getsockname(int fd, enum arch server_arch, enum arch client_arc
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct getsockname_req *input = fill_getsockname_request(FALSE);
   struct getsockname_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2170,17 +2087,13 @@ void server_test_getsockname(int fd, enum arch server_arch, enum arch client_arc
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_getsockname_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_getsockname_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_getsockname_request(input, 0);
  
 }
@@ -2223,6 +2136,7 @@ void server_test_getsockopt(int fd, enum arch server_arch, enum arch client_arch
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct getsockopt_req *input = fill_getsockopt_request(FALSE);
   struct getsockopt_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2251,17 +2165,13 @@ void server_test_getsockopt(int fd, enum arch server_arch, enum arch client_arch
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_getsockopt_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_getsockopt_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_getsockopt_request(input, 0);
  
 }
@@ -2301,6 +2211,7 @@ void server_test_gettimeofday(int fd, enum arch server_arch, enum arch client_ar
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct gettimeofday_req *input = fill_gettimeofday_request();
   struct gettimeofday_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2326,17 +2237,13 @@ void server_test_gettimeofday(int fd, enum arch server_arch, enum arch client_ar
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_gettimeofday_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_gettimeofday_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_gettimeofday_request(input, 0);
  
 }
@@ -2378,6 +2285,7 @@ void server_test_getxattr(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct getxattr_req *input = fill_getxattr_request(FALSE, FALSE);
   struct getxattr_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2406,17 +2314,13 @@ void server_test_getxattr(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_getxattr_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_getxattr_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_getxattr_request(input, 0);
  
 }
@@ -2451,6 +2355,7 @@ void server_test_lchown(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct lchown_req *input = fill_lchown_request(FALSE);
   struct lchown_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2477,17 +2382,13 @@ void server_test_lchown(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_lchown_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_lchown_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_lchown_request(input, 0);
  
 }
@@ -2533,6 +2434,7 @@ void server_test_lchown32(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct lchown32_req *input = fill_lchown32_request(FALSE);
   struct lchown32_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2559,17 +2461,13 @@ void server_test_lchown32(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_lchown32_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_lchown32_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_lchown32_request(input, 0);
 #endif
  
@@ -2612,6 +2510,7 @@ void server_test_lgetxattr(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct lgetxattr_req *input = fill_lgetxattr_request(FALSE, FALSE);
   struct lgetxattr_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2640,17 +2539,13 @@ void server_test_lgetxattr(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_lgetxattr_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_lgetxattr_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_lgetxattr_request(input, 0);
  
 }
@@ -2684,6 +2579,7 @@ void server_test_link(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct link_req *input = fill_link_request(FALSE, FALSE);
   struct link_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2709,17 +2605,13 @@ void server_test_link(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_link_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_link_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_link_request(input, 0);
  
 }
@@ -2753,6 +2645,7 @@ void server_test_listen(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct listen_req *input = fill_listen_request();
   struct listen_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2778,17 +2671,13 @@ void server_test_listen(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_listen_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_listen_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_listen_request(input, 0);
  
 }
@@ -2823,6 +2712,7 @@ void server_test_lseek(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct lseek_req *input = fill_lseek_request();
   struct lseek_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2849,17 +2739,13 @@ void server_test_lseek(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_lseek_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_lseek_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_lseek_request(input, 0);
  
 }
@@ -2899,6 +2785,7 @@ void server_test_lstat64(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct lstat64_req *input = fill_lstat64_request(FALSE);
   struct lstat64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2925,17 +2812,13 @@ void server_test_lstat64(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_lstat64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_lstat64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_lstat64_request(input, 0);
  
 }
@@ -2969,6 +2852,7 @@ void server_test_mkdir(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct mkdir_req *input = fill_mkdir_request(FALSE);
   struct mkdir_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -2994,17 +2878,13 @@ void server_test_mkdir(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_mkdir_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_mkdir_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_mkdir_request(input, 0);
  
 }
@@ -3041,6 +2921,7 @@ void server_test_mount(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct mount_req *input = fill_mount_request(FALSE, FALSE, FALSE, FALSE);
   struct mount_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3069,17 +2950,13 @@ void server_test_mount(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_mount_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_mount_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_mount_request(input, 0);
  
 }
@@ -3113,6 +2990,7 @@ void server_test_open(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct open_req *input = fill_open_request(FALSE);
   struct open_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3138,17 +3016,13 @@ void server_test_open(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_open_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_open_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_open_request(input, 0);
  
 }
@@ -3190,6 +3064,7 @@ void server_test_pread64(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct pread64_req *input = fill_pread64_request();
   struct pread64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3218,17 +3093,13 @@ void server_test_pread64(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_pread64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_pread64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_pread64_request(input, 0);
  
 }
@@ -3264,6 +3135,7 @@ void server_test_pwrite64(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct pwrite64_req *input = fill_pwrite64_request(FALSE);
   struct pwrite64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3291,17 +3163,13 @@ void server_test_pwrite64(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_pwrite64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_pwrite64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_pwrite64_request(input, 0);
  
 }
@@ -3342,6 +3210,7 @@ void server_test_read(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct read_req *input = fill_read_request();
   struct read_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3369,17 +3238,13 @@ void server_test_read(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_read_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_read_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_read_request(input, 0);
  
 }
@@ -3420,6 +3285,7 @@ void server_test_readlink(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct readlink_req *input = fill_readlink_request(FALSE);
   struct readlink_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3447,17 +3313,13 @@ void server_test_readlink(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_readlink_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_readlink_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_readlink_request(input, 0);
  
 }
@@ -3506,6 +3368,7 @@ void server_test_recv(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct recv_req *input = fill_recv_request();
   struct recv_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3534,17 +3397,13 @@ void server_test_recv(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_recv_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_recv_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_recv_request(input, 0);
 #endif
  
@@ -3589,6 +3448,7 @@ void server_test_recvfrom(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct recvfrom_req *input = fill_recvfrom_request(FALSE, FALSE);
   struct recvfrom_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3618,17 +3478,13 @@ void server_test_recvfrom(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_recvfrom_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_recvfrom_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_recvfrom_request(input, 0);
  
 }
@@ -3662,6 +3518,7 @@ void server_test_rename(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct rename_req *input = fill_rename_request(FALSE, FALSE);
   struct rename_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3687,17 +3544,13 @@ void server_test_rename(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_rename_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_rename_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_rename_request(input, 0);
  
 }
@@ -3730,6 +3583,7 @@ void server_test_rmdir(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct rmdir_req *input = fill_rmdir_request(FALSE);
   struct rmdir_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3754,17 +3608,13 @@ void server_test_rmdir(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_rmdir_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_rmdir_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_rmdir_request(input, 0);
  
 }
@@ -3807,6 +3657,7 @@ void server_test_send(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct send_req *input = fill_send_request(FALSE);
   struct send_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3834,17 +3685,13 @@ void server_test_send(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_send_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_send_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_send_request(input, 0);
 #endif
  
@@ -3883,6 +3730,7 @@ void server_test_sendto(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct sendto_req *input = fill_sendto_request(FALSE, FALSE);
   struct sendto_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3912,17 +3760,13 @@ void server_test_sendto(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_sendto_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_sendto_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_sendto_request(input, 0);
  
 }
@@ -3956,6 +3800,7 @@ void server_test_setdomainname(int fd, enum arch server_arch, enum arch client_a
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct setdomainname_req *input = fill_setdomainname_request(FALSE);
   struct setdomainname_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -3981,17 +3826,13 @@ void server_test_setdomainname(int fd, enum arch server_arch, enum arch client_a
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_setdomainname_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_setdomainname_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_setdomainname_request(input, 0);
  
 }
@@ -4025,6 +3866,7 @@ void server_test_sethostname(int fd, enum arch server_arch, enum arch client_arc
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct sethostname_req *input = fill_sethostname_request(FALSE);
   struct sethostname_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4050,17 +3892,13 @@ void server_test_sethostname(int fd, enum arch server_arch, enum arch client_arc
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_sethostname_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_sethostname_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_sethostname_request(input, 0);
  
 }
@@ -4097,6 +3935,7 @@ void server_test_setsockopt(int fd, enum arch server_arch, enum arch client_arch
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct setsockopt_req *input = fill_setsockopt_request(FALSE);
   struct setsockopt_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4125,17 +3964,13 @@ void server_test_setsockopt(int fd, enum arch server_arch, enum arch client_arch
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_setsockopt_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_setsockopt_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_setsockopt_request(input, 0);
  
 }
@@ -4169,6 +4004,7 @@ void server_test_settimeofday(int fd, enum arch server_arch, enum arch client_ar
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct settimeofday_req *input = fill_settimeofday_request(FALSE, FALSE);
   struct settimeofday_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4194,17 +4030,13 @@ void server_test_settimeofday(int fd, enum arch server_arch, enum arch client_ar
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_settimeofday_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_settimeofday_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_settimeofday_request(input, 0);
  
 }
@@ -4238,6 +4070,7 @@ void server_test_shutdown(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct shutdown_req *input = fill_shutdown_request();
   struct shutdown_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4263,17 +4096,13 @@ void server_test_shutdown(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_shutdown_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_shutdown_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_shutdown_request(input, 0);
  
 }
@@ -4308,6 +4137,7 @@ void server_test_socket(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct socket_req *input = fill_socket_request();
   struct socket_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4334,17 +4164,13 @@ void server_test_socket(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_socket_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_socket_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_socket_request(input, 0);
  
 }
@@ -4384,6 +4210,7 @@ void server_test_stat64(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct stat64_req *input = fill_stat64_request(FALSE);
   struct stat64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4410,17 +4237,13 @@ void server_test_stat64(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_stat64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_stat64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_stat64_request(input, 0);
  
 }
@@ -4460,6 +4283,7 @@ void server_test_statfs64(int fd, enum arch server_arch, enum arch client_arch)
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct statfs64_req *input = fill_statfs64_request(FALSE);
   struct statfs64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4486,17 +4310,13 @@ void server_test_statfs64(int fd, enum arch server_arch, enum arch client_arch)
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_statfs64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
+  resp_iov = rscs_post_statfs64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_statfs64_request(input, 0);
  
 }
@@ -4530,6 +4350,7 @@ void server_test_symlink(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct symlink_req *input = fill_symlink_request(FALSE, FALSE);
   struct symlink_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4555,17 +4376,13 @@ void server_test_symlink(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_symlink_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_symlink_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_symlink_request(input, 0);
  
 }
@@ -4599,6 +4416,7 @@ void server_test_truncate64(int fd, enum arch server_arch, enum arch client_arch
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct truncate64_req *input = fill_truncate64_request(FALSE);
   struct truncate64_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4624,17 +4442,13 @@ void server_test_truncate64(int fd, enum arch server_arch, enum arch client_arch
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_truncate64_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_truncate64_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_truncate64_request(input, 0);
  
 }
@@ -4668,6 +4482,7 @@ void server_test_umount2(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct umount2_req *input = fill_umount2_request(FALSE);
   struct umount2_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4693,17 +4508,13 @@ void server_test_umount2(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_umount2_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_umount2_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_umount2_request(input, 0);
  
 }
@@ -4742,6 +4553,7 @@ void server_test_uname(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct uname_req *input = fill_uname_request();
   struct uname_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4767,17 +4579,13 @@ void server_test_uname(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_uname_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_uname_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_uname_request(input, 0);
  
 }
@@ -4810,6 +4618,7 @@ void server_test_unlink(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct unlink_req *input = fill_unlink_request(FALSE);
   struct unlink_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4834,17 +4643,13 @@ void server_test_unlink(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_unlink_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_unlink_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_unlink_request(input, 0);
  
 }
@@ -4878,6 +4683,7 @@ void server_test_utime(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct utime_req *input = fill_utime_request(FALSE, FALSE);
   struct utime_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4903,17 +4709,13 @@ void server_test_utime(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_utime_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_utime_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_utime_request(input, 0);
  
 }
@@ -4948,6 +4750,7 @@ void server_test_utimes(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct utimes_req *input = fill_utimes_request(FALSE);
   struct utimes_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -4974,17 +4777,13 @@ void server_test_utimes(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_utimes_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_utimes_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_utimes_request(input, 0);
  
 }
@@ -5019,6 +4818,7 @@ void server_test_write(int fd, enum arch server_arch, enum arch client_arch) {
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct write_req *input = fill_write_request(FALSE);
   struct write_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -5045,17 +4845,13 @@ void server_test_write(int fd, enum arch server_arch, enum arch client_arch) {
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_write_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
-
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
+  resp_iov = rscs_post_write_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_write_request(input, 0);
  
 }
@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include "rsc_client.h"
 #include "rsc_server.h"
+#include "test_rsc_server.h"
 #include "tests.h"
 #include "aconv.h"
 
@@ -93,6 +94,18 @@ void *test_server(void *fdp) {
   fprintf(stderr, "Server: my arch = %s, client arch = %s\n", aconv_arch2str(myarch), aconv_arch2str(carch));
   ret = rscs_init(myarch);
   assert(ret == 0);
+  /* On a unix socket rscc_init() offers a shared memory region: the
+   * answer of a server which doesn't map it is IOCTL_UNMANAGED */
+  if(myarch == carch) {
+    struct ioctl_req_header req;
+    struct iovec *resp;
+    assert(read(fd, &req, sizeof(req)) == sizeof(req));
+    assert(ntohl(req.req_ioctl_request) == RSC_SHM_PROBE);
+    resp = rscs_manage_ioctl_request(&req);
+    assert(write(fd, resp[0].iov_base, resp[0].iov_len) == resp[0].iov_len);
+    free(resp[0].iov_base);
+    free(resp);
+  }
 
   /*** TESTS ***/
   fprintf(stderr, "test_list... "); fflush(stderr);
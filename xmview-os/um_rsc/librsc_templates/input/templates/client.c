@@ -61,6 +61,7 @@
 #include "rsc_client.h"
 #include "rsc_consts.h"
 #include "event_sub.h"
+#include "rsc_shm.h"
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -70,6 +71,8 @@
 #include <arpa/inet.h>
 #include <sys/uio.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <sys/un.h>
 
 
 <%# Creates the list of headers "header".  %>
@@ -123,6 +126,11 @@ static int rsc_event_sub_fd;
 static 
 #endif
 struct ioctl_cache *ioctl_cache;
+static pthread_mutex_t ioctl_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct rscc_call;
+static void rscc_call_end(struct rscc_call *call);
+static int rscc_shm_init(void);
 
 int rscc_init(int client_fd, int event_sub_fd, struct reg_cbs **rc, enum arch c_arch, enum arch s_arch) {
   if(c_arch < ARCH_FIRST || c_arch > ARCH_LAST) 
@@ -144,6 +152,385 @@ int rscc_init(int client_fd, int event_sub_fd, struct reg_cbs **rc, enum arch c_
   ioctl_cache = ioctl_cache_init(20);
   if(ioctl_cache == NULL)
     return -1;
+  /* A server on the same host can share the memory with me */
+  if(c_arch == s_arch && rscc_shm_init() == -1)
+    return -1;
+  return 0;
+}
+
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  Calls in flight                                                   ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+/* With protocol v1 there is a single call at a time: the socket is locked
+ * from the request to the end of the response. With protocol v2 every
+ * message is preceded by a rsc_frame_header: the requests are sent as soon
+ * as they are ready and a receiving thread gives each response to the
+ * call with the same id, in the order they arrive. The responses of at
+ * least RSC_DIRECT_MIN bytes are read from the socket by the call itself,
+ * directly into the buffers of the caller. With the shared memory the v1
+ * messages go through the rings of the region instead of the socket. */
+#define RSC_DIRECT_MIN (16 * 1024)
+
+struct rscc_call {
+  u_int32_t id;
+  /* The whole response message (v2) */
+  void *resp;
+  int resp_size;
+  int pos;
+  /* 1 when the response is arrived, -1 if the connection was lost */
+  int done;
+  /* 1 if the response is still in the socket ('resp' is NULL), -1 if
+   * the connection broke while the call was reading it */
+  int direct;
+  pthread_cond_t cond;
+  struct rscc_call *next;
+};
+
+static int rsc_proto = RSC_PROTO_V1;
+/* v1: the call in progress; v2: the list of pending calls */
+static pthread_mutex_t rsc_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t rsc_send_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct rscc_call rsc_v1_call;
+static struct rscc_call *rsc_pending;
+static u_int32_t rsc_next_id;
+static int rsc_conn_lost;
+/* The region shared with a server on the same host, NULL if none */
+static struct rsc_shm *rsc_shm;
+/* The socket belongs to a call reading its response: 1 while it 
+ * reads, 0 when it has finished, -1 if the connection broke */
+static int rsc_direct;
+static pthread_cond_t rsc_direct_cond = PTHREAD_COND_INITIALIZER;
+
+/* Removes the call 'id' from the pending ones, NULL if there isn't.
+ * rsc_call_mutex must be locked */
+static struct rscc_call *rscc_call_take(u_int32_t id) {
+  struct rscc_call *call, **pp;
+  for(pp = &rsc_pending; *pp != NULL && (*pp)->id != id; pp = &((*pp)->next))
+    ;
+  if((call = *pp) != NULL)
+    *pp = call->next;
+  return call;
+}
+
+/* Reads and throws away the next 'size' bytes of the socket */
+static int rscc_discard(int size) {
+  char buf[4096];
+  int n;
+  while(size > 0) {
+    n = size > sizeof(buf) ? sizeof(buf) : size;
+    if(read_n_bytes(rsc_sockfd, buf, n) != n)
+      return -1;
+    size -= n;
+  }
+  return 0;
+}
+
+static void *rscc_recv_loop(void *arg) {
+  struct rsc_frame_header frame;
+  struct rscc_call *call;
+  void *resp;
+  int size;
+
+  while(read_n_bytes(rsc_sockfd, &frame, sizeof(frame)) == sizeof(frame)) {
+    if(ntohl(frame.frame_size) > RSC_FRAME_MAX) {
+      RSC_DEBUG(RSCD_MINIMAL, "Frame of %u bytes, closing the connection", ntohl(frame.frame_size));
+      break;
+    }
+    size = ntohl(frame.frame_size);
+    pthread_mutex_lock(&rsc_call_mutex);
+    call = rscc_call_take(ntohl(frame.frame_id));
+    if(call != NULL && size >= RSC_DIRECT_MIN) {
+      /* I wait for the call to read the response */
+      call->resp_size = size;
+      call->direct = 1;
+      call->done = 1;
+      rsc_direct = 1;
+      pthread_cond_signal(&call->cond);
+      while(rsc_direct == 1)
+        pthread_cond_wait(&rsc_direct_cond, &rsc_call_mutex);
+      pthread_mutex_unlock(&rsc_call_mutex);
+      if(rsc_direct == -1)
+        break;
+      continue;
+    }
+    pthread_mutex_unlock(&rsc_call_mutex);
+    if(call == NULL) {
+      /* Nobody waits for it, I throw it away without buffering it */
+      RSC_DEBUG(RSCD_MINIMAL, "Response for the unknown request %u", ntohl(frame.frame_id));
+      if(rscc_discard(size) < 0)
+        break;
+      continue;
+    }
+    /* Only the small responses are buffered (size < RSC_DIRECT_MIN) */
+    if((resp = malloc(size)) == NULL || read_n_bytes(rsc_sockfd, resp, size) != size) {
+      free(resp);
+      pthread_mutex_lock(&rsc_call_mutex);
+      call->done = -1;
+      pthread_cond_signal(&call->cond);
+      pthread_mutex_unlock(&rsc_call_mutex);
+      break;
+    }
+    pthread_mutex_lock(&rsc_call_mutex);
+    call->resp = resp;
+    call->resp_size = size;
+    call->done = 1;
+    pthread_cond_signal(&call->cond);
+    pthread_mutex_unlock(&rsc_call_mutex);
+  }
+
+  /* The connection is lost or the server is broken: I close it, the
+   * pending calls fail and no new one is sent */
+  shutdown(rsc_sockfd, SHUT_RDWR);
+  pthread_mutex_lock(&rsc_call_mutex);
+  rsc_conn_lost = 1;
+  for(call = rsc_pending; call != NULL; call = call->next) {
+    call->done = -1;
+    pthread_cond_signal(&call->cond);
+  }
+  rsc_pending = NULL;
+  pthread_mutex_unlock(&rsc_call_mutex);
+  return NULL;
+}
+
+/* Sends the request in 'v' and returns the number of bytes sent; if
+ * the request has been sent, '*callp' is the call that receives
+ * the response and that must be closed by rscc_call_end(). */
+static int rscc_call_send(struct rscc_call **callp, struct iovec *v, int count, int nbytes) {
+  struct rscc_call *call;
+  struct rsc_frame_header frame;
+  struct iovec *fv;
+  int nwrite;
+
+  *callp = NULL;
+  if(rsc_proto == RSC_PROTO_V1) {
+    pthread_mutex_lock(&rsc_call_mutex);
+    if(rsc_shm != NULL)
+      nwrite = rsc_ring_writev(rsc_shm, RSC_RING_REQ, rsc_sockfd, v, count, nbytes);
+    else
+      nwrite = writev_n_bytes(rsc_sockfd, v, count, nbytes);
+    if(nwrite == nbytes)
+      *callp = &rsc_v1_call;
+    else
+      pthread_mutex_unlock(&rsc_call_mutex);
+    return nwrite;
+  }
+
+  call = calloc(1, sizeof(struct rscc_call));
+  fv = calloc(count + 1, sizeof(struct iovec));
+  if(call == NULL || fv == NULL) {
+    free(call); free(fv);
+    return -1;
+  }
+  pthread_cond_init(&call->cond, NULL);
+  pthread_mutex_lock(&rsc_call_mutex);
+  if(rsc_conn_lost) {
+    pthread_mutex_unlock(&rsc_call_mutex);
+    pthread_cond_destroy(&call->cond);
+    free(call); free(fv);
+    return -1;
+  }
+  call->id = rsc_next_id++;
+  call->next = rsc_pending;
+  rsc_pending = call;
+  pthread_mutex_unlock(&rsc_call_mutex);
+
+  frame.frame_id = htonl(call->id);
+  frame.frame_size = htonl(nbytes);
+  fv[0].iov_base = &frame;
+  fv[0].iov_len = sizeof(frame);
+  memcpy(fv + 1, v, count * sizeof(struct iovec));
+  /* The frames must not be interleaved */
+  pthread_mutex_lock(&rsc_send_mutex);
+  nwrite = writev_n_bytes(rsc_sockfd, fv, count + 1, sizeof(frame) + nbytes);
+  pthread_mutex_unlock(&rsc_send_mutex);
+  free(fv);
+  if(nwrite != sizeof(frame) + nbytes) {
+    call->done = -1;
+    rscc_call_end(call);
+    return -1;
+  }
+  *callp = call;
+  return nbytes;
+}
+
+/* v2: waits for the response of 'call' */
+static int rscc_call_wait(struct rscc_call *call) {
+  pthread_mutex_lock(&rsc_call_mutex);
+  while(call->done == 0)
+    pthread_cond_wait(&call->cond, &rsc_call_mutex);
+  pthread_mutex_unlock(&rsc_call_mutex);
+  return call->done;
+}
+
+/* Reads the next 'size' bytes of the response of 'call' */
+static int rscc_call_recv(struct rscc_call *call, void *buf, int size) {
+  if(rsc_proto == RSC_PROTO_V1 && rsc_shm != NULL)
+    return rsc_ring_read(rsc_shm, RSC_RING_RESP, rsc_sockfd, buf, size);
+  if(rsc_proto == RSC_PROTO_V1)
+    return read_n_bytes(rsc_sockfd, buf, size);
+  if(rscc_call_wait(call) < 0 || call->direct == -1)
+    return -1;
+  if(size > call->resp_size - call->pos)
+    size = call->resp_size - call->pos;
+  if(call->direct) {
+    if(size > 0 && read_n_bytes(rsc_sockfd, buf, size) != size) {
+      call->direct = -1;
+      return -1;
+    }
+  } else
+    memcpy(buf, call->resp + call->pos, size);
+  call->pos += size;
+  return size;
+}
+
+static int rscc_call_recvv(struct rscc_call *call, struct iovec *v, int count, int nbytes) {
+  int i, n, nread;
+  if(rsc_proto == RSC_PROTO_V1 && rsc_shm != NULL)
+    return rsc_ring_readv(rsc_shm, RSC_RING_RESP, rsc_sockfd, v, count, nbytes);
+  if(rsc_proto == RSC_PROTO_V1)
+    return readv_n_bytes(rsc_sockfd, v, count, nbytes);
+  for(i = 0, nread = 0; i < count; i++) {
+    n = rscc_call_recv(call, v[i].iov_base, v[i].iov_len);
+    if(n < 0)
+      return -1;
+    nread += n;
+    if(n < v[i].iov_len)
+      break;
+  }
+  return nread;
+}
+
+static void rscc_call_end(struct rscc_call *call) {
+  struct rscc_call **pp;
+  if(rsc_proto == RSC_PROTO_V1) {
+    pthread_mutex_unlock(&rsc_call_mutex);
+    return;
+  }
+  if(call->direct) {
+    char buf[4096];
+    int n;
+    /* The rest of the response is not wanted, then the socket
+     * goes back to the receiving thread */
+    while(call->direct == 1 && call->pos < call->resp_size) {
+      n = call->resp_size - call->pos;
+      if(rscc_call_recv(call, buf, n > sizeof(buf) ? sizeof(buf) : n) < 0)
+        break;
+    }
+    pthread_mutex_lock(&rsc_call_mutex);
+    rsc_direct = (call->direct == 1) ? 0 : -1;
+    pthread_cond_signal(&rsc_direct_cond);
+    pthread_mutex_unlock(&rsc_call_mutex);
+  }
+  /* The call is still pending if the send failed */
+  pthread_mutex_lock(&rsc_call_mutex);
+  for(pp = &rsc_pending; *pp != NULL && *pp != call; pp = &((*pp)->next))
+    ;
+  if(*pp != NULL)
+    *pp = call->next;
+  pthread_mutex_unlock(&rsc_call_mutex);
+  pthread_cond_destroy(&call->cond);
+  free(call->resp);
+  free(call);
+}
+
+int rscc_set_proto(int version) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
+  pthread_t recv_thread;
+  int ret;
+
+  /* The rings carry a call at a time */
+  if(version < RSC_PROTO_V2 || rsc_proto == RSC_PROTO_V2 || rsc_shm != NULL)
+    return rsc_proto;
+
+  /* The probe is an ioctl request with a reserved code: a v1 server
+   * answers IOCTL_UNMANAGED. */
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(RSC_PROTO_PROBE);
+  v.iov_base = &req;
+  v.iov_len = sizeof(struct ioctl_req_header);
+  if(rscc_call_send(&call, &v, 1, v.iov_len) != v.iov_len)
+    return -1;
+  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+  if(ret == sizeof(struct ioctl_resp_header) &&
+      ntohl(resp.resp_size_type) == RSC_PROTO_V2) {
+    /* From now on the server speaks v2 */
+    if(pthread_create(&recv_thread, NULL, rscc_recv_loop, NULL) != 0)
+      ret = -1;
+    else {
+      pthread_detach(recv_thread);
+      rsc_proto = RSC_PROTO_V2;
+    }
+  }
+  pthread_mutex_unlock(&rsc_call_mutex);
+  if(ret != sizeof(struct ioctl_resp_header))
+    return -1;
+  RSC_DEBUG(RSCD_MINIMAL, "RSC protocol version %d", rsc_proto);
+  return rsc_proto;
+}
+
+int rscc_probe(u_int32_t probe) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
+  int ret;
+
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(probe);
+  v.iov_base = &req;
+  v.iov_len = sizeof(struct ioctl_req_header);
+  if(rscc_call_send(&call, &v, 1, v.iov_len) != v.iov_len)
+    return -1;
+  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+  rscc_call_end(call);
+  if(ret != sizeof(struct ioctl_resp_header))
+    return -1;
+  return ntohl(resp.resp_size_type);
+}
+
+/* On a unix domain socket the server is asked to share a memory region
+ * with me, sending the probe with the fd of the region. Returns -1 if the
+ * connection is lost, 0 with or without the region */
+static int rscc_shm_init(void) {
+  struct ioctl_req_header req;
+  struct ioctl_resp_header resp;
+  struct sockaddr_un addr;
+  socklen_t len = sizeof(addr);
+  struct rsc_shm *shm;
+  int fd, ret;
+
+  if(getsockname(rsc_sockfd, (struct sockaddr *)&addr, &len) == -1 || 
+      addr.sun_family != AF_UNIX)
+    return 0;
+  if((shm = rsc_shm_create(RSC_SHM_RING_SIZE, &fd)) == NULL)
+    return 0;
+  bzero(&req, sizeof(struct ioctl_req_header));
+  req.req_type = RSC_IOCTL_REQ;
+  req.req_size = htonl(sizeof(struct ioctl_req_header));
+  req.req_ioctl_request = htonl(RSC_SHM_PROBE);
+  ret = rsc_shm_send_fd(rsc_sockfd, &req, sizeof(struct ioctl_req_header), fd);
+  close(fd);
+  if(ret != sizeof(struct ioctl_req_header) ||
+      read_n_bytes(rsc_sockfd, &resp, sizeof(struct ioctl_resp_header)) != sizeof(struct ioctl_resp_header)) {
+    rsc_shm_close(shm);
+    return -1;
+  }
+  /* An older server answers IOCTL_UNMANAGED */
+  if(ntohl(resp.resp_size_type) != RSC_SHM_PROBE) {
+    rsc_shm_close(shm);
+    return 0;
+  }
+  rsc_shm = shm;
+  RSC_DEBUG(RSCD_MINIMAL, "Requests through the shared memory");
   return 0;
 }
 
@@ -602,6 +989,7 @@ struct iovec *rscc_manage_<%=syscall.name%>_response(struct sys_resp_header *res
 <% nr_all.each_umview do |syscall| %>
 int rscc_<%= syscall.name %>(<%= syscall.args.join(', ') %>) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -614,7 +1002,7 @@ int rscc_<%= syscall.name %>(<%= syscall.args.join(', ') %>) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -624,9 +1012,10 @@ int rscc_<%= syscall.name %>(<%= syscall.args.join(', ') %>) {
   free(v[0].iov_base); free(v);
 
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
 
@@ -638,14 +1027,17 @@ int rscc_<%= syscall.name %>(<%= syscall.args.join(', ') %>) {
   v = rscc_manage_<%=syscall.name%>_response(&resp_header, &iovec_count, &nbytes, <%=syscall.args.collect{|a| a.name}.join(', ')%>);
   if(v != NULL) {
     /* I read the buffers (if they aren't NULL)...*/
-	  nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+	  nread = rscc_call_recvv(call, v, iovec_count, nbytes);
 	  if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
@@ -870,6 +1262,7 @@ struct iovec *rscc_manage_ioctl_response(struct sys_resp_header *resp_header, in
 
 int rscc_ioctl(int d, int request, void *arg) {
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -891,7 +1284,7 @@ int rscc_ioctl(int d, int request, void *arg) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -900,22 +1293,27 @@ int rscc_ioctl(int d, int request, void *arg) {
   }
   free(v[0].iov_base); free(v);
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
   
   /* I read the additional data, if there is. */
   v = rscc_manage_ioctl_response(&resp_header, &iovec_count, &nbytes, size_type, arg);
   if(v != NULL) {
-    nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+    nread = rscc_call_recvv(call, v, iovec_count, nbytes);
     if(nread != nbytes) {
       fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
+      free(v);
+      rscc_call_end(call);
       return -1;
     }
+    free(v);
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
@@ -986,11 +1384,15 @@ u_int32_t ioctl_cache_search(struct ioctl_cache *cache, int request) {
 u_int32_t rscc_check_ioctl_request(int request) {
   struct ioctl_req_header req;
   struct ioctl_resp_header resp;
+  struct iovec v;
+  struct rscc_call *call;
   int ret;
   u_int32_t size_type;
 
   /* I control if the request is in the cache */
+  pthread_mutex_lock(&ioctl_cache_mutex);
   size_type = ioctl_cache_search(ioctl_cache, request);
+  pthread_mutex_unlock(&ioctl_cache_mutex);
   if(size_type == 0) {
 	  /* otherwise I call the server */
 	  bzero(&req, sizeof(struct ioctl_req_header));
@@ -999,18 +1401,23 @@ u_int32_t rscc_check_ioctl_request(int request) {
 	  req.req_ioctl_request = htonl(request);
 	
 	  /* I send the request */
-	  ret = write_n_bytes(rsc_sockfd, &req, sizeof(struct ioctl_req_header));
+	  v.iov_base = &req;
+	  v.iov_len = sizeof(struct ioctl_req_header);
+	  ret = rscc_call_send(&call, &v, 1, sizeof(struct ioctl_req_header));
 	  if(ret != sizeof(struct ioctl_req_header))
 	    return 0;
 	
 	  /* I wait the answer */
-	  ret = read_n_bytes(rsc_sockfd, &resp, sizeof(struct ioctl_resp_header));
+	  ret = rscc_call_recv(call, &resp, sizeof(struct ioctl_resp_header));
+	  rscc_call_end(call);
 	  if(ret != sizeof(struct ioctl_resp_header))
 	    return 0;
 	  resp.resp_size = ntohl(resp.resp_size);
 	  resp.resp_size_type = ntohl(resp.resp_size_type);
 	  /* I add it to the cache */
+	  pthread_mutex_lock(&ioctl_cache_mutex);
 	  ioctl_cache_add(ioctl_cache, request, resp.resp_size_type);
+	  pthread_mutex_unlock(&ioctl_cache_mutex);
 
     size_type = resp.resp_size_type;
   }
@@ -1190,6 +1597,7 @@ struct iovec *rscc_manage_fcntl_response(struct sys_resp_header *resp_header, in
 int rscc_fcntl(int fd, int cmd, ...) {
   va_list ap;
   struct sys_resp_header resp_header;
+  struct rscc_call *call;
   int nwrite, nread;
   int nbytes;
   struct iovec *v;
@@ -1214,7 +1622,7 @@ int rscc_fcntl(int fd, int cmd, ...) {
   }
     
   /* I send the request ...*/
-  nwrite = writev_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+  nwrite = rscc_call_send(&call, v, iovec_count, nbytes);
   if(nwrite != nbytes) {
     fprintf(stderr, "I've sent only %d/%d bytes.\n", nwrite, nbytes);
     /* I free the request and the iovec structure */
@@ -1223,23 +1631,208 @@ int rscc_fcntl(int fd, int cmd, ...) {
   }
   free(v[0].iov_base); free(v);
   /* ... and I wait the answer */
-  nread = read_n_bytes(rsc_sockfd, &resp_header, sizeof(struct sys_resp_header));
+  nread = rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header));
   if(nread != sizeof(struct sys_resp_header)) {
     fprintf(stderr, "I've ent only %d/%d bytes.\n", nread, sizeof(struct sys_resp_header));
+    rscc_call_end(call);
     return -1;
   }
   /* I read the additional data, if there is. */
   v = rscc_manage_fcntl_response(&resp_header, &iovec_count, &nbytes, cmd_type, third_arg);
   if(v != NULL) {
-    nread = readv_n_bytes(rsc_sockfd, v, iovec_count, nbytes);
+    nread = rscc_call_recvv(call, v, iovec_count, nbytes);
     if(nread != nbytes) {
 	    fprintf(stderr, "I've read only %d/%d bytes.\n", nread, nbytes);
 	    free(v);
+	    rscc_call_end(call);
 	    return -1;
 	  }
+	  free(v);
 
   }
 
+  rscc_call_end(call);
   errno = resp_header.resp_errno;
   return resp_header.resp_retval;
 }
+
+/*########################################################################*/
+/*##                                                                    ##*/
+/*##  COMPOUND REQUESTS                                                 ##*/
+/*##                                                                    ##*/
+/*########################################################################*/
+static pthread_once_t compound_once = PTHREAD_ONCE_INIT;
+static int compound_max;
+
+static void compound_probe(void) {
+  int ret = rscc_probe(RSC_COMPOUND_PROBE);
+  if(ret <= 0 || ret == IOCTL_UNMANAGED)
+    compound_max = 0;
+  else
+    compound_max = ret < RSC_COMPOUND_MAX ? ret : RSC_COMPOUND_MAX;
+  RSC_DEBUG(RSCD_MINIMAL, "compound requests: max %d calls", compound_max);
+}
+
+int rscc_compound_max(void) {
+  pthread_once(&compound_once, compound_probe);
+  return compound_max;
+}
+
+/* The request of the call 'c' with 'fd' as first argument */
+static struct iovec *compound_create_request(struct rscc_compound_call *c, int fd, int *nbytes, int *count) {
+  switch(c->op) {
+    case RSCC_COMPOUND_OPEN:
+      return rscc_create_open_request(nbytes, count, c->path, c->open_flags);
+    case RSCC_COMPOUND_CLOSE:
+      return rscc_create_close_request(nbytes, count, fd);
+    case RSCC_COMPOUND_FSTAT64:
+      return rscc_create_fstat64_request(nbytes, count, fd, c->buf);
+    case RSCC_COMPOUND_PREAD64:
+      return rscc_create_pread64_request(nbytes, count, fd, c->buf, c->count, c->offset);
+    case RSCC_COMPOUND_GETDENTS64:
+      return rscc_create_getdents64_request(nbytes, count, fd, c->buf, c->count);
+  }
+  return NULL;
+}
+
+static struct iovec *compound_manage_response(struct rscc_compound_call *c, struct sys_resp_header *resp_header, int *nbytes, int *count) {
+  switch(c->op) {
+    case RSCC_COMPOUND_OPEN:
+      return rscc_manage_open_response(resp_header, count, nbytes, c->path, c->open_flags);
+    case RSCC_COMPOUND_CLOSE:
+      return rscc_manage_close_response(resp_header, count, nbytes, c->fd);
+    case RSCC_COMPOUND_FSTAT64:
+      return rscc_manage_fstat64_response(resp_header, count, nbytes, c->fd, c->buf);
+    case RSCC_COMPOUND_PREAD64:
+      return rscc_manage_pread64_response(resp_header, count, nbytes, c->fd, c->buf, c->count, c->offset);
+    case RSCC_COMPOUND_GETDENTS64:
+      return rscc_manage_getdents64_response(resp_header, count, nbytes, c->fd, c->buf, c->count);
+  }
+  return NULL;
+}
+
+/* The server doesn't know the compound requests: the calls are executed
+ * one by one, with the same rules */
+static int compound_one_by_one(struct rscc_compound_call *calls, int ncalls) {
+  struct stat64 st;
+  int i, fd;
+  for(i = 0; i < ncalls; i++) {
+    struct rscc_compound_call *c = &calls[i];
+    fd = c->fd;
+    if(c->chain != RSC_COMPOUND_NOCHAIN) {
+      fd = calls[c->chain].retval;
+      if(fd < 0 || ((c->flags & RSC_COMPOUND_IFREG) &&
+            (rscc_fstat64(fd, &st) < 0 || !S_ISREG(st.st_mode)))) {
+        c->retval = -1;
+        c->err = ECANCELED;
+        continue;
+      }
+    }
+    switch(c->op) {
+      case RSCC_COMPOUND_OPEN:
+        c->retval = rscc_open(c->path, c->open_flags); break;
+      case RSCC_COMPOUND_CLOSE:
+        c->retval = rscc_close(fd); break;
+      case RSCC_COMPOUND_FSTAT64:
+        c->retval = rscc_fstat64(fd, c->buf); break;
+      case RSCC_COMPOUND_PREAD64:
+        c->retval = rscc_pread64(fd, c->buf, c->count, c->offset); break;
+      case RSCC_COMPOUND_GETDENTS64:
+        c->retval = rscc_getdents64(fd, c->buf, c->count); break;
+    }
+    c->err = errno;
+  }
+  return 0;
+}
+
+int rscc_compound(struct rscc_compound_call *calls, int ncalls) {
+  struct compound_req_header req;
+  struct compound_resp_header resp;
+  struct compound_item items[RSC_COMPOUND_MAX];
+  struct iovec *reqs[RSC_COMPOUND_MAX], *v;
+  int counts[RSC_COMPOUND_MAX];
+  struct rscc_call *call;
+  int i, n, nbytes, iovec_count, size, ret = -1;
+
+  if(ncalls <= 0 || ncalls > RSC_COMPOUND_MAX) {
+    errno = EINVAL;
+    return -1;
+  }
+  for(i = 0; i < ncalls; i++)
+    if(calls[i].chain != RSC_COMPOUND_NOCHAIN && (calls[i].chain < 0 || calls[i].chain >= i)) {
+      errno = EINVAL;
+      return -1;
+    }
+  if(ncalls > rscc_compound_max())
+    return compound_one_by_one(calls, ncalls);
+
+  /* I build the request: the header, then an item and a syscall
+   * request for each call. The chained fds are set by the server. */
+  size = sizeof(struct compound_req_header);
+  iovec_count = 1;
+  for(n = 0; n < ncalls; n++) {
+    struct rscc_compound_call *c = &calls[n];
+    reqs[n] = compound_create_request(c, c->chain != RSC_COMPOUND_NOCHAIN ? -1 : c->fd, &nbytes, &counts[n]);
+    if(reqs[n] == NULL)
+      goto free_reqs;
+    items[n].chain = c->chain;
+    items[n].flags = c->flags;
+    size += sizeof(struct compound_item) + nbytes;
+    iovec_count += 1 + counts[n];
+  }
+  if((v = calloc(iovec_count, sizeof(struct iovec))) == NULL)
+    goto free_reqs;
+  bzero(&req, sizeof(struct compound_req_header));
+  req.req_type = RSC_COMPOUND_REQ;
+  req.req_size = htonl(size);
+  req.req_count = ncalls;
+  v[0].iov_base = &req;
+  v[0].iov_len = sizeof(struct compound_req_header);
+  for(i = 0, iovec_count = 1; i < ncalls; i++) {
+    v[iovec_count].iov_base = &items[i];
+    v[iovec_count].iov_len = sizeof(struct compound_item);
+    memcpy(&v[iovec_count + 1], reqs[i], counts[i] * sizeof(struct iovec));
+    iovec_count += 1 + counts[i];
+  }
+  RSC_DEBUG(RSCD_REQ_RESP, "==> COMPOUND REQUEST: %d calls, %d bytes", ncalls, size);
+  nbytes = rscc_call_send(&call, v, iovec_count, size);
+  free(v);
+  if(nbytes != size) {
+    fprintf(stderr, "I've sent only %d/%d bytes.\n", nbytes, size);
+    goto free_reqs;
+  }
+
+  /* ... and I read the responses, in the same order */
+  if(rscc_call_recv(call, &resp, sizeof(struct compound_resp_header)) != sizeof(struct compound_resp_header) ||
+      resp.resp_type != RSC_COMPOUND_RESP || resp.resp_count != ncalls) {
+    fprintf(stderr, "Bad response to the compound request.\n");
+    rscc_call_end(call);
+    goto free_reqs;
+  }
+  for(i = 0; i < ncalls; i++) {
+    struct sys_resp_header resp_header;
+    if(rscc_call_recv(call, &resp_header, sizeof(struct sys_resp_header)) != sizeof(struct sys_resp_header))
+      break;
+    v = compound_manage_response(&calls[i], &resp_header, &nbytes, &iovec_count);
+    if(v != NULL) {
+      int nread = rscc_call_recvv(call, v, iovec_count, nbytes);
+      free(v);
+      if(nread != nbytes)
+        break;
+    }
+    calls[i].retval = resp_header.resp_retval;
+    calls[i].err = resp_header.resp_errno;
+  }
+  rscc_call_end(call);
+  if(i == ncalls)
+    ret = 0;
+  else
+    fprintf(stderr, "I've read only %d/%d responses.\n", i, ncalls);
+
+free_reqs:
+  for(i = 0; i < n; i++) {
+    free(reqs[i][0].iov_base);
+    free(reqs[i]);
+  }
+  return ret;
+}
@@ -48,7 +48,7 @@
 
 #ifdef RSCDEBUG
 #include "rsc_messages.h"
-struct ioctl_resp_header *rscs_manage_ioctl_request(struct ioctl_req_header *ioctl_req);
+struct iovec *rscs_manage_ioctl_request(struct ioctl_req_header *ioctl_req);
 
 <%  nr_all.each_umview do |syscall| 
       if(syscall.has_read_args?)  %>
@@ -64,7 +64,7 @@ void <%= syscall.name %>_adjust_write_pointers(struct <%= syscall.name %>_req *<
 <%  nr_all.each_umview do |syscall|  %>
 struct sys_resp_header *rscs_pre_<%= syscall.name %>_exec(void *req, enum arch client_arch);
 int rscs_exec_<%= syscall.name %>(void  *request);
-struct sys_resp_header *rscs_post_<%= syscall.name %>_exec(void *req, struct sys_resp_header *resp, int retval, int errnoval, enum arch client_arch);
+struct iovec *rscs_post_<%= syscall.name %>_exec(void *req, struct sys_resp_header *resp, int retval, int errnoval, enum arch client_arch);
 <%  end %>
 #endif /* RSCDEBUG */
 #endif /* __RSC_SERVER_TESTS_H__ */
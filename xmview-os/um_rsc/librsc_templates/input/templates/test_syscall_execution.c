@@ -150,6 +150,7 @@ void server_test_<%=syscall.name%>(int fd, enum arch server_arch, enum arch clie
   int ret, req_size;
   struct sys_req_header *req_hd;
   struct sys_resp_header *resp_hd;
+  struct iovec *resp_iov;
   struct <%=syscall.name%>_req *input = fill_<%=syscall.name%>_request(<%=syscall.read_args.collect{|a| "FALSE"}.join(', ')%>);
   struct <%=syscall.name%>_req * req;
   req_hd = calloc(1, sizeof(struct sys_req_header));
@@ -199,17 +200,13 @@ void server_test_<%=syscall.name%>(int fd, enum arch server_arch, enum arch clie
 
   /* I call the post-execution function and then I send back the 
    * response. */
-  resp_hd = rscs_post_<%=syscall.name%>_exec(req, resp_hd, ret, errno, client_arch);
-  resp_hd->resp_rsc_const = htons(resp_hd->resp_rsc_const);
-  resp_hd->resp_size = htonl(resp_hd->resp_size);
-  resp_hd->resp_retval = htonl(resp_hd->resp_retval);
-  resp_hd->resp_errno = htonl(resp_hd->resp_errno);
+  resp_iov = rscs_post_<%=syscall.name%>_exec(req, resp_hd, ret, errno, client_arch);
+  assert(resp_iov != NULL);
+  /* The header of the response is already in network byte order */
+  ret = write(fd, resp_iov[0].iov_base, resp_iov[0].iov_len);
+  assert(ret == resp_iov[0].iov_len);
 
-
-  ret = write(fd, resp_hd, ntohl(resp_hd->resp_size));
-  assert(ret == ntohl(resp_hd->resp_size));
-
-  free(req); free(resp_hd); 
+  free(req); free(resp_iov[0].iov_base); free(resp_iov); 
   free_filled_<%=syscall.name%>_request(input, 0);
 <% if @@special_syscall[syscall.rsc] %>
 #endif
@@ -25,10 +25,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <linux/net.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <pthread.h>
@@ -39,6 +41,7 @@
 #include "utils.h"
 
 #include "rsc_client.h"
+#include "rsc_cache.h"
 
 
 #include "handshake.h"
@@ -46,10 +49,17 @@
 #define SERVER_ADDR "127.0.0.1"
 #define SERVER_PORT "8050"
 #define SERVER_PORT_EVENT_SUB "8051"
+#define SERVER_PROTO "2"
+/* The cache is disabled by default */
+#define CACHE_MS "0"
+#define CACHE_DATA (16 * 1024 * 1024)
+/* Bytes read by the opens with the cache, 0 disables the prefetch */
+#define PREFETCH "65536"
 
 static struct service s;
 static int event_sub_fd;
 static struct reg_cbs *reg_cbs;
+static int cache_ms;
 
 static int create_fd(char *server_name, char *port_number) {
   struct addrinfo hint, *res;
@@ -99,20 +109,50 @@ static int create_fd(char *server_name, char *port_number) {
   return fd;
 }
 
-static int init_client(char *server_name, char *port_number, char *event_sub_port_number) {
+/* A server on the same host, listening on the unix socket 'path' */
+static int create_unix_fd(char *path, char *suffix) {
+  struct sockaddr_un addr;
+  int fd;
+
+  GDEBUG(1, "Server socket = %s%s\n", path, suffix);
+  bzero(&addr, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(path) + strlen(suffix) >= sizeof(addr.sun_path)) {
+    GERROR("The path of the socket is too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  strcat(addr.sun_path, suffix);
+  if( (fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 ) {
+    GERROR("Socket() error: %s\n", strerror(errno));
+    return -1;
+  }
+  if( connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ) {
+    GERROR("Connect() error: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int init_client(char *server_name, char *port_number, char *event_sub_port_number, int proto) {
   int fd,  nwrite, nread;
   struct handshake req, resp;
   enum arch my_arch, server_arch;
+  /* An absolute path is the unix socket of a server on the same host:
+   * the requests go through the shared memory */
+  int local = (server_name[0] == '/');
 
   /* I'm connecting to server */
-  fd = create_fd(server_name, port_number);
+  fd = local ? create_unix_fd(server_name, "") : create_fd(server_name, port_number);
   if(fd == -1) {
     GERROR("I cannot connect to the server\n");
     return -1;
   }
 
   /* I'm connecting to server's event subscribe port */
-  event_sub_fd = create_fd(server_name, event_sub_port_number);
+  event_sub_fd = local ? create_unix_fd(server_name, UNIX_EVENT_SUB_SUFFIX) : 
+    create_fd(server_name, event_sub_port_number);
   if(event_sub_fd == -1) {
     GERROR("I cannot connect to the event subscribe service\n");
     return -1;
@@ -147,6 +187,14 @@ static int init_client(char *server_name, char *port_number, char *event_sub_por
     GERROR("I cannot initialize the RSC module.\n");
     return -1;
   }
+
+  /* A v1 server negotiates down. umview calls the module one call at a
+   * time, so there is never more than one request in flight */
+  if((proto = rscc_set_proto(proto)) == -1) {
+    GERROR("I cannot negotiate the protocol version.\n");
+    return -1;
+  }
+  GDEBUG(1, "RSC protocol version %d\n", proto);
   return fd;
   
 }
@@ -187,18 +235,27 @@ void _um_mod_init(char *initargs) {
   char *server_addr;
   char *server_port;
   char *event_sub_server_port;
+  char *proto;
+  char *cache;
+  char *prefetch;
   int opt_len;
   int ret;
   struct rsc_option opt[] = {
     {"sa", 1, &server_addr},
     {"sp", 1, &server_port},
-    {"essp", 1, &event_sub_server_port}
+    {"essp", 1, &event_sub_server_port},
+    {"proto", 1, &proto},
+    {"cache", 1, &cache},
+    {"prefetch", 1, &prefetch}
   };
   
   /* Parsing of the initialization arguments */
   server_addr = SERVER_ADDR;
   server_port = SERVER_PORT;
   event_sub_server_port = SERVER_PORT_EVENT_SUB;
+  proto = SERVER_PROTO;
+  cache = CACHE_MS;
+  prefetch = PREFETCH;
 
   opt_len = sizeof(opt) / sizeof(struct rsc_option);
   if( (ret = rsc_parse_opt(initargs, opt, opt_len)) != 0 ) {
@@ -208,7 +265,7 @@ void _um_mod_init(char *initargs) {
   }
   
   /* Connection to the server */
-  if( init_client(server_addr, server_port, event_sub_server_port) < 0) {
+  if( init_client(server_addr, server_port, event_sub_server_port, atoi(proto)) < 0) {
     GERROR("Connect_to_server() error\n");
     return;
   }
@@ -312,6 +369,63 @@ void _um_mod_init(char *initargs) {
   SERVICESOCKET(s, send, rscc_send);
 #endif
 
+  /* The calls answered by the cache replace the plain ones. The hypervisor
+   * gives readv and writev to read and write, fstat and fstat64 to lstat64
+   * on the path of the fd and fchmod to chmod (see scunify[] in
+   * xmview/services.c): they use or invalidate the cache through them */
+  if((cache_ms = atoi(cache)) > 0) {
+    if((cache_ms = rscc_cache_init(event_sub_fd, cache_ms, CACHE_DATA)) == -1)
+      GERROR("I cannot enable the cache\n");
+    else {
+      SERVICESYSCALL(s, fcntl, rscc_cache_fcntl);
+      SERVICESYSCALL(s, fcntl64, rscc_cache_fcntl);
+      SERVICESYSCALL(s, access, rscc_cache_access);
+      SERVICESYSCALL(s, chmod, rscc_cache_chmod);
+      SERVICESYSCALL(s, chown, rscc_cache_chown);
+      SERVICESYSCALL(s, close, rscc_cache_close);
+      SERVICESYSCALL(s, dup, rscc_cache_dup);
+      SERVICESYSCALL(s, dup2, rscc_cache_dup2);
+      SERVICESYSCALL(s, fchown, rscc_cache_fchown);
+      SERVICESYSCALL(s, getdents64, rscc_cache_getdents64);
+      SERVICESYSCALL(s, lchown, rscc_cache_lchown);
+      SERVICESYSCALL(s, link, rscc_cache_link);
+      SERVICESYSCALL(s, lseek, rscc_cache_lseek);
+      SERVICESYSCALL(s, lstat64, rscc_cache_lstat64);
+      SERVICESYSCALL(s, mkdir, rscc_cache_mkdir);
+      SERVICESYSCALL(s, open, rscc_cache_open);
+      SERVICESYSCALL(s, pread64, rscc_cache_pread64);
+      SERVICESYSCALL(s, pwrite64, rscc_cache_pwrite64);
+      SERVICESYSCALL(s, read, rscc_cache_read);
+      SERVICESYSCALL(s, readlink, rscc_cache_readlink);
+      SERVICESYSCALL(s, rename, rscc_cache_rename);
+      SERVICESYSCALL(s, rmdir, rscc_cache_rmdir);
+      SERVICESYSCALL(s, stat64, rscc_cache_stat64);
+      SERVICESYSCALL(s, symlink, rscc_cache_symlink);
+      SERVICESYSCALL(s, unlink, rscc_cache_unlink);
+      SERVICESYSCALL(s, utime, rscc_cache_utime);
+      SERVICESYSCALL(s, utimes, rscc_cache_utimes);
+      SERVICESYSCALL(s, write, rscc_cache_write);
+#if defined __x86_64__
+      SERVICESYSCALL(s, ftruncate, rscc_cache_ftruncate64);
+      SERVICESYSCALL(s, truncate, rscc_cache_truncate64);
+#else
+      SERVICESYSCALL(s, ftruncate64, rscc_cache_ftruncate64);
+      SERVICESYSCALL(s, truncate64, rscc_cache_truncate64);
+      SERVICESYSCALL(s, _llseek, rscc_cache__llseek);
+#endif
+#if !defined __x86_64__ && !defined __powerpc__
+      SERVICESYSCALL(s, chown32, rscc_cache_chown32);
+      SERVICESYSCALL(s, lchown32, rscc_cache_lchown32);
+      SERVICESYSCALL(s, fchown32, rscc_cache_fchown32);
+#endif
+      GDEBUG(1, "Cache enabled, lease %d ms\n", cache_ms);
+      /* An old server cannot execute the open, the fstat and the reads
+       * with a single request */
+      if(atoi(prefetch) > 0 && rscc_cache_prefetch(atoi(prefetch)) == -1)
+        GDEBUG(1, "No prefetch: the server doesn't know the compound requests\n");
+    }
+  }
+
 	add_service(&s);
 }
 
@@ -327,4 +441,27 @@ __attribute__ ((destructor))
 fini (void)
 {
   GDEBUG(1, "RSC Fini\n");
+  if(cache_ms > 0) {
+    struct rscc_cache_stats st;
+    unsigned long hits = 0, misses = 0;
+    int i;
+    rscc_cache_flush();
+    /* Every hit is a request not sent to the server */
+    rscc_cache_get_stats(&st);
+    for(i = 0; i < RSCC_CACHE_NOPS; i++) {
+      hits += st.hits[i];
+      misses += st.misses[i];
+    }
+    GMESSAGE("RSC cache: %lu round trips saved, %lu misses, %lu opens with prefetch, "
+        "%lu invalidations received, %lu evictions", hits, misses,
+        st.prefetches, st.pushed, st.evictions);
+    GDEBUG(1, "RSC cache: stat %lu/%lu, lstat %lu/%lu, access %lu/%lu, readlink %lu/%lu, "
+        "getdents %lu/%lu, read %lu/%lu (hits/misses)\n",
+        st.hits[RSCC_CACHE_STAT], st.misses[RSCC_CACHE_STAT],
+        st.hits[RSCC_CACHE_LSTAT], st.misses[RSCC_CACHE_LSTAT],
+        st.hits[RSCC_CACHE_ACCESS], st.misses[RSCC_CACHE_ACCESS],
+        st.hits[RSCC_CACHE_READLINK], st.misses[RSCC_CACHE_READLINK],
+        st.hits[RSCC_CACHE_GETDENTS], st.misses[RSCC_CACHE_GETDENTS],
+        st.hits[RSCC_CACHE_READ], st.misses[RSCC_CACHE_READ]);
+  }
 }
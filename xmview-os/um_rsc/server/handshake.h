@@ -30,4 +30,8 @@ struct handshake {
   enum arch arch;
 };
 
+/* A server listening on the unix socket PATH waits for the event
+ * subscription connections on PATH.es */
+#define UNIX_EVENT_SUB_SUFFIX ".es"
+
 #endif /* __HANDSHAKE_HEADER__ */
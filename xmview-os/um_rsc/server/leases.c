@@ -0,0 +1,337 @@
+/*
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   leases.c: changes of the paths cached by the clients
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/inotify.h>
+#define __USE_LARGEFILE64
+#include <sys/stat.h>
+#include "gdebug.h"
+
+#include "rsc_server.h"
+#include "leases.h"
+
+#define WATCH_HASH_SIZE 1024
+/* Beyond this number the changes are found out by the clients when
+ * their leases expire */
+#define MAX_WATCHES 8192
+#define WATCH_MASK (IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE | \
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+#define NAMESPACE_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+
+/* Two paths can have the same watch descriptor (e.g. a path and a symlink
+ * to it), so there is an entry for each path */
+struct watch {
+  int wd;
+  char *path;
+  /* The end of the last lease depending on the watch */
+  long long expire;
+  struct watch *pnext;
+  struct watch *wnext;
+};
+
+static pthread_mutex_t leases_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int inotify_fd = -1;
+static int lease;
+static struct watch *by_path[WATCH_HASH_SIZE];
+static struct watch *by_wd[WATCH_HASH_SIZE];
+static int nwatches;
+static long long next_sweep;
+
+static long long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static unsigned int path_hash(char *path) {
+  unsigned int h = 5381;
+  while(*path)
+    h = h * 33 + (unsigned char)*path++;
+  return h % WATCH_HASH_SIZE;
+}
+
+static struct watch *watch_lookup(char *path) {
+  struct watch *w;
+  for(w = by_path[path_hash(path)]; w != NULL; w = w->pnext)
+    if(strcmp(w->path, path) == 0)
+      return w;
+  return NULL;
+}
+
+/* Removes the entry, and the inotify watch if nobody else uses it */
+static void watch_del(struct watch *w, int rm) {
+  struct watch **pw, *o;
+  int shared = 0;
+  for(pw = &by_path[path_hash(w->path)]; *pw != w; pw = &(*pw)->pnext)
+    ;
+  *pw = w->pnext;
+  for(pw = &by_wd[w->wd % WATCH_HASH_SIZE]; *pw != w; pw = &(*pw)->wnext)
+    ;
+  *pw = w->wnext;
+  for(o = by_wd[w->wd % WATCH_HASH_SIZE]; o != NULL; o = o->wnext)
+    if(o->wd == w->wd)
+      shared = 1;
+  if(rm && !shared)
+    inotify_rm_watch(inotify_fd, w->wd);
+  GDEBUG(2, "lease watch removed: %s (%d)\n", w->path, w->wd);
+  free(w->path);
+  free(w);
+  nwatches--;
+}
+
+/* The watches of the expired leases are useless */
+static void watch_sweep(long long now) {
+  int i;
+  for(i = 0; i < WATCH_HASH_SIZE; i++) {
+    struct watch *w, *next;
+    for(w = by_path[i]; w != NULL; w = next) {
+      next = w->pnext;
+      if(w->expire < now)
+        watch_del(w, 1);
+    }
+  }
+  next_sweep = now + lease;
+}
+
+/* Watches 'path', or its first existing ancestor: the creation of the
+ * missing component is a change too. 'path' is modified. */
+static void watch_add(char *path) {
+  long long now = now_ms();
+  struct watch *w;
+  char *slash;
+  int wd;
+
+  pthread_mutex_lock(&leases_mutex);
+  if(now >= next_sweep)
+    watch_sweep(now);
+  while(1) {
+    if((w = watch_lookup(path)) != NULL) {
+      w->expire = now + lease;
+      break;
+    }
+    if(nwatches >= MAX_WATCHES)
+      break;
+    if((wd = inotify_add_watch(inotify_fd, path, WATCH_MASK)) >= 0) {
+      if((w = calloc(1, sizeof(struct watch))) != NULL &&
+          (w->path = strdup(path)) != NULL) {
+        w->wd = wd;
+        w->expire = now + lease;
+        w->pnext = by_path[path_hash(path)];
+        by_path[path_hash(path)] = w;
+        w->wnext = by_wd[wd % WATCH_HASH_SIZE];
+        by_wd[wd % WATCH_HASH_SIZE] = w;
+        nwatches++;
+        GDEBUG(2, "lease watch added: %s (%d)\n", path, wd);
+      } else
+        free(w);
+      break;
+    }
+    if(errno != ENOENT || (slash = strrchr(path, '/')) == NULL || path[1] == '\0')
+      break;
+    if(slash == path)
+      slash++;
+    *slash = '\0';
+  }
+  pthread_mutex_unlock(&leases_mutex);
+}
+
+int leases_init(int lease_ms) {
+  lease = lease_ms;
+  next_sweep = now_ms() + lease;
+  inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  return inotify_fd;
+}
+
+/* The absolute path following a request, NULL if there is none: the
+ * relative paths depend on the cwd of the client and are not cached */
+static char *req_path(void *request, int off) {
+  int size = ntohl(((struct sys_req_header *)request)->req_size);
+  char *p = (char *)request + off;
+  if(size <= off || memchr(p, '\0', size - off) == NULL || p[0] != '/' ||
+      strlen(p) >= PATH_MAX)
+    return NULL;
+  return p;
+}
+
+/* The changes of a path are reported by its directory, the changes of
+ * the content of a directory ('dir') by the directory itself */
+static void watch_path(char *p, int dir) {
+  char path[PATH_MAX];
+  int n;
+  strcpy(path, p);
+  for(n = strlen(path); n > 1 && path[n - 1] == '/'; n--)
+    path[n - 1] = '\0';
+  if(!dir && (p = strrchr(path, '/')) != NULL && path[1] != '\0')
+    *(p == path ? p + 1 : p) = '\0';
+  watch_add(path);
+}
+
+/* Watches what the answer to a syscall request depends on. The path of
+ * an open request is returned instead: it matters only to the calls of a
+ * compound request using the new fd. */
+static char *watch_request(void *request) {
+  char path[PATH_MAX], fdpath[32];
+  char *p;
+  int fd, dir = 0;
+  ssize_t n;
+
+  /* The request is still in network byte order */
+  switch(ntohs(((struct sys_req_header *)request)->req_rsc_const)) {
+    case __RSC_stat:
+    case __RSC_stat64:
+      p = req_path(request, sizeof(struct stat64_req)); break;
+    case __RSC_lstat:
+    case __RSC_lstat64:
+      p = req_path(request, sizeof(struct lstat64_req)); break;
+    case __RSC_access:
+      p = req_path(request, sizeof(struct access_req)); break;
+    case __RSC_readlink:
+      p = req_path(request, sizeof(struct readlink_req)); break;
+    case __RSC_open:
+      return req_path(request, sizeof(struct open_req));
+    case __RSC_getdents64:
+      dir = 1;
+      /* Fall through */
+    case __RSC_pread64:
+      /* The fd is the first argument of both */
+      memcpy(&fd, (char *)request + sizeof(struct sys_req_header), sizeof(int));
+      snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", fd);
+      if((n = readlink(fdpath, path, sizeof(path) - 1)) <= 0 || path[0] != '/')
+        return NULL;
+      path[n] = '\0';
+      p = path;
+      break;
+    default:
+      return NULL;
+  }
+  if(p != NULL)
+    watch_path(p, dir);
+  return NULL;
+}
+
+void leases_watch(void *request) {
+  struct req_header *req_hd = (struct req_header *)request;
+  struct compound_req_header *comp_hd;
+  char *opened[RSC_COMPOUND_MAX];
+  char *p, *end;
+  int i;
+
+  if(inotify_fd == -1)
+    return;
+  if(req_hd->req_type == RSC_SYS_REQ) {
+    watch_request(request);
+    return;
+  }
+  if(req_hd->req_type != RSC_COMPOUND_REQ)
+    return;
+  /* The calls chained to an open depend on its path; the sizes are
+   * checked again when the request is executed */
+  comp_hd = (struct compound_req_header *)request;
+  p = (char *)request + sizeof(struct compound_req_header);
+  end = (char *)request + ntohl(comp_hd->req_size);
+  for(i = 0; i < comp_hd->req_count && i < RSC_COMPOUND_MAX; i++) {
+    struct compound_item *item = (struct compound_item *)p;
+    struct sys_req_header *sys_hd = (struct sys_req_header *)(p + sizeof(struct compound_item));
+    int size;
+    opened[i] = NULL;
+    if(end - p < sizeof(struct compound_item) + sizeof(struct sys_req_header) ||
+        (size = ntohl(sys_hd->req_size)) < sizeof(struct sys_req_header) ||
+        size > end - (char *)sys_hd)
+      return;
+    if(item->chain == RSC_COMPOUND_NOCHAIN) {
+      if((opened[i] = watch_request(sys_hd)) != NULL)
+        watch_path(opened[i], 0);
+    } else if(item->chain < i && opened[item->chain] != NULL &&
+        ntohs(sys_hd->req_rsc_const) == __RSC_getdents64)
+      watch_path(opened[item->chain], 1);
+    p = (char *)sys_hd + size;
+  }
+}
+
+void leases_events(void (*inval)(char *path, int len, int flags)) {
+  char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  char last[PATH_MAX + NAME_MAX + 2], child[PATH_MAX + NAME_MAX + 2];
+  int last_flags = -1;
+  ssize_t n;
+
+/* The consecutive duplicates are sent once */
+#define INVAL(p, f) do { \
+    if(last_flags != (f) || strcmp(last, (p)) != 0) { \
+      snprintf(last, sizeof(last), "%s", (p)); \
+      last_flags = (f); \
+      inval(last, strlen(last), last_flags); \
+    } \
+  } while(0)
+
+  while((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+    char *e;
+    struct inotify_event *ev;
+    for(e = buf; e < buf + n; e += sizeof(struct inotify_event) + ev->len) {
+      char *paths[8];
+      int npaths = 0, i;
+      struct watch *w, *next;
+      ev = (struct inotify_event *)e;
+
+      if(ev->mask & IN_Q_OVERFLOW) {
+        GDEBUG(1, "inotify queue overflow\n");
+        INVAL("/", RSC_INVAL_RECURSIVE);
+        continue;
+      }
+      pthread_mutex_lock(&leases_mutex);
+      for(w = by_wd[ev->wd % WATCH_HASH_SIZE]; w != NULL; w = next) {
+        next = w->wnext;
+        if(w->wd != ev->wd)
+          continue;
+        if(npaths < sizeof(paths) / sizeof(paths[0]) && (paths[npaths] = strdup(w->path)) != NULL)
+          npaths++;
+        /* The watch of a moved directory would report the changes of
+         * its new path: I remove it */
+        if(ev->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+          watch_del(w, (ev->mask & IN_MOVE_SELF) != 0);
+      }
+      pthread_mutex_unlock(&leases_mutex);
+
+      for(i = 0; i < npaths; i++) {
+        char *path = paths[i];
+        if(ev->len > 0) {
+          snprintf(child, sizeof(child), "%s/%s", strcmp(path, "/") == 0 ? "" : path, ev->name);
+          if(ev->mask & NAMESPACE_EVENTS) {
+            INVAL(child, RSC_INVAL_RECURSIVE);
+            INVAL(path, 0);
+          } else
+            /* The permissions of a directory affect the paths below it */
+            INVAL(child, (ev->mask & IN_ISDIR) ? RSC_INVAL_RECURSIVE : 0);
+        } else if(!(ev->mask & IN_IGNORED))
+          INVAL(path, (ev->mask & (IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)) ? RSC_INVAL_RECURSIVE : 0);
+        free(path);
+      }
+    }
+  }
+#undef INVAL
+}
@@ -0,0 +1,39 @@
+/*
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   leases.h: changes of the paths cached by the clients
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef __LEASES_HEADER__
+#define __LEASES_HEADER__
+
+/* A client with the cache keeps the answers for 'lease_ms' milliseconds.
+ * Before an answer is computed, the directory containing its path is
+ * watched with inotify: the changes are sent to the clients, which
+ * forget what they know about the path. A watch lasts as long as the
+ * leases depending on it.
+ * Returns the inotify fd, -1 on error */
+int leases_init(int lease_ms);
+/* Called before the execution of a request of a client with the cache,
+ * the compound requests included */
+void leases_watch(void *request);
+/* Called when the inotify fd is readable: 'inval' is called for each
+ * changed path, 'flags' as in rsc_es_inval */
+void leases_events(void (*inval)(char *path, int len, int flags));
+
+#endif /* __LEASES_HEADER__ */
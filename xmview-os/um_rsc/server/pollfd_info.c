@@ -23,10 +23,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <assert.h>
-#include <sys/poll.h>
+#include <string.h>
+#include <unistd.h>
 #include "pollfd_info.h"
 #include "aconv.h"
+#include "rsc_messages.h"
+#include "zerocopy.h"
 
 
 /**************************************************************/
@@ -84,11 +86,13 @@ void *buff_deq(struct buffer *b) {
   return data;
 }
 static void free_msg(struct msg *m) {
+  if(m->pipe != NULL)
+    zc_pipe_free(m->pipe);
   free(m->data);
   free(m);
 }
 /* Free client c and all the messages into the 2 buffers */
-static void free_client(struct client *c){
+void free_client(struct client *c){
   struct msg *m, *next;
   if(c->rbuf != NULL) {
     m = c->rbuf->first;
@@ -108,6 +112,10 @@ static void free_client(struct client *c){
   }
   free(c->rbuf);
   free(c->wbuf);
+  if(c->shm_fd != -1)
+    close(c->shm_fd);
+  if(c->shm != NULL)
+    rsc_shm_close(c->shm);
 
   free(c);
 }
@@ -133,99 +141,66 @@ struct client *create_client(int fd, enum client_type type, enum client_state st
   client->type = type;
   client->arch = ACONV_ARCH_ERROR;
   client->state = state;
+  client->proto = RSC_PROTO_V1;
+  client->shm_fd = -1;
 
   return client;
 }
 /**************************************************************/
-/* Pollfd management                                          */
+/* File descriptor registry                                   */
 /**************************************************************/
 
-static void init_empty_entry(struct pollfd_info *p, int i) {
-  p->pollfd[i].fd     = -1; 
-  p->pollfd[i].events  = 0; 
-  p->pollfd[i].revents = 0; 
-  p->clients[i] = NULL;
-}
-
-struct pollfd_info *pollfd_init() {
-  int i;
-  struct pollfd_info *p;
-  p = calloc(1, sizeof(struct pollfd_info));
-  if(p == NULL) 
+struct fd_registry *fdreg_init() {
+  struct fd_registry *r;
+  r = calloc(1, sizeof(struct fd_registry));
+  if(r == NULL) 
     return NULL;
-  p->pollfd = calloc(POLLFD_INITIAL_SIZE, sizeof(struct pollfd));
-  if(p->pollfd == NULL) {
-    free(p);
-    return NULL;
-  }
-  p->clients = calloc(POLLFD_INITIAL_SIZE, sizeof(struct client *));
-  if(p->pollfd == NULL) {
-    free(p->pollfd); free(p);
+  r->clients = calloc(FDREG_INITIAL_SIZE, sizeof(struct client *));
+  if(r->clients == NULL) {
+    free(r);
     return NULL;
   }
-  
-  p->nfds = 0;
-  p->size = POLLFD_INITIAL_SIZE;
-  for(i = 0; i < p->size; i++) {
-    init_empty_entry(p, i);
-  }
+  r->size = FDREG_INITIAL_SIZE;
 
-  return p;
+  return r;
 }
 
-void pollfd_add(struct pollfd_info *p, int fd, short events, struct client *c) {
-  int empty_i = -1;
+/* Insert c as the client of fd, replacing the previous one */
+int fdreg_add(struct fd_registry *r, int fd, struct client *c) {
+  if(fd < 0)
+    return -1;
   /* I have to enlarge the array */
-  if(p->nfds >= p->size) {
-    int i;
-    p->size += POLLFD_INITIAL_SIZE;
-    p->pollfd  = realloc(p->pollfd,  p->size * sizeof(struct pollfd));
-    p->clients = realloc(p->clients, p->size * sizeof(struct client *));
-    assert(p->pollfd != NULL && p->clients != NULL);
+  if(fd >= r->size) {
+    struct client **clients;
+    int size = r->size;
+    while(size <= fd)
+      size *= 2;
+    clients = realloc(r->clients, size * sizeof(struct client *));
+    if(clients == NULL)
+      return -1;
     /* I init the new entries created */
-    for(i = p->nfds; i < p->size; i++) {
-      init_empty_entry(p, i);
-    }
-    empty_i = p->nfds;
-  } else {
-    int i;
-    for(i = 0; i < p->size; i++)
-      if(p->pollfd[i].fd == -1) {
-        empty_i = i;
-        break;
-      }
+    memset(clients + r->size, 0, (size - r->size) * sizeof(struct client *));
+    r->clients = clients;
+    r->size = size;
   }
- 
- p->pollfd[empty_i].fd       = fd;
- p->pollfd[empty_i].events   = events;
- p->pollfd[empty_i].revents  = 0;
- p->clients[empty_i]         = c;
-
- p->nfds += 1;
+  r->clients[fd] = c;
+  return 0;
 }
 
-void pollfd_del(struct pollfd_info *p, int i) {
-  if(i < 0 || i >= p->size)
-    return;
-  free_client(p->clients[i]);
-  init_empty_entry(p, i);
-  p->nfds -= 1;
+struct client *fdreg_get(struct fd_registry *r, int fd) {
+  if(fd < 0 || fd >= r->size)
+    return NULL;
+  return r->clients[fd];
 }
 
-void pollfd_compact(struct pollfd_info *p) {
-  int i, j;
-  for(i = 0, j = 0; i < p->size; i++) {
-    if(p->pollfd[i].fd == -1) {
-      continue;
-    } else {
-      if(j < i) {
-        p->pollfd[j] = p->pollfd[i];
-        p->clients[j] = p->clients[i];
-        init_empty_entry(p, i);
-      }
-      j++;
-    }
-  }
+/* Remove the client of fd and return it, the caller frees it */
+struct client *fdreg_del(struct fd_registry *r, int fd) {
+  struct client *c;
+  if(fd < 0 || fd >= r->size)
+    return NULL;
+  c = r->clients[fd];
+  r->clients[fd] = NULL;
+  return c;
 }
 
 #ifdef GDEBUG_ENABLED
@@ -267,23 +242,26 @@ static void print_client(struct client *client) {
         print_buffer(client->wbuf, "Write buffer");
         break;
       default:
-        fprintf(stderr, "DATA_FD = '%d'; TYPE = '%s'; EVENT SUB FD INDEX = %d", 
-            client->fd, client_type_2_str(client->type), client->esfd_index);
+        fprintf(stderr, "DATA_FD = '%d'; TYPE = '%s'; EVENT SUB FD = %d; HOW = %hX%s", 
+            client->fd, client_type_2_str(client->type), client->esc->fd, client->how,
+            client->fired ? " (fired)" : "");
+        if(client->next != NULL) {
+          fprintf(stderr, "\n\t   ");
+          print_client(client->next);
+        }
         break;
     }
   }
 }
 
-void print_pollfd_info(struct pollfd_info *p) {
+void print_fd_registry(struct fd_registry *r) {
   int i;
-  fprintf(stderr, "Pollfd info: nfds = %d, size = %d:\n", p->nfds, p->size);
-  for(i = 0; i < p->size; i++) {
-    fprintf(stderr, "\t%d", i);
-    if(p->pollfd[i].fd != -1)
-      fprintf(stderr, ". (FD = %.2d, E = %hX): ", p->pollfd[i].fd, p->pollfd[i].events);
-    else
-      fprintf(stderr, ". ");
-    print_client(p->clients[i]);
+  fprintf(stderr, "Fd registry: size = %d:\n", r->size);
+  for(i = 0; i < r->size; i++) {
+    if(r->clients[i] == NULL)
+      continue;
+    fprintf(stderr, "\t%.2d (E = %X): ", i, r->clients[i]->events);
+    print_client(r->clients[i]);
     fprintf(stderr, "\n");
   }
 }
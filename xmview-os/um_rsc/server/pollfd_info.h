@@ -23,8 +23,9 @@
 
 #ifndef __POLLFD_INFO_HEADER__
 #define __POLLFD_INFO_HEADER__
-#include <sys/poll.h>
+#include <sys/types.h>
 #include "aconv.h"
+#include "rsc_shm.h"
 
 enum client_state {
   WAITING_ARCH = 1,
@@ -48,6 +49,7 @@ struct msg {
   void *data;    /* the pointer to data */
   unsigned int n; /* number of byte of data into the buffer */
   unsigned int tot; /* total number of bytes to read/write */
+  struct zc_pipe *pipe; /* if not NULL the data is in this pipe */
   struct msg *next;
 };
 
@@ -58,35 +60,63 @@ struct client {
   enum client_state state;
   struct buffer *rbuf; /* reading buffer */
   struct buffer *wbuf; /* writing buffer */
-  int esfd_index;
+  int proto; /* RSC_PROTO_V1 or RSC_PROTO_V2 (REQ_RESP only) */
+  u_int32_t events; /* the epoll events registered for fd */
+  /* REQ_RESP: requests given to the workers and not answered yet. 
+   * A closed client is freed when the last one comes back */
+  int inflight;
+  int closed;
+  /* REQ_RESP: the client has a cache and the requests get a lease.
+   * EVENT_SUB: the client receives the invalidations of its cache */
+  int cached;
+  /* REQ_RESP: only the arguments of the request are read, and a worker
+   * reads the payload from fd (see zerocopy.h) */
+  int partial;
+  int splicing;
+  /* REQ_RESP: a request changing the working directory of the server
+   * runs alone, as the relative paths of the other requests depend on
+   * it. 'held' waits for the requests in flight before it, no other
+   * request is read while 'serial' is set */
+  struct job *held;
+  int serial;
+  /* REQ_RESP: a client on a unix socket, and the fd it sent with the data
+   * (-1 if none). 'shm' is the region shared with the client, which takes
+   * the place of the socket when the answer to RSC_SHM_PROBE has been sent */
+  int local;
+  int shm_fd;
+  struct rsc_shm *shm;
+  /* SUBSCRIBED_FD: 'fd' is the monitored fd, 'esc' the event 
+   * subscriber; 'next' links the subscriptions of the same fd */
+  struct client *esc;
+  short how;
+  int fired;
+  struct client *next;
 };
 
 
-#define   POLLFD_INITIAL_SIZE   10
-struct pollfd_info {
-  struct pollfd *pollfd;
-  /* The number of used entries into 'pollfd' and 'clients' */
-  int nfds;
-  /* The size of 'pollfd' and 'clients'*/
-  int size;
-  /* The i-th file descriptor in 'pollfd' belongs to the i-th client 
-   * in 'clients' */
+/* The clients indexed by file descriptor: the server finds the client
+ * of a ready fd in constant time */
+#define   FDREG_INITIAL_SIZE   64
+struct fd_registry {
   struct client **clients;
+  /* The size of 'clients' */
+  int size;
 };
 
-struct pollfd_info *pollfd_init();
-void pollfd_add(struct pollfd_info *p, int fd, short events, struct client *c);
-void pollfd_del(struct pollfd_info *p, int i);
-void pollfd_compact(struct pollfd_info *p);
+struct fd_registry *fdreg_init();
+int fdreg_add(struct fd_registry *r, int fd, struct client *c);
+struct client *fdreg_get(struct fd_registry *r, int fd);
+struct client *fdreg_del(struct fd_registry *r, int fd);
 
 struct msg *buff_enq(struct buffer *b, void *data, int tot);
 void *buff_deq(struct buffer *b);
 struct client *create_client(int fd, enum client_type type, enum client_state state);
+void free_client(struct client *c);
 #ifdef GDEBUG_ENABLED
-# define  PRINT_POLLFDINFO(p)   print_pollfd_info(p)
+# define  PRINT_FDREG(r)   print_fd_registry(r)
 
-void print_pollfd_info(struct pollfd_info *p);
+void print_fd_registry(struct fd_registry *r);
 #else
-# define  PRINT_POLLFDINFO(p)
+# define  PRINT_FDREG(r)
 #endif
 #endif /* __POLLFD_INFO_HEADER__ */
@@ -0,0 +1,270 @@
+/*
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   rsc_bench.c: cost of the remote system calls over TCP and through
+ *                the shared memory, with a server on the same host
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#define __USE_LARGEFILE64
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <netdb.h>
+#include <fcntl.h>
+
+#include "rsc_client.h"
+#include "handshake.h"
+
+#define SERVER_ADDR "127.0.0.1"
+#define SERVER_PORT "8050"
+#define ITERATIONS 100000
+#define SIZE 4096
+
+static char *server_addr = SERVER_ADDR;
+static char *server_port = SERVER_PORT;
+static int iterations = ITERATIONS;
+static int size = SIZE;
+
+int read_n_bytes(int fd, void *buffer, int nbytes);
+int write_n_bytes(int fd, void *buffer, int nbytes);
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int connect_tcp(void) {
+  struct addrinfo hint, *res;
+  int fd, ret;
+
+  bzero(&hint, sizeof(hint));
+  hint.ai_socktype = SOCK_STREAM;
+  if((ret = getaddrinfo(server_addr, server_port, &hint, &res)) != 0) {
+    fprintf(stderr, "getaddrinfo() error: %s\n", gai_strerror(ret));
+    return -1;
+  }
+  if((fd = socket(res->ai_family, res->ai_socktype, 0)) == -1 ||
+      connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    fprintf(stderr, "I cannot connect to %s:%s: %s\n", server_addr, server_port, strerror(errno));
+    freeaddrinfo(res);
+    return -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+static int connect_unix(char *path) {
+  struct sockaddr_un addr;
+  int fd;
+
+  bzero(&addr, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 ||
+      connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "I cannot connect to %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  return fd;
+}
+
+/* The handshake and the initialization of librsc, as done by the module */
+static int init_client(int fd, int proto) {
+  struct handshake hs;
+  enum arch my_arch, server_arch;
+
+  my_arch = aconv_get_host_arch();
+  hs.arch = htonl(my_arch);
+  if(write_n_bytes(fd, &hs, sizeof(hs)) != sizeof(hs) ||
+      read_n_bytes(fd, &hs, sizeof(hs)) != sizeof(hs))
+    return -1;
+  server_arch = ntohl(hs.arch);
+  if(rscc_init(fd, -1, NULL, my_arch, server_arch) == -1)
+    return -1;
+  return rscc_set_proto(proto);
+}
+
+static void report(char *transport, char *op, int n, double t) {
+  printf("%-12s %-22s %8.2f us/call %10.0f calls/s\n", transport, op, t * 1e6 / n, n / t);
+}
+
+/* Executes the calls of the benchmark in the current process, connected
+ * through 'fd' */
+static int bench(char *transport, int fd, int proto, char *path) {
+  struct stat64 st;
+  char *buf, op[64];
+  double t;
+  int i, rfd;
+
+  if(init_client(fd, proto) == -1) {
+    fprintf(stderr, "%s: I cannot initialize the client\n", transport);
+    return -1;
+  }
+  if((buf = malloc(size)) == NULL || (rfd = rscc_open(path, O_RDWR)) == -1) {
+    fprintf(stderr, "%s: I cannot open %s\n", transport, path);
+    return -1;
+  }
+
+  t = now();
+  for(i = 0; i < iterations; i++)
+    if(rscc_lseek(rfd, 0, SEEK_CUR) != 0)
+      break;
+  report(transport, "lseek", i, now() - t);
+
+  t = now();
+  for(i = 0; i < iterations; i++)
+    if(rscc_stat64(path, &st) != 0)
+      break;
+  report(transport, "stat64", i, now() - t);
+
+  snprintf(op, sizeof(op), "pread64 %d bytes", size);
+  t = now();
+  for(i = 0; i < iterations; i++)
+    if(rscc_pread64(rfd, buf, size, 0) != size)
+      break;
+  report(transport, op, i, now() - t);
+
+  snprintf(op, sizeof(op), "pwrite64 %d bytes", size);
+  t = now();
+  for(i = 0; i < iterations; i++)
+    if(rscc_pwrite64(rfd, buf, size, 0) != size)
+      break;
+  report(transport, op, i, now() - t);
+
+  rscc_close(rfd);
+  free(buf);
+  return 0;
+}
+
+/* librsc has a single connection: each transport is measured by a
+ * process of its own */
+static int run(char *transport, char *unix_path, int proto, char *path) {
+  pid_t pid;
+  int fd, status;
+
+  if((pid = fork()) == -1)
+    return -1;
+  if(pid == 0) {
+    fd = (unix_path != NULL) ? connect_unix(unix_path) : connect_tcp();
+    exit(fd == -1 || bench(transport, fd, proto, path) == -1);
+  }
+  if(waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return -1;
+  return 0;
+}
+
+static void usage(char *s, int exit_code) {
+  fprintf(stderr, "Usage: %s [OPTIONS]\n"
+      "Measures the remote system calls to a server on this host, through the\n"
+      "loopback TCP connection and, with '-u', through the shared memory.\n"
+      "OPTIONS are:\n"
+      "\t-h, --help                       print this help message.\n"
+      "\t-a ADDRESS, --address ADDRESS    the address of the server (default %s).\n"
+      "\t-p PORT, --port PORT             the port of the server (default %s).\n"
+      "\t-u PATH, --unix PATH             the unix socket of the server ('-u' option of rsc_server).\n"
+      "\t-n N, --iterations N             calls of each kind (default %d).\n"
+      "\t-s BYTES, --size BYTES           size of the reads and the writes (default %d).\n"
+      "\t-f FILE, --file FILE             the file read and written, it must be\n"
+      "\t                                 at least BYTES long (default a temporary file).\n",
+      basename(s), SERVER_ADDR, SERVER_PORT, ITERATIONS, SIZE);
+  exit(exit_code);
+}
+
+int main(int argc, char *argv[]) {
+  char *unix_path = NULL, *path = NULL, tmp[] = "/tmp/rsc_benchXXXXXX";
+  int c, ret = 0;
+
+  while(1) {
+    int option_index = 0;
+    static struct option long_option[] = {
+      {"address", 1, NULL, 'a'},
+      {"port", 1, NULL, 'p'},
+      {"unix", 1, NULL, 'u'},
+      {"iterations", 1, NULL, 'n'},
+      {"size", 1, NULL, 's'},
+      {"file", 1, NULL, 'f'},
+      {"help", 0, NULL, 'h'},
+      {0, 0, 0, 0}
+    };
+
+    c = getopt_long(argc, argv, "a:p:u:n:s:f:h", long_option, &option_index);
+    if(c == -1) break;
+    switch(c) {
+      case 'h':
+        usage(argv[0], 0);
+        break;
+      case 'a':
+        server_addr = optarg;
+        break;
+      case 'p':
+        server_port = optarg;
+        break;
+      case 'u':
+        unix_path = optarg;
+        break;
+      case 'n':
+        if((iterations = atoi(optarg)) <= 0)
+          usage(argv[0], -1);
+        break;
+      case 's':
+        if((size = atoi(optarg)) <= 0)
+          usage(argv[0], -1);
+        break;
+      case 'f':
+        path = optarg;
+        break;
+      default:
+        usage(argv[0], -1);
+        break;
+    }
+  }
+
+  if(path == NULL) {
+    /* The server is on this host: it sees the same file */
+    char *zeros;
+    int fd;
+    if((fd = mkstemp(tmp)) == -1 || (zeros = calloc(1, size)) == NULL ||
+        write_n_bytes(fd, zeros, size) != size) {
+      fprintf(stderr, "I cannot create the temporary file\n");
+      exit(-1);
+    }
+    free(zeros);
+    close(fd);
+    path = tmp;
+  }
+
+  setvbuf(stdout, NULL, _IONBF, 0);
+  if(run("tcp v1", NULL, RSC_PROTO_V1, path) == -1 ||
+      run("tcp v2", NULL, RSC_PROTO_V2, path) == -1 ||
+      (unix_path != NULL && run("shm", unix_path, RSC_PROTO_V2, path) == -1))
+    ret = -1;
+  if(path == tmp)
+    unlink(tmp);
+  return ret;
+}
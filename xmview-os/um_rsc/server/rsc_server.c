@@ -34,14 +34,22 @@
 #include <libgen.h>
 #include <netdb.h>
 #include <fcntl.h>
-#include <sys/poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include <sys/stat.h>
+#include <sys/un.h>
 #include "gdebug.h"
 
 #include "rsc_server.h"
+#include "rsc_shm.h"
 
 #include "handshake.h"
 #include "pollfd_info.h"
+#include "workers.h"
+#include "leases.h"
+#include "zerocopy.h"
 
 /* For ioctl requests */
 #include <asm/sockios.h>
@@ -60,12 +68,27 @@
 #define SERVER_PORT "8050"
 #define SERVER_PORT_EVENT_SUB "8051"
 #define MAX_CONNECTIONS 5
+/* Threads executing the system calls */
+#define WORKERS 8
+/* Requests of a v2 client executed at the same time: a client
+ * cannot take all the workers */
+#define MAX_INFLIGHT 4
+#define MAX_CLIENTS 256
+/* Validity of the answers cached by the clients (ms) */
+#define LEASE 10000
+#define MAX_EVENTS 64
+#define WRITEV_MAX 16
 
 /*####################################################################*/
 /*# Global Variables                                                 #*/
 /*####################################################################*/
 static enum arch my_arch;
-static struct pollfd_info *pfdinfo;
+static struct fd_registry *fdreg;
+static int epfd;
+static int nclients;
+static int max_inflight = MAX_INFLIGHT;
+static int max_clients = MAX_CLIENTS;
+static int lease_ms = LEASE;
 
 /*####################################################################*/
 /*# Local Functions                                                  #*/
@@ -113,6 +136,10 @@ static void print_addr_port(int fd)
       addr = &(info6.sin6_addr);
       port = &(info6.sin6_port);
     
+    } else if(family == AF_UNIX) {
+      /* A client on the same host */
+      GDEBUG(1, "<unix socket>");
+      return;
     } else {
       /* If the family isn't AF_INET or AF_INET6 I clear the variables,
        * in this way the functions that will use them, will genereate 
@@ -173,6 +200,40 @@ static int create_listening_fd(char *server_addr, char *server_port) {
   return fd;
 }
 
+/* The clients on the same host connect to the unix socket 'path' */
+static int create_unix_listening_fd(char *path) {
+  struct sockaddr_un addr;
+  struct stat st;
+  int fd;
+
+  bzero(&addr, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "The path of the unix socket is too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+    fprintf(stderr, "I cannot create the unix socket: %s\n", strerror(errno));
+    return -1;
+  }
+  /* The socket of a previous execution */
+  if(stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path);
+  if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "I cannot bind the unix socket %s: %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  if(listen(fd, MAX_CONNECTIONS) == -1) {
+    fprintf(stderr, "I cannot accept the connections: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  GDEBUG(1, "Server listening on %s (fd = %d).\n", path, fd);
+  return fd;
+}
+
 static void init_ioctl_register_request(void) {
   /* asm/sockios.h */
   rscs_ioctl_register_request(FIOSETOWN, IOCTL_R, sizeof(const int));
@@ -277,7 +338,7 @@ static int set_non_blocking(int fd) {
 
 
 static int
-init(char *server_addr, char *server_port, char *event_sub_server_port, int *listen_fd, int *event_sub_fd) {
+init(char *server_addr, char *server_port, char *event_sub_server_port, char *unix_path, int nworkers, int *listen_fd, int *event_sub_fd, int *unix_fd, int *unix_es_fd, int *done_fd, int *leases_fd) {
   int ret;
 
   *listen_fd = create_listening_fd(server_addr, server_port);
@@ -296,6 +357,19 @@ init(char *server_addr, char *server_port, char *event_sub_server_port, int *lis
   if(set_non_blocking(*event_sub_fd) == 0)
     return -1;
 
+  *unix_fd = *unix_es_fd = -1;
+  if(unix_path != NULL) {
+    char es_path[sizeof(((struct sockaddr_un *)NULL)->sun_path) + sizeof(UNIX_EVENT_SUB_SUFFIX)];
+    snprintf(es_path, sizeof(es_path), "%s" UNIX_EVENT_SUB_SUFFIX, unix_path);
+    if((*unix_fd = create_unix_listening_fd(unix_path)) == -1 ||
+        (*unix_es_fd = create_unix_listening_fd(es_path)) == -1) {
+      fprintf(stderr, "I cannot create the unix sockets\n");
+      return -1;
+    }
+    if(set_non_blocking(*unix_fd) == 0 || set_non_blocking(*unix_es_fd) == 0)
+      return -1;
+  }
+
   /* I get my architecture */
   if( (my_arch = aconv_get_host_arch()) == ACONV_ARCH_ERROR ) {
     fprintf(stderr, "I cannot get my architecture\n");
@@ -307,363 +381,876 @@ init(char *server_addr, char *server_port, char *event_sub_server_port, int *lis
     fprintf(stderr, "I cannot initialize the RSC module\n");
     return -1;
   }
+  zc_init(my_arch);
   GDEBUG(1, "My architecture is %s\n", aconv_arch2str(my_arch));
   
   /* I set the list of ioctl request I support AFTER the initialization
    * of the rsc_module (otherwise segfault)*/
   init_ioctl_register_request();
   
-  /* I Init the pollfd structure */
-  if((pfdinfo = pollfd_init()) == NULL) {
-    fprintf(stderr, "I cannot init the pollfd structure\n");
+  /* I Init the fd registry and the epoll set */
+  if((fdreg = fdreg_init()) == NULL) {
+    fprintf(stderr, "I cannot init the fd registry\n");
     return -1;
   }
+  if((epfd = epoll_create(MAX_EVENTS)) == -1) {
+    fprintf(stderr, "I cannot create the epoll set: %s\n", strerror(errno));
+    return -1;
+  }
+
+  /* A client closing the connection must not kill the server, and
+   * the system calls writing on a broken pipe get EPIPE */
+  signal(SIGPIPE, SIG_IGN);
+  if((*done_fd = workers_init(nworkers)) == -1) {
+    fprintf(stderr, "I cannot start the worker threads\n");
+    return -1;
+  }
+  /* Without inotify the clients use their own timeouts */
+  *leases_fd = -1;
+  if(lease_ms > 0 && (*leases_fd = leases_init(lease_ms)) == -1) {
+    fprintf(stderr, "I cannot watch the files, no leases: %s\n", strerror(errno));
+    lease_ms = 0;
+  }
   
   return 0;
 }
 
-/* Close the connection of the i-th fd */
-static void close_connection(struct pollfd_info *p, int i) {
-	GDEBUG(1, "Connection closed: fd = %d", p->pollfd[i].fd);
-  close(p->pollfd[i].fd);
-  pollfd_del(p, i);
-  /* compact pfdinfo */
-  PRINT_POLLFDINFO(p);
+/* The answer to the probes (see rsc_messages.h) */
+static struct iovec *manage_probe(u_int32_t value) {
+  struct ioctl_resp_header *resp;
+  struct iovec *v;
+  v = calloc(1, sizeof(struct iovec));
+  resp = calloc(1, sizeof(struct ioctl_resp_header));
+  if(v == NULL || resp == NULL) {
+    free(v); free(resp);
+    return NULL;
+  }
+  resp->resp_type = RSC_IOCTL_RESP;
+  resp->resp_size = htonl(sizeof(struct ioctl_resp_header));
+  resp->resp_size_type = htonl(value);
+  v[0].iov_base = resp;
+  v[0].iov_len = sizeof(struct ioctl_resp_header);
+  return v;
 }
 
-static void 
-main_loop(int listen_fd, int event_sub_fd) {
-  int i, nready;
-  int new_fd;
-  int deleted_entry;
+static int is_probe(struct req_header *req_hd, u_int32_t probe) {
+  return req_hd->req_type == RSC_IOCTL_REQ &&
+    ntohl(((struct ioctl_req_header *)req_hd)->req_ioctl_request) == probe;
+}
+
+/* The requests that change the working directory of the server: chdir,
+ * fchdir, and the compound requests with one of them */
+static int changes_cwd(struct req_header *req_hd) {
+  struct compound_req_header *comp_hd;
+  char *p, *end;
+  int i, rsc_const;
+
+  if(req_hd->req_type == RSC_SYS_REQ) {
+    rsc_const = ntohs(((struct sys_req_header *)req_hd)->req_rsc_const);
+    return rsc_const == __RSC_chdir || rsc_const == __RSC_fchdir;
+  }
+  if(req_hd->req_type != RSC_COMPOUND_REQ)
+    return 0;
+  comp_hd = (struct compound_req_header *)req_hd;
+  p = (char *)req_hd + sizeof(struct compound_req_header);
+  end = (char *)req_hd + ntohl(comp_hd->req_size);
+  for(i = 0; i < comp_hd->req_count && i < RSC_COMPOUND_MAX; i++) {
+    struct sys_req_header *sys_hd = (struct sys_req_header *)(p + sizeof(struct compound_item));
+    int size;
+    /* A malformed request is refused by the worker */
+    if(end - p < sizeof(struct compound_item) + sizeof(struct sys_req_header) ||
+        (size = ntohl(sys_hd->req_size)) < sizeof(struct sys_req_header) ||
+        size > end - (char *)sys_hd)
+      return 0;
+    rsc_const = ntohs(sys_hd->req_rsc_const);
+    if(rsc_const == __RSC_chdir || rsc_const == __RSC_fchdir)
+      return 1;
+    p = (char *)sys_hd + size;
+  }
+  return 0;
+}
+
+/* The size of the frame header preceding the messages of the client */
+static inline int frame_size(struct client *c) {
+  return c->proto == RSC_PROTO_V2 ? sizeof(struct rsc_frame_header) : 0;
+}
+
+/* The epoll events c needs now */
+static u_int32_t client_events(struct client *c) {
+  u_int32_t events = 0;
+  /* A v1 client expects the answers in order: I read its next
+   * request when the previous one has been executed */
+  if(c->type != REQ_RESP || (!c->splicing && !c->serial && c->shm == NULL &&
+      c->inflight < (c->proto == RSC_PROTO_V2 ? max_inflight : 1)))
+    events |= EPOLLIN;
+  if(c->wbuf->first != NULL)
+    events |= EPOLLOUT;
+  return events;
+}
+
+static void update_events(struct client *c) {
+  struct epoll_event ev;
+  u_int32_t events = client_events(c);
+  if(events == c->events)
+    return;
+  bzero(&ev, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = c->fd;
+  if(epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1)
+    fprintf(stderr, "epoll_ctl() error on fd %d: %s\n", c->fd, strerror(errno));
+  c->events = events;
+}
+
+/*************************/
+/* Subscribed fds        */
+/*************************/
+static u_int32_t subscriptions_events(struct client *sub) {
+  u_int32_t events = 0;
+  for(; sub != NULL; sub = sub->next)
+    if(!sub->fired)
+      events |= sub->how;
+  return events;
+}
+
+/* A subscription reports only the first event, so the fd is 
+ * monitored in one-shot mode and re-armed for the others */
+static int arm_subscriptions(int fd, struct client *subs) {
+  struct epoll_event ev;
+  bzero(&ev, sizeof(ev));
+  ev.events = subscriptions_events(subs) | EPOLLONESHOT;
+  ev.data.fd = fd;
+  /* The fd may have been closed and reopened by a request */
+  if(epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) == -1 &&
+      (errno != ENOENT || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1))
+    return -1;
+  return 0;
+}
 
+static void free_subscriptions(struct client *sub) {
+  struct client *next;
+  for(; sub != NULL; sub = next) {
+    next = sub->next;
+    free_client(sub);
+  }
+}
+
+static void event_occurred(struct client *sub) {
+  struct rsc_es_resp *resp;
+  sub->fired = 1;
+  resp = rscs_es_event_occurred(sub->esc->fd, sub->fd, sub->how);
+  if(resp != NULL) {
+    buff_enq(sub->esc->wbuf, resp, sizeof(struct rsc_es_resp)); 
+    update_events(sub->esc);
+  }
+}
+
+static int add_subscription(struct client *esc, int fd, short how) {
+  struct client *subs, *c;
+  subs = fdreg_get(fdreg, fd);
+  /* The fd of a client cannot be subscribed */
+  if(subs != NULL && subs->type != SUBSCRIBED_FD)
+    return -1;
+  if((c = create_client(fd, SUBSCRIBED_FD, CONN_SENDING_RESP)) == NULL)
+    return -1;
+  c->esc = esc;
+  c->how = how;
+  c->next = subs;
+  if(fdreg_add(fdreg, fd, c) == -1) {
+    free_client(c);
+    return -1;
+  }
+  /* epoll refuses the regular files, which are always ready */
+  if(arm_subscriptions(fd, c) == -1)
+    event_occurred(c);
+  return 0;
+}
+
+static void del_subscription(struct client *esc, int fd, short how) {
+  struct client *subs, **sub;
+  subs = fdreg_get(fdreg, fd);
+  if(subs == NULL || subs->type != SUBSCRIBED_FD)
+    return;
+  for(sub = &subs; *sub != NULL; sub = &(*sub)->next)
+    if((*sub)->esc == esc && (*sub)->how == how) {
+      struct client *c = *sub;
+      *sub = c->next;
+      free_client(c);
+      break;
+    }
+  if(subs == NULL) {
+    fdreg_del(fdreg, fd);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+  } else {
+    fdreg_add(fdreg, fd, subs);
+    arm_subscriptions(fd, subs);
+  }
+}
+
+/* Remove all the subscriptions of the event subscriber esc */
+static void drop_subscriptions(struct client *esc) {
+  int fd;
+  for(fd = 0; fd < fdreg->size; fd++) {
+    struct client *c = fdreg->clients[fd];
+    while(c != NULL && c->type == SUBSCRIBED_FD) {
+      struct client *next = c->next;
+      if(c->esc == esc)
+        del_subscription(esc, fd, c->how);
+      c = next;
+    }
+  }
+}
+
+static void manage_subscribed_fd(int fd, struct client *subs, u_int32_t revents) {
+  struct client *sub;
+  GDEBUG(1, "Subscribed fd %d is ready for event 0x%X\n", fd, revents);
+  /* After an error or a hangup the client finds out the reason
+   * by itself, retrying the system call */
+  for(sub = subs; sub != NULL; sub = sub->next)
+    if(!sub->fired && (revents & (sub->how | EPOLLERR | EPOLLHUP)))
+      event_occurred(sub);
+  arm_subscriptions(fd, subs);
+}
+
+/*************************/
+/* Clients               */
+/*************************/
+/* Close the connection of c */
+static void close_connection(struct client *c) {
+	GDEBUG(1, "Connection closed: fd = %d", c->fd);
+  fdreg_del(fdreg, c->fd);
+  close(c->fd);
+  if(c->type == EVENT_SUB)
+    drop_subscriptions(c);
+  __sync_fetch_and_sub(&nclients, 1);
+  /* The workers are executing some requests of c: the last one frees it */
+  if(c->inflight > 0)
+    c->closed = 1;
+  else
+    free_client(c);
+  PRINT_FDREG(fdreg);
+}
+
+/* Write the buffered messages of c, as many as the socket accepts.
+ * Returns -1 if the connection is broken */
+static int flush_client(struct client *c) {
+  struct iovec v[WRITEV_MAX];
+  struct msghdr mh;
+  struct msg *m;
+  int n, nwrite;
+  while(c->wbuf->first != NULL) {
+    /* The spliced data goes from the pipe to the socket */
+    if((m = c->wbuf->first)->pipe != NULL) {
+      nwrite = zc_pipe_send(m->pipe, c->fd, m->tot - m->n, m->next != NULL);
+      if(nwrite == -1) {
+        if(errno == EINTR)
+          continue;
+        return errno == EAGAIN ? 0 : -1;
+      }
+      if((m->n += nwrite) == m->tot) {
+        zc_pipe_put(m->pipe);
+        buff_deq(c->wbuf);
+      }
+      continue;
+    }
+    for(n = 0; m != NULL && m->pipe == NULL && n < WRITEV_MAX; m = m->next, n++) {
+      v[n].iov_base = m->data + m->n;
+      v[n].iov_len = m->tot - m->n;
+    }
+    if(m != NULL && m->pipe != NULL) {
+      /* The header of a spliced response must not wait alone for an ack */
+      bzero(&mh, sizeof(mh));
+      mh.msg_iov = v;
+      mh.msg_iovlen = n;
+      nwrite = sendmsg(c->fd, &mh, MSG_MORE);
+    } else
+      nwrite = writev(c->fd, v, n);
+    if(nwrite == -1) {
+      if(errno == EINTR)
+        continue;
+      return errno == EAGAIN ? 0 : -1;
+    }
+    /* I remove the messages completely written */
+    while(nwrite > 0) {
+      m = c->wbuf->first;
+      if(nwrite < m->tot - m->n) {
+        m->n += nwrite;
+        break;
+      }
+      nwrite -= m->tot - m->n;
+      free(buff_deq(c->wbuf));
+    }
+  }
+  return 0;
+}
+
+/* Queue the answer 'resp' to the request 'data', followed by the data
+ * in 'pipe' if not NULL */
+static int queue_response(struct client *c, void *data, int framed, struct iovec *resp, struct zc_pipe *pipe) {
+  int size, pad = 0;
+  void *zeros = NULL;
+  struct msg *m;
+  if(resp == NULL)
+    return -1;
+  size = resp[0].iov_len;
+  if(pipe != NULL) {
+    pad = pipe->pad;
+    size += pipe->len + pad;
+    if(pad > 0 && (zeros = calloc(1, pad)) == NULL) {
+      zc_pipe_free(pipe);
+      free(resp[0].iov_base);
+      free(resp);
+      return -1;
+    }
+  }
+  /* With v2 the response has the id of the request */
+  if(framed) {
+    struct rsc_frame_header *frame;
+    frame = malloc(sizeof(struct rsc_frame_header));
+    if(frame == NULL) {
+      if(pipe != NULL)
+        zc_pipe_free(pipe);
+      free(zeros);
+      free(resp[0].iov_base);
+      free(resp);
+      return -1;
+    }
+    frame->frame_id = ((struct rsc_frame_header *)data)->frame_id;
+    frame->frame_size = htonl(size);
+    buff_enq(c->wbuf, frame, sizeof(struct rsc_frame_header));
+  }
+  buff_enq(c->wbuf, resp[0].iov_base, resp[0].iov_len);
+  free(resp);
+  if(pipe != NULL) {
+    if(pipe->len > 0) {
+      if((m = buff_enq(c->wbuf, NULL, pipe->len)) == NULL) {
+        zc_pipe_free(pipe);
+        free(zeros);
+        return -1;
+      }
+      m->pipe = pipe;
+    } else
+      zc_pipe_put(pipe);
+    if(pad > 0)
+      buff_enq(c->wbuf, zeros, pad);
+  }
+  return 0;
+}
+
+/* Give the request 'read_data' of c to the workers */
+static int submit_request(struct client *c, void *read_data, int payload) {
+  struct job *j;
+  j = calloc(1, sizeof(struct job));
+  if(j == NULL) {
+    free(read_data);
+    return -1;
+  }
+  j->client = c;
+  j->arch = c->arch;
+  j->data = read_data;
+  j->framed = (c->proto == RSC_PROTO_V2);
+  j->cached = c->cached;
+  /* The worker reads the payload, the main loop doesn't read from the
+   * socket until it has finished */
+  if(payload > 0) {
+    if((j->sockfd = dup(c->fd)) == -1) {
+      free(read_data);
+      free(j);
+      return -1;
+    }
+    j->payload = payload;
+    c->splicing = 1;
+  } else if(changes_cwd(j->data + frame_size(c))) {
+    /* The requests in flight run in the old directory, the next ones
+     * in the new one */
+    c->serial = 1;
+    if(c->inflight > 0) {
+      c->held = j;
+      return 0;
+    }
+  }
+  c->inflight++;
+  workers_submit(j);
+  return 0;
+}
+
+/* Manage the message 'read_data' of a REQ_RESP client */
+static int manage_req_resp(struct client *c, void *read_data) {
+  if(c->state == WAITING_ARCH) {
+    /* I read the architecture of the client */
+    struct handshake *client_arch, *server_arch;
+    client_arch = (struct handshake *)read_data;
+    c->arch = ntohl(client_arch->arch);
+    GDEBUG(1, "Client (%d) architecture is %s\n", c->fd, aconv_arch2str(c->arch));
+    free(read_data);
+    
+    /* Now I can send my architecture */
+    c->state = SENDING_ARCH;
+    server_arch = calloc(1, sizeof(struct handshake));
+    if(server_arch == NULL)
+      return -1;
+    server_arch->arch = htonl(my_arch);
+    buff_enq(c->wbuf, server_arch, sizeof(struct handshake));
+    /* The requests can be read while the answer is sent */
+    c->state = CONN_READING_HDR;
+  } else if(c->state == CONN_READING_HDR) {
+    struct req_header *req_hd;
+    struct msg *m;
+    int req_size, prefix;
+    void *new_data;
+    /* I've read all the request header, now I've to read all the request body */
+    c->state = CONN_READING_BODY;
+    req_hd = (struct req_header *)(read_data + frame_size(c));
+    req_size = frame_size(c) + rsc_req_msg_size(req_hd);
+    if(req_size < frame_size(c) + sizeof(struct req_header)) {
+      free(read_data);
+      return -1;
+    }
+    /* The payload of a big write can be spliced: the arguments first */
+    if((prefix = zc_write_prefix(c->arch, req_hd)) > 0) {
+      req_size = frame_size(c) + prefix;
+      c->partial = 1;
+    }
+    new_data = realloc(read_data, req_size);
+    if(new_data == NULL) {
+      free(read_data);
+      return -1;
+    }
+    m = buff_enq(c->rbuf, new_data, req_size);
+    /* I've already read the req_header, so I need to update m->n field */
+    m->n = frame_size(c) + sizeof(struct req_header);
+  } else if(c->state == CONN_READING_BODY && c->partial) {
+    /* I've read the arguments of the request */
+    struct req_header *req_hd = (struct req_header *)(read_data + frame_size(c));
+    int payload, size, nread;
+    struct msg *m;
+    void *new_data;
+    c->partial = 0;
+    if((payload = zc_write_payload(req_hd)) > 0) {
+      c->state = CONN_READING_HDR;
+      return submit_request(c, read_data, payload);
+    }
+    /* Not a write, I read the rest */
+    size = frame_size(c) + rsc_req_msg_size(req_hd);
+    nread = frame_size(c) + zc_write_prefix(c->arch, req_hd);
+    if((new_data = realloc(read_data, size)) == NULL) {
+      free(read_data);
+      return -1;
+    }
+    m = buff_enq(c->rbuf, new_data, size);
+    m->n = nread;
+  } else if(c->state == CONN_READING_BODY) {
+    /* Now I've read all the request */
+    c->state = CONN_READING_HDR;
+    struct req_header *req_hd = (struct req_header *)(read_data + frame_size(c));
+    if(is_probe(req_hd, RSC_PROTO_PROBE)) {
+      int ret;
+      /* The answer to the probe is the last v1 message */
+      ret = queue_response(c, read_data, 0, manage_probe(RSC_PROTO_V2), NULL);
+      c->proto = RSC_PROTO_V2;
+      free(read_data);
+      return ret;
+    } else if(is_probe(req_hd, RSC_CACHE_PROBE) && lease_ms > 0) {
+      int ret;
+      /* The answer is the duration of the leases */
+      ret = queue_response(c, read_data, c->proto == RSC_PROTO_V2, manage_probe(lease_ms), NULL);
+      c->cached = 1;
+      free(read_data);
+      return ret;
+    } else if(is_probe(req_hd, RSC_COMPOUND_PROBE)) {
+      int ret;
+      ret = queue_response(c, read_data, c->proto == RSC_PROTO_V2, manage_probe(RSC_COMPOUND_MAX), NULL);
+      free(read_data);
+      return ret;
+    } else if(is_probe(req_hd, RSC_SHM_PROBE)) {
+      int ret;
+      /* The region comes with the probe. The client waits for the answer
+       * before using it, then serve_shm() takes the client */
+      if(c->local && c->proto == RSC_PROTO_V1 && c->arch == my_arch && c->shm_fd != -1)
+        c->shm = rsc_shm_map(c->shm_fd);
+      if(c->shm_fd != -1) {
+        close(c->shm_fd);
+        c->shm_fd = -1;
+      }
+      ret = queue_response(c, read_data, c->proto == RSC_PROTO_V2, 
+          manage_probe(c->shm != NULL ? RSC_SHM_PROBE : 0), NULL);
+      free(read_data);
+      return ret;
+    } else
+      /* The system call is executed by a worker */
+      return submit_request(c, read_data, 0);
+  }
+  return 0;
+}
+
+/* Manage the message 'read_data' of a EVENT_SUB client */
+static int manage_event_sub(struct client *c, void *read_data) {
+  if(c->state == CONN_READING_HDR) {
+    struct rsc_es_hdr *hdr;
+    int size;
+    void *new_data;
+    struct msg *m;
+    hdr = (struct rsc_es_hdr *)read_data;
+    /* The client wants the invalidations of its cache */
+    if(hdr->type == EVENT_SUB_CACHE) {
+      c->cached = 1;
+      free(read_data);
+      return 0;
+    }
+    if(hdr->type == EVENT_SUB_REQ || hdr->type == EVENT_SUB_DEREG)
+      size = rsc_es_msg_size(hdr->type);
+    else
+      size = -1;
+    if(size == -1 || (new_data = realloc(read_data, size)) == NULL) {
+      free(read_data);
+      return -1;
+    }
+    m = buff_enq(c->rbuf, new_data, size);
+    m->n = sizeof(struct rsc_es_hdr);
+    c->state = CONN_READING_BODY;
+  } else if(c->state == CONN_READING_BODY) {
+    struct rsc_es_ack *ack;
+    ack = rscs_es_manage_msg(c->fd, read_data);
+    free(read_data);
+    /* Now I can send ack back, before any event of the fd */
+    buff_enq(c->wbuf, ack, sizeof(struct rsc_es_ack));
+    c->state = CONN_READING_HDR;
+    /* I take the appropriate action based on ack->response field.
+     * If the response is ACK_FD_REG I've to monitor the fd.
+     * If the response is ACK_FD_DEREG_NOT_READY or ACK_FD_READY,
+     * I stop monitoring it. */
+    if(ack->response == ACK_FD_REG) {
+      if(add_subscription(c, ntohl(ack->fd), ntohl(ack->how)) == -1)
+        return -1;
+    } else if(ack->response == ACK_FD_DEREG_NOT_READY || ack->response == ACK_FD_DEREG_READY)
+      del_subscription(c, ntohl(ack->fd), ntohl(ack->how));
+    GDEBUG(1, "After rscem_manage_msg:");
+    PRINT_FDREG(fdreg);
+  }
+  return 0;
+}
+
+/* Send the change of 'path' to the clients with the cache */
+static void broadcast_inval(char *path, int len, int flags) {
+  int fd;
+  GDEBUG(1, "Invalidation of %s (flags %d)\n", path, flags);
+  for(fd = 0; fd < fdreg->size; fd++) {
+    struct client *c = fdreg->clients[fd];
+    struct rsc_es_inval *inval;
+    if(c == NULL || c->type != EVENT_SUB || !c->cached)
+      continue;
+    if((inval = malloc(sizeof(struct rsc_es_inval) + len)) == NULL)
+      continue;
+    inval->type = EVENT_SUB_INVAL;
+    inval->flags = flags;
+    inval->len = htonl(len);
+    memcpy(inval + 1, path, len);
+    buff_enq(c->wbuf, inval, sizeof(struct rsc_es_inval) + len);
+    update_events(c);
+  }
+}
+
+/* Read from c as long as there are data and c can send requests.
+ * Returns -1 if the connection has to be closed */
+static int read_client(struct client *c) {
+  while(client_events(c) & EPOLLIN) {
+    struct msg *m;
+    int nread;
+    /* If the read buffer is empty I create a new message */
+    if(c->rbuf->first == NULL) {
+      int size = 0;
+      void *data;
+      if(c->type == REQ_RESP && c->state == CONN_READING_HDR)
+        size = frame_size(c) + sizeof(struct req_header);
+      else if(c->type == EVENT_SUB && c->state == CONN_READING_HDR)
+        size = sizeof(struct rsc_es_hdr);
+      if(size == 0 || (data = malloc(size)) == NULL)
+        return -1;
+      buff_enq(c->rbuf, data, size);
+    }
+    /* I read the data of the first message */
+    m = c->rbuf->first;
+    /* A local client can send the fd of a memory region */
+    if(c->local)
+      nread = rsc_shm_recv_fd(c->fd, m->data + m->n, m->tot - m->n, &c->shm_fd);
+    else
+      nread = read(c->fd, m->data + m->n, m->tot - m->n);
+    if(nread == -1 && errno == EINTR)
+      continue;
+    if(nread == -1 && errno == EAGAIN)
+      return 0;
+    /* If there is an error or the connection was closed,
+     * I close the connection from my side */
+    if(nread <= 0)
+      return -1;
+    m->n += nread;
+
+    /* If I've read all the data, I remove the buffer from c->rbuf
+     * and I process the data */
+    if(m->n == m->tot) {
+      void *read_data = buff_deq(c->rbuf);
+      if(c->type == REQ_RESP) {
+        if(manage_req_resp(c, read_data) == -1)
+          return -1;
+      } else if(manage_event_sub(c, read_data) == -1)
+        return -1;
+    }
+  }
+  return 0;
+}
+
+static void accept_clients(int listen_fd, enum client_type type, int local) {
   struct sockaddr_in client_addr;
   socklen_t client_len;
+  int new_fd, size;
+  enum client_state state;
+  if(type == REQ_RESP) {
+    size = sizeof(struct handshake);
+    state = WAITING_ARCH;
+  } else {
+    size = sizeof(struct rsc_es_hdr);
+    state = CONN_READING_HDR;
+  }
+
+  while(1) {
+    struct client *new_client;
+    struct epoll_event ev;
+    void *data;
+    bzero(&client_addr, sizeof(client_addr));
+    client_len = sizeof(client_addr);
+    
+    /* I accept the new connection */
+    new_fd = accept(listen_fd, (struct sockaddr *)&client_addr, &client_len); 
+    if(new_fd == -1) {
+      if(errno != EAGAIN && errno != EINTR)
+        fprintf(stderr, "Accept() error: %s\n", strerror(errno));
+      return;
+    }
+    if(nclients >= max_clients) {
+      fprintf(stderr, "Too many clients, connection refused (fd %d)\n", new_fd);
+      close(new_fd);
+      continue;
+    }
+
+    /* I create the new client structure */
+    new_client = create_client(new_fd, type, state);
+    data = malloc(size);
+    if(new_client == NULL || data == NULL || set_non_blocking(new_fd) == 0) {
+      fprintf(stderr, "I cannot create a new client struct for fd %d\n", new_fd);
+      if(new_client != NULL)
+        free_client(new_client);
+      free(data);
+      close(new_fd);
+      continue;
+    }
+    buff_enq(new_client->rbuf, data, size);
+    new_client->local = local;
+    GDEBUG(1, "Accepting new connection from "); print_addr_port(new_client->fd); GDEBUG(1, " (fd = %d).\n", new_client->fd);
 
-  pollfd_add(pfdinfo, listen_fd, POLLIN, NULL); 
-  pollfd_add(pfdinfo, event_sub_fd, POLLIN, NULL); 
+    /* The fd number may belong to a subscribed fd closed by a request */
+    free_subscriptions(fdreg_get(fdreg, new_fd));
+    bzero(&ev, sizeof(ev));
+    ev.events = new_client->events = EPOLLIN;
+    ev.data.fd = new_fd;
+    if(fdreg_add(fdreg, new_fd, new_client) == -1 ||
+        epoll_ctl(epfd, EPOLL_CTL_ADD, new_fd, &ev) == -1) {
+      fprintf(stderr, "I cannot register the fd %d\n", new_fd);
+      fdreg_del(fdreg, new_fd);
+      free_client(new_client);
+      close(new_fd);
+      continue;
+    }
+    __sync_fetch_and_add(&nclients, 1);
+  }
+}
+
+/*************************/
+/* Local clients         */
+/*************************/
+/* Executes the requests of the client c read from the shared memory, 
+ * in order, and writes the answers in it */
+static void *shm_client(void *arg) {
+  struct client *c = arg;
+  struct req_header hd;
+  struct iovec *resp;
+  void *req = NULL, *new_req;
+  int size, n;
+
+  while(rsc_ring_read(c->shm, RSC_RING_REQ, c->fd, &hd, sizeof(hd)) == sizeof(hd)) {
+    size = rsc_req_msg_size(&hd);
+    if(size < sizeof(hd) || (new_req = realloc(req, size)) == NULL)
+      break;
+    req = new_req;
+    memcpy(req, &hd, sizeof(hd));
+    n = size - sizeof(hd);
+    if(rsc_ring_read(c->shm, RSC_RING_REQ, c->fd, req + sizeof(hd), n) != n)
+      break;
+    if(is_probe(req, RSC_CACHE_PROBE) && lease_ms > 0) {
+      resp = manage_probe(lease_ms);
+      c->cached = 1;
+    } else if(is_probe(req, RSC_COMPOUND_PROBE))
+      resp = manage_probe(RSC_COMPOUND_MAX);
+    else if(is_probe(req, RSC_SHM_PROBE))
+      resp = manage_probe(0);
+    else {
+      if(c->cached)
+        leases_watch(req);
+      resp = rscs_manage_request(c->arch, req);
+    }
+    if(resp == NULL)
+      break;
+    n = rsc_ring_writev(c->shm, RSC_RING_RESP, c->fd, resp, 1, resp[0].iov_len);
+    free(resp[0].iov_base);
+    if(n != resp[0].iov_len) {
+      free(resp);
+      break;
+    }
+    free(resp);
+  }
+  GDEBUG(1, "Local connection closed: fd = %d", c->fd);
+  free(req);
+  close(c->fd);
+  /* The client is woken up if it waits */
+  free_client(c);
+  __sync_fetch_and_sub(&nclients, 1);
+  return NULL;
+}
+
+/* The answer to the RSC_SHM_PROBE has been sent: the main loop forgets
+ * c, a thread of its own executes its requests. A blocking system call
+ * stops only c, as with the workers */
+static void serve_shm(struct client *c) {
+  pthread_attr_t attr;
+  pthread_t tid;
+  sigset_t set, oldset;
+  int ret;
+
+  epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+  fdreg_del(fdreg, c->fd);
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  /* The signals are for the main thread */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK, &set, &oldset);
+  ret = pthread_create(&tid, &attr, shm_client, c);
+  pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+  pthread_attr_destroy(&attr);
+  if(ret != 0) {
+    fprintf(stderr, "I cannot create the thread of the local client %d\n", c->fd);
+    close(c->fd);
+    free_client(c);
+    __sync_fetch_and_sub(&nclients, 1);
+  }
+}
+
+/* The answers of the workers */
+static void manage_done_jobs(void) {
+  struct job *j, *next;
+  for(j = workers_done(); j != NULL; j = next) {
+    struct client *c = j->client;
+    next = j->next;
+    c->inflight--;
+    if(c->inflight == 0 && c->held != NULL) {
+      /* The change of directory can run now */
+      if(c->closed) {
+        free(c->held->data);
+        free(c->held);
+      } else {
+        c->inflight++;
+        workers_submit(c->held);
+      }
+      c->held = NULL;
+    } else if(c->inflight == 0)
+      c->serial = 0;
+    /* The worker has read the payload, the next request can be read */
+    if(j->payload > 0)
+      c->splicing = 0;
+    if(c->closed) {
+      /* Nobody waits for the answer */
+      if(j->resp != NULL) {
+        free(j->resp[0].iov_base);
+        free(j->resp);
+      }
+      if(j->pipe != NULL)
+        zc_pipe_free(j->pipe);
+      if(c->inflight == 0)
+        free_client(c);
+    } else if(queue_response(c, j->data, j->framed, j->resp, j->pipe) == -1 || 
+        flush_client(c) == -1)
+      close_connection(c);
+    else
+      /* A v1 client can send its next request */
+      update_events(c);
+    free(j->data);
+    free(j);
+  }
+}
+
+static void 
+main_loop(int listen_fd, int event_sub_fd, int unix_fd, int unix_es_fd, int done_fd, int leases_fd) {
+  struct epoll_event events[MAX_EVENTS], ev;
+  int i, nready;
+  int fds[6] = {listen_fd, event_sub_fd, done_fd, leases_fd, unix_fd, unix_es_fd};
+
+  for(i = 0; i < 6; i++) {
+    if(fds[i] == -1)
+      continue;
+    bzero(&ev, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fds[i];
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, fds[i], &ev) == -1) {
+      fprintf(stderr, "I cannot register the fd %d: %s\n", fds[i], strerror(errno));
+      return;
+    }
+  }
 
   /* Main loop */
   while(1) {
-    deleted_entry = 0;
-		GDEBUG(1, "Before poll():");
-    PRINT_POLLFDINFO(pfdinfo);
+		GDEBUG(1, "Before epoll_wait():");
+    PRINT_FDREG(fdreg);
 
-    /* Poll */
-    nready = poll(pfdinfo->pollfd, pfdinfo->nfds, -1);
+    nready = epoll_wait(epfd, events, MAX_EVENTS, -1);
     /* There is an error? */
     if(nready == -1) {
-      fprintf(stderr, "poll() error: %s; I continue.\n", strerror(errno));
+      if(errno != EINTR)
+        fprintf(stderr, "epoll_wait() error: %s; I continue.\n", strerror(errno));
       continue;
     }
 
-    for(i = 0; i < pfdinfo->nfds; i++) {
-      if(pfdinfo->pollfd[i].revents == 0)
+    for(i = 0; i < nready; i++) {
+      int fd = events[i].data.fd;
+      u_int32_t revents = events[i].events;
+      struct client *c;
+      if(fd == listen_fd)
+        accept_clients(fd, REQ_RESP, 0);
+      else if(fd == event_sub_fd)
+        accept_clients(fd, EVENT_SUB, 0);
+      else if(fd == unix_fd)
+        accept_clients(fd, REQ_RESP, 1);
+      else if(fd == unix_es_fd)
+        accept_clients(fd, EVENT_SUB, 1);
+      else if(fd == done_fd)
+        manage_done_jobs();
+      else if(fd == leases_fd)
+        leases_events(broadcast_inval);
+      /* The client may have been closed by a previous event */
+      else if((c = fdreg_get(fdreg, fd)) == NULL)
         continue;
-      GDEBUG(1, "fd = %d is ready for event 0x%X\n", pfdinfo->pollfd[i].fd, pfdinfo->pollfd[i].revents);
-      /* If there is an error, I close the connection */
-      if( pfdinfo->pollfd[i].revents & POLLERR || pfdinfo->pollfd[i].revents & POLLHUP || 
-          pfdinfo->pollfd[i].revents & POLLNVAL) {
-          /* printf("Error, getchar():\n"); getchar(); */
-          close_connection(pfdinfo, i);
-          deleted_entry = 1;
-          if(--nready < 0) break;
-          continue;
-      }
-
-	    /*********************************************/
-	    /* New Connection/Event Subscribe management */
-	    /*********************************************/
-	    if((pfdinfo->pollfd[i].fd == listen_fd || pfdinfo->pollfd[i].fd == event_sub_fd) 
-          && pfdinfo->pollfd[i].revents & POLLIN) {
-        enum client_type type;
-        int size;
-        enum client_state state;
-        if(pfdinfo->pollfd[i].fd == listen_fd) {
-          type = REQ_RESP;
-          size = sizeof(struct handshake);
-          state = WAITING_ARCH;
-        } else {
-          type = EVENT_SUB;
-          size = sizeof(struct rsc_es_hdr);
-          state = CONN_READING_HDR;
-        }
-        
-	      bzero(&client_addr, sizeof(client_addr));
-	      client_len = sizeof(client_addr);
-	
-	      /* I accept the new connection */
-	      new_fd = accept(pfdinfo->pollfd[i].fd, (struct sockaddr *)&client_addr, &client_len); 
-	
-	      if(new_fd == -1) {
-	        fprintf(stderr, "Accept() error: %s\n", strerror(errno));
-	      } else {
-	        /* I create the new client structure */
-	        struct client *new_client;
-          void *data;
-	        new_client = create_client(new_fd, type, state);
-          data = malloc(sizeof(struct handshake));
-          if(data == NULL) {
-            close(new_fd);
-            if(--nready < 0) break;
-            continue;
-          }
-
-	        if(new_client == NULL || data == NULL) {
-	          fprintf(stderr, "I cannot create a new client struct for fd %d\n", new_fd);
-            if(new_client == NULL)
-              free(new_client);
-            if(data == NULL);
-              free(data);
-	          close(new_fd);
-	        } else {
-            buff_enq(new_client->rbuf, data, size);
-			      GDEBUG(1, "Accepting new connection from "); print_addr_port(new_client->fd); GDEBUG(1, " (fd = %d).\n", new_client->fd);
-            pollfd_add(pfdinfo, new_client->fd, POLLIN, new_client);
-	        }
-	      }
-	      if(--nready <= 0) break;
-        /*************************************************************************/
-        /* Management of descriptors ready to read of type REQ_RESP or EVENT_SUB */
-        /*************************************************************************/
-      } else if(pfdinfo->clients[i]->type == REQ_RESP || pfdinfo->clients[i]->type == EVENT_SUB) {
-        struct client *client = pfdinfo->clients[i];
-        /***********************************************/
-        /*  POLLIN                                     */
-        /***********************************************/
-        if(pfdinfo->pollfd[i].revents &  POLLIN) {
-	        void *buf;
-	        int size, nread;
-          /* If there are data to read, but the read buffer is empty 
-           * I create a new message */
-          if(client->rbuf->first == NULL) {
-            int size = 0;
-            void *data;
-            if(pfdinfo->clients[i]->type == REQ_RESP && 
-                pfdinfo->clients[i]->state == CONN_READING_HDR)
-              size = sizeof(struct req_header);
-            else if(pfdinfo->clients[i]->type == EVENT_SUB && 
-                pfdinfo->clients[i]->state == CONN_READING_HDR)
-              size = sizeof(struct rsc_es_hdr);
-            if(size != 0) {
-              data = malloc(size);
-              if(data == NULL) {
-                close_connection(pfdinfo, i);
-                deleted_entry = 1;
-                if(--nready < 0) break;
-                continue;
-              }
-
-              buff_enq(client->rbuf, data, size);
-            }
-          }
-		      GDEBUG(1, "There are data ready do be read for fd %d", pfdinfo->pollfd[i].fd);
-          /* I read the data from the first message */
-	        buf = client->rbuf->first->data + client->rbuf->first->n;
-	        size = client->rbuf->first->tot - client->rbuf->first->n;
-			    nread = read(client->fd, buf, size);
-	        if(nread <= 0 ) {
-	          /* If there is an error or the connection was close,
-             * I close the connection from my side */
-            close_connection(pfdinfo, i);
-            deleted_entry = 1;
-            if(--nready <= 0) break;
-            continue;
-          } else {
-	          client->rbuf->first->n += nread;
-          }
-			    
-          /* If I've read all the data, I remove the buffer from client->rbuf
-           * and I process the data */
-			    if(client->rbuf->first->n == client->rbuf->first->tot) {
-            void *read_data = buff_deq(client->rbuf);
-	          if(pfdinfo->clients[i]->type == REQ_RESP) {
-				      if(client->state == WAITING_ARCH) {
-			          /* I read the architecture of the client */
-					      struct handshake *client_arch, *server_arch;
-			          client_arch = (struct handshake *)read_data;
-				
-						    client->arch = ntohl(client_arch->arch);
-						    GDEBUG(1, "Client (%d) architecture is %s\n", client->fd, aconv_arch2str(client->arch));
-                free(read_data);
-						    
-						    /* Now I can send my architecture */
-		            client->state = SENDING_ARCH;
-		            server_arch = calloc(1, sizeof(struct handshake));
-		            if(server_arch == NULL) {
-                  close_connection(pfdinfo, i);
-                  deleted_entry = 1;
-                  if(--nready < 0) break;
-                  continue;
-                }
-                server_arch->arch = htonl(my_arch);
-		            buff_enq(client->wbuf, server_arch, sizeof(struct handshake));
-                pfdinfo->pollfd[i].events |=  POLLOUT;
-                client->state = SENDING_ARCH;
-				      }else if(client->state == CONN_READING_HDR) {
-			          struct req_header *req_hd;
-                struct msg *m;
-		            int req_size;
-                void *new_data;
-		            /* I've read all the request header, now I've to read all the request body */
-                client->state = CONN_READING_BODY;
-		            req_hd = (struct req_header *)read_data;
-			          req_size = rsc_req_msg_size(req_hd);
-                new_data = realloc(read_data, req_size);
-                if(new_data == NULL) {
-                  close_connection(pfdinfo, i);
-                  deleted_entry = 1;
-                  if(--nready < 0) break;
-                  continue;
-                }
-
-		            m = buff_enq(client->rbuf, new_data, req_size);
-                /* I've already read the req_header, so I need to update m->n field */
-                m->n = sizeof(struct req_header);
-		          }else if(client->state == CONN_READING_BODY) {
-			          /* Now I've read all the request and I can pass it to RSC function */
-                struct iovec *resp;
-					      resp = rscs_manage_request(client->arch, read_data);
-                /* If there is an error, I close the connection */
-                if(resp == NULL) {
-                  close_connection(pfdinfo, i);
-                  deleted_entry = 1;
-                  if(--nready < 0) break;
-                  continue;
-                }
-		            buff_enq(client->wbuf, resp[0].iov_base, resp[0].iov_len);
-                pfdinfo->pollfd[i].events |=  POLLOUT;
-                client->state = CONN_SENDING_RESP;
-                free(read_data);
-              }
-            } else {
-	            /* type == EVENT_SUB */
-				      if(client->state == CONN_READING_HDR) {
-	              struct rsc_es_hdr *hdr;
-	              int size;
-                void *new_data;
-                struct msg *m;
-	              hdr = (struct rsc_es_hdr *)read_data;
-	              size = rsc_es_msg_size(hdr->type);
-	              if(size == -1) {
-                  close_connection(pfdinfo, i);
-                  deleted_entry = 1;
-                  if(--nready < 0) break;
-                  continue;
-                }
-                new_data = realloc(read_data, size);
-                if(new_data == NULL) {
-                  close_connection(pfdinfo, i);
-                  deleted_entry = 1;
-                  if(--nready < 0) break;
-                  continue;
-                }
-                m = buff_enq(client->rbuf, new_data, size);
-                m->n = sizeof(struct rsc_es_hdr);
-                client->state = CONN_READING_BODY;
-	            } else if(client->state == CONN_READING_BODY) {
-	              struct rsc_es_ack *ack;
-	              ack = rscs_es_manage_msg(client->fd, read_data);
-                free(read_data);
-			          /* I take the appropriate action based on ack->response field.
-			           * If the response is ACK_FD_REG I've to insert the fd into the
-			           * pollfd set. If the response is ACK_FD_DEREG_NOT_READY or ACK_FD_READY,
-			           * I remove the fd from the pollfd. */
-			          if(ack->response == ACK_FD_REG) {
-				          struct client *c;
-			            /* Into the client structure I insert the stream fd and not the 
-			             * fd to subscribe, In this way I can know where to send data */
-			            c = create_client(client->fd, SUBSCRIBED_FD, CONN_SENDING_RESP);
-                  if(c == NULL) {
-                    close_connection(pfdinfo, i);
-                    deleted_entry = 1;
-                    if(--nready < 0) break;
-                    continue;
-                  }
-                  c->esfd_index = i;
-			            pollfd_add(pfdinfo, ntohl(ack->fd), ntohl(ack->how), c);
-			          } else if(ack->response == ACK_FD_DEREG_NOT_READY || ack->response == ACK_FD_DEREG_READY) {
-			            int j;
-			            for(j = 0; j < pfdinfo->size; j++) 
-			              if( pfdinfo->pollfd[j].fd != -1 &&
-			                  pfdinfo->clients[j] != NULL &&
-			                  pfdinfo->clients[j]->type == SUBSCRIBED_FD &&
-			                  pfdinfo->clients[j]->fd == client->fd && 
-			                  pfdinfo->pollfd[j].fd == ntohl(ack->fd) && 
-			                  pfdinfo->pollfd[j].events == ntohl(ack->how))
-			                break;
-			            if(j < pfdinfo->size)
-			              pollfd_del(pfdinfo, j);
-			          }
-			          GDEBUG(1, "After rscem_manage_msg:");
-			          PRINT_POLLFDINFO(pfdinfo);
-	              /* Now I can send ack back */
-                buff_enq(client->wbuf, ack, sizeof(struct rsc_es_ack));
-                pfdinfo->pollfd[i].events |=  POLLOUT;
-                /* It's not an error, I don't need to keep trace of the sending state */
-                client->state = CONN_READING_HDR;
-	            }
-	          }
-          }
-          /***********************************************/
-          /*  POLLOUT                                    */
-          /***********************************************/
-        } else if(pfdinfo->pollfd[i].revents & POLLOUT) {
-	        void *buf;
-	        int size, nwrite;
-          /* If write buffer is empty, I remove the POLLOUT event and I continue */
-          if(client->wbuf->first == NULL) {
-            pfdinfo->pollfd[i].events &= (~POLLOUT);
-            if(--nready <= 0) 
-              break;
-            continue;
-          }
-		      GDEBUG(1, "There are data ready do be written for fd %d", pfdinfo->pollfd[i].fd);
-	        buf = client->wbuf->first->data + client->wbuf->first->n;
-	        size = client->wbuf->first->tot - client->wbuf->first->n;
-			    nwrite = write(client->fd, buf, size);
-          if(nwrite < 0) {
-            close_connection(pfdinfo, i);
-            deleted_entry = 1;
-            if(--nready < 0) break;
-            continue;
-          } else {
-            client->wbuf->first->n += nwrite;
-          }
-			    if(client->wbuf->first->n == client->wbuf->first->tot) {
-            /* I remove the message from the buffer and I free it */
-            void *data = buff_deq(client->wbuf);
-            free(data);
-            /* If it's a request/response fd and I've sent an arch or response message,
-             * I change my state to reading header */
-	          if( pfdinfo->clients[i]->type == REQ_RESP && 
-                ( client->state == SENDING_ARCH || client->state == CONN_SENDING_RESP) )
-              client->state = CONN_READING_HDR;
-	          /* if client->type is EVENT_SUB  there is nothing to do: I need only
-            * to continue to send the buffered data */
-          }
-        }
-        if(--nready <= 0) break;
-      /*******************************************/
-      /* An event subscribed fd is waken up      */
-      /*******************************************/
-      /* The event is occurred, I send back a response I didn't it before */
-      }else if(pfdinfo->clients[i]->type == SUBSCRIBED_FD) {
-        struct rsc_es_resp *resp;
-        int esfd_index = pfdinfo->clients[i]->esfd_index;
-
-        resp = rscs_es_event_occurred(pfdinfo->pollfd[esfd_index].fd, pfdinfo->pollfd[i].fd, pfdinfo->pollfd[i].revents);
-        if(resp != NULL) {
-          buff_enq(pfdinfo->clients[esfd_index]->wbuf, resp, sizeof(struct rsc_es_resp)); 
-          pfdinfo->pollfd[esfd_index].events |=  POLLOUT;
-        } 
-	      if(--nready <= 0) break;
+      else if(c->type == SUBSCRIBED_FD)
+        manage_subscribed_fd(fd, c, revents);
+      else {
+        GDEBUG(1, "fd = %d is ready for event 0x%X\n", fd, revents);
+        /* If there is an error, I close the connection */
+        if((revents & (EPOLLERR | EPOLLHUP)) ||
+            ((revents & EPOLLIN) && read_client(c) == -1) ||
+            flush_client(c) == -1)
+          close_connection(c);
+        else if(c->shm != NULL && c->wbuf->first == NULL)
+          serve_shm(c);
+        else
+          update_events(c);
       }
-    } /* for(i = 0; i < nready; i++) */
-    /* If I've deleted a pfdinfo, I compact it */
-    if(deleted_entry)
-      pollfd_compact(pfdinfo);
-  } /* while(1) */
+    }
+  }
 }
 
 static void usage(char *s, int exit_code) {
@@ -672,8 +1259,15 @@ static void usage(char *s, int exit_code) {
       "\t-h, --help                       print this help message.\n"
       "\t-a ADDRESS, --address ADDRESS    bind the server to ADDRESS.\n"
       "\t-p PORT, --port PORT             set the port for syscall execution.\n"
-      "\t-e PORT, --es_port PORT          set the port for event subscription.\n",
-      basename(s));
+      "\t-e PORT, --es_port PORT          set the port for event subscription.\n"
+      "\t-w N, --workers N                execute the system calls with N threads (default %d).\n"
+      "\t-i N, --inflight N               execute up to N requests of a client at the same time (default %d).\n"
+      "\t-c N, --clients N                accept up to N connections (default %d).\n"
+      "\t-l MS, --lease MS                the clients can cache the answers for MS milliseconds,\n"
+      "\t                                 0 disables the leases (default %d).\n"
+      "\t-u PATH, --unix PATH             accept the clients on the same host also on the unix\n"
+      "\t                                 sockets PATH and PATH" UNIX_EVENT_SUB_SUFFIX " (event subscription).\n",
+      basename(s), WORKERS, MAX_INFLIGHT, MAX_CLIENTS, LEASE);
 
   exit(exit_code);
 }
@@ -685,14 +1279,16 @@ static void usage(char *s, int exit_code) {
 int
 main (int argc, char *argv[])
 {
-  int listen_fd, event_sub_fd;
-  int c;
-  char *server_addr, *server_port, *event_sub_server_port;
+  int listen_fd, event_sub_fd, unix_fd, unix_es_fd, done_fd, leases_fd;
+  int c, nworkers;
+  char *server_addr, *server_port, *event_sub_server_port, *unix_path;
   
   /* I parse the command-line arguments */
   server_addr = SERVER_ADDR;
   server_port = SERVER_PORT;
   event_sub_server_port = SERVER_PORT_EVENT_SUB;
+  unix_path = NULL;
+  nworkers = WORKERS;
 
   while(1) {
     int option_index = 0;
@@ -700,10 +1296,16 @@ main (int argc, char *argv[])
       {"address", 1, NULL, 'a'},
       {"port", 1, NULL, 'p'},
       {"es_port", 1, NULL, 'e'},
-      {"help", 0, NULL, 'h'}
+      {"workers", 1, NULL, 'w'},
+      {"inflight", 1, NULL, 'i'},
+      {"clients", 1, NULL, 'c'},
+      {"lease", 1, NULL, 'l'},
+      {"unix", 1, NULL, 'u'},
+      {"help", 0, NULL, 'h'},
+      {0, 0, 0, 0}
     };
     
-    c = getopt_long(argc, argv, "a:p:e:h", long_option, &option_index);
+    c = getopt_long(argc, argv, "a:p:e:w:i:c:l:u:h", long_option, &option_index);
     
     if(c == -1) break;
     switch(c) {
@@ -719,6 +1321,25 @@ main (int argc, char *argv[])
       case 'e':
         event_sub_server_port = optarg;
         break;
+      case 'w':
+        if((nworkers = atoi(optarg)) <= 0)
+          usage(argv[0], -1);
+        break;
+      case 'i':
+        if((max_inflight = atoi(optarg)) <= 0)
+          usage(argv[0], -1);
+        break;
+      case 'c':
+        if((max_clients = atoi(optarg)) <= 0)
+          usage(argv[0], -1);
+        break;
+      case 'l':
+        if((lease_ms = atoi(optarg)) < 0)
+          usage(argv[0], -1);
+        break;
+      case 'u':
+        unix_path = optarg;
+        break;
       default:
         usage(argv[0], -1);
         break;
@@ -728,13 +1349,13 @@ main (int argc, char *argv[])
   GDEBUG(1, "Server <addr, port>: <%s, %s>\n", server_addr, server_port);
   
   /* I initialize the server */
-  if(init(server_addr, server_port, event_sub_server_port, &listen_fd, &event_sub_fd) < 0) {
+  if(init(server_addr, server_port, event_sub_server_port, unix_path, nworkers, &listen_fd, &event_sub_fd, &unix_fd, &unix_es_fd, &done_fd, &leases_fd) < 0) {
     fprintf(stderr, "Error during the initialization of the server.\n");
     exit(-1);
   }
 
   /* Main loop */
-  main_loop(listen_fd, event_sub_fd);
+  main_loop(listen_fd, event_sub_fd, unix_fd, unix_es_fd, done_fd, leases_fd);
 
   return 0;
 }
@@ -0,0 +1,141 @@
+/*   
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   workers.c: pool of threads executing the requests of the clients
+ *   
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include "gdebug.h"
+
+#include "rsc_server.h"
+#include "workers.h"
+#include "leases.h"
+#include "zerocopy.h"
+
+/* Requests waiting for a worker */
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static struct job *queue_first, *queue_last;
+/* Requests executed, waiting for the main loop */
+static pthread_mutex_t done_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct job *done_first, *done_last;
+static int done_fd = -1;
+
+static void *worker(void *arg) {
+  struct job *j;
+  u_int64_t one = 1;
+  int wakeup;
+  while(1) {
+    pthread_mutex_lock(&queue_mutex);
+    while(queue_first == NULL)
+      pthread_cond_wait(&queue_cond, &queue_mutex);
+    j = queue_first;
+    queue_first = j->next;
+    if(queue_first == NULL)
+      queue_last = NULL;
+    pthread_mutex_unlock(&queue_mutex);
+
+    if(j->cached)
+      leases_watch(j->data + (j->framed ? sizeof(struct rsc_frame_header) : 0));
+    /* A blocking system call stops only this thread */
+    if(j->payload > 0)
+      zc_write(j);
+    else if(!zc_read(j))
+      j->resp = rscs_manage_request(j->arch, 
+          j->data + (j->framed ? sizeof(struct rsc_frame_header) : 0));
+    j->next = NULL;
+
+    pthread_mutex_lock(&done_mutex);
+    /* The main loop takes the whole list, it needs to be woken up 
+     * only by the first job */
+    wakeup = (done_first == NULL);
+    if(done_first == NULL)
+      done_first = done_last = j;
+    else {
+      done_last->next = j;
+      done_last = j;
+    }
+    pthread_mutex_unlock(&done_mutex);
+    if(wakeup && write(done_fd, &one, sizeof(one)) != sizeof(one))
+      fprintf(stderr, "I cannot wake up the main loop: %s\n", strerror(errno));
+  }
+  return NULL;
+}
+
+int workers_init(int nworkers) {
+  pthread_attr_t attr;
+  pthread_t tid;
+  sigset_t set, oldset;
+  int i;
+
+  if((done_fd = eventfd(0, EFD_NONBLOCK)) == -1)
+    return -1;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  /* The signals are for the main thread */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK, &set, &oldset);
+  for(i = 0; i < nworkers; i++)
+    if(pthread_create(&tid, &attr, worker, NULL) != 0) {
+      fprintf(stderr, "I cannot create the worker thread %d\n", i);
+      break;
+    }
+  pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+  pthread_attr_destroy(&attr);
+  if(i == 0) {
+    close(done_fd);
+    return -1;
+  }
+  GDEBUG(1, "%d worker threads started\n", i);
+
+  return done_fd;
+}
+
+void workers_submit(struct job *j) {
+  j->next = NULL;
+  pthread_mutex_lock(&queue_mutex);
+  if(queue_first == NULL)
+    queue_first = queue_last = j;
+  else {
+    queue_last->next = j;
+    queue_last = j;
+  }
+  pthread_cond_signal(&queue_cond);
+  pthread_mutex_unlock(&queue_mutex);
+}
+
+struct job *workers_done(void) {
+  struct job *list;
+  u_int64_t n;
+  /* I reset the counter before taking the list: a job added later 
+   * wakes up the main loop again */
+  if(read(done_fd, &n, sizeof(n)) == -1 && errno != EAGAIN)
+    fprintf(stderr, "I cannot read the workers fd: %s\n", strerror(errno));
+  pthread_mutex_lock(&done_mutex);
+  list = done_first;
+  done_first = done_last = NULL;
+  pthread_mutex_unlock(&done_mutex);
+  return list;
+}
@@ -0,0 +1,55 @@
+/*   
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   workers.h: pool of threads executing the requests of the clients
+ *   
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef __WORKERS_HEADER__
+#define __WORKERS_HEADER__
+#include <sys/uio.h>
+#include "pollfd_info.h"
+
+struct job {
+  struct client *client;
+  enum arch arch;
+  /* The request as read from the client, with the frame header if 
+   * 'framed' is set */
+  void *data;
+  int framed;
+  /* The answer gets a lease (see leases.h) */
+  int cached;
+  /* The answer, NULL if the request is not valid */
+  struct iovec *resp;
+  /* The data of the answer, if spliced (see zerocopy.h) */
+  struct zc_pipe *pipe;
+  /* A write whose last 'payload' bytes are still in 'sockfd' */
+  int payload;
+  int sockfd;
+  struct job *next;
+};
+
+/* Start 'nworkers' threads. Returns the fd which is readable when there
+ * are executed jobs, -1 on error */
+int workers_init(int nworkers);
+/* Give a request to the workers. The requests of a client can run at the
+ * same time, the main loop submits a change of directory alone */
+void workers_submit(struct job *j);
+/* The list of the jobs executed, in order of completion */
+struct job *workers_done(void);
+
+#endif /* __WORKERS_HEADER__ */
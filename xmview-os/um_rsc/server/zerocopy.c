@@ -0,0 +1,365 @@
+/*
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   zerocopy.c: file data moved between the files and the clients
+ *               without copying it into the server
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include "gdebug.h"
+
+#include "rsc_server.h"
+#include "zerocopy.h"
+
+/* The biggest read spliced is a page less */
+#define ZC_PIPE_SIZE (1024 * 1024)
+/* The idle pipes kept for the next requests */
+#define ZC_POOL_MAX 16
+/* A client stopping in the middle of a payload is disconnected (ms) */
+#define ZC_TIMEOUT 30000
+/* The arguments of write and pwrite64 are read before the payload,
+ * so the first bytes of the payload of a write are in memory */
+#define WRITE_PREFIX sizeof(struct pwrite64_req)
+
+static enum arch my_arch;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct zc_pipe *pool;
+static int npool;
+
+void zc_init(enum arch server_arch) {
+  my_arch = server_arch;
+}
+
+static inline void *job_request(struct job *j) {
+  return j->data + (j->framed ? sizeof(struct rsc_frame_header) : 0);
+}
+
+/*************************/
+/* Pipes                 */
+/*************************/
+static struct zc_pipe *pipe_get(void) {
+  struct zc_pipe *p;
+  pthread_mutex_lock(&pool_mutex);
+  if((p = pool) != NULL) {
+    pool = p->next;
+    npool--;
+  }
+  pthread_mutex_unlock(&pool_mutex);
+  if(p == NULL) {
+    if((p = calloc(1, sizeof(struct zc_pipe))) == NULL)
+      return NULL;
+    if(pipe2(p->fd, O_CLOEXEC) == -1) {
+      free(p);
+      return NULL;
+    }
+    /* Without the permission for a bigger pipe I keep the default size */
+    if((p->size = fcntl(p->fd[1], F_SETPIPE_SZ, ZC_PIPE_SIZE)) == -1)
+      p->size = fcntl(p->fd[1], F_GETPIPE_SZ);
+  }
+  p->len = p->pad = 0;
+  p->next = NULL;
+  return p;
+}
+
+int zc_pipe_send(struct zc_pipe *p, int fd, int len, int more) {
+  return splice(p->fd[0], NULL, fd, NULL, len, 
+      SPLICE_F_MOVE | SPLICE_F_NONBLOCK | (more ? SPLICE_F_MORE : 0));
+}
+
+void zc_pipe_put(struct zc_pipe *p) {
+  pthread_mutex_lock(&pool_mutex);
+  if(npool < ZC_POOL_MAX) {
+    p->next = pool;
+    pool = p;
+    npool++;
+    p = NULL;
+  }
+  pthread_mutex_unlock(&pool_mutex);
+  if(p != NULL)
+    zc_pipe_free(p);
+}
+
+void zc_pipe_free(struct zc_pipe *p) {
+  close(p->fd[0]);
+  close(p->fd[1]);
+  free(p);
+}
+
+/* The answer to a spliced request: only the header, the rest of the
+ * 'size' bytes comes from the pipe */
+static struct iovec *zc_resp(struct sys_req_header *req_hd, int size, int retval) {
+  struct sys_resp_header *resp;
+  struct iovec *v;
+  v = calloc(1, sizeof(struct iovec));
+  resp = calloc(1, sizeof(struct sys_resp_header));
+  if(v == NULL || resp == NULL) {
+    free(v); free(resp);
+    return NULL;
+  }
+  resp->resp_type = RSC_SYS_RESP;
+  /* The constant is still in network byte order */
+  resp->resp_rsc_const = req_hd->req_rsc_const;
+  resp->resp_size = htonl(size);
+  resp->resp_retval = htonl(retval);
+  v[0].iov_base = resp;
+  v[0].iov_len = sizeof(struct sys_resp_header);
+  return v;
+}
+
+/*************************/
+/* Reads                 */
+/*************************/
+int zc_read(struct job *j) {
+  struct sys_req_header *req_hd = job_request(j);
+  struct stat64 st;
+  struct zc_pipe *p;
+  loff_t offset, *offp = NULL;
+  void *buf;
+  size_t count;
+  int fd, n, tot, size;
+
+  if(j->arch != my_arch || req_hd->req_type != RSC_SYS_REQ)
+    return 0;
+  /* The request is still in network byte order */
+  switch(ntohs(req_hd->req_rsc_const)) {
+    case __RSC_read: {
+      struct read_req *req = (struct read_req *)req_hd;
+      if(ntohl(req->req_size) != sizeof(struct read_req))
+        return 0;
+      fd = req->fd; buf = req->buf; count = req->count;
+      break;
+    }
+    case __RSC_pread64: {
+      struct pread64_req *req = (struct pread64_req *)req_hd;
+      if(ntohl(req->req_size) != sizeof(struct pread64_req))
+        return 0;
+      fd = req->fd; buf = req->buf; count = req->count;
+      offset = req->offset;
+      offp = &offset;
+      break;
+    }
+    default:
+      return 0;
+  }
+  /* 'count' bytes starting in the middle of a page must fit in the pipe */
+  if(buf == NULL || count < ZC_MIN || count > ZC_PIPE_SIZE - getpagesize())
+    return 0;
+  /* The other files can give less bytes than asked, or block */
+  if(fstat64(fd, &st) == -1 || !S_ISREG(st.st_mode))
+    return 0;
+  if((p = pipe_get()) == NULL)
+    return 0;
+  if(p->size < count + getpagesize()) {
+    zc_pipe_put(p);
+    return 0;
+  }
+  for(tot = 0; tot < count; tot += n)
+    if((n = splice(fd, offp, p->fd[1], NULL, count - tot, SPLICE_F_MOVE)) <= 0)
+      break;
+  if(tot == 0 && n == -1) {
+    /* The file system doesn't support splice, or the read fails:
+     * nothing has been read and the request is executed as usual */
+    zc_pipe_put(p);
+    return 0;
+  }
+
+  p->len = tot;
+  size = sizeof(struct sys_resp_header) + tot;
+  /* The response to pread64 has always 'count' bytes */
+  if(offp != NULL) {
+    p->pad = count - tot;
+    size += p->pad;
+  }
+  if((j->resp = zc_resp(req_hd, size, tot)) == NULL)
+    zc_pipe_free(p);
+  else
+    j->pipe = p;
+  GDEBUG(2, "fd %d: %d bytes spliced\n", fd, tot);
+  return 1;
+}
+
+/*************************/
+/* Writes                */
+/*************************/
+int zc_write_prefix(enum arch client_arch, struct req_header *req_hd) {
+  if(client_arch != my_arch || req_hd->req_type != RSC_SYS_REQ ||
+      ntohl(req_hd->req_size) < sizeof(struct write_req) + ZC_MIN)
+    return 0;
+  return WRITE_PREFIX;
+}
+
+int zc_write_payload(void *request) {
+  struct sys_req_header *req_hd = request;
+  void *buf;
+  size_t count;
+  int size;
+
+  switch(ntohs(req_hd->req_rsc_const)) {
+    case __RSC_write:
+      size = sizeof(struct write_req);
+      buf = ((struct write_req *)request)->buf;
+      count = ((struct write_req *)request)->count;
+      break;
+    case __RSC_pwrite64:
+      size = sizeof(struct pwrite64_req);
+      buf = ((struct pwrite64_req *)request)->buf;
+      count = ((struct pwrite64_req *)request)->count;
+      break;
+    default:
+      return 0;
+  }
+  if(buf == NULL || count != ntohl(req_hd->req_size) - size)
+    return 0;
+  return ntohl(req_hd->req_size) - WRITE_PREFIX;
+}
+
+/* Waits for the data of the client */
+static int sock_wait(int fd) {
+  struct pollfd pfd;
+  int ret;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while((ret = poll(&pfd, 1, ZC_TIMEOUT)) == -1 && errno == EINTR)
+    ;
+  return ret == 1 ? 0 : -1;
+}
+
+/* Reads 'len' bytes from 'fd' into 'buf', or throws them away if 'buf'
+ * is NULL */
+static int read_all(int fd, char *buf, int len) {
+  char tmp[4096];
+  int n;
+  while(len > 0) {
+    if(buf != NULL)
+      n = read(fd, buf, len);
+    else
+      n = read(fd, tmp, len > sizeof(tmp) ? sizeof(tmp) : len);
+    if(n == -1 && (errno == EINTR || (errno == EAGAIN && sock_wait(fd) == 0)))
+      continue;
+    if(n <= 0)
+      return -1;
+    len -= n;
+    if(buf != NULL)
+      buf += n;
+  }
+  return 0;
+}
+
+void zc_write(struct job *j) {
+  struct sys_req_header *req_hd = job_request(j);
+  struct zc_pipe *p;
+  loff_t offset, *offp = NULL;
+  char *payload, *data;
+  size_t count;
+  int fd, head, taken, inpipe, written, n;
+
+  if(ntohs(req_hd->req_rsc_const) == __RSC_pwrite64) {
+    struct pwrite64_req *req = (struct pwrite64_req *)req_hd;
+    fd = req->fd; count = req->count;
+    offset = req->offset;
+    offp = &offset;
+    payload = (char *)(req + 1);
+  } else {
+    struct write_req *req = (struct write_req *)req_hd;
+    fd = req->fd; count = req->count;
+    payload = (char *)(req + 1);
+  }
+  head = (char *)req_hd + WRITE_PREFIX - payload;
+  /* The payload taken from the request and from the socket, the part
+   * of it in the pipe and the part written into the file */
+  taken = inpipe = head;
+  written = 0;
+  if((p = pipe_get()) != NULL && head > 0 && write(p->fd[1], payload, head) != head) {
+    zc_pipe_free(p);
+    p = NULL;
+  }
+  if(p == NULL)
+    goto copy;
+
+  while(written < count) {
+    if(taken < count) {
+      n = splice(j->sockfd, NULL, p->fd[1], NULL, count - taken, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if(n > 0) {
+        taken += n;
+        inpipe += n;
+      } else if(n == 0 || (errno != EAGAIN && errno != EINTR))
+        goto broken;
+      else if(inpipe == 0) {
+        if(errno == EAGAIN && sock_wait(j->sockfd) == -1)
+          goto broken;
+        continue;
+      }
+    }
+    while(inpipe > 0) {
+      n = splice(p->fd[0], NULL, fd, offp, inpipe, SPLICE_F_MOVE);
+      if(n == -1 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        break;
+      inpipe -= n;
+      written += n;
+    }
+    if(inpipe > 0) {
+      /* Nothing written: the file doesn't support splice, or the write
+       * fails. The error is given by the usual execution */
+      if(written == 0)
+        goto copy;
+      break;
+    }
+  }
+  /* After a short write the rest of the payload is thrown away */
+  if(read_all(p->fd[0], NULL, inpipe) == -1 ||
+      read_all(j->sockfd, NULL, count - taken) == -1)
+    goto broken;
+  zc_pipe_put(p);
+  j->resp = zc_resp(req_hd, sizeof(struct sys_resp_header), written);
+  GDEBUG(2, "fd %d: %d bytes spliced\n", fd, written);
+  close(j->sockfd);
+  return;
+
+copy:
+  /* The whole request in memory, as without splice */
+  n = payload - (char *)j->data;
+  if((data = realloc(j->data, n + count)) == NULL)
+    goto broken;
+  j->data = data;
+  payload = data + n;
+  if((p != NULL && read_all(p->fd[0], payload, inpipe) == -1) ||
+      read_all(j->sockfd, payload + taken, count - taken) == -1)
+    goto broken;
+  if(p != NULL)
+    zc_pipe_put(p);
+  close(j->sockfd);
+  j->resp = rscs_manage_request(j->arch, job_request(j));
+  return;
+
+broken:
+  if(p != NULL)
+    zc_pipe_free(p);
+  close(j->sockfd);
+}
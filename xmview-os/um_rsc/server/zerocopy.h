@@ -0,0 +1,71 @@
+/*
+ *   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   zerocopy.h: file data moved between the files and the clients
+ *               without copying it into the server
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef __ZEROCOPY_HEADER__
+#define __ZEROCOPY_HEADER__
+#include "aconv.h"
+#include "workers.h"
+
+/* The read, pread64, write and pwrite64 of at least ZC_MIN bytes of a
+ * client with the architecture of the server are spliced: the data read
+ * from a regular file goes into a pipe, and from the pipe into the socket
+ * of the client when the main loop sends the response; the payload of a
+ * write goes from the socket into a pipe, and from the pipe into the file.
+ * When the file doesn't support splice the request is executed as usual. */
+#define ZC_MIN (16 * 1024)
+
+struct zc_pipe {
+  int fd[2];
+  /* The capacity of the pipe */
+  int size;
+  /* The bytes of the response in the pipe, and the zeros following them */
+  int len;
+  int pad;
+  struct zc_pipe *next;
+};
+
+void zc_init(enum arch server_arch);
+
+/* The bytes of the request 'req_hd' (still in network byte order) to read
+ * before the payload, 0 if the request has to be read whole */
+int zc_write_prefix(enum arch client_arch, struct req_header *req_hd);
+/* The request, read up to the prefix, is a write: returns the bytes of
+ * its payload still in the socket, 0 if the rest has to be read as usual */
+int zc_write_payload(void *request);
+
+/* If the request of 'j' is a read to splice, executes it and returns 1:
+ * the answer is in 'j->resp' and the data in 'j->pipe'. Returns 0 if the
+ * request has to be executed by rscs_manage_request() */
+int zc_read(struct job *j);
+/* Executes the write of 'j', whose last 'j->payload' bytes are read from
+ * 'j->sockfd'. 'j->resp' is NULL if the connection cannot be used anymore */
+void zc_write(struct job *j);
+
+/* Sends up to 'len' bytes of 'p' into the socket 'fd', without blocking;
+ * 'more' if other data follows. Returns the bytes sent, -1 on error */
+int zc_pipe_send(struct zc_pipe *p, int fd, int len, int more);
+/* A pipe sent to the client can be used again */
+void zc_pipe_put(struct zc_pipe *p);
+/* A pipe which can have some data in it */
+void zc_pipe_free(struct zc_pipe *p);
+
+#endif /* __ZEROCOPY_HEADER__ */
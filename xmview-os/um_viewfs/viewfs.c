@@ -34,14 +34,22 @@
 #include <config.h>
 #include <assert.h>
 #include <sys/select.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <errno.h>
 #include "viewfs0args.h"
 #include "module.h"
 #include "libummod.h"
+#include "umdirsnap.h"
+#include "viewfs_index.h"
 #include "viewfs0args.h"
 
 #include "gdebug.h"
-#define INFOEXT "\377"
-#define MAXSIZE ((1ULL<<((sizeof(size_t)*8)-1))-1)
+#define COPYALL ((off_t) -1)
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
 #define MERGEROFS
 #define FILEINFO
 
@@ -69,37 +77,26 @@ struct viewfs {
 	int pathlen;
 	int sourcelen;
 	int flags;
+	struct vindex *index; /* overlay metadata, NULL=use the hidden files */
+	struct viewfs *next;  /* list of the mounts */
 };
 
-#define WORDLEN sizeof(int *)
-#define WORDALIGN(X) (((X) + WORDLEN) & ~(WORDLEN-1))
-#define SIZEDIRENT64NONAME (sizeof(__u64)+sizeof(__s64)+sizeof(unsigned short)+sizeof(unsigned char))
-
-struct viewfs_dirent64 {
-	__u64             d_ino;
-	__s64             d_off;
-	unsigned short  d_reclen;
-	unsigned char   d_type;
-	char            *d_name;
-};
-
-struct umdirent {
-	struct viewfs_dirent64 de;
-	struct umdirent *next;
-};
+/* the mounts of a source share its index */
+static struct viewfs *viewfs_head;
 
 struct viewfsdir {
 	struct viewfs *vfs;
 	int fd;
 	char *path;
 	char *vfspath;
-	struct umdirent *dirinfo; /* conversion fuse-getdir into kernel compliant
-															 dirent. Dir head pointer */
-	struct umdirent *dirpos;    /* same conversion above: current pos entry */
+	struct umdirsnap *dirsnap; /* merged directory entries */
+	long long pos;             /* index in dirsnap */
 	struct viewfsdir *next;
 };
 
 struct viewfsdir *viewfs_opendirs=NULL;
+/* last merged directory read, reused if the three layers are unchanged */
+static struct umdirsnap *viewfs_dircache;
 
 #define MNTTABSTEP 4 /* must be a power of two */
 #define MNTTABSTEP_1 (MNTTABSTEP-1)
@@ -157,37 +154,154 @@ static void destroy_path(struct viewfs *vfs,char *path,int wipe)
 }
 
 /* copy a file oldpath->newpath */
-static int copyfile (char *oldpath, char *newpath, size_t truncate)
-{
-	struct stat oldstat;
-	int fdin=open(oldpath,O_RDONLY);
-	int fdout=-1;
-	char buf[4096];
+#define COPYCHUNK (16*1024*1024)
+#define COPYBUFSIZE (256*1024)
+enum copymode {COPY_RANGE, COPY_SENDFILE, COPY_READWRITE};
 
-	if (stat(oldpath,&oldstat)==0) {
-		if (S_ISDIR(oldstat.st_mode)) {
-			close(fdin);
-			errno=EXDEV;
+static int writeall(int fd, char *buf, size_t len, off_t off)
+{
+	while (len > 0) {
+		ssize_t n=pwrite(fd,buf,len,off);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
 			return -1;
 		}
-		fdout=open(newpath,O_WRONLY|O_CREAT|O_TRUNC,(oldstat.st_mode & 0777) | 0600);
+		buf+=n;
+		len-=n;
+		off+=n;
 	}
-	//printk("copyfile %s %s %d\n",oldpath,newpath,truncate);
-  if (fdin >= 0 && fdout >= 0) {
-		size_t nread,readsize=4096;
-		if (truncate < readsize) readsize=truncate;
-		while ((nread=read(fdin,buf,4096))>0) {
-			write(fdout,buf,nread);
-			truncate -= nread;
-			if (truncate < readsize) readsize=truncate;
+	return 0;
+}
+
+/* copy [off,end) of fdin at the same offset of fdout. copy_file_range
+	 copies in the kernel (or shares the extents), sendfile is the fallback
+	 between different file systems, read/write the last resort */
+static int copyrange(int fdin, int fdout, off_t off, off_t end, int *mode)
+{
+	char *buf=NULL;
+	while (off < end) {
+		size_t len=(end - off > COPYCHUNK) ? COPYCHUNK : end - off;
+		ssize_t n;
+#ifdef __NR_copy_file_range
+		if (*mode == COPY_RANGE) {
+			loff_t inoff=off, outoff=off;
+			n=syscall(__NR_copy_file_range,fdin,&inoff,fdout,&outoff,len,0);
+			if (n < 0 && (errno == EXDEV || errno == ENOSYS ||
+						errno == EINVAL || errno == EOPNOTSUPP)) {
+				*mode=COPY_SENDFILE;
+				continue;
+			}
+		} else
+#endif
+		if (*mode == COPY_SENDFILE) {
+			off_t inoff=off;
+			if (lseek(fdout,off,SEEK_SET) < 0)
+				n=-1;
+			else {
+				n=sendfile(fdout,fdin,&inoff,len);
+				if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+					*mode=COPY_READWRITE;
+					continue;
+				}
+			}
+		} else {
+			if (buf == NULL && (buf=malloc(COPYBUFSIZE)) == NULL)
+				return -1;
+			if (len > COPYBUFSIZE)
+				len=COPYBUFSIZE;
+			n=pread(fdin,buf,len,off);
+			if (n > 0 && writeall(fdout,buf,n,off) < 0)
+				n=-1;
+		}
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			free(buf);
+			return -1;
 		}
+		if (n == 0) /* the file has been truncated meanwhile */
+			break;
+		off+=n;
+	}
+	free(buf);
+	return 0;
+}
+
+/* copy the data segments of the first size bytes: holes are not copied */
+static int copydata(int fdin, int fdout, off_t size)
+{
+	off_t off=0;
+	int mode=COPY_RANGE;
+#ifndef __NR_copy_file_range
+	mode=COPY_SENDFILE;
+#endif
+	while (off < size) {
+		off_t data=off;
+		off_t hole=size;
+#ifdef SEEK_DATA
+		if ((data=lseek(fdin,off,SEEK_DATA)) < 0) {
+			if (errno == ENXIO) /* a hole up to EOF */
+				break;
+			data=off;
+		} else if ((hole=lseek(fdin,data,SEEK_HOLE)) < 0 || hole > size)
+			hole=size;
+#endif
+		if (data >= size)
+			break;
+		if (copyrange(fdin,fdout,data,hole,&mode) < 0)
+			return -1;
+		off=hole;
 	}
-	close (fdin);
-	close (fdout);
-	errno=0;
 	return 0;
 }
 
+/* copy-up for cow. length is the size of the copy (truncate), COPYALL
+	 copies the whole file. When source and copy are on the same file system
+	 FICLONE shares the extents (btrfs, xfs reflinks), there is nothing to
+	 read when length is 0 (O_TRUNC). An incomplete copy is removed. */
+static int copyfile (char *oldpath, char *newpath, off_t length)
+{
+	struct stat oldstat;
+	int fdin,fdout;
+	int rv=0;
+	off_t size;
+
+	if (stat(oldpath,&oldstat) < 0)
+		return -1;
+	if (S_ISDIR(oldstat.st_mode)) {
+		errno=EXDEV;
+		return -1;
+	}
+	if (length < 0)
+		length=oldstat.st_size;
+	size=(length < oldstat.st_size)?length:oldstat.st_size;
+	//printk("copyfile %s %s %lld\n",oldpath,newpath,(long long)length);
+	if ((fdout=open(newpath,O_WRONLY|O_CREAT|O_TRUNC,(oldstat.st_mode & 0777) | 0600)) < 0)
+		return -1;
+	if (size > 0) {
+		if ((fdin=open(oldpath,O_RDONLY)) < 0)
+			rv=-1;
+		else {
+			if (size < oldstat.st_size || ioctl(fdout,FICLONE,fdin) < 0)
+				rv=copydata(fdin,fdout,size);
+			close(fdin);
+		}
+	}
+	/* trailing hole, or a truncate beyond EOF */
+	if (rv == 0 && ftruncate(fdout,length) < 0)
+		rv=-1;
+	if (close(fdout) < 0)
+		rv=-1;
+	if (rv < 0) {
+		int saved_errno=errno;
+		unlink(newpath);
+		errno=saved_errno;
+	} else
+		errno=0;
+	return rv;
+}
+
 /* path->newpath conversion */
 static char *unwrap(struct viewfs *vfs,char *path)
 {
@@ -208,10 +322,14 @@ static inline char *wipeunwrap(struct viewfs *vfs,char *path,char *ext)
 static inline int isdeleted (struct viewfs *vfs,char *path)
 {
 	if (vfs->flags & VIEWFS_MERGE) {
-		char *wipefile=wipeunwrap(vfs,path,"");
+		char *wipefile;
 		struct stat64 buf;
 		int erno=errno;
-		int rv=lstat64(wipefile,&buf);
+		int rv;
+		if (vfs->index)
+			return vindex_isdeleted(vfs->index,path+vfs->pathlen);
+		wipefile=wipeunwrap(vfs,path,"");
+		rv=lstat64(wipefile,&buf);
 		rv=(rv==0 && S_ISREG(buf.st_mode));
 		//printk("isdeleted %s %s %lo %d\n",path,wipefile,buf.st_mode,rv);
 		free(wipefile);
@@ -230,6 +348,8 @@ static inline void wipeunlink (struct viewfs *vfs,char *path)
 		char *wipefile=wipeunwrap(vfs,path,"");
 		if (unlink(wipefile) >= 0)
 			destroy_path(vfs,wipefile,1);
+		if (vfs->index)
+			vindex_setdeleted(vfs->index,path+vfs->pathlen,0);
 		free(wipefile);
 	}
 	errno=erno;
@@ -249,6 +369,12 @@ static inline int wipeoutfile (struct viewfs *vfs,char *path)
 		/* DELETE OTHER info */
 		unlink(infofile);
 		rv=mknod(wipefile,S_IFREG|0666,0);
+		if (vfs->index) {
+			if (rv == 0)
+				vindex_setdeleted(vfs->index,path+vfs->pathlen,1);
+			else
+				vindex_setinfo(vfs->index,path+vfs->pathlen,NULL,0);
+		}
 		free(realfile);
 		free(wipefile);
 		free(infofile);
@@ -265,6 +391,8 @@ static inline void deleteinfo (struct viewfs *vfs,char *path)
 		char *infofile=wipeunwrap(vfs,path,INFOEXT);
 		if(unlink(infofile)>=0)
 			destroy_path(vfs,infofile,1);
+		if (vfs->index)
+			vindex_setinfo(vfs->index,path+vfs->pathlen,NULL,0);
 		free(infofile);
 	}
 	errno=saveerrno;
@@ -284,20 +412,34 @@ static inline dev_t new_decode_dev(unsigned int dev)
 	return makedev(major, minor);
 }
 
-static void gethexstat(struct viewfs *vfs,char *path,struct stat64 *st)
-{ 
-	char *infofile;
-	char hexstat[60];
+static int readhexstat(struct viewfs *vfs,char *path,char *hexstat)
+{
+	char *infofile=wipeunwrap(vfs,path,INFOEXT);
 	int len;
-	
 #ifdef FILEINFO
 	int fd;
-  infofile=wipeunwrap(vfs,path,INFOEXT);
-	if ((fd=open(infofile,O_RDONLY))>=0 && (len=read(fd,hexstat,60)) >= 24) {
+	if ((fd=open(infofile,O_RDONLY))>=0) {
+		len=read(fd,hexstat,60);
+		close(fd);
+	} else
+		len=-1;
 #else
-	infofile=wipeunwrap(vfs,path,INFOEXT);
-	if ((len=readlink(infofile,hexstat,60)) >= 24) {
+	len=readlink(infofile,hexstat,60);
 #endif
+	free(infofile);
+	return len;
+}
+
+static void gethexstat(struct viewfs *vfs,char *path,struct stat64 *st)
+{ 
+	char hexstat[60];
+	int len;
+	
+	if (vfs->index)
+		len=vindex_getinfo(vfs->index,path+vfs->pathlen,hexstat);
+	else
+		len=readhexstat(vfs,path,hexstat);
+	if (len >= 24) {
 		if (*hexstat != ' ') {
 			mode_t mode;
 			sscanf(hexstat,"%08x",&mode);
@@ -315,11 +457,7 @@ static void gethexstat(struct viewfs *vfs,char *path,struct stat64 *st)
 			sscanf(hexstat+24,"%08x",&kdev);
 			st->st_rdev=new_decode_dev(kdev);
 		}
-#ifdef FILEINFO
-		close(fd);
-#endif
 	}
-	free(infofile);
 }
 
 static void hexencode32(char *s,unsigned int v)
@@ -374,12 +512,14 @@ static void puthexstat(struct viewfs *vfs,char *path,
 		len=32;
 	}
 #ifdef FILEINFO
-	pwrite(fd,hexstat,len,0);
+	if (pwrite(fd,hexstat,len,0) == len && vfs->index)
+		vindex_setinfo(vfs->index,path+vfs->pathlen,hexstat,len);
 	close(fd);
 #else
 	create_path(vfs,infofile);
 	//printk("%x %d %d %d=%s=\n",mode,uid,gid,rdev,hexstat);
-	symlink(hexstat,infofile);
+	if (symlink(hexstat,infofile) == 0 && vfs->index)
+		vindex_setinfo(vfs->index,path+vfs->pathlen,hexstat,(len < 24)?24:len);
 #endif
 	free(infofile);
 }
@@ -474,6 +614,10 @@ static void copy_vvlinkrename(struct viewfs *vfs, int (*linkrename)(),
 	char *oldinfo=wipeunwrap(vfs,oldvpath,INFOEXT);
 	char *newinfo=wipeunwrap(vfs,newvpath,INFOEXT);
 	linkrename(oldinfo,newinfo);
+	if (vfs->index) {
+		vindex_reloadinfo(vfs->index,oldvpath+vfs->pathlen);
+		vindex_reloadinfo(vfs->index,newvpath+vfs->pathlen);
+	}
 	free(oldinfo);
 	free(newinfo);
 }
@@ -696,7 +840,7 @@ static long viewfs_open(char *path, int flags, mode_t mode)
 		/* is not in cow but it exists, copy it! */
 		if (!file_exist(vfspath)) {
 			if (file_exist(path) && !isdeleted(vfs,path)) {
-				rv=copyfile(path,vfspath,(flags & O_TRUNC)?0:MAXSIZE);
+				rv=copyfile(path,vfspath,(flags & O_TRUNC)?0:COPYALL);
 				if (rv >= 0 && (vfs->flags & VIEWFS_VSTAT))
 					copy_vstat(vfs,path,vfspath);
 			} else if (flags & O_CREAT)
@@ -714,7 +858,8 @@ static long viewfs_open(char *path, int flags, mode_t mode)
 			vfsdir->fd=rv;
 			vfsdir->path=strdup(path);
 			vfsdir->vfspath=strdup(vfspath);
-			vfsdir->dirinfo=vfsdir->dirpos=0;
+			vfsdir->dirsnap=NULL;
+			vfsdir->pos=0;
 			vfsdir->next=viewfs_opendirs;
 			viewfs_opendirs=vfsdir;
 			FD_SET(rv,&viewfs_dirset);
@@ -733,7 +878,10 @@ static long viewfs_truncate64(char *path, loff_t length)
 	char *vfspath=unwrap(vfs,path);
 	if (vfs->flags & VIEWFS_DEBUG)
 		printk("VIEWFS_TRUNCATE %s->%s %d\n",path,vfspath,length);
-	if (vfs->flags & VIEWFS_MERGE) {
+	if (length < 0) {
+		rv=-1;
+		errno=EINVAL;
+	} else if (vfs->flags & VIEWFS_MERGE) {
 		if ((rv=cownoenterror(vfs,path,vfspath))==0) { /* ENOENT */
 			if (vfs->flags & VIEWFS_COW) {
 				if (file_exist(vfspath)) /* virt file */
@@ -796,7 +944,7 @@ static long viewfs_link(char *oldpath, char *newpath)
 						rv=link(thisoldpath,vfsnewpath);
 						//printk("link %s-%s -> %d\n",thisoldpath,vfsnewpath,rv);
 						if (rv<0) {
-							rv=copyfile(thisoldpath,vfsnewpath,MAXSIZE);
+							rv=copyfile(thisoldpath,vfsnewpath,COPYALL);
 							if (rv>=0) {
 								wipeunlink(vfs,newpath);
 								if (vfs->flags & VIEWFS_VSTAT)
@@ -812,7 +960,7 @@ static long viewfs_link(char *oldpath, char *newpath)
 					rv=link(thisoldpath,vfsnewpath);
 					//printk("link %s-%s -> %d\n",thisoldpath,vfsnewpath,rv);
 					if (rv<0) {
-						rv=copyfile(thisoldpath,vfsnewpath,MAXSIZE);
+						rv=copyfile(thisoldpath,vfsnewpath,COPYALL);
 						if (rv>=0) {
 							wipeunlink(vfs,newpath);
 							if (vfs->flags & VIEWFS_VSTAT)
@@ -864,7 +1012,7 @@ static long viewfs_rename(char *oldpath, char *newpath)
 					create_vpath(vfs,newpath,vfsnewpath);
 					rv=rename(thisoldpath,vfsnewpath);
 					if (rv<0) {
-						rv=copyfile(thisoldpath,vfsnewpath,MAXSIZE);
+						rv=copyfile(thisoldpath,vfsnewpath,COPYALL);
 						if (rv>=0) {
 							wipeunlink(vfs,newpath);
 							if (vfs->flags & VIEWFS_VSTAT)
@@ -887,7 +1035,7 @@ static long viewfs_rename(char *oldpath, char *newpath)
 				create_vpath(vfs,newpath,vfsnewpath);
 				rv=rename(thisoldpath,vfsnewpath);
 				if (rv<0) {
-					rv=copyfile(thisoldpath,vfsnewpath,MAXSIZE);
+					rv=copyfile(thisoldpath,vfsnewpath,COPYALL);
 					if (rv>=0) {
 						wipeunlink(vfs,newpath);
 						if (vfs->flags & VIEWFS_VSTAT)
@@ -921,16 +1069,16 @@ static long viewfs_rename(char *oldpath, char *newpath)
 	return rv;
 }
 
-static void umcleandirinfo(struct umdirent *tail);
 static struct viewfsdir *viewfs_del_dirfd(struct viewfsdir *vfsdir,int fd)
 {
 	if (vfsdir != NULL) {
 		if (vfsdir->fd == fd) {
+			struct viewfsdir *next=vfsdir->next;
 			free(vfsdir->path);
 			free(vfsdir->vfspath);
-			umcleandirinfo(vfsdir->dirinfo);
+			umdirsnap_put(vfsdir->dirsnap);
 			free(vfsdir);
-			return vfsdir->next;
+			return next;
 		} else {
 			vfsdir->next=viewfs_del_dirfd(vfsdir->next,fd);
 			return vfsdir;
@@ -1248,6 +1396,11 @@ static void zapwipedir(struct viewfs *vfs,char *path)
 					//printk("zapwipe %s %s\n",de->d_name,this);
 					unlink(this);
 					free(this);
+					if (vfs->index) {
+						asprintf(&this,"%s/%s",path+vfs->pathlen,de->d_name);
+						vindex_setdeleted(vfs->index,this,0);
+						free(this);
+					}
 				}
 				off+=de->d_reclen;
 			}
@@ -1337,7 +1490,7 @@ static int vchmod(struct viewfs *vfs, char *path,
 	} else {
 		if (copy) {
 			create_vpath(vfs,path,vfspath);
-			copyfile(path,vfspath,MAXSIZE);
+			copyfile(path,vfspath,COPYALL);
 		}
 		return chmod(vfspath,mode);
 	}
@@ -1394,7 +1547,7 @@ static int vchown(struct viewfs *vfs, int (*chownf)(), char *path,
 	} else {
 		if (copy){
 			create_vpath(vfs,path,vfspath);
-			copyfile(path,vfspath,MAXSIZE);
+			copyfile(path,vfspath,COPYALL);
 		}
 		chown(vfspath,owner,group);
 	}
@@ -1461,14 +1614,14 @@ static long viewfs_utimes(char *path, struct timeval *tv)
 						rv=utimes(path,tv);
 						if (rv<0) {
 							create_path(vfs,vfspath);
-							rv=copyfile(path,vfspath,MAXSIZE);
+							rv=copyfile(path,vfspath,COPYALL);
 							if (rv >= 0 && (vfs->flags & VIEWFS_VSTAT))
 								copy_vstat(vfs,path,vfspath);
 							rv=utimes(vfspath,tv);
 						}
 					} else { /* COW  !MIN */
 						create_path(vfs,vfspath);
-						rv=copyfile(path,vfspath,MAXSIZE);
+						rv=copyfile(path,vfspath,COPYALL);
 						if (rv >= 0 && (vfs->flags & VIEWFS_VSTAT))
 							copy_vstat(vfs,path,vfspath);
 						rv=utimes(vfspath,tv);
@@ -1493,11 +1646,6 @@ static long viewfs_utimes(char *path, struct timeval *tv)
 
 }
 
-static long viewfs_lseek(int fildes, int offset, int whence)
-{
-	return (int) lseek64(fildes, (off_t) offset, whence);
-}
-
 static long viewfs_msocket(char *path, int domain, int type, int protocol)
 {
 	struct viewfs *vfs = um_mod_get_private_data();
@@ -1509,66 +1657,24 @@ static long viewfs_msocket(char *path, int domain, int type, int protocol)
 	return rv;
 }
 
-static int merge_newentry(char *name,struct umdirent *tail,struct umdirent *oldtail)
-{
-	if (oldtail) {
-		do {
-			struct umdirent *next=tail->next;
-			if (strcmp(next->de.d_name,name)==0)
-				return 0;
-			tail=next;
-		} while (tail != oldtail);
-	}
-	return 1;
-}
-
-static struct umdirent *umadddirinfo(int fd, struct umdirent *head,
+/* duplicates (and names deleted in the wipeout dir) are dropped by
+ * the hash set of the snapshot */
+static void umadddirinfo(int fd, struct umdirsnap *snap,
 		int wipeout, int rootdir)
 {
-	if (fd) {
-		char buf[4096];
-		int len;
-		struct umdirent *oldtail=head;
-		long long offset;
-		if (head==0)
-			offset=0;
-		else
-			offset=head->de.d_off+WORDALIGN(12+strlen(head->de.d_name));
-		while ((len=getdents64(fd,(struct dirent64 *)buf,4096)) > 0) {
-			off_t off=0;
-			while (off<len) {
-				struct dirent64 *de=(struct dirent64 *)(buf+off);
-				if (!(wipeout && de->d_type != DT_REG) && 
-						merge_newentry(de->d_name,head,oldtail)) 
-				{
-					/* .- must not appear in the dir listing! */
-					if (!rootdir || (strcmp(de->d_name,".-") != 0)) {
-						struct umdirent *new=(struct umdirent *)malloc(sizeof(struct umdirent));
-						new->de.d_name=strdup(de->d_name);
-						new->de.d_type=de->d_type;
-						new->de.d_ino=de->d_ino;
-						if (wipeout) {
-							new->de.d_reclen=0;
-							new->de.d_off=offset;
-						} else {
-							new->de.d_reclen=WORDALIGN(SIZEDIRENT64NONAME+strlen(de->d_name)+1);
-							new->de.d_off=offset=offset+WORDALIGN(12+strlen(de->d_name));
-						}
-						if (head==NULL) {
-							new->next=new;
-						} else {
-							new->next=head->next;
-							head->next=new;
-						}
-						head=new;
-					}
-				}
-				off+=de->d_reclen;
-			}
+	char buf[4096];
+	int len;
+	while ((len=getdents64(fd,(struct dirent64 *)buf,4096)) > 0) {
+		off_t off=0;
+		while (off<len) {
+			struct dirent64 *de=(struct dirent64 *)(buf+off);
+			/* .- must not appear in the dir listing! */
+			if (!(wipeout && de->d_type != DT_REG) &&
+					!(rootdir && strcmp(de->d_name,".-") == 0))
+				umdirsnap_add(snap,de->d_name,de->d_ino,de->d_type,wipeout);
+			off+=de->d_reclen;
 		}
-		return head;
-	} else
-		return NULL;
+	}
 }
 
 static inline int real_pathlen(struct viewfs *vfs)
@@ -1579,91 +1685,135 @@ static inline int real_pathlen(struct viewfs *vfs)
 		return vfs->pathlen;
 }
 
-/* populate the directory buffer. */
-static struct umdirent *umfilldirinfo(int fd,char *mergepath,struct viewfs *vfs)
+static void viewfs_dirstat(char *path, struct stat *st)
 {
+	if (stat(path,st) < 0)
+		memset(st,0,sizeof(struct stat));
+}
+
+/* populate the directory buffer. */
+static struct umdirsnap *umfilldirinfo(int fd,char *mergepath,struct viewfs *vfs)
+{
+	char *wipedir=wipeunwrap(vfs,mergepath,"");
+	struct umdirsnap *snap=NULL;
+	struct stat st[3];
+	int mergefd;
+	/* destination, wipeout and source dir */
+	if (fstat(fd,&st[0]) < 0)
+		memset(&st[0],0,sizeof(struct stat));
+	viewfs_dirstat(wipedir,&st[1]);
+	viewfs_dirstat(mergepath,&st[2]);
+	if (umdirsnap_match(viewfs_dircache,mergepath,st,3)) {
+		free(wipedir);
+		return umdirsnap_get(viewfs_dircache);
+	}
+	if ((snap=umdirsnap_new()) == NULL) {
+		free(wipedir);
+		return NULL;
+	}
 	/* add the entries of the destination dir*/
-	struct umdirent *result=umadddirinfo(fd,NULL,0,*(mergepath+real_pathlen(vfs))==0);
-	if (vfs->flags & VIEWFS_MERGE) {
-		char *wipedir=wipeunwrap(vfs,mergepath,"");
-		int mergefd=open(wipedir,O_RDONLY|O_DIRECTORY);
-		/* add NULL entries of the deleted files */
-		if (mergefd>=0) {
-			result=umadddirinfo(mergefd,result,1,0);
-			close(mergefd);
-		}
-		/* add the entries in the source dir (if there an entry is deleted it is a
-			 dup entry of the NULL entry so it is not inserted) */
-		mergefd=open(mergepath,O_RDONLY|O_DIRECTORY);
-		if (mergefd>=0) {
-			result=umadddirinfo(mergefd,result,0,0);
-			close(mergefd);
-		}
+	lseek(fd,0,SEEK_SET);
+	umadddirinfo(fd,snap,0,*(mergepath+real_pathlen(vfs))==0);
+	/* add hidden entries for the deleted files */
+	mergefd=open(wipedir,O_RDONLY|O_DIRECTORY);
+	if (mergefd>=0) {
+		umadddirinfo(mergefd,snap,1,0);
+		close(mergefd);
+	}
+	/* add the entries in the source dir (if there an entry is deleted it is a
+		 dup entry of the hidden entry so it is not inserted) */
+	mergefd=open(mergepath,O_RDONLY|O_DIRECTORY);
+	if (mergefd>=0) {
+		umadddirinfo(mergefd,snap,0,0);
+		close(mergefd);
 	}
-	return result;
+	free(wipedir);
+	umdirsnap_setkey(snap,mergepath,st,3);
+	umdirsnap_put(viewfs_dircache);
+	viewfs_dircache=umdirsnap_get(snap);
+	return snap;
 }
 
-static void umcleandirinfo(struct umdirent *tail)
+static struct viewfsdir *viewfs_get_dirfd(int fd)
 {
-	if (tail != NULL) {
-		while (tail->next != tail) {
-			struct umdirent *tmp;
-			tmp=tail->next;
-			tail->next=tmp->next;
-			free(tmp->de.d_name);
-			free(tmp);
-		}
-		free(tail);
-	}
+	struct viewfsdir *vfsdir=viewfs_opendirs;
+	while (vfsdir && vfsdir->fd != fd)
+		vfsdir=vfsdir->next;
+	return vfsdir;
 }
 
 static long viewfs_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count)
 {
 	if (FD_ISSET(fd,&viewfs_dirset)) {
-		struct viewfsdir *vfsdir=viewfs_opendirs;
-		while (vfsdir && vfsdir->fd != fd)
-			vfsdir=vfsdir->next;
+		struct viewfsdir *vfsdir=viewfs_get_dirfd(fd);
 		if (vfsdir) {
-			int curoffs=0;
-			if (vfsdir->dirinfo == NULL) 
-				vfsdir->dirinfo = umfilldirinfo(fd,vfsdir->path,vfsdir->vfs);
-			if (vfsdir->dirinfo == NULL)
+			if (vfsdir->dirsnap == NULL) 
+				vfsdir->dirsnap = umfilldirinfo(fd,vfsdir->path,vfsdir->vfs);
+			if (vfsdir->dirsnap == NULL)
 				return 0;
-			else {
-				struct dirent64 *current;
-				char *base=(char *)dirp;
-				int last=0;
-				if (vfsdir->dirpos==NULL)
-					vfsdir->dirpos=vfsdir->dirinfo;
-				else
-					last=(vfsdir->dirpos==vfsdir->dirinfo);
-				while (!last && curoffs + vfsdir->dirpos->next->de.d_reclen < count)
-				{
-					vfsdir->dirpos=vfsdir->dirpos->next;
-					current=(struct dirent64 *)base;
-					if (vfsdir->dirpos->de.d_reclen > 0) {
-						current->d_ino=vfsdir->dirpos->de.d_ino;
-						current->d_off=vfsdir->dirpos->de.d_off;
-						current->d_reclen=vfsdir->dirpos->de.d_reclen;
-						current->d_type=vfsdir->dirpos->de.d_type;
-						strcpy(current->d_name,vfsdir->dirpos->de.d_name);
-						/* workaround: some FS do not set d_ino, but
-						 * inode 0 is special and is skipped by libc */
-						if (current->d_ino == 0)
-							current->d_ino = 2;
-						base+=vfsdir->dirpos->de.d_reclen;
-						curoffs+=vfsdir->dirpos->de.d_reclen;
-					}
-					last=(vfsdir->dirpos == vfsdir->dirinfo);
-				}
-			}
-			return curoffs;
+			else
+				return umdirsnap_getdents64(vfsdir->dirsnap,&vfsdir->pos,dirp,count);
 		} else
 			return -1;
 	} else
 		return getdents64(fd,dirp,count);
 }
 
+/* merged dirs: the offset is the index in the snapshot (telldir/seekdir),
+ * rewinddir reads the directory again */
+static loff_t viewfs_dirlseek(struct viewfsdir *vfsdir, loff_t offset, int whence)
+{
+	switch (whence) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			offset+=vfsdir->pos;
+			break;
+		default:
+			errno=EINVAL;
+			return -1;
+	}
+	if (offset < 0) {
+		errno=EINVAL;
+		return -1;
+	}
+	if (offset == 0 && vfsdir->dirsnap != NULL) {
+		umdirsnap_put(vfsdir->dirsnap);
+		vfsdir->dirsnap=NULL;
+	}
+	vfsdir->pos=offset;
+	return offset;
+}
+
+static long viewfs_lseek(int fildes, int offset, int whence)
+{
+	struct viewfsdir *vfsdir;
+	if (FD_ISSET(fildes,&viewfs_dirset) && (vfsdir=viewfs_get_dirfd(fildes)) != NULL)
+		return (int) viewfs_dirlseek(vfsdir, offset, whence);
+	else
+		return (int) lseek64(fildes, (off_t) offset, whence);
+}
+
+#if __WORDSIZE == 32
+static long viewfs__llseek(unsigned int fd, unsigned long offset_high,  unsigned  long offset_low, loff_t *result, unsigned int whence)
+{
+	struct viewfsdir *vfsdir;
+	if (FD_ISSET(fd,&viewfs_dirset) && (vfsdir=viewfs_get_dirfd(fd)) != NULL) {
+		loff_t offset = (((loff_t) offset_high)<<32)  |  offset_low;
+		loff_t rv;
+		if (result == NULL) {
+			errno = EFAULT;
+			return -1;
+		}
+		if ((rv=viewfs_dirlseek(vfsdir, offset, whence)) < 0)
+			return -1;
+		*result=rv;
+		return 0;
+	} else
+		return _llseek(fd, offset_high, offset_low, result, whence);
+}
+#endif
+
 static void viewfs_cow_init(struct viewfs *new)
 {
 	//struct stat64 wipestat;
@@ -1712,6 +1862,22 @@ static long viewfs_mount(char *source, char *target, char *filesystemtype,
 				new->pathlen = strlen(target);
 			if (flags & VIEWFS_COW)
 				viewfs_cow_init(new);
+			if (flags & VIEWFS_INDEX) {
+				struct viewfs *vfs;
+				new->index=vindex_get(source,(flags & VIEWFS_JOURNAL) != 0);
+				/* the mounts made before update the index from now on */
+				for (vfs=viewfs_head; vfs != NULL && new->index != NULL; vfs=vfs->next) {
+					if (vfs->index == NULL && strcmp(vfs->source,source) == 0)
+						vfs->index=vindex_find(source);
+				}
+			} else {
+				/* share the index of other mounts, so it is kept up to date */
+				new->index=vindex_find(source);
+				if (new->index == NULL && (flags & VIEWFS_COW))
+					vindex_dropjournal(source);
+			}
+			new->next=viewfs_head;
+			viewfs_head=new;
 			ht_tab_pathadd(CHECKPATH,source,target,filesystemtype,mountflags,data,&s,0,viewfs_confirm,new);
 		}
 	}
@@ -1720,8 +1886,16 @@ static long viewfs_mount(char *source, char *target, char *filesystemtype,
 
 static long viewfs_umountinternal(struct viewfs *vfs, int flags)
 {
+	struct viewfs **scan;
 	if (vfs->flags & VIEWFS_DEBUG)
 		printk("VIEWFS_UMOUNT source %s target %s\n",vfs->source,vfs->path);
+	for (scan=&viewfs_head; *scan != NULL; scan=&((*scan)->next)) {
+		if (*scan == vfs) {
+			*scan=vfs->next;
+			break;
+		}
+	}
+	vindex_put(vfs->index);
 	free(vfs->path);
 	free(vfs->source);
 	freeexceptions(vfs->exceptions);
@@ -1780,7 +1954,7 @@ init (void)
 	SERVICESYSCALL(s, access, viewfs_access);
 #if __WORDSIZE == 32 //TODO: verify that ppc64 doesn't have these
 	SERVICESYSCALL(s, fcntl, fcntl64);
-	SERVICESYSCALL(s, _llseek, _llseek);
+	SERVICESYSCALL(s, _llseek, viewfs__llseek);
 #else
 	SERVICESYSCALL(s, fcntl, fcntl);
 #endif
@@ -44,6 +44,8 @@
 #define VIEWFSARGWOK 15 //"wok"
 #define VIEWFSPERMANENT 17 //"permanent"
 #define VIEWFSARGVSTAT 18 //"permanent"
+#define VIEWFSARGINDEX 19 //"index"
+#define VIEWFSARGJOURNAL 20 //"journal"
 #define VIEWFSFLAGHASSTRING 1
 
 static struct viewfsargitem {
@@ -61,7 +63,9 @@ static struct viewfsargitem {
 	{"wok", VIEWFSARGWOK, 0},
 	{"perm", VIEWFSPERMANENT, 0},
 	{"permanent", VIEWFSPERMANENT, 0},
-	{"vstat", VIEWFSARGVSTAT, 0}
+	{"vstat", VIEWFSARGVSTAT, 0},
+	{"index", VIEWFSARGINDEX, 0},
+	{"journal", VIEWFSARGJOURNAL, 0}
 };
 #define VIEWFSARGTABSIZE sizeof(viewfsargtab)/sizeof(struct viewfsargitem)
 
@@ -145,6 +149,12 @@ int viewfsargs(char *data,int *pflags,char ***pexceptions)
 			case VIEWFSARGVSTAT:
 				*pflags |= VIEWFS_VSTAT;
 				break;
+			case VIEWFSARGINDEX:
+				*pflags |= VIEWFS_INDEX;
+				break;
+			case VIEWFSARGJOURNAL:
+				*pflags |= VIEWFS_INDEX | VIEWFS_JOURNAL;
+				break;
 			case 0:
 				printk("viewfs unknown option %s\n",sepopts[i]);
 				break;
@@ -154,6 +164,10 @@ int viewfsargs(char *data,int *pflags,char ***pexceptions)
 		printk ("vstat is for merge or cow file systems: vstat disabled\n");
 		*pflags &= ~VIEWFS_VSTAT;
 	}
+	if ((*pflags & VIEWFS_INDEX) && !(*pflags & VIEWFS_MERGE)) {
+		printk ("index is for merge or cow file systems: index disabled\n");
+		*pflags &= ~(VIEWFS_INDEX | VIEWFS_JOURNAL);
+	}
 	if (typeoption>1) {
 		free(opts);
 		return -EINVAL;
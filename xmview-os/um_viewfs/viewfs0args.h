@@ -32,6 +32,8 @@
 #define VIEWFS_RENEW 0x100 
 #define VIEWFS_WOK   0x200 
 #define VIEWFS_VSTAT 0x400 
+#define VIEWFS_INDEX 0x800
+#define VIEWFS_JOURNAL 0x1000
 
 int viewfsargs(char *opts,int *pflags,char ***pexceptions);
 #endif
@@ -0,0 +1,422 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   viewfs: in memory index of the overlay metadata
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "viewfs_index.h"
+
+#define VINDEX_DELETED 1
+#define VINDEX_INFO 2
+#define VINDEX_INITSIZE 256
+
+/* source/.-/ JOURNALNAME: the index saved at umount */
+#define JOURNALNAME INFOEXT "journal"
+#define JOURNALMAGIC "VIEWFSJ1"
+
+struct vindex_entry {
+	struct vindex_entry *next;
+	unsigned int hash;
+	unsigned char flags;
+	unsigned char infolen;
+	char info[VINDEX_INFOMAX];
+	char path[];
+};
+
+struct vindex {
+	char *source;
+	int count;
+	int journal;
+	unsigned int size;     /* power of two */
+	unsigned int nentries;
+	struct vindex_entry **table;
+	struct vindex *next;
+};
+
+struct journal_rec {
+	uint8_t flags;
+	uint8_t infolen;
+	uint16_t pathlen;
+};
+
+static struct vindex *vindex_head;
+
+static unsigned int vindex_hash(char *path)
+{
+	unsigned int sum = 2166136261U;
+	while (*path)
+		sum = (sum ^ (unsigned char) *path++) * 16777619U;
+	return sum;
+}
+
+static struct vindex_entry **vindex_search(struct vindex *ix, char *path,
+		unsigned int hash)
+{
+	struct vindex_entry **scan = &ix->table[hash & (ix->size - 1)];
+	while (*scan != NULL) {
+		if ((*scan)->hash == hash && strcmp((*scan)->path, path) == 0)
+			break;
+		scan = &((*scan)->next);
+	}
+	return scan;
+}
+
+static void vindex_grow(struct vindex *ix)
+{
+	unsigned int newsize = ix->size << 1;
+	struct vindex_entry **newtable = calloc(newsize, sizeof(struct vindex_entry *));
+	unsigned int i;
+	if (newtable == NULL)
+		return;
+	for (i = 0; i < ix->size; i++) {
+		while (ix->table[i] != NULL) {
+			struct vindex_entry *this = ix->table[i];
+			ix->table[i] = this->next;
+			this->next = newtable[this->hash & (newsize - 1)];
+			newtable[this->hash & (newsize - 1)] = this;
+		}
+	}
+	free(ix->table);
+	ix->table = newtable;
+	ix->size = newsize;
+}
+
+/* entries with no flags are deleted */
+static void vindex_update(struct vindex *ix, char *path,
+		int setflags, int clrflags, char *info, int infolen)
+{
+	unsigned int hash = vindex_hash(path);
+	struct vindex_entry **pentry = vindex_search(ix, path, hash);
+	struct vindex_entry *entry = *pentry;
+	if (entry == NULL) {
+		if (setflags == 0)
+			return;
+		if ((entry = malloc(sizeof(struct vindex_entry) + strlen(path) + 1)) == NULL)
+			return;
+		entry->next = NULL;
+		entry->hash = hash;
+		entry->flags = 0;
+		entry->infolen = 0;
+		strcpy(entry->path, path);
+		*pentry = entry;
+		ix->nentries++;
+	}
+	entry->flags = (entry->flags & ~clrflags) | setflags;
+	if (setflags & VINDEX_INFO) {
+		if (infolen > VINDEX_INFOMAX)
+			infolen = VINDEX_INFOMAX;
+		memcpy(entry->info, info, infolen);
+		entry->infolen = infolen;
+	}
+	if (entry->flags == 0) {
+		*pentry = entry->next;
+		free(entry);
+		ix->nentries--;
+	} else if (ix->nentries > ix->size)
+		vindex_grow(ix);
+}
+
+static int readinfo(char *infofile, char *info)
+{
+	struct stat st;
+	int len = -1;
+	if (lstat(infofile, &st) < 0)
+		return -1;
+	if (S_ISLNK(st.st_mode))
+		len = readlink(infofile, info, VINDEX_INFOMAX);
+	else if (S_ISREG(st.st_mode)) {
+		int fd = open(infofile, O_RDONLY);
+		if (fd >= 0) {
+			len = read(fd, info, VINDEX_INFOMAX);
+			close(fd);
+		}
+	}
+	return len;
+}
+
+/* dirpath is the hidden dir, path the corresponding path in the view */
+static void vindex_scan(struct vindex *ix, char *dirpath, char *path)
+{
+	DIR *dir = opendir(dirpath);
+	struct dirent *de;
+	if (dir == NULL)
+		return;
+	while ((de = readdir(dir)) != NULL) {
+		char *hiddenpath;
+		char *thispath;
+		int namelen = strlen(de->d_name);
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0 ||
+				(*path == 0 && strncmp(de->d_name, JOURNALNAME, strlen(JOURNALNAME)) == 0))
+			continue;
+		asprintf(&hiddenpath, "%s/%s", dirpath, de->d_name);
+		asprintf(&thispath, "%s/%s", path, de->d_name);
+		if (hiddenpath != NULL && thispath != NULL) {
+			if (de->d_type == DT_DIR)
+				vindex_scan(ix, hiddenpath, thispath);
+			else if (namelen > 1 && de->d_name[namelen-1] == INFOEXT[0]) {
+				char info[VINDEX_INFOMAX];
+				int len = readinfo(hiddenpath, info);
+				thispath[strlen(thispath)-1] = 0;
+				if (len > 0)
+					vindex_update(ix, thispath, VINDEX_INFO, 0, info, len);
+			} else if (de->d_type == DT_REG)
+				vindex_update(ix, thispath, VINDEX_DELETED, 0, NULL, 0);
+			else if (de->d_type == DT_UNKNOWN) {
+				struct stat st;
+				if (lstat(hiddenpath, &st) == 0) {
+					if (S_ISDIR(st.st_mode))
+						vindex_scan(ix, hiddenpath, thispath);
+					else if (S_ISREG(st.st_mode))
+						vindex_update(ix, thispath, VINDEX_DELETED, 0, NULL, 0);
+				}
+			}
+		}
+		free(hiddenpath);
+		free(thispath);
+	}
+	closedir(dir);
+}
+
+static char *journalpath(struct vindex *ix)
+{
+	char *path;
+	asprintf(&path, "%s/.-/%s", ix->source, JOURNALNAME);
+	return path;
+}
+
+/* the journal is valid only until the next change of the hidden files:
+	 it is removed once loaded, so a crash or a mount without the journal
+	 option cannot leave a stale one */
+static int vindex_loadjournal(struct vindex *ix)
+{
+	char *path = journalpath(ix);
+	FILE *f;
+	char magic[sizeof(JOURNALMAGIC)-1];
+	uint32_t n;
+	int rv = -1;
+	if (path == NULL)
+		return -1;
+	if ((f = fopen(path, "r")) != NULL) {
+		if (fread(magic, sizeof(magic), 1, f) == 1 &&
+				memcmp(magic, JOURNALMAGIC, sizeof(magic)) == 0 &&
+				fread(&n, sizeof(n), 1, f) == 1) {
+			char buf[PATH_MAX+VINDEX_INFOMAX];
+			struct journal_rec rec;
+			for (; n > 0; n--) {
+				if (fread(&rec, sizeof(rec), 1, f) != 1 ||
+						rec.pathlen >= PATH_MAX || rec.infolen > VINDEX_INFOMAX ||
+						fread(buf, rec.pathlen + rec.infolen, 1, f) != 1)
+					break;
+				buf[rec.pathlen + rec.infolen] = 0;
+				memmove(buf + rec.pathlen + 1, buf + rec.pathlen, rec.infolen);
+				buf[rec.pathlen] = 0;
+				vindex_update(ix, buf, rec.flags & (VINDEX_DELETED|VINDEX_INFO), 0,
+						buf + rec.pathlen + 1, rec.infolen);
+			}
+			if (n == 0 && fgetc(f) == EOF)
+				rv = 0;
+		}
+		fclose(f);
+		unlink(path);
+	}
+	free(path);
+	return rv;
+}
+
+static void vindex_savejournal(struct vindex *ix)
+{
+	char *path = journalpath(ix);
+	char *tmppath;
+	FILE *f;
+	if (path == NULL)
+		return;
+	asprintf(&tmppath, "%s~", path);
+	if (tmppath != NULL && (f = fopen(tmppath, "w")) != NULL) {
+		uint32_t n = ix->nentries;
+		unsigned int i;
+		int err;
+		fwrite(JOURNALMAGIC, sizeof(JOURNALMAGIC)-1, 1, f);
+		fwrite(&n, sizeof(n), 1, f);
+		for (i = 0; i < ix->size; i++) {
+			struct vindex_entry *entry;
+			for (entry = ix->table[i]; entry != NULL; entry = entry->next) {
+				struct journal_rec rec;
+				rec.flags = entry->flags;
+				rec.infolen = (entry->flags & VINDEX_INFO) ? entry->infolen : 0;
+				rec.pathlen = strlen(entry->path);
+				fwrite(&rec, sizeof(rec), 1, f);
+				fwrite(entry->path, rec.pathlen, 1, f);
+				fwrite(entry->info, rec.infolen, 1, f);
+			}
+		}
+		err = ferror(f);
+		if (fclose(f) != 0 || err || rename(tmppath, path) < 0)
+			unlink(tmppath);
+	}
+	free(tmppath);
+	free(path);
+}
+
+struct vindex *vindex_find(char *source)
+{
+	struct vindex *ix;
+	for (ix = vindex_head; ix != NULL; ix = ix->next) {
+		if (strcmp(ix->source, source) == 0) {
+			ix->count++;
+			return ix;
+		}
+	}
+	return NULL;
+}
+
+void vindex_dropjournal(char *source)
+{
+	char *path;
+	asprintf(&path, "%s/.-/%s", source, JOURNALNAME);
+	if (path != NULL) {
+		unlink(path);
+		free(path);
+	}
+}
+
+struct vindex *vindex_get(char *source, int journal)
+{
+	struct vindex *ix;
+	for (ix = vindex_head; ix != NULL; ix = ix->next) {
+		if (strcmp(ix->source, source) == 0) {
+			ix->count++;
+			ix->journal |= journal;
+			return ix;
+		}
+	}
+	if ((ix = calloc(1, sizeof(struct vindex))) == NULL)
+		return NULL;
+	ix->source = strdup(source);
+	ix->table = calloc(VINDEX_INITSIZE, sizeof(struct vindex_entry *));
+	if (ix->source == NULL || ix->table == NULL) {
+		free(ix->source);
+		free(ix->table);
+		free(ix);
+		return NULL;
+	}
+	ix->size = VINDEX_INITSIZE;
+	ix->count = 1;
+	ix->journal = journal;
+	if (vindex_loadjournal(ix) < 0) {
+		char *wipedir;
+		unsigned int i;
+		/* missing or damaged: start again from the hidden files */
+		for (i = 0; i < ix->size; i++) {
+			while (ix->table[i] != NULL) {
+				struct vindex_entry *entry = ix->table[i];
+				ix->table[i] = entry->next;
+				free(entry);
+			}
+		}
+		ix->nentries = 0;
+		asprintf(&wipedir, "%s/.-", source);
+		if (wipedir != NULL)
+			vindex_scan(ix, wipedir, "");
+		free(wipedir);
+		/* the info of the root is source/.- INFOEXT */
+		vindex_reloadinfo(ix, "");
+	}
+	ix->next = vindex_head;
+	vindex_head = ix;
+	return ix;
+}
+
+void vindex_put(struct vindex *ix)
+{
+	if (ix != NULL && --ix->count == 0) {
+		struct vindex **scan;
+		unsigned int i;
+		if (ix->journal)
+			vindex_savejournal(ix);
+		for (scan = &vindex_head; *scan != NULL; scan = &((*scan)->next)) {
+			if (*scan == ix) {
+				*scan = ix->next;
+				break;
+			}
+		}
+		for (i = 0; i < ix->size; i++) {
+			while (ix->table[i] != NULL) {
+				struct vindex_entry *entry = ix->table[i];
+				ix->table[i] = entry->next;
+				free(entry);
+			}
+		}
+		free(ix->table);
+		free(ix->source);
+		free(ix);
+	}
+}
+
+int vindex_isdeleted(struct vindex *ix, char *path)
+{
+	struct vindex_entry *entry = *vindex_search(ix, path, vindex_hash(path));
+	return (entry != NULL && (entry->flags & VINDEX_DELETED));
+}
+
+void vindex_setdeleted(struct vindex *ix, char *path, int deleted)
+{
+	if (deleted)
+		vindex_update(ix, path, VINDEX_DELETED, VINDEX_INFO, NULL, 0);
+	else
+		vindex_update(ix, path, 0, VINDEX_DELETED, NULL, 0);
+}
+
+int vindex_getinfo(struct vindex *ix, char *path, char *info)
+{
+	struct vindex_entry *entry = *vindex_search(ix, path, vindex_hash(path));
+	if (entry != NULL && (entry->flags & VINDEX_INFO)) {
+		memcpy(info, entry->info, entry->infolen);
+		return entry->infolen;
+	} else
+		return 0;
+}
+
+void vindex_setinfo(struct vindex *ix, char *path, char *info, int len)
+{
+	if (len > 0)
+		vindex_update(ix, path, VINDEX_INFO, 0, info, len);
+	else
+		vindex_update(ix, path, 0, VINDEX_INFO, NULL, 0);
+}
+
+void vindex_reloadinfo(struct vindex *ix, char *path)
+{
+	char *infofile;
+	char info[VINDEX_INFOMAX];
+	int len;
+	asprintf(&infofile, "%s/.-%s%s", ix->source, path, INFOEXT);
+	if (infofile == NULL)
+		return;
+	len = readinfo(infofile, info);
+	vindex_setinfo(ix, path, info, len);
+	free(infofile);
+}
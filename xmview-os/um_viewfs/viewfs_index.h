@@ -0,0 +1,53 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   viewfs: in memory index of the overlay metadata
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _VIEWFS_INDEX_H
+#define _VIEWFS_INDEX_H
+
+/* the wipeout of source/path is source/.-/path,
+	 its fake attributes (vstat) are in source/.-/path INFOEXT */
+#define INFOEXT "\377"
+#define VINDEX_INFOMAX 32
+
+/* The index mirrors the hidden files of the source dir: the hidden files
+	 are still written, the index answers the queries without syscalls.
+	 Mounts of the same source share the index. Paths are relative to the
+	 source dir ("" is the root). */
+struct vindex;
+
+/* journal: load the index saved at the last umount (if any, otherwise the
+	 hidden files are scanned) and save it when the last mount goes away */
+struct vindex *vindex_get(char *source, int journal);
+void vindex_put(struct vindex *ix);
+/* the index of source if another mount uses it (NULL otherwise) */
+struct vindex *vindex_find(char *source);
+/* changes not tracked by an index make the saved index stale */
+void vindex_dropjournal(char *source);
+
+int vindex_isdeleted(struct vindex *ix, char *path);
+void vindex_setdeleted(struct vindex *ix, char *path, int deleted);
+
+/* returns the length of the info, 0 if there is none */
+int vindex_getinfo(struct vindex *ix, char *path, char *info);
+void vindex_setinfo(struct vindex *ix, char *path, char *info, int len);
+/* update the info of path from its hidden file */
+void vindex_reloadinfo(struct vindex *ix, char *path);
+
+#endif
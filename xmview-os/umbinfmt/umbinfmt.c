@@ -95,12 +95,44 @@ static char statusfile[]="status";
 
 #define UMBINFMT_DEBUG 1
 
+/* The registrations are compiled for the exec path: a magic entry is
+	 dispatched on the value of a byte of the header where its mask is 0xff,
+	 an extension entry is hashed. The matcher is rebuilt when the
+	 registrations change and it is read only otherwise. The rank is the
+	 position in the list: the first matching registration wins */
+#define UBM_BUFSIZE 128
+#define UBM_MAXKEYS 8
+#define UBM_EXTHASHSIZE 64
+
+struct ubm_entry {
+	int rank;
+	struct umregister *reg;
+	struct ubm_entry *next;
+};
+
+struct ubm_keytab {
+	int pos;
+	struct ubm_entry *byte[256];
+};
+
+struct ubm_matcher {
+	int nkeys;
+	struct ubm_keytab key[UBM_MAXKEYS];
+	/* magic entries with no byte to dispatch on */
+	struct ubm_entry *generic;
+	int nextlen;
+	unsigned char extlen[UBM_BUFSIZE];
+	struct ubm_entry *ext[UBM_EXTHASHSIZE];
+	struct ubm_entry entries[0];
+};
+
 struct umbinfmt {
 	char *path;
 	unsigned char enabled;
 	char flags;
 	int inuse;
 	struct umregister *head;
+	struct ubm_matcher *matcher;
 	struct ht_elem *binfmt_ht;
 };
 
@@ -130,33 +162,131 @@ static void printdebug(int level, const char *file, const int line, const char *
 }
 #endif
 
-static int searchbinfmt(struct umbinfmt *fc,struct binfmt_req *req)
+static inline unsigned int ubm_exthash(const char *ext, int len)
 {
-	char *buf=req->buf;
-	if (fc->enabled) {
-		struct umregister *scan=fc->head;
-		while (scan != NULL && req->interp==NULL) {
-			if (scan->enabled) {
-				if (scan->type == 'E') {
-					int suffixpos=strlen(req->path)-scan->len;
-					if (suffixpos>0 && strcmp(req->path+suffixpos,scan->magic)==0) {
-						req->interp=scan->interpreter;
-						req->flags=(strchr(scan->flags,'P') != NULL)?BINFMT_KEEP_ARG0:0;
-					}
-				} else if (scan->type == 'M') {
-					int i,j,diff;
-					/*for (i=scan->offset,j=0,diff=0;i<128 && j<scan->len && diff==0;i++,j++)
-						printk("%02x %02x %02x %2x\n",buf[i],scan->magic[j],scan->mask[j],
-						(buf[i] ^ scan->magic[j]) & scan->mask[j]);*/
-					for (i=scan->offset,j=0,diff=0;i<128 && j<scan->len && diff==0;i++,j++)
-						diff=(buf[i] ^ scan->magic[j]) & scan->mask[j];
-					if (diff==0) {
-						req->interp=scan->interpreter;
-						req->flags=(strchr(scan->flags,'P') != NULL)?BINFMT_KEEP_ARG0:0;
+	unsigned int h=2166136261U;
+	while (len-- > 0)
+		h=(h ^ (unsigned char) *ext++) * 16777619U;
+	return h & (UBM_EXTHASHSIZE - 1);
+}
+
+/* add at the tail: the lists are sorted by rank */
+static inline void ubm_append(struct ubm_entry **list, struct ubm_entry *e)
+{
+	while (*list != NULL)
+		list=&((*list)->next);
+	*list=e;
+}
+
+static struct ubm_matcher *ubm_compile(struct umregister *head)
+{
+	struct umregister *scan;
+	struct ubm_matcher *m;
+	int n;
+	for (scan=head,n=0; scan != NULL; scan=scan->next)
+		n++;
+	m=calloc(1,sizeof(struct ubm_matcher) + n*sizeof(struct ubm_entry));
+	if (m == NULL)
+		return NULL;
+	for (scan=head,n=0; scan != NULL; scan=scan->next) {
+		struct ubm_entry *e=&m->entries[n];
+		e->rank=n++;
+		e->reg=scan;
+		if (!scan->enabled)
+			continue;
+		if (scan->type == 'E') {
+			int i;
+			for (i=0; i<m->nextlen && m->extlen[i] != scan->len; i++)
+				;
+			if (i == m->nextlen && m->nextlen < UBM_BUFSIZE)
+				m->extlen[m->nextlen++]=scan->len;
+			ubm_append(&m->ext[ubm_exthash(scan->magic,scan->len)],e);
+		} else {
+			int j,k;
+			for (j=0; j<scan->len && scan->offset+j<UBM_BUFSIZE; j++)
+				if ((unsigned char) scan->mask[j] == 0xff)
+					break;
+			if (j<scan->len && scan->offset+j<UBM_BUFSIZE) {
+				for (k=0; k<m->nkeys && m->key[k].pos != scan->offset+j; k++)
+					;
+				if (k == m->nkeys && m->nkeys < UBM_MAXKEYS)
+					m->key[m->nkeys++].pos=scan->offset+j;
+				if (k < m->nkeys) {
+					ubm_append(&m->key[k].byte[(unsigned char) scan->magic[j]],e);
+					continue;
+				}
+			}
+			ubm_append(&m->generic,e);
+		}
+	}
+	return m;
+}
+
+static void ubm_rebuild(struct umbinfmt *fc)
+{
+	struct ubm_matcher *old=fc->matcher;
+	fc->matcher=ubm_compile(fc->head);
+	free(old);
+}
+
+static inline int ubm_magicmatch(struct umregister *reg, char *buf)
+{
+	int i,j,diff;
+	for (i=reg->offset,j=0,diff=0;i<UBM_BUFSIZE && j<reg->len && diff==0;i++,j++)
+		diff=(buf[i] ^ reg->magic[j]) & reg->mask[j];
+	return diff==0;
+}
+
+/* the first entry of the list matching the header (rank < best) */
+static inline struct ubm_entry *ubm_magicsearch(struct ubm_entry *e, char *buf, int best)
+{
+	for (; e != NULL && e->rank < best; e=e->next)
+		if (ubm_magicmatch(e->reg,buf))
+			return e;
+	return NULL;
+}
+
+static struct umregister *ubm_match(struct ubm_matcher *m, char *path, char *buf)
+{
+	struct ubm_entry *found=NULL, *e;
+	int best=INT_MAX;
+	int k;
+	for (k=0; k<m->nkeys; k++) {
+		if ((e=ubm_magicsearch(m->key[k].byte[(unsigned char) buf[m->key[k].pos]],buf,best)) != NULL) {
+			found=e;
+			best=e->rank;
+		}
+	}
+	if ((e=ubm_magicsearch(m->generic,buf,best)) != NULL) {
+		found=e;
+		best=e->rank;
+	}
+	if (m->nextlen > 0) {
+		int pathlen=strlen(path);
+		for (k=0; k<m->nextlen; k++) {
+			int suffixpos=pathlen-m->extlen[k];
+			if (suffixpos > 0) {
+				char *suffix=path+suffixpos;
+				for (e=m->ext[ubm_exthash(suffix,m->extlen[k])]; e != NULL && e->rank < best; e=e->next) {
+					if (e->reg->len == m->extlen[k] && memcmp(suffix,e->reg->magic,e->reg->len)==0) {
+						found=e;
+						best=e->rank;
+						break;
 					}
 				}
 			}
-			scan=scan->next;
+		}
+	}
+	return found ? found->reg : NULL;
+}
+
+static int searchbinfmt(struct umbinfmt *fc,struct binfmt_req *req)
+{
+	if (fc->enabled && fc->matcher != NULL) {
+		struct umregister *reg=ubm_match(fc->matcher,req->path,req->buf);
+		if (reg) {
+			req->interp=reg->interpreter;
+			req->flags=(strchr(reg->flags,'P') != NULL)?BINFMT_KEEP_ARG0:0;
 		}
 	}
 	//printk("searchbinfmt %s %s\n",req->path,req->interp);
@@ -241,8 +371,10 @@ static struct umregister *delete_reg(struct umregister *head, struct umregister
 		free(this->interpreter);
 		free(this);
 		return next;
-	} else
-		return delete_reg(head->next,this);
+	} else {
+		head->next=delete_reg(head->next,this);
+		return head;
+	}
 }
 
 static struct umregister *delete_allreg(struct umregister *head)
@@ -281,6 +413,7 @@ static long umbinfmt_mount(char *source, char *target, char *filesystemtype,
 	new->inuse=0;
 	new->enabled=1;
 	new->head=NULL;
+	new->matcher=NULL;
 	if (strcmp(source,"none")==0 || strcmp(source,"/")==0)
 		new->binfmt_ht=ht_tab_add(CHECKBINFMT,NULL,0,&s,checkbinfmt,new);
 	else
@@ -298,6 +431,7 @@ static void umbinfmt_umount_internal(struct umbinfmt *fc, int flags)
 	ht_tab_invalidate(fc->binfmt_ht);
 	ht_tab_invalidate(um_mod_get_hte());
 	delete_allreg(fc->head);
+	free(fc->matcher);
 	free(fc_norace->path);
 	free(fc_norace);
 }
@@ -541,11 +675,15 @@ static long umbinfmt_close(int fd)
 		free(ft->contents);
 	ft->bfmount->inuse--;
 	if (UBM_IS_STATUS(ft->reg)) {
-		if (ft->bfmount->enabled == 0xff)
+		if (ft->bfmount->enabled == 0xff) {
 			ft->bfmount->head=delete_allreg(ft->bfmount->head);
-	} else {
-		if (ft->reg->enabled == 0xff)
+			ubm_rebuild(ft->bfmount);
+		}
+	} else if (!UBM_IS_ROOT(ft->reg) && !UBM_IS_REGISTER(ft->reg)) {
+		if (ft->reg->enabled == 0xff) {
 			ft->bfmount->head=delete_reg(ft->bfmount->head,ft->reg);
+			ubm_rebuild(ft->bfmount);
+		}
 	}
 	delfiletab(fd);
 	return 0;
@@ -681,6 +819,7 @@ static void ubm_register(struct umbinfmt *fc,char *buf, size_t count)
 			new->mask=dechex(fields[F_MASK],&(new->len));
 			new->next=fc->head;
 			fc->head=new;
+			ubm_rebuild(fc);
 		}
 	}
 }
@@ -712,6 +851,7 @@ static long umbinfmt_write(int fd, void *buf, size_t count)
 				ft->reg->enabled = 0;
 			if (count >= 2 && cbuf[0]=='-' && cbuf[1]=='1')
 				ft->reg->enabled = 0xff;
+			ubm_rebuild(ft->bfmount);
 		}
 	}
 	if (rv<0) {
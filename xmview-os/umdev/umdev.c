@@ -43,6 +43,7 @@
 #include "module.h"
 #include "libummod.h"
 #include "umdev.h"
+#include "umdev_bcache.h"
 
 //static pthread_mutex_t devicetab_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -75,6 +76,8 @@ struct umdev {
 	int inuse;
 	unsigned long flags;
 	struct ht_elem *devht;
+	size_t bcachesize;
+	struct bcache *bcache;	/* block devices only */
 	void *private_data;
 };
 
@@ -85,6 +88,7 @@ struct fileinfo {
 	int count;        /* number of processes that opened the file */
 	loff_t pos;        /* file offset */
 	struct umdev *umdev;
+	struct bcache_ra ra;
 };
 
 #ifdef __UMDEV_DEBUG__
@@ -292,6 +296,17 @@ void devargs(char *opts, struct devargitem *devargtab, int devargsize, void *arg
 	free(optcopy);
 }
 
+static void cachefun(char *s,struct umdev *fc)
+{
+#ifdef DEBUGUMDEVARGS
+	printk("CACHE %s\n",s);
+#endif
+	if (*s == '=')
+		fc->bcachesize=atoi(s+1) * 1024 * 1024;
+	else
+		fc->bcachesize=BCACHE_DEFAULT_SIZE;
+}
+
 static struct devargitem umdevargtab[] = {
 	{"debug", debugfun},
 	{"char", charfun},
@@ -301,7 +316,8 @@ static struct devargitem umdevargtab[] = {
 	{"mode=", modefun},
 	{"uid=", uidfun},
 	{"gid=", gidfun},
-	{"nsubdev=", plusnum}
+	{"nsubdev=", plusnum},
+	{"cache", cachefun}
 };
 #define UMDEVARGTABSIZE sizeof(umdevargtab)/sizeof(struct devargitem)
 
@@ -340,6 +356,8 @@ static long umdev_mount(char *source, char *target, char *filesystemtype,
 		new->nsubdev = 0;
 		new->inuse = 0;
 		new->flags = 0;
+		new->bcachesize = 0;
+		new->bcache = NULL;
 		new->private_data = NULL;
 
 		if(data) {
@@ -356,6 +374,10 @@ static long umdev_mount(char *source, char *target, char *filesystemtype,
 				return -1;
 			}
 		}
+		/* the module could set the type in init */
+		if (S_ISBLK(new->mode) && new->bcachesize > 0 &&
+				umdev_ops->read && umdev_ops->write)
+			new->bcache = bcache_new(new->bcachesize, umdev_ops);
 		ht_tab_pathadd(CHECKPATH,source,target,filesystemtype,mountflags,data,&s,1,umdev_confirm,new);
 		new->devht=NULL;
 		if (new->dev) {
@@ -375,6 +397,7 @@ static void umdev_umount_internal(struct umdev *fc,int flags) {
 		ht_tab_invalidate(fc->devht);
 	if (fc->flags & UMDEV_DEBUG)
 		printk("UMOUNT => path:%s flag:%d\n",target, flags);
+	bcache_free(fc->bcache);
 	if (fc->devops->fini)
 		fc->devops->fini(mode2char(fc->mode),fc->dev,fc);
 	free(fc->path);
@@ -475,6 +498,8 @@ static long umdev_open(char *path, int flags, mode_t mode)
 #endif
 	ft->count = 0;
 	ft->pos = 0;
+	ft->ra.next = 0;
+	ft->ra.window = 0;
 	//ft->size = buf.st_size; /* SIZE OF device? */
 	di.flags = flags & ~(O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC);
 	di.fh = 0;
@@ -508,7 +533,7 @@ static long umdev_open(char *path, int flags, mode_t mode)
 
 static long umdev_close(int fd)
 {
-	int rv;
+	int rv=0;
 	struct fileinfo *ft=getfiletab(fd);
 
 	struct dev_info di;
@@ -522,11 +547,17 @@ static long umdev_close(int fd)
 	PRINTDEBUG(10,"->CLOSE %c(%d:%d) %d\n",
 			ft->type, major(ft->device), minor(ft->device), ft->count);
 	if (ft->count == 0) {			 
+		int flushrv=0;
 		ft->umdev->inuse--;
+		/* the dev_info of the dirty pages must be valid for the write back */
+		if (ft->umdev->bcache)
+			flushrv=bcache_flush(ft->umdev->bcache);
 		if (ft->umdev->devops->release)
 			rv=ft->umdev->devops->release(ft->type, ft->device, &di);
 		else
 			rv=0;
+		if (rv >= 0 && flushrv < 0)
+			rv=flushrv;
 		if (ft->umdev->flags & UMDEV_DEBUG) 
 			printk("RELEASE[%d %c(%d:%d)] => flags:0x%x rv=%d\n",
 					fd, ft->type, major(ft->device), minor(ft->device), ft->umdev->flags,rv);
@@ -548,7 +579,11 @@ static long umdev_read(int fd, void *buf, size_t count)
 	di.fh = ft->fh;
 	di.flags = 0;
 	di.devhandle=ft->umdev;
-	if (ft->umdev->devops->read)
+	if (ft->umdev->bcache && ft->type == 'b')
+		rv = bcache_read(ft->umdev->bcache, &ft->ra,
+				ft->type, ft->device,
+				buf, count, ft->pos, &di);
+	else if (ft->umdev->devops->read)
 		rv = ft->umdev->devops->read(
 				ft->type, ft->device, 
 				buf, count, ft->pos, &di);
@@ -575,7 +610,11 @@ static long umdev_write(int fd, void *buf, size_t count)
 	di.fh = ft->fh;
 	di.flags = 0;
 	di.devhandle=ft->umdev;
-	if(ft->umdev->devops->write) {
+	if (ft->umdev->bcache && ft->type == 'b') {
+		rv = bcache_write(ft->umdev->bcache,
+				ft->type, ft->device,
+				buf, count, ft->pos, &di);
+	} else if(ft->umdev->devops->write) {
 		rv = ft->umdev->devops->write(
 				ft->type, ft->device,
 				buf, count, ft->pos, &di);
@@ -736,11 +775,12 @@ static long umdev_fsync(int fd)
 	di.fh = ft->fh;
 	di.flags = 0;
 	di.devhandle=ft->umdev;
-	if (ft->umdev->devops->fsync)
+	rv= 0;
+	if (ft->umdev->bcache)
+		rv = bcache_flush(ft->umdev->bcache);
+	if (rv >= 0 && ft->umdev->devops->fsync)
 		rv = ft->umdev->devops->fsync(
 				ft->type, ft->device, &di);
-	else
-		rv= 0;
 	if (ft->umdev->flags & UMDEV_DEBUG) 
 		printk("FSYNC[%d %c(%d:%d)] rv=%d\n",
 				fd, ft->type, major(ft->device), minor(ft->device), rv);
@@ -0,0 +1,628 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   UMDEV: block cache for block devices
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "module.h"
+#include "umdev_bcache.h"
+
+#define BCACHE_HASH_SIZE 1024
+#define BCACHE_HASH_MASK (BCACHE_HASH_SIZE-1)
+/* max size of a write back request (pages) */
+#define BCACHE_FLUSH_MAX 64
+
+/* Only the umview thread calls the bcache functions, so only this thread
+	 deletes pages or changes their data. The mutex serializes the
+	 completion of the asynchronous requests, which may only add pages in
+	 the space reserved at submission time. */
+
+struct bcache_page {
+	char type;
+	dev_t device;
+	unsigned long long index;
+	int len;                  /* < BCACHE_PAGE_SIZE: the device ends here */
+	int dirty;
+	struct dev_info di;       /* for the write back */
+	struct bcache_page **pprevhash,*nexthash;
+	struct bcache_page *prev,*next;           /* LRU list, circular */
+	char data[BCACHE_PAGE_SIZE];
+};
+
+/* size of the (sub)devices, to skip the read of pages fully overwritten */
+struct bcache_devsize {
+	char type;
+	dev_t device;
+	loff_t size;
+	struct bcache_devsize *next;
+};
+
+struct bcache {
+	struct umdev_operations *devops;
+	pthread_mutex_t mutex;
+	pthread_cond_t aiocond;
+	size_t maxsize;
+	size_t size;              /* pages in the cache + reserved space */
+	unsigned long gen;        /* incremented by each write */
+	int naio;                 /* asynchronous requests in flight */
+	int error;                /* write back error, returned by flush */
+	unsigned int ndirty;
+	struct bcache_page *head[BCACHE_HASH_SIZE];
+	struct bcache_page *lru;  /* least recently used */
+	struct bcache_devsize *devsize;
+};
+
+struct bcache_aio {
+	struct umdev_aio aio;
+	struct bcache *bc;
+	struct dev_info di;
+	char type;
+	dev_t device;
+	unsigned long long index;
+	unsigned int npages;
+	unsigned long gen;
+	/* write back */
+	struct bcache_page **pages;
+	int *pending;
+	int rv;
+};
+
+static inline int bcache_hash_mod(dev_t device, unsigned long long index)
+{
+	unsigned long long sum = (device * 0x9e370001ULL) ^ index;
+	return (sum ^ (sum >> 10)) & BCACHE_HASH_MASK;
+}
+
+static inline struct bcache_page *bcache_find(struct bcache *bc,
+		dev_t device, unsigned long long index)
+{
+	struct bcache_page *scan = bc->head[bcache_hash_mod(device, index)];
+	while (scan != NULL) {
+		if (scan->device == device && scan->index == index)
+			return scan;
+		scan = scan->nexthash;
+	}
+	return NULL;
+}
+
+static inline void lru_del(struct bcache *bc, struct bcache_page *page)
+{
+	if (page->next == page)
+		bc->lru = NULL;
+	else {
+		page->prev->next = page->next;
+		page->next->prev = page->prev;
+		if (bc->lru == page)
+			bc->lru = page->next;
+	}
+}
+
+/* the most recently used is the tail, i.e. bc->lru->prev */
+static inline void lru_add(struct bcache *bc, struct bcache_page *page)
+{
+	if (bc->lru == NULL) {
+		page->next = page->prev = page;
+		bc->lru = page;
+	} else {
+		page->next = bc->lru;
+		page->prev = bc->lru->prev;
+		page->prev->next = page;
+		bc->lru->prev = page;
+	}
+}
+
+/* the space for the page has been reserved */
+static void bcache_link(struct bcache *bc, struct bcache_page *page)
+{
+	int hashkey = bcache_hash_mod(page->device, page->index);
+	if (bc->head[hashkey] != NULL)
+		bc->head[hashkey]->pprevhash = &(page->nexthash);
+	page->nexthash = bc->head[hashkey];
+	page->pprevhash = &(bc->head[hashkey]);
+	bc->head[hashkey] = page;
+	lru_add(bc, page);
+}
+
+static void bcache_unlink(struct bcache *bc, struct bcache_page *page)
+{
+	*(page->pprevhash) = page->nexthash;
+	if (page->nexthash)
+		page->nexthash->pprevhash = page->pprevhash;
+	lru_del(bc, page);
+	bc->size -= BCACHE_PAGE_SIZE;
+}
+
+static struct bcache_page *bcache_newpage(char type, dev_t device,
+		unsigned long long index, char *data, int len)
+{
+	struct bcache_page *page = malloc(sizeof(struct bcache_page));
+	if (page != NULL) {
+		page->type = type;
+		page->device = device;
+		page->index = index;
+		page->len = len;
+		page->dirty = 0;
+		if (data)
+			memcpy(page->data, data, len);
+	}
+	return page;
+}
+
+static int bcache_writeback(struct bcache *bc, struct bcache_page *page)
+{
+	int rv = bc->devops->write(page->type, page->device, page->data, page->len,
+			(loff_t) page->index << BCACHE_PAGE_SHIFT, &page->di);
+	/* the tail of a short write would be lost */
+	if (rv >= 0 && rv < page->len)
+		rv = -EIO;
+	return (rv < 0) ? rv : 0;
+}
+
+/* reserve the space for npages, evicting the least recently used pages */
+static void bcache_makeroom(struct bcache *bc, unsigned int npages)
+{
+	size_t need = npages << BCACHE_PAGE_SHIFT;
+	while (1) {
+		struct bcache_page *victim;
+		pthread_mutex_lock(&bc->mutex);
+		if (bc->size + need <= bc->maxsize || bc->lru == NULL) {
+			bc->size += need;
+			pthread_mutex_unlock(&bc->mutex);
+			return;
+		}
+		victim = bc->lru;
+		bcache_unlink(bc, victim);
+		/* readahead in flight could read the old data */
+		if (victim->dirty) {
+			bc->ndirty--;
+			bc->gen++;
+		}
+		pthread_mutex_unlock(&bc->mutex);
+		if (victim->dirty) {
+			int rv = bcache_writeback(bc, victim);
+			if (rv < 0 && bc->error == 0)
+				bc->error = rv;
+		}
+		free(victim);
+	}
+}
+
+/* add the pages read in data (len bytes) at index.
+	 The space has been reserved, pages already in the cache are kept */
+static void bcache_addpages(struct bcache *bc, char type, dev_t device,
+		unsigned long long index, unsigned int npages, char *data, int len)
+{
+	unsigned int i;
+	for (i = 0; i < npages; i++) {
+		int plen = len - (i << BCACHE_PAGE_SHIFT);
+		struct bcache_page *page;
+		if (plen > BCACHE_PAGE_SIZE)
+			plen = BCACHE_PAGE_SIZE;
+		if (plen < 0 || (plen == 0 && i > 0) || bcache_find(bc, device, index + i) ||
+				(page = bcache_newpage(type, device, index + i,
+																data + (i << BCACHE_PAGE_SHIFT), plen)) == NULL)
+			bc->size -= BCACHE_PAGE_SIZE;
+		else
+			bcache_link(bc, page);
+	}
+}
+
+/* number of pages to read when page index is missing:
+	 the window grows while the reader is sequential */
+static unsigned int bcache_window(struct bcache_ra *ra, unsigned long long index,
+		unsigned int wanted)
+{
+	unsigned int npages;
+	if (index == ra->next) {
+		if (ra->window == 0)
+			ra->window = BCACHE_RA_INIT;
+		else if (ra->window < BCACHE_RA_MAX)
+			ra->window <<= 1;
+		if (ra->window > BCACHE_RA_MAX)
+			ra->window = BCACHE_RA_MAX;
+	} else
+		ra->window = 0;
+	npages = (wanted > ra->window) ? wanted : ra->window;
+	if (npages > BCACHE_RA_MAX)
+		npages = BCACHE_RA_MAX;
+	return npages;
+}
+
+static void bcache_readahead_done(struct umdev_aio *aio, int rv)
+{
+	struct bcache_aio *baio = (struct bcache_aio *) aio;
+	struct bcache *bc = baio->bc;
+	pthread_mutex_lock(&bc->mutex);
+	/* a write could have been evicted: the data read could be stale */
+	if (rv < 0 || baio->gen != bc->gen)
+		bc->size -= baio->npages << BCACHE_PAGE_SHIFT;
+	else
+		bcache_addpages(bc, baio->type, baio->device, baio->index, baio->npages,
+				aio->buf, rv);
+	bc->naio--;
+	pthread_cond_broadcast(&bc->aiocond);
+	pthread_mutex_unlock(&bc->mutex);
+	free(aio->buf);
+	free(baio);
+}
+
+static void bcache_readahead(struct bcache *bc, char type, dev_t device,
+		unsigned long long index, unsigned int npages, struct dev_info *di)
+{
+	struct bcache_aio *baio = calloc(1, sizeof(struct bcache_aio));
+	if (baio == NULL)
+		return;
+	if ((baio->aio.buf = malloc(npages << BCACHE_PAGE_SHIFT)) == NULL) {
+		free(baio);
+		return;
+	}
+	bcache_makeroom(bc, npages);
+	baio->aio.write = 0;
+	baio->aio.len = npages << BCACHE_PAGE_SHIFT;
+	baio->aio.pos = (loff_t) index << BCACHE_PAGE_SHIFT;
+	baio->aio.done = bcache_readahead_done;
+	baio->bc = bc;
+	baio->di = *di;
+	baio->type = type;
+	baio->device = device;
+	baio->index = index;
+	baio->npages = npages;
+	pthread_mutex_lock(&bc->mutex);
+	baio->gen = bc->gen;
+	bc->naio++;
+	pthread_mutex_unlock(&bc->mutex);
+	if (bc->devops->aio_submit(type, device, &baio->aio, &baio->di) < 0) {
+		pthread_mutex_lock(&bc->mutex);
+		bc->size -= npages << BCACHE_PAGE_SHIFT;
+		bc->naio--;
+		pthread_mutex_unlock(&bc->mutex);
+		free(baio->aio.buf);
+		free(baio);
+	}
+}
+
+/* read npages (from index) in tmp and add them to the cache.
+	 Returns the number of bytes read */
+static int bcache_fill(struct bcache *bc, char type, dev_t device,
+		unsigned long long index, unsigned int npages, struct dev_info *di, char *tmp)
+{
+	int rv = bc->devops->read(type, device, tmp, npages << BCACHE_PAGE_SHIFT,
+			(loff_t) index << BCACHE_PAGE_SHIFT, di);
+	if (rv >= 0) {
+		bcache_makeroom(bc, npages);
+		pthread_mutex_lock(&bc->mutex);
+		bcache_addpages(bc, type, device, index, npages, tmp, rv);
+		pthread_mutex_unlock(&bc->mutex);
+	}
+	return rv;
+}
+
+int bcache_read(struct bcache *bc, struct bcache_ra *ra, char type, dev_t device,
+		char *buf, size_t count, loff_t pos, struct dev_info *di)
+{
+	size_t done = 0;
+	while (done < count) {
+		unsigned long long index = pos >> BCACHE_PAGE_SHIFT;
+		int poff = pos & (BCACHE_PAGE_SIZE - 1);
+		struct bcache_page *page;
+		ssize_t len;
+		int eof;
+		pthread_mutex_lock(&bc->mutex);
+		if ((page = bcache_find(bc, device, index)) != NULL) {
+			lru_del(bc, page);
+			lru_add(bc, page);
+			pthread_mutex_unlock(&bc->mutex);
+			len = page->len - poff;
+			if (len > (ssize_t) (count - done))
+				len = count - done;
+			if (len > 0)
+				memcpy(buf + done, page->data + poff, len);
+			eof = (page->len < BCACHE_PAGE_SIZE && poff + len >= page->len);
+		} else {
+			unsigned int wanted = (poff + (count - done) + BCACHE_PAGE_SIZE - 1)
+				>> BCACHE_PAGE_SHIFT;
+			unsigned int npages = bcache_window(ra, index, wanted);
+			unsigned int nsync;
+			unsigned int i;
+			char *tmp;
+			int rv;
+			if (wanted > npages)
+				wanted = npages;
+			/* stop at the first page already in the cache */
+			for (i = 1; i < npages && bcache_find(bc, device, index + i) == NULL; i++)
+				;
+			npages = i;
+			pthread_mutex_unlock(&bc->mutex);
+			/* modules supporting aio read ahead while the process goes on */
+			nsync = (bc->devops->aio_submit && npages > wanted) ? wanted : npages;
+			if ((tmp = malloc(nsync << BCACHE_PAGE_SHIFT)) == NULL)
+				return (done > 0) ? done : -ENOMEM;
+			rv = bcache_fill(bc, type, device, index, nsync, di, tmp);
+			if (rv < 0) {
+				free(tmp);
+				return (done > 0) ? done : rv;
+			}
+			if (nsync < npages && rv == (nsync << BCACHE_PAGE_SHIFT))
+				bcache_readahead(bc, type, device, index + nsync, npages - nsync, di);
+			len = rv - poff;
+			if (len > (ssize_t) (count - done))
+				len = count - done;
+			if (len > 0)
+				memcpy(buf + done, tmp + poff, len);
+			eof = (rv < (nsync << BCACHE_PAGE_SHIFT) && poff + len >= rv);
+			free(tmp);
+		}
+		if (len <= 0)
+			break;
+		done += len;
+		pos += len;
+		ra->next = ((pos - 1) >> BCACHE_PAGE_SHIFT) + 1;
+		if (eof)
+			break;
+	}
+	return done;
+}
+
+static loff_t bcache_devsize(struct bcache *bc, char type, dev_t device,
+		struct dev_info *di)
+{
+	struct bcache_devsize *scan;
+	for (scan = bc->devsize; scan != NULL; scan = scan->next)
+		if (scan->type == type && scan->device == device)
+			return scan->size;
+	if (bc->devops->lseek == NULL ||
+			(scan = malloc(sizeof(struct bcache_devsize))) == NULL)
+		return -1;
+	scan->type = type;
+	scan->device = device;
+	scan->size = bc->devops->lseek(type, device, 0, SEEK_END, 0, di);
+	scan->next = bc->devsize;
+	bc->devsize = scan;
+	return scan->size;
+}
+
+int bcache_write(struct bcache *bc, char type, dev_t device,
+		const char *buf, size_t count, loff_t pos, struct dev_info *di)
+{
+	size_t done = 0;
+	pthread_mutex_lock(&bc->mutex);
+	bc->gen++;
+	pthread_mutex_unlock(&bc->mutex);
+	while (done < count) {
+		unsigned long long index = pos >> BCACHE_PAGE_SHIFT;
+		int poff = pos & (BCACHE_PAGE_SIZE - 1);
+		size_t len = BCACHE_PAGE_SIZE - poff;
+		struct bcache_page *page;
+		if (len > count - done)
+			len = count - done;
+		pthread_mutex_lock(&bc->mutex);
+		if ((page = bcache_find(bc, device, index)) != NULL) {
+			lru_del(bc, page);
+			lru_add(bc, page);
+		}
+		pthread_mutex_unlock(&bc->mutex);
+		if (page == NULL) {
+			loff_t end = ((loff_t) index + 1) << BCACHE_PAGE_SHIFT;
+			if (len == BCACHE_PAGE_SIZE && end <= bcache_devsize(bc, type, device, di)) {
+				/* the page is overwritten: nothing to read */
+				if ((page = bcache_newpage(type, device, index, NULL,
+								BCACHE_PAGE_SIZE)) == NULL)
+					return (done > 0) ? done : -ENOMEM;
+				bcache_makeroom(bc, 1);
+				pthread_mutex_lock(&bc->mutex);
+				bcache_link(bc, page);
+				pthread_mutex_unlock(&bc->mutex);
+			} else {
+				char tmp[BCACHE_PAGE_SIZE];
+				int rv = bcache_fill(bc, type, device, index, 1, di, tmp);
+				if (rv < 0)
+					return (done > 0) ? done : rv;
+				pthread_mutex_lock(&bc->mutex);
+				page = bcache_find(bc, device, index);
+				pthread_mutex_unlock(&bc->mutex);
+				if (page == NULL)
+					return (done > 0) ? done : -ENOMEM;
+			}
+		}
+		/* the device ends here */
+		if (poff >= page->len)
+			break;
+		if (len > page->len - poff)
+			len = page->len - poff;
+		memcpy(page->data + poff, buf + done, len);
+		if (!page->dirty) {
+			page->di = *di;
+			pthread_mutex_lock(&bc->mutex);
+			page->dirty = 1;
+			bc->ndirty++;
+			pthread_mutex_unlock(&bc->mutex);
+		}
+		done += len;
+		pos += len;
+	}
+	return done;
+}
+
+static int bcache_pagecmp(const void *a, const void *b)
+{
+	const struct bcache_page *pa = *(struct bcache_page **) a;
+	const struct bcache_page *pb = *(struct bcache_page **) b;
+	if (pa->device != pb->device)
+		return (pa->device < pb->device) ? -1 : 1;
+	if (pa->index != pb->index)
+		return (pa->index < pb->index) ? -1 : 1;
+	return 0;
+}
+
+static void bcache_flush_done(struct umdev_aio *aio, int rv)
+{
+	struct bcache_aio *baio = (struct bcache_aio *) aio;
+	struct bcache *bc = baio->bc;
+	pthread_mutex_lock(&bc->mutex);
+	baio->rv = rv;
+	(*baio->pending)--;
+	bc->naio--;
+	pthread_cond_broadcast(&bc->aiocond);
+	pthread_mutex_unlock(&bc->mutex);
+}
+
+/* dirty pages are sorted and contiguous pages are written by
+	 a single request. With aio all the requests are submitted together */
+int bcache_flush(struct bcache *bc)
+{
+	struct bcache_page **dirty;
+	struct bcache_aio *reqs;
+	unsigned int ndirty = 0;
+	unsigned int nreqs = 0;
+	unsigned int i;
+	int pending = 0;
+	int rv = 0;
+	pthread_mutex_lock(&bc->mutex);
+	if (bc->ndirty > 0 && (dirty = malloc(bc->ndirty * sizeof(struct bcache_page *))) != NULL) {
+		struct bcache_page *page = bc->lru;
+		if (page != NULL) {
+			do {
+				if (page->dirty)
+					dirty[ndirty++] = page;
+				page = page->next;
+			} while (page != bc->lru);
+		}
+	} else {
+		/* the dirty pages are kept, a later flush can write them */
+		if (bc->ndirty > 0)
+			rv = -ENOMEM;
+		dirty = NULL;
+	}
+	pthread_mutex_unlock(&bc->mutex);
+	if (ndirty > 0 && (reqs = calloc(ndirty, sizeof(struct bcache_aio))) == NULL)
+		rv = -ENOMEM;
+	else if (ndirty > 0) {
+		qsort(dirty, ndirty, sizeof(struct bcache_page *), bcache_pagecmp);
+		for (i = 0; i < ndirty; ) {
+			struct bcache_aio *req = &reqs[nreqs++];
+			unsigned int n = 1;
+			unsigned int j;
+			/* a short page (end of device) closes the request */
+			while (i + n < ndirty && n < BCACHE_FLUSH_MAX &&
+					dirty[i + n]->device == dirty[i]->device &&
+					dirty[i + n]->index == dirty[i]->index + n &&
+					dirty[i + n - 1]->len == BCACHE_PAGE_SIZE)
+				n++;
+			req->bc = bc;
+			req->pages = dirty + i;
+			req->npages = n;
+			req->pending = &pending;
+			req->aio.write = 1;
+			req->aio.pos = (loff_t) dirty[i]->index << BCACHE_PAGE_SHIFT;
+			req->aio.len = ((n - 1) << BCACHE_PAGE_SHIFT) + dirty[i + n - 1]->len;
+			req->aio.done = bcache_flush_done;
+			if (n == 1)
+				req->aio.buf = dirty[i]->data;
+			else if ((req->aio.buf = malloc(req->aio.len)) != NULL) {
+				for (j = 0; j < n; j++)
+					memcpy(req->aio.buf + (j << BCACHE_PAGE_SHIFT), dirty[i + j]->data,
+							dirty[i + j]->len);
+			}
+			if (req->aio.buf == NULL)
+				req->rv = -ENOMEM;
+			else if (bc->devops->aio_submit) {
+				pthread_mutex_lock(&bc->mutex);
+				pending++;
+				bc->naio++;
+				pthread_mutex_unlock(&bc->mutex);
+				if (bc->devops->aio_submit(dirty[i]->type, dirty[i]->device, &req->aio,
+							&dirty[i]->di) < 0)
+					bcache_flush_done(&req->aio, -EIO);
+			} else
+				req->rv = bc->devops->write(dirty[i]->type, dirty[i]->device,
+						req->aio.buf, req->aio.len, req->aio.pos, &dirty[i]->di);
+			i += n;
+		}
+		pthread_mutex_lock(&bc->mutex);
+		while (pending > 0)
+			pthread_cond_wait(&bc->aiocond, &bc->mutex);
+		for (i = 0; i < nreqs; i++) {
+			struct bcache_aio *req = &reqs[i];
+			/* a short write keeps the pages dirty */
+			if (req->rv >= 0 && (size_t) req->rv < req->aio.len)
+				req->rv = -EIO;
+			if (req->rv < 0) {
+				if (bc->error == 0)
+					bc->error = req->rv;
+			} else {
+				unsigned int j;
+				for (j = 0; j < req->npages; j++) {
+					req->pages[j]->dirty = 0;
+					bc->ndirty--;
+				}
+			}
+			if (req->npages > 1)
+				free(req->aio.buf);
+		}
+		pthread_mutex_unlock(&bc->mutex);
+		free(reqs);
+	}
+	free(dirty);
+	if (rv == 0)
+		rv = bc->error;
+	bc->error = 0;
+	return rv;
+}
+
+struct bcache *bcache_new(size_t maxsize, struct umdev_operations *devops)
+{
+	struct bcache *bc = calloc(1, sizeof(struct bcache));
+	if (bc != NULL) {
+		bc->devops = devops;
+		bc->maxsize = maxsize;
+		pthread_mutex_init(&bc->mutex, NULL);
+		pthread_cond_init(&bc->aiocond, NULL);
+	}
+	return bc;
+}
+
+void bcache_free(struct bcache *bc)
+{
+	if (bc == NULL)
+		return;
+	pthread_mutex_lock(&bc->mutex);
+	while (bc->naio > 0)
+		pthread_cond_wait(&bc->aiocond, &bc->mutex);
+	pthread_mutex_unlock(&bc->mutex);
+	if (bcache_flush(bc) < 0)
+		printk("umdev: block cache write back error\n");
+	while (bc->lru != NULL) {
+		struct bcache_page *page = bc->lru;
+		bcache_unlink(bc, page);
+		free(page);
+	}
+	while (bc->devsize != NULL) {
+		struct bcache_devsize *next = bc->devsize->next;
+		free(bc->devsize);
+		bc->devsize = next;
+	}
+	pthread_mutex_destroy(&bc->mutex);
+	pthread_cond_destroy(&bc->aiocond);
+	free(bc);
+}
@@ -0,0 +1,54 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   UMDEV: block cache for block devices
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _UMDEV_BCACHE_H
+#define _UMDEV_BCACHE_H
+#include <umdev.h>
+
+/* pages are multiple of the sector size: the device module
+	 gets aligned requests only */
+#define BCACHE_PAGE_SHIFT 12
+#define BCACHE_PAGE_SIZE (1 << BCACHE_PAGE_SHIFT)
+#define BCACHE_DEFAULT_SIZE (16 * 1024 * 1024)
+/* readahead window (pages) */
+#define BCACHE_RA_INIT 4
+#define BCACHE_RA_MAX 64
+
+struct bcache;
+
+/* sequential access detection (one for each open file) */
+struct bcache_ra {
+	unsigned long long next;
+	unsigned int window;
+};
+
+struct bcache *bcache_new(size_t maxsize, struct umdev_operations *devops);
+/* flush and free */
+void bcache_free(struct bcache *bc);
+
+int bcache_read(struct bcache *bc, struct bcache_ra *ra, char type, dev_t device,
+		char *buf, size_t count, loff_t pos, struct dev_info *di);
+/* write back: data reaches the device at flush time (or when evicted) */
+int bcache_write(struct bcache *bc, char type, dev_t device,
+		const char *buf, size_t count, loff_t pos, struct dev_info *di);
+/* write all the dirty pages. Returns the first error since the last flush */
+int bcache_flush(struct bcache *bc);
+
+#endif
@@ -3,8 +3,14 @@
 #include "umdev.h"
 #include "stdlib.h"
 #include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <linux/fs.h>
 #include <linux/hdreg.h>
+#include <linux/falloc.h>
 #include <config.h>
 
 #define STD_SIZE 64*1024
@@ -12,14 +18,132 @@
 
 #define READONLY 1
 #define MBR 2
+#define MEMFD 4
+#define HUGEPAGES 8
+
+/* the disk is allocated in chunks at the first write: reading a
+	 missing chunk gives zeros */
+#define RD_CHUNKSHIFT 16
+#define RD_CHUNKSIZE (1 << RD_CHUNKSHIFT)
+#define RD_CHUNKMASK (RD_CHUNKSIZE - 1)
+#define RD_HUGEPAGESIZE (2 * 1024 * 1024)
+
+/* chunks are shared (copy on write) by the clones of a ramdisk */
+struct rdchunk {
+	int count;
+	struct ramdisk *home;     /* data is in the mapping of home, NULL=malloc */
+	char *data;
+};
 
 struct ramdisk {
-	char *diskdata;
 	char flags;
 	unsigned long long rd_size;
 	struct hd_geometry rd_geom;
+	unsigned long nchunks;
+	struct rdchunk **chunk;
+	char *map;                /* memfd or hugepages: chunk i is at map+i*RD_CHUNKSIZE */
+	size_t mapsize;
+	int memfd;
+	char *source;
+	char *clone;
+	struct ramdisk *next;
 };
 
+static struct ramdisk *ramdisks;
+/* home of the chunks left in the mapping of an unmounted disk */
+static struct ramdisk rd_orphans;
+
+/* the slot of a chunk in the mapping must read as zeros */
+static void rd_slotclear(struct ramdisk *ramdisk, char *data)
+{
+	int rv;
+	if (ramdisk->memfd >= 0)
+		rv=fallocate(ramdisk->memfd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+				data - ramdisk->map, RD_CHUNKSIZE);
+	else
+		rv=madvise(data, RD_CHUNKSIZE, MADV_DONTNEED);
+	/* e.g. a part of a huge page */
+	if (rv < 0)
+		memset(data, 0, RD_CHUNKSIZE);
+}
+
+static struct rdchunk *rd_chunknew(struct ramdisk *ramdisk, unsigned long i)
+{
+	struct rdchunk *chunk=malloc(sizeof(struct rdchunk));
+	if (chunk) {
+		chunk->count=1;
+		if (ramdisk->map) {
+			chunk->home=ramdisk;
+			chunk->data=ramdisk->map + ((size_t) i << RD_CHUNKSHIFT);
+		} else {
+			chunk->home=NULL;
+			if ((chunk->data=calloc(1, RD_CHUNKSIZE)) == NULL) {
+				free(chunk);
+				chunk=NULL;
+			}
+		}
+	}
+	return chunk;
+}
+
+/* the data of a shared chunk leaves the mapping of ramdisk */
+static int rd_chunkmoveout(struct rdchunk *chunk)
+{
+	char *data=malloc(RD_CHUNKSIZE);
+	if (data == NULL)
+		return -ENOMEM;
+	memcpy(data, chunk->data, RD_CHUNKSIZE);
+	chunk->data=data;
+	chunk->home=NULL;
+	return 0;
+}
+
+static int rd_chunkdrop(struct ramdisk *ramdisk, unsigned long i)
+{
+	struct rdchunk *chunk=ramdisk->chunk[i];
+	if (chunk) {
+		if (chunk->count > 1) {
+			if (chunk->home == ramdisk) {
+				if (rd_chunkmoveout(chunk) < 0)
+					return -ENOMEM;
+				rd_slotclear(ramdisk, ramdisk->map + ((size_t) i << RD_CHUNKSHIFT));
+			}
+			chunk->count--;
+		} else {
+			if (chunk->home == ramdisk)
+				rd_slotclear(ramdisk, chunk->data);
+			else if (chunk->home == NULL)
+				free(chunk->data);
+			free(chunk);
+		}
+		ramdisk->chunk[i]=NULL;
+	}
+	return 0;
+}
+
+/* copy on write */
+static char *rd_chunkwritable(struct ramdisk *ramdisk, unsigned long i)
+{
+	struct rdchunk *chunk=ramdisk->chunk[i];
+	if (chunk == NULL) 
+		chunk=ramdisk->chunk[i]=rd_chunknew(ramdisk, i);
+	else if (chunk->count > 1) {
+		struct rdchunk *new;
+		if (chunk->home == ramdisk) {
+			/* the slot already has the data, the clones get a copy */
+			if (rd_chunkmoveout(chunk) < 0 || (new=rd_chunknew(ramdisk, i)) == NULL)
+				return NULL;
+		} else {
+			if ((new=rd_chunknew(ramdisk, i)) == NULL)
+				return NULL;
+			memcpy(new->data, chunk->data, RD_CHUNKSIZE);
+		}
+		chunk->count--;
+		chunk=ramdisk->chunk[i]=new;
+	}
+	return chunk ? chunk->data : NULL;
+}
+
 static int rd_open(char type, dev_t device, struct dev_info *di)
 {
 		return 0;
@@ -31,12 +155,24 @@ static int rd_read(char type, dev_t device, char *buf, size_t len, loff_t pos, s
 	if (ramdisk) {
 		loff_t size=ramdisk->rd_size*STD_SECTORSIZE;
 		size_t rlen;
+		size_t done;
 		if (pos > size) pos=size;
 		if (pos+len <= size) 
 			rlen=len;
 		else
 			rlen=size-pos;
-		memcpy(buf,ramdisk->diskdata+pos,rlen);
+		for (done=0; done<rlen; ) {
+			unsigned long i=pos >> RD_CHUNKSHIFT;
+			size_t off=pos & RD_CHUNKMASK;
+			size_t clen=RD_CHUNKSIZE-off;
+			if (clen > rlen-done) clen=rlen-done;
+			if (ramdisk->chunk[i])
+				memcpy(buf+done,ramdisk->chunk[i]->data+off,clen);
+			else
+				memset(buf+done,0,clen);
+			done+=clen;
+			pos+=clen;
+		}
 		return rlen;
 	}
 	else
@@ -52,12 +188,24 @@ static int rd_write(char type, dev_t device, const char *buf, size_t len, loff_t
 		else {
 			loff_t size=ramdisk->rd_size*STD_SECTORSIZE;
 			size_t rlen;
+			size_t done;
 			if (pos > size) pos=size;
 			if (pos+len <= size) 
 				rlen=len;
 			else
 				rlen=size-pos;
-			memcpy(ramdisk->diskdata+pos,buf,rlen);
+			for (done=0; done<rlen; ) {
+				unsigned long i=pos >> RD_CHUNKSHIFT;
+				size_t off=pos & RD_CHUNKMASK;
+				size_t clen=RD_CHUNKSIZE-off;
+				char *data;
+				if (clen > rlen-done) clen=rlen-done;
+				if ((data=rd_chunkwritable(ramdisk, i)) == NULL)
+					return (done > 0) ? done : -ENOMEM;
+				memcpy(data+off,buf+done,clen);
+				done+=clen;
+				pos+=clen;
+			}
 			return rlen;
 		}
 	}
@@ -95,11 +243,57 @@ static loff_t rd_lseek(char type, dev_t device, loff_t offset, int whence, loff_
 		    return -ENODEV;
 }
 
+/* BLKDISCARD: whole chunks are freed, the rest is zeroed */
+static int rd_discard(struct ramdisk *ramdisk, uint64_t start, uint64_t len)
+{
+	loff_t size=ramdisk->rd_size*STD_SECTORSIZE;
+	if (ramdisk->flags & READONLY)
+		return -EACCES;
+	if (start > size || len > size - start)
+		return -EINVAL;
+	while (len > 0) {
+		unsigned long i=start >> RD_CHUNKSHIFT;
+		size_t off=start & RD_CHUNKMASK;
+		size_t clen=RD_CHUNKSIZE-off;
+		if (clen > len) clen=len;
+		if (ramdisk->chunk[i]) {
+			if (clen == RD_CHUNKSIZE) {
+				if (rd_chunkdrop(ramdisk, i) < 0)
+					return -ENOMEM;
+			} else {
+				char *data=rd_chunkwritable(ramdisk, i);
+				if (data == NULL)
+					return -ENOMEM;
+				memset(data+off,0,clen);
+			}
+		}
+		start+=clen;
+		len-=clen;
+	}
+	return 0;
+}
+
 static void rd_setmbr(char *s,struct ramdisk *rd)
 {
 	rd->flags |= MBR;
 }
 
+static void rd_setmemfd(char *s,struct ramdisk *rd)
+{
+	rd->flags |= MEMFD;
+}
+
+static void rd_sethugepages(char *s,struct ramdisk *rd)
+{
+	rd->flags |= HUGEPAGES;
+}
+
+static void rd_setclone(char *s,struct ramdisk *rd)
+{
+	free(rd->clone);
+	rd->clone=strdup(s);
+}
+
 static void rd_setsize(char *s,struct ramdisk *rd)
 {
 	if (s) {
@@ -120,15 +314,123 @@ static void rd_setsize(char *s,struct ramdisk *rd)
 static struct devargitem umdevargtab[] = {
 	  {"size=", rd_setsize},
 	  {"mbr", rd_setmbr},
+	  {"memfd", rd_setmemfd},
+	  {"hugepages", rd_sethugepages},
+	  {"clone=", rd_setclone},
 };
 #define UMDEVARGTABSIZE sizeof(umdevargtab)/sizeof(struct devargitem)
 		
+/* memfd: the disk is a (sparse) shared memory file.
+	 hugepages: the mapping uses transparent huge pages (hugetlbfs pages are not
+	 used: an empty pool would kill umview with SIGBUS at the first write) */
+static int rd_map(struct ramdisk *ramdisk, char *path)
+{
+	ramdisk->mapsize=ramdisk->nchunks << RD_CHUNKSHIFT;
+	if (ramdisk->flags & HUGEPAGES)
+		ramdisk->mapsize=(ramdisk->mapsize + RD_HUGEPAGESIZE - 1) & ~((size_t) RD_HUGEPAGESIZE - 1);
+	if (ramdisk->flags & MEMFD) {
+#ifdef __NR_memfd_create
+		ramdisk->memfd=syscall(__NR_memfd_create, path ? path : "umdevramdisk", 0);
+		if (ramdisk->memfd < 0)
+			return -errno;
+		if (ftruncate(ramdisk->memfd, ramdisk->mapsize) < 0 ||
+				(ramdisk->map=mmap(NULL, ramdisk->mapsize, PROT_READ|PROT_WRITE,
+													 MAP_SHARED, ramdisk->memfd, 0)) == MAP_FAILED) {
+			int rv=-errno;
+			close(ramdisk->memfd);
+			ramdisk->map=NULL;
+			return rv;
+		}
+#else
+		return -ENOSYS;
+#endif
+	} else {
+		ramdisk->map=mmap(NULL, ramdisk->mapsize, PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+		if (ramdisk->map == MAP_FAILED) {
+			ramdisk->map=NULL;
+			return -errno;
+		}
+	}
+#ifdef MADV_HUGEPAGE
+	if (ramdisk->flags & HUGEPAGES)
+		madvise(ramdisk->map, ramdisk->mapsize, MADV_HUGEPAGE);
+#endif
+	return 0;
+}
+
+/* clone=source: the new disk shares (copy on write) the chunks of the
+	 ramdisk mounted from source */
+static int rd_clone(struct ramdisk *ramdisk)
+{
+	struct ramdisk *orig;
+	unsigned long i;
+	for (orig=ramdisks; orig != NULL; orig=orig->next)
+		if (orig->source && strcmp(orig->source, ramdisk->clone) == 0)
+			break;
+	if (orig == NULL)
+		return -ENOENT;
+	for (i=0; i<ramdisk->nchunks && i<orig->nchunks; i++) {
+		if ((ramdisk->chunk[i]=orig->chunk[i]) != NULL)
+			ramdisk->chunk[i]->count++;
+	}
+	return 0;
+}
+
+static void rd_free(struct ramdisk *ramdisk)
+{
+	struct ramdisk **scan;
+	unsigned long i;
+	int keepmap=0;
+	for (scan=&ramdisks; *scan != NULL; scan=&((*scan)->next))
+		if (*scan == ramdisk) {
+			*scan=ramdisk->next;
+			break;
+		}
+	if (ramdisk->chunk) {
+		for (i=0; i<ramdisk->nchunks; i++) {
+			struct rdchunk *chunk=ramdisk->chunk[i];
+			if (chunk == NULL)
+				continue;
+			if (chunk->count > 1) {
+				/* the clones need a copy of the data in the mapping.
+					 No memory: the mapping stays, the chunk is orphaned */
+				if (chunk->home == ramdisk && rd_chunkmoveout(chunk) < 0) {
+					chunk->home=&rd_orphans;
+					keepmap=1;
+				}
+				chunk->count--;
+			} else {
+				if (chunk->home == NULL)
+					free(chunk->data);
+				free(chunk);
+			}
+		}
+		free(ramdisk->chunk);
+	}
+	if (ramdisk->map && !keepmap)
+		munmap(ramdisk->map, ramdisk->mapsize);
+	if (ramdisk->memfd >= 0)
+		close(ramdisk->memfd);
+	free(ramdisk->source);
+	free(ramdisk->clone);
+	free(ramdisk);
+}
+
 static int rd_init(char type, dev_t device, char *path, unsigned long flags, char *args,struct umdev *devhandle)
 {
 	struct ramdisk *ramdisk=calloc(1,sizeof (struct ramdisk));
-	if(args)
-		    devargs(args, umdevargtab, UMDEVARGTABSIZE, ramdisk);
 	if (ramdisk) {
+		int rv;
+		ramdisk->memfd=-1;
+		if(args)
+			devargs(args, umdevargtab, UMDEVARGTABSIZE, ramdisk);
+		if (ramdisk->rd_size == 0 && ramdisk->clone) {
+			struct ramdisk *orig;
+			for (orig=ramdisks; orig != NULL; orig=orig->next)
+				if (orig->source && strcmp(orig->source, ramdisk->clone) == 0)
+					ramdisk->rd_size=orig->rd_size;
+		}
 		if (ramdisk->rd_size == 0)
 			ramdisk->rd_size=STD_SIZE;
 		ramdisk->rd_geom.start=0;
@@ -142,13 +444,24 @@ static int rd_init(char type, dev_t device, char *path, unsigned long flags, cha
 			ramdisk->rd_geom.cylinders=(ramdisk->rd_size+(ramdisk->rd_geom.heads*ramdisk->rd_geom.sectors)-1)/(ramdisk->rd_geom.heads*ramdisk->rd_geom.sectors);
 		}
 		ramdisk->rd_size=ramdisk->rd_geom.heads*ramdisk->rd_geom.sectors*ramdisk->rd_geom.cylinders;
-		if (!ramdisk->diskdata) {
-			ramdisk->diskdata=malloc(ramdisk->rd_size * STD_SECTORSIZE);
-			if (!ramdisk->diskdata) {
-				free(ramdisk);
-				return -ENOMEM;
-			}
+		ramdisk->nchunks=(ramdisk->rd_size * STD_SECTORSIZE + RD_CHUNKSIZE - 1) >> RD_CHUNKSHIFT;
+		ramdisk->chunk=calloc(ramdisk->nchunks, sizeof(struct rdchunk *));
+		if (!ramdisk->chunk) {
+			rd_free(ramdisk);
+			return -ENOMEM;
+		}
+		if ((ramdisk->flags & (MEMFD|HUGEPAGES)) && (rv=rd_map(ramdisk, path)) < 0) {
+			rd_free(ramdisk);
+			return rv;
 		}
+		if (ramdisk->clone && (rv=rd_clone(ramdisk)) < 0) {
+			rd_free(ramdisk);
+			return rv;
+		}
+		if (path)
+			ramdisk->source=strdup(path);
+		ramdisk->next=ramdisks;
+		ramdisks=ramdisk;
 		mode_t mode=umdev_getmode(devhandle);
 		mode = (mode & ~S_IFMT) | S_IFBLK;
 		umdev_setmode(devhandle, mode);
@@ -161,10 +474,8 @@ static int rd_init(char type, dev_t device, char *path, unsigned long flags, cha
 static int rd_fini(char type, dev_t device, struct umdev *devhandle)
 {
     struct ramdisk *ramdisk = umdev_getprivatedata(devhandle);
-		if (ramdisk) {
-			free(ramdisk->diskdata);
-			free(ramdisk);
-		}
+		if (ramdisk) 
+			rd_free(ramdisk);
 		return 0;
 }
 
@@ -181,6 +492,10 @@ static int rd_ioctl(char type, dev_t device, int req, void * arg, struct dev_inf
 			case BLKSSZGET: *(int *)arg = STD_SECTORSIZE;
 											break;
 			case BLKRRPART: break;
+			case BLKDISCARD: {
+												 uint64_t *range = arg;
+												 return rd_discard(ramdisk, range[0], range[1]);
+											 }
 			case BLKGETSIZE: *(int *)arg = ramdisk->rd_size * 
 											    ((ramdisk->flags & MBR)?1:STD_SECTORSIZE);
 											 break;
@@ -206,6 +521,7 @@ static int rd_ioctl_params(char type, dev_t device, int req, struct dev_info *di
 		case BLKROGET: return (sizeof(int) | IOCTL_W);
 		case BLKSSZGET: return (sizeof(int) | IOCTL_W);
 		case BLKRRPART: return 0;
+		case BLKDISCARD: return (2 * sizeof(uint64_t) | IOCTL_R);
 		case BLKGETSIZE: return (sizeof(int) | IOCTL_W);
 		case BLKGETSIZE64: return (sizeof(long long) | IOCTL_W);
 		case HDIO_GETGEO: return (sizeof(struct hd_geometry) | IOCTL_W);
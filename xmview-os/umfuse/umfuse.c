@@ -55,8 +55,13 @@
 #include <pwd.h>
 #include <sys/statfs.h>
 #include <sys/statvfs.h>
+#include <poll.h>
 #include <config.h>
 #include <umfuse_node.h>
+#include <umfuse_cache.h>
+#include <umfuse_pcache.h>
+#include <umfuse_pool.h>
+#include <umdirsnap.h>
 
 #define UMFUSE_FUSE_VERSION 26
 
@@ -100,6 +105,11 @@ struct fuse {
 	pthread_cond_t endloop;
 	pthread_mutex_t endmutex;
 	struct fuse_operations fops;	
+	struct fuse_cache *cache;
+	struct umdirsnap *dircache;	/* last directory read, reused if unchanged */
+	struct fuse_pool *pool;	/* workers for asynchronous reads (fuse_loop_mt) */
+	int max_threads;
+	struct ht_elem *hte;
 	int inuse;
 	unsigned long flags;
 };
@@ -110,25 +120,6 @@ struct fuse {
 #define FUSE_ABORT -3
 static pthread_mutex_t condition_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-#define WORDLEN sizeof(int *)
-#define WORDALIGN(X) (((X) + WORDLEN) & ~(WORDLEN-1))
-#define SIZEDIRENT64NONAME (sizeof(__u64)+sizeof(__s64)+sizeof(unsigned short)+sizeof(unsigned char))
-#define SIZEDIRENT32NONAME (sizeof(long)+sizeof(__kernel_off_t)+sizeof(unsigned short))
-
-struct umfuse_dirent64 {
-	__u64             d_ino;
-	__s64             d_off;
-	unsigned short  d_reclen;
-	unsigned char   d_type;
-	char            *d_name;
-};
-
-struct umdirent {
-	struct umfuse_dirent64 de;
-	//unsigned short d_reclen32;
-	struct umdirent *next;
-};
-
 struct fileinfo {
 	struct fuse_context *context;
 	//char *path;						
@@ -136,9 +127,9 @@ struct fileinfo {
 	long long size;				/* file offset */
 	struct fuse_file_info ffi;		/* includes open flags, file handle and page_write mode  */
 	struct fuse_node *node;
-	struct umdirent *dirinfo;		/* conversion fuse-getdir into kernel compliant
-																 dirent. Dir head pointer */
-	struct umdirent *dirpos;		/* same conversion above: current pos entry */
+	struct umdirsnap *dirsnap;		/* directory entries (pos is the index) */
+	struct pcache_ra ra;				/* page cache readahead state */
+	struct fuse_async *async;		/* pending asynchronous read */
 };
 #define FILEPATH(f) ((f)->node->path)
 
@@ -181,6 +172,19 @@ static void printdebug(int level, const char *file, const int line, const char *
 #endif
 #endif
 
+/* getattr through the attribute cache.
+ * lookup!=0: the caller only needs to know if path exists */
+static int umfuse_getattr(struct fuse_context *fc, char *path, struct stat *buf, int lookup)
+{
+	unsigned long gen;
+	int rv=fcache_get(fc->fuse->cache,path,buf,lookup,&gen);
+	if (rv == FCACHE_MISS) {
+		rv=fc->fuse->fops.getattr(path,buf);
+		fcache_put(fc->fuse->cache,path,buf,rv,gen);
+	}
+	return rv;
+}
+
 /* search for exceptions returns 1 if it is an exception */
 /* XXX EXPERIMENTAL TODO implemement this as negative mount! */
 
@@ -201,7 +205,7 @@ static inline int isexception(char *path, char **exceptions, struct fuse_context
 		if (fc->fuse->flags & FUSE_MERGE) {
 			if (*path) {
 				struct stat buf;
-				int rv=fc->fuse->fops.getattr(path,&buf);
+				int rv=umfuse_getattr(fc,path,&buf,1);
 				return (rv < 0);
 			} else
 				return 0;
@@ -318,7 +322,7 @@ static int check_permission(mode_t mode,uid_t uid,gid_t gid,int mask){
 static int path_check_permission(char *path,int mask) {
 	struct fuse_context *fc=um_mod_get_private_data();
 	struct stat buf;
-	int rv=fc->fuse->fops.getattr(path,&buf);
+	int rv=umfuse_getattr(fc,path,&buf,0);
 	if (rv>=0) rv=check_permission(buf.st_mode,buf.st_uid,buf.st_gid,mask);
 	return rv;
 }
@@ -355,7 +359,7 @@ int check_owner(char *path){
 	int rv;
 	struct fuse_context  *fc=fuse_get_context();
 
-	if (fc->fuse->fops.getattr) rv=fc->fuse->fops.getattr(path,&buf);
+	rv=umfuse_getattr(fc,path,&buf,0);
 	if (rv<0) {
 		PRINTDEBUG (10,"check_owner.Getattr failed:%s",path);
 		return rv;
@@ -427,7 +431,7 @@ static void *startmain(void *vsmo)
 	}
 	/* handle -o options and specific filesystem options */
 	opts = mountflag2options(*(psmo->pmountflags), psmo->data);
-	newargc=fuseargs(psmo->new->fuse->filesystemtype,psmo->source, psmo->new->fuse->path,opts, &newargv,psmo->new, &(psmo->new->fuse->flags), &(psmo->new->fuse->exceptions));
+	newargc=fuseargs(psmo->new->fuse->filesystemtype,psmo->source, psmo->new->fuse->path,opts, &newargv,psmo->new, &(psmo->new->fuse->flags), &(psmo->new->fuse->exceptions), psmo->new->fuse->cache, &(psmo->new->fuse->max_threads));
 	free(opts);
 	if (psmo->new->fuse->flags & FUSE_DEBUG) {
 		GMESSAGE("UmFUSE Debug enabled");
@@ -459,10 +463,15 @@ int fuse_main_real(int argc, char *argv[], const struct fuse_operations *op,
 {
 	struct fuse *f;
 	struct fuse_chan *fuseargs = fuse_mount(NULL, NULL); //options have been already parsed
+	int i;
 	f = fuse_new(fuseargs, NULL, op, op_size, user_data);
 	//I cannot understand this comment. (renzo)
 	//"now opts are lib_opts;debug,hard_remove,use_ino"
-	return fuse_loop(f);
+	/* multithreaded unless -s, as in the FUSE library */
+	for (i=1; i<argc; i++)
+		if (strcmp(argv[i],"-s") == 0)
+			return fuse_loop(f);
+	return fuse_loop_mt(f);
 }
 
 /* fuse_mount and fuse_unmount are dummy functions, 
@@ -574,10 +583,19 @@ void fuse_exit(struct fuse *f)
 
 }
 
+/* worker threads run the file system code with the mount hte */
+static void umfuse_thread_init(void *arg)
+{
+	struct fuse *f=arg;
+	um_mod_set_hte(f->hte);
+}
+
 int fuse_loop_mt(struct fuse *f)
 {
-	//in fuselib is FUSE event loop with multiple threads,
-	//but here is all with multiple threads ;-)
+	/* the module is thread safe: blocking reads can be run
+	 * by a pool of workers (see umfuse_event_subscribe) */
+	if (f != NULL)
+		f->pool = fpool_new(f->max_threads, umfuse_thread_init, f);
 	return fuse_loop(f);
 }
 
@@ -591,7 +609,10 @@ int fuse_invalidate(struct fuse *f, const char *path)
 	 *
 	 * @return 0 on success or -errno on failure
 	 */
-	//return -errno
+	if (f == NULL || path == NULL)
+		return -EINVAL;
+	fcache_invalidate(f->cache, path);
+	pcache_drop(node_search(f, (char *) path));
 	return 0;
 }
 
@@ -630,6 +651,10 @@ static long umfuse_mount(char *source, char *target, char *filesystemtype,
 		assert(new->fuse);
 		new->fuse->path = strdup(target);
 		new->fuse->exceptions = NULL;
+		new->fuse->cache = fcache_new();
+		new->fuse->dircache = NULL;
+		new->fuse->pool = NULL;
+		new->fuse->max_threads = FUSE_MAX_THREADS;
 		if (strcmp(target,"/")==0)
 			new->fuse->pathlen = 0;
 		else
@@ -645,6 +670,7 @@ static long umfuse_mount(char *source, char *target, char *filesystemtype,
 		new->fuse->flags = mountflags; /* all the mount flags + FUSE_DEBUG */
 
 		um_mod_set_hte(ht_tab_pathadd(CHECKPATH,source,target,filesystemtype,mountflags,data,&s,0,umfuse_confirm,new));
+		new->fuse->hte = um_mod_get_hte();
 
 		smo.new = new;
 		smo.pmountflags = &(new->fuse->flags);
@@ -668,10 +694,13 @@ static long umfuse_mount(char *source, char *target, char *filesystemtype,
 			//GERROR("UMOUNT ABORT");
 			ht_tab_invalidate(um_mod_get_hte());
 			pthread_join(fc_norace->fuse->thread, NULL);
+			fpool_free(fc_norace->fuse->pool);
 			dlclose(fc_norace->fuse->dlhandle);
 			free(fc_norace->fuse->filesystemtype);
 			freeexceptions(fc_norace->fuse->exceptions);
 			free(fc_norace->fuse->path);
+			fcache_free(fc_norace->fuse->cache);
+			umdirsnap_put(fc_norace->fuse->dircache);
 			free(fc_norace->fuse);
 			ht_tab_del(um_mod_get_hte());
 			errno = EIO;
@@ -693,9 +722,15 @@ static void umfuse_umount_internal(struct fuse_context *fc, int flags)
 	fc_norace->pid=um_mod_getpid();
 	//printk("umount %s\n",target);
 	if (fc_norace->fuse->flags & FUSE_DEBUG) {
-		GMESSAGE("UMOUNT => path:%s flag:%d",target, flags);
+		char stats[256];
+		fcache_stats(fc_norace->fuse->cache, stats, sizeof(stats));
+		GMESSAGE("UMOUNT => path:%s flag:%d %s",target, flags, stats);
+		pcache_stats(stats, sizeof(stats));
+		GMESSAGE("UMOUNT => path:%s %s",target, stats);
 	}
 	//printf("PID %d TID %d \n",getpid(),pthread_self());
+	fpool_free(fc_norace->fuse->pool);
+	fc_norace->fuse->pool = NULL;
 	pthread_mutex_lock( &fc_norace->fuse->endmutex );
 	//pthread_mutex_lock( &condition_mutex );
 	if (fc_norace->fuse->fops.destroy != NULL)
@@ -710,6 +745,8 @@ static void umfuse_umount_internal(struct fuse_context *fc, int flags)
 	freeexceptions(fc_norace->fuse->exceptions);
 	free(fc_norace->fuse->path);
 	dlclose(fc_norace->fuse->dlhandle);
+	fcache_free(fc_norace->fuse->cache);
+	umdirsnap_put(fc_norace->fuse->dircache);
 	free(fc_norace->fuse);
 	free(fc_norace);
 }
@@ -732,28 +769,13 @@ static long umfuse_umount2(char *target, int flags)
 }
 /* Handle for a getdir() operation */
 struct fuse_dirhandle {
-	struct umdirent *tail;
-	long long offset;
+	struct umdirsnap *snap;
 };
 
 static int umfusefilldir(fuse_dirh_t h, const char *name, int type, ino_t ino)
 {
-	if (name != NULL) {
-		struct umdirent *new=(struct umdirent *)malloc(sizeof(struct umdirent));
-		new->de.d_ino=ino;
-		new->de.d_type=type;
-		new->de.d_name=strdup(name);
-		new->de.d_reclen=WORDALIGN(SIZEDIRENT64NONAME+strlen(name)+1);
-		/* virtualize the offset on a real file, 64bit ino+16len+8namlen+8type */
-		new->de.d_off=h->offset=h->offset+WORDALIGN(12+strlen(name));
-		if (h->tail==NULL) {
-			new->next=new;
-		} else {
-			new->next=h->tail->next;
-			h->tail->next=new;
-		}
-		h->tail=new;
-	}
+	if (name != NULL)
+		umdirsnap_add(h->snap, name, ino, type, 0);
 	return 0;
 }
 
@@ -761,42 +783,15 @@ static int umfusefillreaddir(void *buf, const char *name, const struct stat *stb
 {
 	fuse_dirh_t h=buf;
 	if (name != NULL) {
-		struct umdirent *new=(struct umdirent *)malloc(sizeof(struct umdirent));
-		if (stbuf == NULL) {
-			new->de.d_ino=-1;
-			new->de.d_type=0;
-		} else {
-			new->de.d_ino=stbuf->st_ino;
-			new->de.d_type=stbuf->st_mode >> 12;
-		}
-		new->de.d_name=strdup(name);
-		new->de.d_reclen=WORDALIGN(SIZEDIRENT64NONAME+strlen(name)+1);
-		/* virtualize the offset on a real file, 64bit ino+16len+8namlen+8type */
-		new->de.d_off=h->offset=h->offset+WORDALIGN(12+strlen(name));
-		if (h->tail==NULL) {
-			new->next=new;
-		} else {
-			new->next=h->tail->next;
-			h->tail->next=new;
-		}
-		h->tail=new;
+		if (stbuf == NULL)
+			umdirsnap_add(h->snap, name, -1, 0, 0);
+		else
+			umdirsnap_add(h->snap, name, stbuf->st_ino, stbuf->st_mode >> 12, 0);
 	}
 	return 0;
 }
 
-static int merge_newentry(char *name,struct umdirent *tail,struct umdirent *oldtail)
-{
-	if (oldtail) {
-		do {
-			struct umdirent *next=tail->next;
-			if (strcmp(next->de.d_name,name)==0)
-				return 0;
-			tail=next;
-		} while (tail != oldtail);
-	}
-	return 1;
-}
-
+/* names already provided by the file system are skipped */
 static void um_mergedir(char *path,struct fuse_context *fc,fuse_dirh_t h)
 {
 	char *abspath;
@@ -804,30 +799,14 @@ static void um_mergedir(char *path,struct fuse_context *fc,fuse_dirh_t h)
 	asprintf(&abspath,"%s%s",fc->fuse->path,path);
 	fd=open(abspath,O_RDONLY|O_DIRECTORY);
 	free(abspath);
-	if (fd) {
+	if (fd >= 0) {
 		char buf[4096];
 		int len;
-		struct umdirent *oldtail=h->tail;
 		while ((len=getdents64(fd,(struct dirent64 *)buf,4096)) > 0) {
 			off_t off=0;
 			while (off<len) {
 				struct dirent64 *de=(struct dirent64 *)(buf+off);
-				if (merge_newentry(de->d_name,h->tail,oldtail))
-				{
-					struct umdirent *new=(struct umdirent *)malloc(sizeof(struct umdirent));
-					new->de.d_name=strdup(de->d_name);
-					new->de.d_type=de->d_type;
-					new->de.d_ino=de->d_ino;
-					new->de.d_reclen=WORDALIGN(SIZEDIRENT64NONAME+strlen(de->d_name)+1);
-					new->de.d_off=h->offset=h->offset+WORDALIGN(12+strlen(de->d_name));
-					if (h->tail==NULL) {
-						new->next=new;
-					} else {
-						new->next=h->tail->next;
-						h->tail->next=new;
-					}
-					h->tail=new;
-				}
+				umdirsnap_add(h->snap, de->d_name, de->d_ino, de->d_type, 0);
 				off+=de->d_reclen;
 			}
 		}
@@ -835,77 +814,59 @@ static void um_mergedir(char *path,struct fuse_context *fc,fuse_dirh_t h)
 	}
 }
 
-static struct umdirent *umfilldirinfo(struct fileinfo *fi)
+/* the snapshot of the last directory read is reused if its mtime (and the
+ * mtime of the real directory for merge mounts) has not changed */
+static struct umdirsnap *umfilldirinfo(struct fileinfo *fi)
 {
 	int rv;
 	struct fuse_dirhandle dh;
 	struct fuse_context *fc=fi->context;
-	dh.tail=NULL;
-	dh.offset=0;
+	struct stat st[2];
+	int nst=0;
+	memset(st, 0, sizeof(st));
+	if (umfuse_getattr(fc, FILEPATH(fi), &st[0], 0) == 0 && st[0].st_mtime != 0) {
+		nst=1;
+		if (fc->fuse->flags & FUSE_MERGE) {
+			char *abspath;
+			asprintf(&abspath,"%s%s",fc->fuse->path,FILEPATH(fi));
+			if (abspath == NULL || stat(abspath, &st[1]) < 0)
+				memset(&st[1], 0, sizeof(struct stat));
+			free(abspath);
+			nst=2;
+		}
+		if (umdirsnap_match(fc->fuse->dircache, FILEPATH(fi), st, nst))
+			return umdirsnap_get(fc->fuse->dircache);
+	}
+	if ((dh.snap=umdirsnap_new()) == NULL)
+		return NULL;
 	if (fc->fuse->fops.readdir)
 		rv=fc->fuse->fops.readdir(FILEPATH(fi),&dh, umfusefillreaddir, 0, &fi->ffi);
 	else
 		rv=fc->fuse->fops.getdir(FILEPATH(fi), &dh, umfusefilldir);
 	if (fc->fuse->flags & FUSE_MERGE && rv>=0) 
 		um_mergedir(FILEPATH(fi),fc,&dh);
-	if (rv < 0)
+	if (rv < 0) {
+		umdirsnap_put(dh.snap);
 		return NULL;
-	else 
-		return dh.tail;
-}
-
-static void umcleandirinfo(struct umdirent *tail)
-{
-	if (tail != NULL) {
-		while (tail->next != tail) {
-			struct umdirent *tmp;
-			tmp=tail->next;
-			tail->next=tmp->next;
-			free(tmp->de.d_name);
-			free(tmp);
-		}
-		free(tail);
 	}
+	if (nst > 0) {
+		umdirsnap_setkey(dh.snap, FILEPATH(fi), st, nst);
+		umdirsnap_put(fc->fuse->dircache);
+		fc->fuse->dircache=umdirsnap_get(dh.snap);
+	}
+	return dh.snap;
 }
 
 static long umfuse_getdents64(unsigned int fd, struct dirent64 *dirp, unsigned int count)
 {
 	struct fileinfo *ft=getfiletab(fd);
-	unsigned int curoffs=0;
-	if (ft->dirinfo == NULL) {
-		ft->dirinfo = umfilldirinfo(ft);
-	} 
-	/* TODO management of lseek on directories */
-
-	if (ft->dirinfo==NULL) 
-		return 0;
-	else {
-		struct dirent64 *current;
-		char *base=(char *)dirp;
-		int last=0;
-		if (ft->dirpos==NULL)
-			ft->dirpos=ft->dirinfo;
-		else
-			last=(ft->dirpos==ft->dirinfo);
-		while (!last && curoffs + ft->dirpos->next->de.d_reclen < count)
-		{
-			ft->dirpos=ft->dirpos->next;
-			current=(struct dirent64 *)base;
-			current->d_ino=ft->dirpos->de.d_ino;
-			current->d_off=ft->dirpos->de.d_off;
-			current->d_reclen=ft->dirpos->de.d_reclen;
-			current->d_type=ft->dirpos->de.d_type;
-			strcpy(current->d_name,ft->dirpos->de.d_name);
-			/* workaround: some FS do not set d_ino, but
-			 * inode 0 is special and is skipped by libc */
-			if (current->d_ino == 0)
-				current->d_ino = 2;
-			base+=ft->dirpos->de.d_reclen;
-			curoffs+=ft->dirpos->de.d_reclen;
-			last=(ft->dirpos == ft->dirinfo);
-		}
+	if (ft->dirsnap == NULL) {
+		ft->dirsnap = umfilldirinfo(ft);
+		if (ft->dirsnap == NULL)
+			return 0;
 	}
-	return curoffs;
+	/* lseek/telldir: the position is the index in the snapshot */
+	return umdirsnap_getdents64(ft->dirsnap, &ft->pos, dirp, count);
 }
 
 static long umfuse_access(char *path, int mode);
@@ -975,9 +936,11 @@ static long umfuse_open(char *path, int flags, mode_t mode)
 	ft->ffi.flags = flags & ~(O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC);
 	ft->ffi.writepage = 0; //XXX do we need writepage != 0?
 	ft->node = NULL;
-	ft->dirinfo = NULL;
-	ft->dirpos = NULL;
-	exists_err = fc->fuse->fops.getattr(unpath, &buf);
+	ft->dirsnap = NULL;
+	ft->ra.next = 0;
+	ft->ra.window = 0;
+	ft->async = NULL;
+	exists_err = umfuse_getattr(fc, unpath, &buf, 0);
 	ft->size = buf.st_size;
 
 	if ((flags & O_ACCMODE) != O_RDONLY && fc->fuse->flags & MS_RDONLY) {
@@ -1015,6 +978,8 @@ static long umfuse_open(char *path, int flags, mode_t mode)
 
 	if(exists_err == 0 && (flags & O_TRUNC) && (flags & O_ACCMODE)!= O_RDONLY) {
 		rv=fc->fuse->fops.truncate(unpath, 0);
+		fcache_invalidate(fc->fuse->cache, unpath);
+		pcache_drop(node_search(fc->fuse, unpath));
 		if (rv < 0) {
 			errno = -rv;
 			goto error;
@@ -1024,6 +989,8 @@ static long umfuse_open(char *path, int flags, mode_t mode)
 	/* create the file: create or (obsolete mode) mknod+open */
 	if ((flags & O_CREAT) && (exists_err != 0)){ 
 		GDEBUG(10, "umfuse create/mknod call");
+		/* drop the negative entry and the parent's attributes */
+		fcache_invalidate_parent(fc->fuse->cache, unpath);
 		if (fc->fuse->fops.create != NULL) {
 			if (fc->fuse->flags & FUSE_DEBUG) 
 				GMESSAGE("CREATE[%s] => path:%s mode:0x%x", fc->fuse->path, path, mode);
@@ -1042,7 +1009,7 @@ static long umfuse_open(char *path, int flags, mode_t mode)
 			if (fc->fuse->fops.fgetattr != NULL)
 				rv = fc->fuse->fops.fgetattr(unpath, &buf, &ft->ffi);
 			else
-				rv = fc->fuse->fops.getattr(unpath, &buf);
+				rv = umfuse_getattr(fc, unpath, &buf, 0);
 		}
 	} else { /* the file exists! */
 		if ((flags & O_DIRECTORY) && fc->fuse->fops.readdir)
@@ -1074,6 +1041,7 @@ error:
 	return -1;
 }
 
+static void umfuse_async_cancel(struct fileinfo *ft);
 static long umfuse_close(int fd)
 {
 	int rv;
@@ -1085,9 +1053,12 @@ static long umfuse_close(int fd)
 	if (fc->fuse->flags & FUSE_DEBUG) {
 		GMESSAGE("CLOSE[%s:%d] %s %p",fc->fuse->path,fd,FILEPATH(ft),fc);
 	}
+	umfuse_async_cancel(ft);
 
 	if (!(ft->ffi.flags & O_DIRECTORY)) {
 		rv=fc->fuse->fops.flush(FILEPATH(ft), &ft->ffi);
+		if ((ft->ffi.flags & O_ACCMODE) != O_RDONLY)
+			fcache_invalidate(fc->fuse->cache, FILEPATH(ft));
 
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("FLUSH[%s:%d] => path:%s",
@@ -1107,14 +1078,18 @@ static long umfuse_close(int fd)
 	}
 	if (node_hiddenpathcheck(ft->node)) {
 		rv = fc->fuse->fops.unlink(FILEPATH(ft));
+		fcache_invalidate_parent(fc->fuse->cache, FILEPATH(ft));
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("UNLINK[%s:%d] => path:%s flags:0x%x",
 					fc->fuse->path, fd, FILEPATH(ft), fc->fuse->flags);
 		}
 	}
 
+	/* the pages live as long as the node */
+	if (ft->node != NULL && ft->node->open_count == 1)
+		pcache_drop(ft->node);
 	node_del(ft->node);
-	umcleandirinfo(ft->dirinfo);
+	umdirsnap_put(ft->dirsnap);
 	delfiletab(fd);
 	if (rv<0) {
 		errno= -rv;
@@ -1124,6 +1099,215 @@ static long umfuse_close(int fd)
 	}
 }
 
+/* page cache fill function */
+static int umfuse_fill(void *arg, char *buf, size_t size, off_t off)
+{
+	struct fileinfo *ft=arg;
+	struct fuse_context *fc=ft->context;
+	return fc->fuse->fops.read(FILEPATH(ft), buf, size, off, &ft->ffi);
+}
+
+static inline int umfuse_pagecache(struct fileinfo *ft)
+{
+	unsigned long flags=ft->context->fuse->flags;
+	return (flags & FUSE_PAGECACHE) && !(flags & FUSE_DIRECTIO) &&
+		!ft->ffi.direct_io && !(ft->ffi.flags & O_DIRECT) && ft->node != NULL;
+}
+
+/* ASYNCHRONOUS READS:
+ * a read which is going to block the caller (see check_suspend_on) gets
+ * started by umfuse_event_subscribe on a worker thread: the process is
+ * suspended until the worker calls cb, then umfuse_read consumes the
+ * data. The job has its own copy of path and fuse_file_info, close
+ * waits for it. */
+struct fuse_async {
+	struct fpool_job job;
+	struct fuse_context *fc;
+	struct fuse_node *node;
+	char *path;
+	struct fuse_file_info ffi;
+	struct pcache_ra ra;
+	int pagecache;
+	long long pos;
+	size_t size;
+	char *buf;
+	int rv;
+	int done;
+	void (*cb)();
+	void *arg;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+static int umfuse_async_fill(void *arg, char *buf, size_t size, off_t off)
+{
+	struct fuse_async *as=arg;
+	return as->fc->fuse->fops.read(as->path, buf, size, off, &as->ffi);
+}
+
+static void umfuse_async_run(struct fpool_job *job)
+{
+	struct fuse_async *as=(struct fuse_async *)job;
+	void (*cb)();
+	void *arg;
+	int rv;
+	if (as->pagecache)
+		rv = pcache_read(as->node, &as->ra, as->buf, as->size, as->pos,
+				umfuse_async_fill, as);
+	else
+		rv = umfuse_async_fill(as, as->buf, as->size, as->pos);
+	pthread_mutex_lock(&as->mutex);
+	as->rv = rv;
+	as->done = 1;
+	cb = as->cb;
+	arg = as->arg;
+	as->cb = NULL;
+	pthread_cond_signal(&as->cond);
+	pthread_mutex_unlock(&as->mutex);
+	if (cb)
+		cb(arg);
+}
+
+static struct fuse_async *umfuse_async_new(struct fileinfo *ft, size_t size)
+{
+	struct fuse_async *as=calloc(1, sizeof(struct fuse_async));
+	if (as == NULL)
+		return NULL;
+	if ((as->buf=malloc(size)) == NULL ||
+			(as->path=strdup(FILEPATH(ft))) == NULL) {
+		free(as->buf);
+		free(as);
+		return NULL;
+	}
+	as->job.fun = umfuse_async_run;
+	as->fc = ft->context;
+	as->node = ft->node;
+	as->ffi = ft->ffi;
+	/* the readahead state of the file is not shared with the worker */
+	as->ra = ft->ra;
+	as->pagecache = umfuse_pagecache(ft);
+	as->pos = ft->pos;
+	as->size = size;
+	pthread_mutex_init(&as->mutex, NULL);
+	pthread_cond_init(&as->cond, NULL);
+	return as;
+}
+
+static void umfuse_async_wait(struct fuse_async *as)
+{
+	pthread_mutex_lock(&as->mutex);
+	while (!as->done)
+		pthread_cond_wait(&as->cond, &as->mutex);
+	pthread_mutex_unlock(&as->mutex);
+}
+
+static void umfuse_async_free(struct fuse_async *as)
+{
+	pthread_cond_destroy(&as->cond);
+	pthread_mutex_destroy(&as->mutex);
+	free(as->path);
+	free(as->buf);
+	free(as);
+}
+
+/* wait for the pending read (if any) and discard it */
+static void umfuse_async_cancel(struct fileinfo *ft)
+{
+	if (ft->async != NULL) {
+		umfuse_async_wait(ft->async);
+		umfuse_async_free(ft->async);
+		ft->async = NULL;
+	}
+}
+
+/* copy the result of the pending read to buf: returns the number of
+ * bytes or -errno. *more is set when the caller has to read the
+ * remaining part (if any) synchronously */
+static int umfuse_async_collect(struct fileinfo *ft, char *buf, size_t count,
+		int *more)
+{
+	struct fuse_async *as=ft->async;
+	int rv;
+	umfuse_async_wait(as);
+	*more = 0;
+	if (as->pos != ft->pos) {
+		/* lseek in the meanwhile */
+		rv = 0;
+		*more = 1;
+	} else if ((rv = as->rv) > 0) {
+		/* the read was at the current position: the readahead goes on */
+		ft->ra = as->ra;
+		if (rv > count)
+			rv = count;
+		memcpy(buf, as->buf, rv);
+		*more = (as->rv == as->size);
+	}
+	ft->async = NULL;
+	umfuse_async_free(as);
+	return rv;
+}
+
+#define FUSE_ASYNC_SIZE (64 * 1024)
+#define FUSE_ASYNC_MAX (1024 * 1024)
+
+static long umfuse_event_subscribe(void (* cb)(), void *arg, int fd, int how)
+{
+	struct fileinfo *ft=getfiletab(fd);
+	struct fuse_context *fc=ft->context;
+	struct fuse_async *as;
+	size_t size;
+	int sysno;
+	if (cb == NULL) {
+		/* unsubscribe: the read (if any) completes anyway */
+		if ((as=ft->async) != NULL) {
+			pthread_mutex_lock(&as->mutex);
+			as->cb = NULL;
+			pthread_mutex_unlock(&as->mutex);
+		}
+		return 0;
+	}
+	/* files are always ready for poll/select and writes */
+	sysno=um_mod_getsyscallno();
+	if (!(how & POLLIN) || (sysno != __NR_read && sysno != __NR_readv) ||
+			fc->fuse->pool == NULL || (ft->ffi.flags & O_DIRECTORY) ||
+			(ft->ffi.flags & O_ACCMODE) == O_WRONLY || ft->pos == ft->size)
+		return how;
+	if ((as=ft->async) != NULL) {
+		int rv=0;
+		pthread_mutex_lock(&as->mutex);
+		if (as->done)
+			rv=how & POLLIN;
+		else {
+			as->cb = cb;
+			as->arg = arg;
+		}
+		pthread_mutex_unlock(&as->mutex);
+		return rv;
+	}
+	size = (sysno == __NR_read) ? um_mod_getargs()[2] : FUSE_ASYNC_SIZE;
+	if (size == 0)
+		return how;
+	if (size > FUSE_ASYNC_MAX)
+		size = FUSE_ASYNC_MAX;
+	if ((as=umfuse_async_new(ft, size)) == NULL)
+		return how;
+	fc->pid=um_mod_getpid();
+	as->cb = cb;
+	as->arg = arg;
+	ft->async = as;
+	if (fpool_submit(fc->fuse->pool, &as->job) < 0) {
+		/* no threads, synchronous read */
+		ft->async = NULL;
+		umfuse_async_free(as);
+		return how;
+	}
+	if (fc->fuse->flags & FUSE_DEBUG) {
+		GMESSAGE("ASYNC READ[%s:%d] => path:%s count:%u pos:%lld",
+				fc->fuse->path, fd, FILEPATH(ft), size, ft->pos);
+	}
+	return 0;
+}
+
 static long umfuse_read(int fd, void *buf, size_t count)
 {
 	int rv;
@@ -1135,13 +1319,31 @@ static long umfuse_read(int fd, void *buf, size_t count)
 		return 0;
 	else {
 		struct fuse_context *fc=ft->context;
+		int done=0;
+		int more=1;
 		fc->pid=um_mod_getpid();
-		rv = fc->fuse->fops.read(
-				FILEPATH(ft),
-				buf,
-				count,
-				ft->pos,
-				&ft->ffi);
+		if (ft->async != NULL) {
+			done = umfuse_async_collect(ft, buf, count, &more);
+			if (done < 0) {
+				errno= -done;
+				return -1;
+			}
+		}
+		if (!more || done == count)
+			rv = 0;
+		else if (umfuse_pagecache(ft))
+			rv = pcache_read(ft->node, &ft->ra, (char *)buf + done, count - done,
+					ft->pos + done, umfuse_fill, ft);
+		else
+			rv = fc->fuse->fops.read(
+					FILEPATH(ft),
+					(char *)buf + done,
+					count - done,
+					ft->pos + done,
+					&ft->ffi);
+		/* the data already read is returned anyway */
+		if (done > 0)
+			rv = (rv > 0) ? done + rv : done;
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("READ[%s:%d] => path:%s count:%u rv:%d",
 					fc->fuse->path,fd, FILEPATH(ft), count, rv);
@@ -1174,11 +1376,16 @@ static long umfuse_write(int fd, void *buf, size_t count)
 	} else {
 		struct fuse_context *fc=ft->context;
 		fc->pid=um_mod_getpid();
+		umfuse_async_cancel(ft);
 		if (ft->ffi.flags & O_APPEND)
 			rv=umfuse_lseek64(fd,0,SEEK_END);
 		if (rv!=-1) {
 			rv = fc->fuse->fops.write(FILEPATH(ft),
 					buf, count, ft->pos, &ft->ffi);
+			fcache_invalidate(fc->fuse->cache, FILEPATH(ft));
+			/* write through */
+			if (rv > 0)
+				pcache_invalidate(ft->node, ft->pos, rv);
 		}
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("WRITE[%s:%d] => path:%s count:0x%x rv:%d",
@@ -1246,7 +1453,7 @@ static long umfuse_lstat64(char *path, struct stat64 *buf64, int fd)
 
 	fc->pid=um_mod_getpid();
 	memset(&buf, 0, sizeof(struct stat));
-	rv = fc->fuse->fops.getattr(unpath, &buf);
+	rv = umfuse_getattr(fc, unpath, &buf, 0);
 	if (fc->fuse->flags & FUSE_DEBUG) {
 		GMESSAGE("%s: stat->GETATTR => path:%s status: %s Err:%d",
 				fc->fuse->path, path, rv ? "Error" : "Success", (rv < 0) ? -rv : 0);
@@ -1321,7 +1528,7 @@ static long umfuse_access(char *path, int mode)
 		rv= fc->fuse->fops.access(unwrap(fc, path), mode);
 	else
 	{
-		rv = fc->fuse->fops.getattr(unwrap(fc, path), &buf);
+		rv = umfuse_getattr(fc, unwrap(fc, path), &buf, 1);
 		/* XXX user permission management */
 	}
 	if (rv < 0) {
@@ -1363,6 +1570,7 @@ static long umfuse_mknod(const char *path, mode_t mode, dev_t dev)
 					major(dev),minor(dev));
 		rv = fc->fuse->fops.mknod(unpath, mode, dev);
 	}
+	fcache_invalidate_parent(fc->fuse->cache, unpath);
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1398,6 +1606,7 @@ static long umfuse_mkdir(char *path, int mode)
 	}
 	rv = fc->fuse->fops.mkdir(
 			unwrap(fc, path), mode);
+	fcache_invalidate_parent(fc->fuse->cache, unwrap(fc, path));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1432,6 +1641,7 @@ static long umfuse_rmdir(char *path)
 	}
 	rv= fc->fuse->fops.rmdir(
 			unwrap(fc, path));
+	fcache_invalidate_parent(fc->fuse->cache, unwrap(fc, path));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1469,6 +1679,7 @@ static long umfuse_chmod(char *path, int mode, int fd)
 		GMESSAGE("CHMOD [%s] => path:%s",fc->fuse->path,path);
 	}
 	rv= fc->fuse->fops.chmod(unpath, mode);
+	fcache_invalidate(fc->fuse->cache, unpath);
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1506,6 +1717,7 @@ static long umfuse_lchown(char *path, uid_t owner, gid_t group, int fd)
 
 	fc->pid=um_mod_getpid();
 	rv = fc->fuse->fops.chown(unpath, owner, group);
+	fcache_invalidate(fc->fuse->cache, unpath);
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1544,7 +1756,7 @@ static long umfuse_unlink(char *path)
 		}
 	}
 
-	if ((exists_err = fc->fuse->fops.getattr(unpath, &buf)) < 0) {
+	if ((exists_err = umfuse_getattr(fc, unpath, &buf, 1)) < 0) {
 		errno = ENOENT;
 		return -1;
 	}
@@ -1568,8 +1780,10 @@ static long umfuse_unlink(char *path)
 		rv = fc->fuse->fops.rename(unpath,hiddenpath);
 		if (rv == 0) 
 			node_newpath(node,hiddenpath);
+		fcache_invalidate_parent(fc->fuse->cache, hiddenpath);
 		free(hiddenpath);
 	}
+	fcache_invalidate_parent(fc->fuse->cache, unpath);
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1605,6 +1819,9 @@ static long umfuse_link(char *oldpath, char *newpath)
 	rv = fc->fuse->fops.link(
 			unwrap(fc, oldpath),
 			unwrap(fc, newpath));
+	/* st_nlink of oldpath changes too */
+	fcache_invalidate(fc->fuse->cache, unwrap(fc, oldpath));
+	fcache_invalidate_parent(fc->fuse->cache, unwrap(fc, newpath));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1660,6 +1877,11 @@ static long umfuse_rename(char *oldpath, char *newpath)
 	}
 
 	rv = fc->fuse->fops.rename(unoldpath,unnewpath);
+	/* the entries below a renamed directory move too */
+	fcache_invalidate_tree(fc->fuse->cache, unoldpath);
+	fcache_invalidate_tree(fc->fuse->cache, unnewpath);
+	fcache_invalidate_parent(fc->fuse->cache, unoldpath);
+	fcache_invalidate_parent(fc->fuse->cache, unnewpath);
 
 	if (rv < 0) {
 		errno = -rv;
@@ -1713,6 +1935,7 @@ static long umfuse_symlink(char *oldpath, char *newpath)
 	rv = fc->fuse->fops.symlink(
 			oldpath,
 			unwrap(fc, newpath));
+	fcache_invalidate_parent(fc->fuse->cache, unwrap(fc, newpath));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1758,6 +1981,8 @@ static long umfuse_truncate64(char *path, loff_t length)
 	}
 	rv = fc->fuse->fops.truncate(
 			unwrap(fc, path),(off_t)length);
+	fcache_invalidate(fc->fuse->cache, unwrap(fc, path));
+	pcache_drop(node_search(fc->fuse, unwrap(fc, path)));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1783,13 +2008,17 @@ static long umfuse_ftruncate64(int fd, off_t length)
 		errno = EROFS;
 		return -1;
 	}
-	if (fc->fuse->fops.ftruncate == NULL)
+	umfuse_async_cancel(ft);
+	if (fc->fuse->fops.ftruncate == NULL) {
+		pcache_drop(ft->node);
 		return umfuse_truncate64(FILEPATH(ft),length);
-	else {
+	} else {
 		int rv;
 		fc->pid=um_mod_getpid();
 		rv = fc->fuse->fops.ftruncate(
 				FILEPATH(ft),(off_t)length,&ft->ffi);
+		fcache_invalidate(fc->fuse->cache, FILEPATH(ft));
+		pcache_drop(ft->node);
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("FTRUNCATE [%s] debug => path %s",fc->fuse->path,FILEPATH(ft));		
 		}
@@ -1851,6 +2080,7 @@ static long umfuse_utimes(char *path, struct timeval tv[2])
 			GMESSAGE("UTIME [%s] => %s ", fc->fuse->path, path);
 		rv = fc->fuse->fops.utime(unwrap(fc, path), &buf);
 	}
+	fcache_invalidate(fc->fuse->cache, unwrap(fc, path));
 	if (rv < 0) {
 		errno = -rv;
 		return -1;
@@ -1870,12 +2100,16 @@ static ssize_t umfuse_pread64(int fd, void *buf, size_t count, long long offset)
 	else {
 		struct fuse_context *fc=ft->context;
 		fc->pid=um_mod_getpid();
-		rv = fc->fuse->fops.read(
-				FILEPATH(ft),
-				buf,
-				count,
-				offset,
-				&ft->ffi);
+		if (umfuse_pagecache(ft))
+			rv = pcache_read(ft->node, &ft->ra, buf, count, offset,
+					umfuse_fill, ft);
+		else
+			rv = fc->fuse->fops.read(
+					FILEPATH(ft),
+					buf,
+					count,
+					offset,
+					&ft->ffi);
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("PREAD[%s:%d] => path:%s count:%u pos:%lld rv:%d",
 					fc->fuse->path,fd, FILEPATH(ft), count, offset, rv);
@@ -1900,8 +2134,12 @@ static ssize_t umfuse_pwrite64(int fd, const void *buf, size_t count, long long
 	} else {
 		struct fuse_context *fc=ft->context;
 		fc->pid=um_mod_getpid();
+		umfuse_async_cancel(ft);
 		rv = fc->fuse->fops.write(FILEPATH(ft),
 				buf, count, offset, &ft->ffi);
+		fcache_invalidate(fc->fuse->cache, FILEPATH(ft));
+		if (rv > 0)
+			pcache_invalidate(ft->node, offset, rv);
 		if (fc->fuse->flags & FUSE_DEBUG) {
 			GMESSAGE("PWRITE[%s:%d] => path:%s count:%u pos:%lld rv:%d",
 					fc->fuse->path, fd, FILEPATH(ft), count, offset, rv);
@@ -1940,6 +2178,11 @@ static loff_t umfuse_lseek64(int fd, loff_t offset, int whence)
 	switch (whence) {
 		case SEEK_SET:
 			ft->pos=offset;
+			/* rewinddir: read the directory again */
+			if (offset == 0 && ft->dirsnap != NULL) {
+				umdirsnap_put(ft->dirsnap);
+				ft->dirsnap = NULL;
+			}
 			break;
 		case SEEK_CUR:
 			ft->pos += offset;
@@ -1952,7 +2195,7 @@ static loff_t umfuse_lseek64(int fd, loff_t offset, int whence)
 				assert(fc != NULL);
 
 				fc->pid=um_mod_getpid();
-				rv = fc->fuse->fops.getattr(FILEPATH(ft),&buf);
+				rv = umfuse_getattr(fc, FILEPATH(ft), &buf, 0);
 				if (rv>=0) {
 					ft->pos = buf.st_size + offset;
 				} else {
@@ -2043,6 +2286,7 @@ init (void)
 	s.name="umfuse";
 	s.description="virtual file systems (user level FUSE)";
 	s.destructor=umfuse_destructor;
+	s.event_subscribe=umfuse_event_subscribe;
 	s.syscall=(sysfun *)calloc(scmap_scmapsize,sizeof(sysfun));
 	s.socket=(sysfun *)calloc(scmap_sockmapsize,sizeof(sysfun));
 	SERVICESYSCALL(s, mount, umfuse_mount);
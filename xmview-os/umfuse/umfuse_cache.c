@@ -0,0 +1,321 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   attribute/entry cache (FUSE-style timeouts)
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <umfuse_cache.h>
+
+#define FCACHE_HASH_SIZE 256
+#define FCACHE_HASH_MASK (FCACHE_HASH_SIZE-1)
+/* max number of entries per mount, the least recently used is dropped */
+#define FCACHE_MAX_ENTRIES 1024
+
+struct fcache_entry {
+	char *path;
+	long hashsum;
+	int err;                  /* 0 or -ENOENT (negative entry) */
+	struct stat st;
+	double attr_expire;
+	double entry_expire;
+	struct fcache_entry **pprevhash,*nexthash;
+	struct fcache_entry *prev,*next; /* LRU list, circular */
+};
+
+struct fuse_cache {
+	pthread_mutex_t mutex;
+	double timeout[3];
+	unsigned long gen;
+	int count;
+	struct fcache_entry *lru; /* least recently used */
+	struct fcache_entry *head[FCACHE_HASH_SIZE];
+	unsigned long hits;
+	unsigned long neghits;
+	unsigned long misses;
+	unsigned long invalidations;
+};
+
+static inline double fcache_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9;
+}
+
+static inline long fcache_hash_sum(const char *path) {
+	long sum = 0;
+	while (*path != 0) {
+		sum ^= ((sum << 5) + (sum >> 2) + *path);
+		path++;
+	}
+	return sum;
+}
+
+static inline int fcache_hash_mod(long sum)
+{
+	return sum & FCACHE_HASH_MASK;
+}
+
+static inline void lru_del(struct fuse_cache *cache, struct fcache_entry *e)
+{
+	if (e->next == e)
+		cache->lru = NULL;
+	else {
+		e->prev->next = e->next;
+		e->next->prev = e->prev;
+		if (cache->lru == e)
+			cache->lru = e->next;
+	}
+}
+
+/* the most recently used is the tail, i.e. cache->lru->prev */
+static inline void lru_add(struct fuse_cache *cache, struct fcache_entry *e)
+{
+	if (cache->lru == NULL) {
+		e->next = e->prev = e;
+		cache->lru = e;
+	} else {
+		e->next = cache->lru;
+		e->prev = cache->lru->prev;
+		e->prev->next = e;
+		cache->lru->prev = e;
+	}
+}
+
+static void fcache_del(struct fuse_cache *cache, struct fcache_entry *e)
+{
+	*(e->pprevhash) = e->nexthash;
+	if (e->nexthash)
+		e->nexthash->pprevhash = e->pprevhash;
+	lru_del(cache, e);
+	cache->count--;
+	free(e->path);
+	free(e);
+}
+
+static inline struct fcache_entry *fcache_find(struct fuse_cache *cache,
+		const char *path, long hashsum)
+{
+	struct fcache_entry *scan = cache->head[fcache_hash_mod(hashsum)];
+	while (scan != NULL) {
+		if (scan->hashsum == hashsum && strcmp(scan->path, path) == 0)
+			return scan;
+		scan = scan->nexthash;
+	}
+	return NULL;
+}
+
+struct fuse_cache *fcache_new(void)
+{
+	struct fuse_cache *new = calloc(1, sizeof(struct fuse_cache));
+	if (new != NULL) {
+		pthread_mutex_init(&new->mutex, NULL);
+		new->timeout[FCACHE_ATTR] = FCACHE_ATTR_TIMEOUT;
+		new->timeout[FCACHE_ENTRY] = FCACHE_ENTRY_TIMEOUT;
+		new->timeout[FCACHE_NEGATIVE] = FCACHE_NEGATIVE_TIMEOUT;
+	}
+	return new;
+}
+
+void fcache_free(struct fuse_cache *cache)
+{
+	if (cache) {
+		while (cache->lru != NULL)
+			fcache_del(cache, cache->lru);
+		pthread_mutex_destroy(&cache->mutex);
+		free(cache);
+	}
+}
+
+void fcache_timeout(struct fuse_cache *cache, int which, double timeout)
+{
+	if (cache && which >= FCACHE_ATTR && which <= FCACHE_NEGATIVE)
+		cache->timeout[which] = (timeout > 0) ? timeout : 0;
+}
+
+int fcache_get(struct fuse_cache *cache, const char *path, struct stat *buf,
+		int lookup, unsigned long *gen)
+{
+	long hashsum;
+	struct fcache_entry *e;
+	int rv = FCACHE_MISS;
+	if (cache == NULL)
+		return FCACHE_MISS;
+	hashsum = fcache_hash_sum(path);
+	pthread_mutex_lock(&cache->mutex);
+	*gen = cache->gen;
+	if ((e = fcache_find(cache, path, hashsum)) != NULL) {
+		double now = fcache_now();
+		if (e->err != 0) {
+			if (now < e->entry_expire) {
+				cache->neghits++;
+				rv = e->err;
+			}
+		} else if (now < e->attr_expire || (lookup && now < e->entry_expire)) {
+			cache->hits++;
+			*buf = e->st;
+			rv = 0;
+		}
+		if (rv == FCACHE_MISS) {
+			if (now >= e->entry_expire)
+				fcache_del(cache, e);
+		} else {
+			lru_del(cache, e);
+			lru_add(cache, e);
+		}
+	}
+	if (rv == FCACHE_MISS)
+		cache->misses++;
+	pthread_mutex_unlock(&cache->mutex);
+	return rv;
+}
+
+void fcache_put(struct fuse_cache *cache, const char *path, struct stat *buf,
+		int rv, unsigned long gen)
+{
+	long hashsum;
+	struct fcache_entry *e;
+	double now;
+	if (cache == NULL)
+		return;
+	if (rv == 0 && cache->timeout[FCACHE_ATTR] == 0 &&
+			cache->timeout[FCACHE_ENTRY] == 0)
+		return;
+	if (rv == -ENOENT && cache->timeout[FCACHE_NEGATIVE] == 0)
+		return;
+	if (rv != 0 && rv != -ENOENT)
+		return;
+	hashsum = fcache_hash_sum(path);
+	pthread_mutex_lock(&cache->mutex);
+	/* an invalidation raced with getattr: the result can be stale */
+	if (gen == cache->gen) {
+		if ((e = fcache_find(cache, path, hashsum)) != NULL)
+			lru_del(cache, e);
+		else {
+			if (cache->count >= FCACHE_MAX_ENTRIES)
+				fcache_del(cache, cache->lru);
+			if ((e = malloc(sizeof(struct fcache_entry))) != NULL) {
+				int hashkey = fcache_hash_mod(hashsum);
+				e->path = strdup(path);
+				e->hashsum = hashsum;
+				if (cache->head[hashkey] != NULL)
+					cache->head[hashkey]->pprevhash = &(e->nexthash);
+				e->nexthash = cache->head[hashkey];
+				e->pprevhash = &(cache->head[hashkey]);
+				cache->head[hashkey] = e;
+				cache->count++;
+			}
+		}
+		if (e != NULL) {
+			now = fcache_now();
+			e->err = rv;
+			if (rv == 0) {
+				e->st = *buf;
+				e->attr_expire = now + cache->timeout[FCACHE_ATTR];
+				e->entry_expire = now + cache->timeout[FCACHE_ENTRY];
+			} else
+				e->attr_expire = e->entry_expire = now + cache->timeout[FCACHE_NEGATIVE];
+			lru_add(cache, e);
+		}
+	}
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void fcache_invalidate(struct fuse_cache *cache, const char *path)
+{
+	struct fcache_entry *e;
+	if (cache == NULL)
+		return;
+	pthread_mutex_lock(&cache->mutex);
+	cache->gen++;
+	if ((e = fcache_find(cache, path, fcache_hash_sum(path))) != NULL) {
+		fcache_del(cache, e);
+		cache->invalidations++;
+	}
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void fcache_invalidate_tree(struct fuse_cache *cache, const char *path)
+{
+	int len = strlen(path);
+	if (cache == NULL)
+		return;
+	/* "/" is the root: everything is below it */
+	if (len == 1 && *path == '/')
+		len = 0;
+	pthread_mutex_lock(&cache->mutex);
+	cache->gen++;
+	if (cache->lru != NULL) {
+		struct fcache_entry *e = cache->lru;
+		int n = cache->count;
+		/* entries are deleted while scanning, count them instead of
+		 * looking for the end of the circular list */
+		while (n-- > 0) {
+			struct fcache_entry *next = e->next;
+			if (strncmp(e->path, path, len) == 0 &&
+					(e->path[len] == '/' || e->path[len] == 0 || len == 0)) {
+				fcache_del(cache, e);
+				cache->invalidations++;
+			}
+			e = next;
+		}
+	}
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void fcache_invalidate_parent(struct fuse_cache *cache, const char *path)
+{
+	char *slash;
+	fcache_invalidate(cache, path);
+	if ((slash = strrchr(path, '/')) != NULL) {
+		if (slash == path)
+			fcache_invalidate(cache, "/");
+		else {
+			char *ppath = strndup(path, slash - path);
+			if (ppath != NULL) {
+				fcache_invalidate(cache, ppath);
+				free(ppath);
+			}
+		}
+	}
+}
+
+int fcache_stats(struct fuse_cache *cache, char *buf, size_t size)
+{
+	unsigned long lookups;
+	int rv;
+	if (cache == NULL)
+		return snprintf(buf, size, "cache disabled");
+	pthread_mutex_lock(&cache->mutex);
+	lookups = cache->hits + cache->neghits + cache->misses;
+	rv = snprintf(buf, size,
+			"attr cache: %d entries, %lu hits, %lu negative hits, %lu misses, hit rate %lu%%, %lu invalidations",
+			cache->count, cache->hits, cache->neghits, cache->misses,
+			lookups ? ((cache->hits + cache->neghits) * 100) / lookups : 0,
+			cache->invalidations);
+	pthread_mutex_unlock(&cache->mutex);
+	return rv;
+}
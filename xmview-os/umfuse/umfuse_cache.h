@@ -0,0 +1,70 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   attribute/entry cache (FUSE-style timeouts)
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _UMFUSE_CACHE_H
+#define _UMFUSE_CACHE_H
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* The cache is per mount and keyed by the (unwrapped) path.
+ * A positive entry keeps the result of getattr: the attributes are valid
+ * for attr_timeout seconds, the existence of the name for entry_timeout
+ * seconds. A negative entry records ENOENT for negative_timeout seconds.
+ * A timeout equal to zero disables the corresponding cache. */
+
+#define FCACHE_ATTR 0
+#define FCACHE_ENTRY 1
+#define FCACHE_NEGATIVE 2
+
+/* defaults, the same of the FUSE library */
+#define FCACHE_ATTR_TIMEOUT 1.0
+#define FCACHE_ENTRY_TIMEOUT 1.0
+#define FCACHE_NEGATIVE_TIMEOUT 0.0
+
+/* fcache_get return value when the caller has to ask the file system */
+#define FCACHE_MISS 1
+
+struct fuse_cache;
+
+struct fuse_cache *fcache_new(void);
+void fcache_free(struct fuse_cache *cache);
+void fcache_timeout(struct fuse_cache *cache, int which, double timeout);
+
+/* lookup!=0: the caller just needs to know whether path exists.
+ * returns 0 (buf filled), -ENOENT or FCACHE_MISS; on a miss *gen must
+ * be passed back to fcache_put */
+int fcache_get(struct fuse_cache *cache, const char *path, struct stat *buf,
+		int lookup, unsigned long *gen);
+/* rv is the return value of getattr. The result is discarded if
+ * the cache has been invalidated since fcache_get */
+void fcache_put(struct fuse_cache *cache, const char *path, struct stat *buf,
+		int rv, unsigned long gen);
+
+void fcache_invalidate(struct fuse_cache *cache, const char *path);
+/* path and all the entries below it (rename of directories) */
+void fcache_invalidate_tree(struct fuse_cache *cache, const char *path);
+/* path and its parent directory (nlink, mtime...) */
+void fcache_invalidate_parent(struct fuse_cache *cache, const char *path);
+
+int fcache_stats(struct fuse_cache *cache, char *buf, size_t size);
+
+#endif
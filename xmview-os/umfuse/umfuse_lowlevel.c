@@ -0,0 +1,1506 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   support for FUSE low-level (inode based) file systems
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+/* A low-level file system is hosted by registering a path based
+ * fuse_operations table (ll_oper) in place of the module's one: umfuse.c
+ * and its caches do not change. Paths are translated into node ids by a
+ * dentry table keyed by (parent node id, name): a lookup request reaches
+ * the file system only when a component is missing or its entry_timeout
+ * has expired. Each dentry keeps the lookup count the file system has
+ * to be told about by forget when the dentry is dropped.
+ * The path is walked only by the path based calls, i.e. by the lookups:
+ * open, opendir and create put the node id in the file handle seen by
+ * umfuse.c (fi->fh points to a struct ll_file), so the calls on an open
+ * file reach the file system by node id. An open node id is pinned: the
+ * forgets of its lookups are deferred to the last release, as the
+ * kernel does for the inodes of the open files.
+ *
+ * Replies can be sent by the file system from any thread, the caller
+ * waits for the reply of each request. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/statvfs.h>
+#include <fuse.h>
+#include <fuse_lowlevel.h>
+#include <fuse_opt.h>
+#include <config.h>
+
+#define LL_HASH_SIZE 512
+#define LL_HASH_MASK (LL_HASH_SIZE-1)
+/* max number of dentries, unused leaves are dropped (and forgotten) */
+#ifndef LL_MAX_DENTRIES
+#define LL_MAX_DENTRIES 4096
+#endif
+#define LL_READDIR_SIZE 8192
+
+struct ll_dentry {
+	fuse_ino_t parent;
+	char *name;
+	long hashsum;
+	fuse_ino_t ino;
+	unsigned long nlookup;
+	double expire;              /* entry_timeout */
+	struct ll_dentry *pdentry;  /* dentry of the parent dir, NULL for root */
+	int children;               /* dentries having this one as pdentry */
+	struct ll_dentry **pprevhash,*nexthash;
+	struct ll_dentry **pprevino,*nextino;
+	struct ll_dentry *prev,*next; /* LRU list, circular */
+};
+
+/* a node id of open files */
+struct ll_inode {
+	fuse_ino_t ino;
+	int open;
+	unsigned long nlookup;      /* forgets deferred to the last release */
+	struct ll_inode **pprev,*next;
+};
+
+/* fi->fh of the open files, as seen by umfuse.c */
+struct ll_file {
+	struct ll_inode *inode;
+	uint64_t fh;                /* the file handle of the file system */
+};
+
+struct fuse_ll {
+	struct fuse_lowlevel_ops op;
+	void *userdata;
+	pthread_mutex_t mutex;
+	int count;
+	struct ll_dentry *lru;     /* least recently used */
+	struct ll_dentry *head[LL_HASH_SIZE];     /* (parent, name) */
+	struct ll_dentry *ino_head[LL_HASH_SIZE]; /* node id */
+	struct ll_inode *open_head[LL_HASH_SIZE]; /* node id of open files */
+};
+
+struct fuse_session {
+	struct fuse *f;
+	struct fuse_ll *ll;
+	int exited;
+};
+
+struct fuse_req {
+	struct fuse_ll *ll;
+	struct fuse_ctx ctx;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int replied;
+	int err;
+	/* reply buffers */
+	struct fuse_entry_param *entry;
+	struct stat *attr;
+	struct fuse_file_info *fi;
+	struct statvfs *stbuf;
+	char *buf;
+	size_t size;
+	size_t count;
+};
+
+/* the same layout of the kernel interface */
+struct ll_dirent {
+	uint64_t ino;
+	uint64_t off;
+	uint32_t namelen;
+	uint32_t type;
+	char name[0];
+};
+#define LL_DIRENT_NAME_OFFSET ((size_t) &((struct ll_dirent *) 0)->name)
+#define LL_DIRENT_ALIGN(X) (((X) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1))
+
+static inline double ll_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9;
+}
+
+static inline struct fuse_ll *ll_get(void)
+{
+	return fuse_get_context()->private_data;
+}
+
+/* REQUESTS */
+
+static void ll_req_init(struct fuse_req *req, struct fuse_ll *ll)
+{
+	struct fuse_context *fc = fuse_get_context();
+	memset(req, 0, sizeof(struct fuse_req));
+	req->ll = ll;
+	req->ctx.uid = fc->uid;
+	req->ctx.gid = fc->gid;
+	req->ctx.pid = fc->pid;
+	pthread_mutex_init(&req->mutex, NULL);
+	pthread_cond_init(&req->cond, NULL);
+}
+
+/* wait for the reply: returns 0 or -errno */
+static int ll_req_wait(struct fuse_req *req)
+{
+	pthread_mutex_lock(&req->mutex);
+	while (!req->replied)
+		pthread_cond_wait(&req->cond, &req->mutex);
+	pthread_mutex_unlock(&req->mutex);
+	pthread_mutex_destroy(&req->mutex);
+	pthread_cond_destroy(&req->cond);
+	return req->err;
+}
+
+static int ll_reply(fuse_req_t req, int err)
+{
+	pthread_mutex_lock(&req->mutex);
+	req->err = -err;
+	req->replied = 1;
+	pthread_cond_signal(&req->cond);
+	pthread_mutex_unlock(&req->mutex);
+	return 0;
+}
+
+void *fuse_req_userdata(fuse_req_t req)
+{
+	return req->ll->userdata;
+}
+
+const struct fuse_ctx *fuse_req_ctx(fuse_req_t req)
+{
+	return &req->ctx;
+}
+
+void fuse_req_interrupt_func(fuse_req_t req, fuse_interrupt_func_t func,
+		void *data)
+{
+}
+
+int fuse_req_interrupted(fuse_req_t req)
+{
+	return 0;
+}
+
+int fuse_reply_err(fuse_req_t req, int err)
+{
+	return ll_reply(req, err);
+}
+
+void fuse_reply_none(fuse_req_t req)
+{
+	ll_reply(req, 0);
+}
+
+int fuse_reply_entry(fuse_req_t req, const struct fuse_entry_param *e)
+{
+	if (req->entry)
+		*req->entry = *e;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_create(fuse_req_t req, const struct fuse_entry_param *e,
+		const struct fuse_file_info *fi)
+{
+	if (req->entry)
+		*req->entry = *e;
+	if (req->fi && req->fi != fi)
+		*req->fi = *fi;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_attr(fuse_req_t req, const struct stat *attr,
+		double attr_timeout)
+{
+	if (req->attr)
+		*req->attr = *attr;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_readlink(fuse_req_t req, const char *link)
+{
+	if (req->buf && req->size > 0) {
+		strncpy(req->buf, link, req->size);
+		req->buf[req->size - 1] = 0;
+	}
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_open(fuse_req_t req, const struct fuse_file_info *fi)
+{
+	if (req->fi && req->fi != fi)
+		*req->fi = *fi;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_write(fuse_req_t req, size_t count)
+{
+	req->count = count;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_buf(fuse_req_t req, const char *buf, size_t size)
+{
+	if (size > req->size)
+		size = req->size;
+	if (size > 0)
+		memcpy(req->buf, buf, size);
+	req->count = size;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_iov(fuse_req_t req, const struct iovec *iov, int count)
+{
+	size_t size = 0;
+	int i;
+	for (i = 0; i < count && size < req->size; i++) {
+		size_t len = iov[i].iov_len;
+		if (len > req->size - size)
+			len = req->size - size;
+		memcpy(req->buf + size, iov[i].iov_base, len);
+		size += len;
+	}
+	req->count = size;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_statfs(fuse_req_t req, const struct statvfs *stbuf)
+{
+	if (req->stbuf)
+		*req->stbuf = *stbuf;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_xattr(fuse_req_t req, size_t count)
+{
+	req->count = count;
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_lock(fuse_req_t req, struct flock *lock)
+{
+	return ll_reply(req, 0);
+}
+
+int fuse_reply_bmap(fuse_req_t req, uint64_t idx)
+{
+	req->count = idx;
+	return ll_reply(req, 0);
+}
+
+size_t fuse_add_direntry(fuse_req_t req, char *buf, size_t bufsize,
+		const char *name, const struct stat *stbuf, off_t off)
+{
+	size_t namelen = strlen(name);
+	size_t entsize = LL_DIRENT_ALIGN(LL_DIRENT_NAME_OFFSET + namelen);
+	if (buf != NULL && entsize <= bufsize) {
+		struct ll_dirent *de = (struct ll_dirent *) buf;
+		de->ino = stbuf->st_ino;
+		de->off = off;
+		de->namelen = namelen;
+		de->type = (stbuf->st_mode & S_IFMT) >> 12;
+		memcpy(de->name, name, namelen);
+		memset(de->name + namelen, 0, entsize - LL_DIRENT_NAME_OFFSET - namelen);
+	}
+	return entsize;
+}
+
+/* DENTRY TABLE */
+
+static inline long ll_hash_sum(fuse_ino_t parent, const char *name)
+{
+	long sum = (long) parent;
+	while (*name != 0) {
+		sum ^= ((sum << 5) + (sum >> 2) + *name);
+		name++;
+	}
+	return sum;
+}
+
+static inline int ll_hash_mod(long sum)
+{
+	return sum & LL_HASH_MASK;
+}
+
+static struct ll_dentry *ll_find(struct fuse_ll *ll, fuse_ino_t parent,
+		const char *name, long hashsum)
+{
+	struct ll_dentry *scan = ll->head[ll_hash_mod(hashsum)];
+	while (scan != NULL) {
+		if (scan->hashsum == hashsum && scan->parent == parent &&
+				strcmp(scan->name, name) == 0)
+			return scan;
+		scan = scan->nexthash;
+	}
+	return NULL;
+}
+
+static inline void lru_del(struct fuse_ll *ll, struct ll_dentry *d)
+{
+	if (d->next == d)
+		ll->lru = NULL;
+	else {
+		d->prev->next = d->next;
+		d->next->prev = d->prev;
+		if (ll->lru == d)
+			ll->lru = d->next;
+	}
+}
+
+static inline void lru_add(struct fuse_ll *ll, struct ll_dentry *d)
+{
+	if (ll->lru == NULL) {
+		d->next = d->prev = d;
+		ll->lru = d;
+	} else {
+		d->next = ll->lru;
+		d->prev = ll->lru->prev;
+		d->prev->next = d;
+		ll->lru->prev = d;
+	}
+}
+
+static void ll_hash_add(struct fuse_ll *ll, struct ll_dentry *d)
+{
+	int hashkey = ll_hash_mod(d->hashsum);
+	if (ll->head[hashkey] != NULL)
+		ll->head[hashkey]->pprevhash = &(d->nexthash);
+	d->nexthash = ll->head[hashkey];
+	d->pprevhash = &(ll->head[hashkey]);
+	ll->head[hashkey] = d;
+}
+
+static void ll_hash_del(struct ll_dentry *d)
+{
+	*(d->pprevhash) = d->nexthash;
+	if (d->nexthash)
+		d->nexthash->pprevhash = d->pprevhash;
+}
+
+static struct ll_dentry *ll_find_ino(struct fuse_ll *ll, fuse_ino_t ino)
+{
+	struct ll_dentry *scan = ll->ino_head[ll_hash_mod((long) ino)];
+	while (scan != NULL) {
+		if (scan->ino == ino)
+			return scan;
+		scan = scan->nextino;
+	}
+	return NULL;
+}
+
+static void ll_ino_add(struct fuse_ll *ll, struct ll_dentry *d)
+{
+	int hashkey = ll_hash_mod((long) d->ino);
+	if (ll->ino_head[hashkey] != NULL)
+		ll->ino_head[hashkey]->pprevino = &(d->nextino);
+	d->nextino = ll->ino_head[hashkey];
+	d->pprevino = &(ll->ino_head[hashkey]);
+	ll->ino_head[hashkey] = d;
+}
+
+static void ll_ino_del(struct ll_dentry *d)
+{
+	*(d->pprevino) = d->nextino;
+	if (d->nextino)
+		d->nextino->pprevino = d->pprevino;
+}
+
+/* directories cannot be hard linked: a node id used as a parent
+ * has one dentry (none for the root) */
+static void ll_set_pdentry(struct fuse_ll *ll, struct ll_dentry *d)
+{
+	if (d->pdentry)
+		d->pdentry->children--;
+	d->pdentry = (d->parent == FUSE_ROOT_ID) ? NULL : ll_find_ino(ll, d->parent);
+	if (d->pdentry == d)
+		d->pdentry = NULL;
+	if (d->pdentry)
+		d->pdentry->children++;
+}
+
+static void ll_unhash(struct fuse_ll *ll, struct ll_dentry *d,
+		struct ll_dentry **forget);
+
+/* the entries below d are keyed by its node id: drop them when
+ * the node id gets forgotten */
+static void ll_unhash_children(struct fuse_ll *ll, struct ll_dentry *d,
+		struct ll_dentry **forget)
+{
+	while (d->children > 0) {
+		struct ll_dentry *scan = ll->lru;
+		int n = ll->count;
+		while (n-- > 0 && scan->pdentry != d)
+			scan = scan->next;
+		if (scan->pdentry != d)
+			break;
+		/* the scan restarts: scan->next may be in the subtree */
+		ll_unhash(ll, scan, forget);
+	}
+}
+
+/* unlink d (and its subtree) from the table: the dentries are queued
+ * in *forget, their lookup counts have to be sent to the file system */
+static void ll_unhash(struct fuse_ll *ll, struct ll_dentry *d,
+		struct ll_dentry **forget)
+{
+	ll_unhash_children(ll, d, forget);
+	ll_hash_del(d);
+	ll_ino_del(d);
+	lru_del(ll, d);
+	if (d->pdentry)
+		d->pdentry->children--;
+	ll->count--;
+	d->next = *forget;
+	*forget = d;
+}
+
+static struct ll_inode *ll_find_open(struct fuse_ll *ll, fuse_ino_t ino)
+{
+	struct ll_inode *scan = ll->open_head[ll_hash_mod((long) ino)];
+	while (scan != NULL) {
+		if (scan->ino == ino)
+			return scan;
+		scan = scan->next;
+	}
+	return NULL;
+}
+
+static void ll_forget(struct fuse_ll *ll, fuse_ino_t ino, unsigned long nlookup)
+{
+	struct ll_inode *inode;
+	pthread_mutex_lock(&ll->mutex);
+	/* the node id of an open file is forgotten by its last release */
+	if (nlookup > 0 && (inode = ll_find_open(ll, ino)) != NULL) {
+		inode->nlookup += nlookup;
+		nlookup = 0;
+	}
+	pthread_mutex_unlock(&ll->mutex);
+	if (ll->op.forget && nlookup > 0) {
+		struct fuse_req req;
+		ll_req_init(&req, ll);
+		ll->op.forget(&req, ino, nlookup);
+		ll_req_wait(&req);
+	}
+}
+
+/* send the forget requests (without holding the table lock) */
+static void ll_forget_list(struct fuse_ll *ll, struct ll_dentry *forget)
+{
+	while (forget != NULL) {
+		struct ll_dentry *next = forget->next;
+		ll_forget(ll, forget->ino, forget->nlookup);
+		free(forget->name);
+		free(forget);
+		forget = next;
+	}
+}
+
+/* drop least recently used leaves until there is room for a new dentry */
+static void ll_shrink(struct fuse_ll *ll, struct ll_dentry **forget)
+{
+	struct ll_dentry *scan = ll->lru;
+	int n = ll->count;
+	while (ll->count >= LL_MAX_DENTRIES && n-- > 0) {
+		struct ll_dentry *next = scan->next;
+		if (scan->children == 0)
+			ll_unhash(ll, scan, forget);
+		scan = next;
+	}
+}
+
+/* record a successful lookup (or mknod, mkdir, create...) of
+ * name in parent: the file system has incremented the lookup count */
+static void ll_enter(struct fuse_ll *ll, fuse_ino_t parent, const char *name,
+		struct fuse_entry_param *e)
+{
+	long hashsum = ll_hash_sum(parent, name);
+	struct ll_dentry *d;
+	struct ll_dentry *forget = NULL;
+	pthread_mutex_lock(&ll->mutex);
+	if ((d = ll_find(ll, parent, name, hashsum)) != NULL) {
+		lru_del(ll, d);
+		if (d->ino != e->ino) {
+			/* replaced behind our back: forget the old node id */
+			struct ll_dentry *old = malloc(sizeof(struct ll_dentry));
+			ll_unhash_children(ll, d, &forget);
+			if (old) {
+				old->ino = d->ino;
+				old->nlookup = d->nlookup;
+				old->name = NULL;
+				old->next = forget;
+				forget = old;
+			}
+			ll_ino_del(d);
+			d->ino = e->ino;
+			d->nlookup = 0;
+			ll_ino_add(ll, d);
+		}
+	} else {
+		ll_shrink(ll, &forget);
+		if ((d = calloc(1, sizeof(struct ll_dentry))) != NULL &&
+				(d->name = strdup(name)) != NULL) {
+			d->parent = parent;
+			d->hashsum = hashsum;
+			d->ino = e->ino;
+			ll_set_pdentry(ll, d);
+			ll_hash_add(ll, d);
+			ll_ino_add(ll, d);
+			ll->count++;
+		} else {
+			free(d);
+			d = NULL;
+		}
+	}
+	if (d != NULL) {
+		d->nlookup++;
+		d->expire = ll_now() + e->entry_timeout;
+		lru_add(ll, d);
+	}
+	pthread_mutex_unlock(&ll->mutex);
+	ll_forget_list(ll, forget);
+	/* no memory: give the lookup back */
+	if (d == NULL)
+		ll_forget(ll, e->ino, 1);
+}
+
+static void ll_drop(struct fuse_ll *ll, fuse_ino_t parent, const char *name)
+{
+	struct ll_dentry *d;
+	struct ll_dentry *forget = NULL;
+	pthread_mutex_lock(&ll->mutex);
+	if ((d = ll_find(ll, parent, name, ll_hash_sum(parent, name))) != NULL)
+		ll_unhash(ll, d, &forget);
+	pthread_mutex_unlock(&ll->mutex);
+	ll_forget_list(ll, forget);
+}
+
+static void ll_move(struct fuse_ll *ll, fuse_ino_t parent, const char *name,
+		fuse_ino_t newparent, const char *newname)
+{
+	struct ll_dentry *d;
+	struct ll_dentry *forget = NULL;
+	pthread_mutex_lock(&ll->mutex);
+	/* the target (if any) has been replaced */
+	if ((d = ll_find(ll, newparent, newname, ll_hash_sum(newparent, newname))) != NULL)
+		ll_unhash(ll, d, &forget);
+	if ((d = ll_find(ll, parent, name, ll_hash_sum(parent, name))) != NULL) {
+		char *s = strdup(newname);
+		if (s == NULL)
+			ll_unhash(ll, d, &forget);
+		else {
+			/* the subtree stays, it is keyed by the node id of d */
+			ll_hash_del(d);
+			free(d->name);
+			d->name = s;
+			d->parent = newparent;
+			d->hashsum = ll_hash_sum(newparent, newname);
+			ll_set_pdentry(ll, d);
+			ll_hash_add(ll, d);
+		}
+	}
+	pthread_mutex_unlock(&ll->mutex);
+	ll_forget_list(ll, forget);
+}
+
+/* lookup name in parent */
+static int ll_child(struct fuse_ll *ll, fuse_ino_t parent, const char *name,
+		fuse_ino_t *ino)
+{
+	long hashsum = ll_hash_sum(parent, name);
+	struct ll_dentry *d;
+	struct fuse_entry_param e;
+	struct fuse_req req;
+	int rv;
+	pthread_mutex_lock(&ll->mutex);
+	if ((d = ll_find(ll, parent, name, hashsum)) != NULL &&
+			ll_now() < d->expire) {
+		lru_del(ll, d);
+		lru_add(ll, d);
+		*ino = d->ino;
+		pthread_mutex_unlock(&ll->mutex);
+		return 0;
+	}
+	pthread_mutex_unlock(&ll->mutex);
+	if (ll->op.lookup == NULL)
+		return -ENOSYS;
+	memset(&e, 0, sizeof(e));
+	ll_req_init(&req, ll);
+	req.entry = &e;
+	ll->op.lookup(&req, parent, name);
+	rv = ll_req_wait(&req);
+	/* ino==0 is a negative entry */
+	if (rv == 0 && e.ino == 0)
+		rv = -ENOENT;
+	if (rv == 0) {
+		*ino = e.ino;
+		ll_enter(ll, parent, name, &e);
+	} else if (rv == -ENOENT)
+		ll_drop(ll, parent, name);
+	return rv;
+}
+
+/* path -> node id */
+static int ll_walk(struct fuse_ll *ll, const char *path, int len,
+		fuse_ino_t *ino)
+{
+	char name[NAME_MAX + 1];
+	const char *s = path;
+	const char *end = path + len;
+	*ino = FUSE_ROOT_ID;
+	while (s < end) {
+		const char *e;
+		int rv;
+		while (s < end && *s == '/')
+			s++;
+		if (s == end)
+			break;
+		for (e = s; e < end && *e != '/'; e++)
+			;
+		if (e - s > NAME_MAX)
+			return -ENAMETOOLONG;
+		memcpy(name, s, e - s);
+		name[e - s] = 0;
+		if ((rv = ll_child(ll, *ino, name, ino)) < 0)
+			return rv;
+		s = e;
+	}
+	return 0;
+}
+
+static inline int ll_resolve(struct fuse_ll *ll, const char *path, fuse_ino_t *ino)
+{
+	return ll_walk(ll, path, strlen(path), ino);
+}
+
+/* parent node id and last component name (points into path) */
+static int ll_resolve_parent(struct fuse_ll *ll, const char *path,
+		fuse_ino_t *parent, const char **name)
+{
+	const char *slash = strrchr(path, '/');
+	if (slash == NULL || slash[1] == 0)
+		return -EINVAL;
+	*name = slash + 1;
+	if (strlen(*name) > NAME_MAX)
+		return -ENAMETOOLONG;
+	return ll_walk(ll, path, slash - path, parent);
+}
+
+/* OPEN FILES */
+
+/* fi has been opened on ino: fi->fh becomes a struct ll_file */
+static int ll_file_new(struct fuse_ll *ll, fuse_ino_t ino,
+		struct fuse_file_info *fi, int isdir)
+{
+	struct ll_file *file = malloc(sizeof(struct ll_file));
+	struct ll_inode *inode = NULL;
+	if (file != NULL) {
+		pthread_mutex_lock(&ll->mutex);
+		if ((inode = ll_find_open(ll, ino)) == NULL &&
+				(inode = calloc(1, sizeof(struct ll_inode))) != NULL) {
+			int hashkey = ll_hash_mod((long) ino);
+			inode->ino = ino;
+			if (ll->open_head[hashkey] != NULL)
+				ll->open_head[hashkey]->pprev = &(inode->next);
+			inode->next = ll->open_head[hashkey];
+			inode->pprev = &(ll->open_head[hashkey]);
+			ll->open_head[hashkey] = inode;
+		}
+		if (inode != NULL)
+			inode->open++;
+		pthread_mutex_unlock(&ll->mutex);
+	}
+	if (inode == NULL) {
+		/* no memory: the file system has to close it */
+		void (*release)(fuse_req_t, fuse_ino_t, struct fuse_file_info *) =
+			isdir ? ll->op.releasedir : ll->op.release;
+		free(file);
+		if (release) {
+			struct fuse_req req;
+			ll_req_init(&req, ll);
+			release(&req, ino, fi);
+			ll_req_wait(&req);
+		}
+		return -ENOMEM;
+	}
+	file->inode = inode;
+	file->fh = fi->fh;
+	fi->fh = (uint64_t) (uintptr_t) file;
+	return 0;
+}
+
+static void ll_file_del(struct fuse_ll *ll, struct ll_file *file)
+{
+	struct ll_inode *inode = file->inode;
+	fuse_ino_t ino = inode->ino;
+	unsigned long nlookup = 0;
+	pthread_mutex_lock(&ll->mutex);
+	if (--inode->open == 0) {
+		*(inode->pprev) = inode->next;
+		if (inode->next)
+			inode->next->pprev = inode->pprev;
+		nlookup = inode->nlookup;
+		free(inode);
+	}
+	pthread_mutex_unlock(&ll->mutex);
+	ll_forget(ll, ino, nlookup);
+	free(file);
+}
+
+/* node id of path or, when *fi is an open file, its node id:
+ * *fi is changed to llfi, a copy with the file handle of the file system */
+static int ll_resolve_fi(struct fuse_ll *ll, const char *path,
+		struct fuse_file_info **fi, struct fuse_file_info *llfi, fuse_ino_t *ino)
+{
+	struct ll_file *file;
+	if (*fi == NULL)
+		return ll_resolve(ll, path, ino);
+	file = (struct ll_file *) (uintptr_t) (*fi)->fh;
+	*llfi = **fi;
+	llfi->fh = file->fh;
+	*fi = llfi;
+	*ino = file->inode->ino;
+	return 0;
+}
+
+/* PATH BASED OPERATIONS */
+
+static int ll_fgetattr(const char *path, struct stat *stbuf,
+		struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.getattr == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	req.attr = stbuf;
+	ll->op.getattr(&req, ino, fi);
+	return ll_req_wait(&req);
+}
+
+static int ll_getattr(const char *path, struct stat *stbuf)
+{
+	return ll_fgetattr(path, stbuf, NULL);
+}
+
+static int ll_readlink(const char *path, char *buf, size_t size)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	fuse_ino_t ino;
+	int rv = ll_resolve(ll, path, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.readlink == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	req.buf = buf;
+	req.size = size;
+	ll->op.readlink(&req, ino);
+	return ll_req_wait(&req);
+}
+
+/* common part of mknod, mkdir, symlink, link and create */
+static void ll_entry_req_init(struct fuse_req *req, struct fuse_ll *ll,
+		struct fuse_entry_param *e)
+{
+	ll_req_init(req, ll);
+	memset(e, 0, sizeof(struct fuse_entry_param));
+	req->entry = e;
+}
+
+static int ll_newentry(struct fuse_ll *ll, struct fuse_req *req,
+		fuse_ino_t parent, const char *name)
+{
+	int rv = ll_req_wait(req);
+	if (rv == 0 && req->entry->ino != 0)
+		ll_enter(ll, parent, name, req->entry);
+	return rv;
+}
+
+static int ll_mknod(const char *path, mode_t mode, dev_t rdev)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_entry_param e;
+	fuse_ino_t parent;
+	const char *name;
+	int rv = ll_resolve_parent(ll, path, &parent, &name);
+	if (rv < 0)
+		return rv;
+	if (ll->op.mknod == NULL)
+		return -ENOSYS;
+	ll_entry_req_init(&req, ll, &e);
+	ll->op.mknod(&req, parent, name, mode, rdev);
+	return ll_newentry(ll, &req, parent, name);
+}
+
+static int ll_mkdir(const char *path, mode_t mode)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_entry_param e;
+	fuse_ino_t parent;
+	const char *name;
+	int rv = ll_resolve_parent(ll, path, &parent, &name);
+	if (rv < 0)
+		return rv;
+	if (ll->op.mkdir == NULL)
+		return -ENOSYS;
+	ll_entry_req_init(&req, ll, &e);
+	ll->op.mkdir(&req, parent, name, mode);
+	return ll_newentry(ll, &req, parent, name);
+}
+
+static int ll_symlink(const char *link, const char *path)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_entry_param e;
+	fuse_ino_t parent;
+	const char *name;
+	int rv = ll_resolve_parent(ll, path, &parent, &name);
+	if (rv < 0)
+		return rv;
+	if (ll->op.symlink == NULL)
+		return -ENOSYS;
+	ll_entry_req_init(&req, ll, &e);
+	ll->op.symlink(&req, link, parent, name);
+	return ll_newentry(ll, &req, parent, name);
+}
+
+static int ll_link(const char *oldpath, const char *newpath)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_entry_param e;
+	fuse_ino_t ino, parent;
+	const char *name;
+	int rv = ll_resolve(ll, oldpath, &ino);
+	if (rv < 0)
+		return rv;
+	if ((rv = ll_resolve_parent(ll, newpath, &parent, &name)) < 0)
+		return rv;
+	if (ll->op.link == NULL)
+		return -ENOSYS;
+	ll_entry_req_init(&req, ll, &e);
+	ll->op.link(&req, ino, parent, name);
+	return ll_newentry(ll, &req, parent, name);
+}
+
+static int ll_remove(const char *path, int isdir)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	fuse_ino_t parent;
+	const char *name;
+	int rv = ll_resolve_parent(ll, path, &parent, &name);
+	if (rv < 0)
+		return rv;
+	if ((isdir ? ll->op.rmdir : ll->op.unlink) == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	if (isdir)
+		ll->op.rmdir(&req, parent, name);
+	else
+		ll->op.unlink(&req, parent, name);
+	if ((rv = ll_req_wait(&req)) == 0)
+		ll_drop(ll, parent, name);
+	return rv;
+}
+
+static int ll_unlink(const char *path)
+{
+	return ll_remove(path, 0);
+}
+
+static int ll_rmdir(const char *path)
+{
+	return ll_remove(path, 1);
+}
+
+static int ll_rename(const char *oldpath, const char *newpath)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	fuse_ino_t parent, newparent;
+	const char *name, *newname;
+	int rv = ll_resolve_parent(ll, oldpath, &parent, &name);
+	if (rv < 0)
+		return rv;
+	if ((rv = ll_resolve_parent(ll, newpath, &newparent, &newname)) < 0)
+		return rv;
+	if (ll->op.rename == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	ll->op.rename(&req, parent, name, newparent, newname);
+	if ((rv = ll_req_wait(&req)) == 0)
+		ll_move(ll, parent, name, newparent, newname);
+	return rv;
+}
+
+static int ll_setattr(const char *path, struct stat *attr, int to_set,
+		struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct stat newattr;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.setattr == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	req.attr = &newattr;
+	ll->op.setattr(&req, ino, attr, to_set, fi);
+	return ll_req_wait(&req);
+}
+
+static int ll_chmod(const char *path, mode_t mode)
+{
+	struct stat attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.st_mode = mode;
+	return ll_setattr(path, &attr, FUSE_SET_ATTR_MODE, NULL);
+}
+
+static int ll_chown(const char *path, uid_t uid, gid_t gid)
+{
+	struct stat attr;
+	int to_set = 0;
+	memset(&attr, 0, sizeof(attr));
+	attr.st_uid = uid;
+	attr.st_gid = gid;
+	if (uid != (uid_t) -1)
+		to_set |= FUSE_SET_ATTR_UID;
+	if (gid != (gid_t) -1)
+		to_set |= FUSE_SET_ATTR_GID;
+	return ll_setattr(path, &attr, to_set, NULL);
+}
+
+static int ll_ftruncate(const char *path, off_t size, struct fuse_file_info *fi)
+{
+	struct stat attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.st_size = size;
+	return ll_setattr(path, &attr, FUSE_SET_ATTR_SIZE, fi);
+}
+
+static int ll_truncate(const char *path, off_t size)
+{
+	return ll_ftruncate(path, size, NULL);
+}
+
+static int ll_utimens(const char *path, const struct timespec tv[2])
+{
+	struct stat attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.st_atim = tv[0];
+	attr.st_mtim = tv[1];
+	return ll_setattr(path, &attr, FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME, NULL);
+}
+
+/* open, opendir */
+static int ll_openop(const char *path, struct fuse_file_info *fi, int isdir)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	fuse_ino_t ino;
+	int rv = ll_resolve(ll, path, &ino);
+	if (rv < 0)
+		return rv;
+	if ((isdir ? ll->op.opendir : ll->op.open) != NULL) {
+		ll_req_init(&req, ll);
+		req.fi = fi;
+		if (isdir)
+			ll->op.opendir(&req, ino, fi);
+		else
+			ll->op.open(&req, ino, fi);
+		if ((rv = ll_req_wait(&req)) < 0)
+			return rv;
+	}
+	return ll_file_new(ll, ino, fi, isdir);
+}
+
+static int ll_open(const char *path, struct fuse_file_info *fi)
+{
+	return ll_openop(path, fi, 0);
+}
+
+static int ll_opendir(const char *path, struct fuse_file_info *fi)
+{
+	return ll_openop(path, fi, 1);
+}
+
+static int ll_create(const char *path, mode_t mode, struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_entry_param e;
+	fuse_ino_t parent;
+	const char *name;
+	int rv;
+	if (ll->op.create == NULL) {
+		/* as the kernel does: mknod + open */
+		if ((rv = ll_mknod(path, mode, 0)) < 0)
+			return rv;
+		return ll_open(path, fi);
+	}
+	if ((rv = ll_resolve_parent(ll, path, &parent, &name)) < 0)
+		return rv;
+	ll_entry_req_init(&req, ll, &e);
+	req.fi = fi;
+	ll->op.create(&req, parent, name, mode, fi);
+	if ((rv = ll_newentry(ll, &req, parent, name)) < 0)
+		return rv;
+	return ll_file_new(ll, e.ino, fi, 0);
+}
+
+static int ll_read(const char *path, char *buf, size_t size, off_t off,
+		struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.read == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	req.buf = buf;
+	req.size = size;
+	ll->op.read(&req, ino, size, off, fi);
+	if ((rv = ll_req_wait(&req)) == 0)
+		rv = req.count;
+	return rv;
+}
+
+static int ll_write(const char *path, const char *buf, size_t size, off_t off,
+		struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.write == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	ll->op.write(&req, ino, buf, size, off, fi);
+	if ((rv = ll_req_wait(&req)) == 0)
+		rv = req.count;
+	return rv;
+}
+
+static int ll_statfs(const char *path, struct statvfs *stbuf)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	/* umfuse passes the mountpoint-relative path of any file:
+		 the statistics are those of the whole file system */
+	if (ll->op.statfs == NULL)
+		return -ENOSYS;
+	ll_req_init(&req, ll);
+	req.stbuf = stbuf;
+	ll->op.statfs(&req, FUSE_ROOT_ID);
+	return ll_req_wait(&req);
+}
+
+/* flush, release, releasedir */
+static int ll_fileop(const char *path, struct fuse_file_info *fi,
+		void (*op)(fuse_req_t, fuse_ino_t, struct fuse_file_info *))
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv;
+	if (op == NULL)
+		return 0;
+	if ((rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino)) < 0)
+		return rv;
+	ll_req_init(&req, ll);
+	op(&req, ino, fi);
+	return ll_req_wait(&req);
+}
+
+static int ll_flush(const char *path, struct fuse_file_info *fi)
+{
+	return ll_fileop(path, fi, ll_get()->op.flush);
+}
+
+/* release, releasedir: the last use of the open file */
+static int ll_releaseop(const char *path, struct fuse_file_info *fi,
+		void (*op)(fuse_req_t, fuse_ino_t, struct fuse_file_info *))
+{
+	struct ll_file *file = (struct ll_file *) (uintptr_t) fi->fh;
+	int rv = ll_fileop(path, fi, op);
+	ll_file_del(ll_get(), file);
+	return rv;
+}
+
+static int ll_release(const char *path, struct fuse_file_info *fi)
+{
+	return ll_releaseop(path, fi, ll_get()->op.release);
+}
+
+static int ll_releasedir(const char *path, struct fuse_file_info *fi)
+{
+	return ll_releaseop(path, fi, ll_get()->op.releasedir);
+}
+
+static int ll_fsyncop(const char *path, int datasync, struct fuse_file_info *fi,
+		void (*op)(fuse_req_t, fuse_ino_t, int, struct fuse_file_info *))
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	int rv;
+	if (op == NULL)
+		return -ENOSYS;
+	if ((rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino)) < 0)
+		return rv;
+	ll_req_init(&req, ll);
+	op(&req, ino, datasync, fi);
+	return ll_req_wait(&req);
+}
+
+static int ll_fsync(const char *path, int datasync, struct fuse_file_info *fi)
+{
+	return ll_fsyncop(path, datasync, fi, ll_get()->op.fsync);
+}
+
+static int ll_fsyncdir(const char *path, int datasync, struct fuse_file_info *fi)
+{
+	return ll_fsyncop(path, datasync, fi, ll_get()->op.fsyncdir);
+}
+
+static int ll_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
+		off_t offset, struct fuse_file_info *fi)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_file_info llfi;
+	fuse_ino_t ino;
+	char *dbuf;
+	int rv = ll_resolve_fi(ll, path, &fi, &llfi, &ino);
+	if (rv < 0)
+		return rv;
+	if (ll->op.readdir == NULL)
+		return -ENOSYS;
+	if ((dbuf = malloc(LL_READDIR_SIZE)) == NULL)
+		return -ENOMEM;
+	while (1) {
+		struct fuse_req req;
+		size_t pos = 0;
+		ll_req_init(&req, ll);
+		req.buf = dbuf;
+		req.size = LL_READDIR_SIZE;
+		ll->op.readdir(&req, ino, LL_READDIR_SIZE, offset, fi);
+		if ((rv = ll_req_wait(&req)) < 0 || req.count == 0)
+			break;
+		while (pos + LL_DIRENT_NAME_OFFSET <= req.count) {
+			struct ll_dirent *de = (struct ll_dirent *) (dbuf + pos);
+			size_t entsize = LL_DIRENT_ALIGN(LL_DIRENT_NAME_OFFSET + de->namelen);
+			char name[NAME_MAX + 1];
+			struct stat st;
+			if (pos + entsize > req.count || de->namelen > NAME_MAX)
+				break;
+			memcpy(name, de->name, de->namelen);
+			name[de->namelen] = 0;
+			memset(&st, 0, sizeof(st));
+			st.st_ino = de->ino;
+			st.st_mode = de->type << 12;
+			filler(buf, name, &st, 0);
+			offset = de->off;
+			pos += entsize;
+		}
+		/* a malformed reply would loop forever */
+		if (pos == 0)
+			break;
+	}
+	free(dbuf);
+	return (rv < 0) ? rv : 0;
+}
+
+static int ll_access(const char *path, int mask)
+{
+	struct fuse_ll *ll = ll_get();
+	struct fuse_req req;
+	fuse_ino_t ino;
+	int rv = ll_resolve(ll, path, &ino);
+	if (rv < 0 || ll->op.access == NULL)
+		return rv;
+	ll_req_init(&req, ll);
+	ll->op.access(&req, ino, mask);
+	return ll_req_wait(&req);
+}
+
+static void *ll_init(struct fuse_conn_info *conn)
+{
+	struct fuse_ll *ll = ll_get();
+	if (ll->op.init)
+		ll->op.init(ll->userdata, conn);
+	return ll;
+}
+
+static void ll_destroy(void *private_data)
+{
+	struct fuse_ll *ll = private_data;
+	struct ll_dentry *forget = NULL;
+	int i;
+	pthread_mutex_lock(&ll->mutex);
+	while (ll->lru != NULL)
+		ll_unhash(ll, ll->lru, &forget);
+	pthread_mutex_unlock(&ll->mutex);
+	ll_forget_list(ll, forget);
+	/* files left open: their deferred forgets */
+	for (i = 0; i < LL_HASH_SIZE; i++) {
+		while (ll->open_head[i] != NULL) {
+			struct ll_inode *inode = ll->open_head[i];
+			ll->open_head[i] = inode->next;
+			if (ll->op.forget && inode->nlookup > 0) {
+				struct fuse_req req;
+				ll_req_init(&req, ll);
+				ll->op.forget(&req, inode->ino, inode->nlookup);
+				ll_req_wait(&req);
+			}
+			free(inode);
+		}
+	}
+	if (ll->op.destroy)
+		ll->op.destroy(ll->userdata);
+	pthread_mutex_destroy(&ll->mutex);
+	free(ll);
+}
+
+static struct fuse_operations ll_oper = {
+	.getattr = ll_getattr,
+	.readlink = ll_readlink,
+	.mknod = ll_mknod,
+	.mkdir = ll_mkdir,
+	.unlink = ll_unlink,
+	.rmdir = ll_rmdir,
+	.symlink = ll_symlink,
+	.rename = ll_rename,
+	.link = ll_link,
+	.chmod = ll_chmod,
+	.chown = ll_chown,
+	.truncate = ll_truncate,
+	.open = ll_open,
+	.read = ll_read,
+	.write = ll_write,
+	.statfs = ll_statfs,
+	.flush = ll_flush,
+	.release = ll_release,
+	.fsync = ll_fsync,
+	.opendir = ll_opendir,
+	.readdir = ll_readdir,
+	.releasedir = ll_releasedir,
+	.fsyncdir = ll_fsyncdir,
+	.init = ll_init,
+	.destroy = ll_destroy,
+	.access = ll_access,
+	.create = ll_create,
+	.ftruncate = ll_ftruncate,
+	.fgetattr = ll_fgetattr,
+	.utimens = ll_utimens,
+};
+
+/* SESSION */
+
+struct fuse_session *fuse_lowlevel_new(struct fuse_args *args,
+		const struct fuse_lowlevel_ops *op, size_t op_size, void *userdata)
+{
+	struct fuse_context *fc = fuse_get_context();
+	struct fuse_session *se;
+	struct fuse_ll *ll;
+	if (op_size > sizeof(struct fuse_lowlevel_ops)) {
+		fprintf(stderr, "umfuse: low-level ops structure too large\n");
+		op_size = sizeof(struct fuse_lowlevel_ops);
+	}
+	if ((ll = calloc(1, sizeof(struct fuse_ll))) == NULL)
+		return NULL;
+	if ((se = calloc(1, sizeof(struct fuse_session))) == NULL) {
+		free(ll);
+		return NULL;
+	}
+	memcpy(&ll->op, op, op_size);
+	ll->userdata = userdata;
+	pthread_mutex_init(&ll->mutex, NULL);
+	se->ll = ll;
+	/* the mount is a high-level one for umfuse.c */
+	se->f = fuse_new((struct fuse_chan *) fc, NULL, &ll_oper,
+			sizeof(struct fuse_operations), ll);
+	if (se->f == NULL) {
+		pthread_mutex_destroy(&ll->mutex);
+		free(ll);
+		free(se);
+		return NULL;
+	}
+	return se;
+}
+
+void fuse_session_add_chan(struct fuse_session *se, struct fuse_chan *ch)
+{
+}
+
+void fuse_session_remove_chan(struct fuse_chan *ch)
+{
+}
+
+/* the fuse_ll structure is freed by ll_destroy at umount time */
+void fuse_session_destroy(struct fuse_session *se)
+{
+	free(se);
+}
+
+void fuse_session_exit(struct fuse_session *se)
+{
+	se->exited = 1;
+}
+
+void fuse_session_reset(struct fuse_session *se)
+{
+	se->exited = 0;
+}
+
+int fuse_session_exited(struct fuse_session *se)
+{
+	return se->exited;
+}
+
+int fuse_session_loop(struct fuse_session *se)
+{
+	return fuse_loop(se->f);
+}
+
+int fuse_session_loop_mt(struct fuse_session *se)
+{
+	return fuse_loop_mt(se->f);
+}
+
+int fuse_set_signal_handlers(struct fuse_session *se)
+{
+	return 0;
+}
+
+void fuse_remove_signal_handlers(struct fuse_session *se)
+{
+}
+
+/* CMDLINE (see lib/helper.c) */
+
+enum {
+	KEY_HELP,
+	KEY_HELP_NOHEADER,
+	KEY_VERSION,
+	KEY_KEEP,
+};
+
+struct helper_opts {
+	int singlethread;
+	int foreground;
+	char *mountpoint;
+};
+
+#define FUSE_HELPER_OPT(t, p) { t, offsetof(struct helper_opts, p), 1 }
+
+static const struct fuse_opt fuse_helper_opts[] = {
+	FUSE_HELPER_OPT("-d",       foreground),
+	FUSE_HELPER_OPT("debug",    foreground),
+	FUSE_HELPER_OPT("-f",       foreground),
+	FUSE_HELPER_OPT("-s",       singlethread),
+	FUSE_OPT_KEY("-d",          KEY_KEEP),
+	FUSE_OPT_KEY("debug",       KEY_KEEP),
+	FUSE_OPT_KEY("-h",          KEY_HELP),
+	FUSE_OPT_KEY("--help",      KEY_HELP),
+	FUSE_OPT_KEY("-ho",         KEY_HELP_NOHEADER),
+	FUSE_OPT_KEY("-V",          KEY_VERSION),
+	FUSE_OPT_KEY("--version",   KEY_VERSION),
+	FUSE_OPT_END
+};
+
+static int fuse_helper_opt_proc(void *data, const char *arg, int key,
+		struct fuse_args *outargs)
+{
+	struct helper_opts *hopts = data;
+
+	switch (key) {
+		case FUSE_OPT_KEY_NONOPT:
+			/* the last non option is the mountpoint, the others
+			 * (e.g. the source) are left to the file system */
+			if (hopts->mountpoint != NULL) {
+				int rv = fuse_opt_add_arg(outargs, hopts->mountpoint);
+				free(hopts->mountpoint);
+				hopts->mountpoint = NULL;
+				if (rv == -1)
+					return -1;
+			}
+			hopts->mountpoint = strdup(arg);
+			return (hopts->mountpoint == NULL) ? -1 : 0;
+		case KEY_HELP:
+		case KEY_HELP_NOHEADER:
+		case KEY_VERSION:
+			return -1;
+		default:
+			return 1;
+	}
+}
+
+int fuse_parse_cmdline(struct fuse_args *args, char **mountpoint,
+		int *multithreaded, int *foreground)
+{
+	struct helper_opts hopts;
+	memset(&hopts, 0, sizeof(hopts));
+	if (fuse_opt_parse(args, &hopts, fuse_helper_opts, fuse_helper_opt_proc) == -1) {
+		free(hopts.mountpoint);
+		return -1;
+	}
+	if (mountpoint)
+		*mountpoint = hopts.mountpoint;
+	else
+		free(hopts.mountpoint);
+	if (multithreaded)
+		*multithreaded = !hopts.singlethread;
+	if (foreground)
+		*foreground = hopts.foreground;
+	return 0;
+}
+
+int fuse_daemonize(int foreground)
+{
+	/* the file system runs in a thread of umview */
+	return 0;
+}
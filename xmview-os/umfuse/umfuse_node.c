@@ -85,6 +85,7 @@ struct fuse_node *node_add(void *fuse, char *path)
 			new->fuse=fuse;
 			new->hashsum=hashsum;
 			new->open_count=1;
+			new->pages=NULL;
 			new->path=strdup(path);
 			if (node_head[hashkey] != NULL)
 				node_head[hashkey]->pprevhash = &(new->nexthash);
@@ -35,6 +35,7 @@ struct fuse_node {
 	void *fuse;
 	long hashsum;
 	int open_count;
+	void *pages; /* page cache (umfuse_pcache.c) */
 	struct fuse_node **pprevhash,*nexthash;
 };
 
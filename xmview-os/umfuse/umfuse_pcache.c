@@ -0,0 +1,293 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   page cache for file data (with readahead)
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <umfuse_node.h>
+#include <umfuse_pcache.h>
+
+#define PCACHE_HASH_SIZE 1024
+#define PCACHE_HASH_MASK (PCACHE_HASH_SIZE-1)
+
+struct pcache_page {
+	struct fuse_node *node;
+	unsigned long index;
+	int len;                  /* < PCACHE_PAGE_SIZE: the page contains EOF */
+	struct pcache_page **pprevhash,*nexthash;
+	struct pcache_page **pprevnode,*nextnode; /* pages of the same node */
+	struct pcache_page *prev,*next;           /* LRU list, circular */
+	char data[PCACHE_PAGE_SIZE];
+};
+
+static pthread_mutex_t pcache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct pcache_page *pcache_head[PCACHE_HASH_SIZE];
+static struct pcache_page *pcache_lru; /* least recently used */
+static size_t pcache_size;
+/* incremented by each invalidation: pages read by a concurrent fill
+	 could be stale */
+static unsigned long pcache_gen;
+static unsigned long pcache_hits;
+static unsigned long pcache_misses;
+static unsigned long pcache_rapages;
+static unsigned long pcache_evictions;
+
+static inline int pcache_hash_mod(struct fuse_node *node, unsigned long index)
+{
+	unsigned long sum = ((unsigned long) node >> 4) ^ (index * 0x9e370001UL);
+	return (sum ^ (sum >> 10)) & PCACHE_HASH_MASK;
+}
+
+static inline struct pcache_page *pcache_find(struct fuse_node *node,
+		unsigned long index)
+{
+	struct pcache_page *scan = pcache_head[pcache_hash_mod(node, index)];
+	while (scan != NULL) {
+		if (scan->node == node && scan->index == index)
+			return scan;
+		scan = scan->nexthash;
+	}
+	return NULL;
+}
+
+static inline void lru_del(struct pcache_page *page)
+{
+	if (page->next == page)
+		pcache_lru = NULL;
+	else {
+		page->prev->next = page->next;
+		page->next->prev = page->prev;
+		if (pcache_lru == page)
+			pcache_lru = page->next;
+	}
+}
+
+/* the most recently used is the tail, i.e. pcache_lru->prev */
+static inline void lru_add(struct pcache_page *page)
+{
+	if (pcache_lru == NULL) {
+		page->next = page->prev = page;
+		pcache_lru = page;
+	} else {
+		page->next = pcache_lru;
+		page->prev = pcache_lru->prev;
+		page->prev->next = page;
+		pcache_lru->prev = page;
+	}
+}
+
+static void pcache_del(struct pcache_page *page)
+{
+	*(page->pprevhash) = page->nexthash;
+	if (page->nexthash)
+		page->nexthash->pprevhash = page->pprevhash;
+	*(page->pprevnode) = page->nextnode;
+	if (page->nextnode)
+		page->nextnode->pprevnode = page->pprevnode;
+	lru_del(page);
+	pcache_size -= PCACHE_PAGE_SIZE;
+	free(page);
+}
+
+static void pcache_insert(struct fuse_node *node, unsigned long index,
+		char *data, int len)
+{
+	struct pcache_page *page = pcache_find(node, index);
+	if (page != NULL)
+		lru_del(page);
+	else {
+		int hashkey = pcache_hash_mod(node, index);
+		while (pcache_lru != NULL &&
+				pcache_size + PCACHE_PAGE_SIZE > PCACHE_MAX_SIZE) {
+			pcache_del(pcache_lru);
+			pcache_evictions++;
+		}
+		if ((page = malloc(sizeof(struct pcache_page))) == NULL)
+			return;
+		page->node = node;
+		page->index = index;
+		if (pcache_head[hashkey] != NULL)
+			pcache_head[hashkey]->pprevhash = &(page->nexthash);
+		page->nexthash = pcache_head[hashkey];
+		page->pprevhash = &(pcache_head[hashkey]);
+		pcache_head[hashkey] = page;
+		if (node->pages != NULL)
+			((struct pcache_page *)node->pages)->pprevnode = &(page->nextnode);
+		page->nextnode = node->pages;
+		page->pprevnode = (struct pcache_page **) &(node->pages);
+		node->pages = page;
+		pcache_size += PCACHE_PAGE_SIZE;
+	}
+	page->len = len;
+	memcpy(page->data, data, len);
+	lru_add(page);
+}
+
+/* number of pages to read when page index is missing:
+	 the window grows while the reader is sequential */
+static unsigned int pcache_window(struct pcache_ra *ra, unsigned long index,
+		unsigned int wanted)
+{
+	unsigned int npages;
+	if (index == ra->next) {
+		if (ra->window == 0)
+			ra->window = PCACHE_RA_INIT;
+		else if (ra->window < PCACHE_RA_MAX)
+			ra->window <<= 1;
+		if (ra->window > PCACHE_RA_MAX)
+			ra->window = PCACHE_RA_MAX;
+	} else
+		ra->window = 0;
+	npages = (wanted > ra->window) ? wanted : ra->window;
+	if (npages > PCACHE_RA_MAX)
+		npages = PCACHE_RA_MAX;
+	return npages;
+}
+
+ssize_t pcache_read(struct fuse_node *node, struct pcache_ra *ra,
+		char *buf, size_t count, off_t off, pcache_fill_t fill, void *arg)
+{
+	size_t done = 0;
+	while (done < count) {
+		unsigned long index = off >> PCACHE_PAGE_SHIFT;
+		int poff = off & (PCACHE_PAGE_SIZE - 1);
+		struct pcache_page *page;
+		ssize_t len;
+		int eof;
+		pthread_mutex_lock(&pcache_mutex);
+		if ((page = pcache_find(node, index)) != NULL) {
+			pcache_hits++;
+			lru_del(page);
+			lru_add(page);
+			len = page->len - poff;
+			if (len > (ssize_t) (count - done))
+				len = count - done;
+			if (len > 0)
+				memcpy(buf + done, page->data + poff, len);
+			eof = (page->len < PCACHE_PAGE_SIZE && poff + len >= page->len);
+			pthread_mutex_unlock(&pcache_mutex);
+		} else {
+			unsigned long gen = pcache_gen;
+			unsigned int wanted = (poff + (count - done) + PCACHE_PAGE_SIZE - 1)
+				>> PCACHE_PAGE_SHIFT;
+			unsigned int npages = pcache_window(ra, index, wanted);
+			unsigned int i;
+			char *tmp;
+			int rv;
+			/* stop at the first page already in the cache */
+			for (i = 1; i < npages && pcache_find(node, index + i) == NULL; i++)
+				;
+			npages = i;
+			pcache_misses++;
+			pthread_mutex_unlock(&pcache_mutex);
+			if ((tmp = malloc(npages << PCACHE_PAGE_SHIFT)) == NULL)
+				return (done > 0) ? done : -ENOMEM;
+			rv = fill(arg, tmp, npages << PCACHE_PAGE_SHIFT,
+					(off_t) index << PCACHE_PAGE_SHIFT);
+			if (rv < 0) {
+				free(tmp);
+				return (done > 0) ? done : rv;
+			}
+			pthread_mutex_lock(&pcache_mutex);
+			if (gen == pcache_gen) {
+				for (i = 0; i < npages; i++) {
+					int plen = rv - (i << PCACHE_PAGE_SHIFT);
+					if (plen > PCACHE_PAGE_SIZE)
+						plen = PCACHE_PAGE_SIZE;
+					if (plen < 0 || (plen == 0 && i > 0))
+						break;
+					pcache_insert(node, index + i, tmp + (i << PCACHE_PAGE_SHIFT), plen);
+					if (plen < PCACHE_PAGE_SIZE)
+						break;
+				}
+				if (i > 1)
+					pcache_rapages += i - 1;
+			}
+			pthread_mutex_unlock(&pcache_mutex);
+			len = rv - poff;
+			if (len > (ssize_t) (count - done))
+				len = count - done;
+			if (len > 0)
+				memcpy(buf + done, tmp + poff, len);
+			eof = (rv < (npages << PCACHE_PAGE_SHIFT) && poff + len >= rv);
+			free(tmp);
+		}
+		if (len <= 0)
+			break;
+		done += len;
+		off += len;
+		ra->next = (off - 1) >> PCACHE_PAGE_SHIFT;
+		ra->next++;
+		if (eof)
+			break;
+	}
+	return done;
+}
+
+void pcache_invalidate(struct fuse_node *node, off_t off, size_t len)
+{
+	unsigned long first = off >> PCACHE_PAGE_SHIFT;
+	unsigned long last = (off + len - 1) >> PCACHE_PAGE_SHIFT;
+	struct pcache_page *page;
+	if (node == NULL || len == 0)
+		return;
+	pthread_mutex_lock(&pcache_mutex);
+	pcache_gen++;
+	page = node->pages;
+	while (page != NULL) {
+		struct pcache_page *next = page->nextnode;
+		/* a page containing EOF is stale when the file grows */
+		if ((page->index >= first && page->index <= last) ||
+				page->len < PCACHE_PAGE_SIZE)
+			pcache_del(page);
+		page = next;
+	}
+	pthread_mutex_unlock(&pcache_mutex);
+}
+
+void pcache_drop(struct fuse_node *node)
+{
+	if (node == NULL)
+		return;
+	pthread_mutex_lock(&pcache_mutex);
+	pcache_gen++;
+	while (node->pages != NULL)
+		pcache_del(node->pages);
+	pthread_mutex_unlock(&pcache_mutex);
+}
+
+int pcache_stats(char *buf, size_t size)
+{
+	unsigned long reads;
+	int rv;
+	pthread_mutex_lock(&pcache_mutex);
+	reads = pcache_hits + pcache_misses;
+	rv = snprintf(buf, size,
+			"page cache: %lu KB, %lu hits, %lu misses, hit rate %lu%%, %lu readahead pages, %lu evictions",
+			(unsigned long) (pcache_size >> 10), pcache_hits, pcache_misses,
+			reads ? (pcache_hits * 100) / reads : 0,
+			pcache_rapages, pcache_evictions);
+	pthread_mutex_unlock(&pcache_mutex);
+	return rv;
+}
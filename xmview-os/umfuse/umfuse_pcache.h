@@ -0,0 +1,63 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   page cache for file data (with readahead)
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _UMFUSE_PCACHE_H
+#define _UMFUSE_PCACHE_H
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Pages are keyed by (fuse_node, page index) and shared by all the open
+ * files of the same node. All the mounts share a global memory cap,
+ * the least recently used pages are evicted first. */
+
+#define PCACHE_PAGE_SHIFT 12
+#define PCACHE_PAGE_SIZE (1 << PCACHE_PAGE_SHIFT)
+/* global memory cap (bytes of data) */
+#ifndef PCACHE_MAX_SIZE
+#define PCACHE_MAX_SIZE (16 * 1024 * 1024)
+#endif
+/* readahead window (pages) */
+#define PCACHE_RA_INIT 4
+#define PCACHE_RA_MAX 32
+
+struct fuse_node;
+
+/* per open file readahead state */
+struct pcache_ra {
+	unsigned long next;  /* page expected by a sequential reader */
+	unsigned int window; /* current readahead window, 0=no history */
+};
+
+/* reads size bytes at offset off from the file system: returns the
+ * number of bytes read (less than size at EOF) or -errno */
+typedef int (*pcache_fill_t)(void *arg, char *buf, size_t size, off_t off);
+
+ssize_t pcache_read(struct fuse_node *node, struct pcache_ra *ra,
+		char *buf, size_t count, off_t off, pcache_fill_t fill, void *arg);
+
+/* drop the pages overlapping [off, off+len) */
+void pcache_invalidate(struct fuse_node *node, off_t off, size_t len);
+/* drop all the pages of node */
+void pcache_drop(struct fuse_node *node);
+
+int pcache_stats(char *buf, size_t size);
+
+#endif
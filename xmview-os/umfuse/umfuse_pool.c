@@ -0,0 +1,128 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   worker pool for asynchronous operations
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <umfuse_pool.h>
+
+struct fuse_pool {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;       /* new jobs or exiting */
+	pthread_cond_t done;       /* a thread terminated */
+	int max_threads;
+	int nthreads;
+	int idle;
+	int exiting;
+	struct fpool_job *head;
+	struct fpool_job **tail;
+	void (*init)(void *);
+	void *arg;
+};
+
+static void *fpool_thread(void *arg)
+{
+	struct fuse_pool *pool = arg;
+	if (pool->init)
+		pool->init(pool->arg);
+	pthread_mutex_lock(&pool->mutex);
+	while (1) {
+		struct fpool_job *job;
+		while (pool->head == NULL && !pool->exiting) {
+			pool->idle++;
+			pthread_cond_wait(&pool->cond, &pool->mutex);
+			pool->idle--;
+		}
+		/* queued jobs are run before exiting */
+		if ((job = pool->head) == NULL)
+			break;
+		if ((pool->head = job->next) == NULL)
+			pool->tail = &pool->head;
+		pthread_mutex_unlock(&pool->mutex);
+		job->fun(job);
+		pthread_mutex_lock(&pool->mutex);
+	}
+	pool->nthreads--;
+	pthread_cond_signal(&pool->done);
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+struct fuse_pool *fpool_new(int max_threads, void (*init)(void *), void *arg)
+{
+	struct fuse_pool *pool;
+	if (max_threads <= 0)
+		return NULL;
+	if ((pool = calloc(1, sizeof(struct fuse_pool))) != NULL) {
+		pthread_mutex_init(&pool->mutex, NULL);
+		pthread_cond_init(&pool->cond, NULL);
+		pthread_cond_init(&pool->done, NULL);
+		pool->max_threads = max_threads;
+		pool->tail = &pool->head;
+		pool->init = init;
+		pool->arg = arg;
+	}
+	return pool;
+}
+
+void fpool_free(struct fuse_pool *pool)
+{
+	if (pool) {
+		pthread_mutex_lock(&pool->mutex);
+		pool->exiting = 1;
+		pthread_cond_broadcast(&pool->cond);
+		while (pool->nthreads > 0)
+			pthread_cond_wait(&pool->done, &pool->mutex);
+		pthread_mutex_unlock(&pool->mutex);
+		pthread_cond_destroy(&pool->done);
+		pthread_cond_destroy(&pool->cond);
+		pthread_mutex_destroy(&pool->mutex);
+		free(pool);
+	}
+}
+
+int fpool_submit(struct fuse_pool *pool, struct fpool_job *job)
+{
+	int rv = 0;
+	if (pool == NULL)
+		return -1;
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->idle == 0 && pool->nthreads < pool->max_threads) {
+		pthread_t thread;
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		if (pthread_create(&thread, &attr, fpool_thread, pool) == 0)
+			pool->nthreads++;
+		pthread_attr_destroy(&attr);
+	}
+	if (pool->nthreads == 0 || pool->exiting)
+		rv = -1;
+	else {
+		job->next = NULL;
+		*(pool->tail) = job;
+		pool->tail = &job->next;
+		pthread_cond_signal(&pool->cond);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	return rv;
+}
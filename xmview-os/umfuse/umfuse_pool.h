@@ -0,0 +1,43 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   umviewos -> fuse gateway
+ *   worker pool for asynchronous operations
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+#ifndef _UMFUSE_POOL_H
+#define _UMFUSE_POOL_H
+
+/* Jobs are run in FIFO order by up to max_threads threads, created
+ * when there is no idle thread. init(arg) is called by each thread
+ * before running its first job. */
+
+struct fpool_job {
+	void (*fun)(struct fpool_job *job);
+	struct fpool_job *next;
+};
+
+struct fuse_pool;
+
+struct fuse_pool *fpool_new(int max_threads, void (*init)(void *), void *arg);
+/* wait for the queued jobs, then terminate the threads */
+void fpool_free(struct fuse_pool *pool);
+/* returns -1 if the job cannot be run (no thread): the caller has to
+ * do it synchronously */
+int fpool_submit(struct fuse_pool *pool, struct fpool_job *job);
+
+#endif
@@ -57,6 +57,7 @@ the format string is similar to that used in printf.
 #include <fuse/fuse.h>
 #include <config.h>
 #include "umfusestd.h"
+#include "umfuse_cache.h"
 
 #define MAXARGS 256
 #define PATH_MAX 256
@@ -74,6 +75,12 @@ the format string is similar to that used in printf.
 #define FUSEARGMERGE 11 //"merge"
 #define FUSEARGFSDEBUG 12 //"fsdebug"
 #define FUSEARGHARDREMOVE 13 //"fsdebug"
+#define FUSEARGATTRTIMEOUT 14 //"attr_timeout"
+#define FUSEARGENTRYTIMEOUT 15 //"entry_timeout"
+#define FUSEARGNEGTIMEOUT 16 //"negative_timeout"
+#define FUSEARGPAGECACHE 17 //"page_cache"
+#define FUSEARGDIRECTIO 18 //"direct_io"
+#define FUSEARGMAXTHREADS 19 //"max_threads"
 #define FUSEFLAGHASSTRING 1
 #define FUSEFLAGCOPY 2
 static struct fuseargitem {
@@ -93,7 +100,13 @@ static struct fuseargitem {
 	{"hard_remove",FUSEARGHARDREMOVE, 0},
 	{"human", FUSEARGHUMAN, 0},
 	{"merge", FUSEARGMERGE, 0},
-	{"fsdebug", FUSEARGFSDEBUG, 0}
+	{"fsdebug", FUSEARGFSDEBUG, 0},
+	{"attr_timeout=", FUSEARGATTRTIMEOUT, FUSEFLAGHASSTRING},
+	{"entry_timeout=", FUSEARGENTRYTIMEOUT, FUSEFLAGHASSTRING},
+	{"negative_timeout=", FUSEARGNEGTIMEOUT, FUSEFLAGHASSTRING},
+	{"page_cache", FUSEARGPAGECACHE, 0},
+	{"direct_io", FUSEARGDIRECTIO, 0},
+	{"max_threads=", FUSEARGMAXTHREADS, FUSEFLAGHASSTRING}
 };
 #define FUSEARGTABSIZE sizeof(fuseargtab)/sizeof(struct fuseargitem)
 
@@ -181,7 +194,7 @@ static int fuseaddargs(char *fmt, char *source, char *mountpoint, char *opts, ch
 	return nargc;
 }
 
-int fuseargs(char* filesystemtype,char *source, char *mountpoint, char *opts, char ***pargv,struct fuse_context *fc,unsigned long *pflags,char ***pexceptions)
+int fuseargs(char* filesystemtype,char *source, char *mountpoint, char *opts, char ***pargv,struct fuse_context *fc,unsigned long *pflags,char ***pexceptions,struct fuse_cache *cache,int *pmaxthreads)
 {
 	char *sepopts[MAXARGS];
 	char *exceptions[MAXARGS];
@@ -275,6 +288,24 @@ int fuseargs(char* filesystemtype,char *source, char *mountpoint, char *opts, ch
 			case FUSEARGHARDREMOVE:
 				*pflags |= FUSE_HARDREMOVE;
 				break;
+			case FUSEARGATTRTIMEOUT:
+				fcache_timeout(cache,FCACHE_ATTR,atof(sepopts[i]+strlen(fuseargtab[j].arg)));
+				break;
+			case FUSEARGENTRYTIMEOUT:
+				fcache_timeout(cache,FCACHE_ENTRY,atof(sepopts[i]+strlen(fuseargtab[j].arg)));
+				break;
+			case FUSEARGNEGTIMEOUT:
+				fcache_timeout(cache,FCACHE_NEGATIVE,atof(sepopts[i]+strlen(fuseargtab[j].arg)));
+				break;
+			case FUSEARGPAGECACHE:
+				*pflags |= FUSE_PAGECACHE;
+				break;
+			case FUSEARGDIRECTIO:
+				*pflags |= FUSE_DIRECTIO;
+				break;
+			case FUSEARGMAXTHREADS:
+				*pmaxthreads=atoi(sepopts[i]+strlen(fuseargtab[j].arg));
+				break;
 			case FUSEARGFSDEBUG:
 				sepopts[i]="debug";
 			default:
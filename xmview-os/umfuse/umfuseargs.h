@@ -1,6 +1,7 @@
 #ifndef UMFUSEARGS_H
 #define UMFUSEARGS_H
 struct fuse_context;
-int fuseargs(char* filesystemtype,char *source, char *mountpoint, char *opts, char ***pargv,struct fuse_context *fc,unsigned long *pflags,char ***pexceptions);
+struct fuse_cache;
+int fuseargs(char* filesystemtype,char *source, char *mountpoint, char *opts, char ***pargv,struct fuse_context *fc,unsigned long *pflags,char ***pexceptions,struct fuse_cache *cache,int *pmaxthreads);
 void fusefreearg(int argc,char *argv[]);
 #endif
@@ -32,6 +32,13 @@
 #define FUSE_MERGE       (1 << 27)
 /** Enable hard remove */
 #define FUSE_HARDREMOVE  (1 << 26)
+/** Enable the page cache */
+#define FUSE_PAGECACHE   (1 << 25)
+/** Disable the page cache (also for files opened with fi->direct_io) */
+#define FUSE_DIRECTIO    (1 << 24)
+
+/** Default max number of worker threads per mount (-o max_threads=N) */
+#define FUSE_MAX_THREADS 4
 
 extern struct fuse_operations defaultservice;
 
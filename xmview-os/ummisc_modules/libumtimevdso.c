@@ -0,0 +1,195 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   libumtimevdso: virtual time of ummisctime without system calls
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+
+/* usage (inside the view):
+	 $ mount -t ummisctime -o vdso none /tmp/time
+	 $ LD_PRELOAD=libumtimevdso.so UMMISCTIME=/tmp/time command
+
+	 gettimeofday, clock_gettime(CLOCK_REALTIME) and time compute the
+	 virtual time from the shared page of the mount and the real clock of
+	 the vdso. Everything else (and everything, when the page or the vdso
+	 are not available) goes through the system calls, i.e. through the
+	 ummisctime module. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <link.h>
+#include <dlfcn.h>
+#include <pthread.h>
+/* the prototype of gettimeofday changed among glibc versions */
+#define gettimeofday __umtime_gettimeofday
+#include <sys/time.h>
+#undef gettimeofday
+#include <sys/mman.h>
+#include <sys/auxv.h>
+
+#include "umtimepage.h"
+
+typedef int (*clock_gettime_t)(clockid_t clk_id, struct timespec *tp);
+typedef int (*gettimeofday_t)(struct timeval *tv, struct timezone *tz);
+typedef time_t (*time_t_t)(time_t *t);
+
+static pthread_once_t umtime_once = PTHREAD_ONCE_INIT;
+static struct umtimepage *page;
+static clock_gettime_t vdso_clock_gettime;
+static clock_gettime_t next_clock_gettime;
+static gettimeofday_t next_gettimeofday;
+static time_t_t next_time;
+
+/* search a function in the dynamic symbols of the vdso */
+static void *vdso_sym(const char *name)
+{
+	ElfW(Ehdr) *eh=(ElfW(Ehdr) *) getauxval(AT_SYSINFO_EHDR);
+	ElfW(Phdr) *ph;
+	ElfW(Shdr) *sh;
+	ElfW(Sym) *sym=NULL;
+	char *strtab=NULL;
+	ElfW(Addr) base=0;
+	int i,nsym=0;
+	if (eh == NULL)
+		return NULL;
+	ph=(ElfW(Phdr) *) ((char *) eh + eh->e_phoff);
+	for (i=0; i<eh->e_phnum; i++)
+		if (ph[i].p_type == PT_LOAD) {
+			base=(ElfW(Addr)) eh + ph[i].p_offset - ph[i].p_vaddr;
+			break;
+		}
+	sh=(ElfW(Shdr) *) ((char *) eh + eh->e_shoff);
+	for (i=0; i<eh->e_shnum; i++)
+		if (sh[i].sh_type == SHT_DYNSYM) {
+			sym=(ElfW(Sym) *) ((char *) eh + sh[i].sh_offset);
+			nsym=sh[i].sh_size / sh[i].sh_entsize;
+			strtab=(char *) eh + sh[sh[i].sh_link].sh_offset;
+			break;
+		}
+	for (i=0; i<nsym; i++)
+		if ((sym[i].st_info & 0xf) == STT_FUNC /* ST_TYPE */ &&
+				sym[i].st_shndx != SHN_UNDEF &&
+				strcmp(strtab + sym[i].st_name, name) == 0)
+			return (void *) (base + sym[i].st_value);
+	return NULL;
+}
+
+/* the page name is in the "page" file of the ummisctime mount */
+static struct umtimepage *umtime_getpage(void)
+{
+	char *mountpoint=getenv("UMMISCTIME");
+	char *path;
+	char name[256];
+	int fd,n;
+	struct umtimepage *rv;
+	if (mountpoint == NULL || asprintf(&path,"%s/page",mountpoint) < 0)
+		return NULL;
+	fd=open(path,O_RDONLY);
+	free(path);
+	if (fd < 0)
+		return NULL;
+	n=read(fd,name,sizeof(name)-1);
+	close(fd);
+	if (n <= 0)
+		return NULL;
+	name[n]=0;
+	name[strcspn(name,"\n")]=0;
+	if ((fd=shm_open(name,O_RDONLY,0)) < 0)
+		return NULL;
+	rv=mmap(NULL,sizeof(struct umtimepage),PROT_READ,MAP_SHARED,fd,0);
+	close(fd);
+	if (rv == MAP_FAILED)
+		return NULL;
+	if (rv->magic != UMTIMEPAGE_MAGIC) {
+		munmap(rv,sizeof(struct umtimepage));
+		return NULL;
+	}
+	return rv;
+}
+
+static void umtime_init(void)
+{
+	next_clock_gettime=(clock_gettime_t) dlsym(RTLD_NEXT,"clock_gettime");
+	next_gettimeofday=(gettimeofday_t) dlsym(RTLD_NEXT,"gettimeofday");
+	next_time=(time_t_t) dlsym(RTLD_NEXT,"time");
+	/* x86 names, then arm/ppc/s390 names */
+	if ((vdso_clock_gettime=vdso_sym("__vdso_clock_gettime")) == NULL)
+		vdso_clock_gettime=vdso_sym("__kernel_clock_gettime");
+	if (vdso_clock_gettime)
+		page=umtime_getpage();
+}
+
+/* 0 if the virtual time is in ts, -1 if the caller must use the syscall */
+static int umtime(struct timespec *ts)
+{
+	struct timespec real;
+	uint32_t seq;
+	int64_t ns;
+	pthread_once(&umtime_once,umtime_init);
+	if (page == NULL)
+		return -1;
+	do {
+		seq=page->seq;
+		__sync_synchronize();
+		if (vdso_clock_gettime(CLOCK_REALTIME,&real) < 0)
+			return -1;
+		ns=page->base_virt + (int64_t)
+			((real.tv_sec * 1000000000LL + real.tv_nsec - page->base_real) * page->freq);
+		__sync_synchronize();
+	} while ((seq & 1) || seq != page->seq);
+	ts->tv_sec=ns / 1000000000;
+	ts->tv_nsec=ns % 1000000000;
+	if (ts->tv_nsec < 0) {
+		ts->tv_sec--;
+		ts->tv_nsec += 1000000000;
+	}
+	return 0;
+}
+
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+	if (clk_id == CLOCK_REALTIME && umtime(tp) == 0)
+		return 0;
+	pthread_once(&umtime_once,umtime_init);
+	return next_clock_gettime(clk_id,tp);
+}
+
+int gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+	struct timespec ts;
+	if (tv && tz == NULL && umtime(&ts) == 0) {
+		tv->tv_sec=ts.tv_sec;
+		tv->tv_usec=ts.tv_nsec / 1000;
+		return 0;
+	}
+	pthread_once(&umtime_once,umtime_init);
+	return next_gettimeofday(tv,tz);
+}
+
+time_t time(time_t *t)
+{
+	struct timespec ts;
+	if (umtime(&ts) == 0) {
+		if (t)
+			*t=ts.tv_sec;
+		return ts.tv_sec;
+	}
+	return next_time(t);
+}
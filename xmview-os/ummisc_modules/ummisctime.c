@@ -24,12 +24,19 @@
 #include <sys/time.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include "ummisc.h"
+#include "umtimepage.h"
 
 struct umtimeinfo {
 	long double offset;
 	double freq;
+	/* vdso mode */
+	char *shmname;
+	struct umtimepage *page;
 };
 
 static loff_t gp_time(int op,char *value,int size,struct ummisc *mh,int tag,char *path);
@@ -39,10 +46,12 @@ static void ummisc_time_fini(struct ummisc *mh);
 
 #define GP_OFFSET 1
 #define GP_FREQ 2
+#define GP_PAGE 3
 
 struct fsentry fseroot[] = {
 	{"offset",NULL,gp_time,GP_OFFSET},
 	{"frequency",NULL,gp_time,GP_FREQ},
+	{"page",NULL,gp_time,GP_PAGE},
 	{NULL,NULL,NULL,0}};
 
 struct ummisc_operations ummisc_ops = {
@@ -63,6 +72,53 @@ static long double umtime(struct umtimeinfo *umt)
 	return now;
 }
 
+/* update the shared page (if any) after each change of offset/freq */
+static void umtime_publish(struct umtimeinfo *umt)
+{
+	struct umtimepage *page=umt->page;
+	if (page) {
+		struct timespec ts;
+		long double now;
+		clock_gettime(CLOCK_REALTIME,&ts);
+		now=ts.tv_sec + ((long double) ts.tv_nsec) / 1000000000;
+		page->seq++;
+		__sync_synchronize();
+		page->base_real=ts.tv_sec * 1000000000LL + ts.tv_nsec;
+		page->base_virt=(int64_t) ((now*umt->freq+umt->offset) * 1000000000);
+		page->freq=umt->freq;
+		__sync_synchronize();
+		page->seq++;
+	}
+}
+
+static void umtime_mappage(struct umtimeinfo *umt)
+{
+	static int count;
+	int fd;
+	if (asprintf(&umt->shmname,"/ummisctime.%d.%d",getpid(),count++) < 0) {
+		umt->shmname=NULL;
+		return;
+	}
+	fd=shm_open(umt->shmname,O_RDWR|O_CREAT|O_EXCL,0644);
+	if (fd >= 0) {
+		if (ftruncate(fd,sizeof(struct umtimepage)) == 0)
+			umt->page=mmap(NULL,sizeof(struct umtimepage),PROT_READ|PROT_WRITE,
+					MAP_SHARED,fd,0);
+		close(fd);
+		if (umt->page == MAP_FAILED)
+			umt->page=NULL;
+	}
+	if (umt->page) {
+		umt->page->magic=UMTIMEPAGE_MAGIC;
+		umtime_publish(umt);
+	} else {
+		if (fd >= 0)
+			shm_unlink(umt->shmname);
+		free(umt->shmname);
+		umt->shmname=NULL;
+	}
+}
+
 static void umsettime(struct umtimeinfo *umt,long double newnow)
 {
 	struct timespec ts;
@@ -71,6 +127,7 @@ static void umsettime(struct umtimeinfo *umt,long double newnow)
 	now=ts.tv_sec + ((long double) ts.tv_nsec) / 1000000000;
 	now=now*umt->freq+umt->offset;
 	umt->offset += newnow - now;
+	umtime_publish(umt);
 }
 
 static void setnewfreq(struct umtimeinfo *umt,long double newfreq)
@@ -87,6 +144,7 @@ static void setnewfreq(struct umtimeinfo *umt,long double newfreq)
 			//newfreq,now,oldtime,newuncorrected);
 	umt->offset += (oldtime-newuncorrected);
 	umt->freq=newfreq;
+	umtime_publish(umt);
 }
 
 int misc_gettimeofday(struct timeval *tv, struct timezone *tz,
@@ -157,6 +215,7 @@ static loff_t gp_time(int op,char *value,int size,struct ummisc *mh,int tag, cha
 				rv=size;
 				value[size]=0;
 				sscanf(value,"%Lf",&buf->offset);
+				umtime_publish(buf);
 			}
 			break;
 		case GP_FREQ:
@@ -171,6 +230,16 @@ static loff_t gp_time(int op,char *value,int size,struct ummisc *mh,int tag, cha
 				setnewfreq(buf,newfreq);
 			}
 			break;
+		case GP_PAGE:
+			if (op==UMMISC_GET) {
+				if (buf->shmname)
+					snprintf(value,size,"%s\n",buf->shmname);
+				else
+					*value=0;
+				rv=strlen(value);
+			} else
+				rv=size;
+			break;
 	}
 	return rv;
 }
@@ -180,12 +249,25 @@ static void ummisc_time_init(char *path, unsigned long flags, char *args, struct
 	buf=calloc(1,sizeof(struct umtimeinfo));
 	assert(buf);
 	buf->freq=1;
+	if (args) {
+		char *opts=strdup(args);
+		char *opt,*saveptr;
+		for (opt=strtok_r(opts,",",&saveptr); opt; opt=strtok_r(NULL,",",&saveptr))
+			if (strcmp(opt,"vdso") == 0)
+				umtime_mappage(buf);
+		free(opts);
+	}
 	ummisc_setprivatedata(mh,buf);
 	//printk("ummisc_time_init \n");
 }
 
 static void ummisc_time_fini(struct ummisc *mh) {
 	struct umtimeinfo *buf=ummisc_getprivatedata(mh);
+	if (buf->page) {
+		munmap(buf->page,sizeof(struct umtimepage));
+		shm_unlink(buf->shmname);
+		free(buf->shmname);
+	}
 	free(buf);
 	//printk("ummisc_time_fini \n");
 }
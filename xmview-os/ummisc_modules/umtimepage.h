@@ -0,0 +1,43 @@
+/*   This is part of um-ViewOS
+ *   The user-mode implementation of OSVIEW -- A Process with a View
+ *
+ *   UMMISCTIME: shared time page (vdso mode)
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License, version 2, as
+ *   published by the Free Software Foundation.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA.
+ *
+ */
+#ifndef _UMTIMEPAGE_H
+#define _UMTIMEPAGE_H
+#include <stdint.h>
+
+/* A ummisctime mount with the "vdso" option publishes its clock in a
+	 shared memory page, whose name can be read from the "page" file of the
+	 mount. libumtimevdso reads the page and the real clock of the vdso:
+	 virtual time costs no system call.
+
+	 virtual = base_virt + (real - base_real) * freq   (nanoseconds)
+
+	 seq is odd while the page is being updated (seqlock) */
+
+#define UMTIMEPAGE_MAGIC 0x756d7470
+
+struct umtimepage {
+	volatile uint32_t seq;
+	uint32_t magic;
+	int64_t base_real;
+	int64_t base_virt;
+	double freq;
+};
+
+#endif
@@ -71,6 +71,7 @@ struct umnet {
 	time_t sockettime;
 	void *private_data;
 	struct ht_elem *socket_ht;
+	int delegate;
 };
 
 struct fileinfo {
@@ -270,6 +271,9 @@ static long umnet_msocket(char *path, int domain, int type, int protocol)
 		} else {
 			return umnet_setdefstack(um_mod_getumpid(),domain,mh);
 		}
+	} else if (mh->delegate) {
+		mh->sockettime=time(NULL);
+		return UM_NATIVE_SOCKET;
 	} else if (mh->netops->msocket) {
 		rv=mh->netops->msocket(domain, type, protocol, mh);
 		if (rv >= 0) {
@@ -424,9 +428,31 @@ long umnet_sendmsg(int fd, const struct msghdr *msg, int flags) {
 	struct fileinfo *ft=getfiletab(fd);
 	if (ft->umnet->netops->sendmsg) 
 		return(ft->umnet->netops->sendmsg(ft->nfd,msg,flags));
-	else
-		return umnet_sendto(ft->nfd,msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
+	else if (msg->msg_controllen > 0) {
+		errno = EOPNOTSUPP;
+		return -1;
+	} else if (msg->msg_iovlen == 1)
+		return umnet_sendto(fd,msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
 			msg->msg_name,msg->msg_namelen);
+	else {
+		/* stacks without sendmsg: gather the iovecs */
+		size_t i,len;
+		char *buf,*p;
+		long rv;
+		for (i=0,len=0;i<msg->msg_iovlen;i++)
+			len+=msg->msg_iov[i].iov_len;
+		if ((p=buf=malloc(len ? len : 1)) == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		for (i=0;i<msg->msg_iovlen;i++) {
+			memcpy(p,msg->msg_iov[i].iov_base,msg->msg_iov[i].iov_len);
+			p+=msg->msg_iov[i].iov_len;
+		}
+		rv=umnet_sendto(fd,buf,len,flags,msg->msg_name,msg->msg_namelen);
+		free(buf);
+		return rv;
+	}
 }
 
 long umnet_recvmsg(int fd, struct msghdr *msg, int flags) {
@@ -434,12 +460,74 @@ long umnet_recvmsg(int fd, struct msghdr *msg, int flags) {
 	if (ft->umnet->netops->recvmsg) 
 		return(ft->umnet->netops->recvmsg(ft->nfd, msg, flags));
 	else {
+		long rv;
 		msg->msg_controllen=0;
-		return umnet_recvfrom(ft->nfd,msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
-				msg->msg_name,&msg->msg_namelen);
+		msg->msg_flags=0;
+		if (msg->msg_iovlen == 1)
+			rv=umnet_recvfrom(fd,msg->msg_iov->iov_base,msg->msg_iov->iov_len,flags,
+					msg->msg_name,&msg->msg_namelen);
+		else {
+			/* stacks without recvmsg: scatter to the iovecs */
+			size_t i,len;
+			char *buf,*p;
+			for (i=0,len=0;i<msg->msg_iovlen;i++)
+				len+=msg->msg_iov[i].iov_len;
+			if ((p=buf=malloc(len ? len : 1)) == NULL) {
+				errno = ENOMEM;
+				return -1;
+			}
+			rv=umnet_recvfrom(fd,buf,len,flags,msg->msg_name,&msg->msg_namelen);
+			for (i=0,len=(rv > 0)?rv:0; i<msg->msg_iovlen && len>0; i++) {
+				size_t qty=(len > msg->msg_iov[i].iov_len)?msg->msg_iov[i].iov_len:len;
+				memcpy(msg->msg_iov[i].iov_base,p,qty);
+				p+=qty;
+				len-=qty;
+			}
+			free(buf);
+		}
+		return rv;
 	}
 }
 
+/* sendmmsg/recvmmsg: one call of the hypervisor for a batch of datagrams */
+#ifdef __NR_sendmmsg
+static long umnet_sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+	struct fileinfo *ft=getfiletab(fd);
+	if (ft->umnet->netops->sendmmsg) 
+		return ft->umnet->netops->sendmmsg(ft->nfd, msgvec, vlen, flags);
+	else {
+		unsigned int i;
+		for (i=0; i<vlen; i++) {
+			long rv=umnet_sendmsg(fd, &msgvec[i].msg_hdr, flags);
+			if (rv < 0)
+				return (i > 0) ? i : rv;
+			msgvec[i].msg_len=rv;
+		}
+		return i;
+	}
+}
+#endif
+
+#ifdef __NR_recvmmsg
+static long umnet_recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		struct timespec *timeout) {
+	struct fileinfo *ft=getfiletab(fd);
+	if (ft->umnet->netops->recvmmsg) 
+		return ft->umnet->netops->recvmmsg(ft->nfd, msgvec, vlen, flags, timeout);
+	else {
+		/* the datagrams already queued after the first one (MSG_WAITFORONE) */
+		unsigned int i;
+		for (i=0; i<vlen; i++) {
+			long rv=umnet_recvmsg(fd, &msgvec[i].msg_hdr, (i > 0) ? (flags | MSG_DONTWAIT) : flags);
+			if (rv < 0)
+				return (i > 0) ? i : rv;
+			msgvec[i].msg_len=rv;
+		}
+		return i;
+	}
+}
+#endif
+
 static long umnet_getsockopt(int fd, int level, int optname,
 		void *optval, socklen_t *optlen)
 {
@@ -617,6 +705,7 @@ static long umnet_mount(char *source, char *target, char *filesystemtype,
 		new->uid=0;
 		new->gid=0;
 		new->flags=mountflags;
+		new->delegate=0;
 		if (new->netops->init) 
 			new->netops->init(source,new->path,mountflags,data,new);
 		new->socket_ht=ht_tab_add(CHECKSOCKET,NULL,0,&s,checksocket,NULL);
@@ -665,6 +754,12 @@ void umnet_setprivatedata(struct umnet *nethandle, void *privatedata)
 		nethandle->private_data=privatedata;
 }
 
+void umnet_setdelegate(struct umnet *nethandle, int delegate)
+{
+	if(nethandle)
+		nethandle->delegate=delegate;
+}
+
 void *umnet_getprivatedata(struct umnet *nethandle)
 {
 	if(nethandle)
@@ -814,6 +909,12 @@ init (void)
 	SERVICESOCKET(s, recvfrom, umnet_recvfrom);
 	SERVICESOCKET(s, sendmsg, umnet_sendmsg);
 	SERVICESOCKET(s, recvmsg, umnet_recvmsg);
+#ifdef __NR_sendmmsg
+	SERVICESOCKET(s, sendmmsg, umnet_sendmmsg);
+#endif
+#ifdef __NR_recvmmsg
+	SERVICESOCKET(s, recvmmsg, umnet_recvmmsg);
+#endif
 	SERVICESOCKET(s, getsockopt, umnet_getsockopt);
 	SERVICESOCKET(s, setsockopt, umnet_setsockopt);
 	SERVICESYSCALL(s, read, umnet_read);
@@ -88,6 +88,14 @@ int umnetnative_fini (struct umnet *nethandle){
 
 int um_mod_event_subscribe(void (* cb)(), void *arg, int fd, int how);
 
+/* The call runs in the hypervisor, woken up when the first datagram is
+	 ready: the datagrams after it are only those already queued */
+static int umnetnative_recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		struct timespec *timeout)
+{
+	return recvmmsg(fd, msgvec, vlen, flags | MSG_WAITFORONE, timeout);
+}
+
 static int umnetnative_ioctl(int d, int request, void *arg)
 {
 	if (request == SIOCGIFCONF) {
@@ -121,6 +129,8 @@ struct umnet_operations umnet_ops={
 	.recvfrom=recvfrom,
 	.sendmsg=sendmsg,
 	.recvmsg=recvmsg,
+	.sendmmsg=sendmmsg,
+	.recvmmsg=umnetnative_recvmmsg,
 	.getsockopt=getsockopt,
 	.setsockopt=setsockopt,
 	.read=read,
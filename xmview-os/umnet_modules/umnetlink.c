@@ -224,6 +224,8 @@ struct umnet_operations umnet_ops={
 	.recvfrom=recvfrom,
 	.sendmsg=sendmsg,
 	.recvmsg=recvmsg,
+	.sendmmsg=sendmmsg,
+	.recvmmsg=recvmmsg,
 	.getsockopt=getsockopt,
 	.setsockopt=setsockopt,
 	.read=read,
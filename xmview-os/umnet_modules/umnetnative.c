@@ -77,7 +77,21 @@ int umnetnative_msocket (int domain, int type, int protocol,
 	return msocket(NULL,domain, type, protocol);
 }
 
+/* delegate: the processes use the sockets of the kernel directly,
+	 send/recv & C. are not captured */
 int umnetnative_init (char *source, char *mountpoint, unsigned long flags, char *args, struct umnet *nethandle) {
+	if (args) {
+		char *opts=strdup(args);
+		char *token, *saveptr;
+		for (token=strtok_r(opts, ",", &saveptr); token != NULL; 
+				token=strtok_r(NULL, ",", &saveptr)) {
+			if (strcmp(token, "delegate") == 0)
+				umnet_setdelegate(nethandle, 1);
+			else
+				printk("umnetnative: unknown option \"%s\"\n",token);
+		}
+		free(opts);
+	}
 	return 0;
 }
 
@@ -87,6 +101,14 @@ int umnetnative_fini (struct umnet *nethandle){
 
 int um_mod_event_subscribe(void (* cb)(), void *arg, int fd, int how);
 
+/* The call runs in the hypervisor, woken up when the first datagram is
+	 ready: the datagrams after it are only those already queued */
+static int umnetnative_recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		struct timespec *timeout)
+{
+	return recvmmsg(fd, msgvec, vlen, flags | MSG_WAITFORONE, timeout);
+}
+
 static int umnetnative_ioctl(int d, int request, void *arg)
 {
 	if (request == SIOCGIFCONF) {
@@ -120,6 +142,8 @@ struct umnet_operations umnet_ops={
 	.recvfrom=recvfrom,
 	.sendmsg=sendmsg,
 	.recvmsg=recvmsg,
+	.sendmmsg=sendmmsg,
+	.recvmmsg=umnetnative_recvmmsg,
 	.getsockopt=getsockopt,
 	.setsockopt=setsockopt,
 	.read=read,
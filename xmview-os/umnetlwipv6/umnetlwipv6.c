@@ -35,6 +35,7 @@
 #include <linux/sockios.h>
 #include <linux/if.h>
 #include <dlfcn.h>
+#include <time.h>
 #include <lwipv6.h>
 #include "umnet.h"
 
@@ -280,6 +281,62 @@ int umnetlwipv6_supported_domain(int domain)
 	}
 }
 
+/* lwipv6 has no sendmmsg/recvmmsg: the datagrams of a batch are passed
+ * to the stack one at a time, with the semantics of the system calls */
+static int umnetlwipv6_sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+	unsigned int i;
+	for (i=0; i<vlen; i++) {
+		ssize_t rv=lwip_sendmsg(fd, &msgvec[i].msg_hdr, flags);
+		if (rv < 0)
+			return (i > 0) ? i : -1;
+		msgvec[i].msg_len=rv;
+	}
+	return i;
+}
+
+static int umnetlwipv6_recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+		struct timespec *timeout)
+{
+	struct timespec deadline, now;
+	unsigned int i;
+	if (timeout) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout->tv_sec;
+		deadline.tv_nsec += timeout->tv_nsec;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+	}
+	for (i=0; i<vlen; ) {
+		/* The call runs in the hypervisor, woken up when the first datagram
+		 * is ready: as with MSG_WAITFORONE only that one is waited for */
+		int msgflags=flags & ~MSG_WAITFORONE;
+		ssize_t rv;
+		if (i > 0)
+			msgflags |= MSG_DONTWAIT;
+		rv=lwip_recvmsg(fd, &msgvec[i].msg_hdr, msgflags);
+		if (rv < 0)
+			return (i > 0) ? i : -1;
+		msgvec[i++].msg_len=rv;
+		/* as the kernel, the timeout is checked after each datagram */
+		if (timeout) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			timeout->tv_sec=deadline.tv_sec - now.tv_sec;
+			timeout->tv_nsec=deadline.tv_nsec - now.tv_nsec;
+			if (timeout->tv_nsec < 0) {
+				timeout->tv_sec--;
+				timeout->tv_nsec += 1000000000;
+			}
+			if (timeout->tv_sec < 0) {
+				timeout->tv_sec=timeout->tv_nsec=0;
+				break;
+			}
+		}
+	}
+	return i;
+}
 
 struct umnet_operations umnet_ops={
 	.msocket=umnetlwipv6_msocket,
@@ -287,7 +344,9 @@ struct umnet_operations umnet_ops={
 	.ioctlparms=umnetlwipv6_ioctlparms,
 	.init=umnetlwipv6_init,
 	.fini=umnetlwipv6_fini,
-	.supported_domain=umnetlwipv6_supported_domain
+	.supported_domain=umnetlwipv6_supported_domain,
+	.sendmmsg=umnetlwipv6_sendmmsg,
+	.recvmmsg=umnetlwipv6_recvmmsg
 };
 
 typedef int (*intfun)();
@@ -36,6 +36,19 @@ import umpyew
 # 'proc', 'module', 'mount' and corresponds to the ctlhs.
 modCtlHistorySet = ['proc'];
 
+# The checks modCheckFun is interested in (subset of 'path', 'socket',
+# 'fstype', 'sc' and 'binfmt'). The other checks return 0 without calling
+# Python. If not defined, modCheckFun gets all the checks.
+modCheckTypes = ['path', 'sc'];
+
+# The system calls (C names) implemented by this module. If not defined, all
+# the sys* functions are registered.
+# modSyscalls = ['stat64', 'lstat64', 'open', 'close', 'read', 'write']
+
+# If True, the GIL is released between calls: Python threads started by this
+# module run while the hypervisor is not calling it.
+modThreads = False
+
 # If you have any initalization, put it here.
 def modInit():
 	print "Init!"
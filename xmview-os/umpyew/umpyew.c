@@ -61,18 +61,92 @@ struct pService
 	PyObject **socket;
 };
 
+/* Argument tuples are reused: a tuple goes back to the cache of its system
+ * call unless the Python code kept a reference to it */
+struct pArgCache
+{
+	PyObject **syscall;
+	PyObject **socket;
+};
+
 static struct service s;
 static struct pService ps;
+static struct pArgCache pac;
 static PyObject *pModule;
 
 /* Used for calling PyCall with empty arg */
 static PyObject *pEmptyTuple;
 
+/* modSyscalls: the system calls implemented by the Python module (all the
+ * sys* functions when it is not defined) */
+static PyObject *pDeclared;
+
+/* modCheckTypes: the checks the Python module cares about, the other ones
+ * return 0 without entering the interpreter */
+#define CHECKBIT_PATH 0x01
+#define CHECKBIT_SOCKET 0x02
+#define CHECKBIT_FSTYPE 0x04
+#define CHECKBIT_SC 0x08
+#define CHECKBIT_BINFMT 0x10
+static int checkmask = ~0;
+
+/* interned keys and the (reused) keyword dict of modCheckFun */
+static PyObject *pKeyPath, *pKeySocket, *pKeyFstype, *pKeySc, *pKeyBinfmt;
+static PyObject *pCheckKw;
+
+/* modThreads: the GIL is released between calls, so the threads of the
+ * Python module run while the hypervisor is not calling Python */
+static PyThreadState *pMainState;
+#define PYGIL_ENSURE (pMainState ? PyGILState_Ensure() : PyGILState_LOCKED)
+#define PYGIL_RELEASE(gstate) { if (pMainState) PyGILState_Release(gstate); }
+
+static inline PyObject *pyargs_get(PyObject **cache, int argc)
+{
+	PyObject *pArg = *cache;
+	if (pArg && PyTuple_GET_SIZE(pArg) == argc)
+	{
+		/* out of the cache during the call: nested calls get a new tuple */
+		*cache = NULL;
+		return pArg;
+	}
+	return PyTuple_New(argc);
+}
+
+static inline void pyargs_put(PyObject **cache, PyObject *pArg)
+{
+	if (*cache == NULL && Py_REFCNT(pArg) == 1)
+	{
+		Py_ssize_t i;
+		for (i = 0; i < PyTuple_GET_SIZE(pArg); i++)
+		{
+			PyObject *pItem = PyTuple_GET_ITEM(pArg, i);
+			PyTuple_SET_ITEM(pArg, i, NULL);
+			Py_XDECREF(pItem);
+		}
+		*cache = pArg;
+	}
+	else
+		Py_DECREF(pArg);
+}
+
+static int declared(const char *cname)
+{
+	PyObject *pName;
+	int rv;
+
+	if (!pDeclared)
+		return 1;
+	pName = PyString_FromString(cname);
+	rv = PySequence_Contains(pDeclared, pName);
+	Py_DECREF(pName);
+	return rv == 1;
+}
+
 #define PYCHKERR {GMESSAGE("testing..."); if (PyErr_Occurred()) PyErr_Print();}
 
 #define PYTHON_SYSCALL(cname, pyname) \
 	{ \
-		if (PyObject_HasAttrString(pModule, #pyname)) \
+		if (declared(#cname) && PyObject_HasAttrString(pModule, #pyname)) \
 		{ \
 			pTmpFunc = PyObject_GetAttrString(pModule, #pyname); \
 			if (pTmpFunc && PyCallable_Check(pTmpFunc)) \
@@ -100,9 +174,11 @@ static PyObject *pEmptyTuple;
 #define PYIN(type, cname, argc) \
 	PyObject *pRetVal; \
 	long retval; \
-	PyObject *pFunc = PyTuple_GetItem(GETSERVICE##type(ps, cname), 0); \
-	PyObject *pKw = PyTuple_GetItem(GETSERVICE##type(ps, cname), 1); \
-	PyObject *pArg = PyTuple_New(argc);
+	PyObject *pFunc = PyTuple_GET_ITEM(GETSERVICE##type(ps, cname), 0); \
+	PyObject *pKw = PyTuple_GET_ITEM(GETSERVICE##type(ps, cname), 1); \
+	PyObject **ppArgCache = &GETSERVICE##type(pac, cname); \
+	PyGILState_STATE gstate = PYGIL_ENSURE; \
+	PyObject *pArg = pyargs_get(ppArgCache, argc);
 
 #define PYCALL \
 	{ \
@@ -126,11 +202,12 @@ static PyObject *pEmptyTuple;
 
 #define PYOUT \
 	{ \
-		Py_DECREF(pArg); \
+		pyargs_put(ppArgCache, pArg); \
 		if (pRetVal) \
 		{ \
 			Py_DECREF(pRetVal); \
 		} \
+		PYGIL_RELEASE(gstate); \
 	}
 
 #define PYINSYS(cname, argc) PYIN(SYSCALL, cname, argc)
@@ -415,7 +492,10 @@ static long umpyew_utime(char *path, struct utimbuf *buf)
 	if (buf)
 		PYARG(1, PyTuple_Pack(2, PyInt_FromLong(buf->actime), PyInt_FromLong(buf->modtime)));
 	else
+	{
+		Py_INCREF(Py_None);
 		PYARG(1, Py_None);
+	}
 	PYCALL;
 	PYOUT;
 	return retval;
@@ -434,7 +514,10 @@ static long umpyew_utimes(char *path, struct timeval tv[2])
 					(PyFloat_FromDouble(tv[1].tv_sec + (double)tv[1].tv_usec / 1000000.0)):
 					(PyInt_FromLong(tv[1].tv_sec))));
 	else
+	{
+		Py_INCREF(Py_None);
 		PYARG(1, Py_None);
+	}
 	PYCALL;
 	PYOUT;
 	return retval;
@@ -503,73 +586,97 @@ static long umpyew_alwayszero()
 	return 0;
 }
 
+static int checkbit(int type)
+{
+	switch(type)
+	{
+		case CHECKPATH: return CHECKBIT_PATH;
+		case CHECKSOCKET: return CHECKBIT_SOCKET;
+		case CHECKFSTYPE: return CHECKBIT_FSTYPE;
+		case CHECKSC: return CHECKBIT_SC;
+		case CHECKBINFMT: return CHECKBIT_BINFMT;
+		default: return 0;
+	}
+}
+
 static epoch_t checkfun(int type, void *arg)
 {
-	PyObject *pKw = PyDict_New();
+	PyObject *pKw;
+	PyObject *pKey;
 	PyObject *pArg;
 	PyObject *pRetVal;
-	epoch_t retval = -1;
+	PyGILState_STATE gstate;
+	epoch_t retval;
 	struct binfmt_req *bf;
 
+	if (!(checkmask & checkbit(type)))
+	{
+		if (!checkbit(type))
+			GERROR("Unknown check type %d", type);
+		return 0;
+	}
+
+	gstate = PYGIL_ENSURE;
 	switch(type)
 	{
 		case CHECKPATH:
+			pKey = pKeyPath;
 			pArg = PyString_FromString((char*)arg);
-			PyDict_SetItemString(pKw, "path", pArg);
 			break;
 
 		case CHECKSOCKET:
+			pKey = pKeySocket;
 			pArg = PyInt_FromLong((long)arg);
-			PyDict_SetItemString(pKw, "socket", pArg);
 			break;
 
 		case CHECKFSTYPE:
+			pKey = pKeyFstype;
 			pArg = PyString_FromString((char*)arg);
-			PyDict_SetItemString(pKw, "fstype", pArg);
 			break;
 
 		case CHECKSC:
+			pKey = pKeySc;
 			pArg = PyInt_FromLong(*((long*)arg));
-			PyDict_SetItemString(pKw, "sc", pArg);
 			break;
 
-		case CHECKBINFMT:
+		default: /* CHECKBINFMT */
 			bf = (struct binfmt_req*) arg;
-			pArg = PyTuple_New(3);
-			if (bf->path)
-				PyTuple_SET_ITEM(pArg, 0, PyString_FromString(bf->path));
-
-			if (bf->interp)
-				PyTuple_SET_ITEM(pArg, 1, PyString_FromString(bf->interp));
-				
-
-			PyTuple_SET_ITEM(pArg, 2, PyInt_FromLong(bf->flags));
-			PyDict_SetItemString(pKw, "binfmt", pArg);
-			break;
-
-		default:
-			GERROR("Unknown check type %d", type);
-			retval = 0;
+			pKey = pKeyBinfmt;
+			pArg = Py_BuildValue("(zzi)", bf->path, bf->interp, bf->flags);
 			break;
 	}
 
-	if (!retval)
+	/* the dict is reused unless the Python code kept a reference to it */
+	if (pCheckKw)
 	{
-		Py_DECREF(pKw);
-		return retval;
+		pKw = pCheckKw;
+		pCheckKw = NULL;
 	}
+	else
+		pKw = PyDict_New();
+	PyDict_SetItem(pKw, pKey, pArg);
+	Py_DECREF(pArg);
 
 	pRetVal = PyObject_Call(ps.checkfun, pEmptyTuple, pKw);
-	if (!pRetVal)
+	if (pRetVal)
+	{
+		retval = PyInt_AsLong(pRetVal);
+		Py_DECREF(pRetVal);
+	}
+	else
 	{
 		PyErr_Print();
-		return 0;
+		retval = 0;
 	}
 
-	retval = PyInt_AsLong(pRetVal);
-	Py_DECREF(pArg);
-	Py_DECREF(pKw);
-	Py_DECREF(pRetVal);
+	if (pCheckKw == NULL && Py_REFCNT(pKw) == 1)
+	{
+		PyDict_Clear(pKw);
+		pCheckKw = pKw;
+	}
+	else
+		Py_DECREF(pKw);
+	PYGIL_RELEASE(gstate);
 	return retval;
 }
 
@@ -577,6 +684,7 @@ static long ctl(int type, va_list ap)
 {
 	long retval;
 	PyObject *pArg, *pCmdArgs, *pRetVal;
+	PyGILState_STATE gstate = PYGIL_ENSURE;
 
 	pArg = PyTuple_New(3);
 
@@ -618,18 +726,27 @@ static long ctl(int type, va_list ap)
 		
 		default:
 			Py_DECREF(pArg);
+			PYGIL_RELEASE(gstate);
 			return -1;
 	}
 	
 	PyTuple_SET_ITEM(pArg, 2, pCmdArgs);
 
 	pRetVal = PyObject_CallObject(ps.ctl, pArg);
-	Py_DECREF(pCmdArgs);
 	Py_DECREF(pArg);
 
-	retval = PyInt_AsLong(pRetVal);
-	Py_DECREF(pRetVal);
+	if (pRetVal)
+	{
+		retval = PyInt_AsLong(pRetVal);
+		Py_DECREF(pRetVal);
+	}
+	else
+	{
+		PyErr_Print();
+		retval = -1;
+	}
 
+	PYGIL_RELEASE(gstate);
 	return retval;
 }
 
@@ -665,6 +782,11 @@ void _um_mod_init(char *initargs)
 	Py_InitModule("umpyew", pEmbMethods);
 	
 	pEmptyTuple = PyTuple_New(0);
+	pKeyPath = PyString_InternFromString("path");
+	pKeySocket = PyString_InternFromString("socket");
+	pKeyFstype = PyString_InternFromString("fstype");
+	pKeySc = PyString_InternFromString("sc");
+	pKeyBinfmt = PyString_InternFromString("binfmt");
 	pName = PyString_FromString(name);
 
 
@@ -731,6 +853,46 @@ void _um_mod_init(char *initargs)
 
 	Py_XDECREF(pTmpObj);
 
+	/*
+	 * Add modCheckTypes
+	 */
+	pTmpObj = PyObject_GetAttrString(pModule, "modCheckTypes");
+
+	if (pTmpObj && PyList_Check(pTmpObj))
+	{
+		checkmask = 0;
+		for (i = 0; i < PyList_Size(pTmpObj); i++)
+			if ((tmphs = PyString_AsString(PyList_GET_ITEM(pTmpObj, i))))
+			{
+				if (!strcmp(tmphs, "path"))
+					checkmask |= CHECKBIT_PATH;
+				else if (!strcmp(tmphs, "socket"))
+					checkmask |= CHECKBIT_SOCKET;
+				else if (!strcmp(tmphs, "fstype"))
+					checkmask |= CHECKBIT_FSTYPE;
+				else if (!strcmp(tmphs, "sc"))
+					checkmask |= CHECKBIT_SC;
+				else if (!strcmp(tmphs, "binfmt"))
+					checkmask |= CHECKBIT_BINFMT;
+			}
+	}
+	else
+		PyErr_Clear();
+
+	Py_XDECREF(pTmpObj);
+
+	/*
+	 * Add modSyscalls
+	 */
+	pDeclared = PyObject_GetAttrString(pModule, "modSyscalls");
+	if (pDeclared && !PySequence_Check(pDeclared))
+	{
+		GERROR("modSyscalls is not a list, ignored");
+		Py_DECREF(pDeclared);
+		pDeclared = NULL;
+	}
+	PyErr_Clear();
+
 	/*
 	 * Call modInit, if present
 	 */
@@ -744,6 +906,7 @@ void _um_mod_init(char *initargs)
 	 * Add system calls
 	 */
 	ps.syscall = calloc(scmap_scmapsize, sizeof(PyObject*));
+	pac.syscall = calloc(scmap_scmapsize, sizeof(PyObject*));
 
 	PYTHON_SYSCALL(open, sysOpen);
 	PYTHON_SYSCALL(close, sysClose);
@@ -770,6 +933,18 @@ void _um_mod_init(char *initargs)
 	PYTHON_SYSCALL(pread64, sysPread64);
 	PYTHON_SYSCALL(pwrite64, sysPwrite64);
 
+	/*
+	 * modThreads: release the GIL (the calls acquire it)
+	 */
+	pTmpObj = PyObject_GetAttrString(pModule, "modThreads");
+	if (pTmpObj && PyObject_IsTrue(pTmpObj) == 1)
+	{
+		PyEval_InitThreads();
+		pMainState = PyEval_SaveThread();
+	}
+	PyErr_Clear();
+	Py_XDECREF(pTmpObj);
+
 	add_service(&s);
 }
 
@@ -779,6 +954,12 @@ fini (void)
 {
 	GBACKTRACE(5,20);
 
+	if (pMainState)
+	{
+		PyEval_RestoreThread(pMainState);
+		pMainState = NULL;
+	}
+
 	PyObject *pTmpObj = PyObject_GetAttrString(pModule, "modFini");
 	if (pTmpObj && PyCallable_Check(pTmpObj))
 		PyObject_CallObject(pTmpObj, pEmptyTuple);
@@ -786,6 +967,7 @@ fini (void)
 
 	free(s.syscall);
 	free(s.socket);
+	free(pac.syscall);
 
 	/* Finalizing will destroy everything, no need for DECREFs (I think) */
 	PyErr_Clear();
@@ -855,7 +855,12 @@ long nw_msocket(int scno,struct npcb *npc,struct ht_elem *hte,sysfun um_syscall)
 			return -1;
 		} else {	
 			int sfd;
-			if ((sfd=do_nested_call(um_syscall,&(npc->sysargs[0]),4)) < 0) {
+			if ((sfd=do_nested_call(um_syscall,&(npc->sysargs[0]),4)) == UM_NATIVE_SOCKET) {
+				/* delegation: a socket of the kernel */
+				npc->path=NULL;
+				return nw_msocket(scno,npc,NULL,NULL);
+			}
+			if (sfd < 0) {
 				if (errno == ENOSYS && npc->path == NULL) {
 					/* backward compatibility:
 					 * modules implementing only "socket". 
@@ -115,6 +115,7 @@ wrapinfun wrap_in_socket, wrap_out_socket;
 wrapinfun wrap_in_bind_connect, wrap_in_listen, wrap_in_getsock, wrap_in_send;
 wrapinfun wrap_in_recv, wrap_in_shutdown, wrap_in_setsockopt, wrap_in_getsockopt;
 wrapinfun wrap_in_sendmsg, wrap_in_recvmsg, wrap_in_accept;
+wrapinfun wrap_in_sendmmsg, wrap_in_recvmmsg;
 wrapinfun wrap_in_msocket;
 wrapinfun wrap_in_sendto, wrap_in_recvfrom;
 wrapinfun wrap_in_umservice, wrap_out_umservice;
@@ -155,6 +156,14 @@ wrapoutfun wrap_out_epoll_create,wrap_out_epoll_ctl,wrap_out_epoll_wait;
 	#define	__NR_getsockopt	SYS_GETSOCKOPT
 	#define	__NR_sendmsg	SYS_SENDMSG
 	#define	__NR_recvmsg	SYS_RECVMSG
+#ifdef SYS_RECVMMSG
+	#undef	__NR_recvmmsg
+	#define	__NR_recvmmsg	SYS_RECVMMSG
+#endif
+#ifdef SYS_SENDMMSG
+	#undef	__NR_sendmmsg
+	#define	__NR_sendmmsg	SYS_SENDMMSG
+#endif
 #endif
 	#define __NR_msocket VIRSYS_MSOCKET
 
@@ -432,6 +441,12 @@ struct sc_map sockmap[]={
 #ifdef __NR_accept4
 /*18*/	{__NR_accept4,   choice_fd,	wrap_in_accept,	wrap_out_socket,	nchoice_sfd,	nw_accept, CB_R,	4, SOC_SOCKET|SOC_NET},
 #endif
+#ifdef __NR_recvmmsg
+/*19*/	{__NR_recvmmsg,  choice_fd,	wrap_in_recvmmsg,	wrap_out_std,	nchoice_sfd,	nw_sockfd_std, CB_R,	5, SOC_SOCKET|SOC_NET},
+#endif
+#ifdef __NR_sendmmsg
+/*20*/	{__NR_sendmmsg,  choice_fd,	wrap_in_sendmmsg,	wrap_out_std,	nchoice_sfd,	nw_sockfd_std, 0,	4, SOC_SOCKET|SOC_NET},
+#endif
 };
 
 /* fake sockmap when socket system calls are normal syscalls */
@@ -129,6 +129,9 @@ struct service {
 #define UM_NONE 0xff
 #define UM_ERR 0x00
 
+/* msocket return value: the process creates a kernel socket */
+#include "um_msocket.h"
+
 int add_service(char *file,int permanent);
 int del_service(char *name);
 int list_services(char *buf,int len);
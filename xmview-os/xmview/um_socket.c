@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <alloca.h>
+#include <stddef.h>
 #include <config.h>
 #include "defs.h"
 #include "umproc.h"
@@ -51,6 +52,31 @@
 
 /* SOCKET & MSOCKET call management (IN) */
 
+/* msocket -> socket translation: the kernel creates the socket */
+static int msocket_native(struct pcb *pc, int domain, int type, int protocol)
+{
+#if (__NR_socketcall != __NR_doesnotexist)
+	struct {
+		long domain;
+		long type;
+		long protocol;
+	} socketcallparms = {domain,type,protocol};
+	long sp=getsp(pc);
+	ustoren(pc,sp-sizeof(socketcallparms),
+			sizeof(socketcallparms),&socketcallparms);
+	pc->sysargs[0]=SYS_SOCKET;
+	pc->sysargs[1]=sp-sizeof(socketcallparms);
+	putscno(__NR_socketcall,pc);
+	return SC_MODICALL;
+#else
+	pc->sysargs[0]=domain;
+	pc->sysargs[1]=type;
+	pc->sysargs[2]=protocol;
+	putscno(__NR_socket,pc);
+	return SC_MODICALL;
+#endif
+}
+
 int wrap_in_msocket(int sc_number,struct pcb *pc,
 		struct ht_elem *hte, sysfun um_syscall)
 {
@@ -73,7 +99,10 @@ int wrap_in_msocket(int sc_number,struct pcb *pc,
 			}
 			return SC_FAKE;
 		} else {
-			if ((pc->retval = um_syscall(pc->path,domain,type,protocol)) < 0) {
+			if ((pc->retval = um_syscall(pc->path,domain,type,protocol)) == UM_NATIVE_SOCKET)
+				/* delegation: the socket belongs to the process */
+				return msocket_native(pc,domain,type,protocol);
+			if (pc->retval < 0) {
 				if (errno == ENOSYS && pc->path==NULL) {
 					/* backward compatibility:
 					 * modules implementing only "socket". 
@@ -102,28 +131,9 @@ int wrap_in_msocket(int sc_number,struct pcb *pc,
 	} else {
 		/* msocket -> socket translation for native system calls
 		 * just for the case path=NULL */
-		if (pc->sysargs[0]==umNULL) {
-#if (__NR_socketcall != __NR_doesnotexist)
-			struct {
-				long domain;
-				long type;
-				long protocol;
-			} socketcallparms = {domain,type,protocol};
-			long sp=getsp(pc);
-			ustoren(pc,sp-sizeof(socketcallparms),
-					sizeof(socketcallparms),&socketcallparms);
-			pc->sysargs[0]=SYS_SOCKET;
-			pc->sysargs[1]=sp-sizeof(socketcallparms);
-			putscno(__NR_socketcall,pc);
-			return SC_MODICALL;
-#else
-			pc->sysargs[0]=domain;
-			pc->sysargs[1]=type;
-			pc->sysargs[2]=protocol;
-			putscno(__NR_socket,pc);
-			return SC_MODICALL;
-#endif
-		} else {
+		if (pc->sysargs[0]==umNULL) 
+			return msocket_native(pc,domain,type,protocol);
+		else {
 			pc->retval = -1;
 			pc->erno = ENOTSUP;
 			return SC_FAKE;
@@ -693,3 +703,195 @@ int wrap_in_sendmsg(int sc_number,struct pcb *pc,
 	}
 	return SC_FAKE;
 }
+
+/* sendmmsg and recvmmsg: a batch of messages in a single call */
+struct lmsghdr {
+	struct msghdr msg;    /* the msghdr in the memory of the process */
+	struct iovec *iovec;  /* the iovec in the memory of the process */
+	struct iovec liovec;  /* one local buffer for all the iovecs */
+	char *buf;
+};
+
+static int lmsg_get(struct pcb *pc, long pmsg, struct lmsghdr *lm, 
+		struct msghdr *lmsg, int send)
+{
+	unsigned int i;
+	size_t totalsize;
+	char *p;
+	umoven(pc,pmsg,sizeof(struct msghdr),&lm->msg);
+	if (lm->msg.msg_name == NULL) 
+		lm->msg.msg_namelen=0;
+	else if (__builtin_expect((lm->msg.msg_namelen > MAX_SOCKET_NAME),0)) 
+		lm->msg.msg_namelen=MAX_SOCKET_NAME;
+	if (lm->msg.msg_iov == NULL) 
+		lm->msg.msg_iovlen=0;
+	else if (__builtin_expect((lm->msg.msg_iovlen > IOV_MAX),0)) 
+		lm->msg.msg_iovlen=IOV_MAX;
+	if (lm->msg.msg_control == NULL) 
+		lm->msg.msg_controllen=0;
+	else if (__builtin_expect((lm->msg.msg_controllen > MAX_SOCK_CONTROLLEN),0))
+		lm->msg.msg_controllen=MAX_SOCK_CONTROLLEN;
+	/* iovec, control, name, data */
+	totalsize=lm->msg.msg_iovlen * sizeof(struct iovec) + 
+		CMSG_ALIGN(lm->msg.msg_controllen) + lm->msg.msg_namelen;
+	if ((lm->buf=malloc(totalsize)) == NULL)
+		return -1;
+	lm->iovec=(struct iovec *)lm->buf;
+	umoven(pc,(long)lm->msg.msg_iov,lm->msg.msg_iovlen * sizeof(struct iovec),lm->iovec);
+	for (i=0,totalsize=0;i<lm->msg.msg_iovlen;i++)
+		totalsize += lm->iovec[i].iov_len;
+	*lmsg=lm->msg;
+	lmsg->msg_control=lm->buf + lm->msg.msg_iovlen * sizeof(struct iovec);
+	lmsg->msg_name=lmsg->msg_control + CMSG_ALIGN(lm->msg.msg_controllen);
+	if (lm->msg.msg_namelen > 0)
+		umoven(pc,(long)lm->msg.msg_name,lm->msg.msg_namelen,lmsg->msg_name);
+	if (send && lm->msg.msg_controllen > 0)
+		umoven(pc,(long)lm->msg.msg_control,lm->msg.msg_controllen,lmsg->msg_control);
+	if ((p=malloc(totalsize ? totalsize : 1)) == NULL) {
+		free(lm->buf);
+		lm->buf=NULL;
+		return -1;
+	}
+	lm->liovec.iov_base=p;
+	lm->liovec.iov_len=totalsize;
+	lmsg->msg_iov=&lm->liovec;
+	lmsg->msg_iovlen=1;
+	if (send) {
+		for (i=0;i<lm->msg.msg_iovlen;i++) {
+			umoven(pc,(long)lm->iovec[i].iov_base,lm->iovec[i].iov_len,p);
+			p += lm->iovec[i].iov_len;
+		}
+	}
+	return 0;
+}
+
+/* recvmmsg: data, name, control and flags back to the process */
+static void lmsg_put(struct pcb *pc, long pmsg, struct lmsghdr *lm, 
+		struct msghdr *lmsg, size_t size)
+{
+	unsigned int i;
+	char *p=lm->liovec.iov_base;
+	for (i=0;i<lm->msg.msg_iovlen && size>0;i++) {
+		size_t qty=(size > lm->iovec[i].iov_len)?lm->iovec[i].iov_len:size;
+		ustoren(pc,(long)lm->iovec[i].iov_base,qty,p);
+		p += qty;
+		size -= qty;
+	}
+	if (lm->msg.msg_namelen > 0) {
+		lm->msg.msg_namelen=lmsg->msg_namelen;
+		ustoren(pc,(long)lm->msg.msg_name,lm->msg.msg_namelen,lmsg->msg_name);
+	}
+	if (lm->msg.msg_controllen > 0) {
+		lm->msg.msg_controllen=lmsg->msg_controllen;
+		ustoren(pc,(long)lm->msg.msg_control,lm->msg.msg_controllen,lmsg->msg_control);
+	}
+	lm->msg.msg_flags=lmsg->msg_flags;
+	ustoren(pc,pmsg,sizeof(struct msghdr),&lm->msg);
+}
+
+static void lmsg_free(struct lmsghdr *lm, unsigned int vlen)
+{
+	unsigned int i;
+	for (i=0;i<vlen;i++) {
+		if (lm[i].buf) {
+			free(lm[i].buf);
+			free(lm[i].liovec.iov_base);
+		}
+	}
+	free(lm);
+}
+
+/* modules without sendmmsg/recvmmsg get one sendmsg/recvmsg call for each message */
+static sysfun ht_sockmsg(struct ht_elem *hte, int send)
+{
+#if (__NR_socketcall != __NR_doesnotexist)
+	return ht_socketcall(hte,send?SYS_SENDMSG:SYS_RECVMSG);
+#else
+	return ht_syscall(hte,uscno(send?__NR_sendmsg:__NR_recvmsg));
+#endif
+}
+
+#define MMSG_LEN(P,I) ((P) + (I)*sizeof(struct mmsghdr) + offsetof(struct mmsghdr, msg_len))
+
+static int wrap_in_mmsg(struct pcb *pc, struct ht_elem *hte, sysfun um_syscall, int send)
+{
+	int sfd=fd2sfd(pc->fds,pc->sysargs[0]);
+	if (sfd < 0) {
+		pc->retval= -1;
+		pc->erno= EBADF;
+	} else {
+		long pmmsg=pc->sysargs[1];
+		unsigned int vlen=pc->sysargs[2];
+		int flags=pc->sysargs[3];
+		long ptimeout=send?umNULL:pc->sysargs[4];
+		struct timespec timeout;
+		struct lmsghdr *lm;
+		struct mmsghdr *lmmsg;
+		unsigned int i;
+		if (__builtin_expect((vlen > IOV_MAX),0)) vlen=IOV_MAX;
+		if (vlen == 0) {
+			pc->retval=0;
+			return SC_FAKE;
+		}
+		lm=calloc(vlen,sizeof(struct lmsghdr));
+		lmmsg=calloc(vlen,sizeof(struct mmsghdr));
+		for (i=0;lm != NULL && lmmsg != NULL && i<vlen;i++) {
+			if (lmsg_get(pc,pmmsg+i*sizeof(struct mmsghdr),&lm[i],&lmmsg[i].msg_hdr,send) < 0)
+				break;
+		}
+		if (i < vlen) {
+			pc->retval= -1;
+			pc->erno= ENOMEM;
+		} else {
+			if (ptimeout != umNULL)
+				umoven(pc,ptimeout,sizeof(struct timespec),&timeout);
+			if (isnosys(um_syscall)) {
+				/* MSG_WAITFORONE: the messages after the first one do not wait */
+				um_syscall=ht_sockmsg(hte,send);
+				flags &= ~MSG_WAITFORONE;
+				for (i=0;i<vlen;i++) {
+					long rv=um_syscall(sfd,&lmmsg[i].msg_hdr,
+							(send || i==0)?flags:flags|MSG_DONTWAIT);
+					if (rv < 0) {
+						if (i == 0)
+							pc->erno=errno;
+						break;
+					}
+					lmmsg[i].msg_len=rv;
+				}
+				pc->retval=(i > 0)?i:-1;
+			} else {
+				if (send)
+					pc->retval=um_syscall(sfd,lmmsg,vlen,flags);
+				else
+					pc->retval=um_syscall(sfd,lmmsg,vlen,flags,
+							(ptimeout != umNULL)?&timeout:NULL);
+				if (pc->retval < 0)
+					pc->erno=errno;
+			}
+			for (i=0;(long)i<pc->retval;i++) {
+				if (!send)
+					lmsg_put(pc,pmmsg+i*sizeof(struct mmsghdr),&lm[i],&lmmsg[i].msg_hdr,lmmsg[i].msg_len);
+				ustoren(pc,MMSG_LEN(pmmsg,i),sizeof(unsigned int),&lmmsg[i].msg_len);
+			}
+			if (ptimeout != umNULL)
+				ustoren(pc,ptimeout,sizeof(struct timespec),&timeout);
+		}
+		if (lm)
+			lmsg_free(lm,vlen);
+		free(lmmsg);
+	}
+	return SC_FAKE;
+}
+
+int wrap_in_sendmmsg(int sc_number,struct pcb *pc,
+		struct ht_elem *hte, sysfun um_syscall)
+{
+	return wrap_in_mmsg(pc,hte,um_syscall,1);
+}
+
+int wrap_in_recvmmsg(int sc_number,struct pcb *pc,
+		struct ht_elem *hte, sysfun um_syscall)
+{
+	return wrap_in_mmsg(pc,hte,um_syscall,0);
+}